@@ -68,6 +68,7 @@
 #define WEBRTC_API_PEERCONNECTIONINTERFACE_H_
 
 #include <memory>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -623,6 +624,16 @@ class PeerConnectionInterface : public rtc::RefCountInterface {
   // break third party projects. As soon as they have been updated this should
   // be changed to "= 0;".
   virtual void GetStats(RTCStatsCollectorCallback* callback) {}
+  // Like GetStats(RTCStatsCollectorCallback*), but the report only contains
+  // stats whose type is in |stats_types|, e.g. RTCTransportStats::kType. Only
+  // those stats are gathered, which makes frequently polling a few stats types
+  // cheaper than getting the full report.
+  virtual void GetStats(RTCStatsCollectorCallback* callback,
+                        const std::set<std::string>& stats_types) {}
+  // Gets the stats of |track|, of the RTP streams sending or receiving it and
+  // of the stats they reference, such as codecs and transports.
+  virtual void GetStats(MediaStreamTrackInterface* track,
+                        RTCStatsCollectorCallback* callback) {}
 
   // Create a data channel with the provided config, or default config if none
   // is provided. Note that an offer/answer negotiation is still necessary
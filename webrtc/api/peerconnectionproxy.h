@@ -49,6 +49,14 @@ BEGIN_SIGNALING_PROXY_MAP(PeerConnection)
                 MediaStreamTrackInterface*,
                 StatsOutputLevel)
   PROXY_METHOD1(void, GetStats, RTCStatsCollectorCallback*)
+  PROXY_METHOD2(void,
+                GetStats,
+                RTCStatsCollectorCallback*,
+                const std::set<std::string>&)
+  PROXY_METHOD2(void,
+                GetStats,
+                MediaStreamTrackInterface*,
+                RTCStatsCollectorCallback*)
   PROXY_METHOD2(rtc::scoped_refptr<DataChannelInterface>,
                 CreateDataChannel,
                 const std::string&,
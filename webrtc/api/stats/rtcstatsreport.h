@@ -62,6 +62,10 @@ class RTCStatsReport : public rtc::RefCountInterface {
   const RTCStats* Get(const std::string& id) const;
   size_t size() const { return stats_.size(); }
 
+  // Removes the stats object with ID |id| from the report and returns it, or
+  // returns null if there is no such stats object.
+  std::unique_ptr<const RTCStats> Take(const std::string& id);
+
   // Takes ownership of all the stats in |victim|, leaving it empty.
   void TakeMembersFrom(rtc::scoped_refptr<RTCStatsReport> victim);
 
@@ -13,6 +13,9 @@
 
 #include <stdint.h>
 
+#include <vector>
+
+#include "webrtc/api/optional.h"
 #include "webrtc/api/video/video_rotation.h"
 #include "webrtc/api/video/video_frame_buffer.h"
 
@@ -20,6 +23,14 @@ namespace webrtc {
 
 class VideoFrame {
  public:
+  // A rectangle of pixels, in the coordinates of the frame.
+  struct UpdateRect {
+    int offset_x;
+    int offset_y;
+    int width;
+    int height;
+  };
+
   // TODO(nisse): This constructor is consistent with the now deleted
   // cricket::WebRtcVideoFrame. We should consider whether or not we
   // want to stick to this style and deprecate the other constructor.
@@ -87,6 +98,20 @@ class VideoFrame {
   VideoRotation rotation() const { return rotation_; }
   void set_rotation(VideoRotation rotation) { rotation_ = rotation; }
 
+  // The parts of the frame that changed since the previous frame from the same
+  // source, e.g. the damaged region of a captured screen. Unset when unknown,
+  // in which case any part of the frame may have changed; an empty list means
+  // that the frame is identical to the previous one. Encoders may use this to
+  // skip unchanged blocks, so a frame that is dropped before encoding must
+  // have its rects merged into the next one, see UpdateRectAccumulator.
+  const rtc::Optional<std::vector<UpdateRect>>& update_rects() const {
+    return update_rects_;
+  }
+  void set_update_rects(
+      const rtc::Optional<std::vector<UpdateRect>>& update_rects) {
+    update_rects_ = update_rects;
+  }
+
   // Get render time in milliseconds.
   // TODO(nisse): Deprecated. Migrate all users to timestamp_us().
   int64_t render_time_ms() const;
@@ -108,6 +133,7 @@ class VideoFrame {
   int64_t ntp_time_ms_;
   int64_t timestamp_us_;
   VideoRotation rotation_;
+  rtc::Optional<std::vector<UpdateRect>> update_rects_;
 };
 
 }  // namespace webrtc
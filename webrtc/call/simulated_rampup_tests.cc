@@ -0,0 +1,521 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// Ramp-up scenarios for the send-side bandwidth estimation, run in simulated
+// time by a test::DiscreteEventScheduler. Unlike rampup_tests.cc, which runs a
+// Call in real time, these run the congestion controller, pacer and transport
+// feedback of a call on a single thread, so minutes of a call take a fraction
+// of a second and every run of a scenario gives the same result.
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "webrtc/logging/rtc_event_log/rtc_event_log.h"
+#include "webrtc/modules/bitrate_controller/include/bitrate_controller.h"
+#include "webrtc/modules/congestion_controller/include/send_side_congestion_controller.h"
+#include "webrtc/modules/include/module.h"
+#include "webrtc/modules/include/module_common_types.h"
+#include "webrtc/modules/pacing/paced_sender.h"
+#include "webrtc/modules/pacing/packet_router.h"
+#include "webrtc/modules/remote_bitrate_estimator/remote_estimator_proxy.h"
+#include "webrtc/modules/rtp_rtcp/include/rtp_header_extension_map.h"
+#include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
+#include "webrtc/modules/rtp_rtcp/source/rtcp_packet/common_header.h"
+#include "webrtc/modules/rtp_rtcp/source/rtcp_packet/receiver_report.h"
+#include "webrtc/modules/rtp_rtcp/source/rtcp_packet/transport_feedback.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_header_extensions.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_packet_received.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_packet_to_send.h"
+#include "webrtc/rtc_base/checks.h"
+#include "webrtc/rtc_base/location.h"
+#include "webrtc/rtc_base/ptr_util.h"
+#include "webrtc/rtc_base/socket.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/system_wrappers/include/field_trial.h"
+#include "webrtc/test/discrete_event_scheduler.h"
+#include "webrtc/test/fake_network_pipe.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+const int64_t kStartTimeUs = 100000000;
+const uint32_t kMediaSsrc = 0x1111;
+const uint32_t kPaddingSsrc = 0x2222;
+const uint32_t kReceiverSsrc = 0x3333;
+const uint8_t kTransportSequenceNumberId = 1;
+const int64_t kFrameIntervalMs = 33;
+const size_t kMaxPacketSize = 1200;
+const size_t kMaxPaddingPacketSize = 224;
+const int64_t kReceiverReportIntervalMs = 500;
+const int64_t kSampleIntervalMs = 100;
+
+const int kMinBitrateBps = 30000;
+const int kStartBitrateBps = 300000;
+const int kMaxBitrateBps = 2500000;
+
+// Runs a FakeNetworkPipe as a module of a ProcessThread, handing the packets
+// that leave it to |receive_callback|.
+class NetworkLink : public Module {
+ public:
+  using ReceiveCallback = std::function<void(const uint8_t*, size_t)>;
+
+  NetworkLink(Clock* clock,
+              const FakeNetworkPipe::Config& config,
+              uint64_t seed,
+              ReceiveCallback receive_callback)
+      : pipe_(clock,
+              config,
+              rtc::MakeUnique<CallbackDemuxer>(std::move(receive_callback)),
+              seed),
+        process_thread_(nullptr) {}
+
+  void SetConfig(const FakeNetworkPipe::Config& config) {
+    pipe_.SetConfig(config);
+  }
+
+  void SendPacket(const uint8_t* data, size_t length) {
+    pipe_.SendPacket(data, length);
+    if (process_thread_)
+      process_thread_->WakeUp(this);
+  }
+
+  int64_t TimeUntilNextProcess() override {
+    return pipe_.TimeUntilNextProcess();
+  }
+  void Process() override { pipe_.Process(); }
+  void ProcessThreadAttached(ProcessThread* process_thread) override {
+    process_thread_ = process_thread;
+  }
+
+ private:
+  class CallbackDemuxer : public Demuxer {
+   public:
+    explicit CallbackDemuxer(ReceiveCallback callback)
+        : callback_(std::move(callback)) {}
+    void SetReceiver(PacketReceiver* receiver) override {}
+    void DeliverPacket(const NetworkPacket* packet,
+                       const PacketTime& packet_time) override {
+      callback_(packet->data(), packet->data_length());
+    }
+
+   private:
+    const ReceiveCallback callback_;
+  };
+
+  FakeNetworkPipe pipe_;
+  ProcessThread* process_thread_;
+};
+
+// Sends the transport feedback of a RemoteEstimatorProxy over a NetworkLink.
+class FeedbackSender : public PacketRouter {
+ public:
+  explicit FeedbackSender(NetworkLink* link) : link_(link) {}
+
+  bool SendTransportFeedback(rtcp::TransportFeedback* packet) override {
+    packet->SetSenderSsrc(kReceiverSsrc);
+    rtc::Buffer buffer = packet->Build();
+    link_->SendPacket(buffer.data(), buffer.size());
+    return true;
+  }
+
+ private:
+  NetworkLink* const link_;
+};
+
+// The send-side bandwidth estimation of a call with one video stream, whose
+// encoder always produces exactly the target bitrate, and a receiver that
+// sends transport feedback and receiver reports back over the network.
+class SimulatedBweCall : public PacedSender::PacketSender,
+                         public SendSideCongestionController::Observer {
+ public:
+  SimulatedBweCall(test::DiscreteEventScheduler* scheduler,
+                   const FakeNetworkPipe::Config& forward_config,
+                   const FakeNetworkPipe::Config& return_config,
+                   uint64_t seed)
+      : scheduler_(scheduler),
+        clock_(scheduler->clock()),
+        process_thread_(scheduler->CreateProcessThread()),
+        rtt_ms_(forward_config.queue_delay_ms + return_config.queue_delay_ms),
+        forward_link_(clock_, forward_config, seed,
+                      [this](const uint8_t* data, size_t length) {
+                        OnRtpPacket(data, length);
+                      }),
+        return_link_(clock_, return_config, seed + 1,
+                     [this](const uint8_t* data, size_t length) {
+                       OnRtcpPacket(data, length);
+                     }),
+        pacer_(clock_, this, &event_log_),
+        congestion_controller_(clock_, this, &event_log_, &pacer_),
+        bandwidth_observer_(congestion_controller_.GetBitrateController()
+                                ->CreateRtcpBandwidthObserver()),
+        target_bitrate_bps_(0),
+        media_sequence_number_(0),
+        padding_sequence_number_(0),
+        transport_sequence_number_(0),
+        feedback_sender_(&return_link_),
+        remote_estimator_proxy_(clock_, &feedback_sender_),
+        bytes_received_(0) {
+    extensions_.Register<TransportSequenceNumber>(kTransportSequenceNumberId);
+    congestion_controller_.SetBweBitrates(kMinBitrateBps, kStartBitrateBps,
+                                          kMaxBitrateBps);
+    congestion_controller_.OnRttUpdate(rtt_ms_, rtt_ms_);
+    // Pad up to the estimate while the encoder is below it, like a Call does
+    // during ramp-up.
+    pacer_.SetSendBitrateLimits(kMinBitrateBps, kMaxBitrateBps);
+
+    process_thread_->RegisterModule(&forward_link_, RTC_FROM_HERE);
+    process_thread_->RegisterModule(&return_link_, RTC_FROM_HERE);
+    process_thread_->RegisterModule(&pacer_, RTC_FROM_HERE);
+    process_thread_->RegisterModule(&congestion_controller_, RTC_FROM_HERE);
+    process_thread_->RegisterModule(&remote_estimator_proxy_, RTC_FROM_HERE);
+    process_thread_->Start();
+
+    scheduler_->PostTask([this] { EncodeFrame(); });
+    scheduler_->PostDelayedTask([this] { SendReceiverReport(); },
+                                kReceiverReportIntervalMs);
+  }
+
+  ~SimulatedBweCall() override {
+    process_thread_->Stop();
+    process_thread_->DeRegisterModule(&remote_estimator_proxy_);
+    process_thread_->DeRegisterModule(&congestion_controller_);
+    process_thread_->DeRegisterModule(&pacer_);
+    process_thread_->DeRegisterModule(&return_link_);
+    process_thread_->DeRegisterModule(&forward_link_);
+  }
+
+  void SetForwardConfig(const FakeNetworkPipe::Config& config) {
+    forward_link_.SetConfig(config);
+  }
+
+  uint32_t target_bitrate_bps() const { return target_bitrate_bps_; }
+  size_t bytes_received() const { return bytes_received_; }
+
+  // Implements SendSideCongestionController::Observer.
+  void OnNetworkChanged(uint32_t bitrate_bps,
+                        uint8_t fraction_loss,
+                        int64_t rtt_ms,
+                        int64_t probing_interval_ms) override {
+    target_bitrate_bps_ = bitrate_bps;
+  }
+
+  // Implements PacedSender::PacketSender.
+  bool TimeToSendPacket(uint32_t ssrc,
+                        uint16_t sequence_number,
+                        int64_t capture_time_ms,
+                        bool retransmission,
+                        const PacedPacketInfo& cluster_info) override {
+    auto it = queued_packet_sizes_.find(sequence_number);
+    RTC_CHECK(it != queued_packet_sizes_.end());
+    const size_t size = it->second;
+    queued_packet_sizes_.erase(it);
+    SendRtpPacket(ssrc, sequence_number, size, cluster_info);
+    return true;
+  }
+
+  size_t TimeToSendPadding(size_t bytes,
+                           const PacedPacketInfo& cluster_info) override {
+    size_t bytes_sent = 0;
+    while (bytes_sent < bytes) {
+      const size_t size =
+          std::min(bytes - bytes_sent, kMaxPaddingPacketSize);
+      bytes_sent +=
+          SendRtpPacket(kPaddingSsrc, padding_sequence_number_++, size,
+                        cluster_info);
+    }
+    return bytes_sent;
+  }
+
+ private:
+  void EncodeFrame() {
+    const size_t frame_size =
+        target_bitrate_bps_ * kFrameIntervalMs / 8000;
+    const int64_t now_ms = clock_->TimeInMilliseconds();
+    for (size_t offset = 0; offset < frame_size; offset += kMaxPacketSize) {
+      const size_t size = std::min(frame_size - offset, kMaxPacketSize);
+      queued_packet_sizes_[media_sequence_number_] = size;
+      pacer_.InsertPacket(RtpPacketSender::kNormalPriority, kMediaSsrc,
+                          media_sequence_number_++, now_ms, size, false);
+    }
+    scheduler_->PostDelayedTask([this] { EncodeFrame(); }, kFrameIntervalMs);
+  }
+
+  size_t SendRtpPacket(uint32_t ssrc,
+                       uint16_t sequence_number,
+                       size_t size,
+                       const PacedPacketInfo& cluster_info) {
+    RtpPacketToSend packet(&extensions_);
+    packet.SetSsrc(ssrc);
+    packet.SetSequenceNumber(sequence_number);
+    packet.SetTimestamp(
+        static_cast<uint32_t>(clock_->TimeInMilliseconds() * 90));
+    const uint16_t transport_sequence_number = ++transport_sequence_number_;
+    packet.SetExtension<TransportSequenceNumber>(transport_sequence_number);
+    packet.SetPayloadSize(
+        size > packet.headers_size() ? size - packet.headers_size() : 0);
+
+    congestion_controller_.AddPacket(ssrc, transport_sequence_number,
+                                     packet.size(), cluster_info);
+    forward_link_.SendPacket(packet.data(), packet.size());
+    congestion_controller_.OnSentPacket(rtc::SentPacket(
+        transport_sequence_number, clock_->TimeInMilliseconds()));
+    return packet.size();
+  }
+
+  void OnRtpPacket(const uint8_t* data, size_t length) {
+    RtpPacketReceived packet(&extensions_);
+    RTC_CHECK(packet.Parse(data, length));
+    bytes_received_ += length;
+    RTPHeader header;
+    packet.GetHeader(&header);
+    remote_estimator_proxy_.IncomingPacket(clock_->TimeInMilliseconds(),
+                                           packet.payload_size(), header);
+    if (header.ssrc != kMediaSsrc)
+      return;
+    const int64_t sequence_number =
+        sequence_number_unwrapper_.Unwrap(header.sequenceNumber);
+    if (!receive_statistics_.received_packets)
+      receive_statistics_.base_sequence_number = sequence_number;
+    receive_statistics_.highest_sequence_number =
+        std::max(receive_statistics_.highest_sequence_number, sequence_number);
+    ++receive_statistics_.received_packets;
+  }
+
+  void SendReceiverReport() {
+    ReceiveStatistics& stats = receive_statistics_;
+    if (stats.received_packets > 0) {
+      const int64_t expected =
+          stats.highest_sequence_number - stats.base_sequence_number + 1;
+      const int64_t expected_interval = expected - stats.last_expected;
+      const int64_t received_interval =
+          stats.received_packets - stats.last_received_packets;
+      const int64_t lost_interval = expected_interval - received_interval;
+      stats.last_expected = expected;
+      stats.last_received_packets = stats.received_packets;
+
+      rtcp::ReportBlock block;
+      block.SetMediaSsrc(kMediaSsrc);
+      block.SetFractionLost(
+          expected_interval > 0 && lost_interval > 0
+              ? static_cast<uint8_t>((lost_interval << 8) / expected_interval)
+              : 0);
+      block.SetCumulativeLost(static_cast<uint32_t>(
+          std::max<int64_t>(expected - stats.received_packets, 0)));
+      block.SetExtHighestSeqNum(
+          static_cast<uint32_t>(stats.highest_sequence_number));
+      rtcp::ReceiverReport report;
+      report.SetSenderSsrc(kReceiverSsrc);
+      report.AddReportBlock(block);
+      rtc::Buffer buffer = report.Build();
+      return_link_.SendPacket(buffer.data(), buffer.size());
+    }
+    scheduler_->PostDelayedTask([this] { SendReceiverReport(); },
+                                kReceiverReportIntervalMs);
+  }
+
+  void OnRtcpPacket(const uint8_t* data, size_t length) {
+    const int64_t now_ms = clock_->TimeInMilliseconds();
+    rtcp::CommonHeader header;
+    for (const uint8_t* next = data; next < data + length;
+         next = header.NextPacket()) {
+      RTC_CHECK(header.Parse(next, data + length - next));
+      if (header.type() == rtcp::Rtpfb::kPacketType &&
+          header.fmt() == rtcp::TransportFeedback::kFeedbackMessageType) {
+        rtcp::TransportFeedback feedback;
+        RTC_CHECK(feedback.Parse(header));
+        congestion_controller_.OnTransportFeedback(feedback);
+      } else if (header.type() == rtcp::ReceiverReport::kPacketType) {
+        rtcp::ReceiverReport report;
+        RTC_CHECK(report.Parse(header));
+        ReportBlockList report_blocks;
+        for (const rtcp::ReportBlock& block : report.report_blocks()) {
+          report_blocks.push_back(RTCPReportBlock(
+              report.sender_ssrc(), block.source_ssrc(), block.fraction_lost(),
+              block.cumulative_lost(), block.extended_high_seq_num(),
+              block.jitter(), block.last_sr(), block.delay_since_last_sr()));
+        }
+        bandwidth_observer_->OnReceivedRtcpReceiverReport(report_blocks,
+                                                          rtt_ms_, now_ms);
+      }
+    }
+  }
+
+  struct ReceiveStatistics {
+    int64_t base_sequence_number = 0;
+    int64_t highest_sequence_number = 0;
+    int64_t received_packets = 0;
+    int64_t last_expected = 0;
+    int64_t last_received_packets = 0;
+  };
+
+  test::DiscreteEventScheduler* const scheduler_;
+  Clock* const clock_;
+  const std::unique_ptr<ProcessThread> process_thread_;
+  const int64_t rtt_ms_;
+  RtcEventLogNullImpl event_log_;
+  RtpHeaderExtensionMap extensions_;
+
+  NetworkLink forward_link_;
+  NetworkLink return_link_;
+
+  // Sender.
+  PacedSender pacer_;
+  SendSideCongestionController congestion_controller_;
+  const std::unique_ptr<RtcpBandwidthObserver> bandwidth_observer_;
+  uint32_t target_bitrate_bps_;
+  uint16_t media_sequence_number_;
+  uint16_t padding_sequence_number_;
+  uint16_t transport_sequence_number_;
+  std::map<uint16_t, size_t> queued_packet_sizes_;
+
+  // Receiver.
+  FeedbackSender feedback_sender_;
+  RemoteEstimatorProxy remote_estimator_proxy_;
+  SequenceNumberUnwrapper sequence_number_unwrapper_;
+  ReceiveStatistics receive_statistics_;
+  size_t bytes_received_;
+};
+
+FakeNetworkPipe::Config LinkConfig(int capacity_kbps, int delay_ms) {
+  FakeNetworkPipe::Config config;
+  config.link_capacity_kbps = capacity_kbps;
+  config.queue_delay_ms = delay_ms;
+  config.queue_length_packets = 100;
+  return config;
+}
+
+// A change of the forward link capacity during a scenario.
+struct CapacityChange {
+  int64_t time_ms;
+  int capacity_kbps;
+};
+
+// The target bitrate of a call, sampled every |kSampleIntervalMs|.
+std::vector<uint32_t> RunScenario(int64_t duration_ms,
+                                  const std::vector<CapacityChange>& changes,
+                                  uint64_t seed) {
+  const int kOneWayDelayMs = 50;
+  test::DiscreteEventScheduler scheduler(kStartTimeUs);
+  SimulatedBweCall call(
+      &scheduler, LinkConfig(changes.front().capacity_kbps, kOneWayDelayMs),
+      LinkConfig(0, kOneWayDelayMs), seed);
+  for (const CapacityChange& change : changes) {
+    scheduler.PostDelayedTask(
+        [&call, change] {
+          call.SetForwardConfig(
+              LinkConfig(change.capacity_kbps, kOneWayDelayMs));
+        },
+        change.time_ms);
+  }
+
+  std::vector<uint32_t> target_bitrates_bps;
+  for (int64_t time_ms = 0; time_ms < duration_ms;
+       time_ms += kSampleIntervalMs) {
+    scheduler.RunFor(kSampleIntervalMs);
+    target_bitrates_bps.push_back(call.target_bitrate_bps());
+  }
+  return target_bitrates_bps;
+}
+
+// Returns the time at which |bitrates_bps| first reaches |threshold_bps| at or
+// after |from_ms|, or -1 if it does not.
+int64_t TimeToReachMs(const std::vector<uint32_t>& bitrates_bps,
+                      int64_t from_ms,
+                      uint32_t threshold_bps) {
+  for (size_t i = from_ms / kSampleIntervalMs; i < bitrates_bps.size(); ++i) {
+    if (bitrates_bps[i] >= threshold_bps)
+      return (i + 1) * kSampleIntervalMs - from_ms;
+  }
+  return -1;
+}
+
+uint32_t BitrateAtMs(const std::vector<uint32_t>& bitrates_bps,
+                     int64_t time_ms) {
+  RTC_CHECK_GE(time_ms, kSampleIntervalMs);
+  return bitrates_bps[time_ms / kSampleIntervalMs - 1];
+}
+
+}  // namespace
+
+TEST(SimulatedRampUpTest, RampsUpToMaxBitrate) {
+  const std::vector<uint32_t> bitrates_bps =
+      RunScenario(30000, {{0, 0}}, 1);
+  const int64_t rampup_time_ms =
+      TimeToReachMs(bitrates_bps, 0, kMaxBitrateBps * 9 / 10);
+  ASSERT_GE(rampup_time_ms, 0);
+  EXPECT_LT(rampup_time_ms, 15000);
+  EXPECT_GE(BitrateAtMs(bitrates_bps, 30000), kMaxBitrateBps * 9u / 10);
+  test::PrintResult("simulated_ramp_up", "", "time_to_max",
+                    static_cast<size_t>(rampup_time_ms), "ms", false);
+}
+
+TEST(SimulatedRampUpTest, RampsDownAndUpWithLinkCapacity) {
+  const int kHighCapacityKbps = 2000;
+  const int kLowCapacityKbps = 500;
+  const std::vector<uint32_t> bitrates_bps = RunScenario(
+      90000, {{0, kHighCapacityKbps}, {30000, kLowCapacityKbps},
+              {60000, kHighCapacityKbps}},
+      1);
+
+  EXPECT_GE(BitrateAtMs(bitrates_bps, 30000), kHighCapacityKbps * 1000 / 2);
+  EXPECT_LE(BitrateAtMs(bitrates_bps, 30000), kHighCapacityKbps * 1100);
+  // Measured after the queue built up during the drop has drained.
+  EXPECT_LE(BitrateAtMs(bitrates_bps, 45000), kLowCapacityKbps * 1100);
+  EXPECT_GE(BitrateAtMs(bitrates_bps, 60000), kLowCapacityKbps * 1000 / 2);
+  const int64_t second_rampup_time_ms =
+      TimeToReachMs(bitrates_bps, 60000, kHighCapacityKbps * 1000 / 2);
+  ASSERT_GE(second_rampup_time_ms, 0);
+  EXPECT_LT(second_rampup_time_ms, 20000);
+
+  test::PrintResult("simulated_ramp_up_down_up", "", "first_rampup",
+                    static_cast<size_t>(TimeToReachMs(
+                        bitrates_bps, 0, kHighCapacityKbps * 1000 / 2)),
+                    "ms", false);
+  test::PrintResult("simulated_ramp_up_down_up", "", "second_rampup",
+                    static_cast<size_t>(second_rampup_time_ms), "ms", false);
+}
+
+TEST(SimulatedRampUpTest, IsDeterministic) {
+  const std::vector<CapacityChange> changes = {
+      {0, 1500}, {10000, 300}, {20000, 1500}};
+  const std::vector<uint32_t> first_run = RunScenario(30000, changes, 17);
+  const std::vector<uint32_t> second_run = RunScenario(30000, changes, 17);
+  EXPECT_EQ(first_run, second_run);
+}
+
+// Reports how much faster than real time a long call is simulated.
+TEST(SimulatedRampUpTest, Performance) {
+  const int64_t kDurationMs = 10 * 60 * 1000;
+  const int64_t kQuickDurationMs = 60 * 1000;
+  const int64_t duration_ms = field_trial::IsEnabled("WebRTC-QuickPerfTest")
+                                  ? kQuickDurationMs
+                                  : kDurationMs;
+  // The scheduler replaces the clock of rtc::TimeMicros() while it runs.
+  const int64_t start_us = rtc::TimeMicros();
+  const std::vector<uint32_t> bitrates_bps = RunScenario(
+      duration_ms,
+      {{0, 2000}, {duration_ms / 3, 500}, {2 * duration_ms / 3, 2000}}, 1);
+  const int64_t elapsed_us = std::max<int64_t>(rtc::TimeMicros() - start_us, 1);
+  EXPECT_EQ(static_cast<size_t>(duration_ms / kSampleIntervalMs),
+            bitrates_bps.size());
+
+  test::PrintResult("simulated_call", "", "wall_time",
+                    static_cast<size_t>(elapsed_us / 1000), "ms", false);
+  test::PrintResult("simulated_call", "", "speedup",
+                    static_cast<size_t>(duration_ms * 1000 / elapsed_us),
+                    "x", false);
+}
+
+}  // namespace webrtc
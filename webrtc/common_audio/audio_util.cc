@@ -10,35 +10,201 @@
 
 #include "webrtc/common_audio/include/audio_util.h"
 
+#include "webrtc/common_audio/audio_util_simd.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
 #include "webrtc/typedefs.h"
 
 namespace webrtc {
 
-void FloatToS16(const float* src, size_t size, int16_t* dest) {
+namespace {
+
+void FloatToS16_C(const float* src, size_t size, int16_t* dest) {
   for (size_t i = 0; i < size; ++i)
     dest[i] = FloatToS16(src[i]);
 }
 
-void S16ToFloat(const int16_t* src, size_t size, float* dest) {
+void S16ToFloat_C(const int16_t* src, size_t size, float* dest) {
   for (size_t i = 0; i < size; ++i)
     dest[i] = S16ToFloat(src[i]);
 }
 
-void FloatS16ToS16(const float* src, size_t size, int16_t* dest) {
+void FloatS16ToS16_C(const float* src, size_t size, int16_t* dest) {
   for (size_t i = 0; i < size; ++i)
     dest[i] = FloatS16ToS16(src[i]);
 }
 
-void FloatToFloatS16(const float* src, size_t size, float* dest) {
+void FloatToFloatS16_C(const float* src, size_t size, float* dest) {
   for (size_t i = 0; i < size; ++i)
     dest[i] = FloatToFloatS16(src[i]);
 }
 
-void FloatS16ToFloat(const float* src, size_t size, float* dest) {
+void FloatS16ToFloat_C(const float* src, size_t size, float* dest) {
   for (size_t i = 0; i < size; ++i)
     dest[i] = FloatS16ToFloat(src[i]);
 }
 
+void DeinterleaveStereo_C(const int16_t* interleaved,
+                          size_t samples_per_channel,
+                          int16_t* left,
+                          int16_t* right) {
+  for (size_t i = 0; i < samples_per_channel; ++i) {
+    left[i] = interleaved[2 * i];
+    right[i] = interleaved[2 * i + 1];
+  }
+}
+
+void InterleaveStereo_C(const int16_t* left,
+                        const int16_t* right,
+                        size_t samples_per_channel,
+                        int16_t* interleaved) {
+  for (size_t i = 0; i < samples_per_channel; ++i) {
+    interleaved[2 * i] = left[i];
+    interleaved[2 * i + 1] = right[i];
+  }
+}
+
+void DeinterleaveStereoS16ToFloatS16_C(const int16_t* interleaved,
+                                       size_t samples_per_channel,
+                                       float* left,
+                                       float* right) {
+  for (size_t i = 0; i < samples_per_channel; ++i) {
+    left[i] = interleaved[2 * i];
+    right[i] = interleaved[2 * i + 1];
+  }
+}
+
+struct AudioUtilKernels {
+  void (*float_to_s16)(const float*, size_t, int16_t*);
+  void (*s16_to_float)(const int16_t*, size_t, float*);
+  void (*float_s16_to_s16)(const float*, size_t, int16_t*);
+  void (*float_to_float_s16)(const float*, size_t, float*);
+  void (*float_s16_to_float)(const float*, size_t, float*);
+  void (*deinterleave_stereo)(const int16_t*, size_t, int16_t*, int16_t*);
+  void (*interleave_stereo)(const int16_t*, const int16_t*, size_t, int16_t*);
+  void (*deinterleave_stereo_s16_to_float_s16)(const int16_t*,
+                                               size_t,
+                                               float*,
+                                               float*);
+};
+
+const AudioUtilKernels kKernelsC = {
+    FloatToS16_C,         S16ToFloat_C,
+    FloatS16ToS16_C,      FloatToFloatS16_C,
+    FloatS16ToFloat_C,    DeinterleaveStereo_C,
+    InterleaveStereo_C,   DeinterleaveStereoS16ToFloatS16_C};
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+const AudioUtilKernels kKernelsSSE2 = {
+    FloatToS16_SSE2,       S16ToFloat_SSE2,
+    FloatS16ToS16_SSE2,    FloatToFloatS16_SSE2,
+    FloatS16ToFloat_SSE2,  DeinterleaveStereo_SSE2,
+    InterleaveStereo_SSE2, DeinterleaveStereoS16ToFloatS16_SSE2};
+
+const AudioUtilKernels kKernelsAVX2 = {
+    FloatToS16_AVX2,       S16ToFloat_AVX2,
+    FloatS16ToS16_AVX2,    FloatToFloatS16_AVX2,
+    FloatS16ToFloat_AVX2,  DeinterleaveStereo_AVX2,
+    InterleaveStereo_AVX2, DeinterleaveStereoS16ToFloatS16_AVX2};
+#elif defined(WEBRTC_HAS_NEON)
+const AudioUtilKernels kKernelsNEON = {
+    FloatToS16_NEON,       S16ToFloat_NEON,
+    FloatS16ToS16_NEON,    FloatToFloatS16_NEON,
+    FloatS16ToFloat_NEON,  DeinterleaveStereo_NEON,
+    InterleaveStereo_NEON, DeinterleaveStereoS16ToFloatS16_NEON};
+#endif
+
+const AudioUtilKernels* SelectKernels() {
+// If we know the minimum architecture at compile time, avoid CPU detection.
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  // AVX2 always requires CPU detection.
+  if (WebRtc_GetCPUInfo(kAVX2))
+    return &kKernelsAVX2;
+#if defined(__SSE2__)
+  return &kKernelsSSE2;
+#else
+  return WebRtc_GetCPUInfo(kSSE2) ? &kKernelsSSE2 : &kKernelsC;
+#endif
+#elif defined(WEBRTC_HAS_NEON)
+  return &kKernelsNEON;
+#else
+  return &kKernelsC;
+#endif
+}
+
+const AudioUtilKernels& Kernels() {
+  static const AudioUtilKernels* const kernels = SelectKernels();
+  return *kernels;
+}
+
+}  // namespace
+
+void FloatToS16(const float* src, size_t size, int16_t* dest) {
+  Kernels().float_to_s16(src, size, dest);
+}
+
+void S16ToFloat(const int16_t* src, size_t size, float* dest) {
+  Kernels().s16_to_float(src, size, dest);
+}
+
+void FloatS16ToS16(const float* src, size_t size, int16_t* dest) {
+  Kernels().float_s16_to_s16(src, size, dest);
+}
+
+void FloatToFloatS16(const float* src, size_t size, float* dest) {
+  Kernels().float_to_float_s16(src, size, dest);
+}
+
+void FloatS16ToFloat(const float* src, size_t size, float* dest) {
+  Kernels().float_s16_to_float(src, size, dest);
+}
+
+template <>
+void Deinterleave<int16_t>(const int16_t* interleaved,
+                           size_t samples_per_channel,
+                           size_t num_channels,
+                           int16_t* const* deinterleaved) {
+  if (num_channels == 2) {
+    Kernels().deinterleave_stereo(interleaved, samples_per_channel,
+                                  deinterleaved[0], deinterleaved[1]);
+  } else {
+    DeinterleaveImpl(interleaved, samples_per_channel, num_channels,
+                     deinterleaved);
+  }
+}
+
+template <>
+void Interleave<int16_t>(const int16_t* const* deinterleaved,
+                         size_t samples_per_channel,
+                         size_t num_channels,
+                         int16_t* interleaved) {
+  if (num_channels == 2) {
+    Kernels().interleave_stereo(deinterleaved[0], deinterleaved[1],
+                                samples_per_channel, interleaved);
+  } else {
+    InterleaveImpl(deinterleaved, samples_per_channel, num_channels,
+                   interleaved);
+  }
+}
+
+void DeinterleaveS16ToFloatS16(const int16_t* interleaved,
+                               size_t samples_per_channel,
+                               size_t num_channels,
+                               float* const* deinterleaved) {
+  if (num_channels == 2) {
+    Kernels().deinterleave_stereo_s16_to_float_s16(
+        interleaved, samples_per_channel, deinterleaved[0], deinterleaved[1]);
+    return;
+  }
+  for (size_t i = 0; i < num_channels; ++i) {
+    float* channel = deinterleaved[i];
+    size_t interleaved_idx = i;
+    for (size_t j = 0; j < samples_per_channel; ++j) {
+      channel[j] = interleaved[interleaved_idx];
+      interleaved_idx += num_channels;
+    }
+  }
+}
+
 template <>
 void DownmixInterleavedToMono<int16_t>(const int16_t* interleaved,
                                        size_t num_frames,
@@ -0,0 +1,197 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/common_audio/audio_util_simd.h"
+
+#include <immintrin.h>
+
+#include "webrtc/common_audio/include/audio_util.h"
+
+namespace webrtc {
+
+namespace {
+
+inline __m256 Select(__m256 mask, __m256 a, __m256 b) {
+  return _mm256_blendv_ps(b, a, mask);
+}
+
+// Multiplies positive values by |positive_scale| and the others by
+// |negative_scale|.
+inline __m256 Scale(__m256 v, float positive_scale, float negative_scale) {
+  const __m256 positive = _mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_GT_OQ);
+  return _mm256_mul_ps(v, Select(positive, _mm256_set1_ps(positive_scale),
+                                 _mm256_set1_ps(negative_scale)));
+}
+
+// Adds 0.5 to positive values and subtracts it from the others, then
+// saturates to the int16 range and truncates, like FloatS16ToS16(float).
+inline __m256i RoundToS16x8(__m256 v, __m256 positive) {
+  v = _mm256_add_ps(
+      v, Select(positive, _mm256_set1_ps(0.5f), _mm256_set1_ps(-0.5f)));
+  v = _mm256_max_ps(v, _mm256_set1_ps(limits_int16::min()));
+  v = _mm256_min_ps(v, _mm256_set1_ps(limits_int16::max()));
+  return _mm256_cvttps_epi32(v);
+}
+
+inline __m256i FloatToS16x8(__m256 v) {
+  const __m256 positive = _mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_GT_OQ);
+  const __m256 scaled =
+      _mm256_mul_ps(v, Select(positive, _mm256_set1_ps(limits_int16::max()),
+                              _mm256_set1_ps(-limits_int16::min())));
+  return RoundToS16x8(scaled, positive);
+}
+
+inline __m256i FloatS16ToS16x8(__m256 v) {
+  return RoundToS16x8(v,
+                      _mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_GT_OQ));
+}
+
+// Packs two vectors of 32-bit values in the int16 range into one of 16-bit
+// values, in order. _mm256_packs_epi32 works within 128-bit lanes.
+inline __m256i PackS32x16(__m256i lo, __m256i hi) {
+  return _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xd8);
+}
+
+inline __m256 LoadS16x8(const int16_t* src) {
+  return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src))));
+}
+
+}  // namespace
+
+void FloatToS16_AVX2(const float* src, size_t size, int16_t* dest) {
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m256i lo = FloatToS16x8(_mm256_loadu_ps(src + i));
+    const __m256i hi = FloatToS16x8(_mm256_loadu_ps(src + i + 8));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i),
+                        PackS32x16(lo, hi));
+  }
+  for (; i < size; ++i)
+    dest[i] = FloatToS16(src[i]);
+}
+
+void S16ToFloat_AVX2(const int16_t* src, size_t size, float* dest) {
+  const float kMaxInt16Inverse = 1.f / limits_int16::max();
+  const float kMinInt16Inverse = -1.f / limits_int16::min();
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    _mm256_storeu_ps(dest + i, Scale(LoadS16x8(src + i), kMaxInt16Inverse,
+                                     kMinInt16Inverse));
+  }
+  for (; i < size; ++i)
+    dest[i] = S16ToFloat(src[i]);
+}
+
+void FloatS16ToS16_AVX2(const float* src, size_t size, int16_t* dest) {
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m256i lo = FloatS16ToS16x8(_mm256_loadu_ps(src + i));
+    const __m256i hi = FloatS16ToS16x8(_mm256_loadu_ps(src + i + 8));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i),
+                        PackS32x16(lo, hi));
+  }
+  for (; i < size; ++i)
+    dest[i] = FloatS16ToS16(src[i]);
+}
+
+void FloatToFloatS16_AVX2(const float* src, size_t size, float* dest) {
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    _mm256_storeu_ps(dest + i,
+                     Scale(_mm256_loadu_ps(src + i), limits_int16::max(),
+                           -limits_int16::min()));
+  }
+  for (; i < size; ++i)
+    dest[i] = FloatToFloatS16(src[i]);
+}
+
+void FloatS16ToFloat_AVX2(const float* src, size_t size, float* dest) {
+  const float kMaxInt16Inverse = 1.f / limits_int16::max();
+  const float kMinInt16Inverse = -1.f / limits_int16::min();
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    _mm256_storeu_ps(dest + i, Scale(_mm256_loadu_ps(src + i),
+                                     kMaxInt16Inverse, kMinInt16Inverse));
+  }
+  for (; i < size; ++i)
+    dest[i] = FloatS16ToFloat(src[i]);
+}
+
+void DeinterleaveStereo_AVX2(const int16_t* interleaved,
+                             size_t samples_per_channel,
+                             int16_t* left,
+                             int16_t* right) {
+  size_t i = 0;
+  for (; i + 16 <= samples_per_channel; i += 16) {
+    const __m256i a = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(interleaved + 2 * i));
+    const __m256i b = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(interleaved + 2 * i + 16));
+    // Sign extend the left samples in the low half of each 32-bit pair and
+    // shift down the right samples in the high half.
+    const __m256i left_a = _mm256_srai_epi32(_mm256_slli_epi32(a, 16), 16);
+    const __m256i left_b = _mm256_srai_epi32(_mm256_slli_epi32(b, 16), 16);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(left + i),
+                        PackS32x16(left_a, left_b));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(right + i),
+        PackS32x16(_mm256_srai_epi32(a, 16), _mm256_srai_epi32(b, 16)));
+  }
+  for (; i < samples_per_channel; ++i) {
+    left[i] = interleaved[2 * i];
+    right[i] = interleaved[2 * i + 1];
+  }
+}
+
+void InterleaveStereo_AVX2(const int16_t* left,
+                           const int16_t* right,
+                           size_t samples_per_channel,
+                           int16_t* interleaved) {
+  size_t i = 0;
+  for (; i + 16 <= samples_per_channel; i += 16) {
+    const __m256i l =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + i));
+    const __m256i r =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(right + i));
+    // Samples 0-3 and 8-11, and 4-7 and 12-15.
+    const __m256i lo = _mm256_unpacklo_epi16(l, r);
+    const __m256i hi = _mm256_unpackhi_epi16(l, r);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(interleaved + 2 * i),
+                        _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(interleaved + 2 * i + 16),
+                        _mm256_permute2x128_si256(lo, hi, 0x31));
+  }
+  for (; i < samples_per_channel; ++i) {
+    interleaved[2 * i] = left[i];
+    interleaved[2 * i + 1] = right[i];
+  }
+}
+
+void DeinterleaveStereoS16ToFloatS16_AVX2(const int16_t* interleaved,
+                                          size_t samples_per_channel,
+                                          float* left,
+                                          float* right) {
+  size_t i = 0;
+  for (; i + 8 <= samples_per_channel; i += 8) {
+    const __m256i v = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(interleaved + 2 * i));
+    const __m256i l = _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+    const __m256i r = _mm256_srai_epi32(v, 16);
+    _mm256_storeu_ps(left + i, _mm256_cvtepi32_ps(l));
+    _mm256_storeu_ps(right + i, _mm256_cvtepi32_ps(r));
+  }
+  for (; i < samples_per_channel; ++i) {
+    left[i] = interleaved[2 * i];
+    right[i] = interleaved[2 * i + 1];
+  }
+}
+
+}  // namespace webrtc
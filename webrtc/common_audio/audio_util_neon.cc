@@ -0,0 +1,169 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/common_audio/audio_util_simd.h"
+
+#include <arm_neon.h>
+
+#include "webrtc/common_audio/include/audio_util.h"
+
+namespace webrtc {
+
+namespace {
+
+// Multiplies positive values by |positive_scale| and the others by
+// |negative_scale|.
+inline float32x4_t Scale(float32x4_t v,
+                         float positive_scale,
+                         float negative_scale) {
+  const uint32x4_t positive = vcgtq_f32(v, vdupq_n_f32(0.f));
+  return vmulq_f32(v, vbslq_f32(positive, vdupq_n_f32(positive_scale),
+                                vdupq_n_f32(negative_scale)));
+}
+
+// Adds 0.5 to positive values and subtracts it from the others, then
+// saturates to the int16 range and truncates, like FloatS16ToS16(float).
+inline int16x4_t RoundToS16x4(float32x4_t v, uint32x4_t positive) {
+  v = vaddq_f32(v,
+                vbslq_f32(positive, vdupq_n_f32(0.5f), vdupq_n_f32(-0.5f)));
+  v = vmaxq_f32(v, vdupq_n_f32(limits_int16::min()));
+  v = vminq_f32(v, vdupq_n_f32(limits_int16::max()));
+  return vqmovn_s32(vcvtq_s32_f32(v));
+}
+
+inline int16x4_t FloatToS16x4(float32x4_t v) {
+  const uint32x4_t positive = vcgtq_f32(v, vdupq_n_f32(0.f));
+  const float32x4_t scaled =
+      vmulq_f32(v, vbslq_f32(positive, vdupq_n_f32(limits_int16::max()),
+                             vdupq_n_f32(-limits_int16::min())));
+  return RoundToS16x4(scaled, positive);
+}
+
+inline int16x4_t FloatS16ToS16x4(float32x4_t v) {
+  return RoundToS16x4(v, vcgtq_f32(v, vdupq_n_f32(0.f)));
+}
+
+inline int16x8_t FloatS16ToS16x8(const float* src) {
+  return vcombine_s16(FloatS16ToS16x4(vld1q_f32(src)),
+                      FloatS16ToS16x4(vld1q_f32(src + 4)));
+}
+
+inline void StoreS16x8AsFloat(int16x8_t v, float* dest) {
+  vst1q_f32(dest, vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))));
+  vst1q_f32(dest + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))));
+}
+
+}  // namespace
+
+void FloatToS16_NEON(const float* src, size_t size, int16_t* dest) {
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    vst1q_s16(dest + i, vcombine_s16(FloatToS16x4(vld1q_f32(src + i)),
+                                     FloatToS16x4(vld1q_f32(src + i + 4))));
+  }
+  for (; i < size; ++i)
+    dest[i] = FloatToS16(src[i]);
+}
+
+void S16ToFloat_NEON(const int16_t* src, size_t size, float* dest) {
+  const float kMaxInt16Inverse = 1.f / limits_int16::max();
+  const float kMinInt16Inverse = -1.f / limits_int16::min();
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    const int16x8_t v = vld1q_s16(src + i);
+    const float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+    const float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+    vst1q_f32(dest + i, Scale(lo, kMaxInt16Inverse, kMinInt16Inverse));
+    vst1q_f32(dest + i + 4, Scale(hi, kMaxInt16Inverse, kMinInt16Inverse));
+  }
+  for (; i < size; ++i)
+    dest[i] = S16ToFloat(src[i]);
+}
+
+void FloatS16ToS16_NEON(const float* src, size_t size, int16_t* dest) {
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8)
+    vst1q_s16(dest + i, FloatS16ToS16x8(src + i));
+  for (; i < size; ++i)
+    dest[i] = FloatS16ToS16(src[i]);
+}
+
+void FloatToFloatS16_NEON(const float* src, size_t size, float* dest) {
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    vst1q_f32(dest + i, Scale(vld1q_f32(src + i), limits_int16::max(),
+                              -limits_int16::min()));
+  }
+  for (; i < size; ++i)
+    dest[i] = FloatToFloatS16(src[i]);
+}
+
+void FloatS16ToFloat_NEON(const float* src, size_t size, float* dest) {
+  const float kMaxInt16Inverse = 1.f / limits_int16::max();
+  const float kMinInt16Inverse = -1.f / limits_int16::min();
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    vst1q_f32(dest + i,
+              Scale(vld1q_f32(src + i), kMaxInt16Inverse, kMinInt16Inverse));
+  }
+  for (; i < size; ++i)
+    dest[i] = FloatS16ToFloat(src[i]);
+}
+
+void DeinterleaveStereo_NEON(const int16_t* interleaved,
+                             size_t samples_per_channel,
+                             int16_t* left,
+                             int16_t* right) {
+  size_t i = 0;
+  for (; i + 8 <= samples_per_channel; i += 8) {
+    const int16x8x2_t v = vld2q_s16(interleaved + 2 * i);
+    vst1q_s16(left + i, v.val[0]);
+    vst1q_s16(right + i, v.val[1]);
+  }
+  for (; i < samples_per_channel; ++i) {
+    left[i] = interleaved[2 * i];
+    right[i] = interleaved[2 * i + 1];
+  }
+}
+
+void InterleaveStereo_NEON(const int16_t* left,
+                           const int16_t* right,
+                           size_t samples_per_channel,
+                           int16_t* interleaved) {
+  size_t i = 0;
+  for (; i + 8 <= samples_per_channel; i += 8) {
+    int16x8x2_t v;
+    v.val[0] = vld1q_s16(left + i);
+    v.val[1] = vld1q_s16(right + i);
+    vst2q_s16(interleaved + 2 * i, v);
+  }
+  for (; i < samples_per_channel; ++i) {
+    interleaved[2 * i] = left[i];
+    interleaved[2 * i + 1] = right[i];
+  }
+}
+
+void DeinterleaveStereoS16ToFloatS16_NEON(const int16_t* interleaved,
+                                          size_t samples_per_channel,
+                                          float* left,
+                                          float* right) {
+  size_t i = 0;
+  for (; i + 8 <= samples_per_channel; i += 8) {
+    const int16x8x2_t v = vld2q_s16(interleaved + 2 * i);
+    StoreS16x8AsFloat(v.val[0], left + i);
+    StoreS16x8AsFloat(v.val[1], right + i);
+  }
+  for (; i < samples_per_channel; ++i) {
+    left[i] = interleaved[2 * i];
+    right[i] = interleaved[2 * i + 1];
+  }
+}
+
+}  // namespace webrtc
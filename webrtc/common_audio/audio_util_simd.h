@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_COMMON_AUDIO_AUDIO_UTIL_SIMD_H_
+#define WEBRTC_COMMON_AUDIO_AUDIO_UTIL_SIMD_H_
+
+#include <stddef.h>
+
+#include "webrtc/typedefs.h"
+
+namespace webrtc {
+
+// Vectorized versions of the audio_util.h conversions, selected at runtime by
+// audio_util.cc. They produce the same output as the scalar functions, which
+// they use for the samples past the last full vector. The stereo functions
+// take the left and right channel buffers.
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+void FloatToS16_SSE2(const float* src, size_t size, int16_t* dest);
+void S16ToFloat_SSE2(const int16_t* src, size_t size, float* dest);
+void FloatS16ToS16_SSE2(const float* src, size_t size, int16_t* dest);
+void FloatToFloatS16_SSE2(const float* src, size_t size, float* dest);
+void FloatS16ToFloat_SSE2(const float* src, size_t size, float* dest);
+void DeinterleaveStereo_SSE2(const int16_t* interleaved,
+                             size_t samples_per_channel,
+                             int16_t* left,
+                             int16_t* right);
+void InterleaveStereo_SSE2(const int16_t* left,
+                           const int16_t* right,
+                           size_t samples_per_channel,
+                           int16_t* interleaved);
+void DeinterleaveStereoS16ToFloatS16_SSE2(const int16_t* interleaved,
+                                          size_t samples_per_channel,
+                                          float* left,
+                                          float* right);
+
+void FloatToS16_AVX2(const float* src, size_t size, int16_t* dest);
+void S16ToFloat_AVX2(const int16_t* src, size_t size, float* dest);
+void FloatS16ToS16_AVX2(const float* src, size_t size, int16_t* dest);
+void FloatToFloatS16_AVX2(const float* src, size_t size, float* dest);
+void FloatS16ToFloat_AVX2(const float* src, size_t size, float* dest);
+void DeinterleaveStereo_AVX2(const int16_t* interleaved,
+                             size_t samples_per_channel,
+                             int16_t* left,
+                             int16_t* right);
+void InterleaveStereo_AVX2(const int16_t* left,
+                           const int16_t* right,
+                           size_t samples_per_channel,
+                           int16_t* interleaved);
+void DeinterleaveStereoS16ToFloatS16_AVX2(const int16_t* interleaved,
+                                          size_t samples_per_channel,
+                                          float* left,
+                                          float* right);
+#elif defined(WEBRTC_HAS_NEON)
+void FloatToS16_NEON(const float* src, size_t size, int16_t* dest);
+void S16ToFloat_NEON(const int16_t* src, size_t size, float* dest);
+void FloatS16ToS16_NEON(const float* src, size_t size, int16_t* dest);
+void FloatToFloatS16_NEON(const float* src, size_t size, float* dest);
+void FloatS16ToFloat_NEON(const float* src, size_t size, float* dest);
+void DeinterleaveStereo_NEON(const int16_t* interleaved,
+                             size_t samples_per_channel,
+                             int16_t* left,
+                             int16_t* right);
+void InterleaveStereo_NEON(const int16_t* left,
+                           const int16_t* right,
+                           size_t samples_per_channel,
+                           int16_t* interleaved);
+void DeinterleaveStereoS16ToFloatS16_NEON(const int16_t* interleaved,
+                                          size_t samples_per_channel,
+                                          float* left,
+                                          float* right);
+#endif
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_COMMON_AUDIO_AUDIO_UTIL_SIMD_H_
@@ -0,0 +1,188 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/common_audio/audio_util_simd.h"
+
+#include <emmintrin.h>
+
+#include "webrtc/common_audio/include/audio_util.h"
+
+namespace webrtc {
+
+namespace {
+
+// Returns |a| where |mask| is set and |b| elsewhere.
+inline __m128 Select(__m128 mask, __m128 a, __m128 b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Multiplies positive values by |positive_scale| and the others by
+// |negative_scale|.
+inline __m128 Scale(__m128 v, float positive_scale, float negative_scale) {
+  const __m128 positive = _mm_cmpgt_ps(v, _mm_setzero_ps());
+  return _mm_mul_ps(v, Select(positive, _mm_set1_ps(positive_scale),
+                              _mm_set1_ps(negative_scale)));
+}
+
+// Adds 0.5 to positive values and subtracts it from the others, then
+// saturates to the int16 range and truncates, like FloatS16ToS16(float).
+inline __m128i RoundToS16x4(__m128 v, __m128 positive) {
+  v = _mm_add_ps(v, Select(positive, _mm_set1_ps(0.5f), _mm_set1_ps(-0.5f)));
+  v = _mm_max_ps(v, _mm_set1_ps(limits_int16::min()));
+  v = _mm_min_ps(v, _mm_set1_ps(limits_int16::max()));
+  return _mm_cvttps_epi32(v);
+}
+
+inline __m128i FloatToS16x4(__m128 v) {
+  const __m128 positive = _mm_cmpgt_ps(v, _mm_setzero_ps());
+  const __m128 scaled =
+      _mm_mul_ps(v, Select(positive, _mm_set1_ps(limits_int16::max()),
+                           _mm_set1_ps(-limits_int16::min())));
+  return RoundToS16x4(scaled, positive);
+}
+
+inline __m128i FloatS16ToS16x4(__m128 v) {
+  return RoundToS16x4(v, _mm_cmpgt_ps(v, _mm_setzero_ps()));
+}
+
+}  // namespace
+
+void FloatToS16_SSE2(const float* src, size_t size, int16_t* dest) {
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    const __m128i lo = FloatToS16x4(_mm_loadu_ps(src + i));
+    const __m128i hi = FloatToS16x4(_mm_loadu_ps(src + i + 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i),
+                     _mm_packs_epi32(lo, hi));
+  }
+  for (; i < size; ++i)
+    dest[i] = FloatToS16(src[i]);
+}
+
+void S16ToFloat_SSE2(const int16_t* src, size_t size, float* dest) {
+  const float kMaxInt16Inverse = 1.f / limits_int16::max();
+  const float kMinInt16Inverse = -1.f / limits_int16::min();
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    // Sign extend to 32 bits.
+    const __m128i lo32 = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    const __m128i hi32 = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+    const __m128 lo = _mm_cvtepi32_ps(lo32);
+    const __m128 hi = _mm_cvtepi32_ps(hi32);
+    _mm_storeu_ps(dest + i, Scale(lo, kMaxInt16Inverse, kMinInt16Inverse));
+    _mm_storeu_ps(dest + i + 4, Scale(hi, kMaxInt16Inverse, kMinInt16Inverse));
+  }
+  for (; i < size; ++i)
+    dest[i] = S16ToFloat(src[i]);
+}
+
+void FloatS16ToS16_SSE2(const float* src, size_t size, int16_t* dest) {
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    const __m128i lo = FloatS16ToS16x4(_mm_loadu_ps(src + i));
+    const __m128i hi = FloatS16ToS16x4(_mm_loadu_ps(src + i + 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i),
+                     _mm_packs_epi32(lo, hi));
+  }
+  for (; i < size; ++i)
+    dest[i] = FloatS16ToS16(src[i]);
+}
+
+void FloatToFloatS16_SSE2(const float* src, size_t size, float* dest) {
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    _mm_storeu_ps(dest + i, Scale(_mm_loadu_ps(src + i), limits_int16::max(),
+                                  -limits_int16::min()));
+  }
+  for (; i < size; ++i)
+    dest[i] = FloatToFloatS16(src[i]);
+}
+
+void FloatS16ToFloat_SSE2(const float* src, size_t size, float* dest) {
+  const float kMaxInt16Inverse = 1.f / limits_int16::max();
+  const float kMinInt16Inverse = -1.f / limits_int16::min();
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    _mm_storeu_ps(dest + i, Scale(_mm_loadu_ps(src + i), kMaxInt16Inverse,
+                                  kMinInt16Inverse));
+  }
+  for (; i < size; ++i)
+    dest[i] = FloatS16ToFloat(src[i]);
+}
+
+void DeinterleaveStereo_SSE2(const int16_t* interleaved,
+                             size_t samples_per_channel,
+                             int16_t* left,
+                             int16_t* right) {
+  size_t i = 0;
+  for (; i + 8 <= samples_per_channel; i += 8) {
+    const __m128i a =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(interleaved + 2 * i));
+    const __m128i b = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(interleaved + 2 * i + 8));
+    // Sign extend the left samples in the low half of each 32-bit pair and
+    // shift down the right samples in the high half.
+    const __m128i left_a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+    const __m128i left_b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(left + i),
+                     _mm_packs_epi32(left_a, left_b));
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(right + i),
+        _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16)));
+  }
+  for (; i < samples_per_channel; ++i) {
+    left[i] = interleaved[2 * i];
+    right[i] = interleaved[2 * i + 1];
+  }
+}
+
+void InterleaveStereo_SSE2(const int16_t* left,
+                           const int16_t* right,
+                           size_t samples_per_channel,
+                           int16_t* interleaved) {
+  size_t i = 0;
+  for (; i + 8 <= samples_per_channel; i += 8) {
+    const __m128i l =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i));
+    const __m128i r =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(interleaved + 2 * i),
+                     _mm_unpacklo_epi16(l, r));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(interleaved + 2 * i + 8),
+                     _mm_unpackhi_epi16(l, r));
+  }
+  for (; i < samples_per_channel; ++i) {
+    interleaved[2 * i] = left[i];
+    interleaved[2 * i + 1] = right[i];
+  }
+}
+
+void DeinterleaveStereoS16ToFloatS16_SSE2(const int16_t* interleaved,
+                                          size_t samples_per_channel,
+                                          float* left,
+                                          float* right) {
+  size_t i = 0;
+  for (; i + 4 <= samples_per_channel; i += 4) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(interleaved + 2 * i));
+    const __m128i l = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+    const __m128i r = _mm_srai_epi32(v, 16);
+    _mm_storeu_ps(left + i, _mm_cvtepi32_ps(l));
+    _mm_storeu_ps(right + i, _mm_cvtepi32_ps(r));
+  }
+  for (; i < samples_per_channel; ++i) {
+    left[i] = interleaved[2 * i];
+    right[i] = interleaved[2 * i + 1];
+  }
+}
+
+}  // namespace webrtc
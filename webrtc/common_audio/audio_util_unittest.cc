@@ -9,8 +9,19 @@
  */
 
 #include "webrtc/common_audio/include/audio_util.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "webrtc/common_audio/audio_util_simd.h"
+#include "webrtc/rtc_base/random.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
 #include "webrtc/test/gmock.h"
 #include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
 #include "webrtc/typedefs.h"
 
 namespace webrtc {
@@ -227,5 +238,235 @@ TEST(AudioUtilTest, DownmixToMonoTest) {
   }
 }
 
+// Random samples in [-|range|, |range|], followed by values on the rounding
+// and saturation boundaries of the conversions.
+std::vector<float> CreateFloatSamples(float range) {
+  Random random(0x1234);
+  std::vector<float> samples(1000);
+  for (float& sample : samples)
+    sample = range * (2 * random.Rand<float>() - 1);
+  const float kBoundaries[] = {0.f,      -0.f,      0.5f,     -0.5f,
+                               1.f,      -1.f,      1.5f,     -1.5f,
+                               32766.5f, 32767.f,   32767.5f, 40000.f,
+                               -32767.5f, -32768.f, -32768.5f, -40000.f};
+  for (float boundary : kBoundaries) {
+    samples.push_back(boundary);
+    samples.push_back(boundary / 32767.f);
+    samples.push_back(boundary / 32768.f);
+  }
+  return samples;
+}
+
+std::vector<int16_t> CreateS16Samples() {
+  std::vector<int16_t> samples;
+  for (int i = limits_int16::min(); i <= limits_int16::max(); ++i)
+    samples.push_back(static_cast<int16_t>(i));
+  return samples;
+}
+
+// Checks that |convert| matches |scalar| for every sample, for all sizes
+// up to 40 and for the whole of |input|.
+template <typename In, typename Out>
+void ExpectMatchesScalar(void (*convert)(const In*, size_t, Out*),
+                         Out (*scalar)(In),
+                         const std::vector<In>& input) {
+  std::vector<Out> output(input.size());
+  for (size_t size = 0; size <= input.size(); size = size < 40 ? size + 1
+                                                              : input.size()) {
+    std::fill(output.begin(), output.end(), Out(123));
+    convert(input.data(), size, output.data());
+    for (size_t i = 0; i < size; ++i)
+      ASSERT_EQ(scalar(input[i]), output[i]) << "size " << size << " at " << i;
+    for (size_t i = size; i < input.size(); ++i)
+      ASSERT_EQ(Out(123), output[i]) << "Wrote past the end.";
+    if (size == input.size())
+      break;
+  }
+}
+
+void ExpectConversionsMatchScalar(
+    void (*float_to_s16)(const float*, size_t, int16_t*),
+    void (*s16_to_float)(const int16_t*, size_t, float*),
+    void (*float_s16_to_s16)(const float*, size_t, int16_t*),
+    void (*float_to_float_s16)(const float*, size_t, float*),
+    void (*float_s16_to_float)(const float*, size_t, float*)) {
+  const std::vector<float> float_samples = CreateFloatSamples(1.2f);
+  const std::vector<float> float_s16_samples = CreateFloatSamples(40000.f);
+  ExpectMatchesScalar<float, int16_t>(float_to_s16, &FloatToS16,
+                                      float_samples);
+  ExpectMatchesScalar<int16_t, float>(s16_to_float, &S16ToFloat,
+                                      CreateS16Samples());
+  ExpectMatchesScalar<float, int16_t>(float_s16_to_s16, &FloatS16ToS16,
+                                      float_s16_samples);
+  ExpectMatchesScalar<float, float>(float_to_float_s16, &FloatToFloatS16,
+                                    float_samples);
+  ExpectMatchesScalar<float, float>(float_s16_to_float, &FloatS16ToFloat,
+                                    float_s16_samples);
+}
+
+TEST(AudioUtilTest, ConversionsMatchScalar) {
+  ExpectConversionsMatchScalar(&FloatToS16, &S16ToFloat, &FloatS16ToS16,
+                               &FloatToFloatS16, &FloatS16ToFloat);
+}
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+TEST(AudioUtilTest, Sse2ConversionsMatchScalar) {
+  ASSERT_TRUE(WebRtc_GetCPUInfo(kSSE2));
+  ExpectConversionsMatchScalar(&FloatToS16_SSE2, &S16ToFloat_SSE2,
+                               &FloatS16ToS16_SSE2, &FloatToFloatS16_SSE2,
+                               &FloatS16ToFloat_SSE2);
+}
+
+TEST(AudioUtilTest, Avx2ConversionsMatchScalar) {
+  if (!WebRtc_GetCPUInfo(kAVX2))
+    return;
+  ExpectConversionsMatchScalar(&FloatToS16_AVX2, &S16ToFloat_AVX2,
+                               &FloatS16ToS16_AVX2, &FloatToFloatS16_AVX2,
+                               &FloatS16ToFloat_AVX2);
+}
+#endif
+
+TEST(AudioUtilTest, InterleavingMatchesGenericImplementation) {
+  Random random(0x5678);
+  for (size_t num_channels : {1, 2, 3, 8}) {
+    for (size_t samples_per_channel = 0; samples_per_channel < 40;
+         ++samples_per_channel) {
+      const size_t length = num_channels * samples_per_channel;
+      std::vector<int16_t> interleaved(length);
+      for (int16_t& sample : interleaved)
+        sample = random.Rand<int16_t>();
+
+      std::vector<std::vector<int16_t>> expected(
+          num_channels, std::vector<int16_t>(samples_per_channel));
+      std::vector<std::vector<int16_t>> actual = expected;
+      std::vector<int16_t*> expected_ptrs, actual_ptrs;
+      for (size_t i = 0; i < num_channels; ++i) {
+        expected_ptrs.push_back(expected[i].data());
+        actual_ptrs.push_back(actual[i].data());
+      }
+      DeinterleaveImpl(interleaved.data(), samples_per_channel, num_channels,
+                       expected_ptrs.data());
+      Deinterleave(interleaved.data(), samples_per_channel, num_channels,
+                   actual_ptrs.data());
+      EXPECT_EQ(expected, actual);
+
+      std::vector<int16_t> reinterleaved(length);
+      Interleave(actual_ptrs.data(), samples_per_channel, num_channels,
+                 reinterleaved.data());
+      EXPECT_EQ(interleaved, reinterleaved);
+    }
+  }
+}
+
+TEST(AudioUtilTest, DeinterleaveS16ToFloatS16MatchesDeinterleave) {
+  Random random(0x9abc);
+  for (size_t num_channels : {1, 2, 3, 8}) {
+    for (size_t samples_per_channel = 0; samples_per_channel < 40;
+         ++samples_per_channel) {
+      const size_t length = num_channels * samples_per_channel;
+      std::vector<int16_t> interleaved(length);
+      for (int16_t& sample : interleaved)
+        sample = random.Rand<int16_t>();
+
+      std::vector<std::vector<float>> channels(
+          num_channels, std::vector<float>(samples_per_channel));
+      std::vector<float*> channel_ptrs;
+      for (std::vector<float>& channel : channels)
+        channel_ptrs.push_back(channel.data());
+      DeinterleaveS16ToFloatS16(interleaved.data(), samples_per_channel,
+                                num_channels, channel_ptrs.data());
+      for (size_t i = 0; i < num_channels; ++i) {
+        for (size_t j = 0; j < samples_per_channel; ++j)
+          ASSERT_EQ(interleaved[j * num_channels + i], channels[i][j]);
+      }
+    }
+  }
+}
+
+// Reports the time each routine takes for a 10 ms frame at 48 kHz.
+// Disabled since it only reports timings; run it with
+// --gtest_also_run_disabled_tests.
+TEST(AudioUtilTest, DISABLED_Performance) {
+  const size_t kSamplesPerChannel = 480;
+  const int kNumIterations = 20000;
+
+  for (size_t num_channels : {1, 2, 8}) {
+    const size_t length = num_channels * kSamplesPerChannel;
+    const std::string trace = std::to_string(num_channels) + "ch";
+    std::vector<float> float_data(length);
+    std::vector<float> float_data_out(length);
+    std::vector<int16_t> s16_data(length);
+    std::vector<int16_t> s16_data_out(length);
+    std::vector<std::vector<float>> float_channels(
+        num_channels, std::vector<float>(kSamplesPerChannel));
+    std::vector<std::vector<int16_t>> s16_channels(
+        num_channels, std::vector<int16_t>(kSamplesPerChannel));
+    std::vector<float*> float_ptrs;
+    std::vector<int16_t*> s16_ptrs;
+    for (size_t i = 0; i < num_channels; ++i) {
+      float_ptrs.push_back(float_channels[i].data());
+      s16_ptrs.push_back(s16_channels[i].data());
+    }
+    Random random(0x4321);
+    for (size_t i = 0; i < length; ++i) {
+      s16_data[i] = random.Rand<int16_t>();
+      float_data[i] = S16ToFloat(s16_data[i]);
+    }
+
+    auto measure = [&](const char* name, const std::function<void()>& run) {
+      const int64_t start_us = rtc::TimeMicros();
+      for (int i = 0; i < kNumIterations; ++i)
+        run();
+      const int64_t elapsed_us = rtc::TimeMicros() - start_us;
+      test::PrintResult(name, "", trace,
+                        static_cast<size_t>(1000 * elapsed_us / kNumIterations),
+                        "ns", false);
+    };
+
+    measure("float_to_s16", [&] {
+      FloatToS16(float_data.data(), length, s16_data_out.data());
+    });
+    measure("s16_to_float", [&] {
+      S16ToFloat(s16_data.data(), length, float_data_out.data());
+    });
+    measure("float_s16_to_s16", [&] {
+      FloatS16ToS16(float_data.data(), length, s16_data_out.data());
+    });
+    measure("float_to_float_s16", [&] {
+      FloatToFloatS16(float_data.data(), length, float_data_out.data());
+    });
+    measure("float_s16_to_float", [&] {
+      FloatS16ToFloat(float_data.data(), length, float_data_out.data());
+    });
+    measure("deinterleave", [&] {
+      Deinterleave(s16_data.data(), kSamplesPerChannel, num_channels,
+                   s16_ptrs.data());
+    });
+    measure("interleave", [&] {
+      Interleave(s16_ptrs.data(), kSamplesPerChannel, num_channels,
+                 s16_data_out.data());
+    });
+    measure("deinterleave_s16_to_float_s16", [&] {
+      DeinterleaveS16ToFloatS16(s16_data.data(), kSamplesPerChannel,
+                                num_channels, float_ptrs.data());
+    });
+    measure("upmix_mono_to_interleaved", [&] {
+      UpmixMonoToInterleaved(s16_ptrs[0], kSamplesPerChannel,
+                             static_cast<int>(num_channels),
+                             s16_data_out.data());
+    });
+    measure("downmix_to_mono", [&] {
+      DownmixToMono<float, float>(float_ptrs.data(), kSamplesPerChannel,
+                                  static_cast<int>(num_channels),
+                                  float_data_out.data());
+    });
+    measure("downmix_interleaved_to_mono", [&] {
+      DownmixInterleavedToMono(s16_data.data(), kSamplesPerChannel,
+                               static_cast<int>(num_channels),
+                               s16_data_out.data());
+    });
+  }
+}
+
 }  // namespace
 }  // namespace webrtc
@@ -36,6 +36,22 @@ ChannelBuffer<float>* IFChannelBuffer::fbuf() {
   return &fbuf_;
 }
 
+ChannelBuffer<int16_t>* IFChannelBuffer::ibuf_for_overwrite() {
+  if (!ivalid_)
+    ibuf_.set_num_channels(fbuf_.num_channels());
+  ivalid_ = true;
+  fvalid_ = false;
+  return &ibuf_;
+}
+
+ChannelBuffer<float>* IFChannelBuffer::fbuf_for_overwrite() {
+  if (!fvalid_)
+    fbuf_.set_num_channels(ibuf_.num_channels());
+  fvalid_ = true;
+  ivalid_ = false;
+  return &fbuf_;
+}
+
 const ChannelBuffer<int16_t>* IFChannelBuffer::ibuf_const() const {
   RefreshI();
   return &ibuf_;
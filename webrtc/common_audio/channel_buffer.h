@@ -159,6 +159,10 @@ class IFChannelBuffer {
   ChannelBuffer<float>* fbuf();
   const ChannelBuffer<int16_t>* ibuf_const() const;
   const ChannelBuffer<float>* fbuf_const() const;
+  // Like ibuf() and fbuf(), but skip bringing the returned ChannelBuffer up to
+  // date. For callers that overwrite every sample of every channel.
+  ChannelBuffer<int16_t>* ibuf_for_overwrite();
+  ChannelBuffer<float>* fbuf_for_overwrite();
 
   size_t num_frames() const { return ibuf_.num_frames(); }
   size_t num_frames_per_band() const { return ibuf_.num_frames_per_band(); }
@@ -50,6 +50,21 @@ TEST(IFChannelBufferTest, SettingNumChannelsOfOneChannelBufferSetsTheOther) {
   ExpectNumChannels(ifchb, kStereo);
 }
 
+TEST(IFChannelBufferTest, OverwriteAccessorsInvalidateTheOtherBuffer) {
+  IFChannelBuffer ifchb(kNumFrames, kStereo);
+  ifchb.ibuf()->set_num_channels(kMono);
+  float* const* fchannels = ifchb.fbuf_for_overwrite()->channels();
+  EXPECT_EQ(ifchb.fbuf_const()->num_channels(), kMono);
+  for (size_t i = 0; i < kNumFrames; ++i)
+    fchannels[0][i] = 1000.4f;
+  EXPECT_EQ(1000, ifchb.ibuf_const()->channels()[0][kNumFrames - 1]);
+
+  int16_t* const* ichannels = ifchb.ibuf_for_overwrite()->channels();
+  for (size_t i = 0; i < kNumFrames; ++i)
+    ichannels[0][i] = -7;
+  EXPECT_EQ(-7.f, ifchb.fbuf_const()->channels()[0][kNumFrames - 1]);
+}
+
 #if RTC_DCHECK_IS_ON && GTEST_HAS_DEATH_TEST && !defined(WEBRTC_ANDROID)
 TEST(ChannelBufferTest, SetNumChannelsDeathTest) {
   ChannelBuffer<float> chb(kNumFrames, kMono);
@@ -59,6 +59,7 @@ static inline float FloatS16ToFloat(float v) {
   return v * (v > 0 ? kMaxInt16Inverse : -kMinInt16Inverse);
 }
 
+// The array versions below use SSE2, AVX2 or NEON when available.
 void FloatToS16(const float* src, size_t size, int16_t* dest);
 void S16ToFloat(const int16_t* src, size_t size, float* dest);
 void FloatS16ToS16(const float* src, size_t size, int16_t* dest);
@@ -80,6 +81,21 @@ void CopyAudioIfNeeded(const T* const* src,
   }
 }
 
+template <typename T>
+void DeinterleaveImpl(const T* interleaved,
+                      size_t samples_per_channel,
+                      size_t num_channels,
+                      T* const* deinterleaved) {
+  for (size_t i = 0; i < num_channels; ++i) {
+    T* channel = deinterleaved[i];
+    size_t interleaved_idx = i;
+    for (size_t j = 0; j < samples_per_channel; ++j) {
+      channel[j] = interleaved[interleaved_idx];
+      interleaved_idx += num_channels;
+    }
+  }
+}
+
 // Deinterleave audio from |interleaved| to the channel buffers pointed to
 // by |deinterleaved|. There must be sufficient space allocated in the
 // |deinterleaved| buffers (|num_channel| buffers with |samples_per_channel|
@@ -89,11 +105,27 @@ void Deinterleave(const T* interleaved,
                   size_t samples_per_channel,
                   size_t num_channels,
                   T* const* deinterleaved) {
+  DeinterleaveImpl(interleaved, samples_per_channel, num_channels,
+                   deinterleaved);
+}
+
+// Vectorized for stereo.
+template <>
+void Deinterleave<int16_t>(const int16_t* interleaved,
+                           size_t samples_per_channel,
+                           size_t num_channels,
+                           int16_t* const* deinterleaved);
+
+template <typename T>
+void InterleaveImpl(const T* const* deinterleaved,
+                    size_t samples_per_channel,
+                    size_t num_channels,
+                    T* interleaved) {
   for (size_t i = 0; i < num_channels; ++i) {
-    T* channel = deinterleaved[i];
+    const T* channel = deinterleaved[i];
     size_t interleaved_idx = i;
     for (size_t j = 0; j < samples_per_channel; ++j) {
-      channel[j] = interleaved[interleaved_idx];
+      interleaved[interleaved_idx] = channel[j];
       interleaved_idx += num_channels;
     }
   }
@@ -107,16 +139,24 @@ void Interleave(const T* const* deinterleaved,
                 size_t samples_per_channel,
                 size_t num_channels,
                 T* interleaved) {
-  for (size_t i = 0; i < num_channels; ++i) {
-    const T* channel = deinterleaved[i];
-    size_t interleaved_idx = i;
-    for (size_t j = 0; j < samples_per_channel; ++j) {
-      interleaved[interleaved_idx] = channel[j];
-      interleaved_idx += num_channels;
-    }
-  }
+  InterleaveImpl(deinterleaved, samples_per_channel, num_channels,
+                 interleaved);
 }
 
+// Vectorized for stereo.
+template <>
+void Interleave<int16_t>(const int16_t* const* deinterleaved,
+                         size_t samples_per_channel,
+                         size_t num_channels,
+                         int16_t* interleaved);
+
+// Deinterleave S16 audio into FloatS16 channel buffers, in a single pass.
+// Equivalent to Deinterleave() followed by converting each channel.
+void DeinterleaveS16ToFloatS16(const int16_t* interleaved,
+                               size_t samples_per_channel,
+                               size_t num_channels,
+                               float* const* deinterleaved);
+
 // Copies audio from a single channel buffer pointed to by |mono| to each
 // channel of |interleaved|. There must be sufficient space allocated in
 // |interleaved| (|samples_per_channel| * |num_channels|).
@@ -12,6 +12,7 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <limits>
 #include <sstream>
 
@@ -38,6 +39,26 @@ class ReadableWavFile : public ReadableWav {
   FILE* file_;
 };
 
+// Reads from a buffer in memory.
+class ReadableWavBuffer : public ReadableWav {
+ public:
+  ReadableWavBuffer(const uint8_t* data, size_t size)
+      : data_(data), size_(size), position_(0) {}
+  size_t Read(void* buf, size_t num_bytes) override {
+    num_bytes = std::min(num_bytes, size_ - position_);
+    if (num_bytes > 0)
+      memcpy(buf, data_ + position_, num_bytes);
+    position_ += num_bytes;
+    return num_bytes;
+  }
+  size_t position() const { return position_; }
+
+ private:
+  const uint8_t* const data_;
+  const size_t size_;
+  size_t position_;
+};
+
 std::string WavFile::FormatAsString() const {
   std::ostringstream s;
   s << "Sample rate: " << sample_rate() << " Hz, Channels: " << num_channels()
@@ -60,6 +81,21 @@ WavReader::WavReader(const std::string& filename)
   RTC_CHECK_EQ(kBytesPerSample, bytes_per_sample);
 }
 
+WavReader::WavReader(const uint8_t* data, size_t size)
+    : file_handle_(nullptr) {
+  ReadableWavBuffer readable(data, size);
+  WavFormat format;
+  size_t bytes_per_sample;
+  RTC_CHECK(ReadWavHeader(&readable, &num_channels_, &sample_rate_, &format,
+                          &bytes_per_sample, &num_samples_));
+  RTC_CHECK_EQ(kWavFormat, format);
+  RTC_CHECK_EQ(kBytesPerSample, bytes_per_sample);
+  next_sample_ = data + readable.position();
+  // Don't read past the end of a truncated file.
+  num_samples_remaining_ =
+      std::min(num_samples_, (size - readable.position()) / kBytesPerSample);
+}
+
 WavReader::~WavReader() {
   Close();
 }
@@ -82,6 +118,12 @@ size_t WavReader::ReadSamples(size_t num_samples, int16_t* samples) {
 #endif
   // There could be metadata after the audio; ensure we don't read it.
   num_samples = std::min(num_samples, num_samples_remaining_);
+  if (next_sample_) {
+    memcpy(samples, next_sample_, num_samples * sizeof(*samples));
+    next_sample_ += num_samples * sizeof(*samples);
+    num_samples_remaining_ -= num_samples;
+    return num_samples;
+  }
   const size_t read =
       fread(samples, sizeof(*samples), num_samples, file_handle_);
   // If we didn't read what was requested, ensure we've reached the EOF.
@@ -106,7 +148,8 @@ size_t WavReader::ReadSamples(size_t num_samples, float* samples) {
 }
 
 void WavReader::Close() {
-  RTC_CHECK_EQ(0, fclose(file_handle_));
+  if (file_handle_)
+    RTC_CHECK_EQ(0, fclose(file_handle_));
   file_handle_ = nullptr;
 }
 
@@ -70,6 +70,10 @@ class WavReader final : public WavFile {
   // Opens an existing WAV file for reading.
   explicit WavReader(const std::string& filename);
 
+  // Reads a WAV file that is already in memory, e.g. memory-mapped. |data|
+  // must outlive the reader.
+  WavReader(const uint8_t* data, size_t size);
+
   // Close the WAV file.
   ~WavReader() override;
 
@@ -89,6 +93,8 @@ class WavReader final : public WavFile {
   size_t num_samples_;  // Total number of samples in the file.
   size_t num_samples_remaining_;
   FILE* file_handle_;  // Input file, owned by this class.
+  // The next sample to read if reading from memory rather than from a file.
+  const uint8_t* next_sample_ = nullptr;
 
   RTC_DISALLOW_COPY_AND_ASSIGN(WavReader);
 };
@@ -11,8 +11,10 @@
 // MSVC++ requires this to be set before any other includes to get M_PI.
 #define _USE_MATH_DEFINES
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
+#include <vector>
 
 #include "webrtc/common_audio/wav_file.h"
 #include "webrtc/common_audio/wav_header.h"
@@ -174,4 +176,50 @@ TEST(WavWriterTest, LargeFile) {
   }
 }
 
+// Read a WAV file from memory and verify that it matches reading the file.
+TEST(WavReaderTest, FromMemory) {
+  const std::string outfile = test::OutputPath() + "wavtest4.wav";
+  static const int kSampleRate = 16000;
+  static const size_t kNumChannels = 2;
+  static const size_t kNumSamples = 1000;
+  float samples[kNumSamples];
+  for (size_t i = 0; i < kNumSamples; ++i)
+    samples[i] = 10.f * i - 5000.f;
+  {
+    WavWriter w(outfile, kSampleRate, kNumChannels);
+    w.WriteSamples(samples, kNumSamples);
+  }
+
+  const size_t file_size = test::GetFileSize(outfile);
+  std::vector<uint8_t> contents(file_size);
+  FILE* f = fopen(outfile.c_str(), "rb");
+  ASSERT_TRUE(f);
+  ASSERT_EQ(1u, fread(contents.data(), file_size, 1, f));
+  EXPECT_EQ(0, fclose(f));
+
+  WavReader file_reader(outfile);
+  WavReader memory_reader(contents.data(), contents.size());
+  EXPECT_EQ(file_reader.sample_rate(), memory_reader.sample_rate());
+  EXPECT_EQ(file_reader.num_channels(), memory_reader.num_channels());
+  EXPECT_EQ(file_reader.num_samples(), memory_reader.num_samples());
+
+  // Read in chunks that don't divide the file evenly.
+  static const size_t kChunkSize = 300;
+  int16_t expected[kChunkSize];
+  int16_t actual[kChunkSize];
+  for (size_t i = 0; i < kNumSamples; i += kChunkSize) {
+    const size_t expected_read = std::min(kChunkSize, kNumSamples - i);
+    EXPECT_EQ(expected_read, file_reader.ReadSamples(kChunkSize, expected));
+    EXPECT_EQ(expected_read, memory_reader.ReadSamples(kChunkSize, actual));
+    EXPECT_EQ(0, memcmp(expected, actual, expected_read * sizeof(int16_t)));
+  }
+  EXPECT_EQ(0u, memory_reader.ReadSamples(kChunkSize, actual));
+
+  // A truncated file is read up to where it ends.
+  WavReader truncated_reader(contents.data(), kWavHeaderSize + 100);
+  EXPECT_EQ(kNumSamples, truncated_reader.num_samples());
+  EXPECT_EQ(50u, truncated_reader.ReadSamples(kChunkSize, actual));
+  EXPECT_EQ(0u, truncated_reader.ReadSamples(kChunkSize, actual));
+}
+
 }  // namespace webrtc
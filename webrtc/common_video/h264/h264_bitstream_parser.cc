@@ -22,6 +22,9 @@ namespace {
 const int kMaxAbsQpDeltaValue = 51;
 const int kMinQpValue = 0;
 const int kMaxQpValue = 51;
+// Slice headers without pred_weight_table(), which is unsupported, are a few
+// dozen bytes even with reference list modifications.
+const size_t kMaxSliceHeaderSize = 256;
 }
 
 namespace webrtc {
@@ -45,8 +48,22 @@ H264BitstreamParser::Result H264BitstreamParser::ParseNonParameterSetNalu(
     return kInvalidStream;
 
   last_slice_qp_delta_ = rtc::Optional<int32_t>();
-  const std::vector<uint8_t> slice_rbsp =
-      H264::ParseRbsp(source, source_length);
+  // Only the slice header is parsed, so there is no need to unescape the
+  // slice data that follows it. Should the header not fit in the first
+  // |kMaxSliceHeaderSize| bytes, parse again with the whole slice.
+  if (source_length > kMaxSliceHeaderSize) {
+    const std::vector<uint8_t> header_rbsp =
+        H264::ParseRbsp(source, kMaxSliceHeaderSize);
+    Result result = ParseSliceHeader(header_rbsp, nalu_type);
+    if (result != kInvalidStream)
+      return result;
+  }
+  return ParseSliceHeader(H264::ParseRbsp(source, source_length), nalu_type);
+}
+
+H264BitstreamParser::Result H264BitstreamParser::ParseSliceHeader(
+    const std::vector<uint8_t>& slice_rbsp,
+    uint8_t nalu_type) {
   if (slice_rbsp.size() < H264::kNaluTypeSize)
     return kInvalidStream;
 
@@ -54,8 +71,8 @@ H264BitstreamParser::Result H264BitstreamParser::ParseNonParameterSetNalu(
                               slice_rbsp.size() - H264::kNaluTypeSize);
   // Check to see if this is an IDR slice, which has an extra field to parse
   // out.
-  bool is_idr = (source[0] & 0x0F) == H264::NaluType::kIdr;
-  uint8_t nal_ref_idc = (source[0] & 0x60) >> 5;
+  bool is_idr = (slice_rbsp[0] & 0x0F) == H264::NaluType::kIdr;
+  uint8_t nal_ref_idc = (slice_rbsp[0] & 0x60) >> 5;
   uint32_t golomb_tmp;
   uint32_t bits_tmp;
 
@@ -13,6 +13,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <vector>
+
 #include "webrtc/api/optional.h"
 #include "webrtc/common_video/h264/pps_parser.h"
 #include "webrtc/common_video/h264/sps_parser.h"
@@ -51,6 +53,10 @@ class H264BitstreamParser {
   Result ParseNonParameterSetNalu(const uint8_t* source,
                                   size_t source_length,
                                   uint8_t nalu_type);
+  // Parses the slice header at the start of |slice_rbsp|, a slice NAL unit
+  // with emulation prevention bytes removed, up to and including the slice QP.
+  Result ParseSliceHeader(const std::vector<uint8_t>& slice_rbsp,
+                          uint8_t nalu_type);
 
   // SPS/PPS state, updated when parsing new SPS/PPS, used to parse slices.
   rtc::Optional<SpsParser::SpsState> sps_;
@@ -10,42 +10,104 @@
 
 #include "webrtc/common_video/h264/h264_common.h"
 
+#include "webrtc/typedefs.h"
+#if defined(WEBRTC_ARCH_X86_FAMILY) && defined(__SSE2__)
+#include <emmintrin.h>
+#define WEBRTC_H264_SCAN_SSE2
+#elif defined(WEBRTC_HAS_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace webrtc {
 namespace H264 {
 
 const uint8_t kNaluTypeMask = 0x1F;
 
+namespace {
+
+const uint8_t kStartCodeByte = 0x01;
+const uint8_t kEmulationByte = 0x03;
+
+// Returns the offset of the first 00 00 |third_byte| sequence at or after
+// |offset| that lies entirely within the first |length| bytes of |data|, or
+// |length| if there is none.
+//
+// Zero bytes are rare in entropy coded slice data, so whole blocks of 16 bytes
+// are ruled out at a time where SIMD is available. The block containing a
+// match, and the tail of the data, are scanned a byte at a time.
+size_t FindZeroZeroSequence(const uint8_t* data,
+                            size_t length,
+                            size_t offset,
+                            uint8_t third_byte) {
+#if defined(WEBRTC_H264_SCAN_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i third = _mm_set1_epi8(static_cast<char>(third_byte));
+  for (; offset + 18 <= length; offset += 16) {
+    const __m128i b0 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+    const __m128i b1 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset + 1));
+    const __m128i b2 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset + 2));
+    const __m128i match =
+        _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, zero),
+                                    _mm_cmpeq_epi8(b1, zero)),
+                      _mm_cmpeq_epi8(b2, third));
+    if (_mm_movemask_epi8(match) != 0)
+      break;
+  }
+#elif defined(WEBRTC_HAS_NEON)
+  const uint8x16_t zero = vdupq_n_u8(0);
+  const uint8x16_t third = vdupq_n_u8(third_byte);
+  for (; offset + 18 <= length; offset += 16) {
+    const uint8x16_t match =
+        vandq_u8(vandq_u8(vceqq_u8(vld1q_u8(data + offset), zero),
+                          vceqq_u8(vld1q_u8(data + offset + 1), zero)),
+                 vceqq_u8(vld1q_u8(data + offset + 2), third));
+    const uint64x2_t match64 = vreinterpretq_u64_u8(match);
+    if ((vgetq_lane_u64(match64, 0) | vgetq_lane_u64(match64, 1)) != 0)
+      break;
+  }
+#endif
+  // Given the 3-byte sequence at |offset|, if its last byte is neither 0 nor
+  // |third_byte|, no sequence can start at any of the three offsets.
+  while (offset + 2 < length) {
+    const uint8_t byte = data[offset + 2];
+    if (byte != 0 && byte != third_byte) {
+      offset += 3;
+    } else if (byte == third_byte && data[offset + 1] == 0 &&
+               data[offset] == 0) {
+      return offset;
+    } else {
+      ++offset;
+    }
+  }
+  return length;
+}
+
+}  // namespace
+
 std::vector<NaluIndex> FindNaluIndices(const uint8_t* buffer,
                                        size_t buffer_size) {
-  // This is sorta like Boyer-Moore, but with only the first optimization step:
-  // given a 3-byte sequence we're looking at, if the 3rd byte isn't 1 or 0,
-  // skip ahead to the next 3-byte sequence. 0s and 1s are relatively rare, so
-  // this will skip the majority of reads/checks.
   std::vector<NaluIndex> sequences;
   if (buffer_size < kNaluShortStartSequenceSize)
     return sequences;
 
-  const size_t end = buffer_size - kNaluShortStartSequenceSize;
-  for (size_t i = 0; i < end;) {
-    if (buffer[i + 2] > 1) {
-      i += 3;
-    } else if (buffer[i + 2] == 1 && buffer[i + 1] == 0 && buffer[i] == 0) {
-      // We found a start sequence, now check if it was a 3 of 4 byte one.
-      NaluIndex index = {i, i + 3, 0};
-      if (index.start_offset > 0 && buffer[index.start_offset - 1] == 0)
-        --index.start_offset;
-
-      // Update length of previous entry.
-      auto it = sequences.rbegin();
-      if (it != sequences.rend())
-        it->payload_size = index.start_offset - it->payload_start_offset;
-
-      sequences.push_back(index);
-
-      i += 3;
-    } else {
-      ++i;
-    }
+  // A start sequence must be followed by at least one byte of payload.
+  const size_t end = buffer_size - 1;
+  for (size_t i = FindZeroZeroSequence(buffer, end, 0, kStartCodeByte);
+       i < end; i = FindZeroZeroSequence(buffer, end, i + 3, kStartCodeByte)) {
+    // We found a start sequence, now check if it was a 3 of 4 byte one.
+    NaluIndex index = {i, i + 3, 0};
+    if (index.start_offset > 0 && buffer[index.start_offset - 1] == 0)
+      --index.start_offset;
+
+    // Update length of previous entry.
+    auto it = sequences.rbegin();
+    if (it != sequences.rend())
+      it->payload_size = index.start_offset - it->payload_start_offset;
+
+    sequences.push_back(index);
   }
 
   // Update length of last entry, if any.
@@ -65,27 +127,20 @@ std::vector<uint8_t> ParseRbsp(const uint8_t* data, size_t length) {
   out.reserve(length);
 
   for (size_t i = 0; i < length;) {
-    // Be careful about over/underflow here. byte_length_ - 3 can underflow, and
-    // i + 3 can overflow, but byte_length_ - i can't, because i < byte_length_
-    // above, and that expression will produce the number of bytes left in
-    // the stream including the byte at i.
-    if (length - i >= 3 && !data[i] && !data[i + 1] && data[i + 2] == 3) {
-      // Two rbsp bytes.
-      out.push_back(data[i++]);
-      out.push_back(data[i++]);
-      // Skip the emulation byte.
-      i++;
-    } else {
-      // Single rbsp byte.
-      out.push_back(data[i++]);
+    size_t escape = FindZeroZeroSequence(data, length, i, kEmulationByte);
+    if (escape == length) {
+      out.insert(out.end(), data + i, data + length);
+      break;
     }
+    // Copy up to and including the two zero bytes, skip the emulation byte.
+    out.insert(out.end(), data + i, data + escape + 2);
+    i = escape + 3;
   }
   return out;
 }
 
 void WriteRbsp(const uint8_t* bytes, size_t length, rtc::Buffer* destination) {
   static const uint8_t kZerosInStartSequence = 2;
-  static const uint8_t kEmulationByte = 0x03u;
   size_t num_consecutive_zeros = 0;
   destination->EnsureCapacity(destination->size() + length);
 
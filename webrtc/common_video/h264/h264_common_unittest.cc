@@ -0,0 +1,261 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/common_video/h264/h264_common.h"
+
+#include <vector>
+
+#include "webrtc/common_video/h264/h264_bitstream_parser.h"
+#include "webrtc/rtc_base/bitbuffer.h"
+#include "webrtc/rtc_base/buffer.h"
+#include "webrtc/rtc_base/random.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace H264 {
+namespace {
+
+// SPS, PPS and the start of an IDR slice with QP 35, from
+// h264_bitstream_parser_unittest.cc.
+const uint8_t kSpsPpsAndIdrSliceHeader[] = {
+    0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x80, 0x20, 0xda, 0x01, 0x40, 0x16,
+    0xe8, 0x06, 0xd0, 0xa1, 0x35, 0x00, 0x00, 0x00, 0x01, 0x68, 0xce, 0x06,
+    0xe2, 0x00, 0x00, 0x00, 0x01, 0x65, 0xb8, 0x40, 0xf0, 0x8c, 0x03, 0xf2,
+    0x75, 0x67, 0xad, 0x41, 0x64, 0x24, 0x0e, 0xa0, 0xb2, 0x12, 0x1e, 0xf8,
+};
+
+// Byte-by-byte implementations to compare against.
+std::vector<size_t> FindStartSequencesReference(const uint8_t* buffer,
+                                                size_t buffer_size) {
+  std::vector<size_t> offsets;
+  for (size_t i = 0; i + kNaluShortStartSequenceSize < buffer_size; ++i) {
+    if (buffer[i] == 0 && buffer[i + 1] == 0 && buffer[i + 2] == 1)
+      offsets.push_back(i + kNaluShortStartSequenceSize);
+  }
+  return offsets;
+}
+
+std::vector<uint8_t> ParseRbspReference(const uint8_t* data, size_t length) {
+  std::vector<uint8_t> out;
+  for (size_t i = 0; i < length;) {
+    if (length - i >= 3 && !data[i] && !data[i + 1] && data[i + 2] == 3) {
+      out.push_back(data[i++]);
+      out.push_back(data[i++]);
+      i++;
+    } else {
+      out.push_back(data[i++]);
+    }
+  }
+  return out;
+}
+
+// Random bytes where roughly one in |zero_period| bytes is 0 and small values
+// are common, so that start and escape sequences show up at every alignment.
+std::vector<uint8_t> CreateRandomData(Random* random,
+                                      size_t length,
+                                      int zero_period) {
+  std::vector<uint8_t> data(length);
+  for (uint8_t& byte : data) {
+    if (random->Rand(zero_period - 1) == 0) {
+      byte = 0;
+    } else {
+      byte = static_cast<uint8_t>(random->Rand(0, 4));
+      if (random->Rand<bool>())
+        byte = static_cast<uint8_t>(random->Rand(0, 255));
+    }
+  }
+  return data;
+}
+
+// A 1080p sized IDR access unit, with eight slices of escaped random data.
+rtc::Buffer CreateAccessUnit(Random* random) {
+  const size_t kSliceSize = 25000;
+  const size_t kNumSlices = 8;
+  const size_t kSliceHeaderOffset = 25;
+  rtc::Buffer access_unit(kSpsPpsAndIdrSliceHeader, kSliceHeaderOffset);
+  for (size_t i = 0; i < kNumSlices; ++i) {
+    access_unit.AppendData(
+        kSpsPpsAndIdrSliceHeader + kSliceHeaderOffset,
+        sizeof(kSpsPpsAndIdrSliceHeader) - kSliceHeaderOffset);
+    std::vector<uint8_t> slice_data = CreateRandomData(random, kSliceSize, 100);
+    WriteRbsp(slice_data.data(), slice_data.size(), &access_unit);
+  }
+  return access_unit;
+}
+
+// The SPS and PPS of |kSpsPpsAndIdrSliceHeader| followed by a P slice with
+// |num_modifications| reference picture list modifications, which make its
+// header about four bytes per modification long. The PPS sets the initial QP
+// to 20.
+rtc::Buffer CreatePSliceWithModifications(size_t num_modifications,
+                                          int32_t slice_qp_delta) {
+  const size_t kSliceHeaderOffset = 25;
+  rtc::Buffer access_unit(kSpsPpsAndIdrSliceHeader, kSliceHeaderOffset);
+  const uint8_t kStartSequence[] = {0x00, 0x00, 0x00, 0x01};
+  access_unit.AppendData(kStartSequence);
+
+  std::vector<uint8_t> slice(16 + 4 * num_modifications, 0xaa);
+  rtc::BitBufferWriter writer(slice.data(), slice.size());
+  // nal_ref_idc 2, nal_unit_type kSlice.
+  writer.WriteUInt8(0x40 | kSlice);
+  writer.WriteExponentialGolomb(0);  // first_mb_in_slice
+  writer.WriteExponentialGolomb(0);  // slice_type: P
+  writer.WriteExponentialGolomb(0);  // pic_parameter_set_id
+  writer.WriteBits(1, 4);            // frame_num
+  writer.WriteBits(0, 1);            // num_ref_idx_active_override_flag
+  writer.WriteBits(1, 1);            // ref_pic_list_modification_flag_l0
+  for (size_t i = 0; i < num_modifications; ++i) {
+    writer.WriteExponentialGolomb(0);      // modification_of_pic_nums_idc
+    writer.WriteExponentialGolomb(50000);  // abs_diff_pic_num_minus1
+  }
+  writer.WriteExponentialGolomb(3);  // modification_of_pic_nums_idc: end
+  writer.WriteBits(0, 1);            // adaptive_ref_pic_marking_mode_flag
+  EXPECT_TRUE(writer.WriteSignedExponentialGolomb(slice_qp_delta));
+  WriteRbsp(slice.data(), slice.size(), &access_unit);
+  return access_unit;
+}
+
+}  // namespace
+
+TEST(H264CommonTest, FindNaluIndicesMatchesReference) {
+  Random random(0x1234);
+  for (size_t length = 0; length < 300; ++length) {
+    for (int zero_period : {2, 4, 50}) {
+      std::vector<uint8_t> data =
+          CreateRandomData(&random, length, zero_period);
+      std::vector<size_t> expected =
+          FindStartSequencesReference(data.data(), data.size());
+      std::vector<NaluIndex> indices =
+          FindNaluIndices(data.data(), data.size());
+      ASSERT_EQ(expected.size(), indices.size()) << "length " << length;
+      for (size_t i = 0; i < indices.size(); ++i) {
+        EXPECT_EQ(expected[i], indices[i].payload_start_offset);
+        size_t end = i + 1 < indices.size() ? indices[i + 1].start_offset
+                                            : data.size();
+        EXPECT_EQ(end,
+                  indices[i].payload_start_offset + indices[i].payload_size);
+      }
+    }
+  }
+}
+
+TEST(H264CommonTest, FindNaluIndicesLongAndShortStartSequences) {
+  const uint8_t kBuffer[] = {0x00, 0x00, 0x00, 0x01, 0x67, 0xaa,
+                             0x00, 0x00, 0x01, 0x68, 0x00, 0x00,
+                             0x00, 0x01, 0x65, 0xbb, 0xcc, 0x00,
+                             0x00, 0x01};
+  std::vector<NaluIndex> indices = FindNaluIndices(kBuffer, sizeof(kBuffer));
+  ASSERT_EQ(3u, indices.size());
+  EXPECT_EQ(0u, indices[0].start_offset);
+  EXPECT_EQ(4u, indices[0].payload_start_offset);
+  EXPECT_EQ(2u, indices[0].payload_size);
+  EXPECT_EQ(6u, indices[1].start_offset);
+  EXPECT_EQ(9u, indices[1].payload_start_offset);
+  EXPECT_EQ(1u, indices[1].payload_size);
+  EXPECT_EQ(10u, indices[2].start_offset);
+  EXPECT_EQ(14u, indices[2].payload_start_offset);
+  // The trailing start sequence has no payload and is not a NALU.
+  EXPECT_EQ(6u, indices[2].payload_size);
+}
+
+TEST(H264CommonTest, ParseRbspMatchesReference) {
+  Random random(0x5678);
+  for (size_t length = 0; length < 300; ++length) {
+    for (int zero_period : {2, 4, 50}) {
+      std::vector<uint8_t> data =
+          CreateRandomData(&random, length, zero_period);
+      EXPECT_EQ(ParseRbspReference(data.data(), data.size()),
+                ParseRbsp(data.data(), data.size()))
+          << "length " << length;
+    }
+  }
+}
+
+TEST(H264CommonTest, ParseRbspUndoesWriteRbsp) {
+  Random random(0x9abc);
+  std::vector<uint8_t> data = CreateRandomData(&random, 10000, 3);
+  rtc::Buffer escaped;
+  WriteRbsp(data.data(), data.size(), &escaped);
+  EXPECT_GT(escaped.size(), data.size());
+  EXPECT_EQ(data, ParseRbsp(escaped.data(), escaped.size()));
+}
+
+TEST(H264CommonTest, ParsesQpOfLongSlices) {
+  Random random(0xdef0);
+  rtc::Buffer access_unit = CreateAccessUnit(&random);
+  H264BitstreamParser parser;
+  parser.ParseBitstream(access_unit.data(), access_unit.size());
+  int qp;
+  ASSERT_TRUE(parser.GetLastSliceQp(&qp));
+  EXPECT_EQ(35, qp);
+}
+
+TEST(H264CommonTest, ParsesQpOfSlicesWithLongHeaders) {
+  // 50 modifications make a header of ~200 bytes, which is parsed from the
+  // prefix of the slice. 100 make it ~400 bytes, and the parser has to fall
+  // back to parsing the whole slice.
+  for (size_t num_modifications : {50, 100}) {
+    rtc::Buffer access_unit =
+        CreatePSliceWithModifications(num_modifications, 10);
+    H264BitstreamParser parser;
+    parser.ParseBitstream(access_unit.data(), access_unit.size());
+    int qp;
+    ASSERT_TRUE(parser.GetLastSliceQp(&qp))
+        << num_modifications << " modifications";
+    EXPECT_EQ(30, qp) << num_modifications << " modifications";
+  }
+}
+
+// Disabled since it only reports timings; run it with
+// --gtest_also_run_disabled_tests.
+TEST(H264CommonTest, DISABLED_ParseAccessUnitPerformance) {
+  const int kNumIterations = 500;
+  Random random(0x4321);
+  rtc::Buffer access_unit = CreateAccessUnit(&random);
+
+  size_t num_nalus = 0;
+  int64_t start_time_us = rtc::TimeMicros();
+  for (int i = 0; i < kNumIterations; ++i) {
+    num_nalus +=
+        FindNaluIndices(access_unit.data(), access_unit.size()).size();
+  }
+  const int64_t find_time_us = rtc::TimeMicros() - start_time_us;
+  EXPECT_EQ(10u * kNumIterations, num_nalus);
+
+  size_t rbsp_size = 0;
+  start_time_us = rtc::TimeMicros();
+  for (int i = 0; i < kNumIterations; ++i)
+    rbsp_size += ParseRbsp(access_unit.data(), access_unit.size()).size();
+  const int64_t rbsp_time_us = rtc::TimeMicros() - start_time_us;
+  EXPECT_LE(rbsp_size, access_unit.size() * kNumIterations);
+
+  H264BitstreamParser parser;
+  start_time_us = rtc::TimeMicros();
+  for (int i = 0; i < kNumIterations; ++i)
+    parser.ParseBitstream(access_unit.data(), access_unit.size());
+  const int64_t qp_time_us = rtc::TimeMicros() - start_time_us;
+  int qp;
+  EXPECT_TRUE(parser.GetLastSliceQp(&qp));
+
+  test::PrintResult("h264_find_nalu_indices", "", "1080p_idr",
+                    static_cast<size_t>(find_time_us / kNumIterations), "us",
+                    true);
+  test::PrintResult("h264_parse_rbsp", "", "1080p_idr",
+                    static_cast<size_t>(rbsp_time_us / kNumIterations), "us",
+                    true);
+  test::PrintResult("h264_parse_slice_qp", "", "1080p_idr",
+                    static_cast<size_t>(qp_time_us / kNumIterations), "us",
+                    true);
+}
+
+}  // namespace H264
+}  // namespace webrtc
@@ -19,6 +19,14 @@
 
 namespace webrtc {
 
+// The number of decoded frames from one decoder that the application may hold
+// on to at once, the same for all software decoders. The VP8, VP9 and H264
+// decoders size their pools as this plus the frames that the decoder itself
+// keeps as references in the pool. Decoded frames should not be referenced for
+// longer than necessary; this gives the application ~1 second to e.g. render
+// each frame of a 60 fps video.
+const size_t kMaxPendingDecodedFrames = 60;
+
 // Simple buffer pool to avoid unnecessary allocations of I420Buffer objects.
 // The pool manages the memory of the I420Buffer returned from CreateBuffer.
 // When the I420Buffer is destructed, the memory is returned to the pool for use
@@ -0,0 +1,48 @@
+/*
+ *  Copyright 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_COMMON_VIDEO_INCLUDE_UPDATE_RECT_ACCUMULATOR_H_
+#define WEBRTC_COMMON_VIDEO_INCLUDE_UPDATE_RECT_ACCUMULATOR_H_
+
+#include <vector>
+
+#include "webrtc/api/optional.h"
+#include "webrtc/api/video/video_frame.h"
+
+namespace webrtc {
+
+// Collects the update rects of frames that are dropped on their way to the
+// encoder, so that the next frame that is encoded describes everything that
+// changed since the previous encoded frame.
+class UpdateRectAccumulator {
+ public:
+  // The number of rects kept before they are replaced by their bounding box.
+  static const size_t kMaxRects;
+
+  UpdateRectAccumulator();
+  ~UpdateRectAccumulator();
+
+  // Adds the update rects of a frame that will not be encoded.
+  void AddDroppedFrame(const VideoFrame& frame);
+  void Add(const rtc::Optional<std::vector<VideoFrame::UpdateRect>>& rects);
+
+  // Returns the rects added since the last call merged with those of |frame|,
+  // which is about to be encoded, and starts over.
+  rtc::Optional<std::vector<VideoFrame::UpdateRect>> TakeForFrame(
+      const VideoFrame& frame);
+
+ private:
+  // Unset once a frame with unknown update rects has been added.
+  rtc::Optional<std::vector<VideoFrame::UpdateRect>> rects_;
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_COMMON_VIDEO_INCLUDE_UPDATE_RECT_ACCUMULATOR_H_
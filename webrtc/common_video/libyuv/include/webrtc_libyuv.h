@@ -116,6 +116,19 @@ double I420SSIM(const VideoFrame* ref_frame, const VideoFrame* test_frame);
 double I420SSIM(const I420BufferInterface& ref_buffer,
                 const I420BufferInterface& test_buffer);
 
+// Compute SSIM for an I420 image given by its planes. Gives the same result as
+// libyuv::I420Ssim, which is used by the functions above, but sums each 4x4
+// block once instead of once for every 8x8 window that covers it, and sums the
+// blocks with SSE2 where available. Chroma planes are (width + 1) / 2 by
+// (height + 1) / 2.
+double I420SSIM(const uint8_t* ref_y, int ref_stride_y,
+                const uint8_t* ref_u, int ref_stride_u,
+                const uint8_t* ref_v, int ref_stride_v,
+                const uint8_t* test_y, int test_stride_y,
+                const uint8_t* test_u, int test_stride_u,
+                const uint8_t* test_v, int test_stride_v,
+                int width, int height);
+
 // Helper function for scaling NV12 to NV12.
 // If the |src_width| and |src_height| matches the |dst_width| and |dst_height|,
 // then |tmp_buffer| is not used. In other cases, the minimum size of
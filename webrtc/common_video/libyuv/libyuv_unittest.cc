@@ -16,10 +16,12 @@
 #include "webrtc/api/video/i420_buffer.h"
 #include "webrtc/api/video/video_frame.h"
 #include "webrtc/common_video/libyuv/include/webrtc_libyuv.h"
+#include "webrtc/rtc_base/random.h"
 #include "webrtc/test/frame_utils.h"
 #include "webrtc/test/gmock.h"
 #include "webrtc/test/gtest.h"
 #include "webrtc/test/testsupport/fileutils.h"
+#include "libyuv/compare.h"
 
 namespace webrtc {
 
@@ -325,4 +327,47 @@ TEST_F(TestLibYuv, NV12Scale4x4to2x2) {
               ::testing::ElementsAre(Average(0, 2, 4, 6), Average(1, 3, 5, 7)));
 }
 
+TEST_F(TestLibYuv, I420SSIMMatchesLibyuv) {
+  Random random(0x5517);
+  // Sizes with partial windows at the edges, odd chroma sizes and chroma
+  // planes with a single window.
+  const std::pair<int, int> kSizes[] = {{352, 288}, {176, 144}, {33, 34},
+                                        {34, 33},   {36, 20},   {18, 18},
+                                        {20, 200},  {200, 20},  {101, 99}};
+  for (const auto& size : kSizes) {
+    const int width = size.first;
+    const int height = size.second;
+    rtc::scoped_refptr<I420Buffer> ref = I420Buffer::Create(width, height);
+    rtc::scoped_refptr<I420Buffer> test = I420Buffer::Create(width, height);
+    uint8_t* const ref_planes[] = {ref->MutableDataY(), ref->MutableDataU(),
+                                   ref->MutableDataV()};
+    uint8_t* const test_planes[] = {test->MutableDataY(), test->MutableDataU(),
+                                    test->MutableDataV()};
+    const size_t plane_sizes[] = {
+        static_cast<size_t>(ref->StrideY() * height),
+        static_cast<size_t>(ref->StrideU() * ref->ChromaHeight()),
+        static_cast<size_t>(ref->StrideV() * ref->ChromaHeight())};
+    for (int plane = 0; plane < 3; ++plane) {
+      for (size_t i = 0; i < plane_sizes[plane]; ++i) {
+        // A smooth gradient, and noise with a range that varies from frame
+        // to frame.
+        const int value = static_cast<int>(i % 251) +
+                          random.Rand(-width % 64, width % 64);
+        ref_planes[plane][i] = static_cast<uint8_t>(value);
+        test_planes[plane][i] =
+            static_cast<uint8_t>(value + random.Rand(-20, 20));
+      }
+    }
+
+    const double expected = libyuv::I420Ssim(
+        ref->DataY(), ref->StrideY(), ref->DataU(), ref->StrideU(),
+        ref->DataV(), ref->StrideV(), test->DataY(), test->StrideY(),
+        test->DataU(), test->StrideU(), test->DataV(), test->StrideV(),
+        width, height);
+    // Bit-exact.
+    EXPECT_EQ(expected, I420SSIM(*ref, *test)) << width << "x" << height;
+    EXPECT_DOUBLE_EQ(1.0, I420SSIM(*ref, *ref)) << width << "x" << height;
+  }
+}
+
 }  // namespace webrtc
@@ -10,9 +10,18 @@
 
 #include "webrtc/common_video/libyuv/include/webrtc_libyuv.h"
 
+#include <float.h>
 #include <string.h>
 
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+#include <emmintrin.h>
+#endif
+
+#include <utility>
+#include <vector>
+
 #include "webrtc/rtc_base/checks.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
 // TODO(nisse): Only needed for the deprecated ConvertToI420.
 #include "webrtc/api/video/i420_buffer.h"
 
@@ -21,6 +30,188 @@
 
 namespace webrtc {
 
+namespace {
+
+// Sums over a 4x4 block of pixels of the two images. SSIM is computed for 8x8
+// windows every 4 pixels, so each window is made of 2x2 blocks.
+struct SsimBlockSums {
+  int32_t sum_a;
+  int32_t sum_b;
+  int32_t sum_sq_a;
+  int32_t sum_sq_b;
+  int32_t sum_axb;
+};
+
+using SsimBlockRowFunction = void (*)(const uint8_t* src_a,
+                                      int stride_a,
+                                      const uint8_t* src_b,
+                                      int stride_b,
+                                      int num_blocks,
+                                      SsimBlockSums* sums);
+
+// Sums the |num_blocks| blocks in the 4 rows starting at |src_a| and |src_b|.
+void SsimBlockRow_C(const uint8_t* src_a,
+                    int stride_a,
+                    const uint8_t* src_b,
+                    int stride_b,
+                    int num_blocks,
+                    SsimBlockSums* sums) {
+  for (int k = 0; k < num_blocks; ++k) {
+    SsimBlockSums block = {0, 0, 0, 0, 0};
+    for (int i = 0; i < 4; ++i) {
+      const uint8_t* a = src_a + i * stride_a + 4 * k;
+      const uint8_t* b = src_b + i * stride_b + 4 * k;
+      for (int j = 0; j < 4; ++j) {
+        block.sum_a += a[j];
+        block.sum_b += b[j];
+        block.sum_sq_a += a[j] * a[j];
+        block.sum_sq_b += b[j] * b[j];
+        block.sum_axb += a[j] * b[j];
+      }
+    }
+    sums[k] = block;
+  }
+}
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+// Adds the two pairs of 32-bit lanes of |v|, i.e. returns the sums of the
+// left and the right block.
+std::pair<int32_t, int32_t> SumLanePairs(__m128i v) {
+  v = _mm_add_epi32(v, _mm_srli_epi64(v, 32));
+  return std::make_pair(_mm_cvtsi128_si32(v),
+                        _mm_cvtsi128_si32(_mm_srli_si128(v, 8)));
+}
+
+// Sums two blocks, i.e. 8 pixels of each row, at a time.
+void SsimBlockRow_SSE2(const uint8_t* src_a,
+                       int stride_a,
+                       const uint8_t* src_b,
+                       int stride_b,
+                       int num_blocks,
+                       SsimBlockSums* sums) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi16(1);
+  int k = 0;
+  for (; k + 2 <= num_blocks; k += 2) {
+    // Sums of the pixels fit in 16 bits, the other sums don't.
+    __m128i sum_a = zero;
+    __m128i sum_b = zero;
+    __m128i sum_sq_a = zero;
+    __m128i sum_sq_b = zero;
+    __m128i sum_axb = zero;
+    for (int i = 0; i < 4; ++i) {
+      const __m128i a = _mm_unpacklo_epi8(
+          _mm_loadl_epi64(
+              reinterpret_cast<const __m128i*>(src_a + i * stride_a + 4 * k)),
+          zero);
+      const __m128i b = _mm_unpacklo_epi8(
+          _mm_loadl_epi64(
+              reinterpret_cast<const __m128i*>(src_b + i * stride_b + 4 * k)),
+          zero);
+      sum_a = _mm_add_epi16(sum_a, a);
+      sum_b = _mm_add_epi16(sum_b, b);
+      sum_sq_a = _mm_add_epi32(sum_sq_a, _mm_madd_epi16(a, a));
+      sum_sq_b = _mm_add_epi32(sum_sq_b, _mm_madd_epi16(b, b));
+      sum_axb = _mm_add_epi32(sum_axb, _mm_madd_epi16(a, b));
+    }
+    const std::pair<int32_t, int32_t> a =
+        SumLanePairs(_mm_madd_epi16(sum_a, ones));
+    const std::pair<int32_t, int32_t> b =
+        SumLanePairs(_mm_madd_epi16(sum_b, ones));
+    const std::pair<int32_t, int32_t> sq_a = SumLanePairs(sum_sq_a);
+    const std::pair<int32_t, int32_t> sq_b = SumLanePairs(sum_sq_b);
+    const std::pair<int32_t, int32_t> axb = SumLanePairs(sum_axb);
+    sums[k] = {a.first, b.first, sq_a.first, sq_b.first, axb.first};
+    sums[k + 1] = {a.second, b.second, sq_a.second, sq_b.second, axb.second};
+  }
+  if (k < num_blocks) {
+    SsimBlockRow_C(src_a + 4 * k, stride_a, src_b + 4 * k, stride_b,
+                   num_blocks - k, sums + k);
+  }
+}
+#endif
+
+SsimBlockRowFunction GetSsimBlockRowFunction() {
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kSSE2))
+    return &SsimBlockRow_SSE2;
+#endif
+  return &SsimBlockRow_C;
+}
+
+// SSIM of an 8x8 window, as computed by libyuv's Ssim8x8_C.
+double SsimWindow(const SsimBlockSums& top_left,
+                  const SsimBlockSums& top_right,
+                  const SsimBlockSums& bottom_left,
+                  const SsimBlockSums& bottom_right) {
+  const int64_t sum_a = top_left.sum_a + top_right.sum_a + bottom_left.sum_a +
+                        bottom_right.sum_a;
+  const int64_t sum_b = top_left.sum_b + top_right.sum_b + bottom_left.sum_b +
+                        bottom_right.sum_b;
+  const int64_t sum_sq_a = top_left.sum_sq_a + top_right.sum_sq_a +
+                           bottom_left.sum_sq_a + bottom_right.sum_sq_a;
+  const int64_t sum_sq_b = top_left.sum_sq_b + top_right.sum_sq_b +
+                           bottom_left.sum_sq_b + bottom_right.sum_sq_b;
+  const int64_t sum_axb = top_left.sum_axb + top_right.sum_axb +
+                          bottom_left.sum_axb + bottom_right.sum_axb;
+
+  // 64^2 * (0.01 * 255)^2 and 64^2 * (0.03 * 255)^2, scaled by the number of
+  // pixels.
+  const int64_t kCount = 64;
+  const int64_t kC1 = (26634 * kCount * kCount) >> 12;
+  const int64_t kC2 = (239708 * kCount * kCount) >> 12;
+  const int64_t sum_a_x_sum_b = sum_a * sum_b;
+  const int64_t ssim_n =
+      (2 * sum_a_x_sum_b + kC1) *
+      (2 * kCount * sum_axb - 2 * sum_a_x_sum_b + kC2);
+  const int64_t sum_a_sq = sum_a * sum_a;
+  const int64_t sum_b_sq = sum_b * sum_b;
+  const int64_t ssim_d = (sum_a_sq + sum_b_sq + kC1) *
+                         (kCount * sum_sq_a - sum_a_sq + kCount * sum_sq_b -
+                          sum_b_sq + kC2);
+  if (ssim_d == 0)
+    return DBL_MAX;
+  return ssim_n * 1.0 / ssim_d;
+}
+
+// Mean SSIM of the 8x8 windows every 4 pixels, like libyuv's CalcFrameSsim.
+// The windows are added up in the same order, so the result is the same.
+double PlaneSsim(SsimBlockRowFunction block_row,
+                 const uint8_t* src_a,
+                 int stride_a,
+                 const uint8_t* src_b,
+                 int stride_b,
+                 int width,
+                 int height) {
+  // Windows start at every multiple of 4 below width - 8 and height - 8.
+  const int num_window_columns = width > 8 ? (width - 5) / 4 : 0;
+  const int num_window_rows = height > 8 ? (height - 5) / 4 : 0;
+  int samples = 0;
+  double ssim_total = 0;
+  if (num_window_columns > 0) {
+    const int num_blocks = num_window_columns + 1;
+    std::vector<SsimBlockSums> top(num_blocks);
+    std::vector<SsimBlockSums> bottom(num_blocks);
+    if (num_window_rows > 0)
+      block_row(src_a, stride_a, src_b, stride_b, num_blocks, top.data());
+    for (int i = 0; i < num_window_rows; ++i) {
+      src_a += 4 * stride_a;
+      src_b += 4 * stride_b;
+      block_row(src_a, stride_a, src_b, stride_b, num_blocks, bottom.data());
+      for (int j = 0; j < num_window_columns; ++j) {
+        ssim_total +=
+            SsimWindow(top[j], top[j + 1], bottom[j], bottom[j + 1]);
+        ++samples;
+      }
+      top.swap(bottom);
+    }
+  }
+  ssim_total /= samples;
+  return ssim_total;
+}
+
+}  // namespace
+
 size_t CalcBufferSize(VideoType type, int width, int height) {
   RTC_DCHECK_GE(width, 0);
   RTC_DCHECK_GE(height, 0);
@@ -293,13 +484,33 @@ double I420SSIM(const I420BufferInterface& ref_buffer,
     scaled_buffer->ScaleFrom(test_buffer);
     return I420SSIM(ref_buffer, *scaled_buffer);
   }
-  return libyuv::I420Ssim(
+  return I420SSIM(
       ref_buffer.DataY(), ref_buffer.StrideY(), ref_buffer.DataU(),
       ref_buffer.StrideU(), ref_buffer.DataV(), ref_buffer.StrideV(),
       test_buffer.DataY(), test_buffer.StrideY(), test_buffer.DataU(),
       test_buffer.StrideU(), test_buffer.DataV(), test_buffer.StrideV(),
       test_buffer.width(), test_buffer.height());
 }
+
+double I420SSIM(const uint8_t* ref_y, int ref_stride_y,
+                const uint8_t* ref_u, int ref_stride_u,
+                const uint8_t* ref_v, int ref_stride_v,
+                const uint8_t* test_y, int test_stride_y,
+                const uint8_t* test_u, int test_stride_u,
+                const uint8_t* test_v, int test_stride_v,
+                int width, int height) {
+  static const SsimBlockRowFunction block_row = GetSsimBlockRowFunction();
+  const int chroma_width = (width + 1) / 2;
+  const int chroma_height = (height + 1) / 2;
+  const double ssim_y = PlaneSsim(block_row, ref_y, ref_stride_y, test_y,
+                                  test_stride_y, width, height);
+  const double ssim_u = PlaneSsim(block_row, ref_u, ref_stride_u, test_u,
+                                  test_stride_u, chroma_width, chroma_height);
+  const double ssim_v = PlaneSsim(block_row, ref_v, ref_stride_v, test_v,
+                                  test_stride_v, chroma_width, chroma_height);
+  // Same weights as libyuv.
+  return ssim_y * 0.8 + 0.1 * (ssim_u + ssim_v);
+}
 double I420SSIM(const VideoFrame* ref_frame, const VideoFrame* test_frame) {
   if (!ref_frame || !test_frame)
     return -1;
@@ -0,0 +1,69 @@
+/*
+ *  Copyright 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/common_video/include/update_rect_accumulator.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace webrtc {
+
+const size_t UpdateRectAccumulator::kMaxRects = 32;
+
+UpdateRectAccumulator::UpdateRectAccumulator()
+    : rects_(std::vector<VideoFrame::UpdateRect>()) {}
+
+UpdateRectAccumulator::~UpdateRectAccumulator() = default;
+
+void UpdateRectAccumulator::AddDroppedFrame(const VideoFrame& frame) {
+  Add(frame.update_rects());
+}
+
+void UpdateRectAccumulator::Add(
+    const rtc::Optional<std::vector<VideoFrame::UpdateRect>>& rects) {
+  if (!rects_)
+    return;
+  if (!rects) {
+    rects_.reset();
+    return;
+  }
+  for (const VideoFrame::UpdateRect& rect : *rects) {
+    if (rect.width > 0 && rect.height > 0)
+      rects_->push_back(rect);
+  }
+  if (rects_->size() <= kMaxRects)
+    return;
+
+  // Many small rects are typically close together, e.g. the glyphs of text
+  // being typed, so their bounding box does not cost much extra area.
+  int left = rects_->front().offset_x;
+  int top = rects_->front().offset_y;
+  int right = left + rects_->front().width;
+  int bottom = top + rects_->front().height;
+  for (const VideoFrame::UpdateRect& rect : *rects_) {
+    left = std::min(left, rect.offset_x);
+    top = std::min(top, rect.offset_y);
+    right = std::max(right, rect.offset_x + rect.width);
+    bottom = std::max(bottom, rect.offset_y + rect.height);
+  }
+  rects_->assign(1, {left, top, right - left, bottom - top});
+}
+
+rtc::Optional<std::vector<VideoFrame::UpdateRect>>
+UpdateRectAccumulator::TakeForFrame(const VideoFrame& frame) {
+  Add(frame.update_rects());
+  rtc::Optional<std::vector<VideoFrame::UpdateRect>> rects =
+      std::move(rects_);
+  rects_ = rtc::Optional<std::vector<VideoFrame::UpdateRect>>(
+      std::vector<VideoFrame::UpdateRect>());
+  return rects;
+}
+
+}  // namespace webrtc
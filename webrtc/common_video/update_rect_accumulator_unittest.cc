@@ -0,0 +1,89 @@
+/*
+ *  Copyright 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <vector>
+
+#include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/common_video/include/update_rect_accumulator.h"
+#include "webrtc/test/gtest.h"
+
+namespace webrtc {
+
+namespace {
+VideoFrame CreateFrame(
+    const rtc::Optional<std::vector<VideoFrame::UpdateRect>>& rects) {
+  VideoFrame frame(I420Buffer::Create(64, 64), kVideoRotation_0, 0);
+  frame.set_update_rects(rects);
+  return frame;
+}
+
+rtc::Optional<std::vector<VideoFrame::UpdateRect>> Rects(
+    const std::vector<VideoFrame::UpdateRect>& rects) {
+  return rtc::Optional<std::vector<VideoFrame::UpdateRect>>(rects);
+}
+}  // namespace
+
+TEST(UpdateRectAccumulatorTest, PassesThroughRectsWithoutDrops) {
+  UpdateRectAccumulator accumulator;
+  auto rects = accumulator.TakeForFrame(CreateFrame(Rects({{1, 2, 3, 4}})));
+  ASSERT_TRUE(rects);
+  ASSERT_EQ(1u, rects->size());
+  EXPECT_EQ(1, (*rects)[0].offset_x);
+  EXPECT_EQ(2, (*rects)[0].offset_y);
+  EXPECT_EQ(3, (*rects)[0].width);
+  EXPECT_EQ(4, (*rects)[0].height);
+
+  rects = accumulator.TakeForFrame(CreateFrame(Rects({})));
+  ASSERT_TRUE(rects);
+  EXPECT_TRUE(rects->empty());
+}
+
+TEST(UpdateRectAccumulatorTest, MergesRectsOfDroppedFrames) {
+  UpdateRectAccumulator accumulator;
+  accumulator.AddDroppedFrame(CreateFrame(Rects({{0, 0, 8, 8}})));
+  accumulator.AddDroppedFrame(CreateFrame(Rects({{16, 16, 8, 8}})));
+  auto rects = accumulator.TakeForFrame(CreateFrame(Rects({{32, 32, 8, 8}})));
+  ASSERT_TRUE(rects);
+  EXPECT_EQ(3u, rects->size());
+
+  // The dropped frames are accounted for only once.
+  rects = accumulator.TakeForFrame(CreateFrame(Rects({})));
+  ASSERT_TRUE(rects);
+  EXPECT_TRUE(rects->empty());
+}
+
+TEST(UpdateRectAccumulatorTest, UnknownRectsOfDroppedFrameAreUnknown) {
+  UpdateRectAccumulator accumulator;
+  accumulator.AddDroppedFrame(
+      CreateFrame(rtc::Optional<std::vector<VideoFrame::UpdateRect>>()));
+  EXPECT_FALSE(accumulator.TakeForFrame(CreateFrame(Rects({{0, 0, 8, 8}}))));
+  EXPECT_TRUE(accumulator.TakeForFrame(CreateFrame(Rects({{0, 0, 8, 8}}))));
+  EXPECT_FALSE(accumulator.TakeForFrame(
+      CreateFrame(rtc::Optional<std::vector<VideoFrame::UpdateRect>>())));
+}
+
+TEST(UpdateRectAccumulatorTest, ReplacesManyRectsWithBoundingBox) {
+  UpdateRectAccumulator accumulator;
+  for (size_t i = 0; i <= UpdateRectAccumulator::kMaxRects; ++i) {
+    const int offset = static_cast<int>(i);
+    accumulator.AddDroppedFrame(
+        CreateFrame(Rects({{offset, 10 + offset, 2, 2}})));
+  }
+  auto rects = accumulator.TakeForFrame(CreateFrame(Rects({})));
+  ASSERT_TRUE(rects);
+  ASSERT_EQ(1u, rects->size());
+  const int last = static_cast<int>(UpdateRectAccumulator::kMaxRects);
+  EXPECT_EQ(0, (*rects)[0].offset_x);
+  EXPECT_EQ(10, (*rects)[0].offset_y);
+  EXPECT_EQ(last + 2, (*rects)[0].width);
+  EXPECT_EQ(last + 2, (*rects)[0].height);
+}
+
+}  // namespace webrtc
@@ -14,10 +14,13 @@
 #include <deque>
 #include <functional>
 #include <limits>
+#include <map>
 #include <memory>
 #include <utility>
 #include <vector>
 
+#include "webrtc/logging/rtc_event_log/rtc_event_record.h"
+#include "webrtc/logging/rtc_event_log/rtc_event_ring_buffer.h"
 #include "webrtc/modules/audio_coding/audio_network_adaptor/include/audio_network_adaptor.h"
 #include "webrtc/modules/remote_bitrate_estimator/include/bwe_defines.h"
 #include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
@@ -55,6 +58,7 @@ RTC_PUSH_IGNORING_WUNDEF()
 #include "webrtc/logging/rtc_event_log/rtc_event_log.pb.h"
 #endif
 RTC_POP_IGNORING_WUNDEF()
+#include "webrtc/logging/rtc_event_log/rtp_packet_batch.h"
 #endif
 
 namespace webrtc {
@@ -64,6 +68,16 @@ namespace webrtc {
 namespace {
 const int kEventsInHistory = 10000;
 
+// Capacity of the lock-free buffer into which records are written by the
+// logging threads. Once it is a quarter full, a task is posted to move the
+// records to the history or the output file.
+const size_t kRecordBufferCapacity = 4096;
+const size_t kRecordDrainThreshold = kRecordBufferCapacity / 4;
+
+// While a log file is open, pending records are written to it at least this
+// often, even if the drain threshold is not reached.
+const uint32_t kRecordDrainIntervalMs = 100;
+
 bool IsConfigEvent(const rtclog::Event& event) {
   rtclog::Event_EventType event_type = event.type();
   return event_type == rtclog::Event::VIDEO_RECEIVER_CONFIG_EVENT ||
@@ -94,7 +108,8 @@ class ResourceOwningTask final : public rtc::QueuedTask {
 }  // namespace
 
 class RtcEventLogImpl final : public RtcEventLog {
-  friend std::unique_ptr<RtcEventLog> RtcEventLog::Create();
+  friend std::unique_ptr<RtcEventLog> RtcEventLog::Create(
+      EncodingType encoding_type);
 
  public:
   ~RtcEventLogImpl() override;
@@ -138,12 +153,14 @@ class RtcEventLogImpl final : public RtcEventLog {
   void StartLoggingInternal(std::unique_ptr<FileWrapper> file,
                             int64_t max_size_bytes);
 
-  RtcEventLogImpl();  // Creation is done by RtcEventLog::Create.
+  // Creation is done by RtcEventLog::Create.
+  explicit RtcEventLogImpl(EncodingType encoding_type);
 
   void StoreEvent(std::unique_ptr<rtclog::Event> event);
-  void LogProbeResult(int id,
-                      rtclog::BweProbeResult::ResultType result,
-                      int bitrate_bps);
+
+  // Writes |record| into the lock-free record buffer. May be called on any
+  // thread; never allocates.
+  void StoreRecord(const RtcEventRecord& record);
 
   // Appends an event to the output protobuf string, returning true on success.
   // Fails and returns false in case the limit on output size prevents the
@@ -153,6 +170,21 @@ class RtcEventLogImpl final : public RtcEventLog {
 
   void LogToMemory(std::unique_ptr<rtclog::Event> event);
 
+  // Moves all records from |record_buffer_| to the output file if logging,
+  // otherwise to |record_history_|. Must run before any protobuf event is
+  // stored, so that the original order of events is preserved.
+  void DrainRecords();
+  void StoreRecordInHistory(const RtcEventRecord& record);
+  void ScheduleRecordDrain();
+
+  // Encodes |records| as a single RTP packet batch and appends it to
+  // |output_string|. If the size limit prevents that, the records are moved
+  // to the history instead. |records| is cleared in either case.
+  bool AppendRtpBatchToString(std::vector<RtcEventRecord>* records,
+                              rtclog::Event* scratch_event,
+                              ProtoString* output_string)
+      RTC_WARN_UNUSED_RESULT;
+
   void StartLogFile();
   void LogToFile(std::unique_ptr<rtclog::Event> event);
   void StopLogFile(int64_t stop_time);
@@ -170,15 +202,43 @@ class RtcEventLogImpl final : public RtcEventLog {
   std::vector<std::unique_ptr<rtclog::Event>> config_history_
       RTC_ACCESS_ON(task_queue_);
 
-  // History containing the most recent (non-configuration) events (~10s).
-  std::deque<std::unique_ptr<rtclog::Event>> history_
-      RTC_ACCESS_ON(task_queue_);
+  // History containing the most recent (non-configuration) protobuf events
+  // (~10s), e.g. RTCP packets. Each event is tagged with the value that
+  // |records_stored_| had when the event was stored, which allows merging
+  // the history with |record_history_| in the original order.
+  struct HistoryEvent {
+    uint64_t records_before;
+    std::unique_ptr<rtclog::Event> event;
+  };
+  std::deque<HistoryEvent> history_ RTC_ACCESS_ON(task_queue_);
+
+  // Circular buffer containing the most recent records (~10s). Records are
+  // kept in their compact form until a log file is started.
+  std::vector<RtcEventRecord> record_history_ RTC_ACCESS_ON(task_queue_);
+  size_t record_history_size_ RTC_ACCESS_ON(task_queue_);
+  // Total number of records that have been stored in |record_history_|.
+  uint64_t records_stored_ RTC_ACCESS_ON(task_queue_);
+
+  bool drain_timer_running_ RTC_ACCESS_ON(task_queue_);
+
+  const EncodingType encoding_type_;
+  // RTP header records waiting to be written as a batch, per SSRC and
+  // direction. Only used with EncodingType::kColumnarRtp. The vectors keep
+  // their capacity between batches.
+  std::map<std::pair<uint32_t, bool>, std::vector<RtcEventRecord>>
+      pending_rtp_batches_ RTC_ACCESS_ON(task_queue_);
 
   std::unique_ptr<FileWrapper> file_ RTC_ACCESS_ON(task_queue_);
 
   size_t max_size_bytes_ RTC_ACCESS_ON(task_queue_);
   size_t written_bytes_ RTC_ACCESS_ON(task_queue_);
 
+  // Records of high-frequency events written by the logging threads, waiting
+  // to be moved to the history or the output file on |task_queue_|.
+  RtcEventRingBuffer record_buffer_;
+  std::atomic<bool> drain_posted_;
+  std::atomic<int> dropped_records_;
+
   // Keep this last to ensure it destructs first, or else tasks living on the
   // queue might access other members after they've been torn down.
   rtc::TaskQueue task_queue_;
@@ -233,14 +293,83 @@ rtclog::BweProbeResult::ResultType ConvertProbeResultType(
   return rtclog::BweProbeResult::SUCCESS;
 }
 
+void EncodeRecord(const RtcEventRecord& record, rtclog::Event* event) {
+  event->Clear();
+  event->set_timestamp_us(record.timestamp_us);
+  switch (record.type) {
+    case RtcEventRecord::Type::kRtpHeader: {
+      event->set_type(rtclog::Event::RTP_EVENT);
+      rtclog::RtpPacket* rtp_packet = event->mutable_rtp_packet();
+      rtp_packet->set_incoming(record.rtp.incoming);
+      rtp_packet->set_packet_length(record.rtp.packet_length);
+      rtp_packet->set_header(record.rtp.header, record.rtp.header_length);
+      if (record.rtp.probe_cluster_id != PacedPacketInfo::kNotAProbe)
+        rtp_packet->set_probe_cluster_id(record.rtp.probe_cluster_id);
+      return;
+    }
+    case RtcEventRecord::Type::kAudioPlayout:
+      event->set_type(rtclog::Event::AUDIO_PLAYOUT_EVENT);
+      event->mutable_audio_playout_event()->set_local_ssrc(
+          record.audio_playout.ssrc);
+      return;
+    case RtcEventRecord::Type::kLossBasedBweUpdate: {
+      event->set_type(rtclog::Event::LOSS_BASED_BWE_UPDATE);
+      auto bwe_event = event->mutable_loss_based_bwe_update();
+      bwe_event->set_bitrate_bps(record.loss_based_bwe_update.bitrate_bps);
+      bwe_event->set_fraction_loss(record.loss_based_bwe_update.fraction_loss);
+      bwe_event->set_total_packets(record.loss_based_bwe_update.total_packets);
+      return;
+    }
+    case RtcEventRecord::Type::kDelayBasedBweUpdate: {
+      event->set_type(rtclog::Event::DELAY_BASED_BWE_UPDATE);
+      auto bwe_event = event->mutable_delay_based_bwe_update();
+      bwe_event->set_bitrate_bps(record.delay_based_bwe_update.bitrate_bps);
+      bwe_event->set_detector_state(
+          ConvertDetectorState(record.delay_based_bwe_update.detector_state));
+      return;
+    }
+    case RtcEventRecord::Type::kProbeClusterCreated: {
+      event->set_type(rtclog::Event::BWE_PROBE_CLUSTER_CREATED_EVENT);
+      auto probe_cluster = event->mutable_probe_cluster();
+      probe_cluster->set_id(record.probe_cluster.id);
+      probe_cluster->set_bitrate_bps(record.probe_cluster.bitrate_bps);
+      probe_cluster->set_min_packets(record.probe_cluster.min_packets);
+      probe_cluster->set_min_bytes(record.probe_cluster.min_bytes);
+      return;
+    }
+    case RtcEventRecord::Type::kProbeResult: {
+      event->set_type(rtclog::Event::BWE_PROBE_RESULT_EVENT);
+      auto probe_result = event->mutable_probe_result();
+      probe_result->set_id(record.probe_result.id);
+      if (record.probe_result.success) {
+        probe_result->set_result(rtclog::BweProbeResult::SUCCESS);
+        probe_result->set_bitrate_bps(record.probe_result.bitrate_bps);
+      } else {
+        probe_result->set_result(
+            ConvertProbeResultType(record.probe_result.failure_reason));
+      }
+      return;
+    }
+  }
+  RTC_NOTREACHED();
+}
+
 }  // namespace
 
 std::atomic<int> RtcEventLogImpl::log_count_(0);
 
-RtcEventLogImpl::RtcEventLogImpl()
-    : file_(FileWrapper::Create()),
+RtcEventLogImpl::RtcEventLogImpl(EncodingType encoding_type)
+    : record_history_(kEventsInHistory),
+      record_history_size_(0),
+      records_stored_(0),
+      drain_timer_running_(false),
+      encoding_type_(encoding_type),
+      file_(FileWrapper::Create()),
       max_size_bytes_(std::numeric_limits<decltype(max_size_bytes_)>::max()),
       written_bytes_(0),
+      record_buffer_(kRecordBufferCapacity),
+      drain_posted_(false),
+      dropped_records_(0),
       task_queue_("rtc_event_log") {}
 
 RtcEventLogImpl::~RtcEventLogImpl() {
@@ -304,6 +433,9 @@ void RtcEventLogImpl::StopLogging() {
 
   task_queue_.PostTask([this, stop_time, &file_finished]() {
     RTC_DCHECK_RUN_ON(&task_queue_);
+    if (file_->is_open()) {
+      DrainRecords();
+    }
     if (file_->is_open()) {
       StopLogFile(stop_time);
     }
@@ -456,6 +588,19 @@ void RtcEventLogImpl::LogRtpHeader(PacketDirection direction,
     header_length += (x_len + 1) * 4;
   }
 
+  if (header_length <= RtcEventRecord::kMaxRtpHeaderLength) {
+    RtcEventRecord record;
+    record.timestamp_us = rtc::TimeMicros();
+    record.type = RtcEventRecord::Type::kRtpHeader;
+    record.rtp.incoming = direction == kIncomingPacket;
+    record.rtp.header_length = static_cast<uint8_t>(header_length);
+    record.rtp.probe_cluster_id = probe_cluster_id;
+    record.rtp.packet_length = static_cast<uint32_t>(packet_length);
+    memcpy(record.rtp.header, header, header_length);
+    StoreRecord(record);
+    return;
+  }
+
   std::unique_ptr<rtclog::Event> rtp_event(new rtclog::Event());
   rtp_event->set_timestamp_us(rtc::TimeMicros());
   rtp_event->set_type(rtclog::Event::RTP_EVENT);
@@ -516,36 +661,33 @@ void RtcEventLogImpl::LogRtcpPacket(PacketDirection direction,
 }
 
 void RtcEventLogImpl::LogAudioPlayout(uint32_t ssrc) {
-  std::unique_ptr<rtclog::Event> event(new rtclog::Event());
-  event->set_timestamp_us(rtc::TimeMicros());
-  event->set_type(rtclog::Event::AUDIO_PLAYOUT_EVENT);
-  auto playout_event = event->mutable_audio_playout_event();
-  playout_event->set_local_ssrc(ssrc);
-  StoreEvent(std::move(event));
+  RtcEventRecord record;
+  record.timestamp_us = rtc::TimeMicros();
+  record.type = RtcEventRecord::Type::kAudioPlayout;
+  record.audio_playout.ssrc = ssrc;
+  StoreRecord(record);
 }
 
 void RtcEventLogImpl::LogLossBasedBweUpdate(int32_t bitrate_bps,
                                             uint8_t fraction_loss,
                                             int32_t total_packets) {
-  std::unique_ptr<rtclog::Event> event(new rtclog::Event());
-  event->set_timestamp_us(rtc::TimeMicros());
-  event->set_type(rtclog::Event::LOSS_BASED_BWE_UPDATE);
-  auto bwe_event = event->mutable_loss_based_bwe_update();
-  bwe_event->set_bitrate_bps(bitrate_bps);
-  bwe_event->set_fraction_loss(fraction_loss);
-  bwe_event->set_total_packets(total_packets);
-  StoreEvent(std::move(event));
+  RtcEventRecord record;
+  record.timestamp_us = rtc::TimeMicros();
+  record.type = RtcEventRecord::Type::kLossBasedBweUpdate;
+  record.loss_based_bwe_update.bitrate_bps = bitrate_bps;
+  record.loss_based_bwe_update.fraction_loss = fraction_loss;
+  record.loss_based_bwe_update.total_packets = total_packets;
+  StoreRecord(record);
 }
 
 void RtcEventLogImpl::LogDelayBasedBweUpdate(int32_t bitrate_bps,
                                              BandwidthUsage detector_state) {
-  std::unique_ptr<rtclog::Event> event(new rtclog::Event());
-  event->set_timestamp_us(rtc::TimeMicros());
-  event->set_type(rtclog::Event::DELAY_BASED_BWE_UPDATE);
-  auto bwe_event = event->mutable_delay_based_bwe_update();
-  bwe_event->set_bitrate_bps(bitrate_bps);
-  bwe_event->set_detector_state(ConvertDetectorState(detector_state));
-  StoreEvent(std::move(event));
+  RtcEventRecord record;
+  record.timestamp_us = rtc::TimeMicros();
+  record.type = RtcEventRecord::Type::kDelayBasedBweUpdate;
+  record.delay_based_bwe_update.bitrate_bps = bitrate_bps;
+  record.delay_based_bwe_update.detector_state = detector_state;
+  StoreRecord(record);
 }
 
 void RtcEventLogImpl::LogAudioNetworkAdaptation(
@@ -575,42 +717,37 @@ void RtcEventLogImpl::LogProbeClusterCreated(int id,
                                              int bitrate_bps,
                                              int min_probes,
                                              int min_bytes) {
-  std::unique_ptr<rtclog::Event> event(new rtclog::Event());
-  event->set_timestamp_us(rtc::TimeMicros());
-  event->set_type(rtclog::Event::BWE_PROBE_CLUSTER_CREATED_EVENT);
-
-  auto probe_cluster = event->mutable_probe_cluster();
-  probe_cluster->set_id(id);
-  probe_cluster->set_bitrate_bps(bitrate_bps);
-  probe_cluster->set_min_packets(min_probes);
-  probe_cluster->set_min_bytes(min_bytes);
-  StoreEvent(std::move(event));
+  RtcEventRecord record;
+  record.timestamp_us = rtc::TimeMicros();
+  record.type = RtcEventRecord::Type::kProbeClusterCreated;
+  record.probe_cluster.id = id;
+  record.probe_cluster.bitrate_bps = bitrate_bps;
+  record.probe_cluster.min_packets = min_probes;
+  record.probe_cluster.min_bytes = min_bytes;
+  StoreRecord(record);
 }
 
 void RtcEventLogImpl::LogProbeResultSuccess(int id, int bitrate_bps) {
-  LogProbeResult(id, rtclog::BweProbeResult::SUCCESS, bitrate_bps);
+  RtcEventRecord record;
+  record.timestamp_us = rtc::TimeMicros();
+  record.type = RtcEventRecord::Type::kProbeResult;
+  record.probe_result.id = id;
+  record.probe_result.success = true;
+  record.probe_result.failure_reason = kTimeout;  // Unused.
+  record.probe_result.bitrate_bps = bitrate_bps;
+  StoreRecord(record);
 }
 
 void RtcEventLogImpl::LogProbeResultFailure(int id,
                                             ProbeFailureReason failure_reason) {
-  rtclog::BweProbeResult::ResultType result =
-      ConvertProbeResultType(failure_reason);
-  LogProbeResult(id, result, -1);
-}
-
-void RtcEventLogImpl::LogProbeResult(int id,
-                                     rtclog::BweProbeResult::ResultType result,
-                                     int bitrate_bps) {
-  std::unique_ptr<rtclog::Event> event(new rtclog::Event());
-  event->set_timestamp_us(rtc::TimeMicros());
-  event->set_type(rtclog::Event::BWE_PROBE_RESULT_EVENT);
-
-  auto probe_result = event->mutable_probe_result();
-  probe_result->set_id(id);
-  probe_result->set_result(result);
-  if (result == rtclog::BweProbeResult::SUCCESS)
-    probe_result->set_bitrate_bps(bitrate_bps);
-  StoreEvent(std::move(event));
+  RtcEventRecord record;
+  record.timestamp_us = rtc::TimeMicros();
+  record.type = RtcEventRecord::Type::kProbeResult;
+  record.probe_result.id = id;
+  record.probe_result.success = false;
+  record.probe_result.failure_reason = failure_reason;
+  record.probe_result.bitrate_bps = -1;
+  StoreRecord(record);
 }
 
 void RtcEventLogImpl::StartLoggingInternal(std::unique_ptr<FileWrapper> file,
@@ -641,6 +778,8 @@ void RtcEventLogImpl::StoreEvent(std::unique_ptr<rtclog::Event> event) {
 
   auto event_handler = [this](std::unique_ptr<rtclog::Event> rtclog_event) {
     RTC_DCHECK_RUN_ON(&task_queue_);
+    // Records logged before this event must be stored before it.
+    DrainRecords();
     if (file_->is_open()) {
       LogToFile(std::move(rtclog_event));
     } else {
@@ -652,6 +791,139 @@ void RtcEventLogImpl::StoreEvent(std::unique_ptr<rtclog::Event> event) {
       std::move(event), event_handler));
 }
 
+void RtcEventLogImpl::StoreRecord(const RtcEventRecord& record) {
+  if (!record_buffer_.Push(record)) {
+    // The task queue is not keeping up; drop the record rather than block
+    // the logging thread.
+    dropped_records_.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (record_buffer_.size() >= kRecordDrainThreshold &&
+      !drain_posted_.exchange(true)) {
+    task_queue_.PostTask([this]() {
+      RTC_DCHECK_RUN_ON(&task_queue_);
+      drain_posted_.store(false);
+      DrainRecords();
+    });
+  }
+}
+
+void RtcEventLogImpl::DrainRecords() {
+  RTC_DCHECK_RUN_ON(&task_queue_);
+
+  RtcEventRecord record;
+  if (!file_->is_open()) {
+    while (record_buffer_.Pop(&record)) {
+      StoreRecordInHistory(record);
+    }
+    return;
+  }
+
+  // Encode all pending records into a single string, reusing one event, and
+  // write them with a single call.
+  ProtoString output_string;
+  rtclog::Event event;
+  bool appended = true;
+  while (record_buffer_.Pop(&record)) {
+    if (!appended) {
+      // Keep the remaining records in memory, they may be written to the next
+      // log file.
+      StoreRecordInHistory(record);
+      continue;
+    }
+    if (encoding_type_ == EncodingType::kColumnarRtp &&
+        record.type == RtcEventRecord::Type::kRtpHeader) {
+      const auto stream_id = std::make_pair(
+          ByteReader<uint32_t>::ReadBigEndian(record.rtp.header + 8),
+          record.rtp.incoming);
+      std::vector<RtcEventRecord>& batch = pending_rtp_batches_[stream_id];
+      batch.push_back(record);
+      if (batch.size() >= kMaxPacketsPerRtpBatch) {
+        appended = AppendRtpBatchToString(&batch, &event, &output_string);
+      }
+      continue;
+    }
+    EncodeRecord(record, &event);
+    appended = AppendEventToString(&event, &output_string);
+    if (!appended) {
+      StoreRecordInHistory(record);
+    }
+  }
+
+  // Batches are written at the end of every drain, so that packets are not
+  // delayed by more than the drain interval.
+  for (auto& stream_batch : pending_rtp_batches_) {
+    std::vector<RtcEventRecord>& batch = stream_batch.second;
+    if (batch.empty()) {
+      continue;
+    }
+    if (appended) {
+      appended = AppendRtpBatchToString(&batch, &event, &output_string);
+    } else {
+      for (const RtcEventRecord& batched_record : batch) {
+        StoreRecordInHistory(batched_record);
+      }
+      batch.clear();
+    }
+  }
+
+  if (!output_string.empty()) {
+    if (file_->Write(output_string.data(), output_string.size())) {
+      written_bytes_ += output_string.size();
+    } else {
+      LOG(LS_ERROR) << "FileWrapper failed to write WebRtcEventLog file.";
+      // The current FileWrapper implementation closes the file on error.
+      RTC_DCHECK(!file_->is_open());
+      return;
+    }
+  }
+
+  if (!appended) {
+    RTC_DCHECK(file_->is_open());
+    StopLogFile(rtc::TimeMicros());
+  }
+}
+
+bool RtcEventLogImpl::AppendRtpBatchToString(
+    std::vector<RtcEventRecord>* records,
+    rtclog::Event* scratch_event,
+    ProtoString* output_string) {
+  RTC_DCHECK_RUN_ON(&task_queue_);
+  RTC_DCHECK(!records->empty());
+  EncodeRtpPacketBatch(*records, scratch_event);
+  const bool appended = AppendEventToString(scratch_event, output_string);
+  if (!appended) {
+    for (const RtcEventRecord& record : *records) {
+      StoreRecordInHistory(record);
+    }
+  }
+  records->clear();
+  return appended;
+}
+
+void RtcEventLogImpl::StoreRecordInHistory(const RtcEventRecord& record) {
+  RTC_DCHECK_RUN_ON(&task_queue_);
+  record_history_[records_stored_ % record_history_.size()] = record;
+  ++records_stored_;
+  if (record_history_size_ < record_history_.size()) {
+    ++record_history_size_;
+  }
+}
+
+void RtcEventLogImpl::ScheduleRecordDrain() {
+  RTC_DCHECK_RUN_ON(&task_queue_);
+  task_queue_.PostDelayedTask(
+      [this]() {
+        RTC_DCHECK_RUN_ON(&task_queue_);
+        if (!file_->is_open()) {
+          drain_timer_running_ = false;
+          return;
+        }
+        DrainRecords();
+        ScheduleRecordDrain();
+      },
+      kRecordDrainIntervalMs);
+}
+
 bool RtcEventLogImpl::AppendEventToString(rtclog::Event* event,
                                           ProtoString* output_string) {
   RTC_DCHECK_RUN_ON(&task_queue_);
@@ -693,7 +965,7 @@ void RtcEventLogImpl::LogToMemory(std::unique_ptr<rtclog::Event> event) {
   if (IsConfigEvent(*event.get())) {
     config_history_.push_back(std::move(event));
   } else {
-    history_.push_back(std::move(event));
+    history_.push_back({records_stored_, std::move(event)});
     if (history_.size() > kEventsInHistory) {
       history_.pop_front();
     }
@@ -724,14 +996,36 @@ void RtcEventLogImpl::StartLogFile() {
     appended = AppendEventToString(event.get(), &output_string);
   }
 
-  // Serialize the events in the event queue.
-  while (appended && !history_.empty()) {
-    appended = AppendEventToString(history_.front().get(), &output_string);
-    if (appended) {
-      // Known issue - if writing to the file fails, these events will have
-      // been lost. If we try to open a new file, these events will be missing
-      // from it.
-      history_.pop_front();
+  // Serialize the events in the event queue, merging the protobuf events with
+  // the records (including those that have not been drained yet) in the order
+  // in which they were logged.
+  RtcEventRecord record;
+  while (record_buffer_.Pop(&record)) {
+    StoreRecordInHistory(record);
+  }
+  rtclog::Event record_event;
+  while (appended && (!history_.empty() || record_history_size_ > 0)) {
+    const uint64_t oldest_record = records_stored_ - record_history_size_;
+    // Known issue - if writing to the file fails, these events will have
+    // been lost. If we try to open a new file, these events will be missing
+    // from it.
+    const bool event_is_next =
+        !history_.empty() &&
+        (record_history_size_ == 0 ||
+         history_.front().records_before <= oldest_record);
+    if (event_is_next) {
+      appended =
+          AppendEventToString(history_.front().event.get(), &output_string);
+      if (appended) {
+        history_.pop_front();
+      }
+    } else {
+      EncodeRecord(record_history_[oldest_record % record_history_.size()],
+                   &record_event);
+      appended = AppendEventToString(&record_event, &output_string);
+      if (appended) {
+        --record_history_size_;
+      }
     }
   }
 
@@ -747,6 +1041,12 @@ void RtcEventLogImpl::StartLogFile() {
   if (!appended) {
     RTC_DCHECK(file_->is_open());
     StopLogFile(rtc::TimeMicros());
+    return;
+  }
+
+  if (!drain_timer_running_) {
+    drain_timer_running_ = true;
+    ScheduleRecordDrain();
   }
 }
 
@@ -764,7 +1064,7 @@ void RtcEventLogImpl::LogToFile(std::unique_ptr<rtclog::Event> event) {
 
   if (!appended) {
     RTC_DCHECK(file_->is_open());
-    history_.push_back(std::move(event));
+    history_.push_back({records_stored_, std::move(event)});
     StopLogFile(rtc::TimeMicros());
     return;
   }
@@ -802,6 +1102,12 @@ void RtcEventLogImpl::StopLogFile(int64_t stop_time) {
   max_size_bytes_ = std::numeric_limits<decltype(max_size_bytes_)>::max();
   written_bytes_ = 0;
 
+  const int dropped_records = dropped_records_.exchange(0);
+  if (dropped_records > 0) {
+    LOG(LS_WARNING) << "WebRTC event log dropped " << dropped_records
+                    << " events because the record buffer was full.";
+  }
+
   file_->CloseFile();
   RTC_DCHECK(!file_->is_open());
 }
@@ -826,6 +1132,10 @@ bool RtcEventLog::ParseRtcEventLog(const std::string& file_name,
 
 // RtcEventLog member functions.
 std::unique_ptr<RtcEventLog> RtcEventLog::Create() {
+  return Create(EncodingType::kLegacy);
+}
+
+std::unique_ptr<RtcEventLog> RtcEventLog::Create(EncodingType encoding_type) {
 #ifdef ENABLE_RTC_EVENT_LOG
   // TODO(eladalon): Known issue - there's a race over |log_count_| here.
   constexpr int kMaxLogCount = 5;
@@ -836,7 +1146,7 @@ std::unique_ptr<RtcEventLog> RtcEventLog::Create() {
     std::atomic_fetch_sub(&RtcEventLogImpl::log_count_, 1);
     return std::unique_ptr<RtcEventLog>(new RtcEventLogNullImpl());
   }
-  return std::unique_ptr<RtcEventLog>(new RtcEventLogImpl());
+  return std::unique_ptr<RtcEventLog>(new RtcEventLogImpl(encoding_type));
 #else
   return CreateNull();
 #endif  // ENABLE_RTC_EVENT_LOG
@@ -43,10 +43,23 @@ enum ProbeFailureReason {
 
 class RtcEventLog {
  public:
+  // Format used when writing events to the log file.
+  enum class EncodingType {
+    // One rtclog::Event per logged event.
+    kLegacy,
+    // RTP headers are written in delta-compressed, columnar batches of
+    // packets with the same SSRC and direction (RTP_PACKET_BATCH_EVENT).
+    // Other events are written as in kLegacy. Batching means that RTP
+    // packets are not interleaved with other events in the file in the exact
+    // order they were logged.
+    kColumnarRtp,
+  };
+
   virtual ~RtcEventLog() {}
 
   // Factory method to create an RtcEventLog object.
   static std::unique_ptr<RtcEventLog> Create();
+  static std::unique_ptr<RtcEventLog> Create(EncodingType encoding_type);
   // TODO(nisse): webrtc::Clock is deprecated. Delete this method and
   // above forward declaration of Clock when
   // webrtc/system_wrappers/include/clock.h is deleted.
@@ -17,6 +17,7 @@
 
 #include "webrtc/logging/rtc_event_log/rtc_event_log.h"
 #include "webrtc/logging/rtc_event_log/rtc_event_log_parser.h"
+#include "webrtc/logging/rtc_event_log/rtc_event_log_reader.h"
 #include "webrtc/modules/rtp_rtcp/source/byte_io.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_utility.h"
 #include "webrtc/rtc_base/checks.h"
@@ -102,9 +103,9 @@ int main(int argc, char* argv[]) {
     RTC_CHECK(ParseSsrc(FLAG_ssrc, &ssrc_filter))
         << "Flag verification has failed.";
 
-  webrtc::ParsedRtcEventLog parsed_stream;
-  if (!parsed_stream.ParseFile(input_file)) {
-    std::cerr << "Error while parsing input file: " << input_file << std::endl;
+  webrtc::RtcEventLogReader reader;
+  if (!reader.OpenFile(input_file)) {
+    std::cerr << "Error while opening input file: " << input_file << std::endl;
     return -1;
   }
 
@@ -118,88 +119,111 @@ int main(int argc, char* argv[]) {
     return -1;
   }
 
-  std::cout << "Found " << parsed_stream.GetNumberOfEvents()
-            << " events in the input file." << std::endl;
+  // The log is converted in a single pass without keeping the events in
+  // memory, so that arbitrarily large logs can be converted. Media types are
+  // looked up from the stream configurations logged before each packet.
+  webrtc::ParsedRtcEventLog parsed_stream;
+  size_t event_counter = 0;
   int rtp_counter = 0, rtcp_counter = 0;
   bool header_only = false;
-  for (size_t i = 0; i < parsed_stream.GetNumberOfEvents(); i++) {
-    // The parsed_stream will assert if the protobuf event is missing
-    // some required fields and we attempt to access them. We could consider
-    // a softer failure option, but it does not seem useful to generate
-    // RTP dumps based on broken event logs.
-    if (FLAG_rtp &&
-        parsed_stream.GetEventType(i) == webrtc::ParsedRtcEventLog::RTP_EVENT) {
+  auto write_packet = [&](const webrtc::rtclog::Event& event) {
+    ++event_counter;
+    // The RTP and RTCP events are required to contain the fields read below.
+    // We could consider a softer failure option, but it does not seem useful
+    // to generate RTP dumps based on broken event logs.
+    if (FLAG_rtp && event.type() == webrtc::rtclog::Event::RTP_EVENT) {
+      const webrtc::rtclog::RtpPacket& rtp_packet = event.rtp_packet();
+      RTC_CHECK(rtp_packet.has_incoming());
+      RTC_CHECK(rtp_packet.has_packet_length());
+      RTC_CHECK(rtp_packet.has_header());
+      RTC_CHECK_GE(rtp_packet.header().size(), 12u);
+      RTC_CHECK_LE(rtp_packet.header().size(),
+                   webrtc::test::RtpPacket::kMaxPacketBufferSize);
       webrtc::test::RtpPacket packet;
-      webrtc::PacketDirection direction;
-      parsed_stream.GetRtpHeader(i, &direction, packet.data, &packet.length,
-                                 &packet.original_length);
+      memcpy(packet.data, rtp_packet.header().data(),
+             rtp_packet.header().size());
+      packet.length = rtp_packet.header().size();
+      packet.original_length = rtp_packet.packet_length();
       if (packet.original_length > packet.length)
         header_only = true;
-      packet.time_ms = parsed_stream.GetTimestamp(i) / 1000;
-
-      webrtc::RtpUtility::RtpHeaderParser rtp_parser(packet.data,
-                                                     packet.length);
+      packet.time_ms = event.timestamp_us() / 1000;
 
       // TODO(terelius): Maybe add a flag to dump outgoing traffic instead?
-      if (direction == webrtc::kOutgoingPacket)
-        continue;
+      if (!rtp_packet.incoming())
+        return;
 
+      webrtc::RtpUtility::RtpHeaderParser rtp_parser(packet.data,
+                                                     packet.length);
       webrtc::RTPHeader parsed_header;
       rtp_parser.Parse(&parsed_header);
-      MediaType media_type =
-          parsed_stream.GetMediaType(parsed_header.ssrc, direction);
+      MediaType media_type = parsed_stream.GetMediaType(
+          parsed_header.ssrc, webrtc::kIncomingPacket);
       if (!FLAG_audio && media_type == MediaType::AUDIO)
-        continue;
+        return;
       if (!FLAG_video && media_type == MediaType::VIDEO)
-        continue;
+        return;
       if (!FLAG_data && media_type == MediaType::DATA)
-        continue;
+        return;
       if (strlen(FLAG_ssrc) > 0) {
         const uint32_t packet_ssrc =
             webrtc::ByteReader<uint32_t>::ReadBigEndian(
                 reinterpret_cast<const uint8_t*>(packet.data + 8));
         if (packet_ssrc != ssrc_filter)
-          continue;
+          return;
       }
 
       rtp_writer->WritePacket(&packet);
       rtp_counter++;
     }
-    if (FLAG_rtcp && parsed_stream.GetEventType(i) ==
-                         webrtc::ParsedRtcEventLog::RTCP_EVENT) {
+    if (FLAG_rtcp && event.type() == webrtc::rtclog::Event::RTCP_EVENT) {
+      const webrtc::rtclog::RtcpPacket& rtcp_packet = event.rtcp_packet();
+      RTC_CHECK(rtcp_packet.has_incoming());
+      RTC_CHECK(rtcp_packet.has_packet_data());
+      RTC_CHECK_GE(rtcp_packet.packet_data().size(), 8u);
+      RTC_CHECK_LE(rtcp_packet.packet_data().size(),
+                   webrtc::test::RtpPacket::kMaxPacketBufferSize);
       webrtc::test::RtpPacket packet;
-      webrtc::PacketDirection direction;
-      parsed_stream.GetRtcpPacket(i, &direction, packet.data, &packet.length);
+      memcpy(packet.data, rtcp_packet.packet_data().data(),
+             rtcp_packet.packet_data().size());
+      packet.length = rtcp_packet.packet_data().size();
       // For RTCP packets the original_length should be set to 0 in the
       // RTPdump format.
       packet.original_length = 0;
-      packet.time_ms = parsed_stream.GetTimestamp(i) / 1000;
+      packet.time_ms = event.timestamp_us() / 1000;
 
       // TODO(terelius): Maybe add a flag to dump outgoing traffic instead?
-      if (direction == webrtc::kOutgoingPacket)
-        continue;
+      if (!rtcp_packet.incoming())
+        return;
 
       // Note that |packet_ssrc| is the sender SSRC. An RTCP message may contain
       // report blocks for many streams, thus several SSRCs and they doen't
       // necessarily have to be of the same media type.
       const uint32_t packet_ssrc = webrtc::ByteReader<uint32_t>::ReadBigEndian(
           reinterpret_cast<const uint8_t*>(packet.data + 4));
-      MediaType media_type = parsed_stream.GetMediaType(packet_ssrc, direction);
+      MediaType media_type =
+          parsed_stream.GetMediaType(packet_ssrc, webrtc::kIncomingPacket);
       if (!FLAG_audio && media_type == MediaType::AUDIO)
-        continue;
+        return;
       if (!FLAG_video && media_type == MediaType::VIDEO)
-        continue;
+        return;
       if (!FLAG_data && media_type == MediaType::DATA)
-        continue;
+        return;
       if (strlen(FLAG_ssrc) > 0) {
         if (packet_ssrc != ssrc_filter)
-          continue;
+          return;
       }
 
       rtp_writer->WritePacket(&packet);
       rtcp_counter++;
     }
+  };
+  if (!parsed_stream.ParseIncrementally(&reader, write_packet)) {
+    std::cerr << "Error while parsing input file: " << input_file << std::endl;
+    return -1;
   }
+
+  std::cout << "Found " << event_counter << " events in the input file."
+            << std::endl;
   std::cout << "Wrote " << rtp_counter << (header_only ? " header-only" : "")
             << " RTP packets and " << rtcp_counter << " RTCP packets to the "
             << "output file." << std::endl;
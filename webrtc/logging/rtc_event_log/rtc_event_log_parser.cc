@@ -74,6 +74,9 @@ ParsedRtcEventLog::EventType GetRuntimeEventType(
       return ParsedRtcEventLog::EventType::BWE_PROBE_CLUSTER_CREATED_EVENT;
     case rtclog::Event::BWE_PROBE_RESULT_EVENT:
       return ParsedRtcEventLog::EventType::BWE_PROBE_RESULT_EVENT;
+    case rtclog::Event::RTP_PACKET_BATCH_EVENT:
+      // Batches are expanded into RTP_EVENTs while parsing and never stored.
+      break;
   }
   RTC_NOTREACHED();
   return ParsedRtcEventLog::EventType::UNKNOWN_EVENT;
@@ -93,27 +96,6 @@ BandwidthUsage GetRuntimeDetectorState(
   return BandwidthUsage::kBwNormal;
 }
 
-std::pair<uint64_t, bool> ParseVarInt(std::istream& stream) {
-  uint64_t varint = 0;
-  for (size_t bytes_read = 0; bytes_read < 10; ++bytes_read) {
-    // The most significant bit of each byte is 0 if it is the last byte in
-    // the varint and 1 otherwise. Thus, we take the 7 least significant bits
-    // of each byte and shift them 7 bits for each byte read previously to get
-    // the (unsigned) integer.
-    int byte = stream.get();
-    if (stream.eof()) {
-      return std::make_pair(varint, false);
-    }
-    RTC_DCHECK_GE(byte, 0);
-    RTC_DCHECK_LE(byte, 255);
-    varint |= static_cast<uint64_t>(byte & 0x7F) << (7 * bytes_read);
-    if ((byte & 0x80) == 0) {
-      return std::make_pair(varint, true);
-    }
-  }
-  return std::make_pair(varint, false);
-}
-
 void GetHeaderExtensions(
     std::vector<RtpExtension>* header_extensions,
     const RepeatedPtrField<rtclog::RtpHeaderExtension>&
@@ -147,65 +129,18 @@ bool ParsedRtcEventLog::ParseString(const std::string& s) {
 
 bool ParsedRtcEventLog::ParseStream(std::istream& stream) {
   events_.clear();
-  const size_t kMaxEventSize = (1u << 16) - 1;
-  std::vector<char> tmp_buffer(kMaxEventSize);
-  uint64_t tag;
-  uint64_t message_length;
-  bool success;
-
-  RTC_DCHECK(stream.good());
-
-  while (1) {
-    // Check whether we have reached end of file.
-    stream.peek();
-    if (stream.eof()) {
-      // Process all extensions maps for faster look-up later.
-      for (auto& event_stream : streams_) {
-        rtp_extensions_maps_[StreamId(event_stream.ssrc,
-                                      event_stream.direction)] =
-            &event_stream.rtp_extensions_map;
-      }
-      return true;
-    }
-
-    // Read the next message tag. The tag number is defined as
-    // (fieldnumber << 3) | wire_type. In our case, the field number is
-    // supposed to be 1 and the wire type for an
-    // length-delimited field is 2.
-    const uint64_t kExpectedTag = (1 << 3) | 2;
-    std::tie(tag, success) = ParseVarInt(stream);
-    if (!success) {
-      LOG(LS_WARNING) << "Missing field tag from beginning of protobuf event.";
-      return false;
-    } else if (tag != kExpectedTag) {
-      LOG(LS_WARNING) << "Unexpected field tag at beginning of protobuf event.";
-      return false;
-    }
-
-    // Read the length field.
-    std::tie(message_length, success) = ParseVarInt(stream);
-    if (!success) {
-      LOG(LS_WARNING) << "Missing message length after protobuf field tag.";
-      return false;
-    } else if (message_length > kMaxEventSize) {
-      LOG(LS_WARNING) << "Protobuf message length is too large.";
-      return false;
-    }
-
-    // Read the next protobuf event to a temporary char buffer.
-    stream.read(tmp_buffer.data(), message_length);
-    if (stream.gcount() != static_cast<int>(message_length)) {
-      LOG(LS_WARNING) << "Failed to read protobuf message from file.";
-      return false;
-    }
-
-    // Parse the protobuf event from the buffer.
-    rtclog::Event event;
-    if (!event.ParseFromArray(tmp_buffer.data(), message_length)) {
-      LOG(LS_WARNING) << "Failed to parse protobuf message.";
-      return false;
-    }
+  RtcEventLogReader reader;
+  reader.OpenStream(&stream);
+  return ParseIncrementally(&reader, [this](const rtclog::Event& event) {
+    events_.push_back(event);
+  });
+}
 
+bool ParsedRtcEventLog::ParseIncrementally(
+    RtcEventLogReader* reader,
+    const std::function<void(const rtclog::Event&)>& callback) {
+  rtclog::Event event;
+  while (reader->ReadNextEvent(&event)) {
     EventType type = GetRuntimeEventType(event.type());
     switch (type) {
       case VIDEO_RECEIVER_CONFIG_EVENT: {
@@ -252,8 +187,15 @@ bool ParsedRtcEventLog::ParseStream(std::istream& stream) {
         break;
     }
 
-    events_.push_back(event);
+    callback(event);
+  }
+
+  // Process all extensions maps for faster look-up later.
+  for (auto& event_stream : streams_) {
+    rtp_extensions_maps_[StreamId(event_stream.ssrc, event_stream.direction)] =
+        &event_stream.rtp_extensions_map;
   }
+  return !reader->failed();
 }
 
 size_t ParsedRtcEventLog::GetNumberOfEvents() const {
@@ -10,6 +10,7 @@
 #ifndef WEBRTC_LOGGING_RTC_EVENT_LOG_RTC_EVENT_LOG_PARSER_H_
 #define WEBRTC_LOGGING_RTC_EVENT_LOG_RTC_EVENT_LOG_PARSER_H_
 
+#include <functional>
 #include <map>
 #include <string>
 #include <utility>  // pair
@@ -18,6 +19,7 @@
 #include "webrtc/call/video_receive_stream.h"
 #include "webrtc/call/video_send_stream.h"
 #include "webrtc/logging/rtc_event_log/rtc_event_log.h"
+#include "webrtc/logging/rtc_event_log/rtc_event_log_reader.h"
 #include "webrtc/modules/rtp_rtcp/include/rtp_header_extension_map.h"
 #include "webrtc/modules/rtp_rtcp/source/byte_io.h"
 #include "webrtc/rtc_base/ignore_wundef.h"
@@ -89,6 +91,15 @@ class ParsedRtcEventLog {
   // Reads an RtcEventLog from an istream and returns true if successful.
   bool ParseStream(std::istream& stream);
 
+  // Reads the events from |reader| one at a time and passes each of them to
+  // |callback| instead of storing it, so that memory use does not grow with
+  // the length of the log. Stream configurations are still collected, which
+  // means that GetMediaType() can be called from |callback| for streams
+  // configured earlier in the log. Returns true if the whole log was read.
+  bool ParseIncrementally(
+      RtcEventLogReader* reader,
+      const std::function<void(const rtclog::Event&)>& callback);
+
   // Returns the number of events in an EventStream.
   size_t GetNumberOfEvents() const;
 
@@ -0,0 +1,397 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/logging/rtc_event_log/rtc_event_log.h"
+#include "webrtc/logging/rtc_event_log/rtc_event_log_parser.h"
+#include "webrtc/logging/rtc_event_log/rtc_event_log_reader.h"
+#include "webrtc/logging/rtc_event_log/rtc_event_record.h"
+#include "webrtc/modules/rtp_rtcp/include/rtp_header_extension_map.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_header_extensions.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_packet_to_send.h"
+#include "webrtc/rtc_base/event.h"
+#include "webrtc/rtc_base/protobuf_utils.h"
+#include "webrtc/rtc_base/random.h"
+#include "webrtc/rtc_base/task_queue.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/system_wrappers/include/file_wrapper.h"
+#include "webrtc/system_wrappers/include/sleep.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/fileutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+// Files generated at build-time by the protobuf compiler.
+#ifdef WEBRTC_ANDROID_PLATFORM_BUILD
+#include "external/webrtc/webrtc/logging/rtc_event_log/rtc_event_log.pb.h"
+#else
+#include "webrtc/logging/rtc_event_log/rtc_event_log.pb.h"
+#endif
+
+namespace webrtc {
+
+namespace {
+
+constexpr size_t kNumPackets = 50000;
+// Packets are logged in bursts, as they would be by a pacer or a network
+// thread, so that the logging task queue gets a chance to keep up.
+constexpr size_t kPacketsPerBurst = 500;
+constexpr int kPauseBetweenBurstsMs = 5;
+// Size of the synthetic log used to benchmark the streaming reader.
+constexpr uint64_t kLargeLogSize = 2ull << 30;
+
+std::vector<RtpPacketToSend> GenerateRtpPackets(size_t count) {
+  Random prng(0x5eed);
+  std::vector<RtpPacketToSend> packets;
+  packets.reserve(count);
+  const uint32_t ssrc = prng.Rand<uint32_t>();
+  for (size_t i = 0; i < count; ++i) {
+    packets.emplace_back(nullptr);
+    RtpPacketToSend& packet = packets.back();
+    packet.SetPayloadType(96);
+    packet.SetSequenceNumber(static_cast<uint16_t>(i));
+    packet.SetTimestamp(static_cast<uint32_t>(i * 3000));
+    packet.SetSsrc(ssrc);
+    packet.SetMarker(i % 10 == 9);
+    packet.SetPayloadSize(prng.Rand(800, 1200));
+  }
+  return packets;
+}
+
+// Generates a call-like packet stream: |num_streams| interleaved SSRCs with
+// transport-wide sequence numbers and absolute send times, in packets of
+// varying size with frames spanning several packets.
+std::vector<RtpPacketToSend> GenerateMultiStreamRtpPackets(
+    const RtpPacketToSend::ExtensionManager* extensions,
+    size_t num_streams,
+    size_t count) {
+  Random prng(0xc0ffee);
+  std::vector<uint32_t> ssrcs;
+  std::vector<uint16_t> sequence_numbers;
+  std::vector<uint32_t> rtp_timestamps;
+  for (size_t i = 0; i < num_streams; ++i) {
+    ssrcs.push_back(prng.Rand<uint32_t>());
+    sequence_numbers.push_back(prng.Rand<uint16_t>());
+    rtp_timestamps.push_back(prng.Rand<uint32_t>());
+  }
+  std::vector<RtpPacketToSend> packets;
+  packets.reserve(count);
+  int64_t send_time_ms = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const size_t stream = prng.Rand(0, static_cast<int>(num_streams) - 1);
+    const bool end_of_frame = prng.Rand(0, 3) == 0;
+    packets.emplace_back(extensions);
+    RtpPacketToSend& packet = packets.back();
+    packet.SetPayloadType(96 + stream);
+    packet.SetSequenceNumber(sequence_numbers[stream]++);
+    packet.SetTimestamp(rtp_timestamps[stream]);
+    packet.SetSsrc(ssrcs[stream]);
+    packet.SetMarker(end_of_frame);
+    packet.SetExtension<TransportSequenceNumber>(static_cast<uint16_t>(i));
+    packet.SetExtension<AbsoluteSendTime>(
+        AbsoluteSendTime::MsTo24Bits(send_time_ms));
+    packet.SetPayloadSize(prng.Rand(200, 1200));
+    if (end_of_frame)
+      rtp_timestamps[stream] += 3000;
+    send_time_ms += prng.Rand(0, 2);
+  }
+  return packets;
+}
+
+std::string TempFilename() {
+  auto test_info = ::testing::UnitTest::GetInstance()->current_test_info();
+  return test::OutputPath() + test_info->test_case_name() + test_info->name();
+}
+
+size_t FileSize(const std::string& file_name) {
+  FILE* file = fopen(file_name.c_str(), "rb");
+  if (!file)
+    return 0;
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);  // NOLINT(runtime/int)
+  fclose(file);
+  return size < 0 ? 0 : static_cast<size_t>(size);
+}
+
+// Replicates the per-event path that RtcEventLogImpl used before RTP headers
+// were logged as RtcEventRecords: one heap-allocated protobuf per packet,
+// handed to the log's task queue and serialized there one at a time.
+class ProtobufPerEventLogger {
+ public:
+  explicit ProtobufPerEventLogger(const std::string& file_name)
+      : file_(FileWrapper::Create()), task_queue_("protobuf_logger") {
+    file_->OpenFile(file_name.c_str(), false);
+  }
+
+  ~ProtobufPerEventLogger() {
+    rtc::Event done(false, false);
+    task_queue_.PostTask([this, &done]() {
+      file_->CloseFile();
+      done.Set();
+    });
+    done.Wait(rtc::Event::kForever);
+  }
+
+  void LogRtpHeader(const RtpPacketToSend& packet) {
+    rtclog::Event* event = new rtclog::Event();
+    event->set_timestamp_us(rtc::TimeMicros());
+    event->set_type(rtclog::Event::RTP_EVENT);
+    event->mutable_rtp_packet()->set_incoming(false);
+    event->mutable_rtp_packet()->set_packet_length(packet.size());
+    event->mutable_rtp_packet()->set_header(packet.data(),
+                                            packet.headers_size());
+    task_queue_.PostTask([this, event]() {
+      rtclog::EventStream event_stream;
+      event_stream.add_stream()->Swap(event);
+      delete event;
+      ProtoString output_string;
+      event_stream.AppendToString(&output_string);
+      file_->Write(output_string.data(), output_string.size());
+    });
+  }
+
+ private:
+  std::unique_ptr<FileWrapper> file_;
+  rtc::TaskQueue task_queue_;
+};
+
+// Logs all |packets| through |log_packet| and returns the time spent on the
+// calling thread, in nanoseconds. Pauses between bursts are not counted.
+template <typename LogPacket>
+int64_t LogPacketsInBursts(const std::vector<RtpPacketToSend>& packets,
+                           LogPacket log_packet) {
+  int64_t logging_time_ns = 0;
+  for (size_t begin = 0; begin < packets.size(); begin += kPacketsPerBurst) {
+    const size_t end = std::min(begin + kPacketsPerBurst, packets.size());
+    const int64_t start_ns = rtc::TimeNanos();
+    for (size_t i = begin; i < end; ++i)
+      log_packet(packets[i]);
+    logging_time_ns += rtc::TimeNanos() - start_ns;
+    SleepMs(kPauseBetweenBurstsMs);
+  }
+  return logging_time_ns;
+}
+
+// Writes a legacy-encoded log of at least |min_size| bytes to |file_name|, by
+// repeating the RTP events for |packets| with increasing timestamps. Returns
+// the number of events written.
+size_t WriteLargeLog(const std::string& file_name,
+                     const std::vector<RtpPacketToSend>& packets,
+                     uint64_t min_size) {
+  std::ofstream file(file_name, std::ios_base::out | std::ios_base::binary |
+                                    std::ios_base::trunc);
+  rtclog::EventStream event_stream;
+  rtclog::Event* event = event_stream.add_stream();
+  event->set_type(rtclog::Event::RTP_EVENT);
+  event->mutable_rtp_packet()->set_incoming(true);
+  ProtoString output_string;
+  uint64_t size = 0;
+  size_t num_events = 0;
+  while (size < min_size) {
+    output_string.clear();
+    for (const RtpPacketToSend& packet : packets) {
+      event->set_timestamp_us(num_events * 1000);
+      event->mutable_rtp_packet()->set_packet_length(packet.size());
+      event->mutable_rtp_packet()->set_header(packet.data(),
+                                              packet.headers_size());
+      event_stream.AppendToString(&output_string);
+      ++num_events;
+    }
+    file.write(output_string.data(), output_string.size());
+    size += output_string.size();
+  }
+  return num_events;
+}
+
+void PrintThroughput(const std::string& trace,
+                     size_t num_events,
+                     int64_t logging_time_ns,
+                     int64_t total_time_ns) {
+  test::PrintResult("rtc_event_log_rtp_header", "_calling_thread", trace,
+                    static_cast<size_t>(num_events * rtc::kNumNanosecsPerSec /
+                                        std::max<int64_t>(logging_time_ns, 1)),
+                    "events/s", true);
+  test::PrintResult("rtc_event_log_rtp_header", "_end_to_end", trace,
+                    static_cast<size_t>(num_events * rtc::kNumNanosecsPerSec /
+                                        std::max<int64_t>(total_time_ns, 1)),
+                    "events/s", false);
+}
+
+}  // namespace
+
+// Measures how many RTP headers per second the event log accepts on the
+// calling thread, and the end-to-end rate including writing the file.
+TEST(RtcEventLogPerformanceTest, RtpHeadersAsRecords) {
+  const std::vector<RtpPacketToSend> packets = GenerateRtpPackets(kNumPackets);
+  const std::string temp_filename = TempFilename();
+
+  const int64_t start_ns = rtc::TimeNanos();
+  std::unique_ptr<RtcEventLog> log = RtcEventLog::Create();
+  ASSERT_TRUE(log->StartLogging(temp_filename, 0));
+  const int64_t logging_time_ns =
+      LogPacketsInBursts(packets, [&log](const RtpPacketToSend& packet) {
+        log->LogRtpHeader(kOutgoingPacket, packet.data(), packet.size());
+      });
+  log->StopLogging();
+  const int64_t total_time_ns = rtc::TimeNanos() - start_ns;
+
+  PrintThroughput("records", kNumPackets, logging_time_ns, total_time_ns);
+  test::PrintResult("rtc_event_log_rtp_header", "_in_memory", "records",
+                    sizeof(RtcEventRecord), "bytes/event", false);
+  test::PrintResult("rtc_event_log_rtp_header", "_in_file", "records",
+                    FileSize(temp_filename) / kNumPackets, "bytes/event",
+                    true);
+
+  // All packets, plus LOG_START and LOG_END, must have made it to the file.
+  ParsedRtcEventLog parsed_log;
+  ASSERT_TRUE(parsed_log.ParseFile(temp_filename));
+  EXPECT_EQ(kNumPackets + 2, parsed_log.GetNumberOfEvents());
+
+  remove(temp_filename.c_str());
+}
+
+// Same as above, for a logger that allocates and serializes one protobuf per
+// packet. Serves as the baseline for the test above.
+TEST(RtcEventLogPerformanceTest, RtpHeadersAsProtobufEvents) {
+  const std::vector<RtpPacketToSend> packets = GenerateRtpPackets(kNumPackets);
+  const std::string temp_filename = TempFilename();
+
+  const int64_t start_ns = rtc::TimeNanos();
+  int64_t logging_time_ns;
+  {
+    ProtobufPerEventLogger logger(temp_filename);
+    logging_time_ns =
+        LogPacketsInBursts(packets, [&logger](const RtpPacketToSend& packet) {
+          logger.LogRtpHeader(packet);
+        });
+  }
+  const int64_t total_time_ns = rtc::TimeNanos() - start_ns;
+
+  PrintThroughput("protobuf", kNumPackets, logging_time_ns, total_time_ns);
+  test::PrintResult("rtc_event_log_rtp_header", "_in_file", "protobuf",
+                    FileSize(temp_filename) / kNumPackets, "bytes/event",
+                    true);
+
+  remove(temp_filename.c_str());
+}
+
+// Writes the same multi-stream packet sequence with both encodings and reports
+// the resulting file sizes and the time needed to parse the files.
+TEST(RtcEventLogPerformanceTest, ColumnarRtpEncodingSizeAndParseTime) {
+  constexpr size_t kNumStreams = 4;
+  RtpPacketToSend::ExtensionManager extensions;
+  extensions.Register(kRtpExtensionTransportSequenceNumber, 1);
+  extensions.Register(kRtpExtensionAbsoluteSendTime, 3);
+  const std::vector<RtpPacketToSend> packets =
+      GenerateMultiStreamRtpPackets(&extensions, kNumStreams, kNumPackets);
+
+  const struct {
+    RtcEventLog::EncodingType encoding_type;
+    const char* trace;
+  } kEncodings[] = {{RtcEventLog::EncodingType::kLegacy, "legacy"},
+                    {RtcEventLog::EncodingType::kColumnarRtp, "columnar"}};
+  for (const auto& encoding : kEncodings) {
+    const std::string temp_filename = TempFilename() + encoding.trace;
+    std::unique_ptr<RtcEventLog> log =
+        RtcEventLog::Create(encoding.encoding_type);
+    ASSERT_TRUE(log->StartLogging(temp_filename, 0));
+    LogPacketsInBursts(packets, [&log](const RtpPacketToSend& packet) {
+      log->LogRtpHeader(kOutgoingPacket, packet.data(), packet.size());
+    });
+    log->StopLogging();
+
+    test::PrintResult("rtc_event_log_file_size", "", encoding.trace,
+                      FileSize(temp_filename) * 1000 / kNumPackets,
+                      "bytes/1000_packets", true);
+
+    const int64_t parse_start_ns = rtc::TimeNanos();
+    ParsedRtcEventLog parsed_log;
+    ASSERT_TRUE(parsed_log.ParseFile(temp_filename));
+    const int64_t parse_time_ns = rtc::TimeNanos() - parse_start_ns;
+    EXPECT_EQ(kNumPackets + 2, parsed_log.GetNumberOfEvents());
+    test::PrintResult("rtc_event_log_parse_time", "", encoding.trace,
+                      static_cast<size_t>(parse_time_ns /
+                                          rtc::kNumNanosecsPerMicrosec),
+                      "us", true);
+
+    remove(temp_filename.c_str());
+  }
+}
+
+// Reads a synthetic 2 GB log with RtcEventLogReader, which only holds one event
+// in memory at a time, then builds an index and uses it to read the packets of
+// a single SSRC. Disabled by default because of the size of the log; run with
+// --gtest_also_run_disabled_tests.
+TEST(RtcEventLogPerformanceTest, DISABLED_StreamingReaderOnLargeLog) {
+  constexpr size_t kNumStreams = 4;
+  RtpPacketToSend::ExtensionManager extensions;
+  extensions.Register(kRtpExtensionTransportSequenceNumber, 1);
+  extensions.Register(kRtpExtensionAbsoluteSendTime, 3);
+  const std::vector<RtpPacketToSend> packets =
+      GenerateMultiStreamRtpPackets(&extensions, kNumStreams, kNumPackets);
+  const std::string log_filename = TempFilename();
+  const size_t num_events = WriteLargeLog(log_filename, packets, kLargeLogSize);
+  const uint64_t log_size = FileSize(log_filename);
+
+  RtcEventLogReader reader;
+  ASSERT_TRUE(reader.OpenFile(log_filename));
+  rtclog::Event event;
+  size_t events_read = 0;
+  int64_t start_ns = rtc::TimeNanos();
+  while (reader.ReadNextEvent(&event))
+    ++events_read;
+  const int64_t read_time_ns = rtc::TimeNanos() - start_ns;
+  ASSERT_FALSE(reader.failed());
+  EXPECT_EQ(num_events, events_read);
+  test::PrintResult("rtc_event_log_streaming_read", "", "2GB_log",
+                    static_cast<size_t>(log_size * rtc::kNumNanosecsPerSec /
+                                        std::max<int64_t>(read_time_ns, 1) /
+                                        (1 << 20)),
+                    "MB/s", true);
+
+  ASSERT_TRUE(reader.OpenFile(log_filename));
+  RtcEventLogIndex index;
+  start_ns = rtc::TimeNanos();
+  ASSERT_TRUE(index.Build(&reader));
+  test::PrintResult("rtc_event_log_index_build_time", "", "2GB_log",
+                    static_cast<size_t>((rtc::TimeNanos() - start_ns) /
+                                        rtc::kNumNanosecsPerMillisec),
+                    "ms", true);
+  const std::string index_filename = log_filename + ".index";
+  ASSERT_TRUE(index.WriteToFile(index_filename));
+  test::PrintResult("rtc_event_log_index_size", "", "2GB_log",
+                    FileSize(index_filename), "bytes", true);
+
+  // Read the packets of one stream by seeking to the indexed messages.
+  const uint32_t ssrc = packets.front().Ssrc();
+  const std::vector<uint64_t> offsets =
+      index.GetPacketOffsets(ssrc, kIncomingPacket);
+  ASSERT_FALSE(offsets.empty());
+  start_ns = rtc::TimeNanos();
+  for (uint64_t offset : offsets) {
+    ASSERT_TRUE(reader.Seek(offset));
+    ASSERT_TRUE(reader.ReadNextEvent(&event));
+  }
+  test::PrintResult("rtc_event_log_indexed_stream_read_time", "", "2GB_log",
+                    static_cast<size_t>((rtc::TimeNanos() - start_ns) /
+                                        rtc::kNumNanosecsPerMillisec),
+                    "ms", true);
+
+  remove(index_filename.c_str());
+  remove(log_filename.c_str());
+}
+
+}  // namespace webrtc
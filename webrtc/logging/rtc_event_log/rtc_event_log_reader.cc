@@ -0,0 +1,313 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/logging/rtc_event_log/rtc_event_log_reader.h"
+
+#include <stdint.h>
+
+#include <iterator>
+
+#include "webrtc/logging/rtc_event_log/rtp_packet_batch.h"
+#include "webrtc/modules/rtp_rtcp/source/byte_io.h"
+#include "webrtc/rtc_base/checks.h"
+#include "webrtc/rtc_base/logging.h"
+#include "webrtc/rtc_base/protobuf_utils.h"
+
+namespace webrtc {
+
+namespace {
+
+const size_t kMaxEventSize = (1u << 16) - 1;
+
+// Reads a varint from |stream| and adds the number of bytes consumed to
+// |position|. Returns false if the stream ends before the varint does.
+bool ParseVarInt(std::istream& stream, uint64_t* varint, uint64_t* position) {
+  *varint = 0;
+  for (size_t bytes_read = 0; bytes_read < 10; ++bytes_read) {
+    // The most significant bit of each byte is 0 if it is the last byte in
+    // the varint and 1 otherwise. Thus, we take the 7 least significant bits
+    // of each byte and shift them 7 bits for each byte read previously to get
+    // the (unsigned) integer.
+    int byte = stream.get();
+    if (stream.eof()) {
+      return false;
+    }
+    ++*position;
+    RTC_DCHECK_GE(byte, 0);
+    RTC_DCHECK_LE(byte, 255);
+    *varint |= static_cast<uint64_t>(byte & 0x7F) << (7 * bytes_read);
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+RtcEventLogReader::RtcEventLogReader()
+    : stream_(nullptr),
+      buffer_(kMaxEventSize),
+      position_(0),
+      event_offset_(0),
+      failed_(false),
+      next_batch_event_(0) {}
+
+RtcEventLogReader::~RtcEventLogReader() = default;
+
+bool RtcEventLogReader::OpenFile(const std::string& file_name) {
+  file_.reset(new std::ifstream(file_name,
+                                std::ios_base::in | std::ios_base::binary));
+  if (!file_->good() || !file_->is_open()) {
+    LOG(LS_WARNING) << "Could not open file for reading.";
+    file_.reset();
+    return false;
+  }
+  OpenStream(file_.get());
+  return true;
+}
+
+void RtcEventLogReader::OpenStream(std::istream* stream) {
+  RTC_DCHECK(stream);
+  RTC_DCHECK(stream->good());
+  stream_ = stream;
+  position_ = 0;
+  event_offset_ = 0;
+  failed_ = false;
+  batch_events_.clear();
+  next_batch_event_ = 0;
+}
+
+bool RtcEventLogReader::ReadNextEvent(rtclog::Event* event) {
+  RTC_DCHECK(stream_) << "No log has been opened.";
+  while (next_batch_event_ == batch_events_.size()) {
+    batch_events_.clear();
+    next_batch_event_ = 0;
+    if (!ReadNextMessage(event))
+      return false;
+    if (event->type() != rtclog::Event::RTP_PACKET_BATCH_EVENT)
+      return true;
+    // Columnar RTP packet batches are expanded into one RTP_EVENT per packet,
+    // so that logs in either encoding can be processed in the same way.
+    if (!DecodeRtpPacketBatch(*event, &batch_events_)) {
+      LOG(LS_WARNING) << "Failed to decode RTP packet batch.";
+      failed_ = true;
+      return false;
+    }
+  }
+  event->Swap(&batch_events_[next_batch_event_++]);
+  return true;
+}
+
+bool RtcEventLogReader::ReadNextMessage(rtclog::Event* event) {
+  if (failed_)
+    return false;
+
+  // Check whether we have reached end of file.
+  stream_->peek();
+  if (stream_->eof())
+    return false;
+
+  const uint64_t message_offset = position_;
+
+  // Read the next message tag. The tag number is defined as
+  // (fieldnumber << 3) | wire_type. In our case, the field number is
+  // supposed to be 1 and the wire type for an length-delimited field is 2.
+  const uint64_t kExpectedTag = (1 << 3) | 2;
+  uint64_t tag;
+  if (!ParseVarInt(*stream_, &tag, &position_)) {
+    LOG(LS_WARNING) << "Missing field tag from beginning of protobuf event.";
+    failed_ = true;
+    return false;
+  } else if (tag != kExpectedTag) {
+    LOG(LS_WARNING) << "Unexpected field tag at beginning of protobuf event.";
+    failed_ = true;
+    return false;
+  }
+
+  // Read the length field.
+  uint64_t message_length;
+  if (!ParseVarInt(*stream_, &message_length, &position_)) {
+    LOG(LS_WARNING) << "Missing message length after protobuf field tag.";
+    failed_ = true;
+    return false;
+  } else if (message_length > kMaxEventSize) {
+    LOG(LS_WARNING) << "Protobuf message length is too large.";
+    failed_ = true;
+    return false;
+  }
+
+  // Read the next protobuf event to a temporary char buffer.
+  stream_->read(buffer_.data(), message_length);
+  if (stream_->gcount() != static_cast<int>(message_length)) {
+    LOG(LS_WARNING) << "Failed to read protobuf message from file.";
+    failed_ = true;
+    return false;
+  }
+  position_ += message_length;
+
+  // Parse the protobuf event from the buffer.
+  if (!event->ParseFromArray(buffer_.data(), message_length)) {
+    LOG(LS_WARNING) << "Failed to parse protobuf message.";
+    failed_ = true;
+    return false;
+  }
+  event_offset_ = message_offset;
+  return true;
+}
+
+bool RtcEventLogReader::Seek(uint64_t offset) {
+  RTC_DCHECK(stream_) << "No log has been opened.";
+  stream_->clear();
+  stream_->seekg(offset);
+  if (stream_->fail()) {
+    LOG(LS_WARNING) << "Failed to seek in event log.";
+    failed_ = true;
+    return false;
+  }
+  position_ = offset;
+  failed_ = false;
+  batch_events_.clear();
+  next_batch_event_ = 0;
+  return true;
+}
+
+RtcEventLogIndex::RtcEventLogIndex() : log_size_(0) {}
+
+RtcEventLogIndex::~RtcEventLogIndex() = default;
+
+bool RtcEventLogIndex::Build(RtcEventLogReader* reader) {
+  type_offsets_.clear();
+  packet_offsets_.clear();
+  rtclog::Event event;
+  while (reader->ReadNextEvent(&event)) {
+    const uint64_t offset = reader->event_offset();
+    AddOffset(offset, &type_offsets_[event.type()]);
+    if (event.type() == rtclog::Event::RTP_EVENT &&
+        event.rtp_packet().header().size() >= 12) {
+      const rtclog::RtpPacket& packet = event.rtp_packet();
+      const uint32_t ssrc = ByteReader<uint32_t>::ReadBigEndian(
+          reinterpret_cast<const uint8_t*>(packet.header().data() + 8));
+      const PacketDirection direction =
+          packet.incoming() ? kIncomingPacket : kOutgoingPacket;
+      AddOffset(offset, &packet_offsets_[std::make_pair(ssrc, direction)]);
+    } else if (event.type() == rtclog::Event::RTCP_EVENT &&
+               event.rtcp_packet().packet_data().size() >= 8) {
+      const rtclog::RtcpPacket& packet = event.rtcp_packet();
+      const uint32_t sender_ssrc = ByteReader<uint32_t>::ReadBigEndian(
+          reinterpret_cast<const uint8_t*>(packet.packet_data().data() + 4));
+      const PacketDirection direction =
+          packet.incoming() ? kIncomingPacket : kOutgoingPacket;
+      AddOffset(offset,
+                &packet_offsets_[std::make_pair(sender_ssrc, direction)]);
+    }
+  }
+  log_size_ = reader->position();
+  return !reader->failed();
+}
+
+bool RtcEventLogIndex::WriteToFile(const std::string& file_name) const {
+  rtclog::EventLogIndex index;
+  index.set_log_size(log_size_);
+  for (const auto& type_and_offsets : type_offsets_) {
+    rtclog::EventLogIndex::TypeOffsets* type_offsets =
+        index.add_type_offsets();
+    type_offsets->set_type(type_and_offsets.first);
+    uint64_t previous_offset = 0;
+    for (uint64_t offset : type_and_offsets.second) {
+      type_offsets->add_offset_deltas(offset - previous_offset);
+      previous_offset = offset;
+    }
+  }
+  for (const auto& stream_and_offsets : packet_offsets_) {
+    rtclog::EventLogIndex::PacketOffsets* packet_offsets =
+        index.add_packet_offsets();
+    packet_offsets->set_ssrc(stream_and_offsets.first.first);
+    packet_offsets->set_incoming(stream_and_offsets.first.second ==
+                                 kIncomingPacket);
+    uint64_t previous_offset = 0;
+    for (uint64_t offset : stream_and_offsets.second) {
+      packet_offsets->add_offset_deltas(offset - previous_offset);
+      previous_offset = offset;
+    }
+  }
+
+  std::ofstream file(file_name, std::ios_base::out | std::ios_base::binary |
+                                    std::ios_base::trunc);
+  if (!file.good() || !file.is_open()) {
+    LOG(LS_WARNING) << "Could not open file for writing.";
+    return false;
+  }
+  ProtoString serialized;
+  index.SerializeToString(&serialized);
+  file.write(serialized.data(), serialized.size());
+  return file.good();
+}
+
+bool RtcEventLogIndex::ReadFromFile(const std::string& file_name) {
+  std::ifstream file(file_name, std::ios_base::in | std::ios_base::binary);
+  if (!file.good() || !file.is_open()) {
+    LOG(LS_WARNING) << "Could not open file for reading.";
+    return false;
+  }
+  const std::string serialized((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+  rtclog::EventLogIndex index;
+  if (!index.ParseFromString(serialized)) {
+    LOG(LS_WARNING) << "Failed to parse event log index.";
+    return false;
+  }
+
+  type_offsets_.clear();
+  packet_offsets_.clear();
+  log_size_ = index.log_size();
+  for (const auto& type_offsets : index.type_offsets()) {
+    std::vector<uint64_t>& offsets = type_offsets_[type_offsets.type()];
+    uint64_t offset = 0;
+    for (uint64_t delta : type_offsets.offset_deltas()) {
+      offset += delta;
+      offsets.push_back(offset);
+    }
+  }
+  for (const auto& packet_offsets : index.packet_offsets()) {
+    const PacketDirection direction =
+        packet_offsets.incoming() ? kIncomingPacket : kOutgoingPacket;
+    std::vector<uint64_t>& offsets =
+        packet_offsets_[std::make_pair(packet_offsets.ssrc(), direction)];
+    uint64_t offset = 0;
+    for (uint64_t delta : packet_offsets.offset_deltas()) {
+      offset += delta;
+      offsets.push_back(offset);
+    }
+  }
+  return true;
+}
+
+std::vector<uint64_t> RtcEventLogIndex::GetOffsets(
+    rtclog::Event::EventType type) const {
+  auto it = type_offsets_.find(type);
+  return it != type_offsets_.end() ? it->second : std::vector<uint64_t>();
+}
+
+std::vector<uint64_t> RtcEventLogIndex::GetPacketOffsets(
+    uint32_t ssrc,
+    PacketDirection direction) const {
+  auto it = packet_offsets_.find(std::make_pair(ssrc, direction));
+  return it != packet_offsets_.end() ? it->second : std::vector<uint64_t>();
+}
+
+void RtcEventLogIndex::AddOffset(uint64_t offset,
+                                 std::vector<uint64_t>* offsets) {
+  // The packets of an RTP packet batch share the offset of the batch.
+  if (offsets->empty() || offsets->back() != offset)
+    offsets->push_back(offset);
+}
+
+}  // namespace webrtc
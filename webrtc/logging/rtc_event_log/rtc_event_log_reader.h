@@ -0,0 +1,132 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+#ifndef WEBRTC_LOGGING_RTC_EVENT_LOG_RTC_EVENT_LOG_READER_H_
+#define WEBRTC_LOGGING_RTC_EVENT_LOG_RTC_EVENT_LOG_READER_H_
+
+#include <fstream>
+#include <istream>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "webrtc/logging/rtc_event_log/rtc_event_log.h"
+#include "webrtc/rtc_base/constructormagic.h"
+#include "webrtc/rtc_base/ignore_wundef.h"
+
+RTC_PUSH_IGNORING_WUNDEF()
+#ifdef WEBRTC_ANDROID_PLATFORM_BUILD
+#include "external/webrtc/webrtc/logging/rtc_event_log/rtc_event_log.pb.h"
+#else
+#include "webrtc/logging/rtc_event_log/rtc_event_log.pb.h"
+#endif
+RTC_POP_IGNORING_WUNDEF()
+
+namespace webrtc {
+
+// Reads the events of an RtcEventLog one at a time. Unlike ParsedRtcEventLog,
+// which keeps every event in memory, the reader only holds the event being
+// read (or, for RTP packet batches, the packets of one batch), so arbitrarily
+// large logs can be processed in a single pass with bounded memory.
+class RtcEventLogReader {
+ public:
+  RtcEventLogReader();
+  ~RtcEventLogReader();
+
+  // Opens |file_name| for reading. Returns false if the file can't be opened.
+  bool OpenFile(const std::string& file_name);
+
+  // Reads from |stream|, which must outlive the reader.
+  void OpenStream(std::istream* stream);
+
+  // Reads the next event into |event|. RTP packet batches are expanded into
+  // one RTP_EVENT per packet. Returns false at the end of the log or if the
+  // log is malformed; use failed() to tell the two cases apart.
+  bool ReadNextEvent(rtclog::Event* event);
+
+  // True if reading stopped because the log is malformed.
+  bool failed() const { return failed_; }
+
+  // Byte offset of the message that the last event returned by
+  // ReadNextEvent() was read from. Events expanded from the same RTP packet
+  // batch share the offset of the batch.
+  uint64_t event_offset() const { return event_offset_; }
+
+  // Number of bytes consumed from the log so far.
+  uint64_t position() const { return position_; }
+
+  // Continues reading at |offset|, which must be the offset of a message, as
+  // returned by event_offset() or stored in an RtcEventLogIndex. Requires a
+  // seekable stream. Returns false if seeking failed.
+  bool Seek(uint64_t offset);
+
+ private:
+  bool ReadNextMessage(rtclog::Event* event);
+
+  std::unique_ptr<std::ifstream> file_;
+  std::istream* stream_;
+  std::vector<char> buffer_;
+  uint64_t position_;
+  uint64_t event_offset_;
+  bool failed_;
+
+  // Packets of the most recently read RTP packet batch that have not yet been
+  // returned by ReadNextEvent().
+  std::vector<rtclog::Event> batch_events_;
+  size_t next_batch_event_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(RtcEventLogReader);
+};
+
+// Byte offsets of the messages in an event log, grouped by event type and, for
+// RTP and RTCP packets, by SSRC and direction. The index is built in one pass
+// over the log and can be stored next to it, so that later runs can seek
+// straight to the parts of the log they need.
+class RtcEventLogIndex {
+ public:
+  RtcEventLogIndex();
+  ~RtcEventLogIndex();
+
+  // Indexes all events from the current position of |reader| to the end of
+  // the log. Returns false if the log is malformed.
+  bool Build(RtcEventLogReader* reader);
+
+  bool WriteToFile(const std::string& file_name) const;
+
+  // Reads an index written by WriteToFile(). Returns false if the file can't
+  // be read or parsed.
+  bool ReadFromFile(const std::string& file_name);
+
+  // Size in bytes of the indexed part of the log. Can be compared with the
+  // size of a log file to detect a stale index.
+  uint64_t log_size() const { return log_size_; }
+
+  // Offsets, in increasing order, of the messages containing events of type
+  // |type|. RTP packet batches are indexed as RTP_EVENT.
+  std::vector<uint64_t> GetOffsets(rtclog::Event::EventType type) const;
+
+  // Offsets, in increasing order, of the messages containing RTP packets with
+  // SSRC |ssrc| or RTCP packets with sender SSRC |ssrc|.
+  std::vector<uint64_t> GetPacketOffsets(uint32_t ssrc,
+                                         PacketDirection direction) const;
+
+ private:
+  static void AddOffset(uint64_t offset, std::vector<uint64_t>* offsets);
+
+  uint64_t log_size_;
+  std::map<rtclog::Event::EventType, std::vector<uint64_t>> type_offsets_;
+  std::map<std::pair<uint32_t, PacketDirection>, std::vector<uint64_t>>
+      packet_offsets_;
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_LOGGING_RTC_EVENT_LOG_RTC_EVENT_LOG_READER_H_
@@ -0,0 +1,259 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/logging/rtc_event_log/rtc_event_log_reader.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "webrtc/logging/rtc_event_log/rtc_event_log_parser.h"
+#include "webrtc/logging/rtc_event_log/rtp_packet_batch.h"
+#include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
+#include "webrtc/modules/rtp_rtcp/source/byte_io.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/fileutils.h"
+
+namespace webrtc {
+
+namespace {
+
+constexpr uint32_t kAudioSsrc = 0x11111111;
+constexpr uint32_t kVideoSsrc = 0x22222222;
+constexpr size_t kRtpHeaderSize = 12;
+constexpr size_t kNumBatchedPackets = 10;
+
+void AppendEvent(const rtclog::Event& event, std::string* log) {
+  rtclog::EventStream event_stream;
+  event_stream.add_stream()->CopyFrom(event);
+  log->append(event_stream.SerializeAsString());
+}
+
+rtclog::Event CreateEvent(rtclog::Event::EventType type, int64_t timestamp_us) {
+  rtclog::Event event;
+  event.set_timestamp_us(timestamp_us);
+  event.set_type(type);
+  return event;
+}
+
+std::string CreateRtpHeader(uint32_t ssrc, uint16_t sequence_number) {
+  uint8_t header[kRtpHeaderSize] = {0x80, 96};
+  ByteWriter<uint16_t>::WriteBigEndian(header + 2, sequence_number);
+  ByteWriter<uint32_t>::WriteBigEndian(header + 4, sequence_number * 960);
+  ByteWriter<uint32_t>::WriteBigEndian(header + 8, ssrc);
+  return std::string(reinterpret_cast<const char*>(header), kRtpHeaderSize);
+}
+
+rtclog::Event CreateRtpEvent(uint32_t ssrc,
+                             uint16_t sequence_number,
+                             int64_t timestamp_us) {
+  rtclog::Event event = CreateEvent(rtclog::Event::RTP_EVENT, timestamp_us);
+  rtclog::RtpPacket* rtp_packet = event.mutable_rtp_packet();
+  rtp_packet->set_incoming(true);
+  rtp_packet->set_packet_length(kRtpHeaderSize + 100);
+  rtp_packet->set_header(CreateRtpHeader(ssrc, sequence_number));
+  return event;
+}
+
+rtclog::Event CreateRtpBatchEvent(uint32_t ssrc, int64_t timestamp_us) {
+  std::vector<RtcEventRecord> records(kNumBatchedPackets);
+  for (size_t i = 0; i < records.size(); ++i) {
+    RtcEventRecord& record = records[i];
+    record.timestamp_us = timestamp_us + i;
+    record.type = RtcEventRecord::Type::kRtpHeader;
+    record.rtp.incoming = true;
+    record.rtp.header_length = kRtpHeaderSize;
+    record.rtp.probe_cluster_id = PacedPacketInfo::kNotAProbe;
+    record.rtp.packet_length = kRtpHeaderSize + 1000;
+    const std::string header = CreateRtpHeader(ssrc, 1000 + i);
+    memcpy(record.rtp.header, header.data(), header.size());
+  }
+  rtclog::Event event;
+  EncodeRtpPacketBatch(records, &event);
+  return event;
+}
+
+rtclog::Event CreateRtcpEvent(uint32_t sender_ssrc, int64_t timestamp_us) {
+  rtclog::Event event = CreateEvent(rtclog::Event::RTCP_EVENT, timestamp_us);
+  uint8_t packet[8] = {0x80, 201, 0, 1};
+  ByteWriter<uint32_t>::WriteBigEndian(packet + 4, sender_ssrc);
+  event.mutable_rtcp_packet()->set_incoming(true);
+  event.mutable_rtcp_packet()->set_packet_data(
+      std::string(reinterpret_cast<const char*>(packet), sizeof(packet)));
+  return event;
+}
+
+rtclog::Event CreateAudioReceiveConfigEvent(uint32_t ssrc) {
+  rtclog::Event event =
+      CreateEvent(rtclog::Event::AUDIO_RECEIVER_CONFIG_EVENT, 0);
+  event.mutable_audio_receiver_config()->set_remote_ssrc(ssrc);
+  event.mutable_audio_receiver_config()->set_local_ssrc(ssrc + 1);
+  return event;
+}
+
+// Log with a config event, a few RTP packets in both encodings and an RTCP
+// packet. Contains 6 messages and 15 events.
+std::string CreateLog() {
+  std::string log;
+  AppendEvent(CreateEvent(rtclog::Event::LOG_START, 0), &log);
+  AppendEvent(CreateAudioReceiveConfigEvent(kAudioSsrc), &log);
+  AppendEvent(CreateRtpEvent(kAudioSsrc, 1, 10), &log);
+  AppendEvent(CreateRtpBatchEvent(kVideoSsrc, 20), &log);
+  AppendEvent(CreateRtcpEvent(kVideoSsrc, 40), &log);
+  AppendEvent(CreateEvent(rtclog::Event::LOG_END, 50), &log);
+  return log;
+}
+
+}  // namespace
+
+TEST(RtcEventLogReaderTest, ReadsEventsInLogOrder) {
+  std::istringstream stream(CreateLog());
+  RtcEventLogReader reader;
+  reader.OpenStream(&stream);
+
+  const std::vector<rtclog::Event::EventType> expected_types = {
+      rtclog::Event::LOG_START, rtclog::Event::AUDIO_RECEIVER_CONFIG_EVENT,
+      rtclog::Event::RTP_EVENT};
+  rtclog::Event event;
+  for (rtclog::Event::EventType expected_type : expected_types) {
+    ASSERT_TRUE(reader.ReadNextEvent(&event));
+    EXPECT_EQ(expected_type, event.type());
+  }
+
+  // The packets of the batch are returned one by one and share an offset.
+  uint64_t batch_offset = 0;
+  for (size_t i = 0; i < kNumBatchedPackets; ++i) {
+    ASSERT_TRUE(reader.ReadNextEvent(&event));
+    ASSERT_EQ(rtclog::Event::RTP_EVENT, event.type());
+    EXPECT_EQ(static_cast<int64_t>(20 + i), event.timestamp_us());
+    if (i == 0)
+      batch_offset = reader.event_offset();
+    EXPECT_EQ(batch_offset, reader.event_offset());
+  }
+
+  ASSERT_TRUE(reader.ReadNextEvent(&event));
+  EXPECT_EQ(rtclog::Event::RTCP_EVENT, event.type());
+  EXPECT_GT(reader.event_offset(), batch_offset);
+  ASSERT_TRUE(reader.ReadNextEvent(&event));
+  EXPECT_EQ(rtclog::Event::LOG_END, event.type());
+  EXPECT_FALSE(reader.ReadNextEvent(&event));
+  EXPECT_FALSE(reader.failed());
+  EXPECT_EQ(CreateLog().size(), reader.position());
+}
+
+TEST(RtcEventLogReaderTest, FailsOnTruncatedLog) {
+  std::string log = CreateLog();
+  log.resize(log.size() - 3);
+  std::istringstream stream(log);
+  RtcEventLogReader reader;
+  reader.OpenStream(&stream);
+
+  rtclog::Event event;
+  size_t events_read = 0;
+  while (reader.ReadNextEvent(&event))
+    ++events_read;
+  EXPECT_TRUE(reader.failed());
+  EXPECT_EQ(3 + kNumBatchedPackets + 1, events_read);
+}
+
+TEST(RtcEventLogReaderTest, SeeksToIndexedPackets) {
+  std::istringstream stream(CreateLog());
+  RtcEventLogReader reader;
+  reader.OpenStream(&stream);
+  RtcEventLogIndex index;
+  ASSERT_TRUE(index.Build(&reader));
+  EXPECT_EQ(CreateLog().size(), index.log_size());
+
+  EXPECT_EQ(1u, index.GetOffsets(rtclog::Event::LOG_START).size());
+  EXPECT_EQ(2u, index.GetOffsets(rtclog::Event::RTP_EVENT).size());
+  EXPECT_TRUE(index.GetOffsets(rtclog::Event::AUDIO_PLAYOUT_EVENT).empty());
+  EXPECT_TRUE(index.GetPacketOffsets(kAudioSsrc, kOutgoingPacket).empty());
+
+  // One message for the RTP packet batch and one for the RTCP packet.
+  const std::vector<uint64_t> video_offsets =
+      index.GetPacketOffsets(kVideoSsrc, kIncomingPacket);
+  ASSERT_EQ(2u, video_offsets.size());
+  rtclog::Event event;
+  ASSERT_TRUE(reader.Seek(video_offsets[0]));
+  for (size_t i = 0; i < kNumBatchedPackets; ++i) {
+    ASSERT_TRUE(reader.ReadNextEvent(&event));
+    ASSERT_EQ(rtclog::Event::RTP_EVENT, event.type());
+    EXPECT_EQ(kVideoSsrc,
+              ByteReader<uint32_t>::ReadBigEndian(reinterpret_cast<
+                  const uint8_t*>(event.rtp_packet().header().data() + 8)));
+  }
+  ASSERT_TRUE(reader.Seek(video_offsets[1]));
+  ASSERT_TRUE(reader.ReadNextEvent(&event));
+  EXPECT_EQ(rtclog::Event::RTCP_EVENT, event.type());
+
+  const std::vector<uint64_t> audio_offsets =
+      index.GetPacketOffsets(kAudioSsrc, kIncomingPacket);
+  ASSERT_EQ(1u, audio_offsets.size());
+  ASSERT_TRUE(reader.Seek(audio_offsets[0]));
+  ASSERT_TRUE(reader.ReadNextEvent(&event));
+  EXPECT_EQ(10, event.timestamp_us());
+}
+
+TEST(RtcEventLogReaderTest, IndexRoundTripsThroughFile) {
+  std::istringstream stream(CreateLog());
+  RtcEventLogReader reader;
+  reader.OpenStream(&stream);
+  RtcEventLogIndex index;
+  ASSERT_TRUE(index.Build(&reader));
+
+  const std::string index_file_name =
+      test::TempFilename(test::OutputPath(), "rtc_event_log_index");
+  ASSERT_TRUE(index.WriteToFile(index_file_name));
+  RtcEventLogIndex read_index;
+  ASSERT_TRUE(read_index.ReadFromFile(index_file_name));
+  remove(index_file_name.c_str());
+
+  EXPECT_EQ(index.log_size(), read_index.log_size());
+  for (rtclog::Event::EventType type :
+       {rtclog::Event::LOG_START, rtclog::Event::RTP_EVENT,
+        rtclog::Event::RTCP_EVENT, rtclog::Event::LOG_END}) {
+    EXPECT_EQ(index.GetOffsets(type), read_index.GetOffsets(type));
+  }
+  EXPECT_EQ(index.GetPacketOffsets(kVideoSsrc, kIncomingPacket),
+            read_index.GetPacketOffsets(kVideoSsrc, kIncomingPacket));
+  EXPECT_EQ(index.GetPacketOffsets(kAudioSsrc, kIncomingPacket),
+            read_index.GetPacketOffsets(kAudioSsrc, kIncomingPacket));
+}
+
+TEST(RtcEventLogReaderTest, ParseIncrementallyTracksStreamConfigs) {
+  std::istringstream stream(CreateLog());
+  RtcEventLogReader reader;
+  reader.OpenStream(&stream);
+
+  ParsedRtcEventLog parsed_log;
+  size_t num_events = 0;
+  size_t num_audio_packets = 0;
+  EXPECT_TRUE(parsed_log.ParseIncrementally(
+      &reader, [&](const rtclog::Event& event) {
+        ++num_events;
+        if (event.type() != rtclog::Event::RTP_EVENT)
+          return;
+        const uint32_t ssrc = ByteReader<uint32_t>::ReadBigEndian(
+            reinterpret_cast<const uint8_t*>(
+                event.rtp_packet().header().data() + 8));
+        if (parsed_log.GetMediaType(ssrc, kIncomingPacket) ==
+            ParsedRtcEventLog::MediaType::AUDIO) {
+          ++num_audio_packets;
+        }
+      }));
+  EXPECT_EQ(4 + kNumBatchedPackets + 1, num_events);
+  EXPECT_EQ(1u, num_audio_packets);
+  EXPECT_EQ(0u, parsed_log.GetNumberOfEvents());
+}
+
+}  // namespace webrtc
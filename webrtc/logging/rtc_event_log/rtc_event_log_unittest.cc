@@ -21,6 +21,8 @@
 #include "webrtc/modules/audio_coding/audio_network_adaptor/include/audio_network_adaptor.h"
 #include "webrtc/modules/remote_bitrate_estimator/include/bwe_defines.h"
 #include "webrtc/modules/rtp_rtcp/include/rtp_header_extension_map.h"
+#include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
+#include "webrtc/modules/rtp_rtcp/source/byte_io.h"
 #include "webrtc/modules/rtp_rtcp/source/rtcp_packet.h"
 #include "webrtc/modules/rtp_rtcp/source/rtcp_packet/sender_report.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_header_extensions.h"
@@ -486,6 +488,83 @@ TEST(RtcEventLogTest, LogEventAndReadBack) {
   remove(temp_filename.c_str());
 }
 
+TEST(RtcEventLogTest, LogRtpPacketsWithColumnarEncodingAndReadBack) {
+  Random prng(24680);
+  const uint32_t kSsrcs[] = {prng.Rand<uint32_t>(), prng.Rand<uint32_t>()};
+  const size_t kNumPackets = 200;
+
+  RtpHeaderExtensionMap extensions;
+  for (unsigned i = 0; i < kNumExtensions; i++)
+    extensions.Register(kExtensionTypes[i], i + 1);
+
+  std::vector<RtpPacketToSend> rtp_packets;
+  for (size_t i = 0; i < kNumPackets; i++) {
+    rtp_packets.push_back(GenerateRtpPacket(&extensions, i % 3,
+                                            prng.Rand(100, 1000), &prng));
+    rtp_packets.back().SetSsrc(kSsrcs[i % 2]);
+  }
+  rtc::Buffer rtcp_packet = GenerateRtcpPacket(&prng);
+
+  auto test_info = ::testing::UnitTest::GetInstance()->current_test_info();
+  const std::string temp_filename =
+      test::OutputPath() + test_info->test_case_name() + test_info->name();
+
+  rtc::ScopedFakeClock fake_clock;
+  fake_clock.SetTimeMicros(prng.Rand<uint32_t>());
+  std::unique_ptr<RtcEventLog> log_dumper(
+      RtcEventLog::Create(RtcEventLog::EncodingType::kColumnarRtp));
+  log_dumper->StartLogging(temp_filename, 10000000);
+  for (size_t i = 0; i < kNumPackets; i++) {
+    log_dumper->LogRtpHeader(kOutgoingPacket, rtp_packets[i].data(),
+                             rtp_packets[i].size());
+    fake_clock.AdvanceTimeMicros(prng.Rand(1, 1000));
+    if (i == kNumPackets / 2) {
+      log_dumper->LogRtcpPacket(kIncomingPacket, rtcp_packet.data(),
+                                rtcp_packet.size());
+    }
+  }
+  log_dumper->StopLogging();
+
+  ParsedRtcEventLog parsed_log;
+  ASSERT_TRUE(parsed_log.ParseFile(temp_filename));
+
+  // The parser expands the batches into one RTP event per packet. Packets
+  // with the same SSRC keep their relative order, but are not necessarily
+  // interleaved with other events in the order they were logged.
+  ASSERT_EQ(kNumPackets + 3, parsed_log.GetNumberOfEvents());
+  RtcEventLogTestHelper::VerifyLogStartEvent(parsed_log, 0);
+  RtcEventLogTestHelper::VerifyLogEndEvent(parsed_log, kNumPackets + 2);
+  std::vector<size_t> next_packet_index = {0, 1};
+  size_t rtcp_events = 0;
+  for (size_t index = 1; index < kNumPackets + 2; index++) {
+    if (parsed_log.GetEventType(index) == ParsedRtcEventLog::RTCP_EVENT) {
+      RtcEventLogTestHelper::VerifyRtcpEvent(parsed_log, index,
+                                             kIncomingPacket,
+                                             rtcp_packet.data(),
+                                             rtcp_packet.size());
+      rtcp_events++;
+      continue;
+    }
+    uint8_t header[IP_PACKET_SIZE];
+    parsed_log.GetRtpHeader(index, nullptr, header, nullptr, nullptr);
+    const uint32_t ssrc = ByteReader<uint32_t>::ReadBigEndian(header + 8);
+    const size_t stream = ssrc == kSsrcs[0] ? 0 : 1;
+    ASSERT_EQ(kSsrcs[stream], ssrc);
+    const size_t i = next_packet_index[stream];
+    ASSERT_LT(i, kNumPackets);
+    RtcEventLogTestHelper::VerifyRtpEvent(
+        parsed_log, index, kOutgoingPacket, rtp_packets[i].data(),
+        rtp_packets[i].headers_size(), rtp_packets[i].size());
+    next_packet_index[stream] += 2;
+  }
+  EXPECT_EQ(1u, rtcp_events);
+  EXPECT_EQ(kNumPackets, next_packet_index[0]);
+  EXPECT_EQ(kNumPackets + 1, next_packet_index[1]);
+
+  // Clean up temporary file - can be pretty slow.
+  remove(temp_filename.c_str());
+}
+
 TEST(RtcEventLogTest, LogLossBasedBweUpdateAndReadBack) {
   Random prng(1234);
 
@@ -147,6 +147,13 @@ rtclog::BweProbeResult::ResultType GetProbeResultType(
            << "Event of type " << type << " has "
            << (event.has_probe_result() ? "" : "no ") << "bwe probe result";
   }
+  if ((type == rtclog::Event::RTP_PACKET_BATCH_EVENT) !=
+      event.has_rtp_packet_batch()) {
+    return ::testing::AssertionFailure()
+           << "Event of type " << type << " has "
+           << (event.has_rtp_packet_batch() ? "" : "no ")
+           << "rtp packet batch";
+  }
   return ::testing::AssertionSuccess();
 }
 
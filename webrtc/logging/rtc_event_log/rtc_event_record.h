@@ -0,0 +1,92 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_LOGGING_RTC_EVENT_LOG_RTC_EVENT_RECORD_H_
+#define WEBRTC_LOGGING_RTC_EVENT_LOG_RTC_EVENT_RECORD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "webrtc/logging/rtc_event_log/rtc_event_log.h"
+#include "webrtc/modules/remote_bitrate_estimator/include/bwe_defines.h"
+
+namespace webrtc {
+
+// Compact, fixed-size representation of the high-frequency events logged by
+// RtcEventLogImpl (RTP headers, BWE updates, probes and audio playouts).
+// Records are trivially copyable so that they can be written into a
+// pre-allocated ring buffer from any thread without allocating, and are only
+// encoded as rtclog::Event protobufs when they are written to a file.
+struct RtcEventRecord {
+  enum class Type : uint8_t {
+    kRtpHeader,
+    kAudioPlayout,
+    kLossBasedBweUpdate,
+    kDelayBasedBweUpdate,
+    kProbeClusterCreated,
+    kProbeResult,
+  };
+
+  // RTP headers longer than this (i.e. with unusually many CSRCs or header
+  // extensions) are logged through the regular protobuf path instead.
+  static constexpr size_t kMaxRtpHeaderLength = 64;
+
+  struct RtpHeader {
+    bool incoming;
+    uint8_t header_length;
+    int32_t probe_cluster_id;
+    uint32_t packet_length;
+    uint8_t header[kMaxRtpHeaderLength];
+  };
+
+  struct AudioPlayout {
+    uint32_t ssrc;
+  };
+
+  struct LossBasedBweUpdate {
+    int32_t bitrate_bps;
+    uint8_t fraction_loss;
+    int32_t total_packets;
+  };
+
+  struct DelayBasedBweUpdate {
+    int32_t bitrate_bps;
+    BandwidthUsage detector_state;
+  };
+
+  struct ProbeClusterCreated {
+    int32_t id;
+    int32_t bitrate_bps;
+    int32_t min_packets;
+    int32_t min_bytes;
+  };
+
+  struct ProbeResult {
+    int32_t id;
+    bool success;
+    ProbeFailureReason failure_reason;
+    int32_t bitrate_bps;
+  };
+
+  int64_t timestamp_us;
+  Type type;
+  union {
+    RtpHeader rtp;
+    AudioPlayout audio_playout;
+    LossBasedBweUpdate loss_based_bwe_update;
+    DelayBasedBweUpdate delay_based_bwe_update;
+    ProbeClusterCreated probe_cluster;
+    ProbeResult probe_result;
+  };
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_LOGGING_RTC_EVENT_LOG_RTC_EVENT_RECORD_H_
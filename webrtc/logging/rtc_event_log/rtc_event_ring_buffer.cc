@@ -0,0 +1,85 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/logging/rtc_event_log/rtc_event_ring_buffer.h"
+
+#include "webrtc/rtc_base/checks.h"
+
+namespace webrtc {
+
+namespace {
+size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value)
+    result <<= 1;
+  return result;
+}
+}  // namespace
+
+RtcEventRingBuffer::RtcEventRingBuffer(size_t capacity)
+    : mask_(RoundUpToPowerOfTwo(capacity) - 1),
+      slots_(new Slot[mask_ + 1]),
+      write_position_(0),
+      read_position_(0) {
+  RTC_DCHECK_GT(capacity, 0);
+  for (size_t i = 0; i <= mask_; ++i)
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+RtcEventRingBuffer::~RtcEventRingBuffer() = default;
+
+bool RtcEventRingBuffer::Push(const RtcEventRecord& record) {
+  Slot* slot;
+  size_t position = write_position_.load(std::memory_order_relaxed);
+  while (true) {
+    slot = &slots_[position & mask_];
+    const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const intptr_t diff =
+        static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+    if (diff == 0) {
+      // The slot is free; try to claim it.
+      if (write_position_.compare_exchange_weak(position, position + 1,
+                                                std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The slot still holds a record from the previous lap.
+      return false;
+    } else {
+      // Another producer claimed the slot first.
+      position = write_position_.load(std::memory_order_relaxed);
+    }
+  }
+  slot->record = record;
+  slot->sequence.store(position + 1, std::memory_order_release);
+  return true;
+}
+
+bool RtcEventRingBuffer::Pop(RtcEventRecord* record) {
+  const size_t position = read_position_.load(std::memory_order_relaxed);
+  Slot* slot = &slots_[position & mask_];
+  const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+  if (sequence != position + 1) {
+    // Empty, or the producer of the oldest record has not finished writing.
+    return false;
+  }
+  *record = slot->record;
+  slot->sequence.store(position + mask_ + 1, std::memory_order_release);
+  read_position_.store(position + 1, std::memory_order_relaxed);
+  return true;
+}
+
+size_t RtcEventRingBuffer::size() const {
+  const size_t read = read_position_.load(std::memory_order_relaxed);
+  const size_t write = write_position_.load(std::memory_order_relaxed);
+  return write >= read ? write - read : 0;
+}
+
+}  // namespace webrtc
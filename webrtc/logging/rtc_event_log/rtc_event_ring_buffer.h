@@ -0,0 +1,62 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_LOGGING_RTC_EVENT_LOG_RTC_EVENT_RING_BUFFER_H_
+#define WEBRTC_LOGGING_RTC_EVENT_LOG_RTC_EVENT_RING_BUFFER_H_
+
+#include <atomic>
+#include <memory>
+
+#include "webrtc/logging/rtc_event_log/rtc_event_record.h"
+#include "webrtc/rtc_base/constructormagic.h"
+
+namespace webrtc {
+
+// Bounded, pre-allocated queue of RtcEventRecords. Any number of threads may
+// call Push() concurrently without taking a lock; Pop() must only be called
+// from a single consumer (the event log's task queue). Each slot carries a
+// sequence number that tells producers and the consumer whether the slot is
+// free, being written, or ready to be read.
+class RtcEventRingBuffer {
+ public:
+  // |capacity| is rounded up to the nearest power of two.
+  explicit RtcEventRingBuffer(size_t capacity);
+  ~RtcEventRingBuffer();
+
+  // Copies |record| into the buffer. Returns false, leaving the buffer
+  // unchanged, if the buffer is full.
+  bool Push(const RtcEventRecord& record);
+
+  // Moves the oldest record into |record|. Returns false if the buffer is
+  // empty. Not thread safe with respect to other calls to Pop().
+  bool Pop(RtcEventRecord* record);
+
+  // Approximate number of records in the buffer; may be stale as soon as it
+  // is returned if other threads are pushing concurrently.
+  size_t size() const;
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    RtcEventRecord record;
+  };
+
+  const size_t mask_;
+  const std::unique_ptr<Slot[]> slots_;
+  std::atomic<size_t> write_position_;
+  std::atomic<size_t> read_position_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(RtcEventRingBuffer);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_LOGGING_RTC_EVENT_LOG_RTC_EVENT_RING_BUFFER_H_
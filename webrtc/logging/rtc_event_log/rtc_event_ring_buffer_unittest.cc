@@ -0,0 +1,124 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/logging/rtc_event_log/rtc_event_ring_buffer.h"
+
+#include <memory>
+#include <vector>
+
+#include "webrtc/rtc_base/platform_thread.h"
+#include "webrtc/system_wrappers/include/sleep.h"
+#include "webrtc/test/gtest.h"
+
+namespace webrtc {
+
+namespace {
+
+RtcEventRecord CreatePlayoutRecord(uint32_t ssrc, int64_t timestamp_us) {
+  RtcEventRecord record;
+  record.timestamp_us = timestamp_us;
+  record.type = RtcEventRecord::Type::kAudioPlayout;
+  record.audio_playout.ssrc = ssrc;
+  return record;
+}
+
+constexpr int kNumProducers = 4;
+constexpr int kRecordsPerProducer = 10000;
+
+struct ProducerContext {
+  RtcEventRingBuffer* buffer;
+  uint32_t ssrc;
+};
+
+void ProduceRecords(void* obj) {
+  ProducerContext* context = static_cast<ProducerContext*>(obj);
+  for (int i = 0; i < kRecordsPerProducer; ++i) {
+    const RtcEventRecord record = CreatePlayoutRecord(context->ssrc, i);
+    while (!context->buffer->Push(record)) {
+      SleepMs(1);
+    }
+  }
+}
+
+}  // namespace
+
+TEST(RtcEventRingBufferTest, CapacityIsRoundedUpToPowerOfTwo) {
+  RtcEventRingBuffer buffer(100);
+  EXPECT_EQ(128u, buffer.capacity());
+  EXPECT_EQ(0u, buffer.size());
+}
+
+TEST(RtcEventRingBufferTest, PopsRecordsInPushOrder) {
+  RtcEventRingBuffer buffer(8);
+  for (uint32_t i = 0; i < 5; ++i)
+    EXPECT_TRUE(buffer.Push(CreatePlayoutRecord(i, 1000 + i)));
+  EXPECT_EQ(5u, buffer.size());
+
+  RtcEventRecord record;
+  for (uint32_t i = 0; i < 5; ++i) {
+    ASSERT_TRUE(buffer.Pop(&record));
+    EXPECT_EQ(RtcEventRecord::Type::kAudioPlayout, record.type);
+    EXPECT_EQ(i, record.audio_playout.ssrc);
+    EXPECT_EQ(1000 + i, record.timestamp_us);
+  }
+  EXPECT_FALSE(buffer.Pop(&record));
+}
+
+TEST(RtcEventRingBufferTest, PushFailsWhenFull) {
+  RtcEventRingBuffer buffer(4);
+  for (uint32_t i = 0; i < 4; ++i)
+    EXPECT_TRUE(buffer.Push(CreatePlayoutRecord(i, i)));
+  EXPECT_FALSE(buffer.Push(CreatePlayoutRecord(4, 4)));
+
+  // Freeing one slot makes room for exactly one more record.
+  RtcEventRecord record;
+  ASSERT_TRUE(buffer.Pop(&record));
+  EXPECT_EQ(0u, record.audio_playout.ssrc);
+  EXPECT_TRUE(buffer.Push(CreatePlayoutRecord(5, 5)));
+  EXPECT_FALSE(buffer.Push(CreatePlayoutRecord(6, 6)));
+
+  for (uint32_t expected_ssrc : {1u, 2u, 3u, 5u}) {
+    ASSERT_TRUE(buffer.Pop(&record));
+    EXPECT_EQ(expected_ssrc, record.audio_playout.ssrc);
+  }
+  EXPECT_FALSE(buffer.Pop(&record));
+}
+
+TEST(RtcEventRingBufferTest, ConcurrentProducersKeepPerThreadOrder) {
+  RtcEventRingBuffer buffer(256);
+  std::vector<ProducerContext> contexts(kNumProducers);
+  std::vector<std::unique_ptr<rtc::PlatformThread>> threads;
+  for (int i = 0; i < kNumProducers; ++i) {
+    contexts[i] = {&buffer, static_cast<uint32_t>(i)};
+    threads.emplace_back(new rtc::PlatformThread(
+        &ProduceRecords, &contexts[i], "ring_buffer_producer"));
+    threads.back()->Start();
+  }
+
+  std::vector<int64_t> next_timestamp(kNumProducers, 0);
+  int received = 0;
+  RtcEventRecord record;
+  while (received < kNumProducers * kRecordsPerProducer) {
+    if (!buffer.Pop(&record)) {
+      SleepMs(1);
+      continue;
+    }
+    ASSERT_LT(record.audio_playout.ssrc, static_cast<uint32_t>(kNumProducers));
+    EXPECT_EQ(next_timestamp[record.audio_playout.ssrc], record.timestamp_us);
+    next_timestamp[record.audio_playout.ssrc] = record.timestamp_us + 1;
+    ++received;
+  }
+
+  for (auto& thread : threads)
+    thread->Stop();
+  EXPECT_FALSE(buffer.Pop(&record));
+}
+
+}  // namespace webrtc
@@ -0,0 +1,342 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/logging/rtc_event_log/rtp_packet_batch.h"
+
+#include <string.h>
+
+#include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
+#include "webrtc/modules/rtp_rtcp/source/byte_io.h"
+#include "webrtc/rtc_base/checks.h"
+#include "webrtc/rtc_base/ignore_wundef.h"
+#include "webrtc/rtc_base/protobuf_utils.h"
+
+// *.pb.h files are generated at build-time by the protobuf compiler.
+RTC_PUSH_IGNORING_WUNDEF()
+#ifdef WEBRTC_ANDROID_PLATFORM_BUILD
+#include "external/webrtc/webrtc/logging/rtc_event_log/rtc_event_log.pb.h"
+#else
+#include "webrtc/logging/rtc_event_log/rtc_event_log.pb.h"
+#endif
+RTC_POP_IGNORING_WUNDEF()
+
+namespace webrtc {
+
+namespace {
+
+constexpr size_t kFixedHeaderLength = 12;
+
+void WriteVarInt(uint64_t value, ProtoString* output) {
+  while (value >= 0x80) {
+    output->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  output->push_back(static_cast<char>(value));
+}
+
+uint64_t ZigZagEncode(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t ZigZagDecode(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void WriteSignedVarInt(int64_t value, ProtoString* output) {
+  WriteVarInt(ZigZagEncode(value), output);
+}
+
+// Sequential reader for one column of a batch.
+class ColumnReader {
+ public:
+  explicit ColumnReader(const ProtoString& column) : column_(column) {}
+
+  bool ReadVarInt(uint64_t* value) {
+    *value = 0;
+    for (size_t shift = 0; shift < 64 && position_ < column_.size();
+         shift += 7) {
+      const uint8_t byte = static_cast<uint8_t>(column_[position_++]);
+      *value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0)
+        return true;
+    }
+    return false;
+  }
+
+  bool ReadSignedVarInt(int64_t* value) {
+    uint64_t encoded;
+    if (!ReadVarInt(&encoded))
+      return false;
+    *value = ZigZagDecode(encoded);
+    return true;
+  }
+
+  bool ReadBytes(size_t length, uint8_t* destination) {
+    if (length > column_.size() - position_)
+      return false;
+    memcpy(destination, column_.data() + position_, length);
+    position_ += length;
+    return true;
+  }
+
+ private:
+  const ProtoString& column_;
+  size_t position_ = 0;
+};
+
+// Writes |length| bytes of |tail| XORed with |previous_tail| (zero-extended
+// to |previous_length|) as alternating runs of zero and literal bytes.
+void WriteHeaderTail(const uint8_t* tail,
+                     size_t length,
+                     const uint8_t* previous_tail,
+                     size_t previous_length,
+                     ProtoString* output) {
+  size_t i = 0;
+  while (i < length) {
+    size_t zeros = 0;
+    while (i + zeros < length &&
+           tail[i + zeros] ==
+               (i + zeros < previous_length ? previous_tail[i + zeros] : 0)) {
+      ++zeros;
+    }
+    WriteVarInt(zeros, output);
+    i += zeros;
+    if (i == length)
+      break;
+    size_t literals = 0;
+    while (i + literals < length &&
+           tail[i + literals] != (i + literals < previous_length
+                                      ? previous_tail[i + literals]
+                                      : 0)) {
+      ++literals;
+    }
+    WriteVarInt(literals, output);
+    for (size_t j = i; j < i + literals; ++j) {
+      const uint8_t previous = j < previous_length ? previous_tail[j] : 0;
+      output->push_back(static_cast<char>(tail[j] ^ previous));
+    }
+    i += literals;
+  }
+}
+
+bool ReadHeaderTail(ColumnReader* reader,
+                    size_t length,
+                    const uint8_t* previous_tail,
+                    size_t previous_length,
+                    uint8_t* tail) {
+  memset(tail, 0, length);
+  size_t i = 0;
+  while (i < length) {
+    uint64_t zeros;
+    if (!reader->ReadVarInt(&zeros) || zeros > length - i)
+      return false;
+    i += zeros;
+    if (i == length)
+      break;
+    uint64_t literals;
+    if (!reader->ReadVarInt(&literals) || literals == 0 ||
+        literals > length - i || !reader->ReadBytes(literals, tail + i)) {
+      return false;
+    }
+    i += literals;
+  }
+  for (size_t j = 0; j < length && j < previous_length; ++j)
+    tail[j] ^= previous_tail[j];
+  return true;
+}
+
+}  // namespace
+
+void EncodeRtpPacketBatch(const std::vector<RtcEventRecord>& records,
+                          rtclog::Event* event) {
+  RTC_DCHECK(!records.empty());
+  event->Clear();
+  event->set_timestamp_us(records.front().timestamp_us);
+  event->set_type(rtclog::Event::RTP_PACKET_BATCH_EVENT);
+
+  rtclog::RtpPacketBatch* batch = event->mutable_rtp_packet_batch();
+  batch->set_incoming(records.front().rtp.incoming);
+  batch->set_ssrc(
+      ByteReader<uint32_t>::ReadBigEndian(records.front().rtp.header + 8));
+  batch->set_number_of_packets(records.size());
+
+  ProtoString timestamp_deltas;
+  ProtoString sequence_number_deltas;
+  ProtoString rtp_timestamp_deltas;
+  ProtoString packet_length_deltas;
+  ProtoString header_length_deltas;
+  ProtoString first_bytes_xor;
+  ProtoString header_tail_xor;
+  ProtoString probe_cluster_ids;
+  bool has_probes = false;
+
+  int64_t previous_timestamp_us = records.front().timestamp_us;
+  uint16_t previous_sequence_number = 0;
+  uint32_t previous_rtp_timestamp = 0;
+  int64_t previous_packet_length = 0;
+  int64_t previous_header_length = 0;
+  uint16_t previous_first_bytes = 0;
+  const uint8_t* previous_tail = nullptr;
+  size_t previous_tail_length = 0;
+
+  for (const RtcEventRecord& record : records) {
+    RTC_DCHECK(record.type == RtcEventRecord::Type::kRtpHeader);
+    RTC_DCHECK_EQ(record.rtp.incoming, batch->incoming());
+    RTC_DCHECK_GE(record.rtp.header_length, kFixedHeaderLength);
+    const uint8_t* header = record.rtp.header;
+    RTC_DCHECK_EQ(ByteReader<uint32_t>::ReadBigEndian(header + 8),
+                  batch->ssrc());
+
+    WriteSignedVarInt(record.timestamp_us - previous_timestamp_us,
+                      &timestamp_deltas);
+    previous_timestamp_us = record.timestamp_us;
+
+    const uint16_t sequence_number =
+        ByteReader<uint16_t>::ReadBigEndian(header + 2);
+    WriteSignedVarInt(
+        static_cast<int16_t>(sequence_number - previous_sequence_number),
+        &sequence_number_deltas);
+    previous_sequence_number = sequence_number;
+
+    const uint32_t rtp_timestamp =
+        ByteReader<uint32_t>::ReadBigEndian(header + 4);
+    WriteSignedVarInt(
+        static_cast<int32_t>(rtp_timestamp - previous_rtp_timestamp),
+        &rtp_timestamp_deltas);
+    previous_rtp_timestamp = rtp_timestamp;
+
+    WriteSignedVarInt(record.rtp.packet_length - previous_packet_length,
+                      &packet_length_deltas);
+    previous_packet_length = record.rtp.packet_length;
+
+    WriteSignedVarInt(record.rtp.header_length - previous_header_length,
+                      &header_length_deltas);
+    previous_header_length = record.rtp.header_length;
+
+    const uint16_t first_bytes = ByteReader<uint16_t>::ReadBigEndian(header);
+    WriteVarInt(first_bytes ^ previous_first_bytes, &first_bytes_xor);
+    previous_first_bytes = first_bytes;
+
+    const size_t tail_length = record.rtp.header_length - kFixedHeaderLength;
+    WriteHeaderTail(header + kFixedHeaderLength, tail_length, previous_tail,
+                    previous_tail_length, &header_tail_xor);
+    previous_tail = header + kFixedHeaderLength;
+    previous_tail_length = tail_length;
+
+    const bool is_probe =
+        record.rtp.probe_cluster_id != PacedPacketInfo::kNotAProbe;
+    has_probes |= is_probe;
+    WriteVarInt(is_probe ? record.rtp.probe_cluster_id + 1 : 0,
+                &probe_cluster_ids);
+  }
+
+  batch->set_timestamp_deltas_us(timestamp_deltas);
+  batch->set_sequence_number_deltas(sequence_number_deltas);
+  batch->set_rtp_timestamp_deltas(rtp_timestamp_deltas);
+  batch->set_packet_length_deltas(packet_length_deltas);
+  batch->set_header_length_deltas(header_length_deltas);
+  batch->set_first_bytes_xor(first_bytes_xor);
+  batch->set_header_tail_xor(header_tail_xor);
+  if (has_probes)
+    batch->set_probe_cluster_ids(probe_cluster_ids);
+}
+
+bool DecodeRtpPacketBatch(const rtclog::Event& event,
+                          std::vector<rtclog::Event>* events) {
+  if (!event.has_rtp_packet_batch() || !event.has_timestamp_us())
+    return false;
+  const rtclog::RtpPacketBatch& batch = event.rtp_packet_batch();
+  if (!batch.has_incoming() || !batch.has_ssrc() ||
+      !batch.has_number_of_packets()) {
+    return false;
+  }
+
+  ColumnReader timestamp_deltas(batch.timestamp_deltas_us());
+  ColumnReader sequence_number_deltas(batch.sequence_number_deltas());
+  ColumnReader rtp_timestamp_deltas(batch.rtp_timestamp_deltas());
+  ColumnReader packet_length_deltas(batch.packet_length_deltas());
+  ColumnReader header_length_deltas(batch.header_length_deltas());
+  ColumnReader first_bytes_xor(batch.first_bytes_xor());
+  ColumnReader header_tail_xor(batch.header_tail_xor());
+  ColumnReader probe_cluster_ids(batch.probe_cluster_ids());
+
+  int64_t timestamp_us = event.timestamp_us();
+  uint16_t sequence_number = 0;
+  uint32_t rtp_timestamp = 0;
+  int64_t packet_length = 0;
+  int64_t header_length = 0;
+  uint64_t first_bytes = 0;
+  uint8_t header[IP_PACKET_SIZE];
+  uint8_t previous_tail[IP_PACKET_SIZE];
+  size_t previous_tail_length = 0;
+
+  const size_t original_size = events->size();
+  for (uint32_t i = 0; i < batch.number_of_packets(); ++i) {
+    int64_t timestamp_delta;
+    int64_t sequence_number_delta;
+    int64_t rtp_timestamp_delta;
+    int64_t packet_length_delta;
+    int64_t header_length_delta;
+    uint64_t first_bytes_delta;
+    uint64_t probe_cluster_id = 0;
+    if (!timestamp_deltas.ReadSignedVarInt(&timestamp_delta) ||
+        !sequence_number_deltas.ReadSignedVarInt(&sequence_number_delta) ||
+        !rtp_timestamp_deltas.ReadSignedVarInt(&rtp_timestamp_delta) ||
+        !packet_length_deltas.ReadSignedVarInt(&packet_length_delta) ||
+        !header_length_deltas.ReadSignedVarInt(&header_length_delta) ||
+        !first_bytes_xor.ReadVarInt(&first_bytes_delta) ||
+        (batch.has_probe_cluster_ids() &&
+         !probe_cluster_ids.ReadVarInt(&probe_cluster_id))) {
+      events->resize(original_size);
+      return false;
+    }
+    timestamp_us += timestamp_delta;
+    sequence_number += static_cast<uint16_t>(sequence_number_delta);
+    rtp_timestamp += static_cast<uint32_t>(rtp_timestamp_delta);
+    packet_length += packet_length_delta;
+    header_length += header_length_delta;
+    first_bytes ^= first_bytes_delta;
+    if (header_length < static_cast<int64_t>(kFixedHeaderLength) ||
+        header_length > static_cast<int64_t>(IP_PACKET_SIZE) ||
+        packet_length < header_length || first_bytes > 0xFFFF) {
+      events->resize(original_size);
+      return false;
+    }
+
+    const size_t tail_length = header_length - kFixedHeaderLength;
+    ByteWriter<uint16_t>::WriteBigEndian(header,
+                                         static_cast<uint16_t>(first_bytes));
+    ByteWriter<uint16_t>::WriteBigEndian(header + 2, sequence_number);
+    ByteWriter<uint32_t>::WriteBigEndian(header + 4, rtp_timestamp);
+    ByteWriter<uint32_t>::WriteBigEndian(header + 8, batch.ssrc());
+    if (!ReadHeaderTail(&header_tail_xor, tail_length, previous_tail,
+                        previous_tail_length, header + kFixedHeaderLength)) {
+      events->resize(original_size);
+      return false;
+    }
+    memcpy(previous_tail, header + kFixedHeaderLength, tail_length);
+    previous_tail_length = tail_length;
+
+    events->emplace_back();
+    rtclog::Event& rtp_event = events->back();
+    rtp_event.set_timestamp_us(timestamp_us);
+    rtp_event.set_type(rtclog::Event::RTP_EVENT);
+    rtclog::RtpPacket* rtp_packet = rtp_event.mutable_rtp_packet();
+    rtp_packet->set_incoming(batch.incoming());
+    rtp_packet->set_packet_length(packet_length);
+    rtp_packet->set_header(header, header_length);
+    if (probe_cluster_id != 0)
+      rtp_packet->set_probe_cluster_id(probe_cluster_id - 1);
+  }
+  return true;
+}
+
+}  // namespace webrtc
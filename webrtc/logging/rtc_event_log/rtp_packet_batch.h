@@ -0,0 +1,44 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_LOGGING_RTC_EVENT_LOG_RTP_PACKET_BATCH_H_
+#define WEBRTC_LOGGING_RTC_EVENT_LOG_RTP_PACKET_BATCH_H_
+
+#include <vector>
+
+#include "webrtc/logging/rtc_event_log/rtc_event_record.h"
+
+namespace webrtc {
+
+namespace rtclog {
+class Event;  // Storage class automatically generated from protobuf.
+}  // namespace rtclog
+
+// Upper bound on the number of packets that RtcEventLogImpl puts into a single
+// RTP_PACKET_BATCH_EVENT. Keeps the serialized event well below the maximum
+// event size accepted by ParsedRtcEventLog.
+constexpr size_t kMaxPacketsPerRtpBatch = 512;
+
+// Encodes |records| as a single RTP_PACKET_BATCH_EVENT in |event|, using the
+// columnar format described in rtc_event_log.proto. All records must be RTP
+// header records with the same SSRC and direction, and |records| must not be
+// empty.
+void EncodeRtpPacketBatch(const std::vector<RtcEventRecord>& records,
+                          rtclog::Event* event);
+
+// Expands the RTP_PACKET_BATCH_EVENT |event| into one RTP_EVENT per packet,
+// appended to |events| in the order they were logged. Returns false if the
+// batch is malformed, in which case |events| is left unchanged.
+bool DecodeRtpPacketBatch(const rtclog::Event& event,
+                          std::vector<rtclog::Event>* events);
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_LOGGING_RTC_EVENT_LOG_RTP_PACKET_BATCH_H_
@@ -0,0 +1,180 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/logging/rtc_event_log/rtp_packet_batch.h"
+
+#include <string.h>
+
+#include <vector>
+
+#include "webrtc/modules/rtp_rtcp/include/rtp_header_extension_map.h"
+#include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_header_extensions.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_packet_to_send.h"
+#include "webrtc/rtc_base/random.h"
+#include "webrtc/test/gtest.h"
+
+// Files generated at build-time by the protobuf compiler.
+#ifdef WEBRTC_ANDROID_PLATFORM_BUILD
+#include "external/webrtc/webrtc/logging/rtc_event_log/rtc_event_log.pb.h"
+#else
+#include "webrtc/logging/rtc_event_log/rtc_event_log.pb.h"
+#endif
+
+namespace webrtc {
+
+namespace {
+
+constexpr uint32_t kSsrc = 0x12345678;
+
+RtcEventRecord CreateRecord(const RtpPacketToSend& packet,
+                            int64_t timestamp_us,
+                            int probe_cluster_id) {
+  RtcEventRecord record;
+  record.timestamp_us = timestamp_us;
+  record.type = RtcEventRecord::Type::kRtpHeader;
+  record.rtp.incoming = false;
+  record.rtp.header_length = static_cast<uint8_t>(packet.headers_size());
+  record.rtp.probe_cluster_id = probe_cluster_id;
+  record.rtp.packet_length = static_cast<uint32_t>(packet.size());
+  memcpy(record.rtp.header, packet.data(), packet.headers_size());
+  return record;
+}
+
+// Generates packets with a mix of header extensions, wrapping sequence
+// numbers and RTP timestamps, and non-monotonic log timestamps.
+std::vector<RtcEventRecord> GenerateRecords(size_t count) {
+  Random prng(0xba7c4);
+  RtpPacketToSend::ExtensionManager extensions;
+  extensions.Register(kRtpExtensionTransportSequenceNumber, 1);
+  extensions.Register(kRtpExtensionAbsoluteSendTime, 3);
+  extensions.Register(kRtpExtensionVideoRotation, 4);
+
+  std::vector<RtcEventRecord> records;
+  uint16_t sequence_number = 0xFFF0;
+  uint32_t rtp_timestamp = 0xFFFFF000;
+  int64_t timestamp_us = 1000000;
+  for (size_t i = 0; i < count; ++i) {
+    RtpPacketToSend packet(&extensions);
+    packet.SetPayloadType(i % 7 == 0 ? 97 : 96);
+    packet.SetMarker(i % 5 == 4);
+    packet.SetSequenceNumber(sequence_number++);
+    packet.SetTimestamp(rtp_timestamp);
+    packet.SetSsrc(kSsrc);
+    if (i % 3 != 0)
+      packet.SetExtension<TransportSequenceNumber>(i);
+    packet.SetExtension<AbsoluteSendTime>(
+        AbsoluteSendTime::MsTo24Bits(timestamp_us / 1000));
+    if (i % 11 == 0)
+      packet.SetExtension<VideoOrientation>(kVideoRotation_90);
+    packet.SetPayloadSize(prng.Rand(50, 1200));
+    if (i % 5 == 4)
+      rtp_timestamp += 3000;
+    timestamp_us += prng.Rand(-100, 5000);
+    records.push_back(CreateRecord(
+        packet, timestamp_us, i % 13 == 0 ? static_cast<int>(i % 4)
+                                          : PacedPacketInfo::kNotAProbe));
+  }
+  return records;
+}
+
+void VerifyRtpEvent(const RtcEventRecord& record, const rtclog::Event& event) {
+  ASSERT_EQ(rtclog::Event::RTP_EVENT, event.type());
+  EXPECT_EQ(record.timestamp_us, event.timestamp_us());
+  const rtclog::RtpPacket& rtp_packet = event.rtp_packet();
+  EXPECT_EQ(record.rtp.incoming, rtp_packet.incoming());
+  EXPECT_EQ(record.rtp.packet_length, rtp_packet.packet_length());
+  ASSERT_EQ(record.rtp.header_length, rtp_packet.header().size());
+  EXPECT_EQ(0, memcmp(record.rtp.header, rtp_packet.header().data(),
+                      record.rtp.header_length));
+  if (record.rtp.probe_cluster_id == PacedPacketInfo::kNotAProbe) {
+    EXPECT_FALSE(rtp_packet.has_probe_cluster_id());
+  } else {
+    ASSERT_TRUE(rtp_packet.has_probe_cluster_id());
+    EXPECT_EQ(static_cast<uint32_t>(record.rtp.probe_cluster_id),
+              rtp_packet.probe_cluster_id());
+  }
+}
+
+}  // namespace
+
+TEST(RtpPacketBatchTest, RoundTrip) {
+  const std::vector<RtcEventRecord> records = GenerateRecords(300);
+
+  rtclog::Event batch_event;
+  EncodeRtpPacketBatch(records, &batch_event);
+  EXPECT_EQ(rtclog::Event::RTP_PACKET_BATCH_EVENT, batch_event.type());
+  EXPECT_EQ(kSsrc, batch_event.rtp_packet_batch().ssrc());
+
+  std::vector<rtclog::Event> events;
+  ASSERT_TRUE(DecodeRtpPacketBatch(batch_event, &events));
+  ASSERT_EQ(records.size(), events.size());
+  for (size_t i = 0; i < records.size(); ++i)
+    VerifyRtpEvent(records[i], events[i]);
+}
+
+TEST(RtpPacketBatchTest, SerializedRoundTripIsSmallerThanSeparateEvents) {
+  const std::vector<RtcEventRecord> records = GenerateRecords(100);
+
+  rtclog::Event batch_event;
+  EncodeRtpPacketBatch(records, &batch_event);
+  rtclog::Event parsed_batch_event;
+  ASSERT_TRUE(
+      parsed_batch_event.ParseFromString(batch_event.SerializeAsString()));
+
+  std::vector<rtclog::Event> events;
+  ASSERT_TRUE(DecodeRtpPacketBatch(parsed_batch_event, &events));
+  ASSERT_EQ(records.size(), events.size());
+  size_t separate_events_size = 0;
+  for (size_t i = 0; i < records.size(); ++i) {
+    VerifyRtpEvent(records[i], events[i]);
+    separate_events_size += events[i].ByteSize();
+  }
+  EXPECT_LT(static_cast<size_t>(batch_event.ByteSize()),
+            separate_events_size / 3);
+}
+
+TEST(RtpPacketBatchTest, AppendsToExistingEvents) {
+  const std::vector<RtcEventRecord> records = GenerateRecords(10);
+  rtclog::Event batch_event;
+  EncodeRtpPacketBatch(records, &batch_event);
+
+  std::vector<rtclog::Event> events(2);
+  ASSERT_TRUE(DecodeRtpPacketBatch(batch_event, &events));
+  ASSERT_EQ(records.size() + 2, events.size());
+  VerifyRtpEvent(records.front(), events[2]);
+}
+
+TEST(RtpPacketBatchTest, RejectsTruncatedBatch) {
+  const std::vector<RtcEventRecord> records = GenerateRecords(10);
+  rtclog::Event batch_event;
+  EncodeRtpPacketBatch(records, &batch_event);
+  rtclog::RtpPacketBatch* batch = batch_event.mutable_rtp_packet_batch();
+  std::string truncated_tail = batch->header_tail_xor();
+  truncated_tail.resize(truncated_tail.size() / 2);
+  batch->set_header_tail_xor(truncated_tail);
+
+  std::vector<rtclog::Event> events(1);
+  EXPECT_FALSE(DecodeRtpPacketBatch(batch_event, &events));
+  EXPECT_EQ(1u, events.size());
+}
+
+TEST(RtpPacketBatchTest, RejectsTooManyPackets) {
+  const std::vector<RtcEventRecord> records = GenerateRecords(10);
+  rtclog::Event batch_event;
+  EncodeRtpPacketBatch(records, &batch_event);
+  batch_event.mutable_rtp_packet_batch()->set_number_of_packets(11);
+
+  std::vector<rtclog::Event> events;
+  EXPECT_FALSE(DecodeRtpPacketBatch(batch_event, &events));
+  EXPECT_TRUE(events.empty());
+}
+
+}  // namespace webrtc
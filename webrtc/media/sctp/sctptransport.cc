@@ -25,6 +25,7 @@ enum PreservedErrno {
 
 #include <memory>
 #include <sstream>
+#include <utility>
 
 #include "usrsctplib/usrsctp.h"
 #include "webrtc/media/base/codec.h"
@@ -46,9 +47,6 @@ namespace {
 // take off 80 bytes for DTLS/TURN/TCP/IP overhead.
 static constexpr size_t kSctpMtu = 1200;
 
-// The size of the SCTP association send buffer.  256kB, the usrsctp default.
-static constexpr int kSendBufferSize = 262144;
-
 // Set the initial value of the static SCTP Data Engines reference count.
 int g_usrsctp_usage_count = 0;
 rtc::GlobalLockPod g_usrsctp_lock_;
@@ -224,7 +222,7 @@ class SctpTransport::UsrSctpWrapper {
     // This is harmless, but we should find out when the library default
     // changes.
     int send_size = usrsctp_sysctl_get_sctp_sendspace();
-    if (send_size != kSendBufferSize) {
+    if (send_size != cricket::kSctpDefaultSendBufferSize) {
       LOG(LS_ERROR) << "Got different send size than expected: " << send_size;
     }
 
@@ -296,12 +294,9 @@ class SctpTransport::UsrSctpWrapper {
 
     VerboseLogPacket(data, length, SCTP_DUMP_OUTBOUND);
     // Note: We have to copy the data; the caller will delete it.
-    rtc::CopyOnWriteBuffer buf(reinterpret_cast<uint8_t*>(data), length);
-    // TODO(deadbeef): Why do we need an AsyncInvoke here? We're already on the
-    // right thread and don't need to unwind the stack.
-    transport->invoker_.AsyncInvoke<void>(
-        RTC_FROM_HERE, transport->network_thread_,
-        rtc::Bind(&SctpTransport::OnPacketFromSctpToNetwork, transport, buf));
+    // TODO(deadbeef): Why do we need to post to the network thread here? We're
+    // already on the right thread and don't need to unwind the stack.
+    transport->QueuePacketFromSctpToNetwork(data, length);
     return 0;
   }
 
@@ -317,7 +312,9 @@ class SctpTransport::UsrSctpWrapper {
                                  int flags,
                                  void* ulp_info) {
     SctpTransport* transport = static_cast<SctpTransport*>(ulp_info);
-    // Post data to the transport's receiver thread (copying it).
+    // Post data to the transport's receiver thread (copying it). This is the
+    // only copy on the way to the receiver; from here on the buffer's storage
+    // is shared.
     // TODO(ldixon): Unclear if copy is needed as this method is responsible for
     // memory cleanup. But this does simplify code.
     const PayloadProtocolIdentifier ppid =
@@ -329,19 +326,16 @@ class SctpTransport::UsrSctpWrapper {
       LOG(LS_ERROR) << "Received an unknown PPID " << ppid
                     << " on an SCTP packet.  Dropping.";
     } else {
-      rtc::CopyOnWriteBuffer buffer;
-      ReceiveDataParams params;
-      buffer.SetData(reinterpret_cast<uint8_t*>(data), length);
-      params.sid = rcv.rcv_sid;
-      params.seq_num = rcv.rcv_ssn;
-      params.timestamp = rcv.rcv_tsn;
-      params.type = type;
-      // The ownership of the packet transfers to |invoker_|. Using
+      SctpInboundPacket packet;
+      packet.buffer.SetData(reinterpret_cast<uint8_t*>(data), length);
+      packet.params.sid = rcv.rcv_sid;
+      packet.params.seq_num = rcv.rcv_ssn;
+      packet.params.timestamp = rcv.rcv_tsn;
+      packet.params.type = type;
+      packet.flags = flags;
+      // The ownership of the packet transfers to the transport's queue. Using
       // CopyOnWriteBuffer is the most convenient way to do this.
-      transport->invoker_.AsyncInvoke<void>(
-          RTC_FROM_HERE, transport->network_thread_,
-          rtc::Bind(&SctpTransport::OnInboundPacketFromSctpToChannel, transport,
-                    buffer, params, flags));
+      transport->QueueInboundPacketFromSctpToChannel(std::move(packet));
     }
     free(data);
     return 1;
@@ -385,11 +379,24 @@ class SctpTransport::UsrSctpWrapper {
 
 SctpTransport::SctpTransport(rtc::Thread* network_thread,
                              rtc::PacketTransportInternal* channel)
+    : SctpTransport(network_thread,
+                    channel,
+                    kSctpDefaultSendBufferSize,
+                    kSctpDefaultReceiveBufferSize) {}
+
+SctpTransport::SctpTransport(rtc::Thread* network_thread,
+                             rtc::PacketTransportInternal* channel,
+                             int send_buffer_size,
+                             int receive_buffer_size)
     : network_thread_(network_thread),
       transport_channel_(channel),
-      was_ever_writable_(channel->writable()) {
+      was_ever_writable_(channel->writable()),
+      send_buffer_size_(send_buffer_size),
+      receive_buffer_size_(receive_buffer_size) {
   RTC_DCHECK(network_thread_);
   RTC_DCHECK(transport_channel_);
+  RTC_DCHECK_GT(send_buffer_size_, 0);
+  RTC_DCHECK_GT(receive_buffer_size_, 0);
   RTC_DCHECK_RUN_ON(network_thread_);
   ConnectTransportChannelSignals();
 }
@@ -649,14 +656,13 @@ bool SctpTransport::OpenSctpSocket() {
 
   UsrSctpWrapper::IncrementUsrSctpUsageCount();
 
-  // If kSendBufferSize isn't reflective of reality, we log an error, but we
-  // still have to do something reasonable here.  Look up what the buffer's
-  // real size is and set our threshold to something reasonable.
-  static const int kSendThreshold = usrsctp_sysctl_get_sctp_sendspace() / 2;
+  // Signal that we're ready to send once half of the send buffer is free.
+  // ConfigureSctpSocket sets the buffer to |send_buffer_size_|.
+  const uint32_t send_threshold = send_buffer_size_ / 2;
 
   sock_ = usrsctp_socket(
       AF_CONN, SOCK_STREAM, IPPROTO_SCTP, &UsrSctpWrapper::OnSctpInboundPacket,
-      &UsrSctpWrapper::SendThresholdCallback, kSendThreshold, this);
+      &UsrSctpWrapper::SendThresholdCallback, send_threshold, this);
   if (!sock_) {
     LOG_ERRNO(LS_ERROR) << debug_name_ << "->OpenSctpSocket(): "
                         << "Failed to create SCTP socket.";
@@ -700,6 +706,24 @@ bool SctpTransport::ConfigureSctpSocket() {
     return false;
   }
 
+  // Size the socket buffers. This has to happen before connecting, since the
+  // receive buffer size is the initial window advertised to the peer.
+  int send_buffer_size = send_buffer_size_;
+  if (usrsctp_setsockopt(sock_, SOL_SOCKET, SO_SNDBUF, &send_buffer_size,
+                         sizeof(send_buffer_size))) {
+    LOG_ERRNO(LS_ERROR) << debug_name_ << "->ConfigureSctpSocket(): "
+                        << "Failed to set SO_SNDBUF to " << send_buffer_size;
+    return false;
+  }
+  int receive_buffer_size = receive_buffer_size_;
+  if (usrsctp_setsockopt(sock_, SOL_SOCKET, SO_RCVBUF, &receive_buffer_size,
+                         sizeof(receive_buffer_size))) {
+    LOG_ERRNO(LS_ERROR) << debug_name_ << "->ConfigureSctpSocket(): "
+                        << "Failed to set SO_RCVBUF to "
+                        << receive_buffer_size;
+    return false;
+  }
+
   // Enable stream ID resets.
   struct sctp_assoc_value stream_rst;
   stream_rst.assoc_id = SCTP_ALL_ASSOC;
@@ -867,6 +891,51 @@ sockaddr_conn SctpTransport::GetSctpSockAddr(int port) {
   return sconn;
 }
 
+void SctpTransport::QueuePacketFromSctpToNetwork(const void* data,
+                                                 size_t length) {
+  bool was_empty;
+  {
+    rtc::CritScope cs(&queue_lock_);
+    was_empty = outbound_packets_.empty();
+    outbound_packets_.emplace_back(static_cast<const uint8_t*>(data), length);
+  }
+  if (was_empty) {
+    invoker_.AsyncInvoke<void>(
+        RTC_FROM_HERE, network_thread_,
+        rtc::Bind(&SctpTransport::OnPacketsFromSctpToNetwork, this));
+  }
+}
+
+void SctpTransport::QueueInboundPacketFromSctpToChannel(
+    SctpInboundPacket packet) {
+  bool was_empty;
+  {
+    rtc::CritScope cs(&queue_lock_);
+    was_empty = inbound_packets_.empty();
+    inbound_packets_.push_back(std::move(packet));
+  }
+  if (was_empty) {
+    invoker_.AsyncInvoke<void>(
+        RTC_FROM_HERE, network_thread_,
+        rtc::Bind(&SctpTransport::OnInboundPacketsFromSctpToChannel, this));
+  }
+}
+
+void SctpTransport::OnPacketsFromSctpToNetwork() {
+  RTC_DCHECK_RUN_ON(network_thread_);
+  RTC_DCHECK(outbound_packets_to_process_.empty());
+  {
+    rtc::CritScope cs(&queue_lock_);
+    outbound_packets_to_process_.swap(outbound_packets_);
+  }
+  TRACE_EVENT1("webrtc", "SctpTransport::OnPacketsFromSctpToNetwork",
+               "packets", outbound_packets_to_process_.size());
+  for (const rtc::CopyOnWriteBuffer& buffer : outbound_packets_to_process_) {
+    OnPacketFromSctpToNetwork(buffer);
+  }
+  outbound_packets_to_process_.clear();
+}
+
 void SctpTransport::OnPacketFromSctpToNetwork(
     const rtc::CopyOnWriteBuffer& buffer) {
   RTC_DCHECK_RUN_ON(network_thread_);
@@ -889,6 +958,20 @@ void SctpTransport::OnPacketFromSctpToNetwork(
                                  rtc::PacketOptions(), PF_NORMAL);
 }
 
+void SctpTransport::OnInboundPacketsFromSctpToChannel() {
+  RTC_DCHECK_RUN_ON(network_thread_);
+  RTC_DCHECK(inbound_packets_to_process_.empty());
+  {
+    rtc::CritScope cs(&queue_lock_);
+    inbound_packets_to_process_.swap(inbound_packets_);
+  }
+  for (const SctpInboundPacket& packet : inbound_packets_to_process_) {
+    OnInboundPacketFromSctpToChannel(packet.buffer, packet.params,
+                                     packet.flags);
+  }
+  inbound_packets_to_process_.clear();
+}
+
 void SctpTransport::OnInboundPacketFromSctpToChannel(
     const rtc::CopyOnWriteBuffer& buffer,
     ReceiveDataParams params,
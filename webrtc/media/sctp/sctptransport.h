@@ -21,8 +21,10 @@
 #include "webrtc/rtc_base/asyncinvoker.h"
 #include "webrtc/rtc_base/constructormagic.h"
 #include "webrtc/rtc_base/copyonwritebuffer.h"
+#include "webrtc/rtc_base/criticalsection.h"
 #include "webrtc/rtc_base/sigslot.h"
 #include "webrtc/rtc_base/thread.h"
+#include "webrtc/rtc_base/thread_annotations.h"
 // For SendDataParams/ReceiveDataParams.
 #include "webrtc/media/base/mediachannel.h"
 #include "webrtc/media/sctp/sctptransportinternal.h"
@@ -35,8 +37,18 @@ struct sctp_stream_reset_event;
 struct socket;
 namespace cricket {
 
+// The default sizes of the SCTP socket's send and receive buffers. 256kB, the
+// usrsctp defaults.
+constexpr int kSctpDefaultSendBufferSize = 256 * 1024;
+constexpr int kSctpDefaultReceiveBufferSize = 256 * 1024;
+
 // Holds data to be passed on to a channel.
-struct SctpInboundPacket;
+struct SctpInboundPacket {
+  rtc::CopyOnWriteBuffer buffer;
+  ReceiveDataParams params;
+  // The usrsctp receive flags; MSG_NOTIFICATION is set for notifications.
+  int flags;
+};
 
 // From channel calls, data flows like this:
 // [network thread (although it can in princple be another thread)]
@@ -44,20 +56,24 @@ struct SctpInboundPacket;
 //  2.  usrsctp_sendv(data)
 // [network thread returns; sctp thread then calls the following]
 //  3.  OnSctpOutboundPacket(wrapped_data)
-// [sctp thread returns having async invoked on the network thread]
-//  4.  SctpTransport::OnPacketFromSctpToNetwork(wrapped_data)
+// [sctp thread returns having queued the packet for the network thread]
+//  4.  SctpTransport::OnPacketsFromSctpToNetwork()
+//      SctpTransport::OnPacketFromSctpToNetwork(wrapped_data)
 //  5.  TransportChannel::SendPacket(wrapped_data)
 //  6.  ... across network ... a packet is sent back ...
 //  7.  SctpTransport::OnPacketReceived(wrapped_data)
 //  8.  usrsctp_conninput(wrapped_data)
 // [network thread returns; sctp thread then calls the following]
 //  9.  OnSctpInboundData(data)
-// [sctp thread returns having async invoked on the network thread]
-//  10. SctpTransport::OnInboundPacketFromSctpToChannel(inboundpacket)
+// [sctp thread returns having queued the data for the network thread]
+//  10. SctpTransport::OnInboundPacketsFromSctpToChannel()
+//      SctpTransport::OnInboundPacketFromSctpToChannel(inboundpacket)
 //  11. SctpTransport::OnDataFromSctpToChannel(data)
 //  12. SctpTransport::SignalDataReceived(data)
 // [from the same thread, methods registered/connected to
 //  SctpTransport are called with the recieved data]
+// Packets queued in steps 3 and 9 are handed to the network thread in
+// batches: a single task drains everything queued before it runs.
 // TODO(zhihuang): Rename "channel" to "transport" on network-level.
 class SctpTransport : public SctpTransportInternal,
                       public sigslot::has_slots<> {
@@ -68,6 +84,14 @@ class SctpTransport : public SctpTransportInternal,
   // |channel| is required (must not be null).
   SctpTransport(rtc::Thread* network_thread,
                 rtc::PacketTransportInternal* channel);
+  // |send_buffer_size| and |receive_buffer_size| are the sizes in bytes of the
+  // SCTP socket's buffers. The receive buffer size is the window advertised to
+  // the peer, so larger buffers keep more data in flight on links with a high
+  // bandwidth-delay product, at the cost of memory per association.
+  SctpTransport(rtc::Thread* network_thread,
+                rtc::PacketTransportInternal* channel,
+                int send_buffer_size,
+                int receive_buffer_size);
   ~SctpTransport() override;
 
   // SctpTransportInternal overrides (see sctptransportinternal.h for comments).
@@ -119,9 +143,16 @@ class SctpTransport : public SctpTransportInternal,
   void OnSendThresholdCallback();
   sockaddr_conn GetSctpSockAddr(int port);
 
-  // Called using |invoker_| to send packet on the network.
+  // Called from usrsctp callbacks, on any thread. Queue a packet for the
+  // network thread, posting a task to |invoker_| if the queue was empty.
+  void QueuePacketFromSctpToNetwork(const void* data, size_t length);
+  void QueueInboundPacketFromSctpToChannel(SctpInboundPacket packet);
+
+  // Called using |invoker_| to send the queued packets on the network.
+  void OnPacketsFromSctpToNetwork();
   void OnPacketFromSctpToNetwork(const rtc::CopyOnWriteBuffer& buffer);
-  // Called using |invoker_| to decide what to do with the packet.
+  // Called using |invoker_| to decide what to do with the queued packets.
+  void OnInboundPacketsFromSctpToChannel();
   // The |flags| parameter is used by SCTP to distinguish notification packets
   // from other types of packets.
   void OnInboundPacketFromSctpToChannel(const rtc::CopyOnWriteBuffer& buffer,
@@ -139,12 +170,24 @@ class SctpTransport : public SctpTransportInternal,
   rtc::Thread* network_thread_;
   // Helps pass inbound/outbound packets asynchronously to the network thread.
   rtc::AsyncInvoker invoker_;
+  // Packets waiting for the network thread. A task is posted to |invoker_|
+  // only when a queue goes from empty to non-empty.
+  rtc::CriticalSection queue_lock_;
+  std::vector<rtc::CopyOnWriteBuffer> outbound_packets_
+      RTC_GUARDED_BY(queue_lock_);
+  std::vector<SctpInboundPacket> inbound_packets_ RTC_GUARDED_BY(queue_lock_);
+  // Swapped with the queues above when draining them, so that their capacity
+  // is reused. Only used on the network thread.
+  std::vector<rtc::CopyOnWriteBuffer> outbound_packets_to_process_;
+  std::vector<SctpInboundPacket> inbound_packets_to_process_;
   // Underlying DTLS channel.
   rtc::PacketTransportInternal* transport_channel_;
   bool was_ever_writable_ = false;
   int local_port_ = kSctpDefaultPort;
   int remote_port_ = kSctpDefaultPort;
   struct socket* sock_ = nullptr;  // The socket created by usrsctp_socket(...).
+  const int send_buffer_size_;
+  const int receive_buffer_size_;
 
   // Has Start been called? Don't create SCTP socket until it has.
   bool started_ = false;
@@ -176,16 +219,27 @@ class SctpTransport : public SctpTransportInternal,
 class SctpTransportFactory : public SctpTransportInternalFactory {
  public:
   explicit SctpTransportFactory(rtc::Thread* network_thread)
-      : network_thread_(network_thread) {}
+      : SctpTransportFactory(network_thread,
+                             kSctpDefaultSendBufferSize,
+                             kSctpDefaultReceiveBufferSize) {}
+  // Creates transports with the given buffer sizes; see SctpTransport.
+  SctpTransportFactory(rtc::Thread* network_thread,
+                       int send_buffer_size,
+                       int receive_buffer_size)
+      : network_thread_(network_thread),
+        send_buffer_size_(send_buffer_size),
+        receive_buffer_size_(receive_buffer_size) {}
 
   std::unique_ptr<SctpTransportInternal> CreateSctpTransport(
       rtc::PacketTransportInternal* channel) override {
-    return std::unique_ptr<SctpTransportInternal>(
-        new SctpTransport(network_thread_, channel));
+    return std::unique_ptr<SctpTransportInternal>(new SctpTransport(
+        network_thread_, channel, send_buffer_size_, receive_buffer_size_));
   }
 
  private:
   rtc::Thread* network_thread_;
+  const int send_buffer_size_;
+  const int receive_buffer_size_;
 };
 
 }  // namespace cricket
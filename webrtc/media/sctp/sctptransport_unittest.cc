@@ -19,12 +19,16 @@
 #include "webrtc/media/sctp/sctptransport.h"
 #include "webrtc/p2p/base/fakedtlstransport.h"
 #include "webrtc/rtc_base/bind.h"
+#include "webrtc/rtc_base/byteorder.h"
 #include "webrtc/rtc_base/copyonwritebuffer.h"
 #include "webrtc/rtc_base/criticalsection.h"
 #include "webrtc/rtc_base/gunit.h"
 #include "webrtc/rtc_base/helpers.h"
 #include "webrtc/rtc_base/ssladapter.h"
+#include "webrtc/rtc_base/stringencode.h"
 #include "webrtc/rtc_base/thread.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
 
 namespace {
 static const int kDefaultTimeout = 10000;  // 10 seconds.
@@ -67,6 +71,41 @@ class SctpFakeDataReceiver : public sigslot::has_slots<> {
   ReceiveDataParams last_params_;
 };
 
+// Counts received messages and bytes, and measures the latency of messages
+// whose first four bytes are an index into |send_times_us|.
+class SctpThroughputReceiver : public sigslot::has_slots<> {
+ public:
+  explicit SctpThroughputReceiver(const std::vector<int64_t>* send_times_us)
+      : send_times_us_(send_times_us) {}
+
+  void OnDataReceived(const ReceiveDataParams& params,
+                      const rtc::CopyOnWriteBuffer& data) {
+    ASSERT_GE(data.size(), 4u);
+    uint32_t index = rtc::GetBE32(data.data());
+    ASSERT_LT(index, send_times_us_->size());
+    last_receive_time_us_ = rtc::TimeMicros();
+    total_latency_us_ += last_receive_time_us_ - (*send_times_us_)[index];
+    ++messages_;
+    bytes_ += data.size();
+  }
+
+  int messages() const { return messages_; }
+  size_t bytes() const { return bytes_; }
+  int64_t last_receive_time_us() const { return last_receive_time_us_; }
+  double average_latency_ms() const {
+    return messages_ ? static_cast<double>(total_latency_us_) /
+                           (messages_ * rtc::kNumMicrosecsPerMillisec)
+                     : 0.0;
+  }
+
+ private:
+  const std::vector<int64_t>* const send_times_us_;
+  int messages_ = 0;
+  size_t bytes_ = 0;
+  int64_t last_receive_time_us_ = 0;
+  int64_t total_latency_us_ = 0;
+};
+
 class SignalReadyToSendObserver : public sigslot::has_slots<> {
  public:
   SignalReadyToSendObserver() : signaled_(false) {}
@@ -134,15 +173,26 @@ class SctpTransportTest : public testing::Test, public sigslot::has_slots<> {
   }
 
   void SetupConnectedTransportsWithTwoStreams(int port1, int port2) {
+    SetupConnectedTransportsWithTwoStreams(port1, port2,
+                                           kSctpDefaultSendBufferSize,
+                                           kSctpDefaultReceiveBufferSize);
+  }
+
+  void SetupConnectedTransportsWithTwoStreams(int port1,
+                                              int port2,
+                                              int send_buffer_size,
+                                              int receive_buffer_size) {
     fake_dtls1_.reset(new FakeDtlsTransport("fake dtls 1", 0));
     fake_dtls2_.reset(new FakeDtlsTransport("fake dtls 2", 0));
     recv1_.reset(new SctpFakeDataReceiver());
     recv2_.reset(new SctpFakeDataReceiver());
-    transport1_.reset(CreateTransport(fake_dtls1_.get(), recv1_.get()));
+    transport1_.reset(CreateTransport(fake_dtls1_.get(), recv1_.get(),
+                                      send_buffer_size, receive_buffer_size));
     transport1_->set_debug_name_for_testing("transport1");
     transport1_->SignalReadyToSendData.connect(
         this, &SctpTransportTest::OnChan1ReadyToSend);
-    transport2_.reset(CreateTransport(fake_dtls2_.get(), recv2_.get()));
+    transport2_.reset(CreateTransport(fake_dtls2_.get(), recv2_.get(),
+                                      send_buffer_size, receive_buffer_size));
     transport2_->set_debug_name_for_testing("transport2");
     transport2_->SignalReadyToSendData.connect(
         this, &SctpTransportTest::OnChan2ReadyToSend);
@@ -170,8 +220,17 @@ class SctpTransportTest : public testing::Test, public sigslot::has_slots<> {
 
   SctpTransport* CreateTransport(FakeDtlsTransport* fake_dtls,
                                  SctpFakeDataReceiver* recv) {
+    return CreateTransport(fake_dtls, recv, kSctpDefaultSendBufferSize,
+                           kSctpDefaultReceiveBufferSize);
+  }
+
+  SctpTransport* CreateTransport(FakeDtlsTransport* fake_dtls,
+                                 SctpFakeDataReceiver* recv,
+                                 int send_buffer_size,
+                                 int receive_buffer_size) {
     SctpTransport* transport =
-        new SctpTransport(rtc::Thread::Current(), fake_dtls);
+        new SctpTransport(rtc::Thread::Current(), fake_dtls, send_buffer_size,
+                          receive_buffer_size);
     // When data is received, pass it to the SctpFakeDataReceiver.
     transport->SignalDataReceived.connect(
         recv, &SctpFakeDataReceiver::OnDataReceived);
@@ -552,6 +611,105 @@ TEST_F(SctpTransportTest, RefusesHighNumberedTransports) {
   EXPECT_FALSE(AddStream(kMaxSctpSid + 1));
 }
 
+// Test that a larger send buffer lets more data be queued before SendData
+// returns SDR_BLOCK.
+TEST_F(SctpTransportTest, SendBufferSizeIsConfigurable) {
+  static const int kMessageSize = 1024;
+  static const int kMaxMessages = 4096;
+  int messages_until_blocked[2];
+  const int send_buffer_sizes[2] = {kSctpDefaultSendBufferSize,
+                                    4 * kSctpDefaultSendBufferSize};
+  for (int i = 0; i < 2; ++i) {
+    SetupConnectedTransportsWithTwoStreams(kTransport1Port, kTransport2Port,
+                                           send_buffer_sizes[i],
+                                           kSctpDefaultReceiveBufferSize);
+    EXPECT_EQ_WAIT(i + 1, transport1_ready_to_send_count(), kDefaultTimeout);
+    // Let the messages pile up in the SCTP socket.
+    fake_dtls1()->SetWritable(false);
+    SendDataParams params;
+    params.sid = 1;
+    rtc::CopyOnWriteBuffer buf(kMessageSize);
+    memset(buf.data<uint8_t>(), 0, kMessageSize);
+    SendDataResult result;
+    int message_count;
+    for (message_count = 0; message_count < kMaxMessages; ++message_count) {
+      if (!transport1()->SendData(params, buf, &result)) {
+        ASSERT_EQ(SDR_BLOCK, result);
+        break;
+      }
+    }
+    ASSERT_NE(kMaxMessages, message_count);
+    messages_until_blocked[i] = message_count;
+  }
+  EXPECT_GT(messages_until_blocked[1], 2 * messages_until_blocked[0]);
+}
+
+// Sends 8 MiB over a pair of loopback transports and reports the throughput
+// and average message latency, for a reliable and an unreliable channel and
+// for the default and larger socket buffers. Disabled since it only reports
+// timings; run it with --gtest_also_run_disabled_tests.
+TEST_F(SctpTransportTest, DISABLED_ThroughputPerformance) {
+  static const size_t kMessageSize = 16 * 1024;
+  static const int kNumMessages = 512;
+  const struct {
+    const char* name;
+    bool ordered;
+    int max_rtx_count;
+  } kChannelTypes[] = {{"reliable", true, -1}, {"unreliable", false, 0}};
+  const int kBufferSizes[] = {kSctpDefaultReceiveBufferSize, 1024 * 1024};
+
+  for (const auto& channel_type : kChannelTypes) {
+    for (int buffer_size : kBufferSizes) {
+      // Wait for the new association to signal that it's ready to send.
+      int ready_to_send_count = transport1_ready_to_send_count();
+      SetupConnectedTransportsWithTwoStreams(kTransport1Port, kTransport2Port,
+                                             buffer_size, buffer_size);
+      ASSERT_TRUE_WAIT(transport1_ready_to_send_count() > ready_to_send_count,
+                       kDefaultTimeout);
+
+      std::vector<int64_t> send_times_us(kNumMessages);
+      SctpThroughputReceiver receiver(&send_times_us);
+      transport2()->SignalDataReceived.disconnect(receiver2());
+      transport2()->SignalDataReceived.connect(
+          &receiver, &SctpThroughputReceiver::OnDataReceived);
+
+      SendDataParams params;
+      params.sid = 1;
+      params.ordered = channel_type.ordered;
+      params.max_rtx_count = channel_type.max_rtx_count;
+      const int64_t start_us = rtc::TimeMicros();
+      for (int i = 0; i < kNumMessages;) {
+        rtc::CopyOnWriteBuffer payload(kMessageSize);
+        memset(payload.data(), 0, kMessageSize);
+        rtc::SetBE32(payload.data(), i);
+        send_times_us[i] = rtc::TimeMicros();
+        SendDataResult result;
+        if (transport1()->SendData(params, payload, &result)) {
+          ++i;
+          continue;
+        }
+        ASSERT_EQ(SDR_BLOCK, result);
+        ready_to_send_count = transport1_ready_to_send_count();
+        ASSERT_TRUE_WAIT(transport1_ready_to_send_count() > ready_to_send_count,
+                         kDefaultTimeout);
+      }
+      EXPECT_EQ_WAIT(kNumMessages, receiver.messages(), kDefaultTimeout);
+
+      const double elapsed_s =
+          static_cast<double>(receiver.last_receive_time_us() - start_us) /
+          rtc::kNumMicrosecsPerSec;
+      const std::string modifier = std::string("_") + channel_type.name +
+                                   "_" + rtc::ToString(buffer_size / 1024) +
+                                   "kB";
+      webrtc::test::PrintResult("sctp_throughput", modifier, "loopback",
+                                receiver.bytes() / (1024 * 1024 * elapsed_s),
+                                "MBps", false);
+      webrtc::test::PrintResult("sctp_latency", modifier, "loopback",
+                                receiver.average_latency_ms(), "ms", false);
+    }
+  }
+}
+
 // Flaky, see webrtc:4453.
 TEST_F(SctpTransportTest, DISABLED_ReusesAStream) {
   // Shut down transport 1, then open it up again for reuse.
@@ -0,0 +1,284 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_coding/codecs/opus/audio_encoder_opus_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "webrtc/modules/audio_coding/audio_network_adaptor/audio_network_adaptor_impl.h"
+#include "webrtc/modules/audio_coding/audio_network_adaptor/controller_manager.h"
+#include "webrtc/rtc_base/checks.h"
+#include "webrtc/rtc_base/logging.h"
+#include "webrtc/rtc_base/ptr_util.h"
+
+namespace webrtc {
+
+namespace {
+
+std::unique_ptr<AudioNetworkAdaptor> CreateAudioNetworkAdaptor(
+    const AudioEncoderOpusConfig& config,
+    const std::string& config_string,
+    RtcEventLog* event_log) {
+  AudioNetworkAdaptorImpl::Config adaptor_config;
+  adaptor_config.event_log = event_log;
+  std::unique_ptr<ControllerManager> controller_manager =
+      ControllerManagerImpl::Create(
+          config_string, config.num_channels,
+          config.supported_frame_lengths_ms,
+          AudioEncoderOpusConfig::kMinBitrateBps, config.num_channels,
+          config.frame_size_ms, *config.bitrate_bps, config.fec_enabled,
+          config.dtx_enabled);
+  if (!controller_manager)
+    return nullptr;
+  return rtc::MakeUnique<AudioNetworkAdaptorImpl>(
+      adaptor_config, std::move(controller_manager));
+}
+
+}  // namespace
+
+struct AudioEncoderOpusPool::TierState {
+  TierState(const Tier& tier, std::unique_ptr<AudioEncoderOpus> encoder)
+      : tier(tier), encoder(std::move(encoder)) {}
+
+  const Tier tier;
+  const std::unique_ptr<AudioEncoderOpus> encoder;
+  size_t num_receivers = 0;
+  // Set when the tier gets its first receiver, to drop the partial packet
+  // buffered when it lost its last one.
+  bool needs_reset = false;
+};
+
+struct AudioEncoderOpusPool::Receiver {
+  Receiver(std::unique_ptr<AudioNetworkAdaptor> adaptor, size_t tier)
+      : adaptor(std::move(adaptor)), tier(tier) {}
+
+  const std::unique_ptr<AudioNetworkAdaptor> adaptor;
+  size_t tier;
+  float packet_loss_fraction = 0.0f;
+};
+
+AudioEncoderOpusPool::AudioEncoderOpusPool(
+    const AudioEncoderOpusConfig& config,
+    int payload_type,
+    const std::vector<Tier>& tiers,
+    const std::string& audio_network_adaptor_config,
+    RtcEventLog* event_log)
+    : AudioEncoderOpusPool(
+          config,
+          payload_type,
+          tiers,
+          audio_network_adaptor_config,
+          event_log,
+          [config](const std::string& config_string, RtcEventLog* event_log) {
+            return CreateAudioNetworkAdaptor(config, config_string, event_log);
+          }) {}
+
+AudioEncoderOpusPool::AudioEncoderOpusPool(
+    const AudioEncoderOpusConfig& config,
+    int payload_type,
+    const std::vector<Tier>& tiers,
+    const std::string& audio_network_adaptor_config,
+    RtcEventLog* event_log,
+    const AudioEncoderOpus::AudioNetworkAdaptorCreator&
+        audio_network_adaptor_creator)
+    : config_(config),
+      audio_network_adaptor_config_(audio_network_adaptor_config),
+      event_log_(event_log),
+      audio_network_adaptor_creator_(audio_network_adaptor_creator) {
+  RTC_CHECK(config_.IsOk());
+  RTC_CHECK(!tiers.empty());
+  for (const Tier& tier : tiers) {
+    AudioEncoderOpusConfig tier_config = config_;
+    tier_config.bitrate_bps = rtc::Optional<int>(tier.bitrate_bps);
+    tier_config.fec_enabled = tier.fec_enabled;
+    RTC_CHECK(tier_config.IsOk()) << "Invalid tier bitrate "
+                                  << tier.bitrate_bps;
+    tiers_.push_back(rtc::MakeUnique<TierState>(
+        tier, rtc::MakeUnique<AudioEncoderOpus>(tier_config, payload_type)));
+  }
+}
+
+AudioEncoderOpusPool::~AudioEncoderOpusPool() = default;
+
+bool AudioEncoderOpusPool::AddReceiver(int receiver_id) {
+  if (receivers_.find(receiver_id) != receivers_.end())
+    return false;
+  std::unique_ptr<AudioNetworkAdaptor> adaptor =
+      audio_network_adaptor_creator_(audio_network_adaptor_config_,
+                                     event_log_);
+  if (!adaptor) {
+    LOG(LS_WARNING) << "Failed to create the audio network adaptor of "
+                    << "receiver " << receiver_id;
+    return false;
+  }
+  const size_t tier = SelectTier(
+      *config_.bitrate_bps, rtc::Optional<bool>(config_.fec_enabled));
+  if (tiers_[tier]->num_receivers++ == 0)
+    tiers_[tier]->needs_reset = true;
+  receivers_[receiver_id] = rtc::MakeUnique<Receiver>(std::move(adaptor), tier);
+  return true;
+}
+
+void AudioEncoderOpusPool::RemoveReceiver(int receiver_id) {
+  auto it = receivers_.find(receiver_id);
+  if (it == receivers_.end())
+    return;
+  --tiers_[it->second->tier]->num_receivers;
+  receivers_.erase(it);
+  UpdatePacketLossRates();
+}
+
+void AudioEncoderOpusPool::OnReceivedUplinkBandwidth(
+    int receiver_id,
+    int target_audio_bitrate_bps) {
+  auto it = receivers_.find(receiver_id);
+  if (it == receivers_.end())
+    return;
+  // Unlike AudioEncoderOpus, which smooths the target bitrate before using it
+  // as the uplink bandwidth, the pool leaves smoothing to the caller; a tier
+  // change is already coarser than the bitrate steps of a single encoder.
+  it->second->adaptor->SetTargetAudioBitrate(target_audio_bitrate_bps);
+  it->second->adaptor->SetUplinkBandwidth(target_audio_bitrate_bps);
+  UpdateTier(it->second.get());
+}
+
+void AudioEncoderOpusPool::OnReceivedUplinkPacketLossFraction(
+    int receiver_id,
+    float uplink_packet_loss_fraction) {
+  auto it = receivers_.find(receiver_id);
+  if (it == receivers_.end())
+    return;
+  it->second->adaptor->SetUplinkPacketLossFraction(uplink_packet_loss_fraction);
+  UpdateTier(it->second.get());
+}
+
+void AudioEncoderOpusPool::OnReceivedUplinkRecoverablePacketLossFraction(
+    int receiver_id,
+    float uplink_recoverable_packet_loss_fraction) {
+  auto it = receivers_.find(receiver_id);
+  if (it == receivers_.end())
+    return;
+  it->second->adaptor->SetUplinkRecoverablePacketLossFraction(
+      uplink_recoverable_packet_loss_fraction);
+  UpdateTier(it->second.get());
+}
+
+void AudioEncoderOpusPool::OnReceivedRtt(int receiver_id, int rtt_ms) {
+  auto it = receivers_.find(receiver_id);
+  if (it == receivers_.end())
+    return;
+  it->second->adaptor->SetRtt(rtt_ms);
+  UpdateTier(it->second.get());
+}
+
+void AudioEncoderOpusPool::OnReceivedOverhead(
+    int receiver_id,
+    size_t overhead_bytes_per_packet) {
+  auto it = receivers_.find(receiver_id);
+  if (it == receivers_.end())
+    return;
+  it->second->adaptor->SetOverhead(overhead_bytes_per_packet);
+  UpdateTier(it->second.get());
+}
+
+int AudioEncoderOpusPool::GetTier(int receiver_id) const {
+  auto it = receivers_.find(receiver_id);
+  return it == receivers_.end() ? -1 : static_cast<int>(it->second->tier);
+}
+
+size_t AudioEncoderOpusPool::NumActiveTiers() const {
+  return std::count_if(tiers_.begin(), tiers_.end(),
+                       [](const std::unique_ptr<TierState>& tier) {
+                         return tier->num_receivers > 0;
+                       });
+}
+
+std::vector<AudioEncoder::EncodedInfo> AudioEncoderOpusPool::Encode(
+    uint32_t rtp_timestamp,
+    rtc::ArrayView<const int16_t> audio,
+    std::vector<rtc::Buffer>* encoded) {
+  encoded->resize(tiers_.size());
+  std::vector<AudioEncoder::EncodedInfo> infos(tiers_.size());
+  for (size_t i = 0; i < tiers_.size(); ++i) {
+    TierState* tier = tiers_[i].get();
+    (*encoded)[i].Clear();
+    if (tier->num_receivers == 0)
+      continue;
+    if (tier->needs_reset) {
+      tier->encoder->Reset();
+      tier->needs_reset = false;
+    }
+    infos[i] = tier->encoder->Encode(rtp_timestamp, audio, &(*encoded)[i]);
+  }
+  return infos;
+}
+
+void AudioEncoderOpusPool::UpdateTier(Receiver* receiver) {
+  const AudioEncoderRuntimeConfig decision =
+      receiver->adaptor->GetEncoderRuntimeConfig();
+  if (decision.uplink_packet_loss_fraction)
+    receiver->packet_loss_fraction = *decision.uplink_packet_loss_fraction;
+
+  const int bitrate_bps = decision.bitrate_bps.value_or(
+      tiers_[receiver->tier]->tier.bitrate_bps);
+  const size_t tier = SelectTier(bitrate_bps, decision.enable_fec);
+  if (tier != receiver->tier) {
+    --tiers_[receiver->tier]->num_receivers;
+    if (tiers_[tier]->num_receivers++ == 0)
+      tiers_[tier]->needs_reset = true;
+    receiver->tier = tier;
+  }
+  UpdatePacketLossRates();
+}
+
+void AudioEncoderOpusPool::UpdatePacketLossRates() {
+  std::vector<float> packet_loss_fractions(tiers_.size(), 0.0f);
+  for (const auto& receiver : receivers_) {
+    float& fraction = packet_loss_fractions[receiver.second->tier];
+    fraction = std::max(fraction, receiver.second->packet_loss_fraction);
+  }
+  for (size_t i = 0; i < tiers_.size(); ++i) {
+    if (tiers_[i]->num_receivers > 0) {
+      tiers_[i]->encoder->OnReceivedUplinkPacketLossFraction(
+          packet_loss_fractions[i]);
+    }
+  }
+}
+
+size_t AudioEncoderOpusPool::SelectTier(int bitrate_bps,
+                                        rtc::Optional<bool> enable_fec) const {
+  // Only consider the tiers with the requested FEC setting, unless there are
+  // none.
+  const bool match_fec =
+      enable_fec &&
+      std::any_of(tiers_.begin(), tiers_.end(),
+                  [&](const std::unique_ptr<TierState>& tier) {
+                    return tier->tier.fec_enabled == *enable_fec;
+                  });
+  rtc::Optional<size_t> highest_below;
+  rtc::Optional<size_t> lowest;
+  for (size_t i = 0; i < tiers_.size(); ++i) {
+    const Tier& tier = tiers_[i]->tier;
+    if (match_fec && tier.fec_enabled != *enable_fec)
+      continue;
+    if (!lowest || tier.bitrate_bps < tiers_[*lowest]->tier.bitrate_bps)
+      lowest = rtc::Optional<size_t>(i);
+    if (tier.bitrate_bps <= bitrate_bps &&
+        (!highest_below ||
+         tier.bitrate_bps > tiers_[*highest_below]->tier.bitrate_bps)) {
+      highest_below = rtc::Optional<size_t>(i);
+    }
+  }
+  RTC_DCHECK(lowest);
+  return highest_below ? *highest_below : *lowest;
+}
+
+}  // namespace webrtc
@@ -0,0 +1,133 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_AUDIO_CODING_CODECS_OPUS_AUDIO_ENCODER_OPUS_POOL_H_
+#define WEBRTC_MODULES_AUDIO_CODING_CODECS_OPUS_AUDIO_ENCODER_OPUS_POOL_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/api/array_view.h"
+#include "webrtc/api/audio_codecs/audio_encoder.h"
+#include "webrtc/api/audio_codecs/opus/audio_encoder_opus_config.h"
+#include "webrtc/modules/audio_coding/codecs/opus/audio_encoder_opus.h"
+#include "webrtc/rtc_base/buffer.h"
+#include "webrtc/rtc_base/constructormagic.h"
+
+namespace webrtc {
+
+class RtcEventLog;
+
+// Encodes one audio source for many receivers, e.g. the mix an MCU sends to
+// every participant of a conference. Instead of one Opus encoder per receiver,
+// the pool runs one encoder per tier, a fixed bitrate and FEC setting, and
+// every receiver is served the packets of one tier. The cost of encoding then
+// grows with the number of tiers in use rather than with the number of
+// receivers.
+//
+// Each receiver has its own AudioNetworkAdaptor, fed with that receiver's
+// network metrics. Its bitrate and FEC decisions select the tier: the one
+// with the highest bitrate not above the decided bitrate, among the tiers
+// matching the FEC decision if there are any. Frame length, DTX and channel
+// decisions are ignored, since they are properties of the shared encoders.
+// The packet loss rate a tier's encoder is tuned for is the highest reported
+// by any of its receivers.
+//
+// Tiers without receivers are not encoded. An encoder is reset when it gets
+// receivers again, so a receiver that moves to such a tier gets no packet for
+// up to a frame length.
+class AudioEncoderOpusPool {
+ public:
+  struct Tier {
+    int bitrate_bps;
+    bool fec_enabled;
+  };
+
+  // |config| is used for the encoders of all tiers, except for the bitrate
+  // and FEC settings. The adaptors of the receivers are created from
+  // |audio_network_adaptor_config|, see AudioEncoder::
+  // EnableAudioNetworkAdaptor().
+  AudioEncoderOpusPool(const AudioEncoderOpusConfig& config,
+                       int payload_type,
+                       const std::vector<Tier>& tiers,
+                       const std::string& audio_network_adaptor_config,
+                       RtcEventLog* event_log);
+
+  // Dependency injection for testing.
+  AudioEncoderOpusPool(
+      const AudioEncoderOpusConfig& config,
+      int payload_type,
+      const std::vector<Tier>& tiers,
+      const std::string& audio_network_adaptor_config,
+      RtcEventLog* event_log,
+      const AudioEncoderOpus::AudioNetworkAdaptorCreator&
+          audio_network_adaptor_creator);
+
+  ~AudioEncoderOpusPool();
+
+  // Adds a receiver, initially served by the tier selected for the configured
+  // bitrate and FEC setting. Returns false if |receiver_id| is already in use
+  // or its AudioNetworkAdaptor could not be created.
+  bool AddReceiver(int receiver_id);
+  void RemoveReceiver(int receiver_id);
+
+  // Network metrics of a single receiver, see the corresponding methods of
+  // AudioEncoder. These may move the receiver to another tier.
+  void OnReceivedUplinkBandwidth(int receiver_id, int target_audio_bitrate_bps);
+  void OnReceivedUplinkPacketLossFraction(int receiver_id,
+                                          float uplink_packet_loss_fraction);
+  void OnReceivedUplinkRecoverablePacketLossFraction(
+      int receiver_id,
+      float uplink_recoverable_packet_loss_fraction);
+  void OnReceivedRtt(int receiver_id, int rtt_ms);
+  void OnReceivedOverhead(int receiver_id, size_t overhead_bytes_per_packet);
+
+  // Returns the index of the tier serving |receiver_id|, or -1 if there is no
+  // such receiver.
+  int GetTier(int receiver_id) const;
+
+  size_t num_tiers() const { return tiers_.size(); }
+  // The number of tiers with at least one receiver.
+  size_t NumActiveTiers() const;
+
+  // Encodes 10 ms of |audio| with the encoder of every tier that has
+  // receivers. Returns one EncodedInfo per tier; the payload of tier i, if
+  // any, is written to |encoded|[i], which is cleared first. Tiers that are
+  // not encoded return an empty EncodedInfo.
+  std::vector<AudioEncoder::EncodedInfo> Encode(
+      uint32_t rtp_timestamp,
+      rtc::ArrayView<const int16_t> audio,
+      std::vector<rtc::Buffer>* encoded);
+
+ private:
+  struct TierState;
+  struct Receiver;
+
+  // Selects a tier from the decision of |receiver|'s AudioNetworkAdaptor.
+  void UpdateTier(Receiver* receiver);
+  void UpdatePacketLossRates();
+  size_t SelectTier(int bitrate_bps, rtc::Optional<bool> enable_fec) const;
+
+  const AudioEncoderOpusConfig config_;
+  const std::string audio_network_adaptor_config_;
+  RtcEventLog* const event_log_;
+  const AudioEncoderOpus::AudioNetworkAdaptorCreator
+      audio_network_adaptor_creator_;
+  std::vector<std::unique_ptr<TierState>> tiers_;
+  std::map<int, std::unique_ptr<Receiver>> receivers_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(AudioEncoderOpusPool);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_AUDIO_CODING_CODECS_OPUS_AUDIO_ENCODER_OPUS_POOL_H_
@@ -0,0 +1,259 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_coding/codecs/opus/audio_encoder_opus_pool.h"
+
+#include <math.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/modules/audio_coding/audio_network_adaptor/mock/mock_audio_network_adaptor.h"
+#include "webrtc/rtc_base/random.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/test/gmock.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+using ::testing::NiceMock;
+using ::testing::Return;
+
+namespace {
+
+constexpr int kPayloadType = 111;
+constexpr int kSampleRateHz = 48000;
+constexpr size_t kSamplesPer10Ms = kSampleRateHz / 100;
+constexpr int kFrameSizeMs = 20;
+
+AudioEncoderOpusConfig CreateConfig() {
+  AudioEncoderOpusConfig config;
+  config.frame_size_ms = kFrameSizeMs;
+  config.num_channels = 1;
+  config.bitrate_bps = rtc::Optional<int>(32000);
+  config.supported_frame_lengths_ms.push_back(kFrameSizeMs);
+  return config;
+}
+
+AudioEncoderRuntimeConfig CreateDecision(int bitrate_bps, bool enable_fec) {
+  AudioEncoderRuntimeConfig decision;
+  decision.bitrate_bps = rtc::Optional<int>(bitrate_bps);
+  decision.enable_fec = rtc::Optional<bool>(enable_fec);
+  return decision;
+}
+
+// Creates pools whose receivers get mock AudioNetworkAdaptors, which are kept
+// in |adaptors| in the order they are created.
+class PoolFactory {
+ public:
+  std::unique_ptr<AudioEncoderOpusPool> Create(
+      const std::vector<AudioEncoderOpusPool::Tier>& tiers) {
+    return std::unique_ptr<AudioEncoderOpusPool>(new AudioEncoderOpusPool(
+        CreateConfig(), kPayloadType, tiers, "", nullptr,
+        [this](const std::string&, RtcEventLog*) {
+          std::unique_ptr<MockAudioNetworkAdaptor> adaptor(
+              new NiceMock<MockAudioNetworkAdaptor>());
+          adaptors.push_back(adaptor.get());
+          return adaptor;
+        }));
+  }
+
+  // Makes the adaptor of the |index|th receiver decide on |decision| and
+  // reports a bandwidth update, which makes the pool act on it.
+  void Decide(AudioEncoderOpusPool* pool,
+              int receiver_id,
+              size_t index,
+              const AudioEncoderRuntimeConfig& decision) {
+    ON_CALL(*adaptors[index], GetEncoderRuntimeConfig())
+        .WillByDefault(Return(decision));
+    pool->OnReceivedUplinkBandwidth(receiver_id,
+                                    decision.bitrate_bps.value_or(0));
+  }
+
+  std::vector<MockAudioNetworkAdaptor*> adaptors;
+};
+
+// A 440 Hz tone with some noise.
+std::vector<int16_t> CreateAudio(size_t num_samples) {
+  Random random(0x1234);
+  std::vector<int16_t> audio(num_samples);
+  for (size_t i = 0; i < num_samples; ++i) {
+    audio[i] = static_cast<int16_t>(
+        8000 * sin(2 * M_PI * 440 * i / kSampleRateHz) +
+        random.Rand(-1000, 1000));
+  }
+  return audio;
+}
+
+}  // namespace
+
+TEST(AudioEncoderOpusPoolTest, SelectsTierFromBitrateDecision) {
+  PoolFactory factory;
+  auto pool = factory.Create({{16000, false}, {32000, false}, {64000, false}});
+  ASSERT_TRUE(pool->AddReceiver(7));
+  EXPECT_EQ(1, pool->GetTier(7));
+
+  factory.Decide(pool.get(), 7, 0, CreateDecision(40000, false));
+  EXPECT_EQ(1, pool->GetTier(7));
+  factory.Decide(pool.get(), 7, 0, CreateDecision(64000, false));
+  EXPECT_EQ(2, pool->GetTier(7));
+  // Below the lowest tier, the lowest tier is used.
+  factory.Decide(pool.get(), 7, 0, CreateDecision(8000, false));
+  EXPECT_EQ(0, pool->GetTier(7));
+}
+
+TEST(AudioEncoderOpusPoolTest, PrefersTiersMatchingFecDecision) {
+  PoolFactory factory;
+  auto pool = factory.Create({{24000, true}, {32000, false}});
+  ASSERT_TRUE(pool->AddReceiver(1));
+
+  factory.Decide(pool.get(), 1, 0, CreateDecision(40000, true));
+  EXPECT_EQ(0, pool->GetTier(1));
+  factory.Decide(pool.get(), 1, 0, CreateDecision(40000, false));
+  EXPECT_EQ(1, pool->GetTier(1));
+
+  // Without a bitrate decision, the receiver keeps its bitrate.
+  AudioEncoderRuntimeConfig decision;
+  decision.enable_fec = rtc::Optional<bool>(true);
+  factory.Decide(pool.get(), 1, 0, decision);
+  EXPECT_EQ(0, pool->GetTier(1));
+}
+
+TEST(AudioEncoderOpusPoolTest, FallsBackToAllTiersWithoutFecMatch) {
+  PoolFactory factory;
+  auto pool = factory.Create({{16000, false}, {32000, false}});
+  ASSERT_TRUE(pool->AddReceiver(1));
+  factory.Decide(pool.get(), 1, 0, CreateDecision(20000, true));
+  EXPECT_EQ(0, pool->GetTier(1));
+}
+
+TEST(AudioEncoderOpusPoolTest, AddsAndRemovesReceivers) {
+  PoolFactory factory;
+  auto pool = factory.Create({{16000, false}, {32000, false}});
+  EXPECT_EQ(0u, pool->NumActiveTiers());
+  EXPECT_TRUE(pool->AddReceiver(1));
+  EXPECT_FALSE(pool->AddReceiver(1));
+  EXPECT_TRUE(pool->AddReceiver(2));
+  EXPECT_EQ(1u, pool->NumActiveTiers());
+
+  factory.Decide(pool.get(), 2, 1, CreateDecision(16000, false));
+  EXPECT_EQ(2u, pool->NumActiveTiers());
+  pool->RemoveReceiver(1);
+  EXPECT_EQ(-1, pool->GetTier(1));
+  EXPECT_EQ(1u, pool->NumActiveTiers());
+  EXPECT_EQ(0, pool->GetTier(2));
+}
+
+TEST(AudioEncoderOpusPoolTest, EncodesOnlyActiveTiers) {
+  PoolFactory factory;
+  auto pool = factory.Create({{16000, false}, {32000, false}, {64000, true}});
+  for (int id = 0; id < 10; ++id)
+    ASSERT_TRUE(pool->AddReceiver(id));
+  for (int id = 0; id < 5; ++id)
+    factory.Decide(pool.get(), id, id, CreateDecision(64000, true));
+  EXPECT_EQ(2u, pool->NumActiveTiers());
+
+  const std::vector<int16_t> audio = CreateAudio(kSamplesPer10Ms);
+  std::vector<rtc::Buffer> encoded;
+  std::vector<AudioEncoder::EncodedInfo> infos;
+  for (int i = 0; i < kFrameSizeMs / 10; ++i)
+    infos = pool->Encode(i * kSamplesPer10Ms, audio, &encoded);
+  ASSERT_EQ(3u, infos.size());
+  ASSERT_EQ(3u, encoded.size());
+  EXPECT_EQ(0u, infos[0].encoded_bytes);
+  EXPECT_EQ(0u, encoded[0].size());
+  for (size_t tier : {1, 2}) {
+    EXPECT_GT(infos[tier].encoded_bytes, 0u);
+    EXPECT_EQ(infos[tier].encoded_bytes, encoded[tier].size());
+    EXPECT_EQ(0u, infos[tier].encoded_timestamp);
+    EXPECT_EQ(kPayloadType, infos[tier].payload_type);
+  }
+  // The higher bitrate tier produces the larger packet.
+  EXPECT_GT(encoded[2].size(), encoded[1].size());
+}
+
+TEST(AudioEncoderOpusPoolTest, ResetsTierThatGetsReceiversAgain) {
+  PoolFactory factory;
+  auto pool = factory.Create({{16000, false}, {32000, false}});
+  ASSERT_TRUE(pool->AddReceiver(1));
+  const std::vector<int16_t> audio = CreateAudio(kSamplesPer10Ms);
+  std::vector<rtc::Buffer> encoded;
+
+  // Leave half a packet in the encoder of tier 1 before it loses its receiver.
+  pool->Encode(0, audio, &encoded);
+  factory.Decide(pool.get(), 1, 0, CreateDecision(16000, false));
+  pool->Encode(kSamplesPer10Ms, audio, &encoded);
+  factory.Decide(pool.get(), 1, 0, CreateDecision(32000, false));
+
+  // Tier 1 starts a new packet rather than completing the old one.
+  std::vector<AudioEncoder::EncodedInfo> infos =
+      pool->Encode(2 * kSamplesPer10Ms, audio, &encoded);
+  EXPECT_EQ(0u, infos[1].encoded_bytes);
+  infos = pool->Encode(3 * kSamplesPer10Ms, audio, &encoded);
+  EXPECT_GT(infos[1].encoded_bytes, 0u);
+  EXPECT_EQ(2 * kSamplesPer10Ms, infos[1].encoded_timestamp);
+}
+
+// Compares the time spent encoding one second of audio for each receiver with
+// an encoder of its own, to the time spent by a pool with three tiers.
+// Disabled since it only reports timings; run it with
+// --gtest_also_run_disabled_tests.
+TEST(AudioEncoderOpusPoolTest, DISABLED_Performance) {
+  // One second of audio.
+  const int kNumFrames = 100;
+  const std::vector<AudioEncoderOpusPool::Tier> kTiers = {
+      {16000, true}, {32000, false}, {64000, false}};
+  const std::vector<int16_t> audio = CreateAudio(kSamplesPer10Ms);
+
+  for (int num_receivers : {1, 4, 16, 64}) {
+    const std::string trace = std::to_string(num_receivers) + "_receivers";
+
+    std::vector<std::unique_ptr<AudioEncoderOpus>> encoders;
+    for (int i = 0; i < num_receivers; ++i) {
+      AudioEncoderOpusConfig config = CreateConfig();
+      config.bitrate_bps = rtc::Optional<int>(16000 + 1000 * (i % 50));
+      encoders.emplace_back(new AudioEncoderOpus(config, kPayloadType));
+    }
+    rtc::Buffer encoded;
+    int64_t start_time_us = rtc::TimeMicros();
+    for (int i = 0; i < kNumFrames; ++i) {
+      for (auto& encoder : encoders) {
+        encoded.Clear();
+        encoder->Encode(i * kSamplesPer10Ms, audio, &encoded);
+      }
+    }
+    const int64_t per_receiver_time_us = rtc::TimeMicros() - start_time_us;
+
+    PoolFactory factory;
+    auto pool = factory.Create(kTiers);
+    for (int i = 0; i < num_receivers; ++i) {
+      ASSERT_TRUE(pool->AddReceiver(i));
+      factory.Decide(pool.get(), i, i,
+                     CreateDecision(16000 + 1000 * (i % 50), i % 2 == 0));
+    }
+    std::vector<rtc::Buffer> pool_encoded;
+    start_time_us = rtc::TimeMicros();
+    for (int i = 0; i < kNumFrames; ++i)
+      pool->Encode(i * kSamplesPer10Ms, audio, &pool_encoded);
+    const int64_t pool_time_us = rtc::TimeMicros() - start_time_us;
+
+    test::PrintResult("opus_per_receiver_encode_time", "", trace,
+                      static_cast<size_t>(per_receiver_time_us / 1000),
+                      "ms_per_s", false);
+    test::PrintResult("opus_pool_encode_time", "", trace,
+                      static_cast<size_t>(pool_time_us / 1000),
+                      "ms_per_s", false);
+    test::PrintResult("opus_pool_active_tiers", "", trace,
+                      pool->NumActiveTiers(), "tiers", false);
+  }
+}
+
+}  // namespace webrtc
@@ -0,0 +1,240 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "webrtc/modules/audio_coding/neteq/include/neteq.h"
+#include "webrtc/modules/audio_coding/neteq/tools/neteq_batch_simulator.h"
+#include "webrtc/modules/audio_coding/neteq/tools/neteq_packet_source_input.h"
+#include "webrtc/modules/audio_coding/neteq/tools/rtp_file_source.h"
+#include "webrtc/rtc_base/checks.h"
+#include "webrtc/rtc_base/flags.h"
+#include "webrtc/rtc_base/format_macros.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/test/testsupport/fileutils.h"
+
+DEFINE_string(replacement_audio_file, "",
+              "A 48 kHz mono PCM file that the fake decoder reads from. "
+              "Required.");
+DEFINE_string(config_file, "",
+              "A file with one NetEq configuration per line: a name followed "
+              "by key=value pairs. The keys are max_packets_in_buffer, "
+              "max_delay_ms, minimum_delay_ms and enable_fast_accelerate. "
+              "Lines starting with # are ignored. If not set, only the "
+              "default configuration is run.");
+DEFINE_string(csv_file, "",
+              "If set, the results of every run are written to this file.");
+DEFINE_int(num_threads, 0,
+           "Number of simulations to run at a time. 0 means one per core.");
+DEFINE_bool(help, false, "Prints this message.");
+
+namespace webrtc {
+namespace test {
+namespace {
+
+// The default RTP header extension IDs and payload types of neteq_rtpplay.
+const NetEqPacketSourceInput::RtpHeaderExtensionMap kRtpExtensions = {
+    {1, kRtpExtensionAudioLevel},
+    {3, kRtpExtensionAbsoluteSendTime},
+    {5, kRtpExtensionTransportSequenceNumber}};
+
+NetEqBatchSimulator::Options DefaultOptions() {
+  NetEqBatchSimulator::Options options;
+  options.codecs = {
+      {13, std::make_pair(NetEqDecoder::kDecoderCNGnb, "cng-nb")},
+      {98, std::make_pair(NetEqDecoder::kDecoderCNGwb, "cng-wb")},
+      {99, std::make_pair(NetEqDecoder::kDecoderCNGswb32kHz, "cng-swb32")},
+      {100, std::make_pair(NetEqDecoder::kDecoderCNGswb48kHz, "cng-swb48")}};
+  options.comfort_noise_types = {13, 98, 99, 100};
+  // G.722, RED and DTMF can't be replaced.
+  options.forbidden_types = {9, 117, 106, 114, 115, 116};
+  return options;
+}
+
+std::unique_ptr<NetEqInput> CreateInput(const std::string& file_name) {
+  if (!FileExists(file_name))
+    return nullptr;
+  if (RtpFileSource::ValidRtpDump(file_name) ||
+      RtpFileSource::ValidPcap(file_name)) {
+    return std::unique_ptr<NetEqInput>(
+        new NetEqRtpDumpInput(file_name, kRtpExtensions));
+  }
+  return std::unique_ptr<NetEqInput>(
+      new NetEqEventLogInput(file_name, kRtpExtensions));
+}
+
+// Parses a line of the config file, e.g.,
+// "min_delay_100 minimum_delay_ms=100 max_packets_in_buffer=100".
+bool ParseConfig(const std::string& line, NetEqBatchSimulator::Config* config) {
+  std::istringstream stream(line);
+  if (!(stream >> config->name))
+    return false;
+  std::string parameter;
+  while (stream >> parameter) {
+    const size_t equals = parameter.find('=');
+    if (equals == std::string::npos)
+      return false;
+    const std::string key = parameter.substr(0, equals);
+    char* end;
+    const long value =  // NOLINT(runtime/int)
+        strtol(parameter.c_str() + equals + 1, &end, 10);
+    if (*end != '\0' || end == parameter.c_str() + equals + 1 || value < 0)
+      return false;
+    if (key == "max_packets_in_buffer") {
+      config->neteq_config.max_packets_in_buffer = value;
+    } else if (key == "max_delay_ms") {
+      config->neteq_config.max_delay_ms = value;
+    } else if (key == "minimum_delay_ms") {
+      config->minimum_delay_ms = value;
+    } else if (key == "enable_fast_accelerate") {
+      config->neteq_config.enable_fast_accelerate = value != 0;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ReadConfigs(const std::string& file_name,
+                 std::vector<NetEqBatchSimulator::Config>* configs) {
+  std::ifstream file(file_name);
+  if (!file)
+    return false;
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#')
+      continue;
+    NetEqBatchSimulator::Config config;
+    if (!ParseConfig(line, &config)) {
+      fprintf(stderr, "Invalid configuration: %s\n", line.c_str());
+      return false;
+    }
+    configs->push_back(config);
+  }
+  return true;
+}
+
+void WriteCsv(const std::string& file_name,
+              const std::vector<std::string>& logs,
+              const std::vector<NetEqBatchSimulator::Config>& configs,
+              const std::vector<NetEqBatchSimulator::Result>& results) {
+  FILE* file = fopen(file_name.c_str(), "w");
+  RTC_CHECK(file) << "Cannot open " << file_name;
+  fprintf(file,
+          "log,config,valid,output_duration_ms,run_time_us,"
+          "current_buffer_size_ms,preferred_buffer_size_ms,packet_loss_rate,"
+          "expand_rate,speech_expand_rate,preemptive_rate,accelerate_rate,"
+          "mean_waiting_time_ms,max_waiting_time_ms,total_samples_received,"
+          "concealed_samples\n");
+  for (const NetEqBatchSimulator::Result& result : results) {
+    fprintf(file,
+            "%s,%s,%d,%" PRId64 ",%" PRId64 ",%f,%f,%f,%f,%f,%f,%f,%f,%f,"
+            "%" PRIu64 ",%" PRIu64 "\n",
+            logs[result.log_index].c_str(),
+            configs[result.config_index].name.c_str(), result.valid ? 1 : 0,
+            result.output_duration_ms, result.run_time_us,
+            result.current_buffer_size_ms, result.preferred_buffer_size_ms,
+            result.packet_loss_rate, result.expand_rate,
+            result.speech_expand_rate, result.preemptive_rate,
+            result.accelerate_rate, result.mean_waiting_time_ms,
+            result.max_waiting_time_ms,
+            result.lifetime_stats.total_samples_received,
+            result.lifetime_stats.concealed_samples);
+  }
+  fclose(file);
+}
+
+int RunBatch(int argc, char* argv[]) {
+  const std::string program_name = argv[0];
+  const std::string usage =
+      "Tool for running NetEq configurations over many RTP dumps or event "
+      "logs, in parallel and with a fake decoder, to compare their jitter "
+      "buffer statistics.\n"
+      "Run " + program_name + " --help for usage.\n"
+      "Example usage:\n" + program_name +
+      " --replacement_audio_file=speech_48kHz.pcm --config_file=sweep.txt "
+      "logs/*.rtp\n";
+  if (rtc::FlagList::SetFlagsFromCommandLine(&argc, argv, true)) {
+    return 1;
+  }
+  if (FLAG_help || argc < 2 || strlen(FLAG_replacement_audio_file) == 0) {
+    std::cout << usage;
+    if (FLAG_help)
+      rtc::FlagList::Print(nullptr, false);
+    return 0;
+  }
+  RTC_CHECK(FileExists(FLAG_replacement_audio_file))
+      << "Cannot open " << FLAG_replacement_audio_file;
+  RTC_CHECK_GE(FLAG_num_threads, 0);
+
+  const std::vector<std::string> logs(argv + 1, argv + argc);
+  std::vector<NetEqBatchSimulator::Config> configs;
+  if (strlen(FLAG_config_file) > 0) {
+    RTC_CHECK(ReadConfigs(FLAG_config_file, &configs))
+        << "Cannot read " << FLAG_config_file;
+    RTC_CHECK(!configs.empty()) << "No configurations in " << FLAG_config_file;
+  } else {
+    configs.resize(1);
+    configs[0].name = "default";
+  }
+
+  NetEqBatchSimulator::Options options = DefaultOptions();
+  options.replacement_audio_file = FLAG_replacement_audio_file;
+  options.num_threads = FLAG_num_threads;
+  NetEqBatchSimulator simulator(options, &CreateInput);
+
+  const int64_t start_time_us = rtc::TimeMicros();
+  const std::vector<NetEqBatchSimulator::Result> results =
+      simulator.Run(logs, configs);
+  const double elapsed_s = (rtc::TimeMicros() - start_time_us) / 1e6;
+
+  int64_t output_duration_ms = 0;
+  size_t num_invalid = 0;
+  for (const NetEqBatchSimulator::Result& result : results) {
+    output_duration_ms += result.output_duration_ms;
+    if (!result.valid) {
+      fprintf(stderr, "Skipping %s with %s: unreadable or NetEq errors\n",
+              logs[result.log_index].c_str(),
+              configs[result.config_index].name.c_str());
+      ++num_invalid;
+    }
+  }
+
+  NetEqBatchSimulator::PrintSummaries(
+      NetEqBatchSimulator::Summarize(configs, results), stdout);
+  printf("\n%" PRIuS " logs x %" PRIuS " configurations (%" PRIuS
+         " invalid) in %.2f s: %.2f logs/s, %.2f simulations/s, "
+         "%.0f times real time\n",
+         logs.size(), configs.size(), num_invalid, elapsed_s,
+         logs.size() / elapsed_s, results.size() / elapsed_s,
+         output_duration_ms / 1000.0 / elapsed_s);
+
+  if (strlen(FLAG_csv_file) > 0)
+    WriteCsv(FLAG_csv_file, logs, configs, results);
+  return 0;
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace webrtc
+
+int main(int argc, char* argv[]) {
+  return webrtc::test::RunBatch(argc, argv);
+}
@@ -0,0 +1,282 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_coding/neteq/tools/neteq_batch_simulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "webrtc/modules/audio_coding/neteq/tools/fake_decode_from_file.h"
+#include "webrtc/modules/audio_coding/neteq/tools/input_audio_file.h"
+#include "webrtc/modules/audio_coding/neteq/tools/neteq_replacement_input.h"
+#include "webrtc/rtc_base/checks.h"
+#include "webrtc/rtc_base/format_macros.h"
+#include "webrtc/rtc_base/parallel_for.h"
+#include "webrtc/rtc_base/ptr_util.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/system_wrappers/include/cpu_info.h"
+
+namespace webrtc {
+namespace test {
+
+namespace {
+
+// The rate of the replacement audio file.
+constexpr int kReplacementSampleRateHz = 48000;
+
+// Same sampling of the network statistics as in neteq_rtpplay: once every
+// 100 GetAudio() calls, i.e., once per second of output. Each call resets the
+// rates, so every sample covers the last second.
+class StatsCollector : public NetEqGetAudioCallback {
+ public:
+  void BeforeGetAudio(NetEq* neteq) override {}
+
+  void AfterGetAudio(int64_t time_now_ms,
+                     const AudioFrame& audio_frame,
+                     bool muted,
+                     NetEq* neteq) override {
+    if (++counter_ < 100)
+      return;
+    counter_ = 0;
+    NetEqNetworkStatistics stats;
+    RTC_CHECK_EQ(neteq->NetworkStatistics(&stats), 0);
+    ++num_samples_;
+    sum_.current_buffer_size_ms += stats.current_buffer_size_ms;
+    sum_.preferred_buffer_size_ms += stats.preferred_buffer_size_ms;
+    sum_.packet_loss_rate += stats.packet_loss_rate / 16384.0;
+    sum_.expand_rate += stats.expand_rate / 16384.0;
+    sum_.speech_expand_rate += stats.speech_expand_rate / 16384.0;
+    sum_.preemptive_rate += stats.preemptive_rate / 16384.0;
+    sum_.accelerate_rate += stats.accelerate_rate / 16384.0;
+    sum_.mean_waiting_time_ms += stats.mean_waiting_time_ms;
+    sum_.max_waiting_time_ms =
+        std::max(sum_.max_waiting_time_ms,
+                 static_cast<double>(stats.max_waiting_time_ms));
+  }
+
+  // Writes the averages to |result|.
+  void GetAverages(NetEqBatchSimulator::Result* result) const {
+    if (num_samples_ == 0)
+      return;
+    result->current_buffer_size_ms =
+        sum_.current_buffer_size_ms / num_samples_;
+    result->preferred_buffer_size_ms =
+        sum_.preferred_buffer_size_ms / num_samples_;
+    result->packet_loss_rate = sum_.packet_loss_rate / num_samples_;
+    result->expand_rate = sum_.expand_rate / num_samples_;
+    result->speech_expand_rate = sum_.speech_expand_rate / num_samples_;
+    result->preemptive_rate = sum_.preemptive_rate / num_samples_;
+    result->accelerate_rate = sum_.accelerate_rate / num_samples_;
+    result->mean_waiting_time_ms = sum_.mean_waiting_time_ms / num_samples_;
+    result->max_waiting_time_ms = sum_.max_waiting_time_ms;
+  }
+
+ private:
+  size_t counter_ = 0;
+  size_t num_samples_ = 0;
+  NetEqBatchSimulator::Result sum_;
+};
+
+// Counts the errors of NetEq::InsertPacket() and NetEq::GetAudio().
+class ErrorCounter : public NetEqTestErrorCallback {
+ public:
+  void OnInsertPacketError(const NetEqInput::PacketData& packet) override {
+    ++num_errors_;
+  }
+  void OnGetAudioError() override { ++num_errors_; }
+
+  size_t num_errors() const { return num_errors_; }
+
+ private:
+  size_t num_errors_ = 0;
+};
+
+// Returns the |percentile| of |values| by the nearest-rank method.
+double Percentile(std::vector<double> values, double percentile) {
+  RTC_DCHECK(!values.empty());
+  const size_t rank = static_cast<size_t>(
+      std::max(std::ceil(percentile / 100 * values.size()), 1.0));
+  std::nth_element(values.begin(), values.begin() + rank - 1, values.end());
+  return values[rank - 1];
+}
+
+}  // namespace
+
+NetEqBatchSimulator::NetEqBatchSimulator(const Options& options,
+                                         InputFactory input_factory)
+    : options_(options), input_factory_(std::move(input_factory)) {
+  RTC_CHECK(input_factory_);
+  // Use the largest payload type that isn't used for anything else.
+  int replacement_payload_type = 127;
+  while (options_.codecs.count(replacement_payload_type) != 0 ||
+         options_.comfort_noise_types.count(replacement_payload_type) != 0 ||
+         options_.forbidden_types.count(replacement_payload_type) != 0) {
+    --replacement_payload_type;
+    RTC_CHECK_GE(replacement_payload_type, 0);
+  }
+  replacement_payload_type_ = static_cast<uint8_t>(replacement_payload_type);
+}
+
+NetEqBatchSimulator::~NetEqBatchSimulator() = default;
+
+std::vector<NetEqBatchSimulator::Result> NetEqBatchSimulator::Run(
+    const std::vector<std::string>& logs,
+    const std::vector<Config>& configs) const {
+  std::vector<Result> results(logs.size() * configs.size());
+  if (results.empty())
+    return results;
+
+  // The simulations are independent, so the results don't depend on the
+  // number of threads.
+  const int num_threads =
+      options_.num_threads > 0
+          ? options_.num_threads
+          : static_cast<int>(CpuInfo::DetectNumberOfCores());
+  rtc::ParallelFor(results.size(), num_threads, "NetEqBatch", [&](size_t i) {
+    const size_t log_index = i / configs.size();
+    const size_t config_index = i % configs.size();
+    Result& result = results[i];
+    result = Simulate(logs[log_index], configs[config_index]);
+    result.log_index = log_index;
+    result.config_index = config_index;
+  });
+  return results;
+}
+
+NetEqBatchSimulator::Result NetEqBatchSimulator::Simulate(
+    const std::string& log,
+    const Config& config) const {
+  Result result;
+  const int64_t start_time_us = rtc::TimeMicros();
+  std::unique_ptr<NetEqInput> input = input_factory_(log);
+  if (!input || !input->NextPacketTime())
+    return result;
+  input.reset(new NetEqReplacementInput(
+      std::move(input), replacement_payload_type_,
+      options_.comfort_noise_types, options_.forbidden_types));
+
+  FakeDecodeFromFile replacement_decoder(
+      rtc::MakeUnique<InputAudioFile>(options_.replacement_audio_file),
+      kReplacementSampleRateHz, false);
+  NetEqTest::ExternalDecoderInfo ext_dec_info = {
+      &replacement_decoder, NetEqDecoder::kDecoderArbitrary,
+      "replacement codec"};
+  NetEqTest::ExtDecoderMap ext_codecs;
+  ext_codecs[replacement_payload_type_] = ext_dec_info;
+
+  StatsCollector stats_collector;
+  ErrorCounter error_counter;
+  NetEqTest::Callbacks callbacks;
+  callbacks.error_callback = &error_counter;
+  callbacks.get_audio_callback = &stats_collector;
+  NetEq::Config neteq_config = config.neteq_config;
+  neteq_config.sample_rate_hz = kReplacementSampleRateHz;
+  NetEqTest test(neteq_config, options_.codecs, ext_codecs, std::move(input),
+                 nullptr, callbacks);
+  if (config.minimum_delay_ms > 0)
+    RTC_CHECK(test.neteq()->SetMinimumDelay(config.minimum_delay_ms));
+
+  const int64_t output_duration_ms = test.Run();
+  // The statistics of a run with errors don't show how NetEq handles the
+  // log, so it is left out like a log that can't be read.
+  if (error_counter.num_errors() > 0)
+    return result;
+  result.valid = true;
+  result.output_duration_ms = output_duration_ms;
+  stats_collector.GetAverages(&result);
+  result.lifetime_stats = test.neteq()->GetLifetimeStatistics();
+  result.run_time_us = rtc::TimeMicros() - start_time_us;
+  return result;
+}
+
+// static
+std::vector<NetEqBatchSimulator::Summary> NetEqBatchSimulator::Summarize(
+    const std::vector<Config>& configs,
+    const std::vector<Result>& results) {
+  std::vector<Summary> summaries(configs.size());
+  std::vector<std::vector<double>> preferred_buffer_sizes(configs.size());
+  std::vector<uint64_t> total_samples(configs.size(), 0);
+  std::vector<uint64_t> concealed_samples(configs.size(), 0);
+  for (const Result& result : results) {
+    if (!result.valid)
+      continue;
+    RTC_CHECK_LT(result.config_index, configs.size());
+    Summary& summary = summaries[result.config_index];
+    ++summary.num_logs;
+    summary.output_duration_ms += result.output_duration_ms;
+    summary.mean_preferred_buffer_size_ms += result.preferred_buffer_size_ms;
+    summary.mean_current_buffer_size_ms += result.current_buffer_size_ms;
+    summary.mean_waiting_time_ms += result.mean_waiting_time_ms;
+    summary.packet_loss_rate += result.packet_loss_rate;
+    summary.expand_rate += result.expand_rate;
+    summary.speech_expand_rate += result.speech_expand_rate;
+    summary.preemptive_rate += result.preemptive_rate;
+    summary.accelerate_rate += result.accelerate_rate;
+    preferred_buffer_sizes[result.config_index].push_back(
+        result.preferred_buffer_size_ms);
+    total_samples[result.config_index] +=
+        result.lifetime_stats.total_samples_received;
+    concealed_samples[result.config_index] +=
+        result.lifetime_stats.concealed_samples;
+  }
+
+  for (size_t i = 0; i < configs.size(); ++i) {
+    Summary& summary = summaries[i];
+    summary.config_name = configs[i].name;
+    if (summary.num_logs == 0)
+      continue;
+    const double num_logs = summary.num_logs;
+    summary.mean_preferred_buffer_size_ms /= num_logs;
+    summary.mean_current_buffer_size_ms /= num_logs;
+    summary.mean_waiting_time_ms /= num_logs;
+    summary.packet_loss_rate /= num_logs;
+    summary.expand_rate /= num_logs;
+    summary.speech_expand_rate /= num_logs;
+    summary.preemptive_rate /= num_logs;
+    summary.accelerate_rate /= num_logs;
+    summary.p95_preferred_buffer_size_ms =
+        Percentile(std::move(preferred_buffer_sizes[i]), 95);
+    if (total_samples[i] > 0) {
+      summary.concealed_rate =
+          static_cast<double>(concealed_samples[i]) / total_samples[i];
+    }
+  }
+  return summaries;
+}
+
+// static
+void NetEqBatchSimulator::PrintSummaries(const std::vector<Summary>& summaries,
+                                         FILE* file) {
+  size_t name_width = 6;
+  for (const Summary& summary : summaries)
+    name_width = std::max(name_width, summary.config_name.size());
+  const int width = static_cast<int>(name_width);
+  fprintf(file,
+          "%-*s %6s %9s %9s %9s %9s %8s %8s %8s %8s %8s %8s\n", width,
+          "config", "logs", "pref_ms", "p95_ms", "buf_ms", "wait_ms", "loss%",
+          "expand%", "sp_exp%", "preemp%", "accel%", "conceal%");
+  for (const Summary& summary : summaries) {
+    fprintf(file,
+            "%-*s %6" PRIuS " %9.1f %9.1f %9.1f %9.1f %8.3f %8.3f %8.3f "
+            "%8.3f %8.3f %8.3f\n",
+            width, summary.config_name.c_str(), summary.num_logs,
+            summary.mean_preferred_buffer_size_ms,
+            summary.p95_preferred_buffer_size_ms,
+            summary.mean_current_buffer_size_ms, summary.mean_waiting_time_ms,
+            100.0 * summary.packet_loss_rate, 100.0 * summary.expand_rate,
+            100.0 * summary.speech_expand_rate,
+            100.0 * summary.preemptive_rate, 100.0 * summary.accelerate_rate,
+            100.0 * summary.concealed_rate);
+  }
+}
+
+}  // namespace test
+}  // namespace webrtc
@@ -0,0 +1,135 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_AUDIO_CODING_NETEQ_TOOLS_NETEQ_BATCH_SIMULATOR_H_
+#define WEBRTC_MODULES_AUDIO_CODING_NETEQ_TOOLS_NETEQ_BATCH_SIMULATOR_H_
+
+#include <stdio.h>
+
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "webrtc/modules/audio_coding/neteq/include/neteq.h"
+#include "webrtc/modules/audio_coding/neteq/tools/neteq_input.h"
+#include "webrtc/modules/audio_coding/neteq/tools/neteq_test.h"
+
+namespace webrtc {
+namespace test {
+
+// Runs NetEq over many input logs and configurations, in parallel, and
+// collects the jitter buffer statistics of each run. The audio payloads are
+// replaced by fake encodings, which FakeDecodeFromFile "decodes" by reading
+// from a PCM file. Hence, no codec is run, and the simulations only measure
+// NetEq's buffering, time stretching and concealment decisions.
+class NetEqBatchSimulator {
+ public:
+  // Creates the input for a log, or returns null if the log can't be read.
+  // Called from the simulation threads, once for every run of the log.
+  using InputFactory =
+      std::function<std::unique_ptr<NetEqInput>(const std::string& log)>;
+
+  struct Config {
+    std::string name;
+    NetEq::Config neteq_config;
+    // Applied with NetEq::SetMinimumDelay() if non-zero.
+    int minimum_delay_ms = 0;
+  };
+
+  struct Options {
+    // 48 kHz mono PCM file that the fake decoder reads from.
+    std::string replacement_audio_file;
+    // Decoders for the packets that are not replaced, such as comfort noise.
+    NetEqTest::DecoderMap codecs;
+    // Packets with these payload types are not replaced. See
+    // NetEqReplacementInput.
+    std::set<uint8_t> comfort_noise_types;
+    std::set<uint8_t> forbidden_types;
+    // The number of simulations to run at a time. 0 means one per core.
+    int num_threads = 0;
+  };
+
+  // The result of running one configuration on one log.
+  struct Result {
+    size_t log_index = 0;
+    size_t config_index = 0;
+    // False if the log could not be read, or if NetEq reported an error while
+    // running it. All values below are then zero.
+    bool valid = false;
+    int64_t output_duration_ms = 0;
+    int64_t run_time_us = 0;
+    // NetEq::NetworkStatistics(), averaged over one-second intervals. The
+    // rates are fractions, not Q14.
+    double current_buffer_size_ms = 0.0;
+    double preferred_buffer_size_ms = 0.0;
+    double packet_loss_rate = 0.0;
+    double expand_rate = 0.0;
+    double speech_expand_rate = 0.0;
+    double preemptive_rate = 0.0;
+    double accelerate_rate = 0.0;
+    double mean_waiting_time_ms = 0.0;
+    double max_waiting_time_ms = 0.0;
+    NetEqLifetimeStatistics lifetime_stats;
+  };
+
+  // The results of one configuration over all valid logs. Every log has the
+  // same weight in the means.
+  struct Summary {
+    std::string config_name;
+    size_t num_logs = 0;
+    int64_t output_duration_ms = 0;
+    double mean_preferred_buffer_size_ms = 0.0;
+    // 95th percentile of the per-log mean preferred buffer sizes.
+    double p95_preferred_buffer_size_ms = 0.0;
+    double mean_current_buffer_size_ms = 0.0;
+    double mean_waiting_time_ms = 0.0;
+    double packet_loss_rate = 0.0;
+    double expand_rate = 0.0;
+    double speech_expand_rate = 0.0;
+    double preemptive_rate = 0.0;
+    double accelerate_rate = 0.0;
+    // Concealed samples over all received samples, from the lifetime
+    // statistics.
+    double concealed_rate = 0.0;
+  };
+
+  NetEqBatchSimulator(const Options& options, InputFactory input_factory);
+  ~NetEqBatchSimulator();
+
+  // Runs every configuration on every log. The results are ordered by log,
+  // and then by configuration.
+  std::vector<Result> Run(const std::vector<std::string>& logs,
+                          const std::vector<Config>& configs) const;
+
+  // Returns one summary per configuration, in the order of |configs|.
+  static std::vector<Summary> Summarize(const std::vector<Config>& configs,
+                                        const std::vector<Result>& results);
+
+  // Prints the summaries as a table, one configuration per row.
+  static void PrintSummaries(const std::vector<Summary>& summaries,
+                             FILE* file);
+
+  uint8_t replacement_payload_type() const {
+    return replacement_payload_type_;
+  }
+
+ private:
+  Result Simulate(const std::string& log, const Config& config) const;
+
+  const Options options_;
+  const InputFactory input_factory_;
+  uint8_t replacement_payload_type_;
+};
+
+}  // namespace test
+}  // namespace webrtc
+#endif  // WEBRTC_MODULES_AUDIO_CODING_NETEQ_TOOLS_NETEQ_BATCH_SIMULATOR_H_
@@ -0,0 +1,276 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_coding/neteq/tools/neteq_batch_simulator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "webrtc/rtc_base/random.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/fileutils.h"
+
+namespace webrtc {
+namespace test {
+
+namespace {
+
+constexpr uint8_t kPayloadType = 111;
+// No decoder is registered for it.
+constexpr uint8_t kComfortNoisePayloadType = 13;
+constexpr int64_t kPacketIntervalMs = 20;
+constexpr int64_t kOutputPeriodMs = 10;
+constexpr int64_t kDurationMs = 10000;
+
+// Sends a 20 ms packet every 20 ms, which arrives after a random delay of up
+// to |max_jitter_ms|. The packets arrive in order.
+class JitteryInput : public NetEqInput {
+ public:
+  JitteryInput(int max_jitter_ms, uint8_t payload_type)
+      : random_(max_jitter_ms + 1),
+        max_jitter_ms_(max_jitter_ms),
+        payload_type_(payload_type) {
+    CreatePacket();
+  }
+
+  rtc::Optional<int64_t> NextPacketTime() const override {
+    return packet_ ? rtc::Optional<int64_t>(
+                         static_cast<int64_t>(packet_->time_ms))
+                   : rtc::Optional<int64_t>();
+  }
+
+  rtc::Optional<int64_t> NextOutputEventTime() const override {
+    return rtc::Optional<int64_t>(next_output_event_ms_);
+  }
+
+  std::unique_ptr<PacketData> PopPacket() override {
+    std::unique_ptr<PacketData> packet = std::move(packet_);
+    CreatePacket();
+    return packet;
+  }
+
+  void AdvanceOutputEvent() override {
+    next_output_event_ms_ += kOutputPeriodMs;
+  }
+
+  bool ended() const override { return next_output_event_ms_ > kDurationMs; }
+
+  rtc::Optional<RTPHeader> NextHeader() const override {
+    return packet_ ? rtc::Optional<RTPHeader>(packet_->header)
+                   : rtc::Optional<RTPHeader>();
+  }
+
+ private:
+  void CreatePacket() {
+    if (send_time_ms_ > kDurationMs) {
+      packet_.reset();
+      return;
+    }
+    packet_.reset(new PacketData);
+    packet_->header.payloadType = payload_type_;
+    packet_->header.sequenceNumber = sequence_number_++;
+    packet_->header.timestamp = static_cast<uint32_t>(send_time_ms_ * 48);
+    packet_->header.ssrc = 0x1234;
+    const uint8_t payload[20] = {0};
+    packet_->payload.SetData(payload);
+    arrival_time_ms_ = std::max(
+        arrival_time_ms_, send_time_ms_ + random_.Rand(0, max_jitter_ms_));
+    packet_->time_ms = arrival_time_ms_;
+    send_time_ms_ += kPacketIntervalMs;
+  }
+
+  Random random_;
+  const int max_jitter_ms_;
+  const uint8_t payload_type_;
+  std::unique_ptr<PacketData> packet_;
+  uint16_t sequence_number_ = 0;
+  int64_t send_time_ms_ = 0;
+  int64_t arrival_time_ms_ = 0;
+  int64_t next_output_event_ms_ = 0;
+};
+
+// The "logs" are the maximum jitter in ms, "missing", or "comfort_noise" for
+// packets without jitter that NetEq can't decode.
+std::unique_ptr<NetEqInput> CreateInput(const std::string& log) {
+  if (log == "missing")
+    return nullptr;
+  if (log == "comfort_noise") {
+    return std::unique_ptr<NetEqInput>(
+        new JitteryInput(0, kComfortNoisePayloadType));
+  }
+  return std::unique_ptr<NetEqInput>(
+      new JitteryInput(atoi(log.c_str()), kPayloadType));
+}
+
+class NetEqBatchSimulatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // One second of a 48 kHz sine.
+    audio_file_ = TempFilename(OutputPath(), "neteq_batch_replacement");
+    FILE* file = fopen(audio_file_.c_str(), "wb");
+    ASSERT_TRUE(file);
+    std::vector<int16_t> samples(48000);
+    for (size_t i = 0; i < samples.size(); ++i)
+      samples[i] = static_cast<int16_t>(8000 * std::sin(0.05 * i));
+    ASSERT_EQ(samples.size(),
+              fwrite(samples.data(), sizeof(int16_t), samples.size(), file));
+    fclose(file);
+  }
+
+  void TearDown() override { RemoveFile(audio_file_); }
+
+  NetEqBatchSimulator::Options DefaultOptions() const {
+    NetEqBatchSimulator::Options options;
+    options.replacement_audio_file = audio_file_;
+    return options;
+  }
+
+  std::vector<NetEqBatchSimulator::Config> DelayConfigs() const {
+    std::vector<NetEqBatchSimulator::Config> configs(2);
+    configs[0].name = "default";
+    configs[1].name = "min_delay_300";
+    configs[1].minimum_delay_ms = 300;
+    return configs;
+  }
+
+  std::string audio_file_;
+};
+
+}  // namespace
+
+TEST_F(NetEqBatchSimulatorTest, RunsEveryConfigOnEveryLog) {
+  NetEqBatchSimulator simulator(DefaultOptions(), &CreateInput);
+  const std::vector<std::string> logs = {"0", "missing", "60"};
+  const std::vector<NetEqBatchSimulator::Result> results =
+      simulator.Run(logs, DelayConfigs());
+
+  ASSERT_EQ(6u, results.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(i / 2, results[i].log_index);
+    EXPECT_EQ(i % 2, results[i].config_index);
+    EXPECT_EQ(results[i].log_index != 1, results[i].valid);
+    if (results[i].valid) {
+      EXPECT_NEAR(kDurationMs, results[i].output_duration_ms,
+                  2 * kOutputPeriodMs);
+      EXPECT_GT(results[i].lifetime_stats.total_samples_received, 0u);
+    } else {
+      EXPECT_EQ(0, results[i].output_duration_ms);
+    }
+  }
+}
+
+TEST_F(NetEqBatchSimulatorTest, RunsWithNetEqErrorsAreInvalid) {
+  NetEqBatchSimulator::Options options = DefaultOptions();
+  // Comfort noise packets are not replaced, so NetEq rejects them since they
+  // have no decoder.
+  options.comfort_noise_types = {kComfortNoisePayloadType};
+  NetEqBatchSimulator simulator(options, &CreateInput);
+  const std::vector<std::string> logs = {"0", "comfort_noise"};
+  const std::vector<NetEqBatchSimulator::Result> results =
+      simulator.Run(logs, DelayConfigs());
+
+  ASSERT_EQ(4u, results.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(results[i].log_index == 0, results[i].valid);
+    if (!results[i].valid)
+      EXPECT_EQ(0, results[i].output_duration_ms);
+  }
+  for (const NetEqBatchSimulator::Summary& summary :
+       NetEqBatchSimulator::Summarize(DelayConfigs(), results)) {
+    EXPECT_EQ(1u, summary.num_logs);
+  }
+}
+
+TEST_F(NetEqBatchSimulatorTest, DelaysFollowJitterAndMinimumDelay) {
+  NetEqBatchSimulator simulator(DefaultOptions(), &CreateInput);
+  const std::vector<NetEqBatchSimulator::Result> results =
+      simulator.Run({"0", "100"}, DelayConfigs());
+  ASSERT_EQ(4u, results.size());
+
+  // More jitter gives a larger buffer, and more of the output is concealed.
+  EXPECT_GT(results[2].preferred_buffer_size_ms,
+            results[0].preferred_buffer_size_ms);
+  EXPECT_GT(results[2].expand_rate, results[0].expand_rate);
+  // The minimum delay is respected.
+  EXPECT_GE(results[1].preferred_buffer_size_ms, 300);
+  EXPECT_GE(results[3].preferred_buffer_size_ms, 300);
+  EXPECT_GT(results[1].current_buffer_size_ms,
+            results[0].current_buffer_size_ms);
+}
+
+TEST_F(NetEqBatchSimulatorTest, SameResultsWithAnyNumberOfThreads) {
+  const std::vector<std::string> logs = {"0", "20", "40", "60", "80"};
+  NetEqBatchSimulator::Options options = DefaultOptions();
+  options.num_threads = 1;
+  const std::vector<NetEqBatchSimulator::Result> expected =
+      NetEqBatchSimulator(options, &CreateInput).Run(logs, DelayConfigs());
+  options.num_threads = 4;
+  const std::vector<NetEqBatchSimulator::Result> results =
+      NetEqBatchSimulator(options, &CreateInput).Run(logs, DelayConfigs());
+
+  ASSERT_EQ(expected.size(), results.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(expected[i].output_duration_ms, results[i].output_duration_ms);
+    EXPECT_EQ(expected[i].preferred_buffer_size_ms,
+              results[i].preferred_buffer_size_ms);
+    EXPECT_EQ(expected[i].current_buffer_size_ms,
+              results[i].current_buffer_size_ms);
+    EXPECT_EQ(expected[i].expand_rate, results[i].expand_rate);
+    EXPECT_EQ(expected[i].accelerate_rate, results[i].accelerate_rate);
+    EXPECT_EQ(expected[i].preemptive_rate, results[i].preemptive_rate);
+    EXPECT_EQ(expected[i].lifetime_stats.concealed_samples,
+              results[i].lifetime_stats.concealed_samples);
+  }
+}
+
+TEST(NetEqBatchSimulatorSummaryTest, AveragesValidLogsPerConfig) {
+  std::vector<NetEqBatchSimulator::Config> configs(2);
+  configs[0].name = "a";
+  configs[1].name = "b";
+  std::vector<NetEqBatchSimulator::Result> results(5);
+  // Config 0 on three logs, of which one is invalid. Config 1 on two logs.
+  const size_t config_index[] = {0, 1, 0, 1, 0};
+  const bool valid[] = {true, true, true, true, false};
+  const double buffer_size_ms[] = {40, 100, 80, 200, 1000};
+  const double expand_rate[] = {0.01, 0.0, 0.03, 0.0, 1.0};
+  for (size_t i = 0; i < results.size(); ++i) {
+    results[i].config_index = config_index[i];
+    results[i].valid = valid[i];
+    results[i].output_duration_ms = 1000;
+    results[i].preferred_buffer_size_ms = buffer_size_ms[i];
+    results[i].expand_rate = expand_rate[i];
+    results[i].lifetime_stats.total_samples_received = 48000;
+    results[i].lifetime_stats.concealed_samples = 480 * i;
+  }
+
+  const std::vector<NetEqBatchSimulator::Summary> summaries =
+      NetEqBatchSimulator::Summarize(configs, results);
+  ASSERT_EQ(2u, summaries.size());
+  EXPECT_EQ("a", summaries[0].config_name);
+  EXPECT_EQ(2u, summaries[0].num_logs);
+  EXPECT_EQ(2000, summaries[0].output_duration_ms);
+  EXPECT_DOUBLE_EQ(60, summaries[0].mean_preferred_buffer_size_ms);
+  EXPECT_DOUBLE_EQ(80, summaries[0].p95_preferred_buffer_size_ms);
+  EXPECT_DOUBLE_EQ(0.02, summaries[0].expand_rate);
+  EXPECT_DOUBLE_EQ(480.0 * 2 / 96000, summaries[0].concealed_rate);
+  EXPECT_EQ("b", summaries[1].config_name);
+  EXPECT_EQ(2u, summaries[1].num_logs);
+  EXPECT_DOUBLE_EQ(150, summaries[1].mean_preferred_buffer_size_ms);
+  EXPECT_DOUBLE_EQ(200, summaries[1].p95_preferred_buffer_size_ms);
+  EXPECT_DOUBLE_EQ(480.0 * 4 / 96000, summaries[1].concealed_rate);
+}
+
+}  // namespace test
+}  // namespace webrtc
@@ -90,6 +90,10 @@ class NetEqTest {
   // Returns the statistics from NetEq.
   NetEqNetworkStatistics SimulationStats();
 
+  // Gives access to the NetEq instance, e.g. to set a minimum delay before
+  // calling Run().
+  NetEq* neteq() { return neteq_.get(); }
+
  private:
   void RegisterDecoders(const DecoderMap& codecs);
   void RegisterExternalDecoders(const ExtDecoderMap& codecs);
@@ -1466,6 +1466,36 @@ static void ProcessNearendBlock(
                             std::min(aec->sampFreq, 16000), 1);
 }
 
+// Points the function pointers of the optimized methods at the fastest
+// implementations for this CPU.
+static bool InitFunctionPointers() {
+  WebRtcAec_FilterFar = FilterFar;
+  WebRtcAec_ScaleErrorSignal = ScaleErrorSignal;
+  WebRtcAec_FilterAdaptation = FilterAdaptation;
+  WebRtcAec_Overdrive = Overdrive;
+  WebRtcAec_Suppress = Suppress;
+  WebRtcAec_ComputeCoherence = ComputeCoherence;
+  WebRtcAec_UpdateCoherenceSpectra = UpdateCoherenceSpectra;
+  WebRtcAec_StoreAsComplex = StoreAsComplex;
+  WebRtcAec_PartitionDelay = PartitionDelay;
+  WebRtcAec_WindowData = WindowData;
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kSSE2)) {
+    WebRtcAec_InitAec_SSE2();
+  }
+#endif
+
+#if defined(MIPS_FPU_LE)
+  WebRtcAec_InitAec_mips();
+#endif
+
+#if defined(WEBRTC_HAS_NEON)
+  WebRtcAec_InitAec_neon();
+#endif
+  return true;
+}
+
 AecCore* WebRtcAec_CreateAec(int instance_count) {
   AecCore* aec = new AecCore(instance_count);
 
@@ -1505,31 +1535,11 @@ AecCore* WebRtcAec_CreateAec(int instance_count) {
   aec->extended_filter_enabled = 0;
   aec->refined_adaptive_filter_enabled = false;
 
-  // Assembly optimization
-  WebRtcAec_FilterFar = FilterFar;
-  WebRtcAec_ScaleErrorSignal = ScaleErrorSignal;
-  WebRtcAec_FilterAdaptation = FilterAdaptation;
-  WebRtcAec_Overdrive = Overdrive;
-  WebRtcAec_Suppress = Suppress;
-  WebRtcAec_ComputeCoherence = ComputeCoherence;
-  WebRtcAec_UpdateCoherenceSpectra = UpdateCoherenceSpectra;
-  WebRtcAec_StoreAsComplex = StoreAsComplex;
-  WebRtcAec_PartitionDelay = PartitionDelay;
-  WebRtcAec_WindowData = WindowData;
-
-#if defined(WEBRTC_ARCH_X86_FAMILY)
-  if (WebRtc_GetCPUInfo(kSSE2)) {
-    WebRtcAec_InitAec_SSE2();
-  }
-#endif
-
-#if defined(MIPS_FPU_LE)
-  WebRtcAec_InitAec_mips();
-#endif
-
-#if defined(WEBRTC_HAS_NEON)
-  WebRtcAec_InitAec_neon();
-#endif
+  // Assembly optimization. The function pointers are shared by all instances,
+  // so they are set only once: rewriting them here would race with other
+  // instances calling them on other threads.
+  static const bool function_pointers_initialized = InitFunctionPointers();
+  RTC_DCHECK(function_pointers_initialized);
 
   return aec;
 }
@@ -24,6 +24,7 @@ extern "C" {
 #include "webrtc/modules/audio_processing/aec/aec_core.h"
 #include "webrtc/modules/audio_processing/aec/aec_resampler.h"
 #include "webrtc/modules/audio_processing/logging/apm_data_dumper.h"
+#include "webrtc/rtc_base/atomicops.h"
 #include "webrtc/typedefs.h"
 
 namespace webrtc {
@@ -126,9 +127,10 @@ void* WebRtcAec_Create() {
   if (!aecpc) {
     return NULL;
   }
-  aecpc->data_dumper.reset(new ApmDataDumper(aecpc->instance_count));
+  const int instance_index = rtc::AtomicOps::Increment(&Aec::instance_count);
+  aecpc->data_dumper.reset(new ApmDataDumper(instance_index));
 
-  aecpc->aec = WebRtcAec_CreateAec(aecpc->instance_count);
+  aecpc->aec = WebRtcAec_CreateAec(instance_index);
   if (!aecpc->aec) {
     WebRtcAec_Free(aecpc);
     return NULL;
@@ -150,7 +152,6 @@ void* WebRtcAec_Create() {
 
   aecpc->initFlag = 0;
 
-  aecpc->instance_count++;
   return aecpc;
 }
 
@@ -387,6 +387,22 @@ static void WebRtcAecm_InitMips(void)
 }
 #endif
 
+// Points the function pointers at the fastest implementations for this CPU.
+static bool InitFunctionPointers() {
+  WebRtcAecm_CalcLinearEnergies = CalcLinearEnergiesC;
+  WebRtcAecm_StoreAdaptiveChannel = StoreAdaptiveChannelC;
+  WebRtcAecm_ResetAdaptiveChannel = ResetAdaptiveChannelC;
+
+#if defined(WEBRTC_HAS_NEON)
+  WebRtcAecm_InitNeon();
+#endif
+
+#if defined(MIPS32_LE)
+  WebRtcAecm_InitMips();
+#endif
+  return true;
+}
+
 // WebRtcAecm_InitCore(...)
 //
 // This function initializes the AECM instant created with WebRtcAecm_CreateCore(...)
@@ -508,18 +524,10 @@ int WebRtcAecm_InitCore(AecmCore* const aecm, int samplingFreq) {
     // used in assembly code, so check the assembly files before any change.
     static_assert(PART_LEN % 16 == 0, "PART_LEN is not a multiple of 16");
 
-    // Initialize function pointers.
-    WebRtcAecm_CalcLinearEnergies = CalcLinearEnergiesC;
-    WebRtcAecm_StoreAdaptiveChannel = StoreAdaptiveChannelC;
-    WebRtcAecm_ResetAdaptiveChannel = ResetAdaptiveChannelC;
-
-#if defined(WEBRTC_HAS_NEON)
-    WebRtcAecm_InitNeon();
-#endif
-
-#if defined(MIPS32_LE)
-    WebRtcAecm_InitMips();
-#endif
+    // Initialize function pointers. They are shared by all instances, so they
+    // are set only once, not while other instances may be calling them.
+    static const bool function_pointers_initialized = InitFunctionPointers();
+    RTC_DCHECK(function_pointers_initialized);
     return 0;
 }
 
@@ -388,23 +388,26 @@ void AudioBuffer::DeinterleaveFrom(AudioFrame* frame) {
   }
   activity_ = frame->vad_activity_;
 
-  int16_t* const* deinterleaved;
+  IFChannelBuffer* deinterleaved;
   if (input_num_frames_ == proc_num_frames_) {
-    deinterleaved = data_->ibuf()->channels();
+    deinterleaved = data_.get();
   } else {
-    deinterleaved = input_buffer_->ibuf()->channels();
+    deinterleaved = input_buffer_.get();
   }
   // TODO(yujo): handle muted frames more efficiently.
   if (num_proc_channels_ == 1) {
     // Downmix and deinterleave simultaneously.
-    DownmixInterleavedToMono(frame->data(), input_num_frames_,
-                             num_input_channels_, deinterleaved[0]);
+    DownmixInterleavedToMono(
+        frame->data(), input_num_frames_, num_input_channels_,
+        deinterleaved->ibuf_for_overwrite()->channels()[0]);
   } else {
     RTC_DCHECK_EQ(num_proc_channels_, num_input_channels_);
-    Deinterleave(frame->data(),
-                 input_num_frames_,
-                 num_proc_channels_,
-                 deinterleaved);
+    // Processing and resampling run on the float data, so convert while
+    // deinterleaving rather than in a separate pass.
+    DeinterleaveS16ToFloatS16(frame->data(),
+                              input_num_frames_,
+                              num_proc_channels_,
+                              deinterleaved->fbuf_for_overwrite()->channels());
   }
 
   // Resample.
@@ -24,6 +24,7 @@
 #include "webrtc/modules/audio_processing/level_controller/signal_classifier.h"
 #include "webrtc/modules/audio_processing/logging/apm_data_dumper.h"
 #include "webrtc/rtc_base/arraysize.h"
+#include "webrtc/rtc_base/atomicops.h"
 #include "webrtc/rtc_base/checks.h"
 #include "webrtc/rtc_base/logging.h"
 #include "webrtc/system_wrappers/include/metrics.h"
@@ -177,12 +178,12 @@ void LevelController::Metrics::Update(float long_term_peak_level,
 }
 
 LevelController::LevelController()
-    : data_dumper_(new ApmDataDumper(instance_count_)),
+    : data_dumper_(
+          new ApmDataDumper(rtc::AtomicOps::Increment(&instance_count_))),
       gain_applier_(data_dumper_.get()),
       signal_classifier_(data_dumper_.get()),
       peak_level_estimator_(kTargetLcPeakLeveldBFS) {
   Initialize(AudioProcessing::kSampleRate48kHz);
-  ++instance_count_;
 }
 
 LevelController::~LevelController() {}
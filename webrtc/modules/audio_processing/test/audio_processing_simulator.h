@@ -85,11 +85,14 @@ struct SimulationSettings {
   bool fixed_interface = false;
   bool store_intermediate_output = false;
   rtc::Optional<std::string> custom_call_order_filename;
+  // Reads the input wav files through memory mappings instead of file reads.
+  bool memory_map_input = false;
 };
 
 // Holds a few statistics about a series of TickIntervals.
 struct TickIntervalStats {
-  TickIntervalStats() : min(std::numeric_limits<int64_t>::max()) {}
+  TickIntervalStats()
+      : sum(0), max(0), min(std::numeric_limits<int64_t>::max()) {}
   int64_t sum;
   int64_t max;
   int64_t min;
@@ -8,16 +8,21 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <string>
+#include <vector>
 
+#include <stdio.h>
 #include <string.h>
 
 #include "webrtc/modules/audio_processing/include/audio_processing.h"
-#include "webrtc/modules/audio_processing/test/aec_dump_based_simulator.h"
 #include "webrtc/modules/audio_processing/test/audio_processing_simulator.h"
-#include "webrtc/modules/audio_processing/test/wav_based_simulator.h"
+#include "webrtc/modules/audio_processing/test/batch_simulation.h"
 #include "webrtc/rtc_base/flags.h"
+#include "webrtc/rtc_base/timeutils.h"
 
 namespace webrtc {
 namespace test {
@@ -29,10 +34,17 @@ const char kUsageDescription[] =
     "Usage: audioproc_f [options] -i <input.wav>\n"
     "                   or\n"
     "       audioproc_f [options] -dump_input <aec_dump>\n"
+    "                   or\n"
+    "       audioproc_f -batch_manifest <manifest> [-num_threads <n>]\n"
     "\n\n"
     "Command-line tool to simulate a call using the audio "
     "processing module, either based on wav files or "
-    "protobuf debug dump recordings.\n";
+    "protobuf debug dump recordings.\n"
+    "In batch mode, each line of the manifest holds the options of one "
+    "simulation, and the simulations are run in parallel within this "
+    "process. The execution times of each simulation are written to "
+    "<output>.timing.json next to its -o output, where <output> is the "
+    "output filename without its .wav extension.\n";
 
 DEFINE_string(dump_input, "", "Aec dump input filename");
 DEFINE_string(dump_output, "", "Aec dump output filename");
@@ -173,6 +185,14 @@ DEFINE_bool(store_intermediate_output,
             false,
             "Creates new output files after each init");
 DEFINE_string(custom_call_order_file, "", "Custom process API call order file");
+DEFINE_string(batch_manifest,
+              "",
+              "File with the options of one simulation per line. Lines "
+              "starting with # are ignored");
+DEFINE_int(num_threads,
+           0,
+           "Number of batch simulations to run at a time. 0 means one per "
+           "core");
 DEFINE_bool(help, false, "Print this message");
 
 void SetSettingIfSpecified(const std::string& value,
@@ -420,6 +440,79 @@ void PerformBasicParameterSanityChecks(const SimulationSettings& settings) {
       "Error: --artifical_nearend must be a valid .wav file name.\n");
 }
 
+// Parses the options on a line of the batch manifest, in the same way as the
+// command line of a single simulation.
+bool ParseManifestLine(const std::vector<std::string>& args,
+                       SimulationSettings* settings) {
+  for (rtc::Flag* flag = rtc::FlagList::list(); flag; flag = flag->next())
+    flag->SetToDefault();
+
+  std::vector<const char*> argv = {"audioproc_f"};
+  for (const std::string& arg : args)
+    argv.push_back(arg.c_str());
+  int argc = static_cast<int>(argv.size());
+  if (rtc::FlagList::SetFlagsFromCommandLine(&argc, argv.data(), true) ||
+      argc != 1 || FLAG_help || strlen(FLAG_batch_manifest) > 0) {
+    return false;
+  }
+  *settings = CreateSettings();
+  // Several simulations can't log to stderr at the same time.
+  ReportConditionalErrorAndExit(settings->use_verbose_logging,
+                                "Error: --verbose can't be used in the batch "
+                                "manifest.\n");
+  PerformBasicParameterSanityChecks(*settings);
+  settings->memory_map_input = true;
+  return true;
+}
+
+int RunBatchManifest(const std::string& manifest_filename, int num_threads) {
+  ReportConditionalErrorAndExit(num_threads < 0,
+                                "Error: --num_threads must not be negative.\n");
+  std::ifstream manifest(manifest_filename);
+  ReportConditionalErrorAndExit(!manifest,
+                                "Error: Cannot open " + manifest_filename);
+  std::vector<SimulationSettings> settings;
+  std::string error;
+  const bool parsed =
+      ParseBatchManifest(&manifest, ParseManifestLine, &settings, &error);
+  ReportConditionalErrorAndExit(!parsed,
+                                "Error: " + error + " in " + manifest_filename);
+  if (settings.empty())
+    return 0;
+
+  int used_threads = 0;
+  const int64_t start_time_us = rtc::TimeMicros();
+  const std::vector<BatchResult> results =
+      RunBatch(settings, num_threads, &used_threads);
+  const int64_t elapsed_us = rtc::TimeMicros() - start_time_us;
+
+  int64_t sum_wall_time_us = 0;
+  double file_time_s = 0.0;
+  for (size_t i = 0; i < settings.size(); ++i) {
+    if (settings[i].output_filename) {
+      ReportConditionalErrorAndExit(
+          !WriteTiming(*settings[i].output_filename, results[i]),
+          "Error: Cannot write " + TimingFilename(*settings[i].output_filename));
+    }
+    sum_wall_time_us += results[i].wall_time_us;
+    file_time_s += results[i].num_process_stream_calls * 1.0 /
+                   AudioProcessingSimulator::kChunksPerSecond;
+  }
+  // Running the simulations one at a time, like one audioproc_f process per
+  // simulation does, takes at least the sum of their times. With more threads
+  // than cores, the times include waiting for a core, and the speedup is
+  // overestimated.
+  std::cout << settings.size() << " simulations on " << used_threads
+            << " threads in " << elapsed_us * 1e-6 << " s, "
+            << file_time_s / (elapsed_us * 1e-6) << " times real time"
+            << std::endl
+            << "Sum of the simulation times: " << sum_wall_time_us * 1e-6
+            << " s, speedup: "
+            << sum_wall_time_us * 1.0 / std::max<int64_t>(elapsed_us, 1)
+            << std::endl;
+  return 0;
+}
+
 }  // namespace
 
 int main(int argc, char* argv[]) {
@@ -433,16 +526,16 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  SimulationSettings settings = CreateSettings();
-  PerformBasicParameterSanityChecks(settings);
-  std::unique_ptr<AudioProcessingSimulator> processor;
-
-  if (settings.aec_dump_input_filename) {
-    processor.reset(new AecDumpBasedSimulator(settings));
-  } else {
-    processor.reset(new WavBasedSimulator(settings));
+  if (strlen(FLAG_batch_manifest) > 0) {
+    // The flags are reused for parsing the manifest.
+    const std::string manifest_filename = FLAG_batch_manifest;
+    return RunBatchManifest(manifest_filename, FLAG_num_threads);
   }
 
+  SimulationSettings settings = CreateSettings();
+  PerformBasicParameterSanityChecks(settings);
+  std::unique_ptr<AudioProcessingSimulator> processor =
+      CreateSimulator(settings);
   processor->Process();
 
   if (settings.report_performance) {
@@ -0,0 +1,166 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/test/batch_simulation.h"
+
+#include <map>
+#include <sstream>
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "webrtc/modules/audio_processing/test/aec_dump_based_simulator.h"
+#include "webrtc/modules/audio_processing/test/wav_based_simulator.h"
+#include "webrtc/rtc_base/format_macros.h"
+#include "webrtc/rtc_base/parallel_for.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/system_wrappers/include/cpu_info.h"
+
+namespace webrtc {
+namespace test {
+namespace {
+
+// Returns the files that a simulation writes to.
+std::vector<std::string> OutputFilenames(const SimulationSettings& settings) {
+  std::vector<std::string> filenames;
+  if (settings.output_filename) {
+    filenames.push_back(*settings.output_filename);
+    filenames.push_back(TimingFilename(*settings.output_filename));
+  }
+  if (settings.reverse_output_filename)
+    filenames.push_back(*settings.reverse_output_filename);
+  if (settings.aec_dump_output_filename)
+    filenames.push_back(*settings.aec_dump_output_filename);
+  if (settings.ed_graph_output_filename)
+    filenames.push_back(*settings.ed_graph_output_filename);
+  return filenames;
+}
+
+BatchResult RunBatchSimulation(const SimulationSettings& settings) {
+  BatchResult result;
+  const int64_t start_time_us = rtc::TimeMicros();
+  std::unique_ptr<AudioProcessingSimulator> processor =
+      CreateSimulator(settings);
+  processor->Process();
+  result.proc_time = processor->proc_time();
+  result.num_process_stream_calls = processor->get_num_process_stream_calls();
+  result.num_reverse_process_stream_calls =
+      processor->get_num_reverse_process_stream_calls();
+  // Include the time for reading the input and writing the output.
+  processor.reset();
+  result.wall_time_us = rtc::TimeMicros() - start_time_us;
+  return result;
+}
+
+}  // namespace
+
+bool ParseBatchManifest(std::istream* manifest,
+                        const SimulationOptionsParser& parse_options,
+                        std::vector<SimulationSettings>* settings,
+                        std::string* error) {
+  // Maps each output file to the line that writes to it. The simulations run
+  // at the same time, so no two of them may write to the same file.
+  std::map<std::string, int> output_lines;
+  std::string line;
+  for (int line_number = 1; std::getline(*manifest, line); ++line_number) {
+    if (line.find_first_not_of(" \t") == std::string::npos || line[0] == '#')
+      continue;
+    std::istringstream stream(line);
+    std::vector<std::string> args;
+    std::string arg;
+    while (stream >> arg)
+      args.push_back(arg);
+    SimulationSettings line_settings;
+    if (!parse_options(args, &line_settings)) {
+      *error = "Invalid options on line " + std::to_string(line_number) +
+               ": " + line;
+      return false;
+    }
+    for (const std::string& filename : OutputFilenames(line_settings)) {
+      auto it = output_lines.insert(std::make_pair(filename, line_number));
+      if (!it.second) {
+        *error = "Line " + std::to_string(line_number) + " writes to " +
+                 filename + ", as does line " +
+                 std::to_string(it.first->second);
+        return false;
+      }
+    }
+    settings->push_back(line_settings);
+  }
+  return true;
+}
+
+std::string TimingFilename(const std::string& output_filename) {
+  const size_t size = output_filename.size();
+  if (size > 4 && (output_filename.compare(size - 4, 4, ".wav") == 0 ||
+                   output_filename.compare(size - 4, 4, ".WAV") == 0)) {
+    return output_filename.substr(0, size - 4) + ".timing.json";
+  }
+  return output_filename + ".timing.json";
+}
+
+std::unique_ptr<AudioProcessingSimulator> CreateSimulator(
+    const SimulationSettings& settings) {
+  if (settings.aec_dump_input_filename) {
+    return std::unique_ptr<AudioProcessingSimulator>(
+        new AecDumpBasedSimulator(settings));
+  }
+  return std::unique_ptr<AudioProcessingSimulator>(
+      new WavBasedSimulator(settings));
+}
+
+std::vector<BatchResult> RunBatch(
+    const std::vector<SimulationSettings>& settings,
+    int num_threads,
+    int* used_threads) {
+  std::vector<BatchResult> results(settings.size());
+  if (num_threads == 0)
+    num_threads = static_cast<int>(CpuInfo::DetectNumberOfCores());
+  const int threads = rtc::ParallelFor(
+      settings.size(), num_threads, "AudioprocBatch",
+      [&](size_t i) { results[i] = RunBatchSimulation(settings[i]); });
+  if (used_threads)
+    *used_threads = threads;
+  return results;
+}
+
+bool WriteTiming(const std::string& output_filename,
+                 const BatchResult& result) {
+  FILE* file = fopen(TimingFilename(output_filename).c_str(), "w");
+  if (!file)
+    return false;
+  const double file_time_s = result.num_process_stream_calls * 1.0 /
+                             AudioProcessingSimulator::kChunksPerSecond;
+  const int64_t exec_time_us =
+      result.proc_time.sum / rtc::kNumNanosecsPerMicrosec;
+  fprintf(file,
+          "{\"file_time_s\": %f, \"wall_time_us\": %" PRId64
+          ", \"exec_time_us\": %" PRId64
+          ", \"num_process_stream_calls\": %" PRIuS
+          ", \"num_reverse_process_stream_calls\": %" PRIuS
+          ", \"mean_chunk_time_us\": %f, \"max_chunk_time_us\": %f"
+          ", \"min_chunk_time_us\": %f}\n",
+          file_time_s, result.wall_time_us, exec_time_us,
+          result.num_process_stream_calls,
+          result.num_reverse_process_stream_calls,
+          result.num_process_stream_calls > 0
+              ? exec_time_us * 1.0 / result.num_process_stream_calls
+              : 0.0,
+          result.num_process_stream_calls > 0
+              ? 1.0 * result.proc_time.max / rtc::kNumNanosecsPerMicrosec
+              : 0.0,
+          result.num_process_stream_calls > 0
+              ? 1.0 * result.proc_time.min / rtc::kNumNanosecsPerMicrosec
+              : 0.0);
+  return fclose(file) == 0;
+}
+
+}  // namespace test
+}  // namespace webrtc
@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_AUDIO_PROCESSING_TEST_BATCH_SIMULATION_H_
+#define WEBRTC_MODULES_AUDIO_PROCESSING_TEST_BATCH_SIMULATION_H_
+
+#include <istream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/modules/audio_processing/test/audio_processing_simulator.h"
+
+namespace webrtc {
+namespace test {
+
+// Parses the options of one simulation, given as command line arguments
+// without the program name, into |settings|. Returns false if they are
+// invalid.
+using SimulationOptionsParser =
+    std::function<bool(const std::vector<std::string>& args,
+                       SimulationSettings* settings)>;
+
+// Reads a batch manifest, which holds the options of one simulation per line.
+// Blank lines and lines starting with # are skipped. Returns false, with a
+// description of the problem in |error|, if the options on a line are invalid
+// or if two simulations would write to the same file.
+bool ParseBatchManifest(std::istream* manifest,
+                        const SimulationOptionsParser& parse_options,
+                        std::vector<SimulationSettings>* settings,
+                        std::string* error);
+
+// Returns the name of the timing file for the -o output |output_filename|,
+// e.g. "out.timing.json" for "out.wav" or "out.WAV". Names without either
+// extension get ".timing.json" appended.
+std::string TimingFilename(const std::string& output_filename);
+
+// Creates the simulator for the input files given by |settings|.
+std::unique_ptr<AudioProcessingSimulator> CreateSimulator(
+    const SimulationSettings& settings);
+
+struct BatchResult {
+  // Includes reading the input and writing the output.
+  int64_t wall_time_us = 0;
+  TickIntervalStats proc_time;
+  size_t num_process_stream_calls = 0;
+  size_t num_reverse_process_stream_calls = 0;
+};
+
+// Runs the simulations of |settings| on |num_threads| threads, or on one
+// thread per core if it is 0. Returns their results in the same order, and
+// the number of threads used in |used_threads| if it is not null.
+std::vector<BatchResult> RunBatch(
+    const std::vector<SimulationSettings>& settings,
+    int num_threads,
+    int* used_threads);
+
+// Writes |result| as JSON to the file named by TimingFilename(). Returns false
+// if the file can't be written.
+bool WriteTiming(const std::string& output_filename, const BatchResult& result);
+
+}  // namespace test
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_AUDIO_PROCESSING_TEST_BATCH_SIMULATION_H_
@@ -0,0 +1,175 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/test/batch_simulation.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "webrtc/common_audio/wav_file.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/fileutils.h"
+
+namespace webrtc {
+namespace test {
+namespace {
+
+// Accepts pairs of -i, -o and -ro options, like audioproc_f.
+bool ParseFileOptions(const std::vector<std::string>& args,
+                      SimulationSettings* settings) {
+  if (args.size() % 2 != 0)
+    return false;
+  for (size_t i = 0; i < args.size(); i += 2) {
+    if (args[i] == "-i") {
+      settings->input_filename = rtc::Optional<std::string>(args[i + 1]);
+    } else if (args[i] == "-o") {
+      settings->output_filename = rtc::Optional<std::string>(args[i + 1]);
+    } else if (args[i] == "-ro") {
+      settings->reverse_output_filename =
+          rtc::Optional<std::string>(args[i + 1]);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Parse(const std::string& manifest_text,
+           std::vector<SimulationSettings>* settings,
+           std::string* error) {
+  std::istringstream manifest(manifest_text);
+  return ParseBatchManifest(&manifest, ParseFileOptions, settings, error);
+}
+
+void WriteWav(const std::string& filename, size_t num_samples) {
+  WavWriter writer(filename, 16000, 1);
+  std::vector<int16_t> samples(num_samples);
+  for (size_t i = 0; i < num_samples; ++i)
+    samples[i] = static_cast<int16_t>((i % 64) * 100);
+  writer.WriteSamples(samples.data(), samples.size());
+}
+
+std::string ReadFile(const std::string& filename) {
+  std::ifstream file(filename);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+}  // namespace
+
+TEST(BatchSimulationTest, ParsesOneSimulationPerLine) {
+  std::vector<SimulationSettings> settings;
+  std::string error;
+  ASSERT_TRUE(Parse("# Comment -i x.wav\n"
+                    "-i a.wav -o a_out.wav\n"
+                    "\n"
+                    "  \t\n"
+                    "-i b.wav   -o b_out.wav -ro b_rev.wav\n",
+                    &settings, &error));
+  ASSERT_EQ(2u, settings.size());
+  EXPECT_EQ("a.wav", *settings[0].input_filename);
+  EXPECT_EQ("a_out.wav", *settings[0].output_filename);
+  EXPECT_FALSE(settings[0].reverse_output_filename);
+  EXPECT_EQ("b.wav", *settings[1].input_filename);
+  EXPECT_EQ("b_out.wav", *settings[1].output_filename);
+  EXPECT_EQ("b_rev.wav", *settings[1].reverse_output_filename);
+}
+
+TEST(BatchSimulationTest, ReportsLineOfInvalidOptions) {
+  std::vector<SimulationSettings> settings;
+  std::string error;
+  EXPECT_FALSE(Parse("-i a.wav -o a_out.wav\n"
+                     "# Comment\n"
+                     "-i b.wav -x 1\n",
+                     &settings, &error));
+  EXPECT_EQ("Invalid options on line 3: -i b.wav -x 1", error);
+}
+
+TEST(BatchSimulationTest, RejectsSharedOutput) {
+  std::vector<SimulationSettings> settings;
+  std::string error;
+  EXPECT_FALSE(Parse("-i a.wav -o out.wav\n"
+                     "-i b.wav -o out.wav\n",
+                     &settings, &error));
+  EXPECT_EQ("Line 2 writes to out.wav, as does line 1", error);
+}
+
+TEST(BatchSimulationTest, RejectsOutputSharedWithReverseOutput) {
+  std::vector<SimulationSettings> settings;
+  std::string error;
+  EXPECT_FALSE(Parse("-i a.wav -o a_out.wav -ro rev.wav\n"
+                     "-i b.wav -o rev.wav\n",
+                     &settings, &error));
+  EXPECT_EQ("Line 2 writes to rev.wav, as does line 1", error);
+}
+
+TEST(BatchSimulationTest, RejectsSharedTimingFile) {
+  std::vector<SimulationSettings> settings;
+  std::string error;
+  EXPECT_FALSE(Parse("-i a.wav -o out.wav\n"
+                     "-i b.wav -o out.WAV\n",
+                     &settings, &error));
+  EXPECT_EQ("Line 2 writes to out.timing.json, as does line 1", error);
+}
+
+TEST(BatchSimulationTest, TimingFilename) {
+  EXPECT_EQ("out.timing.json", TimingFilename("out.wav"));
+  EXPECT_EQ("dir/out.timing.json", TimingFilename("dir/out.WAV"));
+  EXPECT_EQ("out.pcm.timing.json", TimingFilename("out.pcm"));
+  EXPECT_EQ(".wav.timing.json", TimingFilename(".wav"));
+}
+
+TEST(BatchSimulationTest, RunsManifestAndWritesTimings) {
+  const std::string prefix = OutputPath() + "batch_simulation_unittest_";
+  const size_t kNumSamples[] = {1600, 3200};
+  std::string manifest_text;
+  for (size_t i = 0; i < 2; ++i) {
+    const std::string name = prefix + std::to_string(i);
+    WriteWav(name + "_in.wav", kNumSamples[i]);
+    manifest_text += "-i " + name + "_in.wav -o " + name + "_out.wav\n";
+  }
+  std::vector<SimulationSettings> settings;
+  std::string error;
+  ASSERT_TRUE(Parse(manifest_text, &settings, &error)) << error;
+  ASSERT_EQ(2u, settings.size());
+
+  int used_threads = 0;
+  const std::vector<BatchResult> results = RunBatch(settings, 2, &used_threads);
+  EXPECT_EQ(2, used_threads);
+  ASSERT_EQ(2u, results.size());
+  for (size_t i = 0; i < 2; ++i) {
+    const std::string name = prefix + std::to_string(i);
+    // The simulations process 10 ms chunks of their own input.
+    EXPECT_EQ(kNumSamples[i] / 160, results[i].num_process_stream_calls);
+    EXPECT_EQ(0u, results[i].num_reverse_process_stream_calls);
+    {
+      WavReader output(name + "_out.wav");
+      EXPECT_EQ(kNumSamples[i], output.num_samples());
+    }
+
+    ASSERT_TRUE(WriteTiming(*settings[i].output_filename, results[i]));
+    const std::string timing = ReadFile(name + "_out.timing.json");
+    EXPECT_EQ(0u, timing.find("{\"file_time_s\": "));
+    EXPECT_NE(std::string::npos,
+              timing.find("\"num_process_stream_calls\": " +
+                          std::to_string(kNumSamples[i] / 160) + ","));
+    EXPECT_EQ("}\n", timing.substr(timing.size() - 2));
+
+    RemoveFile(name + "_in.wav");
+    RemoveFile(name + "_out.wav");
+    RemoveFile(name + "_out.timing.json");
+  }
+}
+
+}  // namespace test
+}  // namespace webrtc
@@ -57,7 +57,11 @@ WavBasedSimulator::GetCustomEventChain(const std::string& filename) {
 WavBasedSimulator::WavBasedSimulator(const SimulationSettings& settings)
       : AudioProcessingSimulator(settings) {}
 
-WavBasedSimulator::~WavBasedSimulator() = default;
+WavBasedSimulator::~WavBasedSimulator() {
+  // The readers must not outlive the mappings that they read from.
+  buffer_reader_.reset();
+  reverse_buffer_reader_.reset();
+}
 
 std::vector<WavBasedSimulator::SimulationEventType>
 WavBasedSimulator::GetDefaultEventChain() {
@@ -161,9 +165,20 @@ bool WavBasedSimulator::HandleProcessReverseStreamCall() {
   return samples_left_to_process;
 }
 
+std::unique_ptr<WavReader> WavBasedSimulator::OpenInput(
+    const std::string& filename,
+    std::unique_ptr<rtc::MemoryMappedFile>* mapping) {
+  if (!settings_.memory_map_input)
+    return std::unique_ptr<WavReader>(new WavReader(filename));
+  *mapping = rtc::MemoryMappedFile::Open(filename);
+  RTC_CHECK(*mapping) << "Cannot map " << filename;
+  return std::unique_ptr<WavReader>(
+      new WavReader((*mapping)->data(), (*mapping)->size()));
+}
+
 void WavBasedSimulator::Initialize() {
-  std::unique_ptr<WavReader> in_file(
-      new WavReader(settings_.input_filename->c_str()));
+  std::unique_ptr<WavReader> in_file =
+      OpenInput(*settings_.input_filename, &input_mapping_);
   int input_sample_rate_hz = in_file->sample_rate();
   int input_num_channels = in_file->num_channels();
   buffer_reader_.reset(new ChannelBufferWavReader(std::move(in_file)));
@@ -180,8 +195,8 @@ void WavBasedSimulator::Initialize() {
   int reverse_output_sample_rate_hz = 48000;
   int reverse_output_num_channels = 1;
   if (settings_.reverse_input_filename) {
-    std::unique_ptr<WavReader> reverse_in_file(
-        new WavReader(settings_.reverse_input_filename->c_str()));
+    std::unique_ptr<WavReader> reverse_in_file = OpenInput(
+        *settings_.reverse_input_filename, &reverse_input_mapping_);
     reverse_sample_rate_hz = reverse_in_file->sample_rate();
     reverse_num_channels = reverse_in_file->num_channels();
     reverse_buffer_reader_.reset(
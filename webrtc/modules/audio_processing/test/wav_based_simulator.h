@@ -11,11 +11,14 @@
 #ifndef WEBRTC_MODULES_AUDIO_PROCESSING_TEST_WAV_BASED_SIMULATOR_H_
 #define WEBRTC_MODULES_AUDIO_PROCESSING_TEST_WAV_BASED_SIMULATOR_H_
 
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "webrtc/modules/audio_processing/test/audio_processing_simulator.h"
 
 #include "webrtc/rtc_base/constructormagic.h"
+#include "webrtc/rtc_base/memory_mapped_file.h"
 
 namespace webrtc {
 namespace test {
@@ -36,6 +39,9 @@ class WavBasedSimulator final : public AudioProcessingSimulator {
   };
 
   void Initialize();
+  std::unique_ptr<WavReader> OpenInput(
+      const std::string& filename,
+      std::unique_ptr<rtc::MemoryMappedFile>* mapping);
   bool HandleProcessStreamCall();
   bool HandleProcessReverseStreamCall();
   void PrepareProcessStreamCall();
@@ -46,6 +52,10 @@ class WavBasedSimulator final : public AudioProcessingSimulator {
 
   std::vector<SimulationEventType> call_chain_;
   int last_specified_microphone_level_ = 100;
+  // The mapped input files if |settings_.memory_map_input| is set. The
+  // readers in |buffer_reader_| and |reverse_buffer_reader_| point into them.
+  std::unique_ptr<rtc::MemoryMappedFile> input_mapping_;
+  std::unique_ptr<rtc::MemoryMappedFile> reverse_input_mapping_;
 
   RTC_DISALLOW_IMPLICIT_CONSTRUCTORS(WavBasedSimulator);
 };
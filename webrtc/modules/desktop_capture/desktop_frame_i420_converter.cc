@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/desktop_capture/desktop_frame_i420_converter.h"
+
+#include <vector>
+
+#include "third_party/libyuv/include/libyuv/convert.h"
+#include "webrtc/rtc_base/checks.h"
+
+namespace webrtc {
+
+DesktopFrameI420Converter::DesktopFrameI420Converter() = default;
+
+DesktopFrameI420Converter::~DesktopFrameI420Converter() = default;
+
+rtc::scoped_refptr<I420Buffer> DesktopFrameI420Converter::Convert(
+    const DesktopFrame& frame) {
+  const DesktopRect frame_rect = DesktopRect::MakeSize(frame.size());
+  if (!size_.equals(frame.size())) {
+    // The pool drops buffers of the old resolution.
+    stale_regions_.clear();
+    size_ = frame.size();
+  }
+
+  // Each 2x2 block shares its chroma samples, so it has to be converted as a
+  // whole.
+  DesktopRegion updated_region;
+  for (DesktopRegion::Iterator it(frame.updated_region()); !it.IsAtEnd();
+       it.Advance()) {
+    const DesktopRect& rect = it.rect();
+    DesktopRect aligned = DesktopRect::MakeLTRB(
+        rect.left() & ~1, rect.top() & ~1, rect.right() + (rect.right() & 1),
+        rect.bottom() + (rect.bottom() & 1));
+    aligned.IntersectWith(frame_rect);
+    updated_region.AddRect(aligned);
+  }
+  for (auto& stale_region : stale_regions_)
+    stale_region.second.AddRegion(updated_region);
+
+  rtc::scoped_refptr<I420Buffer> buffer =
+      buffer_pool_.CreateBuffer(frame.size().width(), frame.size().height());
+  RTC_CHECK(buffer);
+  auto it = stale_regions_.find(buffer.get());
+  if (it == stale_regions_.end()) {
+    ConvertRect(frame, frame_rect, buffer.get());
+    stale_regions_[buffer.get()];
+    return buffer;
+  }
+  for (DesktopRegion::Iterator rect(it->second); !rect.IsAtEnd();
+       rect.Advance()) {
+    ConvertRect(frame, rect.rect(), buffer.get());
+  }
+  it->second.Clear();
+  return buffer;
+}
+
+VideoFrame DesktopFrameI420Converter::ConvertToVideoFrame(
+    const DesktopFrame& frame,
+    int64_t timestamp_us) {
+  const bool size_changed = !size_.equals(frame.size());
+  VideoFrame video_frame(Convert(frame), kVideoRotation_0, timestamp_us);
+  if (size_changed)
+    return video_frame;
+
+  std::vector<VideoFrame::UpdateRect> update_rects;
+  for (DesktopRegion::Iterator it(frame.updated_region()); !it.IsAtEnd();
+       it.Advance()) {
+    update_rects.push_back({it.rect().left(), it.rect().top(),
+                            it.rect().width(), it.rect().height()});
+  }
+  video_frame.set_update_rects(
+      rtc::Optional<std::vector<VideoFrame::UpdateRect>>(update_rects));
+  return video_frame;
+}
+
+void DesktopFrameI420Converter::ConvertRect(const DesktopFrame& frame,
+                                            const DesktopRect& rect,
+                                            I420Buffer* buffer) {
+  RTC_DCHECK_EQ(0, rect.left() % 2);
+  RTC_DCHECK_EQ(0, rect.top() % 2);
+  const int chroma_offset_u =
+      rect.top() / 2 * buffer->StrideU() + rect.left() / 2;
+  const int chroma_offset_v =
+      rect.top() / 2 * buffer->StrideV() + rect.left() / 2;
+  libyuv::ARGBToI420(
+      frame.GetFrameDataAtPos(rect.top_left()), frame.stride(),
+      buffer->MutableDataY() + rect.top() * buffer->StrideY() + rect.left(),
+      buffer->StrideY(), buffer->MutableDataU() + chroma_offset_u,
+      buffer->StrideU(), buffer->MutableDataV() + chroma_offset_v,
+      buffer->StrideV(), rect.width(), rect.height());
+}
+
+}  // namespace webrtc
@@ -0,0 +1,70 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_DESKTOP_CAPTURE_DESKTOP_FRAME_I420_CONVERTER_H_
+#define WEBRTC_MODULES_DESKTOP_CAPTURE_DESKTOP_FRAME_I420_CONVERTER_H_
+
+#include <stdint.h>
+
+#include <map>
+
+#include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/api/video/video_frame.h"
+#include "webrtc/common_video/include/i420_buffer_pool.h"
+#include "webrtc/modules/desktop_capture/desktop_frame.h"
+#include "webrtc/modules/desktop_capture/desktop_geometry.h"
+#include "webrtc/modules/desktop_capture/desktop_region.h"
+#include "webrtc/rtc_base/constructormagic.h"
+#include "webrtc/rtc_base/scoped_ref_ptr.h"
+
+namespace webrtc {
+
+// Converts the DesktopFrames of a capturer into I420 buffers, converting only
+// the pixels that may have changed. The buffers come from a pool and each of
+// them keeps the frame it was last written with, so a buffer that is reused
+// only needs the areas updated since then, as reported by the updated_region()
+// of the frames in between. Those areas are extended to whole 2x2 chroma
+// blocks. A buffer that is new to the pool, e.g. after a resolution change, is
+// converted in full.
+//
+// The returned buffers must not be written to. This class is not thread safe.
+class DesktopFrameI420Converter {
+ public:
+  DesktopFrameI420Converter();
+  ~DesktopFrameI420Converter();
+
+  // Returns an I420 copy of |frame|. The updated_region() of |frame| must
+  // cover everything that changed since the previous frame passed to this
+  // function.
+  rtc::scoped_refptr<I420Buffer> Convert(const DesktopFrame& frame);
+
+  // Returns a VideoFrame of |frame|, converted as by Convert(), with the
+  // updated_region() of |frame| as its update rects. These are left unset for
+  // the first frame and after a resolution change, when all of the frame
+  // differs from the previous VideoFrame.
+  VideoFrame ConvertToVideoFrame(const DesktopFrame& frame,
+                                 int64_t timestamp_us);
+
+ private:
+  void ConvertRect(const DesktopFrame& frame,
+                   const DesktopRect& rect,
+                   I420Buffer* buffer);
+
+  I420BufferPool buffer_pool_;
+  DesktopSize size_;
+  // The areas that changed since each buffer of |buffer_pool_| was written.
+  std::map<const I420Buffer*, DesktopRegion> stale_regions_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(DesktopFrameI420Converter);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_DESKTOP_CAPTURE_DESKTOP_FRAME_I420_CONVERTER_H_
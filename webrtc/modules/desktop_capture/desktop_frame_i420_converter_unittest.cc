@@ -0,0 +1,262 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/desktop_capture/desktop_frame_i420_converter.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "third_party/libyuv/include/libyuv/convert.h"
+#include "webrtc/modules/desktop_capture/desktop_frame_generator.h"
+#include "webrtc/modules/desktop_capture/rgba_color.h"
+#include "webrtc/rtc_base/arraysize.h"
+#include "webrtc/rtc_base/checks.h"
+#include "webrtc/rtc_base/random.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+
+namespace {
+
+// Paints random rectangles over the previous content of the screen, unlike
+// BlackWhiteDesktopFramePainter which repaints the whole frame each time.
+class RandomRectPainter : public DesktopFramePainter {
+ public:
+  RandomRectPainter(DesktopSize size, uint64_t seed)
+      : random_(seed), screen_(size) {
+    memset(screen_.data(), 0, screen_.stride() * size.height());
+  }
+  ~RandomRectPainter() override = default;
+
+  void set_num_rects(int num_rects) { num_rects_ = num_rects; }
+  // Rects of zero size get a random size.
+  void set_rect_size(DesktopSize rect_size) { rect_size_ = rect_size; }
+
+  bool Paint(DesktopFrame* frame, DesktopRegion* updated_region) override {
+    RTC_CHECK(frame->size().equals(screen_.size()));
+    const DesktopSize& size = screen_.size();
+    for (int i = 0; i < num_rects_; ++i) {
+      const int width = rect_size_.is_empty()
+                            ? random_.Rand(1, size.width())
+                            : std::min(rect_size_.width(), size.width());
+      const int height = rect_size_.is_empty()
+                             ? random_.Rand(1, size.height())
+                             : std::min(rect_size_.height(), size.height());
+      const DesktopRect rect = DesktopRect::MakeXYWH(
+          random_.Rand(0, size.width() - width),
+          random_.Rand(0, size.height() - height), width, height);
+      const RgbaColor color(random_.Rand<uint8_t>(), random_.Rand<uint8_t>(),
+                            random_.Rand<uint8_t>());
+      const uint32_t pixel = color.ToUInt32();
+      for (int y = rect.top(); y < rect.bottom(); ++y) {
+        uint32_t* row = reinterpret_cast<uint32_t*>(
+            screen_.GetFrameDataAtPos(DesktopVector(rect.left(), y)));
+        std::fill(row, row + rect.width(), pixel);
+      }
+      updated_region->AddRect(rect);
+    }
+    frame->CopyPixelsFrom(screen_, DesktopVector(),
+                          DesktopRect::MakeSize(size));
+    return true;
+  }
+
+ private:
+  Random random_;
+  BasicDesktopFrame screen_;
+  int num_rects_ = 1;
+  DesktopSize rect_size_;
+};
+
+// Creates frames of |size| through a PainterDesktopFrameGenerator.
+class FrameSource {
+ public:
+  FrameSource(DesktopSize size, uint64_t seed) : painter_(size, seed) {
+    *generator_.size() = size;
+    generator_.set_provide_updated_region_hints(true);
+    generator_.set_desktop_frame_painter(&painter_);
+  }
+
+  std::unique_ptr<DesktopFrame> GetNextFrame() {
+    return generator_.GetNextFrame(nullptr);
+  }
+  RandomRectPainter* painter() { return &painter_; }
+
+ private:
+  RandomRectPainter painter_;
+  PainterDesktopFrameGenerator generator_;
+};
+
+rtc::scoped_refptr<I420Buffer> ConvertInFull(const DesktopFrame& frame) {
+  rtc::scoped_refptr<I420Buffer> buffer =
+      I420Buffer::Create(frame.size().width(), frame.size().height());
+  libyuv::ARGBToI420(frame.data(), frame.stride(), buffer->MutableDataY(),
+                     buffer->StrideY(), buffer->MutableDataU(),
+                     buffer->StrideU(), buffer->MutableDataV(),
+                     buffer->StrideV(), frame.size().width(),
+                     frame.size().height());
+  return buffer;
+}
+
+bool PlanesEqual(const uint8_t* a,
+                 int stride_a,
+                 const uint8_t* b,
+                 int stride_b,
+                 int width,
+                 int height) {
+  for (int y = 0; y < height; ++y) {
+    if (memcmp(a + y * stride_a, b + y * stride_b, width) != 0)
+      return false;
+  }
+  return true;
+}
+
+bool BuffersEqual(const I420BufferInterface& a,
+                  const I420BufferInterface& b) {
+  const int chroma_width = (a.width() + 1) / 2;
+  const int chroma_height = (a.height() + 1) / 2;
+  return a.width() == b.width() && a.height() == b.height() &&
+         PlanesEqual(a.DataY(), a.StrideY(), b.DataY(), b.StrideY(),
+                     a.width(), a.height()) &&
+         PlanesEqual(a.DataU(), a.StrideU(), b.DataU(), b.StrideU(),
+                     chroma_width, chroma_height) &&
+         PlanesEqual(a.DataV(), a.StrideV(), b.DataV(), b.StrideV(),
+                     chroma_width, chroma_height);
+}
+
+}  // namespace
+
+TEST(DesktopFrameI420ConverterTest, MatchesFullConversion) {
+  // Odd dimensions, so that the rects are clipped after alignment.
+  FrameSource source(DesktopSize(101, 77), 0x5eed);
+  source.painter()->set_num_rects(3);
+  DesktopFrameI420Converter converter;
+  Random random(0x1234);
+  // Buffers still referenced, e.g. by an encoder, make the pool alternate
+  // between several buffers, each of which misses different updates.
+  std::deque<rtc::scoped_refptr<I420Buffer>> held_buffers;
+  for (int i = 0; i < 100; ++i) {
+    std::unique_ptr<DesktopFrame> frame = source.GetNextFrame();
+    ASSERT_TRUE(frame);
+    rtc::scoped_refptr<I420Buffer> buffer = converter.Convert(*frame);
+    ASSERT_TRUE(BuffersEqual(*ConvertInFull(*frame), *buffer))
+        << "Frame " << i;
+    held_buffers.push_back(buffer);
+    while (held_buffers.size() > random.Rand(0u, 3u))
+      held_buffers.pop_front();
+  }
+}
+
+TEST(DesktopFrameI420ConverterTest, ConvertsInFullAfterResolutionChange) {
+  DesktopFrameI420Converter converter;
+  const DesktopSize kSizes[] = {DesktopSize(64, 48), DesktopSize(32, 16),
+                                DesktopSize(64, 48)};
+  for (size_t i = 0; i < arraysize(kSizes); ++i) {
+    FrameSource source(kSizes[i], i + 1);
+    std::unique_ptr<DesktopFrame> frame = source.GetNextFrame();
+    // Only a part of the frame is reported as updated, yet all of it differs
+    // from the previous frame of the same size.
+    ASSERT_FALSE(frame->updated_region().Equals(
+        DesktopRegion(DesktopRect::MakeSize(kSizes[i]))));
+    EXPECT_TRUE(
+        BuffersEqual(*ConvertInFull(*frame), *converter.Convert(*frame)));
+  }
+}
+
+TEST(DesktopFrameI420ConverterTest, SetsUpdateRectsOfVideoFrames) {
+  DesktopFrameI420Converter converter;
+  BasicDesktopFrame frame(DesktopSize(64, 64));
+  memset(frame.data(), 0, frame.stride() * frame.size().height());
+  frame.mutable_updated_region()->SetRect(DesktopRect::MakeSize(frame.size()));
+  // All of the first frame is new.
+  VideoFrame video_frame = converter.ConvertToVideoFrame(frame, 1000);
+  EXPECT_EQ(1000, video_frame.timestamp_us());
+  EXPECT_FALSE(video_frame.update_rects());
+
+  frame.mutable_updated_region()->SetRect(DesktopRect::MakeXYWH(1, 2, 3, 4));
+  frame.mutable_updated_region()->AddRect(
+      DesktopRect::MakeXYWH(40, 50, 10, 5));
+  video_frame = converter.ConvertToVideoFrame(frame, 2000);
+  const rtc::Optional<std::vector<VideoFrame::UpdateRect>>& rects =
+      video_frame.update_rects();
+  ASSERT_TRUE(rects);
+  ASSERT_EQ(2u, rects->size());
+  EXPECT_EQ(1, (*rects)[0].offset_x);
+  EXPECT_EQ(2, (*rects)[0].offset_y);
+  EXPECT_EQ(3, (*rects)[0].width);
+  EXPECT_EQ(4, (*rects)[0].height);
+  EXPECT_EQ(40, (*rects)[1].offset_x);
+  EXPECT_EQ(50, (*rects)[1].offset_y);
+  EXPECT_EQ(10, (*rects)[1].width);
+  EXPECT_EQ(5, (*rects)[1].height);
+  EXPECT_TRUE(BuffersEqual(*ConvertInFull(frame),
+                           *video_frame.video_frame_buffer()->ToI420()));
+
+  // A resolution change makes all of the frame new again.
+  BasicDesktopFrame resized_frame(DesktopSize(32, 32));
+  memset(resized_frame.data(), 0,
+         resized_frame.stride() * resized_frame.size().height());
+  resized_frame.mutable_updated_region()->SetRect(
+      DesktopRect::MakeXYWH(1, 2, 3, 4));
+  EXPECT_FALSE(
+      converter.ConvertToVideoFrame(resized_frame, 3000).update_rects());
+}
+
+// Compares converting 4K frames in full to converting only their updated
+// regions, for updates from a cursor sized rect to the whole screen. One
+// buffer is kept referenced, as an encoder would.
+// Disabled since it only reports timings; run it with
+// --gtest_also_run_disabled_tests.
+TEST(DesktopFrameI420ConverterTest, DISABLED_Performance) {
+  const int kNumFrames = 100;
+  const DesktopSize kSize(3840, 2160);
+  const struct {
+    const char* name;
+    DesktopSize rect_size;
+  } kUpdates[] = {{"cursor", DesktopSize(32, 32)},
+                  {"1_percent", DesktopSize(384, 216)},
+                  {"10_percent", DesktopSize(1214, 683)},
+                  {"50_percent", DesktopSize(2715, 1527)},
+                  {"full", kSize}};
+
+  for (const auto& update : kUpdates) {
+    FrameSource source(kSize, 0x5eed);
+    source.painter()->set_rect_size(update.rect_size);
+    DesktopFrameI420Converter converter;
+    rtc::scoped_refptr<I420Buffer> held_buffer;
+    int64_t full_time_us = 0;
+    int64_t incremental_time_us = 0;
+    for (int i = 0; i < kNumFrames; ++i) {
+      std::unique_ptr<DesktopFrame> frame = source.GetNextFrame();
+      int64_t start_us = rtc::TimeMicros();
+      ConvertInFull(*frame);
+      full_time_us += rtc::TimeMicros() - start_us;
+
+      start_us = rtc::TimeMicros();
+      held_buffer = converter.Convert(*frame);
+      incremental_time_us += rtc::TimeMicros() - start_us;
+    }
+
+    test::PrintResult("desktop_frame_full_conversion_time", "", update.name,
+                      static_cast<size_t>(full_time_us / kNumFrames), "us",
+                      false);
+    test::PrintResult("desktop_frame_incremental_conversion_time", "",
+                      update.name,
+                      static_cast<size_t>(incremental_time_us / kNumFrames),
+                      "us", false);
+  }
+}
+
+}  // namespace webrtc
@@ -15,11 +15,13 @@
 #include <iostream>  // TODO(zijiehe): Remove once flaky has been resolved.
 #include <memory>
 #include <utility>
+#include <vector>
 
 // TODO(zijiehe): Remove once flaky has been resolved.
 #include "webrtc/modules/desktop_capture/desktop_capture_options.h"
 #include "webrtc/modules/desktop_capture/desktop_capturer.h"
 #include "webrtc/modules/desktop_capture/desktop_frame.h"
+#include "webrtc/modules/desktop_capture/desktop_frame_i420_converter.h"
 #include "webrtc/modules/desktop_capture/desktop_region.h"
 #include "webrtc/modules/desktop_capture/mock_desktop_capturer_callback.h"
 #include "webrtc/modules/desktop_capture/rgba_color.h"
@@ -28,8 +30,10 @@
 #include "webrtc/rtc_base/checks.h"
 #include "webrtc/rtc_base/constructormagic.h"
 #include "webrtc/rtc_base/logging.h"
+#include "webrtc/rtc_base/timeutils.h"
 #include "webrtc/test/gmock.h"
 #include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
 
 #if defined(WEBRTC_WIN)
 #include "webrtc/modules/desktop_capture/win/screen_capturer_win_directx.h"
@@ -76,6 +80,32 @@ bool ArePixelsColoredBy(const DesktopFrame& frame,
   return true;
 }
 
+// Returns the number of 16x16 macroblocks of |frame| that intersect its update
+// rects, i.e. the blocks an encoder has to code.
+int CountUpdatedMacroblocks(const VideoFrame& frame) {
+  const int cols = (frame.width() + 15) / 16;
+  const int rows = (frame.height() + 15) / 16;
+  if (!frame.update_rects())
+    return rows * cols;
+  std::vector<bool> updated(rows * cols, false);
+  for (const VideoFrame::UpdateRect& rect : *frame.update_rects()) {
+    const int bottom = rect.offset_y + rect.height;
+    const int right = rect.offset_x + rect.width;
+    for (int row = rect.offset_y / 16; row <= (bottom - 1) / 16; ++row) {
+      for (int col = rect.offset_x / 16; col <= (right - 1) / 16; ++col)
+        updated[row * cols + col] = true;
+    }
+  }
+  return static_cast<int>(std::count(updated.begin(), updated.end(), true));
+}
+
+int RegionArea(const DesktopRegion& region) {
+  int area = 0;
+  for (DesktopRegion::Iterator it(region); !it.IsAtEnd(); it.Advance())
+    area += it.rect().width() * it.rect().height();
+  return area;
+}
+
 }  // namespace
 
 class ScreenCapturerIntegrationTest : public testing::Test {
@@ -151,6 +181,82 @@ class ScreenCapturerIntegrationTest : public testing::Test {
     TestCaptureUpdatedRegion({capturer_.get()});
   }
 
+  // Draws small rectangles, like the glyphs of text being typed, and reports
+  // how much of the captured frames their updated regions cover. The frames
+  // are converted to VideoFrames as for sending, so the macroblock share is
+  // the part of the frame the encoder has to code given their update rects.
+  void MeasureUpdatedRegion() {
+    const int kNumFrames = 300;
+    const int kGlyphWidth = 8;
+    const int kGlyphHeight = 16;
+    std::unique_ptr<ScreenDrawer> drawer = ScreenDrawer::Create();
+    if (!drawer || drawer->DrawableRegion().is_empty()) {
+      LOG(LS_WARNING) << "No ScreenDrawer implementation for current platform.";
+      return;
+    }
+    const DesktopRect drawable = drawer->DrawableRegion();
+    const int glyphs_per_line = drawable.width() / kGlyphWidth;
+    const int lines = drawable.height() / kGlyphHeight;
+    if (glyphs_per_line == 0 || lines == 0) {
+      LOG(LS_WARNING) << "ScreenDrawer::DrawableRegion() is too small.";
+      return;
+    }
+
+    capturer_->Start(&callback_);
+    drawer->Clear();
+    drawer->WaitForPendingDraws();
+    DesktopFrameI420Converter converter;
+    // The first frame is always entirely updated.
+    std::unique_ptr<DesktopFrame> first_frame = CaptureFrame(capturer_.get());
+    ASSERT_TRUE(first_frame);
+    converter.ConvertToVideoFrame(*first_frame, rtc::TimeMicros());
+
+    int64_t frame_area = 0;
+    int64_t updated_area = 0;
+    int64_t total_macroblocks = 0;
+    int64_t updated_macroblocks = 0;
+    int64_t capture_time_us = 0;
+    int64_t conversion_time_us = 0;
+    for (int i = 0; i < kNumFrames; ++i) {
+      DesktopRect glyph = DesktopRect::MakeXYWH(
+          (i % glyphs_per_line) * kGlyphWidth,
+          (i / glyphs_per_line % lines) * kGlyphHeight, kGlyphWidth,
+          kGlyphHeight);
+      glyph.Translate(drawable.top_left());
+      drawer->DrawRectangle(glyph, RgbaColor(i & 0xff, 0x7f, 0x7f));
+      drawer->WaitForPendingDraws();
+
+      int64_t start_us = rtc::TimeMicros();
+      std::unique_ptr<DesktopFrame> frame = CaptureFrame(capturer_.get());
+      capture_time_us += rtc::TimeMicros() - start_us;
+      ASSERT_TRUE(frame);
+      start_us = rtc::TimeMicros();
+      const VideoFrame video_frame =
+          converter.ConvertToVideoFrame(*frame, start_us);
+      conversion_time_us += rtc::TimeMicros() - start_us;
+
+      frame_area += frame->size().width() * frame->size().height();
+      updated_area += RegionArea(frame->updated_region());
+      total_macroblocks += ((frame->size().width() + 15) / 16) *
+                           ((frame->size().height() + 15) / 16);
+      updated_macroblocks += CountUpdatedMacroblocks(video_frame);
+    }
+
+    test::PrintResult("screen_capture_updated_area", "", "glyphs",
+                      static_cast<size_t>(updated_area * 10000 / frame_area),
+                      "bp_of_frame", false);
+    test::PrintResult(
+        "screen_capture_updated_macroblocks", "", "glyphs",
+        static_cast<size_t>(updated_macroblocks * 10000 / total_macroblocks),
+        "bp_of_frame", false);
+    test::PrintResult("screen_capture_time", "", "glyphs",
+                      static_cast<size_t>(capture_time_us / kNumFrames), "us",
+                      false);
+    test::PrintResult("screen_capture_conversion_time", "", "glyphs",
+                      static_cast<size_t>(conversion_time_us / kNumFrames),
+                      "us", false);
+  }
+
 #if defined(WEBRTC_WIN)
   // Enable allow_directx_capturer in DesktopCaptureOptions, but let
   // DesktopCapturer::CreateScreenCapturer() to decide whether a DirectX
@@ -295,6 +401,14 @@ TEST_F(ScreenCapturerIntegrationTest, MAYBE_CaptureUpdatedRegion) {
   TestCaptureUpdatedRegion();
 }
 
+// Not a correctness test: prints how much of the screen the capturer reports
+// as updated while small areas of it change.
+// Disabled since it only reports timings; run it with
+// --gtest_also_run_disabled_tests.
+TEST_F(ScreenCapturerIntegrationTest, DISABLED_UpdatedRegionPerformance) {
+  MeasureUpdatedRegion();
+}
+
 #if defined(WEBRTC_WIN)
 // ScreenCapturerWinGdi randomly returns blank screen, the root cause is still
 // unknown. Bug, https://bugs.chromium.org/p/webrtc/issues/detail?id=6843.
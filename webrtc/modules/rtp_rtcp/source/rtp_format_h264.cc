@@ -84,7 +84,8 @@ RtpPacketizerH264::RtpPacketizerH264(size_t max_payload_len,
     : max_payload_len_(max_payload_len),
       last_packet_reduction_len_(last_packet_reduction_len),
       num_packets_left_(0),
-      packetization_mode_(packetization_mode) {
+      packetization_mode_(packetization_mode),
+      next_packet_(0) {
   // Guard against uninitialized memory in packetization_mode.
   RTC_CHECK(packetization_mode == H264PacketizationMode::NonInterleaved ||
             packetization_mode == H264PacketizationMode::SingleNalUnit);
@@ -106,6 +107,15 @@ size_t RtpPacketizerH264::SetPayloadData(
   RTC_DCHECK(packets_.empty());
   RTC_DCHECK(input_fragments_.empty());
   RTC_DCHECK(fragmentation);
+  input_fragments_.reserve(fragmentation->fragmentationVectorSize);
+  // Every fragment yields at least one packet unit, fragments larger than a
+  // packet yield one per FU-A packet.
+  if (max_payload_len_ > kFuAHeaderSize) {
+    packets_.reserve(fragmentation->fragmentationVectorSize +
+                     (payload_size + last_packet_reduction_len_) /
+                         (max_payload_len_ - kFuAHeaderSize) +
+                     1);
+  }
   for (int i = 0; i < fragmentation->fragmentationVectorSize; ++i) {
     const uint8_t* buffer =
         &payload_data[fragmentation->fragmentationOffset[i]];
@@ -140,7 +150,7 @@ size_t RtpPacketizerH264::SetPayloadData(
         case SpsVuiRewriter::ParseResult::kVuiRewritten:
           input_fragments_.push_back(
               Fragment(output_buffer->data(), output_buffer->size()));
-          input_fragments_.rbegin()->tmp_buffer = std::move(output_buffer);
+          input_fragments_.back().tmp_buffer = std::move(output_buffer);
           updated_sps = true;
           RTC_HISTOGRAM_ENUMERATION(kSpsValidHistogramName,
                                     SpsValidEvent::kSentSpsRewritten,
@@ -239,10 +249,10 @@ void RtpPacketizerH264::PacketizeFuA(size_t fragment_index) {
       }
     }
     RTC_CHECK_GT(packet_length, 0);
-    packets_.push(PacketUnit(Fragment(fragment.buffer + offset, packet_length),
-                             offset - kNalHeaderSize == 0,
-                             payload_left == packet_length, false,
-                             fragment.buffer[0]));
+    packets_.push_back(
+        PacketUnit(Fragment(fragment.buffer + offset, packet_length),
+                   offset - kNalHeaderSize == 0, payload_left == packet_length,
+                   false, fragment.buffer[0]));
     offset += packet_length;
     payload_left -= packet_length;
     --num_packets;
@@ -263,8 +273,8 @@ size_t RtpPacketizerH264::PacketizeStapA(size_t fragment_index) {
           payload_size_left >= fragment->length + fragment_headers_length +
                                    last_packet_reduction_len_)) {
     RTC_CHECK_GT(fragment->length, 0);
-    packets_.push(PacketUnit(*fragment, aggregated_fragments == 0, false, true,
-                             fragment->buffer[0]));
+    packets_.push_back(PacketUnit(*fragment, aggregated_fragments == 0, false,
+                                  true, fragment->buffer[0]));
     payload_size_left -= fragment->length;
     payload_size_left -= fragment_headers_length;
 
@@ -297,25 +307,24 @@ void RtpPacketizerH264::PacketizeSingleNalu(size_t fragment_index) {
       << "Payload size left " << payload_size_left << ", fragment length "
       << fragment->length << ", packetization mode " << packetization_mode_;
   RTC_CHECK_GT(fragment->length, 0u);
-  packets_.push(PacketUnit(*fragment, true /* first */, true /* last */,
-                           false /* aggregated */, fragment->buffer[0]));
+  packets_.push_back(PacketUnit(*fragment, true /* first */, true /* last */,
+                                false /* aggregated */, fragment->buffer[0]));
   ++num_packets_left_;
 }
 
 bool RtpPacketizerH264::NextPacket(RtpPacketToSend* rtp_packet) {
   RTC_DCHECK(rtp_packet);
-  if (packets_.empty()) {
+  if (next_packet_ == packets_.size()) {
     return false;
   }
 
-  PacketUnit packet = packets_.front();
+  const PacketUnit& packet = packets_[next_packet_];
   if (packet.first_fragment && packet.last_fragment) {
     // Single NAL unit packet.
     size_t bytes_to_send = packet.source_fragment.length;
     uint8_t* buffer = rtp_packet->AllocatePayload(bytes_to_send);
     memcpy(buffer, packet.source_fragment.buffer, bytes_to_send);
-    packets_.pop();
-    input_fragments_.pop_front();
+    ++next_packet_;
   } else if (packet.aggregated) {
     RTC_CHECK_EQ(H264PacketizationMode::NonInterleaved, packetization_mode_);
     bool is_last_packet = num_packets_left_ == 1;
@@ -325,11 +334,12 @@ bool RtpPacketizerH264::NextPacket(RtpPacketToSend* rtp_packet) {
     NextFragmentPacket(rtp_packet);
   }
   RTC_DCHECK_LE(rtp_packet->payload_size(), max_payload_len_);
-  if (packets_.empty()) {
+  const bool is_last_packet = next_packet_ == packets_.size();
+  if (is_last_packet) {
     RTC_DCHECK_LE(rtp_packet->payload_size(),
                   max_payload_len_ - last_packet_reduction_len_);
   }
-  rtp_packet->SetMarker(packets_.empty());
+  rtp_packet->SetMarker(is_last_packet);
   --num_packets_left_;
   return true;
 }
@@ -339,7 +349,7 @@ void RtpPacketizerH264::NextAggregatePacket(RtpPacketToSend* rtp_packet,
   uint8_t* buffer = rtp_packet->AllocatePayload(
       last ? max_payload_len_ - last_packet_reduction_len_ : max_payload_len_);
   RTC_DCHECK(buffer);
-  PacketUnit* packet = &packets_.front();
+  const PacketUnit* packet = &packets_[next_packet_];
   RTC_CHECK(packet->first_fragment);
   // STAP-A NALU header.
   buffer[0] = (packet->header & (kFBit | kNriMask)) | H264::NaluType::kStapA;
@@ -353,11 +363,10 @@ void RtpPacketizerH264::NextAggregatePacket(RtpPacketToSend* rtp_packet,
     // Add NAL unit.
     memcpy(&buffer[index], fragment.buffer, fragment.length);
     index += fragment.length;
-    packets_.pop();
-    input_fragments_.pop_front();
+    ++next_packet_;
     if (is_last_fragment)
       break;
-    packet = &packets_.front();
+    packet = &packets_[next_packet_];
     is_last_fragment = packet->last_fragment;
   }
   RTC_CHECK(is_last_fragment);
@@ -365,7 +374,7 @@ void RtpPacketizerH264::NextAggregatePacket(RtpPacketToSend* rtp_packet,
 }
 
 void RtpPacketizerH264::NextFragmentPacket(RtpPacketToSend* rtp_packet) {
-  PacketUnit* packet = &packets_.front();
+  const PacketUnit* packet = &packets_[next_packet_];
   // NAL unit fragmented over multiple packets (FU-A).
   // We do not send original NALU header, so it will be replaced by the
   // FU indicator header of the first packet.
@@ -384,9 +393,7 @@ void RtpPacketizerH264::NextFragmentPacket(RtpPacketToSend* rtp_packet) {
   buffer[0] = fu_indicator;
   buffer[1] = fu_header;
   memcpy(buffer + kFuAHeaderSize, fragment.buffer, fragment.length);
-  if (packet->last_fragment)
-    input_fragments_.pop_front();
-  packets_.pop();
+  ++next_packet_;
 }
 
 std::string RtpPacketizerH264::ToString() {
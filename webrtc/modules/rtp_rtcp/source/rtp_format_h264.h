@@ -11,10 +11,9 @@
 #ifndef WEBRTC_MODULES_RTP_RTCP_SOURCE_RTP_FORMAT_H264_H_
 #define WEBRTC_MODULES_RTP_RTCP_SOURCE_RTP_FORMAT_H264_H_
 
-#include <deque>
 #include <memory>
-#include <queue>
 #include <string>
+#include <vector>
 
 #include "webrtc/modules/rtp_rtcp/source/rtp_format.h"
 #include "webrtc/rtc_base/buffer.h"
@@ -49,6 +48,7 @@ class RtpPacketizerH264 : public RtpPacketizer {
   struct Fragment {
     Fragment(const uint8_t* buffer, size_t length);
     explicit Fragment(const Fragment& fragment);
+    Fragment(Fragment&& fragment) = default;
     const uint8_t* buffer = nullptr;
     size_t length = 0;
     std::unique_ptr<rtc::Buffer> tmp_buffer;
@@ -90,8 +90,11 @@ class RtpPacketizerH264 : public RtpPacketizer {
   const size_t last_packet_reduction_len_;
   size_t num_packets_left_;
   const H264PacketizationMode packetization_mode_;
-  std::deque<Fragment> input_fragments_;
-  std::queue<PacketUnit> packets_;
+  // Both are sized up front in SetPayloadData() and kept until the packetizer
+  // is destroyed, so that packetizing a frame does not allocate per packet.
+  std::vector<Fragment> input_fragments_;
+  std::vector<PacketUnit> packets_;
+  size_t next_packet_;
 
   RTC_DISALLOW_COPY_AND_ASSIGN(RtpPacketizerH264);
 };
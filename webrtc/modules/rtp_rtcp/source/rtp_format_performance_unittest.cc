@@ -0,0 +1,152 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/common_video/h264/h264_common.h"
+#include "webrtc/modules/include/module_common_types.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_format.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_packet_to_send.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+constexpr size_t kMaxPayloadLen = 1200;
+constexpr size_t kLastPacketReductionLen = 20;
+constexpr int kNumFrames = 2000;
+
+// Key frames carry roughly this many bytes per pixel at conference bitrates.
+constexpr double kKeyFrameBytesPerPixel = 0.1;
+
+struct Resolution {
+  const char* name;
+  int width;
+  int height;
+};
+
+constexpr Resolution kResolutions[] = {{"1080p", 1920, 1080},
+                                       {"4k", 3840, 2160}};
+
+// Splits |frame| into |num_fragments| consecutive fragments, the first one
+// being |first_fragment_len| bytes long.
+void CreateFragmentation(const std::vector<uint8_t>& frame,
+                         size_t num_fragments,
+                         size_t first_fragment_len,
+                         RTPFragmentationHeader* fragmentation) {
+  fragmentation->VerifyAndAllocateFragmentationHeader(num_fragments);
+  size_t fragment_len =
+      (frame.size() - first_fragment_len) / (num_fragments - 1);
+  size_t offset = 0;
+  for (size_t i = 0; i < num_fragments; ++i) {
+    size_t length = i == 0 ? first_fragment_len : fragment_len;
+    if (i + 1 == num_fragments)
+      length = frame.size() - offset;
+    fragmentation->fragmentationOffset[i] = offset;
+    fragmentation->fragmentationLength[i] = length;
+    offset += length;
+  }
+}
+
+// Packetizes |frame| |kNumFrames| times and reports the time spent per frame.
+void RunPacketizer(RtpVideoCodecTypes type,
+                   const RTPVideoTypeHeader& type_header,
+                   const std::vector<uint8_t>& frame,
+                   const RTPFragmentationHeader* fragmentation,
+                   const std::string& trace) {
+  RtpPacketToSend packet(nullptr);
+  size_t num_packets = 0;
+  size_t payload_bytes = 0;
+  const int64_t start_time_us = rtc::TimeMicros();
+  for (int i = 0; i < kNumFrames; ++i) {
+    std::unique_ptr<RtpPacketizer> packetizer(
+        RtpPacketizer::Create(type, kMaxPayloadLen, kLastPacketReductionLen,
+                              &type_header, kVideoFrameKey));
+    packetizer->SetPayloadData(frame.data(), frame.size(), fragmentation);
+    while (packetizer->NextPacket(&packet)) {
+      ++num_packets;
+      payload_bytes += packet.payload_size();
+    }
+  }
+  const int64_t elapsed_us = rtc::TimeMicros() - start_time_us;
+
+  ASSERT_GT(num_packets, 0u);
+  // Every payload byte is sent once, plus a payload header per packet.
+  EXPECT_GE(payload_bytes, frame.size() * kNumFrames);
+  test::PrintResult("packetize_time", "", trace,
+                    static_cast<size_t>(elapsed_us / kNumFrames), "us", true);
+  test::PrintResult("packets_per_frame", "", trace, num_packets / kNumFrames,
+                    "packets", false);
+}
+
+std::vector<uint8_t> CreateFrame(const Resolution& resolution) {
+  size_t size = static_cast<size_t>(resolution.width * resolution.height *
+                                    kKeyFrameBytesPerPixel);
+  std::vector<uint8_t> frame(size);
+  for (size_t i = 0; i < size; ++i)
+    frame[i] = static_cast<uint8_t>(i);
+  return frame;
+}
+
+}  // namespace
+
+// The tests below only report timings and are disabled; run them with
+// --gtest_also_run_disabled_tests.
+TEST(RtpPacketizerPerformanceTest, DISABLED_H264) {
+  // One IDR slice per 8 rows of macroblocks.
+  for (const Resolution& resolution : kResolutions) {
+    std::vector<uint8_t> frame = CreateFrame(resolution);
+    const size_t kNumSlices = resolution.height / (16 * 8);
+    RTPFragmentationHeader fragmentation;
+    CreateFragmentation(frame, kNumSlices, frame.size() / kNumSlices,
+                        &fragmentation);
+    for (size_t i = 0; i < kNumSlices; ++i)
+      frame[fragmentation.fragmentationOffset[i]] = H264::kIdr;
+    RTPVideoTypeHeader type_header;
+    type_header.H264.packetization_mode =
+        H264PacketizationMode::NonInterleaved;
+    RunPacketizer(kRtpVideoH264, type_header, frame, &fragmentation,
+                  std::string("h264_") + resolution.name);
+  }
+}
+
+TEST(RtpPacketizerPerformanceTest, DISABLED_Vp8) {
+  // A first partition of mode and motion vectors and 8 token partitions.
+  const size_t kNumPartitions = 9;
+  for (const Resolution& resolution : kResolutions) {
+    std::vector<uint8_t> frame = CreateFrame(resolution);
+    RTPFragmentationHeader fragmentation;
+    CreateFragmentation(frame, kNumPartitions, frame.size() / 10,
+                        &fragmentation);
+    RTPVideoTypeHeader type_header;
+    type_header.VP8.InitRTPVideoHeaderVP8();
+    type_header.VP8.pictureId = 1000;
+    RunPacketizer(kRtpVideoVp8, type_header, frame, &fragmentation,
+                  std::string("vp8_") + resolution.name);
+  }
+}
+
+TEST(RtpPacketizerPerformanceTest, DISABLED_Vp9) {
+  for (const Resolution& resolution : kResolutions) {
+    std::vector<uint8_t> frame = CreateFrame(resolution);
+    RTPVideoTypeHeader type_header;
+    type_header.VP9.InitRTPVideoHeaderVP9();
+    type_header.VP9.picture_id = 1000;
+    type_header.VP9.max_picture_id = kMaxTwoBytePictureId;
+    RunPacketizer(kRtpVideoVp9, type_header, frame, nullptr,
+                  std::string("vp9_") + resolution.name);
+  }
+}
+
+}  // namespace webrtc
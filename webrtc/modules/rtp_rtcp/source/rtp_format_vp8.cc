@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "webrtc/modules/rtp_rtcp/source/rtp_packet_to_send.h"
+#include "webrtc/rtc_base/checks.h"
 #include "webrtc/rtc_base/logging.h"
 
 namespace webrtc {
@@ -152,20 +153,27 @@ RtpPacketizerVp8::RtpPacketizerVp8(const RTPVideoHeaderVP8& hdr_info,
       hdr_info_(hdr_info),
       num_partitions_(0),
       max_payload_len_(max_payload_len),
-      last_packet_reduction_len_(last_packet_reduction_len) {}
+      last_packet_reduction_len_(last_packet_reduction_len),
+      next_packet_(0) {
+  part_offsets_.reserve(kMaxPartitions);
+  part_lengths_.reserve(kMaxPartitions);
+}
 
 RtpPacketizerVp8::RtpPacketizerVp8(const RTPVideoHeaderVP8& hdr_info,
                                    size_t max_payload_len,
                                    size_t last_packet_reduction_len)
     : payload_data_(NULL),
       payload_size_(0),
-      part_info_(),
       vp8_fixed_payload_descriptor_bytes_(1),
       mode_(kEqualSize),
       hdr_info_(hdr_info),
       num_partitions_(0),
       max_payload_len_(max_payload_len),
-      last_packet_reduction_len_(last_packet_reduction_len) {}
+      last_packet_reduction_len_(last_packet_reduction_len),
+      next_packet_(0) {
+  part_offsets_.reserve(kMaxPartitions);
+  part_lengths_.reserve(kMaxPartitions);
+}
 
 RtpPacketizerVp8::~RtpPacketizerVp8() {
 }
@@ -177,13 +185,16 @@ size_t RtpPacketizerVp8::SetPayloadData(
   payload_data_ = payload_data;
   payload_size_ = payload_size;
   if (fragmentation) {
-    part_info_.CopyFrom(*fragmentation);
     num_partitions_ = fragmentation->fragmentationVectorSize;
+    part_offsets_.assign(fragmentation->fragmentationOffset,
+                         fragmentation->fragmentationOffset + num_partitions_);
+    part_lengths_.assign(fragmentation->fragmentationLength,
+                         fragmentation->fragmentationLength + num_partitions_);
   } else {
-    part_info_.VerifyAndAllocateFragmentationHeader(1);
-    part_info_.fragmentationLength[0] = payload_size;
-    part_info_.fragmentationOffset[0] = 0;
-    num_partitions_ = part_info_.fragmentationVectorSize;
+    // No partition info. Treat the frame as a single partition.
+    num_partitions_ = 1;
+    part_offsets_.assign(1, 0);
+    part_lengths_.assign(1, payload_size);
   }
   if (GeneratePackets() < 0) {
     return 0;
@@ -193,21 +204,21 @@ size_t RtpPacketizerVp8::SetPayloadData(
 
 bool RtpPacketizerVp8::NextPacket(RtpPacketToSend* packet) {
   RTC_DCHECK(packet);
-  if (packets_.empty()) {
+  if (next_packet_ == packets_.size()) {
     return false;
   }
-  InfoStruct packet_info = packets_.front();
-  packets_.pop();
+  const InfoStruct& packet_info = packets_[next_packet_++];
+  const bool is_last_packet = next_packet_ == packets_.size();
 
   uint8_t* buffer = packet->AllocatePayload(
-      packets_.empty() ? max_payload_len_ - last_packet_reduction_len_
-                       : max_payload_len_);
+      is_last_packet ? max_payload_len_ - last_packet_reduction_len_
+                     : max_payload_len_);
   int bytes = WriteHeaderAndPayload(packet_info, buffer, max_payload_len_);
   if (bytes < 0) {
     return false;
   }
   packet->SetPayloadSize(bytes);
-  packet->SetMarker(packets_.empty());
+  packet->SetMarker(is_last_packet);
   return true;
 }
 
@@ -228,6 +239,11 @@ int RtpPacketizerVp8::GeneratePackets() {
   size_t per_packet_capacity =
       max_payload_len_ -
       (vp8_fixed_payload_descriptor_bytes_ + PayloadDescriptorExtraLength());
+  // Balanced splitting needs at most one packet more per partition than an
+  // even split of the whole frame.
+  packets_.reserve(
+      (payload_size_ + last_packet_reduction_len_) / per_packet_capacity +
+      num_partitions_ + 1);
 
   if (mode_ == kEqualSize) {
     GeneratePacketsSplitPayloadBalanced(0, payload_size_, per_packet_capacity,
@@ -243,14 +259,13 @@ int RtpPacketizerVp8::GeneratePackets() {
     // Check if the next partition fits in to single packet with some space
     // left to aggregate some partitions together.
     if (mode_ == kAggregate &&
-        part_info_.fragmentationLength[part_idx] < current_packet_capacity) {
+        part_lengths_[part_idx] < current_packet_capacity) {
       part_idx =
           GeneratePacketsAggregatePartitions(part_idx, per_packet_capacity);
     } else {
       GeneratePacketsSplitPayloadBalanced(
-          part_info_.fragmentationOffset[part_idx],
-          part_info_.fragmentationLength[part_idx], per_packet_capacity,
-          last_partition, part_idx);
+          part_offsets_[part_idx], part_lengths_[part_idx],
+          per_packet_capacity, last_partition, part_idx);
       ++part_idx;
     }
   }
@@ -299,14 +314,13 @@ size_t RtpPacketizerVp8::GeneratePacketsAggregatePartitions(size_t part_idx,
   // Bloat the last partition by the reduction of the last packet. As it always
   // will be in the last packet we can pretend that the last packet is the same
   // size as the rest of the packets. Done temporary to simplify calculations.
-  part_info_.fragmentationLength[num_partitions_ - 1] +=
-      last_packet_reduction_len_;
+  part_lengths_[num_partitions_ - 1] += last_packet_reduction_len_;
   // Current partition should fit into the packet.
-  RTC_CHECK_LE(part_info_.fragmentationLength[part_idx], capacity);
+  RTC_CHECK_LE(part_lengths_[part_idx], capacity);
   // Find all partitions, shorter than capacity.
   size_t end_part = part_idx + 1;
   while (end_part < num_partitions_ &&
-         part_info_.fragmentationLength[end_part] <= capacity) {
+         part_lengths_[end_part] <= capacity) {
     ++end_part;
   }
   size_t total_partitions = end_part - part_idx;
@@ -329,14 +343,25 @@ size_t RtpPacketizerVp8::GeneratePacketsAggregatePartitions(size_t part_idx,
     }
   };
 
-  std::vector<PartitionScore> scores(total_partitions + 1);
+  // best_block_size[i] stores optimal number of partitions to be aggregated
+  // in the first packet if only last i partitions are considered. Frames with
+  // more partitions than VP8 produces fall back to heap storage.
+  PartitionScore stack_scores[kMaxPartitions + 1];
+  size_t stack_best_block_size[kMaxPartitions + 1] = {0};
+  std::vector<PartitionScore> heap_scores;
+  std::vector<size_t> heap_best_block_size;
+  PartitionScore* scores = stack_scores;
+  size_t* best_block_size = stack_best_block_size;
+  if (total_partitions > kMaxPartitions) {
+    heap_scores.resize(total_partitions + 1);
+    heap_best_block_size.assign(total_partitions + 1, 0);
+    scores = heap_scores.data();
+    best_block_size = heap_best_block_size.data();
+  }
   // 0 partitions can be split into 0 packets with largest of size 0.
   scores[0].num_packets = 0;
   scores[0].largest_packet_len = 0;
 
-  // best_block_size[i] stores optimal number of partitions to be aggregated
-  // in the first packet if only last i partitions are considered.
-  std::vector<size_t> best_block_size(total_partitions + 1, 0);
   // Calculate scores and best_block_size iteratively.
   for (size_t partitions_left = 0; partitions_left < total_partitions;
        ++partitions_left) {
@@ -351,8 +376,7 @@ size_t RtpPacketizerVp8::GeneratePacketsAggregatePartitions(size_t part_idx,
     // best score for |partitions_left| partitions.
     for (size_t new_partitions_left = partitions_left + 1;
          new_partitions_left <= total_partitions; ++new_partitions_left) {
-      current_payload_len +=
-          part_info_.fragmentationLength[end_part - new_partitions_left];
+      current_payload_len += part_lengths_[end_part - new_partitions_left];
       if (current_payload_len > capacity)
         break;
       // Update maximum packet size.
@@ -368,19 +392,18 @@ size_t RtpPacketizerVp8::GeneratePacketsAggregatePartitions(size_t part_idx,
     }
   }
   // Undo temporary change.
-  part_info_.fragmentationLength[num_partitions_ - 1] -=
-      last_packet_reduction_len_;
+  part_lengths_[num_partitions_ - 1] -= last_packet_reduction_len_;
   // Restore answer given sizes of aggregated blocks in |best_block_size| for
   // each possible left number of partitions.
   size_t partitions_left = total_partitions;
   while (partitions_left > 0) {
     size_t cur_parts = best_block_size[partitions_left];
     size_t first_partition = end_part - partitions_left;
-    size_t start_offset = part_info_.fragmentationOffset[first_partition];
+    size_t start_offset = part_offsets_[first_partition];
     size_t post_last_partition = first_partition + cur_parts;
     size_t finish_offset =
         (post_last_partition < num_partitions_)
-            ? part_info_.fragmentationOffset[post_last_partition]
+            ? part_offsets_[post_last_partition]
             : payload_size_;
     size_t current_payload_len = finish_offset - start_offset;
     QueuePacket(start_offset, current_payload_len, first_partition, true);
@@ -400,7 +423,7 @@ void RtpPacketizerVp8::QueuePacket(size_t start_pos,
   packet_info.size = packet_size;
   packet_info.first_partition_ix = first_partition_in_packet;
   packet_info.first_fragment = start_on_new_fragment;
-  packets_.push(packet_info);
+  packets_.push_back(packet_info);
 }
 
 int RtpPacketizerVp8::WriteHeaderAndPayload(const InfoStruct& packet_info,
@@ -25,7 +25,6 @@
 #ifndef WEBRTC_MODULES_RTP_RTCP_SOURCE_RTP_FORMAT_VP8_H_
 #define WEBRTC_MODULES_RTP_RTCP_SOURCE_RTP_FORMAT_VP8_H_
 
-#include <queue>
 #include <string>
 #include <vector>
 
@@ -81,7 +80,12 @@ class RtpPacketizerVp8 : public RtpPacketizer {
     bool first_fragment;
     size_t first_partition_ix;
   } InfoStruct;
-  typedef std::queue<InfoStruct> InfoQueue;
+  typedef std::vector<InfoStruct> InfoVector;
+
+  // A VP8 frame has a first partition and at most 8 token partitions. Storage
+  // for this many partitions is reserved up front; frames with more partitions
+  // are still packetized but grow the storage.
+  static const size_t kMaxPartitions = 9;
 
   static const int kXBit = 0x80;
   static const int kNBit = 0x20;
@@ -174,7 +178,8 @@ class RtpPacketizerVp8 : public RtpPacketizer {
 
   const uint8_t* payload_data_;
   size_t payload_size_;
-  RTPFragmentationHeader part_info_;
+  std::vector<size_t> part_offsets_;
+  std::vector<size_t> part_lengths_;
   const size_t vp8_fixed_payload_descriptor_bytes_;  // Length of VP8 payload
                                                      // descriptors' fixed part.
   const VP8PacketizerMode mode_;
@@ -182,7 +187,9 @@ class RtpPacketizerVp8 : public RtpPacketizer {
   size_t num_partitions_;
   const size_t max_payload_len_;
   const size_t last_packet_reduction_len_;
-  InfoQueue packets_;
+  // All packets of the frame, computed up front by GeneratePackets().
+  InfoVector packets_;
+  size_t next_packet_;
 
   RTC_DISALLOW_COPY_AND_ASSIGN(RtpPacketizerVp8);
 };
@@ -183,6 +183,33 @@ TEST_F(RtpPacketizerVp8Test, TestAggregateMode) {
                                  kExpectedNum);
 }
 
+// Verify that frames with more partitions than VP8 produces are still
+// packetized partition by partition.
+TEST_F(RtpPacketizerVp8Test, TestAggregateModeManyPartitions) {
+  const size_t kSizeVector[] = {10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10};
+  const size_t kNumPartitions = GTEST_ARRAY_SIZE_(kSizeVector);
+  ASSERT_TRUE(Init(kSizeVector, kNumPartitions));
+
+  hdr_info_.pictureId = 20;
+  const size_t kMaxPayloadSize = 25;
+  RtpPacketizerVp8 packetizer(hdr_info_, kMaxPayloadSize, 0, kAggregate);
+  size_t num_packets = packetizer.SetPayloadData(helper_->payload_data(),
+                                                 helper_->payload_size(),
+                                                 helper_->fragmentation());
+
+  // The expected sizes are obtained by hand.
+  const size_t kExpectedSizes[] = {24, 24, 24, 24, 24, 24};
+  const int kExpectedPart[] = {0, 2, 4, 6, 8, 10};
+  const bool kExpectedFragStart[] = {true, true, true, true, true, true};
+  const size_t kExpectedNum = GTEST_ARRAY_SIZE_(kExpectedSizes);
+  CHECK_ARRAY_SIZE(kExpectedNum, kExpectedPart);
+  CHECK_ARRAY_SIZE(kExpectedNum, kExpectedFragStart);
+  ASSERT_EQ(num_packets, kExpectedNum);
+
+  helper_->GetAllPacketsAndCheck(&packetizer, kExpectedSizes, kExpectedPart,
+                                 kExpectedFragStart, kExpectedNum);
+}
+
 TEST_F(RtpPacketizerVp8Test, TestAggregateModePacketReductionCauseExtraPacket) {
   const size_t kSizeVector[] = {60, 10, 10};
   const size_t kNumPartitions = GTEST_ARRAY_SIZE_(kSizeVector);
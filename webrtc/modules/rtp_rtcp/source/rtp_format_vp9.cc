@@ -156,13 +156,13 @@ void QueuePacket(size_t start_pos,
                  size_t size,
                  bool layer_begin,
                  bool layer_end,
-                 RtpPacketizerVp9::PacketInfoQueue* packets) {
+                 RtpPacketizerVp9::PacketInfoVector* packets) {
   RtpPacketizerVp9::PacketInfo packet_info;
   packet_info.payload_start_pos = start_pos;
   packet_info.size = size;
   packet_info.layer_begin = layer_begin;
   packet_info.layer_end = layer_end;
-  packets->push(packet_info);
+  packets->push_back(packet_info);
 }
 
 // Picture ID:
@@ -467,7 +467,8 @@ RtpPacketizerVp9::RtpPacketizerVp9(const RTPVideoHeaderVP9& hdr,
       max_payload_length_(max_payload_length),
       payload_(nullptr),
       payload_size_(0),
-      last_packet_reduction_len_(last_packet_reduction_len) {}
+      last_packet_reduction_len_(last_packet_reduction_len),
+      next_packet_(0) {}
 
 RtpPacketizerVp9::~RtpPacketizerVp9() {
 }
@@ -528,6 +529,7 @@ void RtpPacketizerVp9::GeneratePackets() {
   // Several last packets are 1 byte larger than the rest.
   // i.e. if 14 bytes were split between 4 packets, it would be 3+3+4+4.
   size_t num_larger_packets = total_bytes % num_packets;
+  packets_.reserve(num_packets);
   size_t bytes_processed = 0;
   size_t num_packets_left = num_packets;
   while (bytes_processed < payload_size_) {
@@ -566,16 +568,16 @@ void RtpPacketizerVp9::GeneratePackets() {
 
 bool RtpPacketizerVp9::NextPacket(RtpPacketToSend* packet) {
   RTC_DCHECK(packet);
-  if (packets_.empty()) {
+  if (next_packet_ == packets_.size()) {
     return false;
   }
-  PacketInfo packet_info = packets_.front();
-  packets_.pop();
+  const PacketInfo& packet_info = packets_[next_packet_++];
+  const bool is_last_packet = next_packet_ == packets_.size();
 
-  if (!WriteHeaderAndPayload(packet_info, packet, packets_.empty())) {
+  if (!WriteHeaderAndPayload(packet_info, packet, is_last_packet)) {
     return false;
   }
-  packet->SetMarker(packets_.empty() &&
+  packet->SetMarker(is_last_packet &&
                     (hdr_.spatial_idx == kNoSpatialIdx ||
                      hdr_.spatial_idx == hdr_.num_spatial_layers - 1));
   return true;
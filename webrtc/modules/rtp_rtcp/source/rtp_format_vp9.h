@@ -21,8 +21,8 @@
 #ifndef WEBRTC_MODULES_RTP_RTCP_SOURCE_RTP_FORMAT_VP9_H_
 #define WEBRTC_MODULES_RTP_RTCP_SOURCE_RTP_FORMAT_VP9_H_
 
-#include <queue>
 #include <string>
+#include <vector>
 
 #include "webrtc/modules/include/module_common_types.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_format.h"
@@ -57,7 +57,7 @@ class RtpPacketizerVp9 : public RtpPacketizer {
     bool layer_begin;
     bool layer_end;
   } PacketInfo;
-  typedef std::queue<PacketInfo> PacketInfoQueue;
+  typedef std::vector<PacketInfo> PacketInfoVector;
 
  private:
   // Calculates all packet sizes and loads info to packet queue.
@@ -82,7 +82,9 @@ class RtpPacketizerVp9 : public RtpPacketizer {
   const uint8_t* payload_;           // The payload data to be packetized.
   size_t payload_size_;              // The size in bytes of the payload data.
   const size_t last_packet_reduction_len_;
-  PacketInfoQueue packets_;
+  // All packets of the layer frame, computed up front by GeneratePackets().
+  PacketInfoVector packets_;
+  size_t next_packet_;
 
   RTC_DISALLOW_COPY_AND_ASSIGN(RtpPacketizerVp9);
 };
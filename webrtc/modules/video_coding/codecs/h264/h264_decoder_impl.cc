@@ -37,6 +37,10 @@ const size_t kYPlaneIndex = 0;
 const size_t kUPlaneIndex = 1;
 const size_t kVPlaneIndex = 2;
 
+// FFmpeg keeps up to 16 reference frames, plus the frame being decoded, in
+// buffers from |H264DecoderImpl::pool_|.
+const size_t kMaxDecoderHeldFrames = 17;
+
 // Used by histograms. Values of entries should not be changed.
 enum H264DecoderImplEvent {
   kH264DecoderEventInit = 0,
@@ -133,6 +137,11 @@ int H264DecoderImpl::AVGetBuffer2(
   // an explicit call to InitializeData here.
   rtc::scoped_refptr<I420Buffer> frame_buffer =
       decoder->pool_.CreateBuffer(width, height);
+  if (!frame_buffer) {
+    LOG(LS_ERROR) << "Too many decoded frames are pending.";
+    decoder->ReportError();
+    return -1;
+  }
 
   int y_size = width * height;
   int uv_size = frame_buffer->ChromaWidth() * frame_buffer->ChromaHeight();
@@ -177,11 +186,11 @@ void H264DecoderImpl::AVFreeBuffer2(void* opaque, uint8_t* data) {
   delete video_frame;
 }
 
-H264DecoderImpl::H264DecoderImpl() : pool_(true),
-                                     decoded_image_callback_(nullptr),
-                                     has_reported_init_(false),
-                                     has_reported_error_(false) {
-}
+H264DecoderImpl::H264DecoderImpl()
+    : pool_(true, kMaxDecoderHeldFrames + kMaxPendingDecodedFrames),
+      decoded_image_callback_(nullptr),
+      has_reported_init_(false),
+      has_reported_error_(false) {}
 
 H264DecoderImpl::~H264DecoderImpl() {
   Release();
@@ -8,6 +8,10 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <memory>
+#include <vector>
+
+#include "webrtc/common_video/include/i420_buffer_pool.h"
 #include "webrtc/common_video/libyuv/include/webrtc_libyuv.h"
 #include "webrtc/modules/video_coding/codecs/h264/include/h264.h"
 #include "webrtc/modules/video_coding/codecs/test/video_codec_test.h"
@@ -35,9 +39,11 @@ class TestH264Impl : public VideoCodecTest {
 #ifdef WEBRTC_USE_H264
 #define MAYBE_EncodeDecode EncodeDecode
 #define MAYBE_DecodedQpEqualsEncodedQp DecodedQpEqualsEncodedQp
+#define MAYBE_DecoderLimitsPendingFrames DecoderLimitsPendingFrames
 #else
 #define MAYBE_EncodeDecode DISABLED_EncodeDecode
 #define MAYBE_DecodedQpEqualsEncodedQp DISABLED_DecodedQpEqualsEncodedQp
+#define MAYBE_DecoderLimitsPendingFrames DISABLED_DecoderLimitsPendingFrames
 #endif
 
 TEST_F(TestH264Impl, MAYBE_EncodeDecode) {
@@ -75,4 +81,46 @@ TEST_F(TestH264Impl, MAYBE_DecodedQpEqualsEncodedQp) {
   EXPECT_EQ(encoded_frame.qp_, *decoded_qp);
 }
 
+TEST_F(TestH264Impl, MAYBE_DecoderLimitsPendingFrames) {
+  // FFmpeg holds on to at most 16 reference frames and the frame being
+  // decoded, on top of the frames held by the application.
+  const size_t kMaxDecoderHeldFrames = 17;
+  EXPECT_EQ(WEBRTC_VIDEO_CODEC_OK,
+            encoder_->Encode(*input_frame_, nullptr, nullptr));
+  EncodedImage encoded_frame;
+  CodecSpecificInfo codec_specific_info;
+  ASSERT_TRUE(WaitForEncodedFrame(&encoded_frame, &codec_specific_info));
+  encoded_frame._frameType = kVideoFrameKey;
+
+  // The application can hold on to its budget of frames.
+  std::vector<std::unique_ptr<VideoFrame>> pending_frames;
+  for (size_t i = 0; i < kMaxPendingDecodedFrames; ++i) {
+    ASSERT_EQ(WEBRTC_VIDEO_CODEC_OK,
+              decoder_->Decode(encoded_frame, false, nullptr));
+    std::unique_ptr<VideoFrame> decoded_frame;
+    rtc::Optional<uint8_t> decoded_qp;
+    ASSERT_TRUE(WaitForDecodedFrame(&decoded_frame, &decoded_qp));
+    pending_frames.push_back(std::move(decoded_frame));
+  }
+
+  // Holding on to more frames exhausts the pool, and decoding fails instead
+  // of crashing.
+  int result = WEBRTC_VIDEO_CODEC_OK;
+  for (size_t i = 0; i <= kMaxDecoderHeldFrames; ++i) {
+    result = decoder_->Decode(encoded_frame, false, nullptr);
+    if (result != WEBRTC_VIDEO_CODEC_OK)
+      break;
+    std::unique_ptr<VideoFrame> decoded_frame;
+    rtc::Optional<uint8_t> decoded_qp;
+    ASSERT_TRUE(WaitForDecodedFrame(&decoded_frame, &decoded_qp));
+    pending_frames.push_back(std::move(decoded_frame));
+  }
+  EXPECT_EQ(WEBRTC_VIDEO_CODEC_ERROR, result);
+
+  // Releasing the frames makes their buffers available again.
+  pending_frames.clear();
+  EXPECT_EQ(WEBRTC_VIDEO_CODEC_OK,
+            decoder_->Decode(encoded_frame, false, nullptr));
+}
+
 }  // namespace webrtc
@@ -60,6 +60,37 @@ size_t Stats::size() const {
   return stats_.size();
 }
 
+int Stats::DecodeTimePercentileUs(int percentile) const {
+  RTC_DCHECK_GE(percentile, 0);
+  RTC_DCHECK_LE(percentile, 100);
+  std::vector<int> decode_times_us;
+  for (const FrameStatistic& stat : stats_) {
+    if (stat.decoding_successful) {
+      decode_times_us.push_back(stat.decode_time_us);
+    }
+  }
+  if (decode_times_us.empty()) {
+    return -1;
+  }
+  // Nearest-rank percentile.
+  size_t rank = (percentile * decode_times_us.size() + 99) / 100;
+  size_t index = rank > 0 ? rank - 1 : 0;
+  std::nth_element(decode_times_us.begin(), decode_times_us.begin() + index,
+                   decode_times_us.end());
+  return decode_times_us[index];
+}
+
+int Stats::AverageEncodeTimeUs() const {
+  if (stats_.empty()) {
+    return -1;
+  }
+  int64_t total_encoding_time_us = 0;
+  for (const FrameStatistic& stat : stats_) {
+    total_encoding_time_us += stat.encode_time_us;
+  }
+  return static_cast<int>(total_encoding_time_us / stats_.size());
+}
+
 void Stats::PrintSummary() const {
   if (stats_.empty()) {
     printf("No frame statistics have been logged yet.\n");
@@ -122,6 +153,9 @@ void Stats::PrintSummary() const {
            frame_it->frame_number);
     printf("  Average : %7d us\n",
            static_cast<int>(total_decoding_time_us / decoded_frames.size()));
+    printf("  50th pct: %7d us\n", DecodeTimePercentileUs(50));
+    printf("  90th pct: %7d us\n", DecodeTimePercentileUs(90));
+    printf("  99th pct: %7d us\n", DecodeTimePercentileUs(99));
     printf("  Failures: %d frames failed to decode.\n",
            static_cast<int>(stats_.size() - decoded_frames.size()));
   }
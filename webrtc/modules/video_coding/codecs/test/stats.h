@@ -63,6 +63,13 @@ class Stats {
 
   size_t size() const;
 
+  // Returns the |percentile|th percentile of the decode time of the frames that
+  // were successfully decoded, or -1 if no frame was.
+  int DecodeTimePercentileUs(int percentile) const;
+
+  // Returns the average encode time of all frames, or -1 if there are none.
+  int AverageEncodeTimeUs() const;
+
   // TODO(brandtr): Add output as CSV.
   void PrintSummary() const;
 
@@ -39,5 +39,26 @@ TEST(StatsTest, AddMultipleFrames) {
   stats.PrintSummary();  // Should not crash.
 }
 
+TEST(StatsTest, DecodeTimePercentiles) {
+  Stats stats;
+  EXPECT_EQ(-1, stats.DecodeTimePercentileUs(50));
+
+  // Decode times 100, 200, ..., 10000 us, in reverse order.
+  const int kNumFrames = 100;
+  for (int i = 0; i < kNumFrames; ++i) {
+    FrameStatistic* frame_stat = stats.AddFrame();
+    frame_stat->decoding_successful = true;
+    frame_stat->decode_time_us = (kNumFrames - i) * 100;
+  }
+  // A frame that failed to decode is not counted.
+  FrameStatistic* frame_stat = stats.AddFrame();
+  frame_stat->decode_time_us = 1000000;
+
+  EXPECT_EQ(100, stats.DecodeTimePercentileUs(0));
+  EXPECT_EQ(5000, stats.DecodeTimePercentileUs(50));
+  EXPECT_EQ(9900, stats.DecodeTimePercentileUs(99));
+  EXPECT_EQ(10000, stats.DecodeTimePercentileUs(100));
+}
+
 }  // namespace test
 }  // namespace webrtc
@@ -189,8 +189,12 @@ void VideoProcessor::Init() {
       WEBRTC_VIDEO_CODEC_OK)
       << "Failed to initialize VideoEncoder";
 
-  RTC_CHECK_EQ(decoder_->InitDecode(&config_.codec_settings, num_cores),
-               WEBRTC_VIDEO_CODEC_OK)
+  int num_decoder_cores = config_.num_decoder_cores > 0
+                              ? config_.num_decoder_cores
+                              : static_cast<int>(num_cores);
+  RTC_CHECK_EQ(
+      decoder_->InitDecode(&config_.codec_settings, num_decoder_cores),
+      WEBRTC_VIDEO_CODEC_OK)
       << "Failed to initialize VideoDecoder";
 
   if (config_.verbose) {
@@ -199,6 +203,7 @@ void VideoProcessor::Init() {
     printf(" Total # of frames: %d\n",
            analysis_frame_reader_->NumberOfFrames());
     printf(" # CPU cores used : %d\n", num_cores);
+    printf(" # CPU cores used by decoder: %d\n", num_decoder_cores);
     const char* encoder_name = encoder_->ImplementationName();
     printf(" Encoder implementation name: %s\n", encoder_name);
     const char* decoder_name = decoder_->ImplementationName();
@@ -78,6 +78,11 @@ struct TestConfig {
   // If set to false, the maximum number of available cores will be used.
   bool use_single_core = false;
 
+  // If > 0: the number of cores given to the decoder, regardless of
+  // |use_single_core|. The decoder output does not depend on the number of
+  // cores, so this can be varied to measure decoder threading.
+  int num_decoder_cores = 0;
+
   // If > 0: forces the encoder to create a keyframe every Nth frame.
   // Note that the encoder may create a keyframe in other locations in addition
   // to this setting. Forcing key frames may also affect encoder planning
@@ -33,7 +33,6 @@
 #include "webrtc/rtc_base/ptr_util.h"
 #include "webrtc/system_wrappers/include/sleep.h"
 #include "webrtc/test/testsupport/fileutils.h"
-#include "webrtc/test/testsupport/metrics/video_metrics.h"
 #include "webrtc/test/video_codec_settings.h"
 
 namespace webrtc {
@@ -254,17 +253,17 @@ void VideoProcessorIntegrationTest::ProcessFramesAndMaybeVerify(
 
   // Calculate and print image quality statistics.
   // TODO(marpan): Should compute these quality metrics per SetRates update.
-  QualityMetricsResult psnr_result, ssim_result;
   EXPECT_EQ(0, I420MetricsFromFiles(config_.input_filename.c_str(),
                                     config_.output_filename.c_str(),
                                     config_.codec_settings.width,
-                                    config_.codec_settings.height, &psnr_result,
-                                    &ssim_result));
+                                    config_.codec_settings.height,
+                                    &psnr_result_, &ssim_result_));
   if (quality_thresholds) {
-    VerifyQuality(psnr_result, ssim_result, *quality_thresholds);
+    VerifyQuality(psnr_result_, ssim_result_, *quality_thresholds);
   }
-  printf("PSNR avg: %f, min: %f\nSSIM avg: %f, min: %f\n", psnr_result.average,
-         psnr_result.min, ssim_result.average, ssim_result.min);
+  printf("PSNR avg: %f, min: %f\nSSIM avg: %f, min: %f\n",
+         psnr_result_.average, psnr_result_.min, ssim_result_.average,
+         ssim_result_.min);
   printf("\n");
 
   // Remove analysis file.
@@ -25,6 +25,7 @@
 #include "webrtc/test/gtest.h"
 #include "webrtc/test/testsupport/frame_reader.h"
 #include "webrtc/test/testsupport/frame_writer.h"
+#include "webrtc/test/testsupport/metrics/video_metrics.h"
 #include "webrtc/test/testsupport/packet_reader.h"
 
 namespace webrtc {
@@ -126,9 +127,16 @@ class VideoProcessorIntegrationTest : public testing::Test {
       const QualityThresholds* quality_thresholds,
       const VisualizationParams* visualization_params);
 
+  const Stats& stats() const { return stats_; }
+
   // Config.
   TestConfig config_;
 
+  // Image quality of the frames processed by the last call to
+  // |ProcessFramesAndMaybeVerify|.
+  QualityMetricsResult psnr_result_;
+  QualityMetricsResult ssim_result_;
+
  private:
   static const int kMaxNumTemporalLayers = 3;
 
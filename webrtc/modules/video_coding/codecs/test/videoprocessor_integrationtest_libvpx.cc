@@ -10,9 +10,13 @@
 
 #include "webrtc/modules/video_coding/codecs/test/videoprocessor_integrationtest.h"
 
+#include <string>
 #include <vector>
 
+#include "webrtc/rtc_base/stringencode.h"
+#include "webrtc/test/field_trial.h"
 #include "webrtc/test/testsupport/fileutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
 
 namespace webrtc {
 namespace test {
@@ -23,10 +27,17 @@ namespace {
 const bool kResilienceOn = true;
 const int kCifWidth = 352;
 const int kCifHeight = 288;
+const int kHdWidth = 1280;
+const int kHdHeight = 720;
 #if !defined(WEBRTC_IOS)
 const int kNumFramesShort = 100;
 #endif
 const int kNumFramesLong = 300;
+const int kNumFramesHd = 100;
+
+// Encode time budgets, in percent of the frame interval. A lower budget models
+// more encoders sharing a CPU.
+const int kEncodeTimeBudgetsPercent[] = {100, 50, 25, 10};
 
 const std::nullptr_t kNoVisualizationParams = nullptr;
 
@@ -47,8 +58,76 @@ class VideoProcessorIntegrationTestLibvpx
     config_.hw_encoder = false;
     config_.hw_decoder = false;
   }
+
+  // Encodes a 720p sequence with eight token partitions, decodes it with
+  // |num_decoder_cores| cores and reports the decode time percentiles.
+  void ProcessHdWithDecoderCores(int num_decoder_cores) {
+    ScopedFieldTrials override_field_trials(
+        "WebRTC-VP8-TokenPartitions/Enabled-8/");
+
+    config_.filename = "ConferenceMotion_1280_720_50";
+    config_.input_filename = ResourcePath(config_.filename, "yuv");
+    config_.num_decoder_cores = num_decoder_cores;
+    SetCodecSettings(&config_, kVideoCodecVP8, 1, false, false, true, false,
+                     kResilienceOn, kHdWidth, kHdHeight);
+
+    RateProfile rate_profile;
+    SetRateProfile(&rate_profile, 0, 2000, 30, 0);
+    rate_profile.frame_index_rate_update[1] = kNumFramesHd + 1;
+    rate_profile.num_frames = kNumFramesHd;
+
+    ProcessFramesAndMaybeVerify(rate_profile, nullptr, nullptr,
+                                kNoVisualizationParams);
+
+    const std::string modifier =
+        "_" + rtc::ToString(num_decoder_cores) + "_cores";
+    for (int percentile : {50, 90, 99}) {
+      PrintResult("vp8_decode_time", modifier,
+                  "p" + rtc::ToString(percentile),
+                  stats().DecodeTimePercentileUs(percentile), "us", false);
+    }
+  }
 };
 
+// Quality versus CPU usage with the encoder speed adjusted to hold the encode
+// time within a budget.
+class VideoProcessorIntegrationTestLibvpxSpeedControl
+    : public VideoProcessorIntegrationTestLibvpx,
+      public ::testing::WithParamInterface<int> {
+ protected:
+  void ProcessWithEncodeTimeBudget(VideoCodecType codec_type,
+                                   const std::string& codec_name) {
+    const int budget_percent = GetParam();
+    ScopedFieldTrials override_field_trials(
+        "WebRTC-VideoEncoderSpeedControl/Enabled-" +
+        rtc::ToString(budget_percent) + "/");
+
+    SetCodecSettings(&config_, codec_type, 1, false, false, true, false,
+                     kResilienceOn, kCifWidth, kCifHeight);
+
+    RateProfile rate_profile;
+    SetRateProfile(&rate_profile, 0, 500, 30, 0);
+    rate_profile.frame_index_rate_update[1] = kNumFramesLong + 1;
+    rate_profile.num_frames = kNumFramesLong;
+
+    ProcessFramesAndMaybeVerify(rate_profile, nullptr, nullptr,
+                                kNoVisualizationParams);
+
+    const std::string modifier =
+        "_" + codec_name + "_" + rtc::ToString(budget_percent) + "_percent";
+    PrintResult("encode_time", modifier, "average",
+                stats().AverageEncodeTimeUs(), "us", false);
+    PrintResult("psnr", modifier, "average",
+                rtc::ToString(psnr_result_.average), "dB", false);
+    PrintResult("ssim", modifier, "average",
+                rtc::ToString(ssim_result_.average), "", false);
+  }
+};
+
+INSTANTIATE_TEST_CASE_P(EncodeTimeBudgets,
+                        VideoProcessorIntegrationTestLibvpxSpeedControl,
+                        ::testing::ValuesIn(kEncodeTimeBudgetsPercent));
+
 // Fails on iOS. See webrtc:4755.
 #if !defined(WEBRTC_IOS)
 
@@ -259,6 +338,35 @@ TEST_F(VideoProcessorIntegrationTestLibvpx, Process10PercentPacketLoss) {
                               kNoVisualizationParams);
 }
 
+// VP8: Decode time of a 720p sequence with one, two and four decoder threads.
+// Disabled since they only report timings; run them with
+// --gtest_also_run_disabled_tests.
+TEST_F(VideoProcessorIntegrationTestLibvpx, DISABLED_DecodeTimeHdOneCore) {
+  ProcessHdWithDecoderCores(1);
+}
+
+TEST_F(VideoProcessorIntegrationTestLibvpx, DISABLED_DecodeTimeHdTwoCores) {
+  ProcessHdWithDecoderCores(2);
+}
+
+TEST_F(VideoProcessorIntegrationTestLibvpx, DISABLED_DecodeTimeHdFourCores) {
+  ProcessHdWithDecoderCores(4);
+}
+
+// The encode-time sweeps only report quality and encode time; the control
+// itself is tested in cpu_speed_controller_unittest.cc. Disabled since the
+// results depend on the machine; run them with
+// --gtest_also_run_disabled_tests.
+TEST_P(VideoProcessorIntegrationTestLibvpxSpeedControl, DISABLED_ProcessVP8) {
+  ProcessWithEncodeTimeBudget(kVideoCodecVP8, "vp8");
+}
+
+#if !defined(RTC_DISABLE_VP9)
+TEST_P(VideoProcessorIntegrationTestLibvpxSpeedControl, DISABLED_ProcessVP9) {
+  ProcessWithEncodeTimeBudget(kVideoCodecVP9, "vp9");
+}
+#endif  // !defined(RTC_DISABLE_VP9)
+
 #endif  // !defined(WEBRTC_IOS)
 
 // The tests below are currently disabled for Android. For ARM, the encoder
@@ -0,0 +1,66 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/video_coding/codecs/vp8/active_map.h"
+
+#include <algorithm>
+
+namespace webrtc {
+
+namespace {
+const int kMacroblockSize = 16;
+}  // namespace
+
+const int ActiveMap::kRefreshFrames = 30;
+
+ActiveMap::ActiveMap(int width, int height)
+    : width_(width),
+      height_(height),
+      rows_((height + kMacroblockSize - 1) / kMacroblockSize),
+      cols_((width + kMacroblockSize - 1) / kMacroblockSize),
+      refresh_row_(0) {}
+
+ActiveMap::~ActiveMap() = default;
+
+const uint8_t* ActiveMap::Update(
+    const rtc::Optional<std::vector<VideoFrame::UpdateRect>>& update_rects,
+    bool key_frame) {
+  if (!update_rects || key_frame) {
+    // All of the frame is coded, so the refresh starts over.
+    refresh_row_ = 0;
+    return nullptr;
+  }
+
+  map_.assign(rows_ * cols_, 0);
+  for (const VideoFrame::UpdateRect& rect : *update_rects) {
+    const int left = std::max(rect.offset_x, 0);
+    const int top = std::max(rect.offset_y, 0);
+    const int right = std::min(rect.offset_x + rect.width, width_);
+    const int bottom = std::min(rect.offset_y + rect.height, height_);
+    if (right <= left || bottom <= top)
+      continue;
+    const int first_col = left / kMacroblockSize;
+    const int last_col = (right - 1) / kMacroblockSize;
+    for (int row = top / kMacroblockSize;
+         row <= (bottom - 1) / kMacroblockSize; ++row) {
+      std::fill_n(map_.begin() + row * cols_ + first_col,
+                  last_col - first_col + 1, 1);
+    }
+  }
+
+  const int refresh_rows = (rows_ + kRefreshFrames - 1) / kRefreshFrames;
+  const int refresh_end = std::min(refresh_row_ + refresh_rows, rows_);
+  std::fill(map_.begin() + refresh_row_ * cols_,
+            map_.begin() + refresh_end * cols_, 1);
+  refresh_row_ = refresh_end < rows_ ? refresh_end : 0;
+  return map_.data();
+}
+
+}  // namespace webrtc
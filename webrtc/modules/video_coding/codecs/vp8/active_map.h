@@ -0,0 +1,60 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_VIDEO_CODING_CODECS_VP8_ACTIVE_MAP_H_
+#define WEBRTC_MODULES_VIDEO_CODING_CODECS_VP8_ACTIVE_MAP_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "webrtc/api/optional.h"
+#include "webrtc/api/video/video_frame.h"
+
+namespace webrtc {
+
+// Builds the libvpx active map of a frame from its update rects: one byte per
+// 16x16 macroblock, row by row, non-zero if the macroblock is coded and zero if
+// it is skipped, i.e. copied from the last frame.
+//
+// Macroblocks that never change would otherwise keep the quality they were
+// first coded with, which is typically low after a key frame. A band of rows
+// is therefore marked active in every map, moving down the frame so that each
+// macroblock is coded at least once every |kRefreshFrames| maps.
+class ActiveMap {
+ public:
+  static const int kRefreshFrames;
+
+  ActiveMap(int width, int height);
+  ~ActiveMap();
+
+  // Returns the map for a frame, or null if all macroblocks must be coded:
+  // for key frames and for frames whose update rects are unknown. The map is
+  // valid until the next call.
+  const uint8_t* Update(
+      const rtc::Optional<std::vector<VideoFrame::UpdateRect>>& update_rects,
+      bool key_frame);
+
+  int rows() const { return rows_; }
+  int cols() const { return cols_; }
+
+ private:
+  const int width_;
+  const int height_;
+  const int rows_;
+  const int cols_;
+  // The first row of the band that is refreshed by the next map.
+  int refresh_row_;
+  std::vector<uint8_t> map_;
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_VIDEO_CODING_CODECS_VP8_ACTIVE_MAP_H_
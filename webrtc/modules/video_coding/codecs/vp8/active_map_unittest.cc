@@ -0,0 +1,109 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <vector>
+
+#include "webrtc/modules/video_coding/codecs/vp8/active_map.h"
+#include "webrtc/test/gtest.h"
+
+namespace webrtc {
+
+namespace {
+rtc::Optional<std::vector<VideoFrame::UpdateRect>> Rects(
+    const std::vector<VideoFrame::UpdateRect>& rects) {
+  return rtc::Optional<std::vector<VideoFrame::UpdateRect>>(rects);
+}
+
+std::vector<uint8_t> ToVector(const ActiveMap& active_map,
+                              const uint8_t* map) {
+  return std::vector<uint8_t>(map, map + active_map.rows() * active_map.cols());
+}
+}  // namespace
+
+TEST(ActiveMapTest, AllMacroblocksAreActiveForKeyFrames) {
+  ActiveMap active_map(64, 48);
+  EXPECT_EQ(nullptr, active_map.Update(Rects({}), true));
+}
+
+TEST(ActiveMapTest, AllMacroblocksAreActiveForUnknownRects) {
+  ActiveMap active_map(64, 48);
+  EXPECT_EQ(nullptr, active_map.Update(
+                         rtc::Optional<std::vector<VideoFrame::UpdateRect>>(),
+                         false));
+}
+
+TEST(ActiveMapTest, MarksMacroblocksOfUpdateRects) {
+  ActiveMap active_map(64, 48);
+  ASSERT_EQ(3, active_map.rows());
+  ASSERT_EQ(4, active_map.cols());
+
+  // The first row is active since it is refreshed by the first map.
+  const uint8_t* map = active_map.Update(
+      Rects({{20, 18, 10, 4}, {62, 20, 20, 2}, {-8, 40, 10, 100}}), false);
+  ASSERT_NE(nullptr, map);
+  const std::vector<uint8_t> expected = {1, 1, 1, 1,
+                                         0, 1, 0, 1,
+                                         1, 0, 0, 0};
+  EXPECT_EQ(expected, ToVector(active_map, map));
+}
+
+TEST(ActiveMapTest, MarksAllMacroblocksOverlappedByRect) {
+  ActiveMap active_map(64, 48);
+  active_map.Update(Rects({}), false);
+
+  // Crosses the macroblock boundaries at x = 32 and y = 32.
+  const uint8_t* map = active_map.Update(Rects({{30, 30, 4, 4}}), false);
+  ASSERT_NE(nullptr, map);
+  const std::vector<uint8_t> expected = {0, 0, 0, 0,
+                                         1, 1, 1, 1,
+                                         0, 1, 1, 0};
+  EXPECT_EQ(expected, ToVector(active_map, map));
+}
+
+TEST(ActiveMapTest, RefreshesAllMacroblocksWithinRefreshFrames) {
+  ActiveMap active_map(1280, 720);
+  const size_t num_macroblocks = active_map.rows() * active_map.cols();
+  const size_t max_refreshed_rows =
+      (active_map.rows() + ActiveMap::kRefreshFrames - 1) /
+      ActiveMap::kRefreshFrames;
+
+  std::vector<uint8_t> refreshed(num_macroblocks, 0);
+  for (int i = 0; i < ActiveMap::kRefreshFrames; ++i) {
+    const uint8_t* map = active_map.Update(Rects({}), false);
+    ASSERT_NE(nullptr, map);
+    size_t num_active = 0;
+    for (size_t j = 0; j < num_macroblocks; ++j) {
+      if (map[j]) {
+        refreshed[j] = 1;
+        ++num_active;
+      }
+    }
+    EXPECT_GT(num_active, 0u);
+    EXPECT_LE(num_active, max_refreshed_rows * active_map.cols());
+  }
+  EXPECT_EQ(std::vector<uint8_t>(num_macroblocks, 1), refreshed);
+}
+
+TEST(ActiveMapTest, KeyFrameRestartsRefresh) {
+  ActiveMap active_map(64, 48);
+  const std::vector<uint8_t> first_row_active = {1, 1, 1, 1,
+                                                 0, 0, 0, 0,
+                                                 0, 0, 0, 0};
+  EXPECT_EQ(first_row_active,
+            ToVector(active_map, active_map.Update(Rects({}), false)));
+  EXPECT_NE(first_row_active,
+            ToVector(active_map, active_map.Update(Rects({}), false)));
+
+  EXPECT_EQ(nullptr, active_map.Update(Rects({}), true));
+  EXPECT_EQ(first_row_active,
+            ToVector(active_map, active_map.Update(Rects({}), false)));
+}
+
+}  // namespace webrtc
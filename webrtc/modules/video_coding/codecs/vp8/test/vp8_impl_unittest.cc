@@ -11,9 +11,12 @@
 #include <stdio.h>
 
 #include <memory>
+#include <set>
+#include <vector>
 
 #include "webrtc/api/optional.h"
 #include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/common_video/include/i420_buffer_pool.h"
 #include "webrtc/common_video/libyuv/include/webrtc_libyuv.h"
 #include "webrtc/modules/video_coding/codecs/test/video_codec_test.h"
 #include "webrtc/modules/video_coding/codecs/vp8/include/vp8.h"
@@ -24,6 +27,7 @@
 #include "webrtc/test/frame_utils.h"
 #include "webrtc/test/gtest.h"
 #include "webrtc/test/testsupport/fileutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
 #include "webrtc/test/video_codec_settings.h"
 
 namespace webrtc {
@@ -331,6 +335,55 @@ TEST_F(TestVp8Impl, MAYBE_DecodeWithACompleteKeyFrame) {
   EXPECT_GT(I420PSNR(input_frame_.get(), &*decoded_cb_.frame_), 36);
 }
 
+TEST_F(TestVp8Impl, DecodedFramesReuseBuffers) {
+  InitEncodeDecode();
+  EncodeFrame();
+  encoded_cb_.encoded_frame_._frameType = kVideoFrameKey;
+
+  const int kNumFrames = 30;
+  std::set<const uint8_t*> buffers;
+  size_t copied_bytes = 0;
+  for (int i = 0; i < kNumFrames; ++i) {
+    ASSERT_EQ(WEBRTC_VIDEO_CODEC_OK,
+              decoder_->Decode(encoded_cb_.encoded_frame_, false, nullptr));
+    ASSERT_TRUE(decoded_cb_.DecodeComplete());
+    rtc::scoped_refptr<I420BufferInterface> buffer =
+        decoded_cb_.frame_->video_frame_buffer()->ToI420();
+    buffers.insert(buffer->DataY());
+    copied_bytes +=
+        CalcBufferSize(VideoType::kI420, buffer->width(), buffer->height());
+  }
+  // |decoded_cb_| holds on to the previous frame while the next one is
+  // decoded, so two buffers are recycled.
+  EXPECT_EQ(2u, buffers.size());
+  test::PrintResult("vp8_decode", "", "copied_bytes_per_frame",
+                    copied_bytes / kNumFrames, "bytes", false);
+  test::PrintResult("vp8_decode", "", "allocated_buffers", buffers.size(),
+                    "buffers", false);
+}
+
+TEST_F(TestVp8Impl, DecoderLimitsPendingFrames) {
+  InitEncodeDecode();
+  EncodeFrame();
+  encoded_cb_.encoded_frame_._frameType = kVideoFrameKey;
+
+  std::vector<VideoFrame> pending_frames;
+  for (size_t i = 0; i < kMaxPendingDecodedFrames; ++i) {
+    ASSERT_EQ(WEBRTC_VIDEO_CODEC_OK,
+              decoder_->Decode(encoded_cb_.encoded_frame_, false, nullptr));
+    ASSERT_TRUE(decoded_cb_.DecodeComplete());
+    pending_frames.push_back(*decoded_cb_.frame_);
+  }
+  EXPECT_EQ(WEBRTC_VIDEO_CODEC_NO_OUTPUT,
+            decoder_->Decode(encoded_cb_.encoded_frame_, false, nullptr));
+
+  // Releasing a frame makes its buffer available again.
+  pending_frames.pop_back();
+  decoded_cb_.frame_ = rtc::Optional<VideoFrame>();
+  EXPECT_EQ(WEBRTC_VIDEO_CODEC_OK,
+            decoder_->Decode(encoded_cb_.encoded_frame_, false, nullptr));
+}
+
 TEST_F(TestVp8Impl, EncoderWith2TemporalLayersRetainsRtpStateAfterRelease) {
   codec_settings_.VP8()->numberOfTemporalLayers = 2;
   InitEncodeDecode();
@@ -44,8 +44,12 @@ const char kVp8PostProcArmFieldTrial[] = "WebRTC-VP8-Postproc-Config-Arm";
 const char kVp8GfBoostFieldTrial[] = "WebRTC-VP8-GfBoost";
 const char kVp8ForceFallbackEncoderFieldTrial[] =
     "WebRTC-VP8-Forced-Fallback-Encoder";
+const char kVp8TokenPartitionsFieldTrial[] = "WebRTC-VP8-TokenPartitions";
 
-const int kTokenPartitions = VP8_ONE_TOKENPARTITION;
+const vp8e_token_partitions kDefaultTokenPartitions = VP8_ONE_TOKENPARTITION;
+// Real-time speeds are negative; -16 is the fastest.
+const int kMinCpuSpeed = -16;
+const int kMaxCpuSpeedOffset = 6;
 enum { kVp8ErrorPropagationTh = 30 };
 enum { kVp832ByteAlign = 32 };
 
@@ -151,6 +155,53 @@ bool GetGfBoostPercentageFromFieldTrialGroup(int* boost_percentage) {
   return true;
 }
 
+// Returns the number of token partitions to encode with, expressed as the
+// number of bits used (0 for one partition, up to 3 for eight partitions).
+// Multiple partitions let a multi-threaded decoder parse the residual tokens of
+// different macroblock rows in parallel.
+vp8e_token_partitions GetTokenPartitionsFromFieldTrialGroup() {
+  std::string group =
+      webrtc::field_trial::FindFullName(kVp8TokenPartitionsFieldTrial);
+  int partitions;
+  if (group.empty() ||
+      sscanf(group.c_str(), "Enabled-%d", &partitions) != 1) {
+    return kDefaultTokenPartitions;
+  }
+  switch (partitions) {
+    case 1:
+      return VP8_ONE_TOKENPARTITION;
+    case 2:
+      return VP8_TWO_TOKENPARTITION;
+    case 4:
+      return VP8_FOUR_TOKENPARTITION;
+    case 8:
+      return VP8_EIGHT_TOKENPARTITION;
+    default:
+      return kDefaultTokenPartitions;
+  }
+}
+
+// Reads the frame size from the uncompressed header of a VP8 key frame (RFC
+// 6386, section 9.1). Returns false if |buffer| does not hold a key frame.
+bool ParseKeyFrameSize(const uint8_t* buffer,
+                       size_t length,
+                       int* width,
+                       int* height) {
+  const size_t kKeyFrameHeaderSize = 10;
+  if (buffer == nullptr || length < kKeyFrameHeaderSize)
+    return false;
+  // The first bit of the frame tag is 0 for key frames, followed by the start
+  // code 0x9d 0x01 0x2a.
+  if ((buffer[0] & 0x01) != 0 || buffer[3] != 0x9d || buffer[4] != 0x01 ||
+      buffer[5] != 0x2a) {
+    return false;
+  }
+  // The upper two bits of each dimension hold the scaling mode.
+  *width = (buffer[6] | (buffer[7] << 8)) & 0x3fff;
+  *height = (buffer[8] | (buffer[9] << 8)) & 0x3fff;
+  return *width > 0 && *height > 0;
+}
+
 void GetPostProcParamsFromFieldTrialGroup(
     VP8DecoderImpl::DeblockParams* deblock_params) {
   std::string group =
@@ -209,6 +260,9 @@ vpx_enc_frame_flags_t VP8EncoderImpl::EncodeFlags(
 VP8EncoderImpl::VP8EncoderImpl()
     : use_gf_boost_(webrtc::field_trial::IsEnabled(kVp8GfBoostFieldTrial)),
       min_pixels_per_frame_(GetForcedFallbackMinPixelsFromFieldTrialGroup()),
+      token_partitions_(GetTokenPartitionsFromFieldTrialGroup()),
+      cpu_speed_controller_(
+          CpuSpeedController::CreateFromFieldTrial(kMaxCpuSpeedOffset)),
       encoded_complete_callback_(nullptr),
       inited_(false),
       timestamp_(0),
@@ -216,7 +270,8 @@ VP8EncoderImpl::VP8EncoderImpl()
       cpu_speed_default_(-6),
       number_of_cores_(0),
       rc_max_intra_target_(0),
-      key_frame_request_(kMaxSimulcastStreams, false) {
+      key_frame_request_(kMaxSimulcastStreams, false),
+      active_map_enabled_(false) {
   Random random(rtc::TimeMicros());
   picture_id_.reserve(kMaxSimulcastStreams);
   for (int i = 0; i < kMaxSimulcastStreams; ++i) {
@@ -263,6 +318,9 @@ int VP8EncoderImpl::Release() {
     tl0_pic_idx_[i] = temporal_layers_[i]->Tl0PicIdx();
   }
   temporal_layers_.clear();
+  update_rects_ = UpdateRectAccumulator();
+  active_map_.reset();
+  active_map_enabled_ = false;
   inited_ = false;
   return ret_val;
 }
@@ -412,6 +470,8 @@ int VP8EncoderImpl::InitEncode(const VideoCodec* inst,
     codec_.simulcastStream[0].height = codec_.height;
   }
 
+  active_map_.reset(new ActiveMap(codec_.width, codec_.height));
+
   encoded_images_.resize(number_of_streams);
   encoders_.resize(number_of_streams);
   configurations_.resize(number_of_streams);
@@ -517,6 +577,8 @@ int VP8EncoderImpl::InitEncode(const VideoCodec* inst,
         SetCpuSpeed(inst->simulcastStream[number_of_streams - 1 - i].width,
                     inst->simulcastStream[number_of_streams - 1 - i].height);
   }
+  if (cpu_speed_controller_)
+    cpu_speed_controller_->Reset();
   configurations_[0].g_w = inst->width;
   configurations_[0].g_h = inst->height;
 
@@ -599,6 +661,15 @@ int VP8EncoderImpl::SetCpuSpeed(int width, int height) {
 #endif
 }
 
+void VP8EncoderImpl::UpdateCpuSpeed() {
+  for (size_t i = 0; i < encoders_.size(); ++i) {
+    vpx_codec_control(
+        &(encoders_[i]), VP8E_SET_CPUUSED,
+        std::max(cpu_speed_[i] - cpu_speed_controller_->speed_offset(),
+                 kMinCpuSpeed));
+  }
+}
+
 int VP8EncoderImpl::NumberOfThreads(int width, int height, int cpus) {
 #if defined(ANDROID)
   if (width * height >= 320 * 180) {
@@ -672,7 +743,7 @@ int VP8EncoderImpl::InitAndSetControlSettings() {
                       codec_.mode == kScreensharing ? 300 : 1);
     vpx_codec_control(&(encoders_[i]), VP8E_SET_CPUUSED, cpu_speed_[i]);
     vpx_codec_control(&(encoders_[i]), VP8E_SET_TOKEN_PARTITIONS,
-                      static_cast<vp8e_token_partitions>(kTokenPartitions));
+                      token_partitions_);
     vpx_codec_control(&(encoders_[i]), VP8E_SET_MAX_INTRA_BITRATE_PCT,
                       rc_max_intra_target_);
     // VP8E_SET_SCREEN_CONTENT_MODE 2 = screen content with more aggressive
@@ -761,6 +832,7 @@ int VP8EncoderImpl::Encode(const VideoFrame& frame,
 
     if (tl_configs[i].drop_frame) {
       // Drop this frame.
+      update_rects_.AddDroppedFrame(frame);
       return WEBRTC_VIDEO_CODEC_OK;
     }
     flags[i] = EncodeFlags(tl_configs[i]);
@@ -798,6 +870,9 @@ int VP8EncoderImpl::Encode(const VideoFrame& frame,
     }
     std::fill(key_frame_request_.begin(), key_frame_request_.end(), false);
   }
+  const rtc::Optional<std::vector<VideoFrame::UpdateRect>> update_rects =
+      update_rects_.TakeForFrame(frame);
+  SetActiveMap(update_rects, send_key_frame);
 
   // Set the encoder frame flags and temporal layer_id for each spatial stream.
   // Note that |temporal_layers_| are defined starting from lowest resolution at
@@ -811,8 +886,10 @@ int VP8EncoderImpl::Encode(const VideoFrame& frame,
     vpx_codec_enc_cfg_t temp_config;
     memcpy(&temp_config, &configurations_[i], sizeof(vpx_codec_enc_cfg_t));
     if (temporal_layers_[stream_idx]->UpdateConfiguration(&temp_config)) {
-      if (vpx_codec_enc_config_set(&encoders_[i], &temp_config))
+      if (vpx_codec_enc_config_set(&encoders_[i], &temp_config)) {
+        update_rects_.Add(update_rects);
         return WEBRTC_VIDEO_CODEC_ERROR;
+      }
     }
 
     vpx_codec_control(&encoders_[i], VP8E_SET_FRAME_FLAGS, flags[stream_idx]);
@@ -832,28 +909,63 @@ int VP8EncoderImpl::Encode(const VideoFrame& frame,
   // If the first try returns WEBRTC_VIDEO_CODEC_TARGET_BITRATE_OVERSHOOT
   // the frame must be reencoded with the same parameters again because
   // target bitrate is exceeded and encoder state has been reset.
+  int64_t encode_time_us = 0;
   while (num_tries == 0 ||
       (num_tries == 1 &&
           error == WEBRTC_VIDEO_CODEC_TARGET_BITRATE_OVERSHOOT)) {
     ++num_tries;
     // Note we must pass 0 for |flags| field in encode call below since they are
     // set above in |vpx_codec_control| function for each encoder/spatial layer.
+    const int64_t encode_start_us = rtc::TimeMicros();
     error = vpx_codec_encode(&encoders_[0], &raw_images_[0], timestamp_,
                                  duration, 0, VPX_DL_REALTIME);
+    encode_time_us += rtc::TimeMicros() - encode_start_us;
     // Reset specific intra frame thresholds, following the key frame.
     if (send_key_frame) {
       vpx_codec_control(&(encoders_[0]), VP8E_SET_MAX_INTRA_BITRATE_PCT,
                         rc_max_intra_target_);
     }
-    if (error)
+    if (error) {
+      update_rects_.Add(update_rects);
       return WEBRTC_VIDEO_CODEC_ERROR;
+    }
     timestamp_ += duration;
     // Examines frame timestamps only.
     error = GetEncodedPartitions(tl_configs, frame);
   }
+  // A frame dropped by the rate control leaves the last frame as it was.
+  if (encoded_images_[0]._length == 0)
+    update_rects_.Add(update_rects);
+  // All streams are encoded by the one call above, so the same offset is
+  // applied to the speed of each of them.
+  if (cpu_speed_controller_ &&
+      cpu_speed_controller_->OnFrameEncoded(encode_time_us,
+                                            codec_.maxFramerate)) {
+    UpdateCpuSpeed();
+  }
   return error;
 }
 
+void VP8EncoderImpl::SetActiveMap(
+    const rtc::Optional<std::vector<VideoFrame::UpdateRect>>& update_rects,
+    bool key_frame) {
+  const uint8_t* active_map = nullptr;
+  if (encoders_.size() == 1 && codec_.VP8()->numberOfTemporalLayers <= 1)
+    active_map = active_map_->Update(update_rects, key_frame);
+  if (!active_map && !active_map_enabled_)
+    return;
+
+  vpx_active_map_t map;
+  map.rows = active_map_->rows();
+  map.cols = active_map_->cols();
+  // libvpx copies the map. A null map makes all macroblocks active again.
+  map.active_map = const_cast<uint8_t*>(active_map);
+  if (vpx_codec_control(&encoders_[0], VP8E_SET_ACTIVEMAP, &map) ==
+      VPX_CODEC_OK) {
+    active_map_enabled_ = active_map != nullptr;
+  }
+}
+
 void VP8EncoderImpl::PopulateCodecSpecific(
     CodecSpecificInfo* codec_specific,
     const TemporalLayers::FrameConfig& tl_config,
@@ -890,8 +1002,9 @@ int VP8EncoderImpl::GetEncodedPartitions(
     encoded_images_[encoder_idx]._length = 0;
     encoded_images_[encoder_idx]._frameType = kVideoFrameDelta;
     RTPFragmentationHeader frag_info;
-    // kTokenPartitions is number of bits used.
-    frag_info.VerifyAndAllocateFragmentationHeader((1 << kTokenPartitions) + 1);
+    // |token_partitions_| is number of bits used.
+    frag_info.VerifyAndAllocateFragmentationHeader((1 << token_partitions_) +
+                                                   1);
     CodecSpecificInfo codec_specific;
     const vpx_codec_cx_pkt_t* pkt = NULL;
     while ((pkt = vpx_codec_get_cx_data(&encoders_[encoder_idx], &iter)) !=
@@ -1018,10 +1131,14 @@ class VP8DecoderImpl::QpSmoother {
 VP8DecoderImpl::VP8DecoderImpl()
     : use_postproc_arm_(
           webrtc::field_trial::IsEnabled(kVp8PostProcArmFieldTrial)),
-      buffer_pool_(false, 300 /* max_number_of_buffers*/),
+      // libvpx keeps its reference frames internally, so all buffers in the
+      // pool are decoded frames held by the application.
+      buffer_pool_(false, kMaxPendingDecodedFrames),
       decode_complete_callback_(NULL),
       inited_(false),
       decoder_(NULL),
+      number_of_cores_(1),
+      number_of_threads_(1),
       propagation_cnt_(-1),
       last_frame_width_(0),
       last_frame_height_(0),
@@ -1036,18 +1153,55 @@ VP8DecoderImpl::~VP8DecoderImpl() {
   Release();
 }
 
+int VP8DecoderImpl::NumberOfThreads(int width,
+                                    int height,
+                                    int number_of_cores) const {
+  // At most eight token partitions can be decoded in parallel.
+  int threads;
+  if (width * height >= 1920 * 1080) {
+    threads = 8;
+  } else if (width * height >= 1280 * 720) {
+    threads = 4;
+  } else if (width * height > 640 * 480) {
+    threads = 2;
+  } else {
+    // A single thread keeps up with VGA or less.
+    threads = 1;
+  }
+  return std::max(1, std::min(threads, number_of_cores));
+}
+
 int VP8DecoderImpl::InitDecode(const VideoCodec* inst, int number_of_cores) {
   int ret_val = Release();
   if (ret_val < 0) {
     return ret_val;
   }
+  number_of_cores_ = number_of_cores;
+  // The resolution may be unknown until the first key frame arrives, in which
+  // case the thread count is revised then.
+  int threads = inst ? NumberOfThreads(inst->width, inst->height,
+                                       number_of_cores_)
+                     : 1;
+  ret_val = InitDecoder(threads);
+  if (ret_val < 0) {
+    return ret_val;
+  }
+
+  propagation_cnt_ = -1;
+  inited_ = true;
+
+  // Always start with a complete key frame.
+  key_frame_required_ = true;
+  return WEBRTC_VIDEO_CODEC_OK;
+}
+
+int VP8DecoderImpl::InitDecoder(int number_of_threads) {
   if (decoder_ == NULL) {
     decoder_ = new vpx_codec_ctx_t;
     memset(decoder_, 0, sizeof(*decoder_));
   }
   vpx_codec_dec_cfg_t cfg;
-  // Setting number of threads to a constant value (1)
-  cfg.threads = 1;
+  cfg.threads = number_of_threads;
   cfg.h = cfg.w = 0;  // set after decode
 
 #if defined(WEBRTC_ARCH_ARM) || defined(WEBRTC_ARCH_ARM64) || defined(ANDROID)
@@ -1061,12 +1215,7 @@ int VP8DecoderImpl::InitDecode(const VideoCodec* inst, int number_of_cores) {
     decoder_ = nullptr;
     return WEBRTC_VIDEO_CODEC_MEMORY;
   }
-
-  propagation_cnt_ = -1;
-  inited_ = true;
-
-  // Always start with a complete key frame.
-  key_frame_required_ = true;
+  number_of_threads_ = number_of_threads;
   return WEBRTC_VIDEO_CODEC_OK;
 }
 
@@ -1088,6 +1237,27 @@ int VP8DecoderImpl::Decode(const EncodedImage& input_image,
     return WEBRTC_VIDEO_CODEC_ERR_PARAMETER;
   }
 
+  // No later frame references anything before a key frame, so this is where
+  // the decoder can be recreated with a thread count suited to a new
+  // resolution.
+  int width;
+  int height;
+  if (input_image._frameType == kVideoFrameKey && input_image._completeFrame &&
+      ParseKeyFrameSize(input_image._buffer, input_image._length, &width,
+                        &height)) {
+    int threads = NumberOfThreads(width, height, number_of_cores_);
+    if (threads != number_of_threads_) {
+      if (vpx_codec_destroy(decoder_)) {
+        return WEBRTC_VIDEO_CODEC_MEMORY;
+      }
+      int ret_val = InitDecoder(threads);
+      if (ret_val < 0) {
+        inited_ = false;
+        return ret_val;
+      }
+    }
+  }
+
 // Post process configurations.
 #if defined(WEBRTC_ARCH_ARM) || defined(WEBRTC_ARCH_ARM64) || defined(ANDROID)
   if (use_postproc_arm_) {
@@ -1218,7 +1388,9 @@ int VP8DecoderImpl::ReturnFrame(const vpx_image_t* img,
   }
   last_frame_width_ = img->d_w;
   last_frame_height_ = img->d_h;
-  // Allocate memory for decoded image.
+  // The VP8 decoder in libvpx does not support external frame buffers and
+  // overwrites |img| on the next decode, so the frame is copied into a buffer
+  // that is recycled once the application releases it.
   rtc::scoped_refptr<I420Buffer> buffer =
       buffer_pool_.CreateBuffer(img->d_w, img->d_h);
   if (!buffer.get()) {
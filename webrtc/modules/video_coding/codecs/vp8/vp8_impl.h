@@ -25,10 +25,13 @@
 
 #include "webrtc/api/video/video_frame.h"
 #include "webrtc/common_video/include/i420_buffer_pool.h"
+#include "webrtc/common_video/include/update_rect_accumulator.h"
 #include "webrtc/common_video/include/video_frame.h"
+#include "webrtc/modules/video_coding/codecs/vp8/active_map.h"
 #include "webrtc/modules/video_coding/codecs/vp8/include/vp8.h"
 #include "webrtc/modules/video_coding/codecs/vp8/temporal_layers.h"
 #include "webrtc/modules/video_coding/include/video_codec_interface.h"
+#include "webrtc/modules/video_coding/utility/cpu_speed_controller.h"
 #include "webrtc/modules/video_coding/utility/quality_scaler.h"
 
 namespace webrtc {
@@ -73,6 +76,9 @@ class VP8EncoderImpl : public VP8Encoder {
   // Set the cpu_speed setting for encoder based on resolution and/or platform.
   int SetCpuSpeed(int width, int height);
 
+  // Applies the speed offset of |cpu_speed_controller_| to each stream.
+  void UpdateCpuSpeed();
+
   // Determine number of encoder threads to use.
   int NumberOfThreads(int width, int height, int number_of_cores);
 
@@ -93,8 +99,19 @@ class VP8EncoderImpl : public VP8Encoder {
 
   uint32_t MaxIntraTarget(uint32_t optimal_buffer_size);
 
+  // Marks the macroblocks outside |update_rects| as inactive, which makes
+  // libvpx code them as skipped blocks copied from the last frame, see
+  // ActiveMap. Only used for a single stream without temporal layers, where
+  // the last frame is the previous encoded frame.
+  void SetActiveMap(
+      const rtc::Optional<std::vector<VideoFrame::UpdateRect>>& update_rects,
+      bool key_frame);
+
   const bool use_gf_boost_;
   const rtc::Optional<int> min_pixels_per_frame_;
+  const vp8e_token_partitions token_partitions_;
+  // Raises the speed of all streams while encoding takes too long, if enabled.
+  const std::unique_ptr<CpuSpeedController> cpu_speed_controller_;
 
   EncodedImageCallback* encoded_complete_callback_;
   VideoCodec codec_;
@@ -115,6 +132,11 @@ class VP8EncoderImpl : public VP8Encoder {
   std::vector<vpx_codec_ctx_t> encoders_;
   std::vector<vpx_codec_enc_cfg_t> configurations_;
   std::vector<vpx_rational_t> downsampling_factors_;
+  // Update rects of the input frames that were not encoded.
+  UpdateRectAccumulator update_rects_;
+  // The active map of the first stream.
+  std::unique_ptr<ActiveMap> active_map_;
+  bool active_map_enabled_;
 };
 
 class VP8DecoderImpl : public VP8Decoder {
@@ -144,6 +166,15 @@ class VP8DecoderImpl : public VP8Decoder {
 
  private:
   class QpSmoother;
+
+  // Determine number of decoder threads to use. Threads decode macroblock rows
+  // in parallel, which libvpx only does for frames encoded with more than one
+  // token partition.
+  int NumberOfThreads(int width, int height, int number_of_cores) const;
+
+  // Creates the decoder instance, decoding with |number_of_threads| threads.
+  int InitDecoder(int number_of_threads);
+
   int ReturnFrame(const vpx_image_t* img,
                   uint32_t timeStamp,
                   int64_t ntp_time_ms,
@@ -155,6 +186,8 @@ class VP8DecoderImpl : public VP8Decoder {
   DecodedImageCallback* decode_complete_callback_;
   bool inited_;
   vpx_codec_ctx_t* decoder_;
+  int number_of_cores_;
+  int number_of_threads_;
   int propagation_cnt_;
   int last_frame_width_;
   int last_frame_height_;
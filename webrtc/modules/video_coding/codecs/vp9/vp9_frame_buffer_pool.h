@@ -14,6 +14,7 @@
 
 #include <vector>
 
+#include "webrtc/common_video/include/i420_buffer_pool.h"
 #include "webrtc/rtc_base/basictypes.h"
 #include "webrtc/rtc_base/buffer.h"
 #include "webrtc/rtc_base/criticalsection.h"
@@ -112,11 +113,9 @@ class Vp9FrameBufferPool {
   // referenced by any frame, see
   // https://tools.ietf.org/html/draft-grange-vp9-bitstream-00#section-2.2.2.
   // Assuming VP9 holds on to at most 8 buffers, any more buffers than that
-  // would have to be by application code. Decoded frames should not be
-  // referenced for longer than necessary. If we allow ~60 additional buffers
-  // then the application has ~1 second to e.g. render each frame of a 60 fps
-  // video.
-  static const size_t max_num_buffers_ = 68;
+  // would have to be by application code, which may hold on to
+  // |kMaxPendingDecodedFrames| frames.
+  static const size_t max_num_buffers_ = 8 + kMaxPendingDecodedFrames;
 };
 
 }  // namespace webrtc
@@ -14,6 +14,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <algorithm>
 #include <vector>
 
 #include "vpx/vpx_encoder.h"
@@ -35,6 +36,9 @@ namespace webrtc {
 
 // Only positive speeds, range for real-time coding currently is: 5 - 8.
 // Lower means slower/better quality, higher means fastest/lower quality.
+const int kMaxCpuSpeed = 8;
+const int kMaxCpuSpeedOffset = 3;
+
 int GetCpuSpeed(int width, int height) {
 #if defined(WEBRTC_ARCH_ARM) || defined(WEBRTC_ARCH_ARM64) || defined(ANDROID)
   return 8;
@@ -68,6 +72,8 @@ VP9EncoderImpl::VP9EncoderImpl()
       inited_(false),
       timestamp_(0),
       cpu_speed_(3),
+      cpu_speed_controller_(
+          CpuSpeedController::CreateFromFieldTrial(kMaxCpuSpeedOffset)),
       rc_max_intra_target_(0),
       encoder_(nullptr),
       config_(nullptr),
@@ -330,6 +336,8 @@ int VP9EncoderImpl::InitEncode(const VideoCodec* inst,
       NumberOfThreads(config_->g_w, config_->g_h, number_of_cores);
 
   cpu_speed_ = GetCpuSpeed(config_->g_w, config_->g_h);
+  if (cpu_speed_controller_)
+    cpu_speed_controller_->Reset();
 
   // TODO(asapersson): Check configuration of temporal switch up and increase
   // pattern length.
@@ -549,12 +557,22 @@ int VP9EncoderImpl::Encode(const VideoFrame& input_image,
 
   RTC_CHECK_GT(codec_.maxFramerate, 0);
   uint32_t duration = 90000 / codec_.maxFramerate;
+  const int64_t encode_start_us = rtc::TimeMicros();
   if (vpx_codec_encode(encoder_, raw_, timestamp_, duration, flags,
                        VPX_DL_REALTIME)) {
     return WEBRTC_VIDEO_CODEC_ERROR;
   }
   timestamp_ += duration;
 
+  if (cpu_speed_controller_ &&
+      cpu_speed_controller_->OnFrameEncoded(
+          rtc::TimeMicros() - encode_start_us, codec_.maxFramerate)) {
+    vpx_codec_control(
+        encoder_, VP8E_SET_CPUUSED,
+        std::min(cpu_speed_ + cpu_speed_controller_->speed_offset(),
+                 kMaxCpuSpeed));
+  }
+
   return WEBRTC_VIDEO_CODEC_OK;
 }
 
@@ -17,6 +17,7 @@
 
 #include "webrtc/modules/video_coding/codecs/vp9/include/vp9.h"
 #include "webrtc/modules/video_coding/codecs/vp9/vp9_frame_buffer_pool.h"
+#include "webrtc/modules/video_coding/utility/cpu_speed_controller.h"
 
 #include "vpx/vp8cx.h"
 #include "vpx/vpx_decoder.h"
@@ -108,6 +109,8 @@ class VP9EncoderImpl : public VP9Encoder {
   bool inited_;
   int64_t timestamp_;
   int cpu_speed_;
+  // Raises |cpu_speed_| while encoding takes too long, if enabled.
+  const std::unique_ptr<CpuSpeedController> cpu_speed_controller_;
   uint32_t rc_max_intra_target_;
   vpx_codec_ctx_t* encoder_;
   vpx_codec_enc_cfg_t* config_;
@@ -0,0 +1,104 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/video_coding/utility/cpu_speed_controller.h"
+
+#include <stdio.h>
+
+#include <string>
+
+#include "webrtc/rtc_base/checks.h"
+#include "webrtc/rtc_base/logging.h"
+#include "webrtc/rtc_base/ptr_util.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/system_wrappers/include/field_trial.h"
+
+namespace webrtc {
+
+namespace {
+const char kFieldTrial[] = "WebRTC-VideoEncoderSpeedControl";
+
+// Smoothing factor applied per frame.
+const float kUtilizationAlpha = 0.9f;
+// Caps the smoothed utilization, so that a single stalled frame does not keep
+// the encoder at a high speed for long.
+const float kMaxUtilization = 4.0f;
+// The number of frames to encode at a speed before changing it again, giving
+// the smoothed utilization time to settle.
+const int kMinFramesBetweenChanges = 15;
+// Changing the speed by one step changes the encode time by roughly 10-30%.
+// Only slow down when there is room for that, to avoid oscillation.
+const float kLowUtilizationFactor = 0.6f;
+}  // namespace
+
+CpuSpeedController::CpuSpeedController(float target_utilization,
+                                       int max_speed_offset)
+    : target_utilization_(target_utilization),
+      max_speed_offset_(max_speed_offset),
+      speed_offset_(0),
+      frames_since_change_(0),
+      utilization_(kUtilizationAlpha, kMaxUtilization) {
+  RTC_DCHECK_GT(target_utilization_, 0.0f);
+  RTC_DCHECK_GE(max_speed_offset_, 0);
+}
+
+std::unique_ptr<CpuSpeedController> CpuSpeedController::CreateFromFieldTrial(
+    int max_speed_offset) {
+  std::string group = webrtc::field_trial::FindFullName(kFieldTrial);
+  if (group.empty())
+    return nullptr;
+
+  int target_percent;
+  if (sscanf(group.c_str(), "Enabled-%d", &target_percent) != 1)
+    return nullptr;
+  if (target_percent <= 0 || target_percent > 100) {
+    LOG(LS_WARNING) << "Invalid target encode time: " << target_percent
+                    << "% of the frame interval.";
+    return nullptr;
+  }
+  return rtc::MakeUnique<CpuSpeedController>(target_percent / 100.0f,
+                                             max_speed_offset);
+}
+
+bool CpuSpeedController::OnFrameEncoded(int64_t encode_time_us,
+                                        uint32_t framerate) {
+  if (framerate == 0)
+    return false;
+  const float utilization = static_cast<float>(encode_time_us) * framerate /
+                            rtc::kNumMicrosecsPerSec;
+  utilization_.Apply(1.0f, utilization);
+  if (++frames_since_change_ < kMinFramesBetweenChanges)
+    return false;
+
+  const float smoothed = utilization_.filtered();
+  int new_offset = speed_offset_;
+  if (smoothed > target_utilization_ && speed_offset_ < max_speed_offset_) {
+    ++new_offset;
+  } else if (smoothed < kLowUtilizationFactor * target_utilization_ &&
+             speed_offset_ > 0) {
+    --new_offset;
+  }
+  if (new_offset == speed_offset_)
+    return false;
+
+  speed_offset_ = new_offset;
+  // Start over, measuring the encode time at the new speed.
+  frames_since_change_ = 0;
+  utilization_.Reset(kUtilizationAlpha);
+  return true;
+}
+
+void CpuSpeedController::Reset() {
+  speed_offset_ = 0;
+  frames_since_change_ = 0;
+  utilization_.Reset(kUtilizationAlpha);
+}
+
+}  // namespace webrtc
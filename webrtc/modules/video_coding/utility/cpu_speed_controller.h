@@ -0,0 +1,60 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_VIDEO_CODING_UTILITY_CPU_SPEED_CONTROLLER_H_
+#define WEBRTC_MODULES_VIDEO_CODING_UTILITY_CPU_SPEED_CONTROLLER_H_
+
+#include <stdint.h>
+
+#include <memory>
+
+#include "webrtc/rtc_base/numerics/exp_filter.h"
+
+namespace webrtc {
+
+// Closed-loop control of the speed setting of a libvpx encoder. The time spent
+// encoding each frame is compared to a budget, a fraction of the frame
+// interval, and the encoder is told to run faster while encoding is over
+// budget and slower (at higher quality) once it is well within it.
+//
+// The controller produces an offset relative to the speed the encoder would
+// otherwise use; it is up to the encoder to map it onto its speed scale.
+class CpuSpeedController {
+ public:
+  // |target_utilization| is the fraction of the frame interval that encoding a
+  // frame should take. The offset stays within [0, |max_speed_offset|].
+  CpuSpeedController(float target_utilization, int max_speed_offset);
+
+  // Returns a controller configured by the "WebRTC-VideoEncoderSpeedControl"
+  // field trial, with the group "Enabled-<target utilization in percent>", or
+  // null if the field trial is not enabled.
+  static std::unique_ptr<CpuSpeedController> CreateFromFieldTrial(
+      int max_speed_offset);
+
+  // Reports the time spent encoding a frame at |framerate| frames per second.
+  // Returns true if |speed_offset()| changed.
+  bool OnFrameEncoded(int64_t encode_time_us, uint32_t framerate);
+
+  // The number of steps the encoder should run faster than its default speed.
+  int speed_offset() const { return speed_offset_; }
+
+  void Reset();
+
+ private:
+  const float target_utilization_;
+  const int max_speed_offset_;
+  int speed_offset_;
+  int frames_since_change_;
+  rtc::ExpFilter utilization_;
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_VIDEO_CODING_UTILITY_CPU_SPEED_CONTROLLER_H_
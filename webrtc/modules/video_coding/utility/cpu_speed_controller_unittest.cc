@@ -0,0 +1,100 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/video_coding/utility/cpu_speed_controller.h"
+
+#include "webrtc/test/field_trial.h"
+#include "webrtc/test/gtest.h"
+
+namespace webrtc {
+
+namespace {
+const float kTargetUtilization = 0.5f;
+const int kMaxSpeedOffset = 3;
+const uint32_t kFramerate = 30;
+// 33333 us per frame at 30 fps.
+const int64_t kOverBudgetUs = 25000;
+const int64_t kWithinBudgetUs = 15000;
+const int64_t kWellWithinBudgetUs = 5000;
+
+// Reports |num_frames| frames and returns the number of speed changes.
+int EncodeFrames(CpuSpeedController* controller,
+                 int num_frames,
+                 int64_t encode_time_us) {
+  int changes = 0;
+  for (int i = 0; i < num_frames; ++i) {
+    if (controller->OnFrameEncoded(encode_time_us, kFramerate))
+      ++changes;
+  }
+  return changes;
+}
+}  // namespace
+
+TEST(CpuSpeedControllerTest, KeepsSpeedWithinBudget) {
+  CpuSpeedController controller(kTargetUtilization, kMaxSpeedOffset);
+  EXPECT_EQ(0, EncodeFrames(&controller, 100, kWithinBudgetUs));
+  EXPECT_EQ(0, controller.speed_offset());
+}
+
+TEST(CpuSpeedControllerTest, SpeedsUpWhenOverBudget) {
+  CpuSpeedController controller(kTargetUtilization, kMaxSpeedOffset);
+  EncodeFrames(&controller, 14, kOverBudgetUs);
+  EXPECT_EQ(0, controller.speed_offset());
+  EXPECT_EQ(1, EncodeFrames(&controller, 1, kOverBudgetUs));
+  EXPECT_EQ(1, controller.speed_offset());
+}
+
+TEST(CpuSpeedControllerTest, SpeedOffsetIsBounded) {
+  CpuSpeedController controller(kTargetUtilization, kMaxSpeedOffset);
+  EncodeFrames(&controller, 300, kOverBudgetUs);
+  EXPECT_EQ(kMaxSpeedOffset, controller.speed_offset());
+  EncodeFrames(&controller, 300, kWellWithinBudgetUs);
+  EXPECT_EQ(0, controller.speed_offset());
+}
+
+TEST(CpuSpeedControllerTest, SlowsDownOnlyWellWithinBudget) {
+  CpuSpeedController controller(kTargetUtilization, kMaxSpeedOffset);
+  EncodeFrames(&controller, 300, kOverBudgetUs);
+  ASSERT_EQ(kMaxSpeedOffset, controller.speed_offset());
+  // Slightly within budget: a slower speed would likely go over it again.
+  EXPECT_EQ(0, EncodeFrames(&controller, 300, kWithinBudgetUs));
+  EXPECT_EQ(kMaxSpeedOffset, controller.speed_offset());
+  EXPECT_EQ(1, EncodeFrames(&controller, 15, kWellWithinBudgetUs));
+  EXPECT_EQ(kMaxSpeedOffset - 1, controller.speed_offset());
+}
+
+TEST(CpuSpeedControllerTest, ResetClearsSpeedOffset) {
+  CpuSpeedController controller(kTargetUtilization, kMaxSpeedOffset);
+  EncodeFrames(&controller, 300, kOverBudgetUs);
+  controller.Reset();
+  EXPECT_EQ(0, controller.speed_offset());
+}
+
+TEST(CpuSpeedControllerTest, NotCreatedWithoutFieldTrial) {
+  EXPECT_FALSE(CpuSpeedController::CreateFromFieldTrial(kMaxSpeedOffset));
+}
+
+TEST(CpuSpeedControllerTest, CreatedFromFieldTrial) {
+  test::ScopedFieldTrials field_trial(
+      "WebRTC-VideoEncoderSpeedControl/Enabled-50/");
+  std::unique_ptr<CpuSpeedController> controller =
+      CpuSpeedController::CreateFromFieldTrial(kMaxSpeedOffset);
+  ASSERT_TRUE(controller);
+  EncodeFrames(controller.get(), 300, kOverBudgetUs);
+  EXPECT_EQ(kMaxSpeedOffset, controller->speed_offset());
+}
+
+TEST(CpuSpeedControllerTest, NotCreatedWithInvalidFieldTrial) {
+  test::ScopedFieldTrials field_trial(
+      "WebRTC-VideoEncoderSpeedControl/Enabled-0/");
+  EXPECT_FALSE(CpuSpeedController::CreateFromFieldTrial(kMaxSpeedOffset));
+}
+
+}  // namespace webrtc
@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "webrtc/common_video/include/frame_callback.h"
+#include "webrtc/common_video/include/update_rect_accumulator.h"
 #include "webrtc/modules/video_coding/codec_database.h"
 #include "webrtc/modules/video_coding/frame_buffer.h"
 #include "webrtc/modules/video_coding/generic_decoder.h"
@@ -130,6 +131,8 @@ class VideoSender : public Module {
   VCMSendStatisticsCallback* const send_stats_callback_;
   VCMCodecDataBase _codecDataBase RTC_GUARDED_BY(encoder_crit_);
   bool frame_dropper_enabled_ RTC_GUARDED_BY(encoder_crit_);
+  // Update rects of the frames dropped by |_mediaOpt|.
+  UpdateRectAccumulator update_rects_ RTC_GUARDED_BY(encoder_crit_);
   VCMProcessTimer _sendStatsTimer;
 
   // Must be accessed on the construction thread of VideoSender.
@@ -324,6 +324,7 @@ int32_t VideoSender::AddVideoFrame(const VideoFrame& videoFrame,
                     << encoder_params.rtt << " input frame rate "
                     << encoder_params.input_frame_rate;
     post_encode_callback_->OnDroppedFrame();
+    update_rects_.AddDroppedFrame(videoFrame);
     return VCM_OK;
   }
   // TODO(pbos): Make sure setting send codec is synchronized with video
@@ -331,6 +332,7 @@ int32_t VideoSender::AddVideoFrame(const VideoFrame& videoFrame,
   if (!_codecDataBase.MatchesCurrentResolution(videoFrame.width(),
                                                videoFrame.height())) {
     LOG(LS_ERROR) << "Incoming frame doesn't match set resolution. Dropping.";
+    update_rects_.AddDroppedFrame(videoFrame);
     return VCM_PARAMETER_ERROR;
   }
   VideoFrame converted_frame = videoFrame;
@@ -348,6 +350,7 @@ int32_t VideoSender::AddVideoFrame(const VideoFrame& videoFrame,
 
     if (!converted_buffer) {
       LOG(LS_ERROR) << "Frame conversion failed, dropping frame.";
+      update_rects_.AddDroppedFrame(videoFrame);
       return VCM_PARAMETER_ERROR;
     }
     converted_frame = VideoFrame(converted_buffer,
@@ -355,10 +358,12 @@ int32_t VideoSender::AddVideoFrame(const VideoFrame& videoFrame,
                                  converted_frame.render_time_ms(),
                                  converted_frame.rotation());
   }
+  converted_frame.set_update_rects(update_rects_.TakeForFrame(videoFrame));
   int32_t ret =
       _encoder->Encode(converted_frame, codecSpecificInfo, next_frame_types);
   if (ret < 0) {
     LOG(LS_ERROR) << "Failed to encode frame. Error code: " << ret;
+    update_rects_.AddDroppedFrame(converted_frame);
     return ret;
   }
 
@@ -32,6 +32,7 @@ using ::testing::AllOf;
 using ::testing::ElementsAre;
 using ::testing::ElementsAreArray;
 using ::testing::Field;
+using ::testing::Invoke;
 using ::testing::NiceMock;
 using ::testing::Pointee;
 using ::testing::Return;
@@ -393,6 +394,34 @@ TEST_F(TestVideoSenderWithMockEncoder,
   AddFrame();
 }
 
+TEST_F(TestVideoSenderWithMockEncoder, AddsUpdateRectsOfFailedFrameToNext) {
+  rtc::Optional<std::vector<VideoFrame::UpdateRect>> encoded_update_rects;
+  EXPECT_CALL(encoder_, Encode(_, _, _))
+      .WillOnce(Return(WEBRTC_VIDEO_CODEC_ERROR))
+      .WillOnce(Invoke([&encoded_update_rects](
+                           const VideoFrame& frame,
+                           const CodecSpecificInfo* codec_specific_info,
+                           const std::vector<FrameType>* frame_types) {
+        encoded_update_rects = frame.update_rects();
+        return WEBRTC_VIDEO_CODEC_OK;
+      }));
+
+  VideoFrame* frame = generator_->NextFrame();
+  frame->set_update_rects(rtc::Optional<std::vector<VideoFrame::UpdateRect>>(
+      std::vector<VideoFrame::UpdateRect>{{0, 0, 8, 8}}));
+  EXPECT_LT(sender_->AddVideoFrame(*frame, nullptr), 0);
+
+  frame = generator_->NextFrame();
+  frame->set_update_rects(rtc::Optional<std::vector<VideoFrame::UpdateRect>>(
+      std::vector<VideoFrame::UpdateRect>{{16, 16, 8, 8}}));
+  EXPECT_EQ(0, sender_->AddVideoFrame(*frame, nullptr));
+
+  ASSERT_TRUE(encoded_update_rects);
+  ASSERT_EQ(2u, encoded_update_rects->size());
+  EXPECT_EQ(0, (*encoded_update_rects)[0].offset_x);
+  EXPECT_EQ(16, (*encoded_update_rects)[1].offset_x);
+}
+
 class TestVideoSenderWithVp8 : public TestVideoSender {
  public:
   TestVideoSenderWithVp8()
@@ -8,22 +8,87 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <stdlib.h>
 #include <string.h>
 
 #include <memory>
+#include <string>
+#include <vector>
 
+#include "webrtc/api/video/i420_buffer.h"
 #include "webrtc/common_video/include/i420_buffer_pool.h"
+#include "webrtc/modules/video_processing/util/denoiser_filter_c.h"
 #include "webrtc/modules/video_processing/video_denoiser.h"
+#include "webrtc/rtc_base/random.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
 #include "webrtc/test/gtest.h"
 #include "webrtc/test/frame_utils.h"
 #include "webrtc/test/testsupport/fileutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
+#include "webrtc/typedefs.h"
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+#include "webrtc/modules/video_processing/util/denoiser_filter_avx2.h"
+#include "webrtc/modules/video_processing/util/denoiser_filter_sse2.h"
+#elif defined(WEBRTC_HAS_NEON)
+#include "webrtc/modules/video_processing/util/denoiser_filter_neon.h"
+#endif
 
 namespace webrtc {
 
+namespace {
+// Every SIMD filter that this CPU can run, to compare against the C filter.
+// DenoiserFilter::Create() only returns the fastest one, so testing through it
+// would leave e.g. the SSE2 filter untested on AVX2 machines.
+std::vector<std::unique_ptr<DenoiserFilter>> CreateSimdFilters() {
+  std::vector<std::unique_ptr<DenoiserFilter>> filters;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kSSE2))
+    filters.emplace_back(new DenoiserFilterSSE2());
+  if (WebRtc_GetCPUInfo(kAVX2))
+    filters.emplace_back(new DenoiserFilterAVX2());
+#elif defined(WEBRTC_HAS_NEON)
+  filters.emplace_back(new DenoiserFilterNEON());
+#endif
+  return filters;
+}
+
+// A static gradient with random noise of up to +-|noise| added to the luma.
+rtc::scoped_refptr<I420Buffer> CreateNoisyFrame(int width,
+                                                int height,
+                                                int noise,
+                                                Random* random) {
+  rtc::scoped_refptr<I420Buffer> buffer = I420Buffer::Create(width, height);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      int value = 64 + (x + y) % 128 + random->Rand(-noise, noise);
+      buffer->MutableDataY()[y * buffer->StrideY() + x] =
+          static_cast<uint8_t>(value);
+    }
+  }
+  memset(buffer->MutableDataU(), 128,
+         buffer->StrideU() * buffer->ChromaHeight());
+  memset(buffer->MutableDataV(), 128,
+         buffer->StrideV() * buffer->ChromaHeight());
+  return buffer;
+}
+
+// Mean absolute difference between the luma planes of two frames.
+double LumaDifference(const I420BufferInterface& a,
+                      const I420BufferInterface& b) {
+  int64_t sum = 0;
+  for (int y = 0; y < a.height(); ++y) {
+    for (int x = 0; x < a.width(); ++x) {
+      sum += abs(a.DataY()[y * a.StrideY() + x] -
+                 b.DataY()[y * b.StrideY() + x]);
+    }
+  }
+  return static_cast<double>(sum) / (a.width() * a.height());
+}
+}  // namespace
+
 TEST(VideoDenoiserTest, CopyMem) {
-  std::unique_ptr<DenoiserFilter> df_c(DenoiserFilter::Create(false, nullptr));
-  std::unique_ptr<DenoiserFilter> df_sse_neon(
-      DenoiserFilter::Create(true, nullptr));
+  DenoiserFilterC df_c;
   uint8_t src[16 * 16], dst[16 * 16];
   for (int i = 0; i < 16; ++i) {
     for (int j = 0; j < 16; ++j) {
@@ -32,18 +97,18 @@ TEST(VideoDenoiserTest, CopyMem) {
   }
 
   memset(dst, 0, 16 * 16);
-  df_c->CopyMem16x16(src, 16, dst, 16);
+  df_c.CopyMem16x16(src, 16, dst, 16);
   EXPECT_EQ(0, memcmp(src, dst, 16 * 16));
 
-  memset(dst, 0, 16 * 16);
-  df_sse_neon->CopyMem16x16(src, 16, dst, 16);
-  EXPECT_EQ(0, memcmp(src, dst, 16 * 16));
+  for (const auto& df_simd : CreateSimdFilters()) {
+    memset(dst, 0, 16 * 16);
+    df_simd->CopyMem16x16(src, 16, dst, 16);
+    EXPECT_EQ(0, memcmp(src, dst, 16 * 16));
+  }
 }
 
 TEST(VideoDenoiserTest, Variance) {
-  std::unique_ptr<DenoiserFilter> df_c(DenoiserFilter::Create(false, nullptr));
-  std::unique_ptr<DenoiserFilter> df_sse_neon(
-      DenoiserFilter::Create(true, nullptr));
+  DenoiserFilterC df_c;
   uint8_t src[16 * 16], dst[16 * 16];
   uint32_t sum = 0, sse = 0, var;
   for (int i = 0; i < 16; ++i) {
@@ -60,55 +125,35 @@ TEST(VideoDenoiserTest, Variance) {
   }
   var = sse - ((sum * sum) >> 7);
   memset(dst, 0, 16 * 16);
-  EXPECT_EQ(var, df_c->Variance16x8(src, 16, dst, 16, &sse));
-  EXPECT_EQ(var, df_sse_neon->Variance16x8(src, 16, dst, 16, &sse));
+  EXPECT_EQ(var, df_c.Variance16x8(src, 16, dst, 16, &sse));
+  for (const auto& df_simd : CreateSimdFilters())
+    EXPECT_EQ(var, df_simd->Variance16x8(src, 16, dst, 16, &sse));
 }
 
 TEST(VideoDenoiserTest, MbDenoise) {
-  std::unique_ptr<DenoiserFilter> df_c(DenoiserFilter::Create(false, nullptr));
-  std::unique_ptr<DenoiserFilter> df_sse_neon(
-      DenoiserFilter::Create(true, nullptr));
+  DenoiserFilterC df_c;
+  std::vector<std::unique_ptr<DenoiserFilter>> simd_filters =
+      CreateSimdFilters();
   uint8_t running_src[16 * 16], src[16 * 16];
-  uint8_t dst[16 * 16], dst_sse_neon[16 * 16];
+  uint8_t dst[16 * 16], dst_simd[16 * 16];
 
-  // Test case: |diff| <= |3 + shift_inc1|
-  for (int i = 0; i < 16; ++i) {
-    for (int j = 0; j < 16; ++j) {
-      running_src[i * 16 + j] = i * 11 + j;
-      src[i * 16 + j] = i * 11 + j + 2;
+  // Test cases: |diff| <= |3 + shift_inc1|, |diff| >= |4 + shift_inc1|,
+  // |diff| >= 8.
+  for (int diff : {2, 5, 8}) {
+    for (int i = 0; i < 16; ++i) {
+      for (int j = 0; j < 16; ++j) {
+        running_src[i * 16 + j] = i * 11 + j;
+        src[i * 16 + j] = i * 11 + j + diff;
+      }
     }
-  }
-  memset(dst, 0, 16 * 16);
-  df_c->MbDenoise(running_src, 16, dst, 16, src, 16, 0, 1);
-  memset(dst_sse_neon, 0, 16 * 16);
-  df_sse_neon->MbDenoise(running_src, 16, dst_sse_neon, 16, src, 16, 0, 1);
-  EXPECT_EQ(0, memcmp(dst, dst_sse_neon, 16 * 16));
-
-  // Test case: |diff| >= |4 + shift_inc1|
-  for (int i = 0; i < 16; ++i) {
-    for (int j = 0; j < 16; ++j) {
-      running_src[i * 16 + j] = i * 11 + j;
-      src[i * 16 + j] = i * 11 + j + 5;
+    memset(dst, 0, 16 * 16);
+    df_c.MbDenoise(running_src, 16, dst, 16, src, 16, 0, 1);
+    for (const auto& df_simd : simd_filters) {
+      memset(dst_simd, 0, 16 * 16);
+      df_simd->MbDenoise(running_src, 16, dst_simd, 16, src, 16, 0, 1);
+      EXPECT_EQ(0, memcmp(dst, dst_simd, 16 * 16)) << "diff " << diff;
     }
   }
-  memset(dst, 0, 16 * 16);
-  df_c->MbDenoise(running_src, 16, dst, 16, src, 16, 0, 1);
-  memset(dst_sse_neon, 0, 16 * 16);
-  df_sse_neon->MbDenoise(running_src, 16, dst_sse_neon, 16, src, 16, 0, 1);
-  EXPECT_EQ(0, memcmp(dst, dst_sse_neon, 16 * 16));
-
-  // Test case: |diff| >= 8
-  for (int i = 0; i < 16; ++i) {
-    for (int j = 0; j < 16; ++j) {
-      running_src[i * 16 + j] = i * 11 + j;
-      src[i * 16 + j] = i * 11 + j + 8;
-    }
-  }
-  memset(dst, 0, 16 * 16);
-  df_c->MbDenoise(running_src, 16, dst, 16, src, 16, 0, 1);
-  memset(dst_sse_neon, 0, 16 * 16);
-  df_sse_neon->MbDenoise(running_src, 16, dst_sse_neon, 16, src, 16, 0, 1);
-  EXPECT_EQ(0, memcmp(dst, dst_sse_neon, 16 * 16));
 
   // Test case: |diff| > 15
   for (int i = 0; i < 16; ++i) {
@@ -119,10 +164,12 @@ TEST(VideoDenoiserTest, MbDenoise) {
   }
   memset(dst, 0, 16 * 16);
   DenoiserDecision decision =
-      df_c->MbDenoise(running_src, 16, dst, 16, src, 16, 0, 1);
-  EXPECT_EQ(COPY_BLOCK, decision);
-  decision = df_sse_neon->MbDenoise(running_src, 16, dst, 16, src, 16, 0, 1);
+      df_c.MbDenoise(running_src, 16, dst, 16, src, 16, 0, 1);
   EXPECT_EQ(COPY_BLOCK, decision);
+  for (const auto& df_simd : simd_filters) {
+    decision = df_simd->MbDenoise(running_src, 16, dst, 16, src, 16, 0, 1);
+    EXPECT_EQ(COPY_BLOCK, decision);
+  }
 }
 
 TEST(VideoDenoiserTest, Denoiser) {
@@ -158,4 +205,90 @@ TEST(VideoDenoiserTest, Denoiser) {
   ASSERT_NE(0, feof(source_file)) << "Error reading source file";
 }
 
+TEST(VideoDenoiserTest, MbDenoiseAndVarianceOnRandomBlocks) {
+  DenoiserFilterC df_c;
+  const int kStride = 32;
+  uint8_t running_src[16 * kStride], src[16 * kStride];
+  uint8_t dst_c[16 * kStride], dst_simd[16 * kStride];
+  for (const auto& df_simd : CreateSimdFilters()) {
+    Random random(0x1234);
+    for (int i = 0; i < 10000; ++i) {
+      // Small differences are filtered, large ones copied.
+      const int max_diff = 1 + i % 20;
+      for (int j = 0; j < 16 * kStride; ++j) {
+        running_src[j] = random.Rand<uint8_t>();
+        src[j] = static_cast<uint8_t>(running_src[j] +
+                                      random.Rand(-max_diff, max_diff));
+      }
+      const uint8_t motion_magnitude = random.Rand(0, 48);
+      const int increase_denoising = random.Rand(0, 1);
+      memset(dst_c, 0, sizeof(dst_c));
+      memset(dst_simd, 0, sizeof(dst_simd));
+      EXPECT_EQ(df_c.MbDenoise(running_src, kStride, dst_c, kStride, src,
+                               kStride, motion_magnitude, increase_denoising),
+                df_simd->MbDenoise(running_src, kStride, dst_simd, kStride,
+                                   src, kStride, motion_magnitude,
+                                   increase_denoising));
+      for (int r = 0; r < 16; ++r)
+        ASSERT_EQ(0, memcmp(dst_c + r * kStride, dst_simd + r * kStride, 16));
+
+      uint32_t sse_c, sse_simd;
+      EXPECT_EQ(df_c.Variance16x8(running_src, kStride, src, kStride, &sse_c),
+                df_simd->Variance16x8(running_src, kStride, src, kStride,
+                                      &sse_simd));
+      EXPECT_EQ(sse_c, sse_simd);
+    }
+  }
+}
+
+// Disabled since it only reports timings; run it with
+// --gtest_also_run_disabled_tests.
+TEST(VideoDenoiserTest, DISABLED_DenoisePerformance) {
+  const int kNumFrames = 100;
+  const int kNoise = 8;
+  const struct {
+    const char* name;
+    int width;
+    int height;
+  } kResolutions[] = {{"720p", 1280, 720}, {"1080p", 1920, 1080}};
+
+  for (const auto& resolution : kResolutions) {
+    Random random(0x5678);
+    VideoDenoiser denoiser(true);
+    double input_difference = 0;
+    double output_difference = 0;
+    // Frames are created as they are denoised, so that only the last input
+    // and output frames are kept alive.
+    rtc::scoped_refptr<I420Buffer> last_frame;
+    rtc::scoped_refptr<I420BufferInterface> last_denoised;
+    int64_t elapsed_us = 0;
+    for (int i = 0; i < kNumFrames; ++i) {
+      rtc::scoped_refptr<I420Buffer> frame = CreateNoisyFrame(
+          resolution.width, resolution.height, kNoise, &random);
+      const int64_t start_us = rtc::TimeMicros();
+      rtc::scoped_refptr<I420BufferInterface> denoised =
+          denoiser.DenoiseFrame(frame, true);
+      elapsed_us += rtc::TimeMicros() - start_us;
+      if (i > 0) {
+        // The frame to frame change in a static scene is what the encoder
+        // spends its bits on.
+        input_difference += LumaDifference(*frame, *last_frame);
+        output_difference += LumaDifference(*denoised, *last_denoised);
+      }
+      last_frame = frame;
+      last_denoised = denoised;
+    }
+    EXPECT_LT(output_difference, input_difference);
+
+    std::string trace = resolution.name;
+    test::PrintResult("denoise_time", "", trace,
+                      static_cast<size_t>(elapsed_us / kNumFrames), "us",
+                      true);
+    test::PrintResult("temporal_noise_reduction", "", trace,
+                      static_cast<size_t>(100 * (1 - output_difference /
+                                                         input_difference)),
+                      "%", false);
+  }
+}
+
 }  // namespace webrtc
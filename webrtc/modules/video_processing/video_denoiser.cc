@@ -8,12 +8,20 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include "webrtc/common_video/include/video_frame_buffer.h"
 #include "webrtc/common_video/libyuv/include/webrtc_libyuv.h"
 #include "webrtc/modules/video_processing/video_denoiser.h"
+#include "webrtc/rtc_base/bind.h"
 #include "libyuv/planar_functions.h"
 
 namespace webrtc {
 
+namespace {
+// Keeps the planes of a denoised frame alive.
+void KeepBuffersAlive(const rtc::scoped_refptr<I420Buffer>& denoised_y,
+                      const rtc::scoped_refptr<I420BufferInterface>& src_uv) {}
+}  // namespace
+
 #if DISPLAY || DISPLAYNEON
 static void CopyMem8x8(const uint8_t* src,
                        int src_stride,
@@ -322,6 +330,7 @@ rtc::scoped_refptr<I420BufferInterface> VideoDenoiser::DenoiseFrame(
   if ((mb_rows_ << 4) != height_ || (mb_cols_ << 4) != width_)
     CopyLumaOnMargin(y_src, stride_y_src, y_dst, stride_y_dst);
 
+#if DISPLAY || DISPLAYNEON
   // Copy u/v planes.
   libyuv::CopyPlane(frame->DataU(), frame->StrideU(),
                     dst->MutableDataU(), dst->StrideU(),
@@ -330,16 +339,23 @@ rtc::scoped_refptr<I420BufferInterface> VideoDenoiser::DenoiseFrame(
                     dst->MutableDataV(), dst->StrideV(),
                     (width_ + 1) >> 1, (height_ + 1) >> 1);
 
-#if DISPLAY || DISPLAYNEON
   // Show rectangular region
   ShowRect(filter_, moving_edge_, moving_object_, x_density_, y_density_,
            frame->DataU(), frame->StrideU(), frame->DataV(), frame->StrideV(),
            dst->MutableDataU(), dst->StrideU(),
            dst->MutableDataV(), dst->StrideV(),
            mb_rows_, mb_cols_);
-#endif
   prev_buffer_ = dst;
   return dst;
+#else
+  // Only the luma plane is denoised, and only it is needed for the next
+  // frame. Share the u/v planes of |frame| rather than copying them.
+  prev_buffer_ = dst;
+  return WrapI420Buffer(width_, height_, dst->DataY(), dst->StrideY(),
+                        frame->DataU(), frame->StrideU(), frame->DataV(),
+                        frame->StrideV(),
+                        rtc::Bind(&KeepBuffersAlive, dst, frame));
+#endif
 }
 
 }  // namespace webrtc
@@ -935,6 +935,165 @@ static void MergeCodecs(const std::vector<C>& reference_codecs,
   }
 }
 
+// Computes the codecs of an m= section from |supported_codecs|, the codecs
+// supported for its direction. The payload types come from |all_codecs|, which
+// has the payload type mappings of the whole session. The order comes from
+// |current_codecs|, the previously negotiated codecs of the m= section (null
+// for a new m= section), and then from |supported_codecs|, to ensure that
+// re-offers don't change existing codec priority, and that new codecs are added
+// with the right priority.
+template <class C>
+static std::vector<C> ComputeMediaSectionCodecs(
+    const std::vector<C>& supported_codecs,
+    const std::vector<C>& all_codecs,
+    const std::vector<C>* current_codecs) {
+  std::vector<C> filtered_codecs;
+  // Add the codecs from current content if exists.
+  if (current_codecs) {
+    for (const C& codec : *current_codecs) {
+      if (FindMatchingCodec<C>(supported_codecs, all_codecs, codec, nullptr)) {
+        filtered_codecs.push_back(codec);
+      }
+    }
+  }
+  // Add other supported codecs.
+  C found_codec;
+  for (const C& codec : supported_codecs) {
+    if (FindMatchingCodec<C>(supported_codecs, all_codecs, codec,
+                             &found_codec) &&
+        !FindMatchingCodec<C>(supported_codecs, filtered_codecs, codec,
+                              nullptr)) {
+      // Use the |found_codec| from |all_codecs| because it has the correctly
+      // mapped payload type.
+      filtered_codecs.push_back(found_codec);
+    }
+  }
+  return filtered_codecs;
+}
+
+// Hashes the payload types of |codecs|, in order. Used to find identical codec
+// lists without comparing every pair of lists.
+template <class C>
+static size_t HashCodecList(const std::vector<C>& codecs) {
+  size_t hash = codecs.size();
+  for (const C& codec : codecs) {
+    hash = hash * 31 + static_cast<size_t>(codec.id);
+  }
+  return hash;
+}
+
+// Returns true if a list equal to |codecs| was added to |lists| before, and
+// otherwise adds |codecs|, which must outlive |lists|. Merging or filtering the
+// same codec list a second time doesn't change the result, so this is used to
+// skip the codec lists repeated in many m= sections.
+template <class C>
+static bool FindOrAddCodecList(
+    const std::vector<C>& codecs,
+    std::unordered_multimap<size_t, const std::vector<C>*>* lists) {
+  const size_t hash = HashCodecList(codecs);
+  const auto range = lists->equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (*it->second == codecs) {
+      return true;
+    }
+  }
+  lists->insert(std::make_pair(hash, &codecs));
+  return false;
+}
+
+// With many m= sections, most of them share the same few codec lists, so the
+// results of ComputeMediaSectionCodecs and NegotiateCodecs, which are quadratic
+// in the number of codecs, are kept for the duration of a CreateOffer or
+// CreateAnswer call and reused for every m= section with the same inputs.
+template <class C>
+class MediaSessionDescriptionFactory::CodecCache {
+ public:
+  // |all_codecs| has the payload type mappings of the session being created,
+  // and must outlive the cache.
+  explicit CodecCache(const std::vector<C>& all_codecs)
+      : all_codecs_(all_codecs) {}
+
+  // Returns ComputeMediaSectionCodecs(|supported_codecs|, all codecs, codecs
+  // of |current_content|). |supported_codecs| must outlive the cache.
+  const std::vector<C>& MediaSectionCodecs(
+      const std::vector<C>& supported_codecs,
+      const ContentInfo* current_content) {
+    const std::vector<C>* current_codecs = nullptr;
+    if (current_content) {
+      current_codecs = &static_cast<const MediaContentDescriptionImpl<C>*>(
+                            current_content->description)
+                            ->codecs();
+    }
+    const size_t hash =
+        (current_codecs ? HashCodecList(*current_codecs) : 0) * 31 +
+        std::hash<const void*>()(&supported_codecs);
+    const auto range = media_section_codecs_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      const MediaSectionEntry& entry = *it->second;
+      if (entry.supported_codecs == &supported_codecs &&
+          entry.has_current_codecs == (current_codecs != nullptr) &&
+          (!current_codecs || entry.current_codecs == *current_codecs)) {
+        return entry.codecs;
+      }
+    }
+    std::unique_ptr<MediaSectionEntry> entry(new MediaSectionEntry());
+    entry->supported_codecs = &supported_codecs;
+    entry->has_current_codecs = current_codecs != nullptr;
+    if (current_codecs) {
+      entry->current_codecs = *current_codecs;
+    }
+    entry->codecs = ComputeMediaSectionCodecs(supported_codecs, all_codecs_,
+                                              current_codecs);
+    const std::vector<C>& codecs = entry->codecs;
+    media_section_codecs_.insert(std::make_pair(hash, std::move(entry)));
+    return codecs;
+  }
+
+  // Returns the result of NegotiateCodecs(|local_codecs|, |offered_codecs|).
+  // |local_codecs| must outlive the cache.
+  const std::vector<C>& NegotiatedCodecs(const std::vector<C>& local_codecs,
+                                         const std::vector<C>& offered_codecs) {
+    const size_t hash = HashCodecList(offered_codecs) * 31 +
+                        std::hash<const void*>()(&local_codecs);
+    const auto range = negotiated_codecs_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      const NegotiatedEntry& entry = *it->second;
+      if (entry.local_codecs == &local_codecs &&
+          entry.offered_codecs == offered_codecs) {
+        return entry.codecs;
+      }
+    }
+    std::unique_ptr<NegotiatedEntry> entry(new NegotiatedEntry());
+    entry->local_codecs = &local_codecs;
+    entry->offered_codecs = offered_codecs;
+    NegotiateCodecs(local_codecs, offered_codecs, &entry->codecs);
+    const std::vector<C>& codecs = entry->codecs;
+    negotiated_codecs_.insert(std::make_pair(hash, std::move(entry)));
+    return codecs;
+  }
+
+ private:
+  struct MediaSectionEntry {
+    const std::vector<C>* supported_codecs;
+    bool has_current_codecs;
+    std::vector<C> current_codecs;
+    std::vector<C> codecs;
+  };
+  struct NegotiatedEntry {
+    const std::vector<C>* local_codecs;
+    std::vector<C> offered_codecs;
+    std::vector<C> codecs;
+  };
+
+  const std::vector<C>& all_codecs_;
+  // Entries are keyed by a hash of their inputs, and never move once added so
+  // that the returned references stay valid.
+  std::unordered_multimap<size_t, std::unique_ptr<MediaSectionEntry>>
+      media_section_codecs_;
+  std::unordered_multimap<size_t, std::unique_ptr<NegotiatedEntry>>
+      negotiated_codecs_;
+};
+
 static bool FindByUriAndEncryption(const RtpHeaderExtensions& extensions,
                                    const webrtc::RtpExtension& ext_to_match,
                                    webrtc::RtpExtension* found_extension) {
@@ -1096,15 +1255,16 @@ static void StripCNCodecs(AudioCodecs* audio_codecs) {
 // according to the given session_options.rtcp_mux, session_options.streams,
 // codecs, crypto, and current_streams.  If we don't currently have crypto (in
 // current_cryptos) and it is enabled (in secure_policy), crypto is created
-// (according to crypto_suites). The codecs, rtcp_mux, and crypto are all
-// negotiated with the offer. If the negotiation fails, this method returns
-// false.  The created content is added to the offer.
+// (according to crypto_suites). The rtcp_mux and crypto are negotiated with
+// the offer, and |negotiated_codecs| is the result of negotiating our codecs
+// with the offer's. If the negotiation fails, this method returns false.  The
+// created content is added to the offer.
 template <class C>
 static bool CreateMediaContentAnswer(
     const MediaContentDescriptionImpl<C>* offer,
     const MediaDescriptionOptions& media_description_options,
     const MediaSessionOptions& session_options,
-    const std::vector<C>& local_codecs,
+    const std::vector<C>& negotiated_codecs,
     const SecurePolicy& sdes_policy,
     const CryptoParamsVec* current_cryptos,
     const RtpHeaderExtensions& local_rtp_extenstions,
@@ -1112,8 +1272,6 @@ static bool CreateMediaContentAnswer(
     StreamParamsVec* current_streams,
     bool bundle_enabled,
     MediaContentDescriptionImpl<C>* answer) {
-  std::vector<C> negotiated_codecs;
-  NegotiateCodecs(local_codecs, offer->codecs(), &negotiated_codecs);
   answer->AddCodecs(negotiated_codecs);
   answer->set_protocol(offer->protocol());
   RtpHeaderExtensions negotiated_rtp_extensions;
@@ -1363,6 +1521,9 @@ SessionDescription* MediaSessionDescriptionFactory::CreateOffer(
                session_options.media_description_options.size());
   }
 
+  CodecCache<AudioCodec> audio_codec_cache(offer_audio_codecs);
+  CodecCache<VideoCodec> video_codec_cache(offer_video_codecs);
+
   // Iterate through the media description options, matching with existing media
   // descriptions in |current_description|.
   int msection_index = 0;
@@ -1381,7 +1542,7 @@ SessionDescription* MediaSessionDescriptionFactory::CreateOffer(
       case MEDIA_TYPE_AUDIO:
         if (!AddAudioContentForOffer(media_description_options, session_options,
                                      current_content, current_description,
-                                     audio_rtp_extensions, offer_audio_codecs,
+                                     audio_rtp_extensions, &audio_codec_cache,
                                      &current_streams, offer.get())) {
           return nullptr;
         }
@@ -1389,7 +1550,7 @@ SessionDescription* MediaSessionDescriptionFactory::CreateOffer(
       case MEDIA_TYPE_VIDEO:
         if (!AddVideoContentForOffer(media_description_options, session_options,
                                      current_content, current_description,
-                                     video_rtp_extensions, offer_video_codecs,
+                                     video_rtp_extensions, &video_codec_cache,
                                      &current_streams, offer.get())) {
           return nullptr;
         }
@@ -1474,6 +1635,9 @@ SessionDescription* MediaSessionDescriptionFactory::CreateAnswer(
   FilterDataCodecs(&answer_data_codecs,
                    session_options.data_channel_type == DCT_SCTP);
 
+  CodecCache<AudioCodec> audio_codec_cache(answer_audio_codecs);
+  CodecCache<VideoCodec> video_codec_cache(answer_video_codecs);
+
   // Must have options for exactly as many sections as in the offer.
   RTC_DCHECK(offer->contents().size() ==
              session_options.media_description_options.size());
@@ -1499,7 +1663,7 @@ SessionDescription* MediaSessionDescriptionFactory::CreateAnswer(
         if (!AddAudioContentForAnswer(
                 media_description_options, session_options, offer_content,
                 offer, current_content, current_description,
-                bundle_transport.get(), answer_audio_codecs, &current_streams,
+                bundle_transport.get(), &audio_codec_cache, &current_streams,
                 answer.get())) {
           return nullptr;
         }
@@ -1508,7 +1672,7 @@ SessionDescription* MediaSessionDescriptionFactory::CreateAnswer(
         if (!AddVideoContentForAnswer(
                 media_description_options, session_options, offer_content,
                 offer, current_content, current_description,
-                bundle_transport.get(), answer_video_codecs, &current_streams,
+                bundle_transport.get(), &video_codec_cache, &current_streams,
                 answer.get())) {
           return nullptr;
         }
@@ -1595,19 +1759,28 @@ void MergeCodecsFromDescription(const SessionDescription* description,
                                 DataCodecs* data_codecs,
                                 UsedPayloadTypes* used_pltypes) {
   RTC_DCHECK(description);
+  std::unordered_multimap<size_t, const AudioCodecs*> merged_audio_codecs;
+  std::unordered_multimap<size_t, const VideoCodecs*> merged_video_codecs;
+  std::unordered_multimap<size_t, const DataCodecs*> merged_data_codecs;
   for (const ContentInfo& content : description->contents()) {
     if (IsMediaContentOfType(&content, MEDIA_TYPE_AUDIO)) {
       const AudioContentDescription* audio =
           static_cast<AudioContentDescription*>(content.description);
-      MergeCodecs<AudioCodec>(audio->codecs(), audio_codecs, used_pltypes);
+      if (!FindOrAddCodecList(audio->codecs(), &merged_audio_codecs)) {
+        MergeCodecs<AudioCodec>(audio->codecs(), audio_codecs, used_pltypes);
+      }
     } else if (IsMediaContentOfType(&content, MEDIA_TYPE_VIDEO)) {
       const VideoContentDescription* video =
           static_cast<VideoContentDescription*>(content.description);
-      MergeCodecs<VideoCodec>(video->codecs(), video_codecs, used_pltypes);
+      if (!FindOrAddCodecList(video->codecs(), &merged_video_codecs)) {
+        MergeCodecs<VideoCodec>(video->codecs(), video_codecs, used_pltypes);
+      }
     } else if (IsMediaContentOfType(&content, MEDIA_TYPE_DATA)) {
       const DataContentDescription* data =
           static_cast<DataContentDescription*>(content.description);
-      MergeCodecs<DataCodec>(data->codecs(), data_codecs, used_pltypes);
+      if (!FindOrAddCodecList(data->codecs(), &merged_data_codecs)) {
+        MergeCodecs<DataCodec>(data->codecs(), data_codecs, used_pltypes);
+      }
     }
   }
 }
@@ -1672,10 +1845,16 @@ void MediaSessionDescriptionFactory::GetCodecsForAnswer(
   AudioCodecs filtered_offered_audio_codecs;
   VideoCodecs filtered_offered_video_codecs;
   DataCodecs filtered_offered_data_codecs;
+  std::unordered_multimap<size_t, const AudioCodecs*> offered_audio_codecs;
+  std::unordered_multimap<size_t, const VideoCodecs*> offered_video_codecs;
+  std::unordered_multimap<size_t, const DataCodecs*> offered_data_codecs;
   for (const ContentInfo& content : remote_offer->contents()) {
     if (IsMediaContentOfType(&content, MEDIA_TYPE_AUDIO)) {
       const AudioContentDescription* audio =
           static_cast<AudioContentDescription*>(content.description);
+      if (FindOrAddCodecList(audio->codecs(), &offered_audio_codecs)) {
+        continue;
+      }
       for (const AudioCodec& offered_audio_codec : audio->codecs()) {
         if (!FindMatchingCodec<AudioCodec>(audio->codecs(),
                                            filtered_offered_audio_codecs,
@@ -1688,6 +1867,9 @@ void MediaSessionDescriptionFactory::GetCodecsForAnswer(
     } else if (IsMediaContentOfType(&content, MEDIA_TYPE_VIDEO)) {
       const VideoContentDescription* video =
           static_cast<VideoContentDescription*>(content.description);
+      if (FindOrAddCodecList(video->codecs(), &offered_video_codecs)) {
+        continue;
+      }
       for (const VideoCodec& offered_video_codec : video->codecs()) {
         if (!FindMatchingCodec<VideoCodec>(video->codecs(),
                                            filtered_offered_video_codecs,
@@ -1700,6 +1882,9 @@ void MediaSessionDescriptionFactory::GetCodecsForAnswer(
     } else if (IsMediaContentOfType(&content, MEDIA_TYPE_DATA)) {
       const DataContentDescription* data =
           static_cast<DataContentDescription*>(content.description);
+      if (FindOrAddCodecList(data->codecs(), &offered_data_codecs)) {
+        continue;
+      }
       for (const DataCodec& offered_data_codec : data->codecs()) {
         if (!FindMatchingCodec<DataCodec>(data->codecs(),
                                           filtered_offered_data_codecs,
@@ -1843,40 +2028,17 @@ bool MediaSessionDescriptionFactory::AddAudioContentForOffer(
     const ContentInfo* current_content,
     const SessionDescription* current_description,
     const RtpHeaderExtensions& audio_rtp_extensions,
-    const AudioCodecs& audio_codecs,
+    CodecCache<AudioCodec>* audio_codec_cache,
     StreamParamsVec* current_streams,
     SessionDescription* desc) const {
-  // Filter audio_codecs (which includes all codecs, with correctly remapped
-  // payload types) based on transceiver direction.
+  // Filter the session's audio codecs (which includes all codecs, with
+  // correctly remapped payload types) based on transceiver direction.
   const AudioCodecs& supported_audio_codecs =
       GetAudioCodecsForOffer(media_description_options.direction);
-
-  AudioCodecs filtered_codecs;
-  // Add the codecs from current content if exists.
-  if (current_content) {
-    RTC_DCHECK(IsMediaContentOfType(current_content, MEDIA_TYPE_AUDIO));
-    const AudioContentDescription* acd =
-        static_cast<const AudioContentDescription*>(
-            current_content->description);
-    for (const AudioCodec& codec : acd->codecs()) {
-      if (FindMatchingCodec<AudioCodec>(supported_audio_codecs, audio_codecs,
-                                        codec, nullptr)) {
-        filtered_codecs.push_back(codec);
-      }
-    }
-  }
-  // Add other supported audio codecs.
-  AudioCodec found_codec;
-  for (const AudioCodec& codec : supported_audio_codecs) {
-    if (FindMatchingCodec<AudioCodec>(supported_audio_codecs, audio_codecs,
-                                      codec, &found_codec) &&
-        !FindMatchingCodec<AudioCodec>(supported_audio_codecs, filtered_codecs,
-                                       codec, nullptr)) {
-      // Use the |found_codec| from |audio_codecs| because it has the correctly
-      // mapped payload type.
-      filtered_codecs.push_back(found_codec);
-    }
-  }
+  RTC_DCHECK(!current_content ||
+             IsMediaContentOfType(current_content, MEDIA_TYPE_AUDIO));
+  const AudioCodecs& filtered_codecs = audio_codec_cache->MediaSectionCodecs(
+      supported_audio_codecs, current_content);
 
   cricket::SecurePolicy sdes_policy =
       IsDtlsActive(current_content, current_description) ? cricket::SEC_DISABLED
@@ -1917,7 +2079,7 @@ bool MediaSessionDescriptionFactory::AddVideoContentForOffer(
     const ContentInfo* current_content,
     const SessionDescription* current_description,
     const RtpHeaderExtensions& video_rtp_extensions,
-    const VideoCodecs& video_codecs,
+    CodecCache<VideoCodec>* video_codec_cache,
     StreamParamsVec* current_streams,
     SessionDescription* desc) const {
   cricket::SecurePolicy sdes_policy =
@@ -1929,32 +2091,10 @@ bool MediaSessionDescriptionFactory::AddVideoContentForOffer(
   GetSupportedVideoSdesCryptoSuiteNames(session_options.crypto_options,
                                         &crypto_suites);
 
-  VideoCodecs filtered_codecs;
-  // Add the codecs from current content if exists.
-  if (current_content) {
-    RTC_DCHECK(IsMediaContentOfType(current_content, MEDIA_TYPE_VIDEO));
-    const VideoContentDescription* vcd =
-        static_cast<const VideoContentDescription*>(
-            current_content->description);
-    for (const VideoCodec& codec : vcd->codecs()) {
-      if (FindMatchingCodec<VideoCodec>(video_codecs_, video_codecs, codec,
-                                        nullptr)) {
-        filtered_codecs.push_back(codec);
-      }
-    }
-  }
-  // Add other supported video codecs.
-  VideoCodec found_codec;
-  for (const VideoCodec& codec : video_codecs_) {
-    if (FindMatchingCodec<VideoCodec>(video_codecs_, video_codecs, codec,
-                                      &found_codec) &&
-        !FindMatchingCodec<VideoCodec>(video_codecs_, filtered_codecs, codec,
-                                       nullptr)) {
-      // Use the |found_codec| from |video_codecs| because it has the correctly
-      // mapped payload type.
-      filtered_codecs.push_back(found_codec);
-    }
-  }
+  RTC_DCHECK(!current_content ||
+             IsMediaContentOfType(current_content, MEDIA_TYPE_VIDEO));
+  const VideoCodecs& filtered_codecs =
+      video_codec_cache->MediaSectionCodecs(video_codecs_, current_content);
 
   if (!CreateMediaContentOffer(
           media_description_options.sender_options, session_options,
@@ -2068,7 +2208,7 @@ bool MediaSessionDescriptionFactory::AddAudioContentForAnswer(
     const ContentInfo* current_content,
     const SessionDescription* current_description,
     const TransportInfo* bundle_transport,
-    const AudioCodecs& audio_codecs,
+    CodecCache<AudioCodec>* audio_codec_cache,
     StreamParamsVec* current_streams,
     SessionDescription* answer) const {
   const AudioContentDescription* offer_audio_description =
@@ -2089,35 +2229,12 @@ bool MediaSessionDescriptionFactory::AddAudioContentForAnswer(
   auto offer_rtd = RtpTransceiverDirection::FromMediaContentDirection(
       offer_audio_description->direction());
   auto answer_rtd = NegotiateRtpTransceiverDirection(offer_rtd, wants_rtd);
-  AudioCodecs supported_audio_codecs =
+  const AudioCodecs& supported_audio_codecs =
       GetAudioCodecsForAnswer(offer_rtd, answer_rtd);
-
-  AudioCodecs filtered_codecs;
-  // Add the codecs from current content if exists.
-  if (current_content) {
-    RTC_DCHECK(IsMediaContentOfType(current_content, MEDIA_TYPE_AUDIO));
-    const AudioContentDescription* acd =
-        static_cast<const AudioContentDescription*>(
-            current_content->description);
-    for (const AudioCodec& codec : acd->codecs()) {
-      if (FindMatchingCodec<AudioCodec>(supported_audio_codecs, audio_codecs,
-                                        codec, nullptr)) {
-        filtered_codecs.push_back(codec);
-      }
-    }
-  }
-  // Add other supported audio codecs.
-  AudioCodec found_codec;
-  for (const AudioCodec& codec : supported_audio_codecs) {
-    if (FindMatchingCodec<AudioCodec>(supported_audio_codecs, audio_codecs,
-                                      codec, &found_codec) &&
-        !FindMatchingCodec<AudioCodec>(supported_audio_codecs, filtered_codecs,
-                                       codec, nullptr)) {
-      // Use the |found_codec| from |audio_codecs| because it has the correctly
-      // mapped payload type.
-      filtered_codecs.push_back(found_codec);
-    }
-  }
+  RTC_DCHECK(!current_content ||
+             IsMediaContentOfType(current_content, MEDIA_TYPE_AUDIO));
+  const AudioCodecs& filtered_codecs = audio_codec_cache->MediaSectionCodecs(
+      supported_audio_codecs, current_content);
 
   bool bundle_enabled = offer_description->HasGroup(GROUP_TYPE_BUNDLE) &&
                         session_options.bundle_enabled;
@@ -2128,7 +2245,9 @@ bool MediaSessionDescriptionFactory::AddAudioContentForAnswer(
       audio_transport->secure() ? cricket::SEC_DISABLED : secure();
   if (!CreateMediaContentAnswer(
           offer_audio_description, media_description_options, session_options,
-          filtered_codecs, sdes_policy, GetCryptos(current_content),
+          audio_codec_cache->NegotiatedCodecs(
+              filtered_codecs, offer_audio_description->codecs()),
+          sdes_policy, GetCryptos(current_content),
           audio_rtp_extensions_, enable_encrypted_rtp_header_extensions_,
           current_streams, bundle_enabled, audio_answer.get())) {
     return false;  // Fails the session setup.
@@ -2161,7 +2280,7 @@ bool MediaSessionDescriptionFactory::AddVideoContentForAnswer(
     const ContentInfo* current_content,
     const SessionDescription* current_description,
     const TransportInfo* bundle_transport,
-    const VideoCodecs& video_codecs,
+    CodecCache<VideoCodec>* video_codec_cache,
     StreamParamsVec* current_streams,
     SessionDescription* answer) const {
   const VideoContentDescription* offer_video_description =
@@ -2175,32 +2294,10 @@ bool MediaSessionDescriptionFactory::AddVideoContentForAnswer(
     return false;
   }
 
-  VideoCodecs filtered_codecs;
-  // Add the codecs from current content if exists.
-  if (current_content) {
-    RTC_DCHECK(IsMediaContentOfType(current_content, MEDIA_TYPE_VIDEO));
-    const VideoContentDescription* vcd =
-        static_cast<const VideoContentDescription*>(
-            current_content->description);
-    for (const VideoCodec& codec : vcd->codecs()) {
-      if (FindMatchingCodec<VideoCodec>(video_codecs_, video_codecs, codec,
-                                        nullptr)) {
-        filtered_codecs.push_back(codec);
-      }
-    }
-  }
-  // Add other supported video codecs.
-  VideoCodec found_codec;
-  for (const VideoCodec& codec : video_codecs_) {
-    if (FindMatchingCodec<VideoCodec>(video_codecs_, video_codecs, codec,
-                                      &found_codec) &&
-        !FindMatchingCodec<VideoCodec>(video_codecs_, filtered_codecs, codec,
-                                       nullptr)) {
-      // Use the |found_codec| from |video_codecs| because it has the correctly
-      // mapped payload type.
-      filtered_codecs.push_back(found_codec);
-    }
-  }
+  RTC_DCHECK(!current_content ||
+             IsMediaContentOfType(current_content, MEDIA_TYPE_VIDEO));
+  const VideoCodecs& filtered_codecs =
+      video_codec_cache->MediaSectionCodecs(video_codecs_, current_content);
 
   bool bundle_enabled = offer_description->HasGroup(GROUP_TYPE_BUNDLE) &&
                         session_options.bundle_enabled;
@@ -2212,7 +2309,9 @@ bool MediaSessionDescriptionFactory::AddVideoContentForAnswer(
       video_transport->secure() ? cricket::SEC_DISABLED : secure();
   if (!CreateMediaContentAnswer(
           offer_video_description, media_description_options, session_options,
-          filtered_codecs, sdes_policy, GetCryptos(current_content),
+          video_codec_cache->NegotiatedCodecs(
+              filtered_codecs, offer_video_description->codecs()),
+          sdes_policy, GetCryptos(current_content),
           video_rtp_extensions_, enable_encrypted_rtp_header_extensions_,
           current_streams, bundle_enabled, video_answer.get())) {
     return false;  // Failed the sessin setup.
@@ -2264,19 +2363,20 @@ bool MediaSessionDescriptionFactory::AddDataContentForAnswer(
       data_transport->secure() ? cricket::SEC_DISABLED : secure();
   bool bundle_enabled = offer_description->HasGroup(GROUP_TYPE_BUNDLE) &&
                         session_options.bundle_enabled;
+  const DataContentDescription* offer_data_description =
+      static_cast<const DataContentDescription*>(offer_content->description);
+  DataCodecs negotiated_codecs;
+  NegotiateCodecs(data_codecs, offer_data_description->codecs(),
+                  &negotiated_codecs);
   if (!CreateMediaContentAnswer(
-          static_cast<const DataContentDescription*>(
-              offer_content->description),
-          media_description_options, session_options, data_codecs, sdes_policy,
-          GetCryptos(current_content), RtpHeaderExtensions(),
-          enable_encrypted_rtp_header_extensions_, current_streams,
-          bundle_enabled, data_answer.get())) {
+          offer_data_description, media_description_options, session_options,
+          negotiated_codecs, sdes_policy, GetCryptos(current_content),
+          RtpHeaderExtensions(), enable_encrypted_rtp_header_extensions_,
+          current_streams, bundle_enabled, data_answer.get())) {
     return false;  // Fails the session setup.
   }
 
   // Respond with sctpmap if the offer uses sctpmap.
-  const DataContentDescription* offer_data_description =
-      static_cast<const DataContentDescription*>(offer_content->description);
   bool offer_uses_sctpmap = offer_data_description->use_sctpmap();
   data_answer->set_use_sctpmap(offer_uses_sctpmap);
 
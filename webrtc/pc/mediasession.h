@@ -473,6 +473,11 @@ class MediaSessionDescriptionFactory {
       const SessionDescription* current_description) const;
 
  private:
+  // Memoizes the codec lists computed for each m= section during one call to
+  // CreateOffer or CreateAnswer. Defined in mediasession.cc.
+  template <class C>
+  class CodecCache;
+
   const AudioCodecs& GetAudioCodecsForOffer(
       const RtpTransceiverDirection& direction) const;
   const AudioCodecs& GetAudioCodecsForAnswer(
@@ -518,7 +523,7 @@ class MediaSessionDescriptionFactory {
       const ContentInfo* current_content,
       const SessionDescription* current_description,
       const RtpHeaderExtensions& audio_rtp_extensions,
-      const AudioCodecs& audio_codecs,
+      CodecCache<AudioCodec>* audio_codec_cache,
       StreamParamsVec* current_streams,
       SessionDescription* desc) const;
 
@@ -528,7 +533,7 @@ class MediaSessionDescriptionFactory {
       const ContentInfo* current_content,
       const SessionDescription* current_description,
       const RtpHeaderExtensions& video_rtp_extensions,
-      const VideoCodecs& video_codecs,
+      CodecCache<VideoCodec>* video_codec_cache,
       StreamParamsVec* current_streams,
       SessionDescription* desc) const;
 
@@ -549,7 +554,7 @@ class MediaSessionDescriptionFactory {
       const ContentInfo* current_content,
       const SessionDescription* current_description,
       const TransportInfo* bundle_transport,
-      const AudioCodecs& audio_codecs,
+      CodecCache<AudioCodec>* audio_codec_cache,
       StreamParamsVec* current_streams,
       SessionDescription* answer) const;
 
@@ -561,7 +566,7 @@ class MediaSessionDescriptionFactory {
       const ContentInfo* current_content,
       const SessionDescription* current_description,
       const TransportInfo* bundle_transport,
-      const VideoCodecs& video_codecs,
+      CodecCache<VideoCodec>* video_codec_cache,
       StreamParamsVec* current_streams,
       SessionDescription* answer) const;
 
@@ -24,6 +24,9 @@
 #include "webrtc/rtc_base/gunit.h"
 #include "webrtc/rtc_base/messagedigest.h"
 #include "webrtc/rtc_base/ssladapter.h"
+#include "webrtc/rtc_base/stringencode.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
 
 #define ASSERT_CRYPTO(cd, s, cs) \
     ASSERT_EQ(s, cd->cryptos().size()); \
@@ -3345,6 +3348,179 @@ TEST_F(MediaSessionDescriptionFactoryTest,
   EXPECT_EQ(video_codecs, vcd2->codecs());
 }
 
+// Test that m= sections with different directions get the codecs for their
+// own direction when they are created in the same offer.
+TEST_F(MediaSessionDescriptionFactoryTest,
+       CreateOfferWithMixedDirectionsUsesCodecsPerSection) {
+  f1_.set_audio_codecs(MAKE_VECTOR(kAudioCodecs1), MAKE_VECTOR(kAudioCodecs2));
+  MediaSessionOptions opts;
+  AddMediaSection(MEDIA_TYPE_AUDIO, "audio1", cricket::MD_SENDONLY, kActive,
+                  &opts);
+  AddMediaSection(MEDIA_TYPE_AUDIO, "audio2", cricket::MD_RECVONLY, kActive,
+                  &opts);
+  AddMediaSection(MEDIA_TYPE_AUDIO, "audio3", cricket::MD_SENDONLY, kActive,
+                  &opts);
+  std::unique_ptr<SessionDescription> offer(f1_.CreateOffer(opts, nullptr));
+  ASSERT_TRUE(offer);
+  ASSERT_EQ(3u, offer->contents().size());
+
+  MediaSessionOptions recv_opts;
+  AddMediaSection(MEDIA_TYPE_AUDIO, "audio2", cricket::MD_RECVONLY, kActive,
+                  &recv_opts);
+  std::unique_ptr<SessionDescription> recv_offer(
+      f1_.CreateOffer(recv_opts, nullptr));
+  ASSERT_TRUE(recv_offer);
+
+  auto codecs = [](const SessionDescription* desc, size_t index) {
+    return static_cast<const AudioContentDescription*>(
+               desc->contents()[index].description)
+        ->codecs();
+  };
+  EXPECT_EQ(codecs(offer.get(), 0), codecs(offer.get(), 2));
+  EXPECT_NE(codecs(offer.get(), 0), codecs(offer.get(), 1));
+  EXPECT_EQ(codecs(recv_offer.get(), 0), codecs(offer.get(), 1));
+}
+
+// Renegotiates sessions with many m= sections, as done by an SFU client each
+// time a participant joins: every round adds an audio and a video section to
+// the previous offer and answer.
+class MediaSessionRenegotiationTest
+    : public MediaSessionDescriptionFactoryTest {
+ public:
+  MediaSessionRenegotiationTest() {
+    const std::vector<AudioCodec> audio_codecs = {
+        AudioCodec(111, "opus", 48000, 0, 2),
+        AudioCodec(103, "ISAC", 16000, 0, 1),
+        AudioCodec(104, "ISAC", 32000, 0, 1),
+        AudioCodec(9, "G722", 8000, 0, 1),
+        AudioCodec(0, "PCMU", 8000, 0, 1),
+        AudioCodec(8, "PCMA", 8000, 0, 1),
+        AudioCodec(106, "CN", 32000, 0, 1),
+        AudioCodec(105, "CN", 16000, 0, 1),
+        AudioCodec(13, "CN", 8000, 0, 1),
+        AudioCodec(126, "telephone-event", 8000, 0, 1)};
+    std::vector<VideoCodec> video_codecs;
+    static const char* const kVideoCodecNames[] = {"VP8", "VP9", "H264", "H264",
+                                                   "red"};
+    for (int i = 0; i < 5; ++i) {
+      VideoCodec codec(96 + 2 * i, kVideoCodecNames[i]);
+      if (i == 2 || i == 3)
+        codec.SetParam(cricket::kH264FmtpPacketizationMode, i - 2);
+      video_codecs.push_back(codec);
+      video_codecs.push_back(VideoCodec::CreateRtxCodec(97 + 2 * i, codec.id));
+    }
+    video_codecs.push_back(VideoCodec(106, "ulpfec"));
+    for (MediaSessionDescriptionFactory* factory : {&f1_, &f2_}) {
+      factory->set_audio_codecs(audio_codecs, audio_codecs);
+      factory->set_video_codecs(video_codecs);
+    }
+    tdf1_.set_secure(SEC_ENABLED);
+    tdf2_.set_secure(SEC_ENABLED);
+  }
+
+ protected:
+  // Adds a sending audio and video section to the offer options, and
+  // receiving ones to the answer options.
+  void AddParticipant() {
+    const int index = num_participants_++;
+    const std::string stream_id = "stream" + rtc::ToString(index);
+    const std::string audio_mid = "audio" + rtc::ToString(index);
+    const std::string video_mid = "video" + rtc::ToString(index);
+    AddMediaSection(MEDIA_TYPE_AUDIO, audio_mid, cricket::MD_SENDONLY,
+                    kActive, &offer_opts_);
+    AttachSenderToMediaSection(audio_mid, MEDIA_TYPE_AUDIO,
+                               "audio_track" + rtc::ToString(index),
+                               {stream_id}, 1, &offer_opts_);
+    AddMediaSection(MEDIA_TYPE_VIDEO, video_mid, cricket::MD_SENDONLY,
+                    kActive, &offer_opts_);
+    AttachSenderToMediaSection(video_mid, MEDIA_TYPE_VIDEO,
+                               "video_track" + rtc::ToString(index),
+                               {stream_id}, 1, &offer_opts_);
+    AddMediaSection(MEDIA_TYPE_AUDIO, audio_mid, cricket::MD_RECVONLY,
+                    kActive, &answer_opts_);
+    AddMediaSection(MEDIA_TYPE_VIDEO, video_mid, cricket::MD_RECVONLY,
+                    kActive, &answer_opts_);
+  }
+
+  // Negotiates a session with at least |num_sections| m= sections.
+  void CreateInitialSession(int num_sections) {
+    offer_opts_ = MediaSessionOptions();
+    answer_opts_ = MediaSessionOptions();
+    num_participants_ = 0;
+    while (2 * num_participants_ < num_sections)
+      AddParticipant();
+    offer_.reset(f1_.CreateOffer(offer_opts_, nullptr));
+    ASSERT_TRUE(offer_);
+    answer_.reset(f2_.CreateAnswer(offer_.get(), answer_opts_, nullptr));
+    ASSERT_TRUE(answer_);
+  }
+
+  MediaSessionOptions offer_opts_;
+  MediaSessionOptions answer_opts_;
+  int num_participants_ = 0;
+  std::unique_ptr<SessionDescription> offer_;
+  std::unique_ptr<SessionDescription> answer_;
+};
+
+TEST_F(MediaSessionRenegotiationTest, EveryRoundAddsAcceptedSections) {
+  ASSERT_NO_FATAL_FAILURE(CreateInitialSession(10));
+  for (int round = 0; round < 3; ++round) {
+    AddParticipant();
+    std::unique_ptr<SessionDescription> new_offer(
+        f1_.CreateOffer(offer_opts_, offer_.get()));
+    ASSERT_TRUE(new_offer);
+    std::unique_ptr<SessionDescription> new_answer(
+        f2_.CreateAnswer(new_offer.get(), answer_opts_, answer_.get()));
+    ASSERT_TRUE(new_answer);
+
+    ASSERT_EQ(static_cast<size_t>(2 * num_participants_),
+              new_answer->contents().size());
+    for (const ContentInfo& content : new_answer->contents())
+      EXPECT_FALSE(content.rejected);
+    offer_ = std::move(new_offer);
+    answer_ = std::move(new_answer);
+  }
+}
+
+// Measures the renegotiation of sessions of growing size. Disabled since it
+// only reports timings; run it with --gtest_also_run_disabled_tests.
+TEST_F(MediaSessionRenegotiationTest, DISABLED_RenegotiationPerformance) {
+  const int kRounds = 5;
+  for (int num_sections : {10, 100, 300}) {
+    ASSERT_NO_FATAL_FAILURE(CreateInitialSession(num_sections));
+
+    int64_t offer_ns = 0;
+    int64_t answer_ns = 0;
+    for (int round = 0; round < kRounds; ++round) {
+      AddParticipant();
+      int64_t start_ns = rtc::SystemTimeNanos();
+      std::unique_ptr<SessionDescription> new_offer(
+          f1_.CreateOffer(offer_opts_, offer_.get()));
+      offer_ns += rtc::SystemTimeNanos() - start_ns;
+      ASSERT_TRUE(new_offer);
+
+      start_ns = rtc::SystemTimeNanos();
+      std::unique_ptr<SessionDescription> new_answer(
+          f2_.CreateAnswer(new_offer.get(), answer_opts_, answer_.get()));
+      answer_ns += rtc::SystemTimeNanos() - start_ns;
+      ASSERT_TRUE(new_answer);
+      offer_ = std::move(new_offer);
+      answer_ = std::move(new_answer);
+    }
+
+    const std::string modifier =
+        "_" + rtc::ToString(num_sections) + "_msections";
+    webrtc::test::PrintResult(
+        "renegotiation_offer", modifier, "",
+        static_cast<size_t>(offer_ns / kRounds / rtc::kNumNanosecsPerMicrosec),
+        "us", false);
+    webrtc::test::PrintResult(
+        "renegotiation_answer", modifier, "",
+        static_cast<size_t>(answer_ns / kRounds / rtc::kNumNanosecsPerMicrosec),
+        "us", false);
+  }
+}
+
 class MediaProtocolTest : public ::testing::TestWithParam<const char*> {
  public:
   MediaProtocolTest() : f1_(&tdf1_), f2_(&tdf2_) {
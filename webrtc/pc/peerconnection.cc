@@ -763,6 +763,24 @@ void PeerConnection::GetStats(RTCStatsCollectorCallback* callback) {
   stats_collector_->GetStatsReport(callback);
 }
 
+void PeerConnection::GetStats(RTCStatsCollectorCallback* callback,
+                              const std::set<std::string>& stats_types) {
+  RTC_DCHECK(stats_collector_);
+  if (stats_types.empty()) {
+    LOG(LS_WARNING) << "GetStats is called without stats types.";
+    stats_collector_->GetStatsReport(callback);
+    return;
+  }
+  stats_collector_->GetStatsReport(stats_types, callback);
+}
+
+void PeerConnection::GetStats(MediaStreamTrackInterface* track,
+                              RTCStatsCollectorCallback* callback) {
+  RTC_DCHECK(stats_collector_);
+  RTC_DCHECK(track);
+  stats_collector_->GetStatsReportForTrack(track->id(), callback);
+}
+
 PeerConnectionInterface::SignalingState PeerConnection::signaling_state() {
   return signaling_state_;
 }
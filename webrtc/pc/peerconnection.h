@@ -86,6 +86,10 @@ class PeerConnection : public PeerConnectionInterface,
                 webrtc::MediaStreamTrackInterface* track,
                 StatsOutputLevel level) override;
   void GetStats(RTCStatsCollectorCallback* callback) override;
+  void GetStats(RTCStatsCollectorCallback* callback,
+                const std::set<std::string>& stats_types) override;
+  void GetStats(MediaStreamTrackInterface* track,
+                RTCStatsCollectorCallback* callback) override;
 
   SignalingState signaling_state() override;
 
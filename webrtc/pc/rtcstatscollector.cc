@@ -10,6 +10,7 @@
 
 #include "webrtc/pc/rtcstatscollector.h"
 
+#include <algorithm>
 #include <memory>
 #include <sstream>
 #include <utility>
@@ -22,6 +23,7 @@
 #include "webrtc/p2p/base/p2pconstants.h"
 #include "webrtc/p2p/base/port.h"
 #include "webrtc/pc/peerconnection.h"
+#include "webrtc/pc/rtcstatstraversal.h"
 #include "webrtc/pc/webrtcsession.h"
 #include "webrtc/rtc_base/checks.h"
 #include "webrtc/rtc_base/stringutils.h"
@@ -575,8 +577,63 @@ void ProduceMediaStreamAndTrackStats(
   }
 }
 
+rtc::scoped_refptr<RTCStatsReport> CopyStatsOfTypes(
+    const RTCStatsReport& report, const std::set<std::string>& stats_types) {
+  rtc::scoped_refptr<RTCStatsReport> result =
+      RTCStatsReport::Create(report.timestamp_us());
+  for (const RTCStats& stats : report) {
+    if (stats_types.find(stats.type()) != stats_types.end())
+      result->AddStats(stats.copy());
+  }
+  return result;
+}
+
+// Selects the stats of the track with ID |track_id|, the RTP streams that
+// reference it and everything they reference in turn.
+rtc::scoped_refptr<RTCStatsReport> CopyStatsOfTrack(
+    const RTCStatsReport& report, const std::string& track_id) {
+  std::vector<std::string> track_stats_ids;
+  for (const RTCMediaStreamTrackStats* track_stats :
+       report.GetStatsOfType<RTCMediaStreamTrackStats>()) {
+    if (track_stats->track_identifier.is_defined() &&
+        *track_stats->track_identifier == track_id) {
+      track_stats_ids.push_back(track_stats->id());
+    }
+  }
+  // RTP streams reference their track, not the other way around.
+  std::vector<const RTCRTPStreamStats*> rtp_stream_stats;
+  for (const RTCInboundRTPStreamStats* inbound_stats :
+       report.GetStatsOfType<RTCInboundRTPStreamStats>()) {
+    rtp_stream_stats.push_back(inbound_stats);
+  }
+  for (const RTCOutboundRTPStreamStats* outbound_stats :
+       report.GetStatsOfType<RTCOutboundRTPStreamStats>()) {
+    rtp_stream_stats.push_back(outbound_stats);
+  }
+  std::vector<std::string> ids = track_stats_ids;
+  for (const RTCRTPStreamStats* stats : rtp_stream_stats) {
+    if (stats->track_id.is_defined() &&
+        std::find(track_stats_ids.begin(), track_stats_ids.end(),
+                  *stats->track_id) != track_stats_ids.end()) {
+      ids.push_back(stats->id());
+    }
+  }
+  return CopyReferencedStats(report, ids);
+}
+
 }  // namespace
 
+RTCStatsCollector::RequestInfo::RequestInfo(
+    rtc::scoped_refptr<RTCStatsCollectorCallback> callback,
+    const std::set<std::string>& stats_types,
+    const std::string& track_id)
+    : callback(callback), stats_types(stats_types), track_id(track_id) {}
+
+RTCStatsCollector::RequestInfo::RequestInfo(const RequestInfo& other) =
+    default;
+
+RTCStatsCollector::RequestInfo::~RequestInfo() = default;
+
 rtc::scoped_refptr<RTCStatsCollector> RTCStatsCollector::Create(
     PeerConnection* pc, int64_t cache_lifetime_us) {
   return rtc::scoped_refptr<RTCStatsCollector>(
@@ -608,31 +665,80 @@ RTCStatsCollector::~RTCStatsCollector() {
 
 void RTCStatsCollector::GetStatsReport(
     rtc::scoped_refptr<RTCStatsCollectorCallback> callback) {
+  GetStatsReportInternal(
+      RequestInfo(callback, std::set<std::string>(), std::string()));
+}
+
+void RTCStatsCollector::GetStatsReport(
+    const std::set<std::string>& stats_types,
+    rtc::scoped_refptr<RTCStatsCollectorCallback> callback) {
+  RTC_DCHECK(!stats_types.empty());
+  GetStatsReportInternal(RequestInfo(callback, stats_types, std::string()));
+}
+
+void RTCStatsCollector::GetStatsReportForTrack(
+    const std::string& track_id,
+    rtc::scoped_refptr<RTCStatsCollectorCallback> callback) {
+  RTC_DCHECK(!track_id.empty());
+  GetStatsReportInternal(
+      RequestInfo(callback, std::set<std::string>(), track_id));
+}
+
+void RTCStatsCollector::GetStatsReportInternal(const RequestInfo& request) {
   RTC_DCHECK(signaling_thread_->IsCurrent());
-  RTC_DCHECK(callback);
-  callbacks_.push_back(callback);
+  RTC_DCHECK(request.callback);
+  requests_.push_back(request);
 
   // "Now" using a monotonically increasing timer.
   int64_t cache_now_us = rtc::TimeMicros();
   if (cached_report_ &&
-      cache_now_us - cache_timestamp_us_ <= cache_lifetime_us_) {
+      cache_now_us - cache_timestamp_us_ <= cache_lifetime_us_ &&
+      CachedReportCovers(request.stats_types)) {
     // We have a fresh cached report to deliver.
     DeliverCachedReport();
   } else if (!num_pending_partial_reports_) {
     // Only start gathering stats if we're not already gathering stats. In the
-    // case of already gathering stats, |callback_| will be invoked when there
-    // are no more pending partial reports.
-
-    // "Now" using a system clock, relative to the UNIX epoch (Jan 1, 1970,
-    // UTC), in microseconds. The system clock could be modified and is not
-    // necessarily monotonically increasing.
-    int64_t timestamp_us = rtc::TimeUTCMicros();
-
-    num_pending_partial_reports_ = 2;
-    partial_report_timestamp_us_ = cache_now_us;
+    // case of already gathering stats, |request| is served when there are no
+    // more pending partial reports.
+    StartGathering(cache_now_us);
+  }
+}
 
-    // Prepare |channel_name_pairs_| for use in
-    // |ProducePartialResultsOnNetworkThread|.
+void RTCStatsCollector::StartGathering(int64_t cache_now_us) {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  RTC_DCHECK(!num_pending_partial_reports_);
+  RTC_DCHECK(!requests_.empty());
+  // Gather the union of the stats types of the pending requests.
+  requested_stats_types_.clear();
+  for (const RequestInfo& request : requests_) {
+    if (request.stats_types.empty()) {
+      requested_stats_types_.clear();
+      break;
+    }
+    requested_stats_types_.insert(request.stats_types.begin(),
+                                  request.stats_types.end());
+  }
+  bool network_stats_requested = IsAnyStatsTypeRequested({
+      RTCCertificateStats::kType, RTCCodecStats::kType,
+      RTCIceCandidatePairStats::kType, RTCLocalIceCandidateStats::kType,
+      RTCRemoteIceCandidateStats::kType, RTCInboundRTPStreamStats::kType,
+      RTCOutboundRTPStreamStats::kType, RTCTransportStats::kType});
+  bool media_info_requested = IsAnyStatsTypeRequested({
+      RTCCodecStats::kType, RTCInboundRTPStreamStats::kType,
+      RTCOutboundRTPStreamStats::kType, RTCMediaStreamStats::kType,
+      RTCMediaStreamTrackStats::kType});
+
+  // "Now" using a system clock, relative to the UNIX epoch (Jan 1, 1970,
+  // UTC), in microseconds. The system clock could be modified and is not
+  // necessarily monotonically increasing.
+  int64_t timestamp_us = rtc::TimeUTCMicros();
+
+  num_pending_partial_reports_ = network_stats_requested ? 2 : 1;
+  partial_report_timestamp_us_ = cache_now_us;
+
+  // Prepare |channel_name_pairs_| for use in
+  // |ProducePartialResultsOnNetworkThread|.
+  if (network_stats_requested) {
     channel_name_pairs_.reset(new ChannelNamePairs());
     if (pc_->session()->voice_channel()) {
       channel_name_pairs_->voice = rtc::Optional<ChannelNamePair>(
@@ -655,32 +761,43 @@ void RTCStatsCollector::GetStatsReport(
           ChannelNamePair(*pc_->session()->sctp_content_name(),
                           *pc_->session()->sctp_transport_name()));
     }
-    // Prepare |track_media_info_map_| for use in
-    // |ProducePartialResultsOnNetworkThread| and
-    // |ProducePartialResultsOnSignalingThread|.
+  }
+  // Prepare |track_media_info_map_| for use in
+  // |ProducePartialResultsOnNetworkThread| and
+  // |ProducePartialResultsOnSignalingThread|. Getting the stats of the voice
+  // and video channels hops to the worker thread, so it is skipped if no stats
+  // that depend on them were asked for.
+  if (media_info_requested) {
     track_media_info_map_.reset(PrepareTrackMediaInfoMap_s().release());
-    // Prepare |track_to_id_| for use in |ProducePartialResultsOnNetworkThread|.
-    // This avoids a possible deadlock if |MediaStreamTrackInterface::id| is
-    // implemented to invoke on the signaling thread.
+    // Prepare |track_to_id_| for use in
+    // |ProducePartialResultsOnNetworkThread|. This avoids a possible deadlock
+    // if |MediaStreamTrackInterface::id| is implemented to invoke on the
+    // signaling thread.
     track_to_id_ = PrepareTrackToID_s();
+  }
 
-    // Prepare |call_stats_| here since GetCallStats() will hop to the worker
-    // thread.
-    // TODO(holmer): To avoid the hop we could move BWE and BWE stats to the
-    // network thread, where it more naturally belongs.
+  // Prepare |call_stats_| here since GetCallStats() will hop to the worker
+  // thread.
+  // TODO(holmer): To avoid the hop we could move BWE and BWE stats to the
+  // network thread, where it more naturally belongs.
+  if (IsAnyStatsTypeRequested({RTCIceCandidatePairStats::kType}))
     call_stats_ = pc_->session()->GetCallStats();
+  else
+    call_stats_ = Call::Stats();
 
+  if (network_stats_requested) {
     invoker_.AsyncInvoke<void>(
         RTC_FROM_HERE, network_thread_,
         rtc::Bind(&RTCStatsCollector::ProducePartialResultsOnNetworkThread,
                   rtc::scoped_refptr<RTCStatsCollector>(this), timestamp_us));
-    ProducePartialResultsOnSignalingThread(timestamp_us);
   }
+  ProducePartialResultsOnSignalingThread(timestamp_us);
 }
 
 void RTCStatsCollector::ClearCachedStatsReport() {
   RTC_DCHECK(signaling_thread_->IsCurrent());
   cached_report_ = nullptr;
+  cached_report_stats_types_.clear();
 }
 
 void RTCStatsCollector::WaitForPendingRequest() {
@@ -700,9 +817,14 @@ void RTCStatsCollector::ProducePartialResultsOnSignalingThread(
   rtc::scoped_refptr<RTCStatsReport> report = RTCStatsReport::Create(
       timestamp_us);
 
-  ProduceDataChannelStats_s(timestamp_us, report.get());
-  ProduceMediaStreamAndTrackStats_s(timestamp_us, report.get());
-  ProducePeerConnectionStats_s(timestamp_us, report.get());
+  if (IsAnyStatsTypeRequested({RTCDataChannelStats::kType}))
+    ProduceDataChannelStats_s(timestamp_us, report.get());
+  if (IsAnyStatsTypeRequested(
+          {RTCMediaStreamStats::kType, RTCMediaStreamTrackStats::kType})) {
+    ProduceMediaStreamAndTrackStats_s(timestamp_us, report.get());
+  }
+  if (IsAnyStatsTypeRequested({RTCPeerConnectionStats::kType}))
+    ProducePeerConnectionStats_s(timestamp_us, report.get());
 
   AddPartialResults(report);
 }
@@ -716,20 +838,38 @@ void RTCStatsCollector::ProducePartialResultsOnNetworkThread(
   std::unique_ptr<SessionStats> session_stats =
       pc_->session()->GetStats(*channel_name_pairs_);
   if (session_stats) {
-    std::map<std::string, CertificateStatsPair> transport_cert_stats =
-        PrepareTransportCertificateStats_n(*session_stats);
-
-    ProduceCertificateStats_n(
-        timestamp_us, transport_cert_stats, report.get());
-    ProduceCodecStats_n(
-        timestamp_us, *track_media_info_map_, report.get());
-    ProduceIceCandidateAndPairStats_n(timestamp_us, *session_stats,
-                                      track_media_info_map_->video_media_info(),
-                                      call_stats_, report.get());
-    ProduceRTPStreamStats_n(
-        timestamp_us, *session_stats, *track_media_info_map_, report.get());
-    ProduceTransportStats_n(
-        timestamp_us, *session_stats, transport_cert_stats, report.get());
+    std::map<std::string, CertificateStatsPair> transport_cert_stats;
+    if (IsAnyStatsTypeRequested(
+            {RTCCertificateStats::kType, RTCTransportStats::kType})) {
+      transport_cert_stats = PrepareTransportCertificateStats_n(*session_stats);
+    }
+
+    if (IsAnyStatsTypeRequested({RTCCertificateStats::kType})) {
+      ProduceCertificateStats_n(
+          timestamp_us, transport_cert_stats, report.get());
+    }
+    if (IsAnyStatsTypeRequested({RTCCodecStats::kType})) {
+      ProduceCodecStats_n(
+          timestamp_us, *track_media_info_map_, report.get());
+    }
+    if (IsAnyStatsTypeRequested({RTCIceCandidatePairStats::kType,
+                                 RTCLocalIceCandidateStats::kType,
+                                 RTCRemoteIceCandidateStats::kType})) {
+      ProduceIceCandidateAndPairStats_n(
+          timestamp_us, *session_stats,
+          track_media_info_map_ ? track_media_info_map_->video_media_info()
+                                : nullptr,
+          call_stats_, report.get());
+    }
+    if (IsAnyStatsTypeRequested({RTCInboundRTPStreamStats::kType,
+                                 RTCOutboundRTPStreamStats::kType})) {
+      ProduceRTPStreamStats_n(
+          timestamp_us, *session_stats, *track_media_info_map_, report.get());
+    }
+    if (IsAnyStatsTypeRequested({RTCTransportStats::kType})) {
+      ProduceTransportStats_n(
+          timestamp_us, *session_stats, transport_cert_stats, report.get());
+    }
   }
 
   AddPartialResults(report);
@@ -757,8 +897,23 @@ void RTCStatsCollector::AddPartialResults_s(
     partial_report_->TakeMembersFrom(partial_report);
   --num_pending_partial_reports_;
   if (!num_pending_partial_reports_) {
+    // Some producers output more than one stats type, e.g. candidate pairs
+    // and candidates. Drop the types that were not asked for.
+    if (!requested_stats_types_.empty()) {
+      std::vector<std::string> unrequested_ids;
+      for (const RTCStats& stats : *partial_report_) {
+        if (requested_stats_types_.find(stats.type()) ==
+            requested_stats_types_.end()) {
+          unrequested_ids.push_back(stats.id());
+        }
+      }
+      for (const std::string& id : unrequested_ids)
+        partial_report_->Take(id);
+    }
     cache_timestamp_us_ = partial_report_timestamp_us_;
     cached_report_ = partial_report_;
+    cached_report_stats_types_.swap(requested_stats_types_);
+    requested_stats_types_.clear();
     partial_report_ = nullptr;
     channel_name_pairs_.reset();
     track_media_info_map_.reset();
@@ -769,18 +924,59 @@ void RTCStatsCollector::AddPartialResults_s(
     TRACE_EVENT_INSTANT1("webrtc_stats", "webrtc_stats", "report",
                          cached_report_->ToJson());
     DeliverCachedReport();
+    // Requests for stats types that were not part of this report arrived
+    // while it was being gathered.
+    if (!requests_.empty() && !num_pending_partial_reports_)
+      StartGathering(rtc::TimeMicros());
   }
 }
 
 void RTCStatsCollector::DeliverCachedReport() {
   RTC_DCHECK(signaling_thread_->IsCurrent());
-  RTC_DCHECK(!callbacks_.empty());
+  RTC_DCHECK(!requests_.empty());
   RTC_DCHECK(cached_report_);
-  for (const rtc::scoped_refptr<RTCStatsCollectorCallback>& callback :
-       callbacks_) {
-    callback->OnStatsDelivered(cached_report_);
+  // Callbacks may request more stats, so don't iterate over |requests_|.
+  std::vector<RequestInfo> requests;
+  requests.swap(requests_);
+  for (const RequestInfo& request : requests) {
+    if (!CachedReportCovers(request.stats_types)) {
+      requests_.push_back(request);
+      continue;
+    }
+    if (!request.track_id.empty()) {
+      request.callback->OnStatsDelivered(
+          CopyStatsOfTrack(*cached_report_, request.track_id));
+    } else if (request.stats_types != cached_report_stats_types_) {
+      request.callback->OnStatsDelivered(
+          CopyStatsOfTypes(*cached_report_, request.stats_types));
+    } else {
+      request.callback->OnStatsDelivered(cached_report_);
+    }
+  }
+}
+
+bool RTCStatsCollector::CachedReportCovers(
+    const std::set<std::string>& stats_types) const {
+  if (!cached_report_)
+    return false;
+  if (cached_report_stats_types_.empty())
+    return true;
+  if (stats_types.empty())
+    return false;
+  return std::includes(cached_report_stats_types_.begin(),
+                       cached_report_stats_types_.end(),
+                       stats_types.begin(), stats_types.end());
+}
+
+bool RTCStatsCollector::IsAnyStatsTypeRequested(
+    std::initializer_list<const char*> types) const {
+  if (requested_stats_types_.empty())
+    return true;
+  for (const char* type : types) {
+    if (requested_stats_types_.find(type) != requested_stats_types_.end())
+      return true;
   }
-  callbacks_.clear();
+  return false;
 }
 
 void RTCStatsCollector::ProduceCertificateStats_n(
@@ -791,11 +987,11 @@ void RTCStatsCollector::ProduceCertificateStats_n(
   for (const auto& transport_cert_stats_pair : transport_cert_stats) {
     if (transport_cert_stats_pair.second.local) {
       ProduceCertificateStatsFromSSLCertificateStats(
-          timestamp_us, *transport_cert_stats_pair.second.local.get(), report);
+          timestamp_us, *transport_cert_stats_pair.second.local, report);
     }
     if (transport_cert_stats_pair.second.remote) {
       ProduceCertificateStatsFromSSLCertificateStats(
-          timestamp_us, *transport_cert_stats_pair.second.remote.get(), report);
+          timestamp_us, *transport_cert_stats_pair.second.remote, report);
     }
   }
 }
@@ -1165,27 +1361,50 @@ void RTCStatsCollector::ProduceTransportStats_n(
 
 std::map<std::string, RTCStatsCollector::CertificateStatsPair>
 RTCStatsCollector::PrepareTransportCertificateStats_n(
-    const SessionStats& session_stats) const {
+    const SessionStats& session_stats) {
   RTC_DCHECK(network_thread_->IsCurrent());
   std::map<std::string, CertificateStatsPair> transport_cert_stats;
+  // Entries of transports that no longer exist are dropped.
+  std::map<std::string, CachedCertificateStats> cached_certificate_stats;
   for (const auto& transport_stats : session_stats.transport_stats) {
-    CertificateStatsPair certificate_stats_pair;
+    const std::string& transport_name = transport_stats.second.transport_name;
+    CachedCertificateStats& cached = cached_certificate_stats[transport_name];
+    auto previous_it = cached_certificate_stats_.find(transport_name);
+    if (previous_it != cached_certificate_stats_.end())
+      cached = std::move(previous_it->second);
+
     rtc::scoped_refptr<rtc::RTCCertificate> local_certificate;
     if (pc_->session()->GetLocalCertificate(
-        transport_stats.second.transport_name, &local_certificate)) {
-      certificate_stats_pair.local =
-          local_certificate->ssl_certificate().GetStats();
+        transport_name, &local_certificate)) {
+      if (local_certificate != cached.local_certificate) {
+        cached.local = local_certificate->ssl_certificate().GetStats();
+        cached.local_certificate = local_certificate;
+      }
+    } else {
+      cached.local_certificate = nullptr;
+      cached.local.reset();
     }
     std::unique_ptr<rtc::SSLCertificate> remote_certificate =
-        pc_->session()->GetRemoteSSLCertificate(
-            transport_stats.second.transport_name);
+        pc_->session()->GetRemoteSSLCertificate(transport_name);
     if (remote_certificate) {
-      certificate_stats_pair.remote = remote_certificate->GetStats();
+      rtc::Buffer remote_der;
+      remote_certificate->ToDER(&remote_der);
+      if (!cached.remote || remote_der != cached.remote_der) {
+        cached.remote = remote_certificate->GetStats();
+        cached.remote_der = std::move(remote_der);
+      }
+    } else {
+      cached.remote_der.Clear();
+      cached.remote.reset();
     }
+
+    CertificateStatsPair certificate_stats_pair;
+    certificate_stats_pair.local = cached.local.get();
+    certificate_stats_pair.remote = cached.remote.get();
     transport_cert_stats.insert(
-        std::make_pair(transport_stats.second.transport_name,
-                       std::move(certificate_stats_pair)));
+        std::make_pair(transport_name, certificate_stats_pair));
   }
+  cached_certificate_stats_ = std::move(cached_certificate_stats);
   return transport_cert_stats;
 }
 
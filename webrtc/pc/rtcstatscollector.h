@@ -11,9 +11,11 @@
 #ifndef WEBRTC_PC_RTCSTATSCOLLECTOR_H_
 #define WEBRTC_PC_RTCSTATSCOLLECTOR_H_
 
+#include <initializer_list>
 #include <map>
 #include <memory>
 #include <set>
+#include <string>
 #include <vector>
 
 #include "webrtc/api/optional.h"
@@ -25,6 +27,8 @@
 #include "webrtc/pc/datachannel.h"
 #include "webrtc/pc/trackmediainfomap.h"
 #include "webrtc/rtc_base/asyncinvoker.h"
+#include "webrtc/rtc_base/buffer.h"
+#include "webrtc/rtc_base/rtccertificate.h"
 #include "webrtc/rtc_base/refcount.h"
 #include "webrtc/rtc_base/scoped_ref_ptr.h"
 #include "webrtc/rtc_base/sigslot.h"
@@ -61,6 +65,22 @@ class RTCStatsCollector : public virtual rtc::RefCountInterface,
   // considered fresh for |cache_lifetime_| ms. const RTCStatsReports are safe
   // to use across multiple threads and may be destructed on any thread.
   void GetStatsReport(rtc::scoped_refptr<RTCStatsCollectorCallback> callback);
+  // Like |GetStatsReport| above, but the report only contains stats whose
+  // |RTCStats::type| is in |stats_types|, e.g. |RTCTransportStats::kType|.
+  // Only the stats of those types are gathered: if none of them are produced
+  // on the network thread it is not invoked, and the voice and video channels
+  // are only queried for types that depend on their stats. A fresh cached
+  // report that covers |stats_types| is used if there is one.
+  void GetStatsReport(const std::set<std::string>& stats_types,
+                      rtc::scoped_refptr<RTCStatsCollectorCallback> callback);
+  // Gets the stats of the track with ID |track_id|, the RTP streams of the
+  // track and the stats they reference directly or indirectly, such as codecs,
+  // transports, candidate pairs, candidates and certificates. This is the
+  // stats selection algorithm of the spec applied to a track.
+  // https://w3c.github.io/webrtc-pc/#dfn-stats-selection-algorithm
+  void GetStatsReportForTrack(
+      const std::string& track_id,
+      rtc::scoped_refptr<RTCStatsCollectorCallback> callback);
   // Clears the cache's reference to the most recent stats report. Subsequently
   // calling |GetStatsReport| guarantees fresh stats.
   void ClearCachedStatsReport();
@@ -83,13 +103,49 @@ class RTCStatsCollector : public virtual rtc::RefCountInterface,
       const rtc::scoped_refptr<RTCStatsReport>& partial_report);
 
  private:
+  // Points into |cached_certificate_stats_|.
   struct CertificateStatsPair {
+    const rtc::SSLCertificateStats* local = nullptr;
+    const rtc::SSLCertificateStats* remote = nullptr;
+  };
+
+  // The certificate stats of a transport, kept between reports because
+  // computing fingerprints and base64 encoding certificates is expensive. They
+  // are only recomputed when the local certificate object or the DER encoding
+  // of the remote certificate changes.
+  struct CachedCertificateStats {
+    rtc::scoped_refptr<rtc::RTCCertificate> local_certificate;
     std::unique_ptr<rtc::SSLCertificateStats> local;
+    rtc::Buffer remote_der;
     std::unique_ptr<rtc::SSLCertificateStats> remote;
   };
 
+  struct RequestInfo {
+    RequestInfo(rtc::scoped_refptr<RTCStatsCollectorCallback> callback,
+                const std::set<std::string>& stats_types,
+                const std::string& track_id);
+    RequestInfo(const RequestInfo& other);
+    ~RequestInfo();
+
+    rtc::scoped_refptr<RTCStatsCollectorCallback> callback;
+    // The stats types to deliver, or empty for all types.
+    std::set<std::string> stats_types;
+    // If not empty, only the stats selected for this track are delivered.
+    std::string track_id;
+  };
+
+  void GetStatsReportInternal(const RequestInfo& request);
+  // Starts gathering the stats types needed by the pending requests that can
+  // not be served from |cached_report_|.
+  void StartGathering(int64_t cache_now_us);
   void AddPartialResults_s(rtc::scoped_refptr<RTCStatsReport> partial_report);
+  // Delivers |cached_report_|, or the subset of it that was asked for, to the
+  // pending requests that it covers.
   void DeliverCachedReport();
+  // True if |stats_types| is a subset of the types in |cached_report_|.
+  bool CachedReportCovers(const std::set<std::string>& stats_types) const;
+  // True if the gathering in progress produces stats of any of |types|.
+  bool IsAnyStatsTypeRequested(std::initializer_list<const char*> types) const;
 
   // Produces |RTCCertificateStats|.
   void ProduceCertificateStats_n(
@@ -129,7 +185,7 @@ class RTCStatsCollector : public virtual rtc::RefCountInterface,
 
   // Helper function to stats-producing functions.
   std::map<std::string, CertificateStatsPair>
-  PrepareTransportCertificateStats_n(const SessionStats& session_stats) const;
+  PrepareTransportCertificateStats_n(const SessionStats& session_stats);
   std::unique_ptr<TrackMediaInfoMap> PrepareTrackMediaInfoMap_s() const;
   std::map<MediaStreamTrackInterface*, std::string> PrepareTrackToID_s() const;
 
@@ -148,7 +204,7 @@ class RTCStatsCollector : public virtual rtc::RefCountInterface,
   int num_pending_partial_reports_;
   int64_t partial_report_timestamp_us_;
   rtc::scoped_refptr<RTCStatsReport> partial_report_;
-  std::vector<rtc::scoped_refptr<RTCStatsCollectorCallback>> callbacks_;
+  std::vector<RequestInfo> requests_;
 
   // Set in |GetStatsReport|, read in |ProducePartialResultsOnNetworkThread| and
   // |ProducePartialResultsOnSignalingThread|, reset after work is complete. Not
@@ -158,6 +214,12 @@ class RTCStatsCollector : public virtual rtc::RefCountInterface,
   std::unique_ptr<TrackMediaInfoMap> track_media_info_map_;
   std::map<MediaStreamTrackInterface*, std::string> track_to_id_;
   Call::Stats call_stats_;
+  // The stats types produced by the gathering in progress, or empty for all
+  // types.
+  std::set<std::string> requested_stats_types_;
+
+  // Only accessed on the network thread.
+  std::map<std::string, CachedCertificateStats> cached_certificate_stats_;
 
   // A timestamp, in microseconds, that is based on a timer that is
   // monotonically increasing. That is, even if the system clock is modified the
@@ -166,6 +228,8 @@ class RTCStatsCollector : public virtual rtc::RefCountInterface,
   int64_t cache_timestamp_us_;
   int64_t cache_lifetime_us_;
   rtc::scoped_refptr<const RTCStatsReport> cached_report_;
+  // The stats types in |cached_report_|, or empty if it has all types.
+  std::set<std::string> cached_report_stats_types_;
 
   // Data recorded and maintained by the stats collector during its lifetime.
   // Some stats are produced from this record instead of other components.
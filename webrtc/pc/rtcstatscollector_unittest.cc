@@ -10,9 +10,12 @@
 
 #include "webrtc/pc/rtcstatscollector.h"
 
+#include <functional>
 #include <initializer_list>
+#include <map>
 #include <memory>
 #include <ostream>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -42,6 +45,7 @@
 #include "webrtc/rtc_base/thread_checker.h"
 #include "webrtc/rtc_base/timedelta.h"
 #include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
 
 using testing::_;
 using testing::Invoke;
@@ -389,14 +393,14 @@ class RTCStatsCollectorTestHelper : public SetSessionDescriptionObserver {
   // associated with multiple |[Voice/Video]SenderInfo|s, remote tracks can only
   // be associated with one |[Voice/Video]ReceiverInfo|.
   void CreateMockRtpSendersReceiversAndChannels(
-      std::initializer_list<std::pair<MediaStreamTrackInterface*,
-          cricket::VoiceSenderInfo>> local_audio_track_info_pairs,
-      std::initializer_list<std::pair<MediaStreamTrackInterface*,
-          cricket::VoiceReceiverInfo>> remote_audio_track_info_pairs,
-      std::initializer_list<std::pair<MediaStreamTrackInterface*,
-          cricket::VideoSenderInfo>> local_video_track_info_pairs,
-      std::initializer_list<std::pair<MediaStreamTrackInterface*,
-          cricket::VideoReceiverInfo>> remote_video_track_info_pairs) {
+      const std::vector<std::pair<MediaStreamTrackInterface*,
+          cricket::VoiceSenderInfo>>& local_audio_track_info_pairs,
+      const std::vector<std::pair<MediaStreamTrackInterface*,
+          cricket::VoiceReceiverInfo>>& remote_audio_track_info_pairs,
+      const std::vector<std::pair<MediaStreamTrackInterface*,
+          cricket::VideoSenderInfo>>& local_video_track_info_pairs,
+      const std::vector<std::pair<MediaStreamTrackInterface*,
+          cricket::VideoReceiverInfo>>& remote_video_track_info_pairs) {
     voice_media_info_.reset(new cricket::VoiceMediaInfo());
     video_media_info_.reset(new cricket::VideoMediaInfo());
     rtp_senders_.clear();
@@ -464,26 +468,36 @@ class RTCStatsCollectorTestHelper : public SetSessionDescriptionObserver {
     EXPECT_CALL(pc_, GetSenders()).WillRepeatedly(Return(rtp_senders_));
     EXPECT_CALL(pc_, GetReceivers()).WillRepeatedly(Return(rtp_receivers_));
 
-    MockVoiceMediaChannel* voice_media_channel = new MockVoiceMediaChannel();
+    voice_media_channel_ = new MockVoiceMediaChannel();
     voice_channel_.reset(new cricket::VoiceChannel(
         worker_thread_, network_thread_, nullptr, media_engine_,
-        voice_media_channel, "VoiceContentName", kDefaultRtcpMuxRequired,
+        voice_media_channel_, "VoiceContentName", kDefaultRtcpMuxRequired,
         kDefaultSrtpRequired));
     EXPECT_CALL(session_, voice_channel())
         .WillRepeatedly(Return(voice_channel_.get()));
-    EXPECT_CALL(*voice_media_channel, GetStats(_))
+    EXPECT_CALL(*voice_media_channel_, GetStats(_))
         .WillOnce(DoAll(SetArgPointee<0>(*voice_media_info_), Return(true)));
 
-    MockVideoMediaChannel* video_media_channel = new MockVideoMediaChannel();
+    video_media_channel_ = new MockVideoMediaChannel();
     video_channel_.reset(new cricket::VideoChannel(
-        worker_thread_, network_thread_, nullptr, video_media_channel,
+        worker_thread_, network_thread_, nullptr, video_media_channel_,
         "VideoContentName", kDefaultRtcpMuxRequired, kDefaultSrtpRequired));
     EXPECT_CALL(session_, video_channel())
         .WillRepeatedly(Return(video_channel_.get()));
-    EXPECT_CALL(*video_media_channel, GetStats(_))
+    EXPECT_CALL(*video_media_channel_, GetStats(_))
         .WillOnce(DoAll(SetArgPointee<0>(*video_media_info_), Return(true)));
   }
 
+  // Lets the channels created by |CreateMockRtpSendersReceiversAndChannels|
+  // return their stats any number of times. Must be called after the stats
+  // have been gathered once.
+  void ExpectRepeatedMediaChannelGetStats() {
+    EXPECT_CALL(*voice_media_channel_, GetStats(_)).WillRepeatedly(
+        DoAll(SetArgPointee<0>(*voice_media_info_), Return(true)));
+    EXPECT_CALL(*video_media_channel_, GetStats(_)).WillRepeatedly(
+        DoAll(SetArgPointee<0>(*video_media_info_), Return(true)));
+  }
+
  private:
   rtc::ScopedFakeClock fake_clock_;
   RtcEventLogNullImpl event_log_;
@@ -499,6 +513,9 @@ class RTCStatsCollectorTestHelper : public SetSessionDescriptionObserver {
   std::vector<rtc::scoped_refptr<DataChannel>> data_channels_;
   std::unique_ptr<cricket::VoiceChannel> voice_channel_;
   std::unique_ptr<cricket::VideoChannel> video_channel_;
+  // Owned by |voice_channel_| and |video_channel_|.
+  MockVoiceMediaChannel* voice_media_channel_ = nullptr;
+  MockVideoMediaChannel* video_media_channel_ = nullptr;
   std::unique_ptr<cricket::VoiceMediaInfo> voice_media_info_;
   std::unique_ptr<cricket::VideoMediaInfo> video_media_info_;
   std::vector<rtc::scoped_refptr<RtpSenderInterface>> rtp_senders_;
@@ -2321,6 +2338,416 @@ TEST_F(RTCStatsCollectorTest, CollectRTCTransportStats) {
       report->Get(expected_rtcp_transport.id())->cast_to<RTCTransportStats>());
 }
 
+TEST_F(RTCStatsCollectorTest, GetStatsReportWithStatsTypes) {
+  // Only stats produced on the signaling thread are requested, so the session
+  // is not asked for its stats.
+  EXPECT_CALL(test_->session(), GetStats(_)).Times(0);
+  rtc::scoped_refptr<const RTCStatsReport> report;
+  collector_->GetStatsReport(
+      std::set<std::string>({RTCPeerConnectionStats::kType}),
+      RTCStatsObtainer::Create(&report));
+  EXPECT_TRUE_WAIT(report, kGetStatsReportTimeoutMs);
+  EXPECT_EQ(1u, report->size());
+  EXPECT_TRUE(report->Get("RTCPeerConnection"));
+
+  // The cached report covers the same stats types.
+  rtc::scoped_refptr<const RTCStatsReport> same_report;
+  collector_->GetStatsReport(
+      std::set<std::string>({RTCPeerConnectionStats::kType}),
+      RTCStatsObtainer::Create(&same_report));
+  EXPECT_TRUE_WAIT(same_report, kGetStatsReportTimeoutMs);
+  EXPECT_EQ(report.get(), same_report.get());
+}
+
+TEST_F(RTCStatsCollectorTest, GetStatsReportWithStatsTypesFromCachedReport) {
+  SessionStats session_stats;
+  session_stats.transport_stats["transport"].transport_name = "transport";
+  cricket::TransportChannelStats channel_stats;
+  channel_stats.component = cricket::ICE_CANDIDATE_COMPONENT_RTP;
+  session_stats.transport_stats["transport"].channel_stats.push_back(
+      channel_stats);
+  // A fresh report that has all stats types serves later requests for a
+  // subset of them.
+  EXPECT_CALL(test_->session(), GetStats(_)).WillOnce(Invoke(
+      [&session_stats](const ChannelNamePairs&) {
+        return std::unique_ptr<SessionStats>(new SessionStats(session_stats));
+      }));
+
+  rtc::scoped_refptr<const RTCStatsReport> full_report = GetStatsReport();
+  EXPECT_TRUE(full_report->Get("RTCPeerConnection"));
+  ASSERT_EQ(1u, full_report->GetStatsOfType<RTCTransportStats>().size());
+
+  rtc::scoped_refptr<const RTCStatsReport> report;
+  collector_->GetStatsReport(
+      std::set<std::string>({RTCTransportStats::kType}),
+      RTCStatsObtainer::Create(&report));
+  EXPECT_TRUE_WAIT(report, kGetStatsReportTimeoutMs);
+  EXPECT_NE(full_report.get(), report.get());
+  EXPECT_EQ(full_report->timestamp_us(), report->timestamp_us());
+  ASSERT_EQ(1u, report->size());
+  const RTCTransportStats* transport_stats =
+      full_report->GetStatsOfType<RTCTransportStats>()[0];
+  ASSERT_TRUE(report->Get(transport_stats->id()));
+  EXPECT_EQ(*transport_stats, *report->Get(transport_stats->id()));
+}
+
+TEST_F(RTCStatsCollectorTest, GetStatsReportForStatsTypesNotInCachedReport) {
+  rtc::scoped_refptr<const RTCStatsReport> data_channel_report;
+  collector_->GetStatsReport(
+      std::set<std::string>({RTCDataChannelStats::kType}),
+      RTCStatsObtainer::Create(&data_channel_report));
+  EXPECT_TRUE_WAIT(data_channel_report, kGetStatsReportTimeoutMs);
+  EXPECT_FALSE(data_channel_report->Get("RTCPeerConnection"));
+
+  // The cached report does not have peer connection stats, so new stats are
+  // gathered even though the cached report is fresh.
+  rtc::scoped_refptr<const RTCStatsReport> report;
+  collector_->GetStatsReport(
+      std::set<std::string>({RTCPeerConnectionStats::kType}),
+      RTCStatsObtainer::Create(&report));
+  EXPECT_TRUE_WAIT(report, kGetStatsReportTimeoutMs);
+  EXPECT_TRUE(report->Get("RTCPeerConnection"));
+  // Neither is the full report a subset of the new cached report.
+  rtc::scoped_refptr<const RTCStatsReport> full_report = GetStatsReport();
+  EXPECT_NE(report.get(), full_report.get());
+  EXPECT_TRUE(full_report->Get("RTCPeerConnection"));
+}
+
+TEST_F(RTCStatsCollectorTest, GetStatsReportForTrack) {
+  rtc::scoped_refptr<StreamCollection> remote_streams =
+      StreamCollection::Create();
+  EXPECT_CALL(test_->pc(), remote_streams())
+      .WillRepeatedly(Return(remote_streams));
+  rtc::scoped_refptr<MediaStream> remote_stream =
+      MediaStream::Create("RemoteStreamLabel");
+  remote_streams->AddStream(remote_stream);
+
+  rtc::scoped_refptr<MediaStreamTrackInterface> remote_audio_track1 =
+      CreateFakeTrack(cricket::MEDIA_TYPE_AUDIO, "RemoteAudioTrackID1",
+                      MediaStreamTrackInterface::kLive);
+  remote_stream->AddTrack(static_cast<AudioTrackInterface*>(
+      remote_audio_track1.get()));
+  rtc::scoped_refptr<MediaStreamTrackInterface> remote_audio_track2 =
+      CreateFakeTrack(cricket::MEDIA_TYPE_AUDIO, "RemoteAudioTrackID2",
+                      MediaStreamTrackInterface::kLive);
+  remote_stream->AddTrack(static_cast<AudioTrackInterface*>(
+      remote_audio_track2.get()));
+
+  cricket::VoiceReceiverInfo voice_receiver_info1;
+  voice_receiver_info1.local_stats.push_back(cricket::SsrcReceiverInfo());
+  voice_receiver_info1.local_stats[0].ssrc = 1;
+  voice_receiver_info1.codec_payload_type = rtc::Optional<int>(42);
+  cricket::VoiceReceiverInfo voice_receiver_info2;
+  voice_receiver_info2.local_stats.push_back(cricket::SsrcReceiverInfo());
+  voice_receiver_info2.local_stats[0].ssrc = 2;
+  voice_receiver_info2.codec_payload_type = rtc::Optional<int>(42);
+
+  test_->CreateMockRtpSendersReceiversAndChannels(
+      {},
+      { std::make_pair(remote_audio_track1.get(), voice_receiver_info1),
+        std::make_pair(remote_audio_track2.get(), voice_receiver_info2) },
+      {}, {});
+
+  SessionStats session_stats;
+  session_stats.proxy_to_transport["VoiceContentName"] = "TransportName";
+  session_stats.proxy_to_transport["VideoContentName"] = "TransportName";
+  session_stats.transport_stats["TransportName"].transport_name =
+      "TransportName";
+  cricket::TransportChannelStats channel_stats;
+  channel_stats.component = cricket::ICE_CANDIDATE_COMPONENT_RTP;
+  session_stats.transport_stats["TransportName"].channel_stats.push_back(
+      channel_stats);
+  EXPECT_CALL(test_->session(), GetStats(_)).WillRepeatedly(Invoke(
+      [&session_stats](const ChannelNamePairs&) {
+        return std::unique_ptr<SessionStats>(new SessionStats(session_stats));
+      }));
+
+  rtc::scoped_refptr<const RTCStatsReport> report;
+  collector_->GetStatsReportForTrack("RemoteAudioTrackID1",
+                                     RTCStatsObtainer::Create(&report));
+  EXPECT_TRUE_WAIT(report, kGetStatsReportTimeoutMs);
+
+  const std::string track_id =
+      "RTCMediaStreamTrack_remote_audio_RemoteAudioTrackID1_1";
+  const std::string transport_id = "RTCTransport_TransportName_" +
+      rtc::ToString<>(cricket::ICE_CANDIDATE_COMPONENT_RTP);
+  ASSERT_TRUE(report->Get(track_id));
+  ASSERT_TRUE(report->Get("RTCInboundRTPAudioStream_1"));
+  EXPECT_EQ(track_id, *report->Get("RTCInboundRTPAudioStream_1")
+                           ->cast_to<RTCInboundRTPStreamStats>().track_id);
+  EXPECT_TRUE(report->Get(transport_id));
+  EXPECT_EQ(3u, report->size());
+  EXPECT_FALSE(
+      report->Get("RTCMediaStreamTrack_remote_audio_RemoteAudioTrackID2_2"));
+  EXPECT_FALSE(report->Get("RTCInboundRTPAudioStream_2"));
+  EXPECT_FALSE(report->Get("RTCPeerConnection"));
+}
+
+TEST_F(RTCStatsCollectorTest, CertificateStatsFollowCertificateChanges) {
+  std::unique_ptr<CertificateInfo> local_certinfo =
+      CreateFakeCertificateAndInfoFromDers(
+          std::vector<std::string>({ "(local) certificate" }));
+  std::unique_ptr<CertificateInfo> remote_certinfo =
+      CreateFakeCertificateAndInfoFromDers(
+          std::vector<std::string>({ "(remote) certificate" }));
+
+  EXPECT_CALL(test_->session(), GetStats(_)).WillRepeatedly(Invoke(
+      [](const ChannelNamePairs&) {
+        std::unique_ptr<SessionStats> stats(new SessionStats());
+        stats->transport_stats["transport"].transport_name = "transport";
+        return stats;
+      }));
+  EXPECT_CALL(test_->session(), GetLocalCertificate(_, _)).WillRepeatedly(
+      Invoke([&local_certinfo](const std::string& transport_name,
+             rtc::scoped_refptr<rtc::RTCCertificate>* certificate) {
+        *certificate = local_certinfo->certificate;
+        return true;
+      }));
+  EXPECT_CALL(test_->session(),
+      GetRemoteSSLCertificate_ReturnsRawPointer(_)).WillRepeatedly(Invoke(
+      [&remote_certinfo](const std::string& transport_name) {
+        return remote_certinfo->certificate->ssl_certificate().GetReference();
+      }));
+
+  rtc::scoped_refptr<const RTCStatsReport> report = GetStatsReport();
+  ExpectReportContainsCertificateInfo(report, *local_certinfo);
+  ExpectReportContainsCertificateInfo(report, *remote_certinfo);
+
+  // Unchanged certificates give the same stats.
+  collector_->ClearCachedStatsReport();
+  report = GetStatsReport();
+  ExpectReportContainsCertificateInfo(report, *local_certinfo);
+  ExpectReportContainsCertificateInfo(report, *remote_certinfo);
+
+  // New certificates replace the old ones.
+  std::unique_ptr<CertificateInfo> old_remote_certinfo =
+      std::move(remote_certinfo);
+  local_certinfo = CreateFakeCertificateAndInfoFromDers(
+      std::vector<std::string>({ "(local) new certificate" }));
+  remote_certinfo = CreateFakeCertificateAndInfoFromDers(
+      std::vector<std::string>({ "(remote) new certificate" }));
+  collector_->ClearCachedStatsReport();
+  report = GetStatsReport();
+  ExpectReportContainsCertificateInfo(report, *local_certinfo);
+  ExpectReportContainsCertificateInfo(report, *remote_certinfo);
+  EXPECT_FALSE(report->Get(
+      "RTCCertificate_" + old_remote_certinfo->fingerprints[0]));
+  EXPECT_EQ(2u, report->GetStatsOfType<RTCCertificateStats>().size());
+}
+
+// A peer connection with 50 tracks and 10 transports.
+class RTCStatsCollectorManyTracksTest : public RTCStatsCollectorTest {
+ public:
+  static const int kNumTracks = 50;
+  static const int kNumTransports = 10;
+
+  void SetUp() override {
+    rtc::scoped_refptr<StreamCollection> local_streams =
+        StreamCollection::Create();
+    rtc::scoped_refptr<StreamCollection> remote_streams =
+        StreamCollection::Create();
+    EXPECT_CALL(test_->pc(), local_streams())
+        .WillRepeatedly(Return(local_streams));
+    EXPECT_CALL(test_->pc(), remote_streams())
+        .WillRepeatedly(Return(remote_streams));
+    rtc::scoped_refptr<MediaStream> local_stream =
+        MediaStream::Create("LocalStreamLabel");
+    local_streams->AddStream(local_stream);
+    rtc::scoped_refptr<MediaStream> remote_stream =
+        MediaStream::Create("RemoteStreamLabel");
+    remote_streams->AddStream(remote_stream);
+
+    // Half of the tracks are sent audio tracks, the other half received video
+    // tracks.
+    std::vector<std::pair<MediaStreamTrackInterface*,
+                          cricket::VoiceSenderInfo>>
+        local_audio_track_info_pairs;
+    std::vector<std::pair<MediaStreamTrackInterface*,
+                          cricket::VideoReceiverInfo>>
+        remote_video_track_info_pairs;
+    for (int i = 0; i < kNumTracks; ++i) {
+      const uint32_t ssrc = static_cast<uint32_t>(i + 1);
+      if (i % 2 == 0) {
+        rtc::scoped_refptr<MediaStreamTrackInterface> track =
+            CreateFakeTrack(cricket::MEDIA_TYPE_AUDIO,
+                            "LocalAudioTrackID" + rtc::ToString<>(i),
+                            MediaStreamTrackInterface::kLive);
+        local_stream->AddTrack(static_cast<AudioTrackInterface*>(track.get()));
+        cricket::VoiceSenderInfo voice_sender_info;
+        voice_sender_info.local_stats.push_back(cricket::SsrcSenderInfo());
+        voice_sender_info.local_stats[0].ssrc = ssrc;
+        voice_sender_info.codec_payload_type = rtc::Optional<int>(111);
+        voice_sender_info.packets_sent = 1000 + i;
+        voice_sender_info.bytes_sent = 100000 + i;
+        local_audio_track_info_pairs.push_back(
+            std::make_pair(track.get(), voice_sender_info));
+        tracks_.push_back(track);
+      } else {
+        rtc::scoped_refptr<MediaStreamTrackInterface> track =
+            CreateFakeTrack(cricket::MEDIA_TYPE_VIDEO,
+                            "RemoteVideoTrackID" + rtc::ToString<>(i),
+                            MediaStreamTrackInterface::kLive);
+        remote_stream->AddTrack(
+            static_cast<VideoTrackInterface*>(track.get()));
+        cricket::VideoReceiverInfo video_receiver_info;
+        video_receiver_info.local_stats.push_back(
+            cricket::SsrcReceiverInfo());
+        video_receiver_info.local_stats[0].ssrc = ssrc;
+        video_receiver_info.codec_payload_type = rtc::Optional<int>(96);
+        video_receiver_info.packets_rcvd = 1000 + i;
+        video_receiver_info.bytes_rcvd = 100000 + i;
+        video_receiver_info.frames_decoded = 300 + i;
+        remote_video_track_info_pairs.push_back(
+            std::make_pair(track.get(), video_receiver_info));
+        tracks_.push_back(track);
+      }
+    }
+    test_->CreateMockRtpSendersReceiversAndChannels(
+        local_audio_track_info_pairs, {}, {}, remote_video_track_info_pairs);
+
+    // Each transport has two candidate pairs, one of them selected, and a
+    // local and a remote certificate.
+    session_stats_.proxy_to_transport["VoiceContentName"] = "Transport0";
+    session_stats_.proxy_to_transport["VideoContentName"] = "Transport1";
+    for (int i = 0; i < kNumTransports; ++i) {
+      const std::string transport_name = "Transport" + rtc::ToString<>(i);
+      cricket::TransportStats& transport_stats =
+          session_stats_.transport_stats[transport_name];
+      transport_stats.transport_name = transport_name;
+      cricket::TransportChannelStats channel_stats;
+      channel_stats.component = cricket::ICE_CANDIDATE_COMPONENT_RTP;
+      channel_stats.dtls_state = cricket::DTLS_TRANSPORT_CONNECTED;
+      for (int j = 0; j < 2; ++j) {
+        cricket::ConnectionInfo connection_info;
+        connection_info.best_connection = j == 0;
+        connection_info.local_candidate = *CreateFakeCandidate(
+            "10.0.0." + rtc::ToString<>(i), 1000 + j, "udp",
+            cricket::LOCAL_PORT_TYPE, 42);
+        connection_info.remote_candidate = *CreateFakeCandidate(
+            "10.0.1." + rtc::ToString<>(i), 2000 + j, "udp",
+            cricket::STUN_PORT_TYPE, 42);
+        connection_info.sent_total_bytes = 1000 * i + j;
+        connection_info.recv_total_bytes = 2000 * i + j;
+        channel_stats.connection_infos.push_back(connection_info);
+      }
+      transport_stats.channel_stats.push_back(channel_stats);
+      local_certinfos_[transport_name] = CreateFakeCertificateAndInfoFromDers(
+          std::vector<std::string>({ "(local) " + transport_name }));
+      remote_certinfos_[transport_name] = CreateFakeCertificateAndInfoFromDers(
+          std::vector<std::string>({ "(remote) " + transport_name }));
+    }
+    EXPECT_CALL(test_->session(), GetStats(_)).WillRepeatedly(Invoke(
+        [this](const ChannelNamePairs&) {
+          return std::unique_ptr<SessionStats>(
+              new SessionStats(session_stats_));
+        }));
+    EXPECT_CALL(test_->session(), GetLocalCertificate(_, _)).WillRepeatedly(
+        Invoke([this](const std::string& transport_name,
+               rtc::scoped_refptr<rtc::RTCCertificate>* certificate) {
+          auto it = local_certinfos_.find(transport_name);
+          if (it == local_certinfos_.end())
+            return false;
+          *certificate = it->second->certificate;
+          return true;
+        }));
+    EXPECT_CALL(test_->session(),
+        GetRemoteSSLCertificate_ReturnsRawPointer(_)).WillRepeatedly(Invoke(
+        [this](const std::string& transport_name) {
+          auto it = remote_certinfos_.find(transport_name);
+          if (it == remote_certinfos_.end())
+            return static_cast<rtc::SSLCertificate*>(nullptr);
+          return it->second->certificate->ssl_certificate().GetReference();
+        }));
+
+    // The first report uses up the channels' one-time stats expectations.
+    full_report_ = GetStatsReport();
+    test_->ExpectRepeatedMediaChannelGetStats();
+  }
+
+ protected:
+  std::vector<rtc::scoped_refptr<MediaStreamTrackInterface>> tracks_;
+  SessionStats session_stats_;
+  std::map<std::string, std::unique_ptr<CertificateInfo>> local_certinfos_;
+  std::map<std::string, std::unique_ptr<CertificateInfo>> remote_certinfos_;
+  rtc::scoped_refptr<const RTCStatsReport> full_report_;
+};
+
+TEST_F(RTCStatsCollectorManyTracksTest,
+       GetStatsReportWith50TracksAnd10Transports) {
+  EXPECT_EQ(static_cast<size_t>(kNumTracks),
+            full_report_->GetStatsOfType<RTCMediaStreamTrackStats>().size());
+  EXPECT_EQ(static_cast<size_t>(kNumTransports),
+            full_report_->GetStatsOfType<RTCTransportStats>().size());
+
+  // Fresh reports for a subset of the stats.
+  collector_->ClearCachedStatsReport();
+  rtc::scoped_refptr<const RTCStatsReport> transport_report;
+  collector_->GetStatsReport(
+      std::set<std::string>({RTCTransportStats::kType}),
+      RTCStatsObtainer::Create(&transport_report));
+  EXPECT_TRUE_WAIT(transport_report, kGetStatsReportTimeoutMs);
+  EXPECT_EQ(static_cast<size_t>(kNumTransports),
+            transport_report->GetStatsOfType<RTCTransportStats>().size());
+  EXPECT_EQ(static_cast<size_t>(kNumTransports), transport_report->size());
+
+  collector_->ClearCachedStatsReport();
+  rtc::scoped_refptr<const RTCStatsReport> track_report;
+  collector_->GetStatsReportForTrack("RemoteVideoTrackID1",
+                                     RTCStatsObtainer::Create(&track_report));
+  EXPECT_TRUE_WAIT(track_report, kGetStatsReportTimeoutMs);
+  std::vector<const RTCMediaStreamTrackStats*> track_stats =
+      track_report->GetStatsOfType<RTCMediaStreamTrackStats>();
+  ASSERT_EQ(1u, track_stats.size());
+  EXPECT_EQ("RemoteVideoTrackID1", *track_stats[0]->track_identifier);
+  EXPECT_FALSE(track_report->Get("RTCPeerConnection"));
+}
+
+// Measures how long it takes to produce fresh stats: all stats, only the
+// transport stats and the stats of a single track. Disabled since it only
+// reports timings; run it with --gtest_also_run_disabled_tests.
+TEST_F(RTCStatsCollectorManyTracksTest,
+       DISABLED_GetStatsReportWith50TracksAnd10TransportsPerformance) {
+  const int kNumReports = 100;
+  // Returns the average real time, in microseconds, that |get_stats| takes to
+  // deliver a fresh report.
+  auto measure = [this](
+      const std::function<void(rtc::scoped_refptr<RTCStatsObtainer>)>&
+          get_stats) {
+    int64_t total_ns = 0;
+    for (int i = 0; i < kNumReports; ++i) {
+      collector_->ClearCachedStatsReport();
+      rtc::scoped_refptr<RTCStatsObtainer> callback =
+          RTCStatsObtainer::Create();
+      int64_t start_ns = rtc::SystemTimeNanos();
+      get_stats(callback);
+      collector_->WaitForPendingRequest();
+      total_ns += rtc::SystemTimeNanos() - start_ns;
+      EXPECT_TRUE(callback->report());
+    }
+    return static_cast<size_t>(
+        total_ns / rtc::kNumNanosecsPerMicrosec / kNumReports);
+  };
+  size_t all_stats_us = measure(
+      [this](rtc::scoped_refptr<RTCStatsObtainer> callback) {
+        collector_->GetStatsReport(callback);
+      });
+  size_t transport_stats_us = measure(
+      [this](rtc::scoped_refptr<RTCStatsObtainer> callback) {
+        collector_->GetStatsReport(
+            std::set<std::string>({RTCTransportStats::kType}), callback);
+      });
+  size_t track_stats_us = measure(
+      [this](rtc::scoped_refptr<RTCStatsObtainer> callback) {
+        collector_->GetStatsReportForTrack("RemoteVideoTrackID1", callback);
+      });
+  test::PrintResult("rtc_stats_collector_50_tracks_10_transports", "",
+                    "all_stats", all_stats_us, "us", false);
+  test::PrintResult("rtc_stats_collector_50_tracks_10_transports", "",
+                    "transport_stats", transport_stats_us, "us", false);
+  test::PrintResult("rtc_stats_collector_50_tracks_10_transports", "",
+                    "track_stats", track_stats_us, "us", false);
+}
+
 class RTCStatsCollectorTestWithFakeCollector : public testing::Test {
  public:
   RTCStatsCollectorTestWithFakeCollector()
@@ -0,0 +1,65 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/pc/rtcstatstraversal.h"
+
+#include <memory>
+
+#include "webrtc/rtc_base/checks.h"
+
+namespace webrtc {
+
+std::vector<const std::string*> GetStatsReferencedIds(
+    const RTCStats& stats, const RTCStatsReport& report) {
+  std::vector<const std::string*> referenced_ids;
+  for (const RTCStatsMemberInterface* member : stats.Members()) {
+    if (member->type() != RTCStatsMemberInterface::kString ||
+        !member->is_defined()) {
+      continue;
+    }
+    const std::string& value =
+        *member->cast_to<RTCStatsMember<std::string>>();
+    if (value != stats.id() && report.Get(value))
+      referenced_ids.push_back(&value);
+  }
+  return referenced_ids;
+}
+
+rtc::scoped_refptr<RTCStatsReport> CopyReferencedStats(
+    const RTCStatsReport& report, const std::vector<std::string>& ids) {
+  rtc::scoped_refptr<RTCStatsReport> result =
+      RTCStatsReport::Create(report.timestamp_us());
+  // Depth-first traversal. A stats object is copied to |result| when it is
+  // first visited, so |result| doubles as the set of visited stats.
+  std::vector<const RTCStats*> stack;
+  for (const std::string& id : ids) {
+    const RTCStats* stats = report.Get(id);
+    if (stats && !result->Get(id)) {
+      result->AddStats(stats->copy());
+      stack.push_back(stats);
+    }
+  }
+  while (!stack.empty()) {
+    const RTCStats* stats = stack.back();
+    stack.pop_back();
+    for (const std::string* referenced_id :
+         GetStatsReferencedIds(*stats, report)) {
+      if (result->Get(*referenced_id))
+        continue;
+      const RTCStats* referenced_stats = report.Get(*referenced_id);
+      RTC_DCHECK(referenced_stats);
+      result->AddStats(referenced_stats->copy());
+      stack.push_back(referenced_stats);
+    }
+  }
+  return result;
+}
+
+}  // namespace webrtc
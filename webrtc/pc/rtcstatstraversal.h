@@ -0,0 +1,38 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_PC_RTCSTATSTRAVERSAL_H_
+#define WEBRTC_PC_RTCSTATSTRAVERSAL_H_
+
+#include <string>
+#include <vector>
+
+#include "webrtc/api/stats/rtcstats.h"
+#include "webrtc/api/stats/rtcstatsreport.h"
+#include "webrtc/rtc_base/scoped_ref_ptr.h"
+
+namespace webrtc {
+
+// Gets the values of the defined string members of |stats| that are the IDs of
+// other stats objects in |report|, e.g. |RTCTransportStats::
+// selected_candidate_pair_id|. The pointers are valid for the lifetime of
+// |stats|.
+std::vector<const std::string*> GetStatsReferencedIds(
+    const RTCStats& stats, const RTCStatsReport& report);
+
+// Returns a report, with the timestamp of |report|, containing copies of the
+// stats in |report| identified by |ids| and of all stats that are directly or
+// indirectly referenced by them. IDs that are not in |report| are ignored.
+rtc::scoped_refptr<RTCStatsReport> CopyReferencedStats(
+    const RTCStatsReport& report, const std::vector<std::string>& ids);
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_PC_RTCSTATSTRAVERSAL_H_
@@ -0,0 +1,131 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/pc/rtcstatstraversal.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/api/stats/rtcstats_objects.h"
+#include "webrtc/rtc_base/gunit.h"
+
+namespace webrtc {
+
+class RTCStatsTraversalTest : public testing::Test {
+ public:
+  RTCStatsTraversalTest() {
+    transport_ = new RTCTransportStats("transport", 0);
+    candidate_pair_ = new RTCIceCandidatePairStats("candidate-pair", 0);
+    local_candidate_ = new RTCLocalIceCandidateStats("local-candidate", 0);
+    remote_candidate_ = new RTCRemoteIceCandidateStats("remote-candidate", 0);
+    initial_report_ = RTCStatsReport::Create(1337);
+    initial_report_->AddStats(std::unique_ptr<const RTCStats>(transport_));
+    initial_report_->AddStats(
+        std::unique_ptr<const RTCStats>(candidate_pair_));
+    initial_report_->AddStats(
+        std::unique_ptr<const RTCStats>(local_candidate_));
+    initial_report_->AddStats(
+        std::unique_ptr<const RTCStats>(remote_candidate_));
+  }
+
+  void CopyReferencedStats(std::vector<const RTCStats*> start_nodes) {
+    std::vector<std::string> start_ids;
+    for (const RTCStats* start_node : start_nodes)
+      start_ids.push_back(start_node->id());
+    result_ = webrtc::CopyReferencedStats(*initial_report_, start_ids);
+  }
+
+  void EXPECT_VISITED(const RTCStats* stats) {
+    ASSERT_TRUE(result_->Get(stats->id()));
+    EXPECT_EQ(*stats, *result_->Get(stats->id()));
+  }
+
+  void EXPECT_UNVISITED(const RTCStats* stats) {
+    EXPECT_FALSE(result_->Get(stats->id()));
+  }
+
+ protected:
+  rtc::scoped_refptr<RTCStatsReport> initial_report_;
+  rtc::scoped_refptr<RTCStatsReport> result_;
+  // Raw pointers to stats owned by |initial_report_|.
+  RTCTransportStats* transport_;
+  RTCIceCandidatePairStats* candidate_pair_;
+  RTCIceCandidateStats* local_candidate_;
+  RTCIceCandidateStats* remote_candidate_;
+};
+
+TEST_F(RTCStatsTraversalTest, NoReachableConnections) {
+  CopyReferencedStats(
+      {transport_, candidate_pair_, local_candidate_, remote_candidate_});
+  EXPECT_EQ(1337, result_->timestamp_us());
+  EXPECT_EQ(4u, result_->size());
+  // The initial report is left untouched.
+  EXPECT_EQ(4u, initial_report_->size());
+}
+
+TEST_F(RTCStatsTraversalTest, SelfReference) {
+  transport_->rtcp_transport_stats_id = "transport";
+  CopyReferencedStats({transport_});
+  EXPECT_VISITED(transport_);
+  EXPECT_UNVISITED(candidate_pair_);
+  EXPECT_UNVISITED(local_candidate_);
+  EXPECT_UNVISITED(remote_candidate_);
+}
+
+TEST_F(RTCStatsTraversalTest, BogusReference) {
+  transport_->rtcp_transport_stats_id = "bogus-reference";
+  CopyReferencedStats({transport_});
+  EXPECT_VISITED(transport_);
+  EXPECT_EQ(1u, result_->size());
+}
+
+TEST_F(RTCStatsTraversalTest, Tree) {
+  transport_->selected_candidate_pair_id = "candidate-pair";
+  candidate_pair_->local_candidate_id = "local-candidate";
+  candidate_pair_->remote_candidate_id = "remote-candidate";
+  CopyReferencedStats({transport_});
+  EXPECT_VISITED(transport_);
+  EXPECT_VISITED(candidate_pair_);
+  EXPECT_VISITED(local_candidate_);
+  EXPECT_VISITED(remote_candidate_);
+}
+
+TEST_F(RTCStatsTraversalTest, MultiplePathsToSameNode) {
+  transport_->selected_candidate_pair_id = "candidate-pair";
+  candidate_pair_->local_candidate_id = "local-candidate";
+  local_candidate_->transport_id = "transport";
+  CopyReferencedStats({candidate_pair_, local_candidate_});
+  EXPECT_VISITED(transport_);
+  EXPECT_VISITED(candidate_pair_);
+  EXPECT_VISITED(local_candidate_);
+  EXPECT_UNVISITED(remote_candidate_);
+}
+
+TEST_F(RTCStatsTraversalTest, StatsOnlyReferencedInOneDirection) {
+  candidate_pair_->transport_id = "transport";
+  CopyReferencedStats({transport_});
+  EXPECT_VISITED(transport_);
+  EXPECT_UNVISITED(candidate_pair_);
+}
+
+TEST_F(RTCStatsTraversalTest, GetStatsReferencedIds) {
+  candidate_pair_->transport_id = "transport";
+  candidate_pair_->local_candidate_id = "local-candidate";
+  candidate_pair_->remote_candidate_id = "bogus-reference";
+  candidate_pair_->state = "succeeded";
+  std::vector<const std::string*> ids =
+      GetStatsReferencedIds(*candidate_pair_, *initial_report_);
+  ASSERT_EQ(2u, ids.size());
+  EXPECT_EQ("transport", *ids[0]);
+  EXPECT_EQ("local-candidate", *ids[1]);
+}
+
+}  // namespace webrtc
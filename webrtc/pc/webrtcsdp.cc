@@ -13,10 +13,13 @@
 #include <ctype.h>
 #include <limits.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <algorithm>
+#include <limits>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
@@ -206,6 +209,11 @@ static const char kApplicationSpecificMaximum[] = "AS";
 
 static const char kDefaultSctpmapProtocol[] = "webrtc-datachannel";
 
+// Estimated sizes of the serialized session section and of a media section,
+// used to reserve the serialized description.
+static const size_t kSdpSessionSectionSizeEstimate = 256;
+static const size_t kSdpMediaSectionSizeEstimate = 2048;
+
 // RTP payload type is in the 0-127 range. Use -1 to indicate "all" payload
 // types.
 const int kWildcardPayloadType = -1;
@@ -300,8 +308,6 @@ static bool ParseFmtpAttributes(const std::string& line,
                                 const MediaType media_type,
                                 MediaContentDescription* media_desc,
                                 SdpParseError* error);
-static bool ParseFmtpParam(const std::string& line, std::string* parameter,
-                           std::string* value, SdpParseError* error);
 static bool ParseCandidate(const std::string& message, Candidate* candidate,
                            SdpParseError* error, bool is_raw);
 static bool ParseRtcpFbAttribute(const std::string& line,
@@ -442,7 +448,9 @@ static bool GetLine(const std::string& message,
   if (line_end > 0 && (message.at(line_end - 1) == kReturn)) {
     --line_end;
   }
-  *line = message.substr(line_begin, (line_end - line_begin));
+  // Assigning rather than using substr() reuses the capacity of |line|, which
+  // the parsers keep across all the lines of a description.
+  line->assign(message, line_begin, line_end - line_begin);
   const char* cline = line->c_str();
   // RFC 4566
   // An SDP session description consists of a number of lines of text of
@@ -461,6 +469,200 @@ static bool GetLine(const std::string& message,
   return true;
 }
 
+// A field of an SDP line. Refers to the characters of the line in place, so
+// that the lines of large descriptions can be tokenized without copying every
+// field into a string of its own.
+class SdpField {
+ public:
+  SdpField() : data_(nullptr), size_(0) {}
+  SdpField(const char* data, size_t size) : data_(data), size_(size) {}
+  explicit SdpField(const std::string& str)
+      : data_(str.data()), size_(str.size()) {}
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  std::string str() const { return std::string(data_, size_); }
+
+  bool operator==(const char* str) const {
+    return strlen(str) == size_ && memcmp(data_, str, size_) == 0;
+  }
+  bool operator!=(const char* str) const { return !(*this == str); }
+
+  // Removes leading and trailing whitespace, like rtc::string_trim.
+  SdpField Trim() const {
+    static const char kWhitespace[] = " \n\r\t";
+    const char* begin = data_;
+    const char* end = data_ + size_;
+    while (begin < end && strchr(kWhitespace, *begin))
+      ++begin;
+    while (end > begin && strchr(kWhitespace, *(end - 1)))
+      --end;
+    return SdpField(begin, end - begin);
+  }
+
+  bool EndsWith(const char* suffix) const {
+    const size_t suffix_size = strlen(suffix);
+    return suffix_size <= size_ &&
+           memcmp(data_ + size_ - suffix_size, suffix, suffix_size) == 0;
+  }
+
+  // Splits the field at the first |delimiter|, like rtc::tokenize_first:
+  // delimiters following the first one are not part of |rest|.
+  bool TokenizeFirst(char delimiter, SdpField* token, SdpField* rest) const {
+    const char* found =
+        static_cast<const char*>(memchr(data_, delimiter, size_));
+    if (!found)
+      return false;
+    *token = SdpField(data_, found - data_);
+    const char* end = data_ + size_;
+    const char* rest_begin = found + 1;
+    while (rest_begin < end && *rest_begin == delimiter)
+      ++rest_begin;
+    *rest = SdpField(rest_begin, end - rest_begin);
+    return true;
+  }
+
+ private:
+  const char* data_;
+  size_t size_;
+};
+
+// The part of |line| after "<type>=".
+static SdpField GetLineValue(const std::string& line) {
+  RTC_DCHECK_GE(line.size(), kLinePrefixLength);
+  return SdpField(line.data() + kLinePrefixLength,
+                  line.size() - kLinePrefixLength);
+}
+
+// Splits a line, or part of one, into the fields separated by |delimiter|.
+// Like rtc::split, consecutive delimiters produce empty fields, and an empty
+// input produces a single empty field.
+class SdpTokenizer {
+ public:
+  SdpTokenizer(const SdpField& input, char delimiter)
+      : next_(input.data()),
+        end_(input.data() + input.size()),
+        delimiter_(delimiter),
+        done_(false) {}
+
+  // Returns false once all the fields have been returned.
+  bool Next(SdpField* field) {
+    if (done_)
+      return false;
+    const char* found = static_cast<const char*>(
+        memchr(next_, delimiter_, end_ - next_));
+    if (!found) {
+      *field = SdpField(next_, end_ - next_);
+      done_ = true;
+      return true;
+    }
+    *field = SdpField(next_, found - next_);
+    next_ = found + 1;
+    return true;
+  }
+
+  // The number of fields that Next() has not returned yet.
+  size_t RemainingFields() const {
+    if (done_)
+      return 0;
+    size_t fields = 1;
+    for (const char* it = next_; it < end_; ++it) {
+      if (*it == delimiter_)
+        ++fields;
+    }
+    return fields;
+  }
+
+ private:
+  const char* next_;
+  const char* end_;
+  const char delimiter_;
+  bool done_;
+};
+
+// Splits |input| into at most |max_fields| fields separated by |delimiter|,
+// returning the number of fields, which may be larger than |max_fields|.
+// Fields past |max_fields| are not stored.
+static size_t SplitFields(const SdpField& input,
+                          char delimiter,
+                          SdpField* fields,
+                          size_t max_fields) {
+  SdpTokenizer tokenizer(input, delimiter);
+  size_t num_fields = 0;
+  SdpField field;
+  while (tokenizer.Next(&field)) {
+    if (num_fields < max_fields)
+      fields[num_fields] = field;
+    ++num_fields;
+  }
+  return num_fields;
+}
+
+// Parses the decimal integer at the start of |data|. This accepts the same
+// input as the stream extraction that rtc::FromString uses: leading
+// whitespace and a sign are allowed, anything after the digits is ignored,
+// and values out of the range of |T| are rejected (negative values of an
+// unsigned |T| wrap around, as they do for streams). Unlike rtc::FromString,
+// it does not create a stream or a string for every value.
+template <typename T>
+static bool ParseInteger(const char* data, size_t size, T* value) {
+  static_assert(std::is_integral<T>::value, "T must be an integer type");
+  size_t i = 0;
+  while (i < size && isspace(static_cast<unsigned char>(data[i])))
+    ++i;
+  bool negative = false;
+  if (i < size && (data[i] == '-' || data[i] == '+')) {
+    negative = data[i] == '-';
+    ++i;
+  }
+  if (i == size || !isdigit(static_cast<unsigned char>(data[i])))
+    return false;
+  const uint64_t limit =
+      negative && std::is_signed<T>::value
+          ? static_cast<uint64_t>(std::numeric_limits<T>::max()) + 1
+          : static_cast<uint64_t>(std::numeric_limits<T>::max());
+  uint64_t magnitude = 0;
+  for (; i < size && isdigit(static_cast<unsigned char>(data[i])); ++i) {
+    const uint64_t digit = data[i] - '0';
+    if (magnitude > (limit - digit) / 10)
+      return false;
+    magnitude = magnitude * 10 + digit;
+  }
+  *value = static_cast<T>(negative ? 0 - magnitude : magnitude);
+  return true;
+}
+
+// Appends the decimal representation of |value| to |message|.
+static void AppendInteger(int64_t value, std::string* message) {
+  char buffer[24];
+  char* const end = buffer + sizeof(buffer);
+  char* begin = end;
+  uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value)
+                                 : static_cast<uint64_t>(value);
+  do {
+    *--begin = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (value < 0)
+    *--begin = '-';
+  message->append(begin, end - begin);
+}
+
+// Appends "a=|attribute|" to |message|, starting an attribute line that the
+// caller completes and terminates with AppendLineBreak(). The hot parts of
+// the serializer write lines straight into the output this way instead of
+// building each line in a stream first.
+static void AppendAttrLineStart(const char* attribute, std::string* message) {
+  message->push_back(kLineTypeAttributes);
+  message->push_back(kSdpDelimiterEqual);
+  message->append(attribute);
+}
+
+static void AppendLineBreak(std::string* message) {
+  message->append(kLineBreak);
+}
+
 // Init |os| to "|type|=|value|".
 static void InitLine(const char type,
                      const std::string& value,
@@ -475,12 +677,12 @@ static void InitAttrLine(const std::string& attribute, std::ostringstream* os) {
 }
 
 // Writes a SDP attribute line based on |attribute| and |value| to |message|.
-static void AddAttributeLine(const std::string& attribute, int value,
+static void AddAttributeLine(const char* attribute, int value,
                              std::string* message) {
-  std::ostringstream os;
-  InitAttrLine(attribute, &os);
-  os << kSdpDelimiterColon << value;
-  AddLine(os.str(), message);
+  AppendAttrLineStart(attribute, message);
+  message->push_back(kSdpDelimiterColon);
+  AppendInteger(value, message);
+  AppendLineBreak(message);
 }
 
 static bool IsLineType(const std::string& message,
@@ -511,40 +713,50 @@ static bool GetLineWithType(const std::string& message, size_t* pos,
   return true;
 }
 
-static bool HasAttribute(const std::string& line,
-                         const std::string& attribute) {
-  return (line.compare(kLinePrefixLength, attribute.size(), attribute) == 0);
+static bool HasAttribute(const std::string& line, const char* attribute) {
+  const size_t attribute_size = strlen(attribute);
+  return line.compare(kLinePrefixLength, attribute_size, attribute,
+                      attribute_size) == 0;
 }
 
 static bool AddSsrcLine(uint32_t ssrc_id,
-                        const std::string& attribute,
+                        const char* attribute,
                         const std::string& value,
                         std::string* message) {
   // RFC 5576
   // a=ssrc:<ssrc-id> <attribute>:<value>
-  std::ostringstream os;
-  InitAttrLine(kAttributeSsrc, &os);
-  os << kSdpDelimiterColon << ssrc_id << kSdpDelimiterSpace
-     << attribute << kSdpDelimiterColon << value;
-  return AddLine(os.str(), message);
+  AppendAttrLineStart(kAttributeSsrc, message);
+  message->push_back(kSdpDelimiterColon);
+  AppendInteger(ssrc_id, message);
+  message->push_back(kSdpDelimiterSpace);
+  message->append(attribute);
+  message->push_back(kSdpDelimiterColon);
+  message->append(value);
+  AppendLineBreak(message);
+  return true;
 }
 
 // Get value only from <attribute>:<value>.
-static bool GetValue(const std::string& message, const std::string& attribute,
-                     std::string* value, SdpParseError* error) {
-  std::string leftpart;
-  if (!rtc::tokenize_first(message, kSdpDelimiterColon, &leftpart, value)) {
-    return ParseFailedGetValue(message, attribute, error);
-  }
+static bool GetValue(const SdpField& message, const char* attribute,
+                     SdpField* value, SdpParseError* error) {
+  SdpField leftpart;
   // The left part should end with the expected attribute.
-  if (leftpart.length() < attribute.length() ||
-      leftpart.compare(leftpart.length() - attribute.length(),
-                       attribute.length(), attribute) != 0) {
-    return ParseFailedGetValue(message, attribute, error);
+  if (!message.TokenizeFirst(kSdpDelimiterColon, &leftpart, value) ||
+      !leftpart.EndsWith(attribute)) {
+    return ParseFailedGetValue(message.str(), attribute, error);
   }
   return true;
 }
 
+static bool GetValue(const std::string& message, const char* attribute,
+                     std::string* value, SdpParseError* error) {
+  SdpField value_field;
+  if (!GetValue(SdpField(message), attribute, &value_field, error))
+    return false;
+  value->assign(value_field.data(), value_field.size());
+  return true;
+}
+
 static bool CaseInsensitiveFind(std::string str1, std::string str2) {
   std::transform(str1.begin(), str1.end(), str1.begin(),
                  ::tolower);
@@ -555,25 +767,40 @@ static bool CaseInsensitiveFind(std::string str1, std::string str2) {
 
 template <class T>
 static bool GetValueFromString(const std::string& line,
-                               const std::string& s,
+                               const SdpField& s,
                                T* t,
                                SdpParseError* error) {
-  if (!rtc::FromString(s, t)) {
+  if (!ParseInteger(s.data(), s.size(), t)) {
     std::ostringstream description;
-    description << "Invalid value: " << s << ".";
+    description << "Invalid value: " << s.str() << ".";
     return ParseFailed(line, description.str(), error);
   }
   return true;
 }
 
+template <class T>
+static bool GetValueFromString(const std::string& line,
+                               const std::string& s,
+                               T* t,
+                               SdpParseError* error) {
+  return GetValueFromString(line, SdpField(s), t, error);
+}
+
 static bool GetPayloadTypeFromString(const std::string& line,
-                                     const std::string& s,
+                                     const SdpField& s,
                                      int* payload_type,
                                      SdpParseError* error) {
   return GetValueFromString(line, s, payload_type, error) &&
       cricket::IsValidRtpPayloadType(*payload_type);
 }
 
+static bool GetPayloadTypeFromString(const std::string& line,
+                                     const std::string& s,
+                                     int* payload_type,
+                                     SdpParseError* error) {
+  return GetPayloadTypeFromString(line, SdpField(s), payload_type, error);
+}
+
 // |msid_stream_id| and |msid_track_id| represent the stream/track ID from the
 // "a=msid" attribute, if it exists. They are empty if the attribute does not
 // exist.
@@ -766,7 +993,11 @@ std::string SdpSerialize(const JsepSessionDescription& jdesc,
     return "";
   }
 
+  // Reserve enough for typical media sections up front, so that the message
+  // is not reallocated repeatedly as it grows.
   std::string message;
+  message.reserve(kSdpSessionSectionSizeEstimate +
+                  desc->contents().size() * kSdpMediaSectionSizeEstimate);
 
   // Session Description.
   AddLine(kSessionVersion, &message);
@@ -1156,23 +1387,23 @@ bool ParseExtmap(const std::string& line,
                  SdpParseError* error) {
   // RFC 5285
   // a=extmap:<value>["/"<direction>] <URI> <extensionattributes>
-  std::vector<std::string> fields;
-  rtc::split(line.substr(kLinePrefixLength),
-                   kSdpDelimiterSpace, &fields);
+  SdpField fields[3];
+  const size_t num_fields =
+      SplitFields(GetLineValue(line), kSdpDelimiterSpace, fields, 3);
   const size_t expected_min_fields = 2;
-  if (fields.size() < expected_min_fields) {
+  if (num_fields < expected_min_fields) {
     return ParseFailedExpectMinFieldNum(line, expected_min_fields, error);
   }
-  std::string uri = fields[1];
+  SdpField uri = fields[1];
 
-  std::string value_direction;
+  SdpField value_direction;
   if (!GetValue(fields[0], kAttributeExtmap, &value_direction, error)) {
     return false;
   }
-  std::vector<std::string> sub_fields;
-  rtc::split(value_direction, kSdpDelimiterSlash, &sub_fields);
+  SdpField sub_field;
+  SplitFields(value_direction, kSdpDelimiterSlash, &sub_field, 1);
   int value = 0;
-  if (!GetValueFromString(line, sub_fields[0], &value, error)) {
+  if (!GetValueFromString(line, sub_field, &value, error)) {
     return false;
   }
 
@@ -1181,7 +1412,7 @@ bool ParseExtmap(const std::string& line,
     // RFC 6904
     // a=extmap:<value["/"<direction>] urn:ietf:params:rtp-hdrext:encrypt <URI> <extensionattributes>
     const size_t expected_min_fields_encrypted = expected_min_fields + 1;
-    if (fields.size() < expected_min_fields_encrypted) {
+    if (num_fields < expected_min_fields_encrypted) {
       return ParseFailedExpectMinFieldNum(line, expected_min_fields_encrypted,
           error);
     }
@@ -1193,7 +1424,7 @@ bool ParseExtmap(const std::string& line,
     }
   }
 
-  *extmap = RtpExtension(uri, value, encrypted);
+  *extmap = RtpExtension(uri.str(), value, encrypted);
   return true;
 }
 
@@ -1444,40 +1675,42 @@ void BuildRtpContentAttributes(const MediaContentDescription* media_desc,
                                const MediaType media_type,
                                bool unified_plan_sdp,
                                std::string* message) {
-  std::ostringstream os;
   // RFC 5285
   // a=extmap:<value>["/"<direction>] <URI> <extensionattributes>
   // The definitions MUST be either all session level or all media level. This
   // implementation uses all media level.
   for (size_t i = 0; i < media_desc->rtp_header_extensions().size(); ++i) {
     const RtpExtension& extension = media_desc->rtp_header_extensions()[i];
-    InitAttrLine(kAttributeExtmap, &os);
-    os << kSdpDelimiterColon << extension.id;
+    AppendAttrLineStart(kAttributeExtmap, message);
+    message->push_back(kSdpDelimiterColon);
+    AppendInteger(extension.id, message);
     if (extension.encrypt) {
-      os << kSdpDelimiterSpace << RtpExtension::kEncryptHeaderExtensionsUri;
+      message->push_back(kSdpDelimiterSpace);
+      message->append(RtpExtension::kEncryptHeaderExtensionsUri);
     }
-    os << kSdpDelimiterSpace << extension.uri;
-    AddLine(os.str(), message);
+    message->push_back(kSdpDelimiterSpace);
+    message->append(extension.uri);
+    AppendLineBreak(message);
   }
 
   // RFC 3264
   // a=sendrecv || a=sendonly || a=sendrecv || a=inactive
   switch (media_desc->direction()) {
     case cricket::MD_INACTIVE:
-      InitAttrLine(kAttributeInactive, &os);
+      AppendAttrLineStart(kAttributeInactive, message);
       break;
     case cricket::MD_SENDONLY:
-      InitAttrLine(kAttributeSendOnly, &os);
+      AppendAttrLineStart(kAttributeSendOnly, message);
       break;
     case cricket::MD_RECVONLY:
-      InitAttrLine(kAttributeRecvOnly, &os);
+      AppendAttrLineStart(kAttributeRecvOnly, message);
       break;
     case cricket::MD_SENDRECV:
     default:
-      InitAttrLine(kAttributeSendRecv, &os);
+      AppendAttrLineStart(kAttributeSendRecv, message);
       break;
   }
-  AddLine(os.str(), message);
+  AppendLineBreak(message);
 
   // draft-ietf-mmusic-msid-11
   // a=msid:<stream id> <track id>
@@ -1488,24 +1721,27 @@ void BuildRtpContentAttributes(const MediaContentDescription* media_desc,
     } else {
       auto track = media_desc->streams().begin();
       const std::string& stream_id = track->sync_label;
-      InitAttrLine(kAttributeMsid, &os);
-      os << kSdpDelimiterColon << stream_id << kSdpDelimiterSpace << track->id;
-      AddLine(os.str(), message);
+      AppendAttrLineStart(kAttributeMsid, message);
+      message->push_back(kSdpDelimiterColon);
+      message->append(stream_id);
+      message->push_back(kSdpDelimiterSpace);
+      message->append(track->id);
+      AppendLineBreak(message);
     }
   }
 
   // RFC 5761
   // a=rtcp-mux
   if (media_desc->rtcp_mux()) {
-    InitAttrLine(kAttributeRtcpMux, &os);
-    AddLine(os.str(), message);
+    AppendAttrLineStart(kAttributeRtcpMux, message);
+    AppendLineBreak(message);
   }
 
   // RFC 5506
   // a=rtcp-rsize
   if (media_desc->rtcp_reduced_size()) {
-    InitAttrLine(kAttributeRtcpReducedSize, &os);
-    AddLine(os.str(), message);
+    AppendAttrLineStart(kAttributeRtcpReducedSize, message);
+    AppendLineBreak(message);
   }
 
   // RFC 4568
@@ -1513,13 +1749,18 @@ void BuildRtpContentAttributes(const MediaContentDescription* media_desc,
   for (std::vector<CryptoParams>::const_iterator it =
            media_desc->cryptos().begin();
        it != media_desc->cryptos().end(); ++it) {
-    InitAttrLine(kAttributeCrypto, &os);
-    os << kSdpDelimiterColon << it->tag << " " << it->cipher_suite << " "
-       << it->key_params;
+    AppendAttrLineStart(kAttributeCrypto, message);
+    message->push_back(kSdpDelimiterColon);
+    AppendInteger(it->tag, message);
+    message->push_back(kSdpDelimiterSpace);
+    message->append(it->cipher_suite);
+    message->push_back(kSdpDelimiterSpace);
+    message->append(it->key_params);
     if (!it->session_params.empty()) {
-      os << " " << it->session_params;
+      message->push_back(kSdpDelimiterSpace);
+      message->append(it->session_params);
     }
-    AddLine(os.str(), message);
+    AppendLineBreak(message);
   }
 
   // RFC 4566
@@ -1542,14 +1783,14 @@ void BuildRtpContentAttributes(const MediaContentDescription* media_desc,
       if (track->ssrc_groups[i].ssrcs.empty()) {
         continue;
       }
-      InitAttrLine(kAttributeSsrcGroup, &os);
-      os << kSdpDelimiterColon << track->ssrc_groups[i].semantics;
-      std::vector<uint32_t>::const_iterator ssrc =
-          track->ssrc_groups[i].ssrcs.begin();
-      for (; ssrc != track->ssrc_groups[i].ssrcs.end(); ++ssrc) {
-        os << kSdpDelimiterSpace << rtc::ToString<uint32_t>(*ssrc);
+      AppendAttrLineStart(kAttributeSsrcGroup, message);
+      message->push_back(kSdpDelimiterColon);
+      message->append(track->ssrc_groups[i].semantics);
+      for (uint32_t ssrc : track->ssrc_groups[i].ssrcs) {
+        message->push_back(kSdpDelimiterSpace);
+        AppendInteger(ssrc, message);
       }
-      AddLine(os.str(), message);
+      AppendLineBreak(message);
     }
     // Build the ssrc lines for each ssrc.
     for (size_t i = 0; i < track->ssrcs.size(); ++i) {
@@ -1564,11 +1805,16 @@ void BuildRtpContentAttributes(const MediaContentDescription* media_desc,
       // The appdata consists of the "id" attribute of a MediaStreamTrack,
       // which corresponds to the "id" attribute of StreamParams.
       const std::string& stream_id = track->sync_label;
-      InitAttrLine(kAttributeSsrc, &os);
-      os << kSdpDelimiterColon << ssrc << kSdpDelimiterSpace
-         << kSsrcAttributeMsid << kSdpDelimiterColon << stream_id
-         << kSdpDelimiterSpace << track->id;
-      AddLine(os.str(), message);
+      AppendAttrLineStart(kAttributeSsrc, message);
+      message->push_back(kSdpDelimiterColon);
+      AppendInteger(ssrc, message);
+      message->push_back(kSdpDelimiterSpace);
+      message->append(kSsrcAttributeMsid);
+      message->push_back(kSdpDelimiterColon);
+      message->append(stream_id);
+      message->push_back(kSdpDelimiterSpace);
+      message->append(track->id);
+      AppendLineBreak(message);
 
       // TODO(ronghuawu): Remove below code which is for backward
       // compatibility.
@@ -1582,48 +1828,36 @@ void BuildRtpContentAttributes(const MediaContentDescription* media_desc,
   }
 }
 
-void WriteFmtpHeader(int payload_type, std::ostringstream* os) {
+void WriteFmtpHeader(int payload_type, std::string* message) {
   // fmtp header: a=fmtp:|payload_type| <parameters>
   // Add a=fmtp
-  InitAttrLine(kAttributeFmtp, os);
+  AppendAttrLineStart(kAttributeFmtp, message);
   // Add :|payload_type|
-  *os << kSdpDelimiterColon << payload_type;
+  message->push_back(kSdpDelimiterColon);
+  AppendInteger(payload_type, message);
 }
 
-void WriteRtcpFbHeader(int payload_type, std::ostringstream* os) {
+void WriteRtcpFbHeader(int payload_type, std::string* message) {
   // rtcp-fb header: a=rtcp-fb:|payload_type|
   // <parameters>/<ccm <ccm_parameters>>
   // Add a=rtcp-fb
-  InitAttrLine(kAttributeRtcpFb, os);
+  AppendAttrLineStart(kAttributeRtcpFb, message);
   // Add :
-  *os << kSdpDelimiterColon;
+  message->push_back(kSdpDelimiterColon);
   if (payload_type == kWildcardPayloadType) {
-    *os << "*";
+    message->push_back('*');
   } else {
-    *os << payload_type;
+    AppendInteger(payload_type, message);
   }
 }
 
 void WriteFmtpParameter(const std::string& parameter_name,
                         const std::string& parameter_value,
-                        std::ostringstream* os) {
+                        std::string* message) {
   // fmtp parameters: |parameter_name|=|parameter_value|
-  *os << parameter_name << kSdpDelimiterEqual << parameter_value;
-}
-
-void WriteFmtpParameters(const cricket::CodecParameterMap& parameters,
-                         std::ostringstream* os) {
-  for (cricket::CodecParameterMap::const_iterator fmtp = parameters.begin();
-       fmtp != parameters.end(); ++fmtp) {
-    // Parameters are a semicolon-separated list, no spaces.
-    // The list is separated from the header by a space.
-    if (fmtp == parameters.begin()) {
-      *os << kSdpDelimiterSpace;
-    } else {
-      *os << kSdpDelimiterSemicolon;
-    }
-    WriteFmtpParameter(fmtp->first, fmtp->second, os);
-  }
+  message->append(parameter_name);
+  message->push_back(kSdpDelimiterEqual);
+  message->append(parameter_value);
 }
 
 bool IsFmtpParam(const std::string& name) {
@@ -1634,45 +1868,48 @@ bool IsFmtpParam(const std::string& name) {
   return name != kCodecParamPTime && name != kCodecParamMaxPTime;
 }
 
-// Retreives fmtp parameters from |params|, which may contain other parameters
-// as well, and puts them in |fmtp_parameters|.
-void GetFmtpParams(const cricket::CodecParameterMap& params,
-                   cricket::CodecParameterMap* fmtp_parameters) {
-  for (cricket::CodecParameterMap::const_iterator iter = params.begin();
-       iter != params.end(); ++iter) {
-    if (IsFmtpParam(iter->first)) {
-      (*fmtp_parameters)[iter->first] = iter->second;
-    }
+// Writes the fmtp parameters of |params|, which may contain other parameters
+// as well.
+void WriteFmtpParameters(const cricket::CodecParameterMap& params,
+                         std::string* message) {
+  bool first = true;
+  for (const auto& param : params) {
+    if (!IsFmtpParam(param.first))
+      continue;
+    // Parameters are a semicolon-separated list, no spaces.
+    // The list is separated from the header by a space.
+    message->push_back(first ? kSdpDelimiterSpace : kSdpDelimiterSemicolon);
+    first = false;
+    WriteFmtpParameter(param.first, param.second, message);
   }
 }
 
 template <class T>
 void AddFmtpLine(const T& codec, std::string* message) {
-  cricket::CodecParameterMap fmtp_parameters;
-  GetFmtpParams(codec.params, &fmtp_parameters);
-  if (fmtp_parameters.empty()) {
+  if (std::none_of(codec.params.begin(), codec.params.end(),
+                   [](const cricket::CodecParameterMap::value_type& param) {
+                     return IsFmtpParam(param.first);
+                   })) {
     // No need to add an fmtp if it will have no (optional) parameters.
     return;
   }
-  std::ostringstream os;
-  WriteFmtpHeader(codec.id, &os);
-  WriteFmtpParameters(fmtp_parameters, &os);
-  AddLine(os.str(), message);
-  return;
+  WriteFmtpHeader(codec.id, message);
+  WriteFmtpParameters(codec.params, message);
+  AppendLineBreak(message);
 }
 
 template <class T>
 void AddRtcpFbLines(const T& codec, std::string* message) {
-  for (std::vector<cricket::FeedbackParam>::const_iterator iter =
-           codec.feedback_params.params().begin();
-       iter != codec.feedback_params.params().end(); ++iter) {
-    std::ostringstream os;
-    WriteRtcpFbHeader(codec.id, &os);
-    os << " " << iter->id();
-    if (!iter->param().empty()) {
-      os << " " << iter->param();
+  for (const cricket::FeedbackParam& param :
+       codec.feedback_params.params()) {
+    WriteRtcpFbHeader(codec.id, message);
+    message->push_back(kSdpDelimiterSpace);
+    message->append(param.id());
+    if (!param.param().empty()) {
+      message->push_back(kSdpDelimiterSpace);
+      message->append(param.param());
     }
-    AddLine(os.str(), message);
+    AppendLineBreak(message);
   }
 }
 
@@ -1712,10 +1949,7 @@ bool GetParameter(const std::string& name,
   if (found == params.end()) {
     return false;
   }
-  if (!rtc::FromString(found->second, value)) {
-    return false;
-  }
-  return true;
+  return ParseInteger(found->second.data(), found->second.size(), value);
 }
 
 void BuildRtpMap(const MediaContentDescription* media_desc,
@@ -1723,7 +1957,6 @@ void BuildRtpMap(const MediaContentDescription* media_desc,
                  std::string* message) {
   RTC_DCHECK(message != NULL);
   RTC_DCHECK(media_desc != NULL);
-  std::ostringstream os;
   if (media_type == cricket::MEDIA_TYPE_VIDEO) {
     const VideoContentDescription* video_desc =
         static_cast<const VideoContentDescription*>(media_desc);
@@ -1734,10 +1967,14 @@ void BuildRtpMap(const MediaContentDescription* media_desc,
       // a=rtpmap:<payload type> <encoding name>/<clock rate>
       // [/<encodingparameters>]
       if (it->id != kWildcardPayloadType) {
-        InitAttrLine(kAttributeRtpmap, &os);
-        os << kSdpDelimiterColon << it->id << " " << it->name << "/"
-           << cricket::kVideoCodecClockrate;
-        AddLine(os.str(), message);
+        AppendAttrLineStart(kAttributeRtpmap, message);
+        message->push_back(kSdpDelimiterColon);
+        AppendInteger(it->id, message);
+        message->push_back(kSdpDelimiterSpace);
+        message->append(it->name);
+        message->push_back(kSdpDelimiterSlash);
+        AppendInteger(cricket::kVideoCodecClockrate, message);
+        AppendLineBreak(message);
       }
       AddRtcpFbLines(*it, message);
       AddFmtpLine(*it, message);
@@ -1755,13 +1992,18 @@ void BuildRtpMap(const MediaContentDescription* media_desc,
       // RFC 4566
       // a=rtpmap:<payload type> <encoding name>/<clock rate>
       // [/<encodingparameters>]
-      InitAttrLine(kAttributeRtpmap, &os);
-      os << kSdpDelimiterColon << it->id << " ";
-      os << it->name << "/" << it->clockrate;
+      AppendAttrLineStart(kAttributeRtpmap, message);
+      message->push_back(kSdpDelimiterColon);
+      AppendInteger(it->id, message);
+      message->push_back(kSdpDelimiterSpace);
+      message->append(it->name);
+      message->push_back(kSdpDelimiterSlash);
+      AppendInteger(it->clockrate, message);
       if (it->channels != 1) {
-        os << "/" << it->channels;
+        message->push_back(kSdpDelimiterSlash);
+        AppendInteger(it->channels, message);
       }
-      AddLine(os.str(), message);
+      AppendLineBreak(message);
       AddRtcpFbLines(*it, message);
       AddFmtpLine(*it, message);
       int minptime = 0;
@@ -1801,10 +2043,14 @@ void BuildRtpMap(const MediaContentDescription* media_desc,
       // RFC 4566
       // a=rtpmap:<payload type> <encoding name>/<clock rate>
       // [/<encodingparameters>]
-      InitAttrLine(kAttributeRtpmap, &os);
-      os << kSdpDelimiterColon << it->id << " "
-         << it->name << "/" << it->clockrate;
-      AddLine(os.str(), message);
+      AppendAttrLineStart(kAttributeRtpmap, message);
+      message->push_back(kSdpDelimiterColon);
+      AppendInteger(it->id, message);
+      message->push_back(kSdpDelimiterSpace);
+      message->append(it->name);
+      message->push_back(kSdpDelimiterSlash);
+      AppendInteger(it->clockrate, message);
+      AppendLineBreak(message);
     }
   }
 }
@@ -2360,12 +2606,11 @@ bool ParseMediaDescription(const std::string& message,
   while (GetLineWithType(message, pos, &line, kLineTypeMedia)) {
     ++mline_index;
 
-    std::vector<std::string> fields;
-    rtc::split(line.substr(kLinePrefixLength),
-                     kSdpDelimiterSpace, &fields);
-
     const size_t expected_min_fields = 4;
-    if (fields.size() < expected_min_fields) {
+    SdpField fields[expected_min_fields];
+    const size_t num_fields = SplitFields(
+        GetLineValue(line), kSdpDelimiterSpace, fields, expected_min_fields);
+    if (num_fields < expected_min_fields) {
       return ParseFailedExpectMinFieldNum(line, expected_min_fields, error);
     }
     bool port_rejected = false;
@@ -2377,23 +2622,28 @@ bool ParseMediaDescription(const std::string& message,
     }
 
     int port = 0;
-    if (!rtc::FromString<int>(fields[1], &port) || !IsValidPort(port)) {
+    if (!ParseInteger(fields[1].data(), fields[1].size(), &port) ||
+        !IsValidPort(port)) {
       return ParseFailed(line, "The port number is invalid", error);
     }
-    std::string protocol = fields[2];
+    std::string protocol = fields[2].str();
 
     // <fmt>
     std::vector<int> payload_types;
     if (IsRtp(protocol)) {
-      for (size_t j = 3 ; j < fields.size(); ++j) {
+      SdpTokenizer tokenizer(GetLineValue(line), kSdpDelimiterSpace);
+      SdpField field;
+      for (size_t j = 0; tokenizer.Next(&field); ++j) {
+        if (j < 3)
+          continue;
         // TODO(wu): Remove when below bug is fixed.
         // https://bugzilla.mozilla.org/show_bug.cgi?id=996329
-        if (fields[j].empty() && j == fields.size() - 1) {
+        if (field.empty() && j == num_fields - 1) {
           continue;
         }
 
         int pl = 0;
-        if (!GetPayloadTypeFromString(line, fields[j], &pl, error)) {
+        if (!GetPayloadTypeFromString(line, field, &pl, error)) {
           return false;
         }
         payload_types.push_back(pl);
@@ -2430,7 +2680,7 @@ bool ParseMediaDescription(const std::string& message,
 
       if (data_desc && IsDtlsSctp(protocol)) {
         int p;
-        if (rtc::FromString(fields[3], &p)) {
+        if (ParseInteger(fields[3].data(), fields[3].size(), &p)) {
           if (!AddSctpDataCodec(data_desc, p)) {
             return false;
           }
@@ -2977,15 +3227,15 @@ bool ParseSsrcAttribute(const std::string& line, SsrcInfoVec* ssrc_infos,
   // RFC 5576
   // a=ssrc:<ssrc-id> <attribute>
   // a=ssrc:<ssrc-id> <attribute>:<value>
-  std::string field1, field2;
-  if (!rtc::tokenize_first(line.substr(kLinePrefixLength), kSdpDelimiterSpace,
-                           &field1, &field2)) {
+  SdpField field1, field2;
+  if (!GetLineValue(line).TokenizeFirst(kSdpDelimiterSpace, &field1,
+                                        &field2)) {
     const size_t expected_fields = 2;
     return ParseFailedExpectFieldNum(line, expected_fields, error);
   }
 
   // ssrc:<ssrc-id>
-  std::string ssrc_id_s;
+  SdpField ssrc_id_s;
   if (!GetValue(field1, kAttributeSsrc, &ssrc_id_s, error)) {
     return false;
   }
@@ -2994,12 +3244,12 @@ bool ParseSsrcAttribute(const std::string& line, SsrcInfoVec* ssrc_infos,
     return false;
   }
 
-  std::string attribute;
-  std::string value;
-  if (!rtc::tokenize_first(field2, kSdpDelimiterColon, &attribute, &value)) {
+  SdpField attribute;
+  SdpField value;
+  if (!field2.TokenizeFirst(kSdpDelimiterColon, &attribute, &value)) {
     std::ostringstream description;
-    description << "Failed to get the ssrc attribute value from " << field2
-                << ". Expected format <attribute>:<value>.";
+    description << "Failed to get the ssrc attribute value from "
+                << field2.str() << ". Expected format <attribute>:<value>.";
     return ParseFailed(line, description.str(), error);
   }
 
@@ -3022,29 +3272,30 @@ bool ParseSsrcAttribute(const std::string& line, SsrcInfoVec* ssrc_infos,
   if (attribute == kSsrcAttributeCname) {
     // RFC 5576
     // cname:<value>
-    ssrc_info->cname = value;
+    ssrc_info->cname.assign(value.data(), value.size());
   } else if (attribute == kSsrcAttributeMsid) {
     // draft-alvestrand-mmusic-msid-00
     // "msid:" identifier [ " " appdata ]
-    std::vector<std::string> fields;
-    rtc::split(value, kSdpDelimiterSpace, &fields);
-    if (fields.size() < 1 || fields.size() > 2) {
+    SdpField fields[2];
+    const size_t num_fields =
+        SplitFields(value, kSdpDelimiterSpace, fields, 2);
+    if (num_fields < 1 || num_fields > 2) {
       return ParseFailed(line,
                          "Expected format \"msid:<identifier>[ <appdata>]\".",
                          error);
     }
-    ssrc_info->stream_id = fields[0];
-    if (fields.size() == 2) {
-      ssrc_info->track_id = fields[1];
+    ssrc_info->stream_id.assign(fields[0].data(), fields[0].size());
+    if (num_fields == 2) {
+      ssrc_info->track_id.assign(fields[1].data(), fields[1].size());
     }
   } else if (attribute == kSsrcAttributeMslabel) {
     // draft-alvestrand-rtcweb-mid-01
     // mslabel:<value>
-    ssrc_info->mslabel = value;
+    ssrc_info->mslabel.assign(value.data(), value.size());
   } else if (attribute == kSSrcAttributeLabel) {
     // The label isn't defined.
     // label:<value>
-    ssrc_info->label = value;
+    ssrc_info->label.assign(value.data(), value.size());
   }
   return true;
 }
@@ -3055,26 +3306,26 @@ bool ParseSsrcGroupAttribute(const std::string& line,
   RTC_DCHECK(ssrc_groups != NULL);
   // RFC 5576
   // a=ssrc-group:<semantics> <ssrc-id> ...
-  std::vector<std::string> fields;
-  rtc::split(line.substr(kLinePrefixLength),
-                   kSdpDelimiterSpace, &fields);
+  SdpTokenizer tokenizer(GetLineValue(line), kSdpDelimiterSpace);
   const size_t expected_min_fields = 2;
-  if (fields.size() < expected_min_fields) {
+  if (tokenizer.RemainingFields() < expected_min_fields) {
     return ParseFailedExpectMinFieldNum(line, expected_min_fields, error);
   }
-  std::string semantics;
-  if (!GetValue(fields[0], kAttributeSsrcGroup, &semantics, error)) {
+  SdpField field;
+  SdpField semantics;
+  tokenizer.Next(&field);
+  if (!GetValue(field, kAttributeSsrcGroup, &semantics, error)) {
     return false;
   }
   std::vector<uint32_t> ssrcs;
-  for (size_t i = 1; i < fields.size(); ++i) {
+  while (tokenizer.Next(&field)) {
     uint32_t ssrc = 0;
-    if (!GetValueFromString(line, fields[i], &ssrc, error)) {
+    if (!GetValueFromString(line, field, &ssrc, error)) {
       return false;
     }
     ssrcs.push_back(ssrc);
   }
-  ssrc_groups->push_back(SsrcGroup(semantics, ssrcs));
+  ssrc_groups->push_back(SsrcGroup(semantics.str(), ssrcs));
   return true;
 }
 
@@ -3148,16 +3399,15 @@ bool ParseRtpmapAttribute(const std::string& line,
                           const std::vector<int>& payload_types,
                           MediaContentDescription* media_desc,
                           SdpParseError* error) {
-  std::vector<std::string> fields;
-  rtc::split(line.substr(kLinePrefixLength),
-                   kSdpDelimiterSpace, &fields);
   // RFC 4566
   // a=rtpmap:<payload type> <encoding name>/<clock rate>[/<encodingparameters>]
   const size_t expected_min_fields = 2;
-  if (fields.size() < expected_min_fields) {
+  SdpField fields[expected_min_fields];
+  if (SplitFields(GetLineValue(line), kSdpDelimiterSpace, fields,
+                  expected_min_fields) < expected_min_fields) {
     return ParseFailedExpectMinFieldNum(line, expected_min_fields, error);
   }
-  std::string payload_type_value;
+  SdpField payload_type_value;
   if (!GetValue(fields[0], kAttributeRtpmap, &payload_type_value, error)) {
     return false;
   }
@@ -3173,18 +3423,19 @@ bool ParseRtpmapAttribute(const std::string& line,
                     << "<fmt> of the m-line: " << line;
     return true;
   }
-  const std::string& encoder = fields[1];
-  std::vector<std::string> codec_params;
-  rtc::split(encoder, '/', &codec_params);
+  const SdpField& encoder = fields[1];
+  SdpField codec_params[3];
+  const size_t num_codec_params =
+      SplitFields(encoder, kSdpDelimiterSlash, codec_params, 3);
   // <encoding name>/<clock rate>[/<encodingparameters>]
   // 2 mandatory fields
-  if (codec_params.size() < 2 || codec_params.size() > 3) {
+  if (num_codec_params < 2 || num_codec_params > 3) {
     return ParseFailed(line,
                        "Expected format \"<encoding name>/<clock rate>"
                        "[/<encodingparameters>]\".",
                        error);
   }
-  const std::string& encoding_name = codec_params[0];
+  const std::string encoding_name = codec_params[0].str();
   int clock_rate = 0;
   if (!GetValueFromString(line, codec_params[1], &clock_rate, error)) {
     return false;
@@ -3201,7 +3452,7 @@ bool ParseRtpmapAttribute(const std::string& line,
     // omitted if the number of channels is one, provided that no
     // additional parameters are needed.
     size_t channels = 1;
-    if (codec_params.size() == 3) {
+    if (num_codec_params == 3) {
       if (!GetValueFromString(line, codec_params[2], &channels, error)) {
         return false;
       }
@@ -3218,10 +3469,11 @@ bool ParseRtpmapAttribute(const std::string& line,
   return true;
 }
 
-bool ParseFmtpParam(const std::string& line, std::string* parameter,
-                    std::string* value, SdpParseError* error) {
-  if (!rtc::tokenize_first(line, kSdpDelimiterEqual, parameter, value)) {
-    ParseFailed(line, "Unable to parse fmtp parameter. \'=\' missing.", error);
+static bool ParseFmtpParam(const SdpField& line, SdpField* parameter,
+                           SdpField* value, SdpParseError* error) {
+  if (!line.TokenizeFirst(kSdpDelimiterEqual, parameter, value)) {
+    ParseFailed(line.str(), "Unable to parse fmtp parameter. \'=\' missing.",
+                error);
     return false;
   }
   // a=fmtp:<payload_type> <param1>=<value1>; <param2>=<value2>; ...
@@ -3236,49 +3488,48 @@ bool ParseFmtpAttributes(const std::string& line, const MediaType media_type,
     return true;
   }
 
-  std::string line_payload;
-  std::string line_params;
+  SdpField line_payload;
+  SdpField line_params;
 
   // RFC 5576
   // a=fmtp:<format> <format specific parameters>
   // At least two fields, whereas the second one is any of the optional
   // parameters.
-  if (!rtc::tokenize_first(line.substr(kLinePrefixLength), kSdpDelimiterSpace,
-                           &line_payload, &line_params)) {
+  if (!GetLineValue(line).TokenizeFirst(kSdpDelimiterSpace, &line_payload,
+                                        &line_params)) {
     ParseFailedExpectMinFieldNum(line, 2, error);
     return false;
   }
 
   // Parse out the payload information.
-  std::string payload_type_str;
+  SdpField payload_type_str;
   if (!GetValue(line_payload, kAttributeFmtp, &payload_type_str, error)) {
     return false;
   }
 
   int payload_type = 0;
-  if (!GetPayloadTypeFromString(line_payload, payload_type_str, &payload_type,
-                                error)) {
+  if (!GetPayloadTypeFromString(line_payload.str(), payload_type_str,
+                                &payload_type, error)) {
     return false;
   }
 
   // Parse out format specific parameters.
-  std::vector<std::string> fields;
-  rtc::split(line_params, kSdpDelimiterSemicolon, &fields);
-
+  SdpTokenizer tokenizer(line_params, kSdpDelimiterSemicolon);
+  SdpField field;
   cricket::CodecParameterMap codec_params;
-  for (auto& iter : fields) {
-    if (iter.find(kSdpDelimiterEqual) == std::string::npos) {
+  while (tokenizer.Next(&field)) {
+    if (!memchr(field.data(), kSdpDelimiterEqual, field.size())) {
       // Only fmtps with equals are currently supported. Other fmtp types
       // should be ignored. Unknown fmtps do not constitute an error.
       continue;
     }
 
-    std::string name;
-    std::string value;
-    if (!ParseFmtpParam(rtc::string_trim(iter), &name, &value, error)) {
+    SdpField name;
+    SdpField value;
+    if (!ParseFmtpParam(field.Trim(), &name, &value, error)) {
       return false;
     }
-    codec_params[name] = value;
+    codec_params[name.str()].assign(value.data(), value.size());
   }
 
   if (media_type == cricket::MEDIA_TYPE_AUDIO) {
@@ -3298,14 +3549,14 @@ bool ParseRtcpFbAttribute(const std::string& line, const MediaType media_type,
       media_type != cricket::MEDIA_TYPE_VIDEO) {
     return true;
   }
-  std::vector<std::string> rtcp_fb_fields;
-  rtc::split(line.c_str(), kSdpDelimiterSpace, &rtcp_fb_fields);
-  if (rtcp_fb_fields.size() < 2) {
+  SdpTokenizer tokenizer(SdpField(line), kSdpDelimiterSpace);
+  if (tokenizer.RemainingFields() < 2) {
     return ParseFailedGetValue(line, kAttributeRtcpFb, error);
   }
-  std::string payload_type_string;
-  if (!GetValue(rtcp_fb_fields[0], kAttributeRtcpFb, &payload_type_string,
-                error)) {
+  SdpField field;
+  SdpField payload_type_string;
+  tokenizer.Next(&field);
+  if (!GetValue(field, kAttributeRtcpFb, &payload_type_string, error)) {
     return false;
   }
   int payload_type = kWildcardPayloadType;
@@ -3315,12 +3566,11 @@ bool ParseRtcpFbAttribute(const std::string& line, const MediaType media_type,
       return false;
     }
   }
-  std::string id = rtcp_fb_fields[1];
-  std::string param = "";
-  for (std::vector<std::string>::iterator iter = rtcp_fb_fields.begin() + 2;
-       iter != rtcp_fb_fields.end(); ++iter) {
-    param.append(*iter);
-  }
+  tokenizer.Next(&field);
+  std::string id = field.str();
+  std::string param;
+  while (tokenizer.Next(&field))
+    param.append(field.data(), field.size());
   const cricket::FeedbackParam feedback_param(id, param);
 
   if (media_type == cricket::MEDIA_TYPE_AUDIO) {
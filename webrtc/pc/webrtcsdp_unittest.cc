@@ -8,8 +8,10 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <algorithm>
 #include <memory>
 #include <set>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -26,6 +28,8 @@
 #include "webrtc/rtc_base/sslfingerprint.h"
 #include "webrtc/rtc_base/stringencode.h"
 #include "webrtc/rtc_base/stringutils.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
 #ifdef WEBRTC_ANDROID
 #include "webrtc/pc/test/androidtestinitializer.h"
 #endif
@@ -3583,3 +3587,155 @@ TEST_F(WebRtcSdpTest, SerializeAndDeserializeWithConnectionAddress) {
   EXPECT_EQ(video_desc_->connection_address().ToString(),
             video_desc->connection_address().ToString());
 }
+
+// Builds an offer with |num_sections| bundled m-sections, alternating between
+// audio and simulcast video, shaped like what an SFU sends to a receiver.
+static std::string MakeLargeSdp(int num_sections) {
+  std::ostringstream os;
+  os << "v=0\r\n"
+     << "o=- 18446744069414584320 18446462598732840960 IN IP4 127.0.0.1\r\n"
+     << "s=-\r\n"
+     << "t=0 0\r\n"
+     << "a=group:BUNDLE";
+  for (int i = 0; i < num_sections; ++i)
+    os << " m" << i;
+  os << "\r\n"
+     << "a=msid-semantic: WMS\r\n";
+  uint32_t ssrc = 1000;
+  for (int i = 0; i < num_sections; ++i) {
+    const bool audio = i % 2 == 0;
+    if (audio) {
+      os << "m=audio 9 UDP/TLS/RTP/SAVPF 111 103 104 9 0 8 106 105 13 126\r\n";
+    } else {
+      os << "m=video 9 UDP/TLS/RTP/SAVPF";
+      for (int pt = 96; pt < 108; ++pt)
+        os << " " << pt;
+      os << "\r\n";
+    }
+    os << "c=IN IP4 0.0.0.0\r\n"
+       << "a=rtcp:9 IN IP4 0.0.0.0\r\n"
+       << "a=ice-ufrag:ufrag_voice\r\n"
+       << "a=ice-pwd:pwd_voice\r\n"
+       << "a=mid:m" << i << "\r\n"
+       << "a=extmap:1 urn:ietf:params:rtp-hdrext:toffset\r\n"
+       << "a=extmap:3 http://www.webrtc.org/experiments/rtp-hdrext/"
+          "abs-send-time\r\n"
+       << "a=sendrecv\r\n"
+       << "a=rtcp-mux\r\n";
+    std::string stream_id = "stream" + rtc::ToString(i);
+    std::string track_id = "track" + rtc::ToString(i);
+    if (audio) {
+      os << "a=rtpmap:111 opus/48000/2\r\n"
+         << "a=rtcp-fb:111 transport-cc\r\n"
+         << "a=fmtp:111 minptime=10;useinbandfec=1\r\n"
+         << "a=rtpmap:103 ISAC/16000\r\n"
+         << "a=rtpmap:104 ISAC/32000\r\n"
+         << "a=rtpmap:9 G722/8000\r\n"
+         << "a=rtpmap:0 PCMU/8000\r\n"
+         << "a=rtpmap:8 PCMA/8000\r\n"
+         << "a=rtpmap:106 CN/32000\r\n"
+         << "a=rtpmap:105 CN/16000\r\n"
+         << "a=rtpmap:13 CN/8000\r\n"
+         << "a=rtpmap:126 telephone-event/8000\r\n"
+         << "a=ssrc:" << ssrc << " cname:stream_cname\r\n"
+         << "a=ssrc:" << ssrc << " msid:" << stream_id << " " << track_id
+         << "\r\n";
+      ++ssrc;
+      continue;
+    }
+    static const char* const kVideoCodecs[] = {"VP8", "VP9", "H264", "H264",
+                                               "red", "ulpfec"};
+    for (int j = 0; j < 6; ++j) {
+      int pt = 96 + 2 * j;
+      os << "a=rtpmap:" << pt << " " << kVideoCodecs[j] << "/90000\r\n";
+      if (j < 4) {
+        os << "a=rtcp-fb:" << pt << " goog-remb\r\n"
+           << "a=rtcp-fb:" << pt << " transport-cc\r\n"
+           << "a=rtcp-fb:" << pt << " ccm fir\r\n"
+           << "a=rtcp-fb:" << pt << " nack\r\n"
+           << "a=rtcp-fb:" << pt << " nack pli\r\n";
+      }
+      if (j == 2 || j == 3) {
+        os << "a=fmtp:" << pt << " level-asymmetry-allowed=1;"
+           << "packetization-mode=" << (j - 2)
+           << ";profile-level-id=42e01f\r\n";
+      }
+      os << "a=rtpmap:" << (pt + 1) << " rtx/90000\r\n"
+         << "a=fmtp:" << (pt + 1) << " apt=" << pt << "\r\n";
+    }
+    // Three simulcast layers, each with an RTX stream.
+    os << "a=ssrc-group:SIM " << ssrc << " " << (ssrc + 1) << " "
+       << (ssrc + 2) << "\r\n";
+    for (uint32_t layer = ssrc; layer < ssrc + 3; ++layer) {
+      os << "a=ssrc-group:FID " << layer << " " << (layer + 3) << "\r\n";
+    }
+    for (uint32_t s = ssrc; s < ssrc + 6; ++s) {
+      os << "a=ssrc:" << s << " cname:stream_cname\r\n"
+         << "a=ssrc:" << s << " msid:" << stream_id << " " << track_id
+         << "\r\n";
+    }
+    ssrc += 6;
+  }
+  return os.str();
+}
+
+// A large description with many m= sections survives a round trip.
+TEST_F(WebRtcSdpTest, LargeSdpRoundTrip) {
+  const int kNumSections = 20;
+  JsepSessionDescription jdesc(kDummyString);
+  SdpParseError error;
+  ASSERT_TRUE(webrtc::SdpDeserialize(MakeLargeSdp(kNumSections), &jdesc,
+                                     &error))
+      << error.line << ": " << error.description;
+  ASSERT_EQ(static_cast<size_t>(kNumSections),
+            jdesc.description()->contents().size());
+
+  // The serialized description must parse back to the same structure.
+  const std::string serialized = webrtc::SdpSerialize(jdesc, false);
+  JsepSessionDescription round_trip(kDummyString);
+  ASSERT_TRUE(SdpDeserialize(serialized, &round_trip));
+  EXPECT_EQ(static_cast<size_t>(kNumSections),
+            round_trip.description()->contents().size());
+  EXPECT_EQ(serialized, webrtc::SdpSerialize(round_trip, false));
+}
+
+// Measures SdpDeserialize and SdpSerialize on descriptions of growing size.
+// Disabled since it only reports timings; run it with
+// --gtest_also_run_disabled_tests.
+TEST_F(WebRtcSdpTest, DISABLED_LargeSdpPerformance) {
+  for (int num_sections : {1, 20, 200}) {
+    const std::string sdp = MakeLargeSdp(num_sections);
+    // Keep the total amount of work roughly constant across sizes.
+    const int kIterations = std::max(2, 400 / num_sections);
+
+    int64_t deserialize_ns = 0;
+    int64_t serialize_ns = 0;
+    for (int i = 0; i < kIterations; ++i) {
+      JsepSessionDescription jdesc(kDummyString);
+      SdpParseError error;
+      int64_t start_ns = rtc::SystemTimeNanos();
+      ASSERT_TRUE(webrtc::SdpDeserialize(sdp, &jdesc, &error))
+          << error.line << ": " << error.description;
+      deserialize_ns += rtc::SystemTimeNanos() - start_ns;
+
+      start_ns = rtc::SystemTimeNanos();
+      webrtc::SdpSerialize(jdesc, false);
+      serialize_ns += rtc::SystemTimeNanos() - start_ns;
+    }
+
+    const std::string modifier =
+        "_" + rtc::ToString(num_sections) + "_msections";
+    webrtc::test::PrintResult("sdp_size", modifier, "", sdp.size(), "bytes",
+                              false);
+    webrtc::test::PrintResult(
+        "sdp_deserialize", modifier, "",
+        static_cast<size_t>(deserialize_ns / kIterations /
+                            rtc::kNumNanosecsPerMicrosec),
+        "us", false);
+    webrtc::test::PrintResult(
+        "sdp_serialize", modifier, "",
+        static_cast<size_t>(serialize_ns / kIterations /
+                            rtc::kNumNanosecsPerMicrosec),
+        "us", false);
+  }
+}
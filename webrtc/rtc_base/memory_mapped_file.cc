@@ -0,0 +1,92 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/rtc_base/memory_mapped_file.h"
+
+#if defined(WEBRTC_WIN)
+#include "webrtc/rtc_base/win32.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "webrtc/rtc_base/checks.h"
+
+namespace rtc {
+
+// static
+std::unique_ptr<MemoryMappedFile> MemoryMappedFile::Open(
+    const std::string& path) {
+#if defined(WEBRTC_WIN)
+  HANDLE file = ::CreateFile(ToUtf16(path).c_str(), GENERIC_READ,
+                             FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return nullptr;
+  LARGE_INTEGER file_size;
+  if (!::GetFileSizeEx(file, &file_size)) {
+    ::CloseHandle(file);
+    return nullptr;
+  }
+  const size_t size = static_cast<size_t>(file_size.QuadPart);
+  if (size == 0) {
+    ::CloseHandle(file);
+    return std::unique_ptr<MemoryMappedFile>(new MemoryMappedFile(nullptr, 0));
+  }
+  HANDLE mapping =
+      ::CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  ::CloseHandle(file);
+  if (!mapping)
+    return nullptr;
+  // The view keeps the mapping alive until it is unmapped.
+  void* data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  ::CloseHandle(mapping);
+  if (!data)
+    return nullptr;
+#else
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return nullptr;
+  struct stat file_stat;
+  if (::fstat(fd, &file_stat) != 0) {
+    ::close(fd);
+    return nullptr;
+  }
+  const size_t size = static_cast<size_t>(file_stat.st_size);
+  if (size == 0) {
+    ::close(fd);
+    return std::unique_ptr<MemoryMappedFile>(new MemoryMappedFile(nullptr, 0));
+  }
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the file is closed.
+  ::close(fd);
+  if (data == MAP_FAILED)
+    return nullptr;
+#endif
+  return std::unique_ptr<MemoryMappedFile>(
+      new MemoryMappedFile(static_cast<const uint8_t*>(data), size));
+}
+
+MemoryMappedFile::MemoryMappedFile(const uint8_t* data, size_t size)
+    : data_(data), size_(size) {}
+
+MemoryMappedFile::~MemoryMappedFile() {
+  if (!data_)
+    return;
+#if defined(WEBRTC_WIN)
+  RTC_CHECK(::UnmapViewOfFile(data_));
+#else
+  RTC_CHECK_EQ(0, ::munmap(const_cast<uint8_t*>(data_), size_));
+#endif
+}
+
+}  // namespace rtc
@@ -0,0 +1,48 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_RTC_BASE_MEMORY_MAPPED_FILE_H_
+#define WEBRTC_RTC_BASE_MEMORY_MAPPED_FILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "webrtc/rtc_base/constructormagic.h"
+
+namespace rtc {
+
+// Maps a whole file into memory for reading. The contents can then be read
+// from any number of threads without seeking or copying, and the pages are
+// shared with the OS file cache. The file must not be modified while mapped.
+class MemoryMappedFile {
+ public:
+  // Returns null if the file can't be opened or mapped.
+  static std::unique_ptr<MemoryMappedFile> Open(const std::string& path);
+  ~MemoryMappedFile();
+
+  // Null for an empty file.
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  MemoryMappedFile(const uint8_t* data, size_t size);
+
+  const uint8_t* const data_;
+  const size_t size_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(MemoryMappedFile);
+};
+
+}  // namespace rtc
+
+#endif  // WEBRTC_RTC_BASE_MEMORY_MAPPED_FILE_H_
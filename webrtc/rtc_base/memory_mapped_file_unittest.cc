@@ -0,0 +1,72 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/rtc_base/memory_mapped_file.h"
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "webrtc/rtc_base/platform_file.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/fileutils.h"
+
+namespace rtc {
+
+namespace {
+
+std::string WriteTempFile(const std::vector<uint8_t>& contents) {
+  const std::string path =
+      webrtc::test::TempFilename(webrtc::test::OutputPath(), "mapped_file");
+  FILE* file = fopen(path.c_str(), "wb");
+  EXPECT_TRUE(file);
+  if (!contents.empty()) {
+    EXPECT_EQ(contents.size(),
+              fwrite(contents.data(), 1, contents.size(), file));
+  }
+  fclose(file);
+  return path;
+}
+
+}  // namespace
+
+TEST(MemoryMappedFileTest, MapsWholeFile) {
+  std::vector<uint8_t> contents(100000);
+  for (size_t i = 0; i < contents.size(); ++i)
+    contents[i] = static_cast<uint8_t>(i * 7);
+  const std::string path = WriteTempFile(contents);
+
+  std::unique_ptr<MemoryMappedFile> file = MemoryMappedFile::Open(path);
+  ASSERT_TRUE(file);
+  ASSERT_EQ(contents.size(), file->size());
+  EXPECT_EQ(contents,
+            std::vector<uint8_t>(file->data(), file->data() + file->size()));
+  file.reset();
+  EXPECT_TRUE(RemoveFile(path));
+}
+
+TEST(MemoryMappedFileTest, MapsEmptyFile) {
+  const std::string path = WriteTempFile(std::vector<uint8_t>());
+
+  std::unique_ptr<MemoryMappedFile> file = MemoryMappedFile::Open(path);
+  ASSERT_TRUE(file);
+  EXPECT_EQ(0u, file->size());
+  EXPECT_EQ(nullptr, file->data());
+  file.reset();
+  EXPECT_TRUE(RemoveFile(path));
+}
+
+TEST(MemoryMappedFileTest, FailsForMissingFile) {
+  EXPECT_FALSE(MemoryMappedFile::Open(
+      webrtc::test::OutputPath() + "memory_mapped_file_does_not_exist"));
+}
+
+}  // namespace rtc
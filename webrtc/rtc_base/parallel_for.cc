@@ -0,0 +1,61 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/rtc_base/parallel_for.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "webrtc/rtc_base/platform_thread.h"
+
+namespace rtc {
+
+namespace {
+
+struct TaskQueue {
+  TaskQueue(size_t num_tasks, FunctionView<void(size_t)> task)
+      : num_tasks(num_tasks), task(task), next_task(0) {}
+
+  const size_t num_tasks;
+  const FunctionView<void(size_t)> task;
+  std::atomic<size_t> next_task;
+};
+
+void RunTasks(void* obj) {
+  TaskQueue* queue = static_cast<TaskQueue*>(obj);
+  for (size_t i = queue->next_task++; i < queue->num_tasks;
+       i = queue->next_task++) {
+    queue->task(i);
+  }
+}
+
+}  // namespace
+
+int ParallelFor(size_t num_tasks,
+                int num_threads,
+                const char* thread_name,
+                FunctionView<void(size_t)> task) {
+  const int used_threads = static_cast<int>(
+      std::min<size_t>(std::max(num_threads, 1), num_tasks));
+  TaskQueue queue(num_tasks, task);
+  std::vector<std::unique_ptr<PlatformThread>> threads;
+  for (int i = 1; i < used_threads; ++i) {
+    threads.emplace_back(new PlatformThread(&RunTasks, &queue, thread_name));
+    threads.back()->Start();
+  }
+  RunTasks(&queue);
+  for (auto& thread : threads)
+    thread->Stop();
+  return used_threads;
+}
+
+}  // namespace rtc
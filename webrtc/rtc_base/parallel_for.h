@@ -0,0 +1,35 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_RTC_BASE_PARALLEL_FOR_H_
+#define WEBRTC_RTC_BASE_PARALLEL_FOR_H_
+
+#include <stddef.h>
+
+#include "webrtc/rtc_base/function_view.h"
+
+namespace rtc {
+
+// Calls |task| once for each index in [0, |num_tasks|) on up to
+// |num_threads| threads, counting the calling thread, and returns when all
+// calls have returned. Each thread takes the next index that hasn't been
+// started, so a few long tasks don't hold up the rest. Intended for tools that
+// run many independent jobs, e.g. simulations or per-frame metrics; |task|
+// must be safe to call concurrently for different indices.
+//
+// Returns the number of threads used, which is at most |num_tasks|.
+int ParallelFor(size_t num_tasks,
+                int num_threads,
+                const char* thread_name,
+                FunctionView<void(size_t)> task);
+
+}  // namespace rtc
+
+#endif  // WEBRTC_RTC_BASE_PARALLEL_FOR_H_
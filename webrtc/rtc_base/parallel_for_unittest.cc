@@ -0,0 +1,59 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/rtc_base/parallel_for.h"
+
+#include <atomic>
+#include <vector>
+
+#include "webrtc/rtc_base/platform_thread.h"
+#include "webrtc/test/gtest.h"
+
+namespace rtc {
+
+TEST(ParallelForTest, RunsEachTaskOnce) {
+  for (int num_threads : {1, 2, 4, 16}) {
+    std::vector<std::atomic<int>> runs(100);
+    for (auto& count : runs)
+      count = 0;
+    const int used_threads = ParallelFor(
+        runs.size(), num_threads, "ParallelForTest",
+        [&runs](size_t i) { ++runs[i]; });
+    EXPECT_EQ(num_threads, used_threads);
+    for (size_t i = 0; i < runs.size(); ++i) {
+      EXPECT_EQ(1, runs[i].load())
+          << "Task " << i << ", " << num_threads << " threads";
+    }
+  }
+}
+
+TEST(ParallelForTest, UsesAtMostOneThreadPerTask) {
+  std::atomic<int> runs(0);
+  EXPECT_EQ(3, ParallelFor(3, 8, "ParallelForTest", [&runs](size_t) {
+              ++runs;
+            }));
+  EXPECT_EQ(3, runs.load());
+
+  EXPECT_EQ(0, ParallelFor(0, 8, "ParallelForTest", [&runs](size_t) {
+              ++runs;
+            }));
+  EXPECT_EQ(3, runs.load());
+}
+
+TEST(ParallelForTest, RunsOnCallingThreadWithOneThread) {
+  const PlatformThreadRef caller = CurrentThreadRef();
+  bool on_caller = true;
+  ParallelFor(10, 1, "ParallelForTest", [&](size_t) {
+    on_caller = on_caller && IsThreadRefEqual(caller, CurrentThreadRef());
+  });
+  EXPECT_TRUE(on_caller);
+}
+
+}  // namespace rtc
@@ -589,7 +589,7 @@ std::string EventLogAnalyzer::GetStreamName(StreamId stream_id) const {
 }
 
 void EventLogAnalyzer::CreatePacketGraph(PacketDirection desired_direction,
-                                         Plot* plot) {
+                                         Plot* plot) const {
   for (auto& kv : rtp_packets_) {
     StreamId stream_id = kv.first;
     const std::vector<LoggedRtpPacket>& packet_stream = kv.second;
@@ -623,7 +623,7 @@ void EventLogAnalyzer::CreateAccumulatedPacketsTimeSeries(
     PacketDirection desired_direction,
     Plot* plot,
     const std::map<StreamId, std::vector<T>>& packets,
-    const std::string& label_prefix) {
+    const std::string& label_prefix) const {
   for (auto& kv : packets) {
     StreamId stream_id = kv.first;
     const std::vector<T>& packet_stream = kv.second;
@@ -647,7 +647,7 @@ void EventLogAnalyzer::CreateAccumulatedPacketsTimeSeries(
 
 void EventLogAnalyzer::CreateAccumulatedPacketsGraph(
     PacketDirection desired_direction,
-    Plot* plot) {
+    Plot* plot) const {
   CreateAccumulatedPacketsTimeSeries(desired_direction, plot, rtp_packets_,
                                      "RTP");
   CreateAccumulatedPacketsTimeSeries(desired_direction, plot, rtcp_packets_,
@@ -663,7 +663,7 @@ void EventLogAnalyzer::CreateAccumulatedPacketsGraph(
 }
 
 // For each SSRC, plot the time between the consecutive playouts.
-void EventLogAnalyzer::CreatePlayoutGraph(Plot* plot) {
+void EventLogAnalyzer::CreatePlayoutGraph(Plot* plot) const {
   std::map<uint32_t, TimeSeries> time_series;
   std::map<uint32_t, uint64_t> last_playout;
 
@@ -702,7 +702,7 @@ void EventLogAnalyzer::CreatePlayoutGraph(Plot* plot) {
 }
 
 // For audio SSRCs, plot the audio level.
-void EventLogAnalyzer::CreateAudioLevelGraph(Plot* plot) {
+void EventLogAnalyzer::CreateAudioLevelGraph(Plot* plot) const {
   std::map<StreamId, TimeSeries> time_series;
 
   for (auto& kv : rtp_packets_) {
@@ -735,7 +735,7 @@ void EventLogAnalyzer::CreateAudioLevelGraph(Plot* plot) {
 }
 
 // For each SSRC, plot the time between the consecutive playouts.
-void EventLogAnalyzer::CreateSequenceNumberGraph(Plot* plot) {
+void EventLogAnalyzer::CreateSequenceNumberGraph(Plot* plot) const {
   for (auto& kv : rtp_packets_) {
     StreamId stream_id = kv.first;
     const std::vector<LoggedRtpPacket>& packet_stream = kv.second;
@@ -764,7 +764,7 @@ void EventLogAnalyzer::CreateSequenceNumberGraph(Plot* plot) {
   plot->SetTitle("Sequence number");
 }
 
-void EventLogAnalyzer::CreateIncomingPacketLossGraph(Plot* plot) {
+void EventLogAnalyzer::CreateIncomingPacketLossGraph(Plot* plot) const {
   for (auto& kv : rtp_packets_) {
     StreamId stream_id = kv.first;
     const std::vector<LoggedRtpPacket>& packet_stream = kv.second;
@@ -821,7 +821,7 @@ void EventLogAnalyzer::CreateIncomingPacketLossGraph(Plot* plot) {
   plot->SetTitle("Estimated incoming loss rate");
 }
 
-void EventLogAnalyzer::CreateIncomingDelayDeltaGraph(Plot* plot) {
+void EventLogAnalyzer::CreateIncomingDelayDeltaGraph(Plot* plot) const {
   for (auto& kv : rtp_packets_) {
     StreamId stream_id = kv.first;
     const std::vector<LoggedRtpPacket>& packet_stream = kv.second;
@@ -854,7 +854,7 @@ void EventLogAnalyzer::CreateIncomingDelayDeltaGraph(Plot* plot) {
   plot->SetTitle("Network latency difference between consecutive packets");
 }
 
-void EventLogAnalyzer::CreateIncomingDelayGraph(Plot* plot) {
+void EventLogAnalyzer::CreateIncomingDelayGraph(Plot* plot) const {
   for (auto& kv : rtp_packets_) {
     StreamId stream_id = kv.first;
     const std::vector<LoggedRtpPacket>& packet_stream = kv.second;
@@ -888,7 +888,7 @@ void EventLogAnalyzer::CreateIncomingDelayGraph(Plot* plot) {
 }
 
 // Plot the fraction of packets lost (as perceived by the loss-based BWE).
-void EventLogAnalyzer::CreateFractionLossGraph(Plot* plot) {
+void EventLogAnalyzer::CreateFractionLossGraph(Plot* plot) const {
   TimeSeries time_series("Fraction lost", LINE_DOT_GRAPH);
   for (auto& bwe_update : bwe_loss_updates_) {
     float x = static_cast<float>(bwe_update.timestamp - begin_time_) / 1000000;
@@ -907,7 +907,7 @@ void EventLogAnalyzer::CreateFractionLossGraph(Plot* plot) {
 void EventLogAnalyzer::CreateTotalBitrateGraph(
     PacketDirection desired_direction,
     Plot* plot,
-    bool show_detector_state) {
+    bool show_detector_state) const {
   struct TimestampSize {
     TimestampSize(uint64_t t, size_t s) : timestamp(t), size(s) {}
     uint64_t timestamp;
@@ -1074,7 +1074,7 @@ void EventLogAnalyzer::CreateTotalBitrateGraph(
 // For each SSRC, plot the bandwidth used by that stream.
 void EventLogAnalyzer::CreateStreamBitrateGraph(
     PacketDirection desired_direction,
-    Plot* plot) {
+    Plot* plot) const {
   for (auto& kv : rtp_packets_) {
     StreamId stream_id = kv.first;
     const std::vector<LoggedRtpPacket>& packet_stream = kv.second;
@@ -1103,7 +1103,7 @@ void EventLogAnalyzer::CreateStreamBitrateGraph(
   }
 }
 
-void EventLogAnalyzer::CreateBweSimulationGraph(Plot* plot) {
+void EventLogAnalyzer::CreateBweSimulationGraph(Plot* plot) const {
   std::multimap<uint64_t, const LoggedRtpPacket*> outgoing_rtp;
   std::multimap<uint64_t, const LoggedRtcpPacket*> incoming_rtcp;
 
@@ -1225,7 +1225,7 @@ void EventLogAnalyzer::CreateBweSimulationGraph(Plot* plot) {
   plot->SetTitle("Simulated BWE behavior");
 }
 
-void EventLogAnalyzer::CreateNetworkDelayFeedbackGraph(Plot* plot) {
+void EventLogAnalyzer::CreateNetworkDelayFeedbackGraph(Plot* plot) const {
   std::multimap<uint64_t, const LoggedRtpPacket*> outgoing_rtp;
   std::multimap<uint64_t, const LoggedRtcpPacket*> incoming_rtcp;
 
@@ -1353,7 +1353,7 @@ std::vector<std::pair<int64_t, int64_t>> EventLogAnalyzer::GetFrameTimestamps()
   return timestamps;
 }
 
-void EventLogAnalyzer::CreateTimestampGraph(Plot* plot) {
+void EventLogAnalyzer::CreateTimestampGraph(Plot* plot) const {
   for (const auto& kv : rtp_packets_) {
     const std::vector<LoggedRtpPacket>& rtp_packets = kv.second;
     StreamId stream_id = kv.first;
@@ -1394,7 +1394,7 @@ void EventLogAnalyzer::CreateTimestampGraph(Plot* plot) {
   plot->SetTitle("Timestamps");
 }
 
-void EventLogAnalyzer::CreateAudioEncoderTargetBitrateGraph(Plot* plot) {
+void EventLogAnalyzer::CreateAudioEncoderTargetBitrateGraph(Plot* plot) const {
   TimeSeries time_series("Audio encoder target bitrate", LINE_DOT_GRAPH);
   ProcessPoints<AudioNetworkAdaptationEvent>(
       [](const AudioNetworkAdaptationEvent& ana_event) -> rtc::Optional<float> {
@@ -1410,7 +1410,7 @@ void EventLogAnalyzer::CreateAudioEncoderTargetBitrateGraph(Plot* plot) {
   plot->SetTitle("Reported audio encoder target bitrate");
 }
 
-void EventLogAnalyzer::CreateAudioEncoderFrameLengthGraph(Plot* plot) {
+void EventLogAnalyzer::CreateAudioEncoderFrameLengthGraph(Plot* plot) const {
   TimeSeries time_series("Audio encoder frame length", LINE_DOT_GRAPH);
   ProcessPoints<AudioNetworkAdaptationEvent>(
       [](const AudioNetworkAdaptationEvent& ana_event) {
@@ -1426,7 +1426,7 @@ void EventLogAnalyzer::CreateAudioEncoderFrameLengthGraph(Plot* plot) {
   plot->SetTitle("Reported audio encoder frame length");
 }
 
-void EventLogAnalyzer::CreateAudioEncoderPacketLossGraph(Plot* plot) {
+void EventLogAnalyzer::CreateAudioEncoderPacketLossGraph(Plot* plot) const {
   TimeSeries time_series("Audio encoder uplink packet loss fraction",
                          LINE_DOT_GRAPH);
   ProcessPoints<AudioNetworkAdaptationEvent>(
@@ -1444,7 +1444,7 @@ void EventLogAnalyzer::CreateAudioEncoderPacketLossGraph(Plot* plot) {
   plot->SetTitle("Reported audio encoder lost packets");
 }
 
-void EventLogAnalyzer::CreateAudioEncoderEnableFecGraph(Plot* plot) {
+void EventLogAnalyzer::CreateAudioEncoderEnableFecGraph(Plot* plot) const {
   TimeSeries time_series("Audio encoder FEC", LINE_DOT_GRAPH);
   ProcessPoints<AudioNetworkAdaptationEvent>(
       [](const AudioNetworkAdaptationEvent& ana_event) {
@@ -1460,7 +1460,7 @@ void EventLogAnalyzer::CreateAudioEncoderEnableFecGraph(Plot* plot) {
   plot->SetTitle("Reported audio encoder FEC");
 }
 
-void EventLogAnalyzer::CreateAudioEncoderEnableDtxGraph(Plot* plot) {
+void EventLogAnalyzer::CreateAudioEncoderEnableDtxGraph(Plot* plot) const {
   TimeSeries time_series("Audio encoder DTX", LINE_DOT_GRAPH);
   ProcessPoints<AudioNetworkAdaptationEvent>(
       [](const AudioNetworkAdaptationEvent& ana_event) {
@@ -1476,7 +1476,7 @@ void EventLogAnalyzer::CreateAudioEncoderEnableDtxGraph(Plot* plot) {
   plot->SetTitle("Reported audio encoder DTX");
 }
 
-void EventLogAnalyzer::CreateAudioEncoderNumChannelsGraph(Plot* plot) {
+void EventLogAnalyzer::CreateAudioEncoderNumChannelsGraph(Plot* plot) const {
   TimeSeries time_series("Audio encoder number of channels", LINE_DOT_GRAPH);
   ProcessPoints<AudioNetworkAdaptationEvent>(
       [](const AudioNetworkAdaptationEvent& ana_event) {
@@ -1634,7 +1634,7 @@ std::unique_ptr<test::NetEqDelayAnalyzer> CreateNetEqTestAndRun(
 void EventLogAnalyzer::CreateAudioJitterBufferGraph(
     const std::string& replacement_file_name,
     int file_sample_rate_hz,
-    Plot* plot) {
+    Plot* plot) const {
   const auto& incoming_audio_kv = std::find_if(
       rtp_packets_.begin(), rtp_packets_.end(),
       [this](std::pair<StreamId, std::vector<LoggedRtpPacket>> kv) {
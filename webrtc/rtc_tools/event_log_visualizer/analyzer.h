@@ -66,44 +66,48 @@ class EventLogAnalyzer {
   // modified while the EventLogAnalyzer is being used.
   explicit EventLogAnalyzer(const ParsedRtcEventLog& log);
 
-  void CreatePacketGraph(PacketDirection desired_direction, Plot* plot);
+  // The Create*Graph() methods only read the packet tables built by the
+  // constructor, so different graphs may be created concurrently from several
+  // threads as long as each call is given its own Plot.
+  void CreatePacketGraph(PacketDirection desired_direction, Plot* plot) const;
 
   void CreateAccumulatedPacketsGraph(PacketDirection desired_direction,
-                                     Plot* plot);
+                                     Plot* plot) const;
 
-  void CreatePlayoutGraph(Plot* plot);
+  void CreatePlayoutGraph(Plot* plot) const;
 
-  void CreateAudioLevelGraph(Plot* plot);
+  void CreateAudioLevelGraph(Plot* plot) const;
 
-  void CreateSequenceNumberGraph(Plot* plot);
+  void CreateSequenceNumberGraph(Plot* plot) const;
 
-  void CreateIncomingPacketLossGraph(Plot* plot);
+  void CreateIncomingPacketLossGraph(Plot* plot) const;
 
-  void CreateIncomingDelayDeltaGraph(Plot* plot);
-  void CreateIncomingDelayGraph(Plot* plot);
+  void CreateIncomingDelayDeltaGraph(Plot* plot) const;
+  void CreateIncomingDelayGraph(Plot* plot) const;
 
-  void CreateFractionLossGraph(Plot* plot);
+  void CreateFractionLossGraph(Plot* plot) const;
 
   void CreateTotalBitrateGraph(PacketDirection desired_direction,
                                Plot* plot,
-                               bool show_detector_state = false);
+                               bool show_detector_state = false) const;
 
-  void CreateStreamBitrateGraph(PacketDirection desired_direction, Plot* plot);
+  void CreateStreamBitrateGraph(PacketDirection desired_direction,
+                                Plot* plot) const;
 
-  void CreateBweSimulationGraph(Plot* plot);
+  void CreateBweSimulationGraph(Plot* plot) const;
 
-  void CreateNetworkDelayFeedbackGraph(Plot* plot);
-  void CreateTimestampGraph(Plot* plot);
+  void CreateNetworkDelayFeedbackGraph(Plot* plot) const;
+  void CreateTimestampGraph(Plot* plot) const;
 
-  void CreateAudioEncoderTargetBitrateGraph(Plot* plot);
-  void CreateAudioEncoderFrameLengthGraph(Plot* plot);
-  void CreateAudioEncoderPacketLossGraph(Plot* plot);
-  void CreateAudioEncoderEnableFecGraph(Plot* plot);
-  void CreateAudioEncoderEnableDtxGraph(Plot* plot);
-  void CreateAudioEncoderNumChannelsGraph(Plot* plot);
+  void CreateAudioEncoderTargetBitrateGraph(Plot* plot) const;
+  void CreateAudioEncoderFrameLengthGraph(Plot* plot) const;
+  void CreateAudioEncoderPacketLossGraph(Plot* plot) const;
+  void CreateAudioEncoderEnableFecGraph(Plot* plot) const;
+  void CreateAudioEncoderEnableDtxGraph(Plot* plot) const;
+  void CreateAudioEncoderNumChannelsGraph(Plot* plot) const;
   void CreateAudioJitterBufferGraph(const std::string& replacement_file_name,
                                     int file_sample_rate_hz,
-                                    Plot* plot);
+                                    Plot* plot) const;
 
   // Returns a vector of capture and arrival timestamps for the video frames
   // of the stream with the most number of frames.
@@ -135,7 +139,7 @@ class EventLogAnalyzer {
       PacketDirection desired_direction,
       Plot* plot,
       const std::map<StreamId, std::vector<T>>& packets,
-      const std::string& label_prefix);
+      const std::string& label_prefix) const;
 
   bool IsRtxSsrc(StreamId stream_id) const;
 
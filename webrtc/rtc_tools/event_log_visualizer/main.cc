@@ -8,13 +8,24 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "webrtc/logging/rtc_event_log/rtc_event_log_parser.h"
 #include "webrtc/rtc_base/flags.h"
+#include "webrtc/rtc_base/parallel_for.h"
+#include "webrtc/rtc_base/timeutils.h"
 #include "webrtc/rtc_tools/event_log_visualizer/analyzer.h"
 #include "webrtc/rtc_tools/event_log_visualizer/plot_base.h"
 #include "webrtc/rtc_tools/event_log_visualizer/plot_python.h"
+#include "webrtc/system_wrappers/include/cpu_info.h"
 #include "webrtc/test/field_trial.h"
 #include "webrtc/test/testsupport/fileutils.h"
 
@@ -114,6 +125,16 @@ DEFINE_string(
 DEFINE_string(wav_filename,
               "",
               "Path to wav file used for simulation of jitter buffer");
+DEFINE_int(num_threads,
+           0,
+           "Number of threads used to create the plots. 0 means one thread "
+           "per CPU core.");
+DEFINE_string(output_dir,
+              "",
+              "Analyze every log file given on the command line, and every "
+              "file in each directory given on the command line, and write "
+              "the python script for <name> to <output_dir>/<name>.py instead "
+              "of to stdout.");
 DEFINE_bool(help, false, "prints this message");
 
 DEFINE_bool(show_detector_state,
@@ -123,45 +144,14 @@ DEFINE_bool(show_detector_state,
 
 void SetAllPlotFlags(bool setting);
 
+namespace {
 
-int main(int argc, char* argv[]) {
-  std::string program_name = argv[0];
-  std::string usage =
-      "A tool for visualizing WebRTC event logs.\n"
-      "Example usage:\n" +
-      program_name + " <logfile> | python\n" + "Run " + program_name +
-      " --help for a list of command line options\n";
-
-  // Parse command line flags without removing them. We're only interested in
-  // the |plot_profile| flag.
-  rtc::FlagList::SetFlagsFromCommandLine(&argc, argv, false);
-  if (strcmp(FLAG_plot_profile, "all") == 0) {
-    SetAllPlotFlags(true);
-  } else if (strcmp(FLAG_plot_profile, "none") == 0) {
-    SetAllPlotFlags(false);
-  } else if (strcmp(FLAG_plot_profile, "default") == 0) {
-    // Do nothing.
-  } else {
-    rtc::Flag* plot_profile_flag = rtc::FlagList::Lookup("plot_profile");
-    RTC_CHECK(plot_profile_flag);
-    plot_profile_flag->Print(false);
-  }
-  // Parse the remaining flags. They are applied relative to the chosen profile.
-  rtc::FlagList::SetFlagsFromCommandLine(&argc, argv, true);
-
-  if (argc != 2 || FLAG_help) {
-    // Print usage information.
-    std::cout << usage;
-    if (FLAG_help)
-      rtc::FlagList::Print(nullptr, false);
-    return 0;
-  }
-
-  webrtc::test::SetExecutablePath(argv[0]);
-  webrtc::test::InitFieldTrialsFromString(FLAG_force_fieldtrials);
-
-  std::string filename = argv[1];
+using webrtc::PacketDirection;
+using webrtc::plotting::Plot;
 
+// Creates the plots selected by the command line flags for |filename| and
+// writes them to |output| as a python script.
+void AnalyzeLog(const std::string& filename, FILE* output, int num_threads) {
   webrtc::ParsedRtcEventLog parsed_log;
 
   if (!parsed_log.ParseFile(filename)) {
@@ -171,91 +161,141 @@ int main(int argc, char* argv[]) {
               << std::endl;
   }
 
+  // The analyzer builds its per-stream packet tables once. The plots only
+  // read them, so they can be created in parallel.
   webrtc::plotting::EventLogAnalyzer analyzer(parsed_log);
   std::unique_ptr<webrtc::plotting::PlotCollection> collection(
-      new webrtc::plotting::PythonPlotCollection());
+      new webrtc::plotting::PythonPlotCollection(output));
+  std::vector<std::function<void()>> plot_tasks;
+  auto add_plot = [&collection,
+                   &plot_tasks](std::function<void(Plot*)> create_plot) {
+    Plot* plot = collection->AppendNewPlot();
+    plot_tasks.push_back([create_plot, plot]() { create_plot(plot); });
+  };
 
   if (FLAG_plot_incoming_packet_sizes) {
-    analyzer.CreatePacketGraph(webrtc::PacketDirection::kIncomingPacket,
-                               collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreatePacketGraph(PacketDirection::kIncomingPacket, plot);
+    });
   }
   if (FLAG_plot_outgoing_packet_sizes) {
-    analyzer.CreatePacketGraph(webrtc::PacketDirection::kOutgoingPacket,
-                               collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreatePacketGraph(PacketDirection::kOutgoingPacket, plot);
+    });
   }
   if (FLAG_plot_incoming_packet_count) {
-    analyzer.CreateAccumulatedPacketsGraph(
-        webrtc::PacketDirection::kIncomingPacket, collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateAccumulatedPacketsGraph(PacketDirection::kIncomingPacket,
+                                             plot);
+    });
   }
   if (FLAG_plot_outgoing_packet_count) {
-    analyzer.CreateAccumulatedPacketsGraph(
-        webrtc::PacketDirection::kOutgoingPacket, collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateAccumulatedPacketsGraph(PacketDirection::kOutgoingPacket,
+                                             plot);
+    });
   }
   if (FLAG_plot_audio_playout) {
-    analyzer.CreatePlayoutGraph(collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreatePlayoutGraph(plot);
+    });
   }
   if (FLAG_plot_audio_level) {
-    analyzer.CreateAudioLevelGraph(collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateAudioLevelGraph(plot);
+    });
   }
   if (FLAG_plot_incoming_sequence_number_delta) {
-    analyzer.CreateSequenceNumberGraph(collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateSequenceNumberGraph(plot);
+    });
   }
   if (FLAG_plot_incoming_delay_delta) {
-    analyzer.CreateIncomingDelayDeltaGraph(collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateIncomingDelayDeltaGraph(plot);
+    });
   }
   if (FLAG_plot_incoming_delay) {
-    analyzer.CreateIncomingDelayGraph(collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateIncomingDelayGraph(plot);
+    });
   }
   if (FLAG_plot_incoming_loss_rate) {
-    analyzer.CreateIncomingPacketLossGraph(collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateIncomingPacketLossGraph(plot);
+    });
   }
   if (FLAG_plot_incoming_bitrate) {
-    analyzer.CreateTotalBitrateGraph(webrtc::PacketDirection::kIncomingPacket,
-                                     collection->AppendNewPlot(),
-                                     FLAG_show_detector_state);
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateTotalBitrateGraph(PacketDirection::kIncomingPacket, plot,
+                                       FLAG_show_detector_state);
+    });
   }
   if (FLAG_plot_outgoing_bitrate) {
-    analyzer.CreateTotalBitrateGraph(webrtc::PacketDirection::kOutgoingPacket,
-                                     collection->AppendNewPlot(),
-                                     FLAG_show_detector_state);
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateTotalBitrateGraph(PacketDirection::kOutgoingPacket, plot,
+                                       FLAG_show_detector_state);
+    });
   }
   if (FLAG_plot_incoming_stream_bitrate) {
-    analyzer.CreateStreamBitrateGraph(webrtc::PacketDirection::kIncomingPacket,
-                                      collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateStreamBitrateGraph(PacketDirection::kIncomingPacket, plot);
+    });
   }
   if (FLAG_plot_outgoing_stream_bitrate) {
-    analyzer.CreateStreamBitrateGraph(webrtc::PacketDirection::kOutgoingPacket,
-                                      collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateStreamBitrateGraph(PacketDirection::kOutgoingPacket, plot);
+    });
   }
   if (FLAG_plot_simulated_sendside_bwe) {
-    analyzer.CreateBweSimulationGraph(collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateBweSimulationGraph(plot);
+    });
   }
   if (FLAG_plot_network_delay_feedback) {
-    analyzer.CreateNetworkDelayFeedbackGraph(collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateNetworkDelayFeedbackGraph(plot);
+    });
   }
   if (FLAG_plot_fraction_loss_feedback) {
-    analyzer.CreateFractionLossGraph(collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateFractionLossGraph(plot);
+    });
   }
   if (FLAG_plot_timestamps) {
-    analyzer.CreateTimestampGraph(collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateTimestampGraph(plot);
+    });
   }
   if (FLAG_plot_audio_encoder_bitrate_bps) {
-    analyzer.CreateAudioEncoderTargetBitrateGraph(collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateAudioEncoderTargetBitrateGraph(plot);
+    });
   }
   if (FLAG_plot_audio_encoder_frame_length_ms) {
-    analyzer.CreateAudioEncoderFrameLengthGraph(collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateAudioEncoderFrameLengthGraph(plot);
+    });
   }
   if (FLAG_plot_audio_encoder_packet_loss) {
-    analyzer.CreateAudioEncoderPacketLossGraph(collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateAudioEncoderPacketLossGraph(plot);
+    });
   }
   if (FLAG_plot_audio_encoder_fec) {
-    analyzer.CreateAudioEncoderEnableFecGraph(collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateAudioEncoderEnableFecGraph(plot);
+    });
   }
   if (FLAG_plot_audio_encoder_dtx) {
-    analyzer.CreateAudioEncoderEnableDtxGraph(collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateAudioEncoderEnableDtxGraph(plot);
+    });
   }
   if (FLAG_plot_audio_encoder_num_channels) {
-    analyzer.CreateAudioEncoderNumChannelsGraph(collection->AppendNewPlot());
+    add_plot([&analyzer](Plot* plot) {
+      analyzer.CreateAudioEncoderNumChannelsGraph(plot);
+    });
   }
   if (FLAG_plot_audio_jitter_buffer) {
     std::string wav_path;
@@ -265,11 +305,114 @@ int main(int argc, char* argv[]) {
       wav_path = webrtc::test::ResourcePath(
           "audio_processing/conversational_speech/EN_script2_F_sp2_B1", "wav");
     }
-    analyzer.CreateAudioJitterBufferGraph(wav_path, 48000,
-                                          collection->AppendNewPlot());
+    add_plot([&analyzer, wav_path](Plot* plot) {
+      analyzer.CreateAudioJitterBufferGraph(wav_path, 48000, plot);
+    });
   }
 
+  const int64_t start_ms = rtc::TimeMillis();
+  // A long simulation on one thread doesn't hold up the remaining plots.
+  rtc::ParallelFor(plot_tasks.size(), num_threads, "PlotWorker",
+                   [&plot_tasks](size_t i) { plot_tasks[i](); });
+  std::cerr << "Created " << plot_tasks.size() << " plots for " << filename
+            << " in " << rtc::TimeMillis() - start_ms << " ms using "
+            << num_threads << " threads." << std::endl;
+
   collection->Draw();
+}
+
+// Returns the log files in |paths|, replacing each directory by the files it
+// contains.
+std::vector<std::string> ListLogFiles(const std::vector<std::string>& paths) {
+  std::vector<std::string> files;
+  for (const std::string& path : paths) {
+    if (!webrtc::test::DirExists(path)) {
+      files.push_back(path);
+      continue;
+    }
+    rtc::Optional<std::vector<std::string>> directory_files =
+        webrtc::test::ReadDirectory(path);
+    if (!directory_files) {
+      std::cerr << "Could not read directory " << path << std::endl;
+      continue;
+    }
+    std::sort(directory_files->begin(), directory_files->end());
+    for (const std::string& file : *directory_files) {
+      if (!webrtc::test::DirExists(file))
+        files.push_back(file);
+    }
+  }
+  return files;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string program_name = argv[0];
+  std::string usage =
+      "A tool for visualizing WebRTC event logs.\n"
+      "Example usage:\n" +
+      program_name + " <logfile> | python\n" + program_name +
+      " --output_dir=<dir> <logfile or directory>...\n" + "Run " +
+      program_name + " --help for a list of command line options\n";
+
+  // Parse command line flags without removing them. We're only interested in
+  // the |plot_profile| flag.
+  rtc::FlagList::SetFlagsFromCommandLine(&argc, argv, false);
+  if (strcmp(FLAG_plot_profile, "all") == 0) {
+    SetAllPlotFlags(true);
+  } else if (strcmp(FLAG_plot_profile, "none") == 0) {
+    SetAllPlotFlags(false);
+  } else if (strcmp(FLAG_plot_profile, "default") == 0) {
+    // Do nothing.
+  } else {
+    rtc::Flag* plot_profile_flag = rtc::FlagList::Lookup("plot_profile");
+    RTC_CHECK(plot_profile_flag);
+    plot_profile_flag->Print(false);
+  }
+  // Parse the remaining flags. They are applied relative to the chosen profile.
+  rtc::FlagList::SetFlagsFromCommandLine(&argc, argv, true);
+
+  const bool batch_mode = strlen(FLAG_output_dir) > 0;
+  if ((batch_mode ? argc < 2 : argc != 2) || FLAG_help) {
+    // Print usage information.
+    std::cout << usage;
+    if (FLAG_help)
+      rtc::FlagList::Print(nullptr, false);
+    return 0;
+  }
+
+  webrtc::test::SetExecutablePath(argv[0]);
+  webrtc::test::InitFieldTrialsFromString(FLAG_force_fieldtrials);
+
+  const int num_threads =
+      FLAG_num_threads > 0
+          ? FLAG_num_threads
+          : static_cast<int>(webrtc::CpuInfo::DetectNumberOfCores());
+
+  if (!batch_mode) {
+    AnalyzeLog(argv[1], stdout, num_threads);
+    return 0;
+  }
+
+  const std::vector<std::string> log_files =
+      ListLogFiles(std::vector<std::string>(argv + 1, argv + argc));
+  const int64_t start_ms = rtc::TimeMillis();
+  for (const std::string& log_file : log_files) {
+    const std::string output_file =
+        std::string(FLAG_output_dir) + "/" +
+        log_file.substr(log_file.find_last_of("/\\") + 1) + ".py";
+    FILE* output = fopen(output_file.c_str(), "w");
+    if (!output) {
+      std::cerr << "Could not open " << output_file << " for writing."
+                << std::endl;
+      return 1;
+    }
+    AnalyzeLog(log_file, output, num_threads);
+    fclose(output);
+  }
+  std::cerr << "Analyzed " << log_files.size() << " logs in "
+            << rtc::TimeMillis() - start_ms << " ms." << std::endl;
 
   return 0;
 }
@@ -10,6 +10,8 @@
 #ifndef WEBRTC_RTC_TOOLS_EVENT_LOG_VISUALIZER_PLOT_PYTHON_H_
 #define WEBRTC_RTC_TOOLS_EVENT_LOG_VISUALIZER_PLOT_PYTHON_H_
 
+#include <stdio.h>
+
 #include "webrtc/rtc_tools/event_log_visualizer/plot_base.h"
 
 namespace webrtc {
@@ -17,17 +19,26 @@ namespace plotting {
 
 class PythonPlot final : public Plot {
  public:
-  PythonPlot();
+  explicit PythonPlot(FILE* output);
   ~PythonPlot() override;
   void Draw() override;
+
+ private:
+  FILE* const output_;
 };
 
 class PythonPlotCollection final : public PlotCollection {
  public:
   PythonPlotCollection();
+  // Writes the python script to |output| instead of stdout. Does not take
+  // ownership of |output|.
+  explicit PythonPlotCollection(FILE* output);
   ~PythonPlotCollection() override;
   void Draw() override;
   Plot* AppendNewPlot() override;
+
+ private:
+  FILE* const output_;
 };
 
 }  // namespace plotting
@@ -37,7 +37,7 @@
  * frame_analyzer --label=<test_label> --reference_file=<name_of_file>
  * --test_file_ref=<name_of_file> --stats_file_test=<name_of_file>
  * --stats_file=<name_of_file> --width=<frame_width>
- * --height=<frame_height>
+ * --height=<frame_height> [--num_threads=<number_of_threads>]
  */
 int main(int argc, char** argv) {
   std::string program_name = argv[0];
@@ -62,7 +62,9 @@ int main(int argc, char** argv) {
       "  - reference_file(string): The reference YUV file to compare against."
       " Default: ref.yuv\n"
       "  - test_file(string): The test YUV file to run the analysis for."
-      " Default: test_file.yuv\n";
+      " Default: test_file.yuv\n"
+      "  - num_threads(int): The number of threads to analyze the frames on."
+      " Default: 0, meaning one per core\n";
 
   webrtc::test::CommandLineParser parser;
 
@@ -77,6 +79,7 @@ int main(int argc, char** argv) {
   parser.SetFlag("stats_file_test", "stats_test.txt");
   parser.SetFlag("reference_file", "ref.yuv");
   parser.SetFlag("test_file", "test.yuv");
+  parser.SetFlag("num_threads", "0");
   parser.SetFlag("help", "false");
 
   parser.ProcessFlags();
@@ -94,13 +97,23 @@ int main(int argc, char** argv) {
     return -1;
   }
 
+  int num_threads = strtol((parser.GetFlag("num_threads")).c_str(), NULL, 10);
+
   webrtc::test::ResultsContainer results;
 
-  webrtc::test::RunAnalysis(parser.GetFlag("reference_file").c_str(),
-                            parser.GetFlag("test_file").c_str(),
-                            parser.GetFlag("stats_file_ref").c_str(),
-                            parser.GetFlag("stats_file_test").c_str(), width,
-                            height, &results);
+  if (num_threads > 0) {
+    webrtc::test::RunAnalysis(parser.GetFlag("reference_file").c_str(),
+                              parser.GetFlag("test_file").c_str(),
+                              parser.GetFlag("stats_file_ref").c_str(),
+                              parser.GetFlag("stats_file_test").c_str(), width,
+                              height, num_threads, &results);
+  } else {
+    webrtc::test::RunAnalysis(parser.GetFlag("reference_file").c_str(),
+                              parser.GetFlag("test_file").c_str(),
+                              parser.GetFlag("stats_file_ref").c_str(),
+                              parser.GetFlag("stats_file_test").c_str(), width,
+                              height, &results);
+  }
 
   std::string label = parser.GetFlag("label");
   webrtc::test::PrintAnalysisResults(label, &results);
@@ -14,10 +14,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <algorithm>
-#include <string>
 #include <map>
+#include <memory>
+#include <string>
 #include <utility>
 
+#include "webrtc/common_video/libyuv/include/webrtc_libyuv.h"
+#include "webrtc/rtc_base/memory_mapped_file.h"
+#include "webrtc/rtc_base/parallel_for.h"
+#include "webrtc/system_wrappers/include/cpu_info.h"
+
 #define STATS_LINE_LENGTH 32
 #define Y4M_FILE_HEADER_MAX_SIZE 200
 #define Y4M_FRAME_DELIMITER "FRAME"
@@ -213,10 +219,10 @@ double CalculateMetrics(VideoAnalysisMetricsType video_metrics_type,
       result = (result > 48.0) ? 48.0 : result;
       break;
     case kSSIM:
-      result = libyuv::I420Ssim(src_y_a, stride_y, src_u_a, stride_uv,
-                                src_v_a, stride_uv, src_y_b, stride_y,
-                                src_u_b, stride_uv, src_v_b, stride_uv,
-                                width, height);
+      // Same result as libyuv::I420Ssim, but faster.
+      result = I420SSIM(src_y_a, stride_y, src_u_a, stride_uv, src_v_a,
+                        stride_uv, src_y_b, stride_y, src_u_b, stride_uv,
+                        src_v_b, stride_uv, width, height);
       break;
     default:
       assert(false);
@@ -225,12 +231,48 @@ double CalculateMetrics(VideoAnalysisMetricsType video_metrics_type,
   return result;
 }
 
+namespace {
+
+// The reference and test frames to compare, in the mapped files.
+struct FramePair {
+  int frame_number;
+  const uint8_t* reference_frame;
+  const uint8_t* test_frame;
+};
+
+// Returns the offset of the first frame in a Y4M file, or -1 if the header is
+// corrupt.
+int FindFirstY4mFrame(const rtc::MemoryMappedFile& file) {
+  const char* data = reinterpret_cast<const char*>(file.data());
+  const std::string header(
+      data, data + std::min<size_t>(file.size(), Y4M_FILE_HEADER_MAX_SIZE - 1));
+  const size_t found = header.find(Y4M_FRAME_DELIMITER);
+  if (found == std::string::npos)
+    return -1;
+  return static_cast<int>(found) + Y4M_FRAME_HEADER_SIZE;
+}
+
+}  // namespace
+
+void RunAnalysis(const char* reference_file_name,
+                 const char* test_file_name,
+                 const char* stats_file_reference_name,
+                 const char* stats_file_test_name,
+                 int width,
+                 int height,
+                 ResultsContainer* results) {
+  RunAnalysis(reference_file_name, test_file_name, stats_file_reference_name,
+              stats_file_test_name, width, height,
+              static_cast<int>(CpuInfo::DetectNumberOfCores()), results);
+}
+
 void RunAnalysis(const char* reference_file_name,
                  const char* test_file_name,
                  const char* stats_file_reference_name,
                  const char* stats_file_test_name,
                  int width,
                  int height,
+                 int num_threads,
                  ResultsContainer* results) {
   // Check if the reference_file_name ends with "y4m".
   bool y4m_mode = false;
@@ -238,16 +280,43 @@ void RunAnalysis(const char* reference_file_name,
     y4m_mode = true;
   }
 
-  int size = GetI420FrameSize(width, height);
+  // The frames are read straight from the mapped files, instead of being
+  // copied into buffers. Frames may be read in any order, and concurrently.
+  std::unique_ptr<rtc::MemoryMappedFile> reference_file =
+      rtc::MemoryMappedFile::Open(reference_file_name);
+  if (!reference_file) {
+    fprintf(stderr, "Couldn't open input file for reading: %s\n",
+            reference_file_name);
+    return;
+  }
+  std::unique_ptr<rtc::MemoryMappedFile> test_file =
+      rtc::MemoryMappedFile::Open(test_file_name);
+  if (!test_file) {
+    fprintf(stderr, "Couldn't open input file for reading: %s\n",
+            test_file_name);
+    return;
+  }
+
+  const size_t size = GetI420FrameSize(width, height);
+  size_t reference_offset = 0;
+  size_t reference_frame_size = size;
+  if (y4m_mode) {
+    const int first_frame = FindFirstY4mFrame(*reference_file);
+    if (first_frame < 0) {
+      fprintf(stdout, "Corrupted Y4M header, could not find \"FRAME\" in %s\n",
+              reference_file_name);
+      return;
+    }
+    reference_offset = first_frame;
+    reference_frame_size = size + Y4M_FRAME_HEADER_SIZE;
+  }
+
   FILE* stats_file_ref = fopen(stats_file_reference_name, "r");
   FILE* stats_file_test = fopen(stats_file_test_name, "r");
 
   // String buffer for the lines in the stats file.
   char line[STATS_LINE_LENGTH];
 
-  // Allocate buffers for test and reference frames.
-  uint8_t* test_frame = new uint8_t[size];
-  uint8_t* reference_frame = new uint8_t[size];
   int previous_frame_number = -1;
 
   // Maps barcode id to the frame id for the reference video.
@@ -263,6 +332,8 @@ void RunAnalysis(const char* reference_file_name,
         std::make_pair(decoded_frame_number, extracted_ref_frame));
   }
 
+  // Match the frames first, then compute their metrics in parallel.
+  std::vector<FramePair> frames;
   while (GetNextStatsLine(stats_file_test, line)) {
     int extracted_test_frame = ExtractFrameSequenceNumber(line);
     int decoded_frame_number = ExtractDecodedFrameNumber(line);
@@ -284,38 +355,40 @@ void RunAnalysis(const char* reference_file_name,
     assert(extracted_test_frame != -1);
     assert(decoded_frame_number != -1);
 
-    ExtractFrameFromYuvFile(test_file_name, width, height, extracted_test_frame,
-                            test_frame);
-    if (y4m_mode) {
-      ExtractFrameFromY4mFile(reference_file_name, width, height,
-                              extracted_ref_frame, reference_frame);
-    } else {
-      ExtractFrameFromYuvFile(reference_file_name, width, height,
-                              extracted_ref_frame, reference_frame);
-    }
-
-    // Calculate the PSNR and SSIM.
-    double result_psnr =
-        CalculateMetrics(kPSNR, reference_frame, test_frame, width, height);
-    double result_ssim =
-        CalculateMetrics(kSSIM, reference_frame, test_frame, width, height);
-
     previous_frame_number = decoded_frame_number;
 
-    // Fill in the result struct.
-    AnalysisResult result;
-    result.frame_number = decoded_frame_number;
-    result.psnr_value = result_psnr;
-    result.ssim_value = result_ssim;
-
-    results->frames.push_back(result);
+    const size_t test_offset = extracted_test_frame * size;
+    const size_t ref_offset =
+        reference_offset + extracted_ref_frame * reference_frame_size;
+    if (test_offset + size > test_file->size() ||
+        ref_offset + size > reference_file->size()) {
+      fprintf(stderr, "Frame %d is past the end of the video files\n",
+              decoded_frame_number);
+      continue;
+    }
+    frames.push_back({decoded_frame_number, reference_file->data() + ref_offset,
+                      test_file->data() + test_offset});
   }
 
+  // The results are kept in the order of the stats file, whichever thread
+  // analyzed the frames.
+  const size_t first_result = results->frames.size();
+  results->frames.resize(first_result + frames.size());
+  AnalysisResult* frame_results = results->frames.data() + first_result;
+  rtc::ParallelFor(frames.size(), num_threads, "FrameAnalysis",
+                   [&](size_t i) {
+                     const FramePair& frame = frames[i];
+                     frame_results[i] = AnalysisResult(
+                         frame.frame_number,
+                         CalculateMetrics(kPSNR, frame.reference_frame,
+                                          frame.test_frame, width, height),
+                         CalculateMetrics(kSSIM, frame.reference_frame,
+                                          frame.test_frame, width, height));
+                   });
+
   // Cleanup.
   fclose(stats_file_ref);
   fclose(stats_file_test);
-  delete[] test_frame;
-  delete[] reference_frame;
 }
 
 void PrintMaxRepeatedAndSkippedFrames(const std::string& label,
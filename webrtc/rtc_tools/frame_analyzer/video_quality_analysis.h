@@ -56,6 +56,8 @@ enum VideoAnalysisMetricsType {kPSNR, kSSIM};
 // problem with the decoding there would be 'Barcode error' instead of yyyy.
 // The stat files are used to compare the right frames with each other and
 // to calculate statistics.
+// The video files are memory mapped, and the frames are analyzed on one thread
+// per core.
 void RunAnalysis(const char* reference_file_name,
                  const char* test_file_name,
                  const char* stats_file_reference_name,
@@ -64,6 +66,17 @@ void RunAnalysis(const char* reference_file_name,
                  int height,
                  ResultsContainer* results);
 
+// Same as above, but analyzes the frames on |num_threads| threads, including
+// the calling one. The results don't depend on the number of threads.
+void RunAnalysis(const char* reference_file_name,
+                 const char* test_file_name,
+                 const char* stats_file_reference_name,
+                 const char* stats_file_test_name,
+                 int width,
+                 int height,
+                 int num_threads,
+                 ResultsContainer* results);
+
 // Compute PSNR or SSIM for an I420 frame (all planes). When we are calculating
 // PSNR values, the max return value (in the case where the test and reference
 // frames are exactly the same) will be 48. In the case of SSIM the max return
@@ -12,12 +12,20 @@
 // to stdout by void functions, but it's still useful as it executes the code.
 
 #include <stdio.h>
+#include <algorithm>
 #include <fstream>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "webrtc/rtc_base/random.h"
+#include "webrtc/rtc_base/timeutils.h"
 #include "webrtc/rtc_tools/frame_analyzer/video_quality_analysis.h"
+#include "webrtc/system_wrappers/include/cpu_info.h"
+#include "webrtc/system_wrappers/include/field_trial.h"
 #include "webrtc/test/gtest.h"
 #include "webrtc/test/testsupport/fileutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
 
 namespace webrtc {
 namespace test {
@@ -336,5 +344,253 @@ TEST_F(VideoQualityAnalysisTest, CalculateFrameClustersEmpty) {
   decltype(clusters) expected;
   ASSERT_EQ(expected, clusters);
 }
+
+namespace {
+
+using Frame = std::vector<uint8_t>;
+
+// Random frames with the values in a narrow range, so that PSNR and SSIM are
+// in their usual range.
+Frame RandomFrame(Random* random, int width, int height) {
+  Frame frame(GetI420FrameSize(width, height));
+  for (uint8_t& value : frame)
+    value = static_cast<uint8_t>(random->Rand(100, 140));
+  return frame;
+}
+
+Frame AddNoise(Random* random, const Frame& frame) {
+  Frame noisy(frame);
+  for (uint8_t& value : noisy)
+    value = static_cast<uint8_t>(value + random->Rand(-5, 5));
+  return noisy;
+}
+
+void WriteVideo(const std::string& file_name,
+                const std::vector<Frame>& frames,
+                int width,
+                int height,
+                bool y4m) {
+  FILE* file = fopen(file_name.c_str(), "wb");
+  ASSERT_TRUE(file != NULL);
+  if (y4m)
+    fprintf(file, "YUV4MPEG2 W%d H%d F30:1 C420\n", width, height);
+  for (const Frame& frame : frames) {
+    if (y4m)
+      fputs("FRAME\n", file);
+    fwrite(frame.data(), 1, frame.size(), file);
+  }
+  ASSERT_EQ(0, fclose(file));
+}
+
+}  // namespace
+
+class VideoQualityAnalysisRunTest : public VideoQualityAnalysisTest {
+ protected:
+  static const int kWidth = 64;
+  static const int kHeight = 48;
+
+  void SetUp() override {
+    VideoQualityAnalysisTest::SetUp();
+    reference_filename_ = TempFilename(OutputPath(), "reference");
+    test_filename_ = TempFilename(OutputPath(), "test");
+
+    // The test video starts at the third reference frame, repeats the fourth
+    // and has a barcode error in place of the fifth.
+    Random random(0x1234);
+    for (int i = 0; i < 8; ++i)
+      reference_frames_.push_back(RandomFrame(&random, kWidth, kHeight));
+    const int kTestToReference[] = {2, 3, 3, 4, 5, 6, 7};
+    for (int reference_frame : kTestToReference) {
+      test_frames_.push_back(
+          AddNoise(&random, reference_frames_[reference_frame]));
+    }
+    WriteVideo(test_filename_, test_frames_, kWidth, kHeight, false);
+
+    std::ofstream stats_file;
+    stats_file.open(stats_filename_ref_.c_str());
+    for (size_t i = 0; i < reference_frames_.size(); ++i)
+      stats_file << "frame_000" << i << " 010" << i << "\n";
+    stats_file.close();
+    stats_file.open(stats_filename_.c_str());
+    stats_file << "frame_0000 0102\n";
+    stats_file << "frame_0001 0103\n";
+    stats_file << "frame_0002 0103\n";
+    stats_file << "frame_0003 Barcode error\n";
+    stats_file << "frame_0004 0105\n";
+    stats_file << "frame_0005 0106\n";
+    stats_file << "frame_0006 0107\n";
+    stats_file.close();
+
+    // Test frame number and reference frame number of the analyzed frames.
+    const std::pair<int, int> kAnalyzed[] = {{0, 2}, {1, 3}, {4, 5},
+                                             {5, 6}, {6, 7}};
+    for (const auto& frames : kAnalyzed) {
+      const Frame& reference = reference_frames_[frames.second];
+      const Frame& test = test_frames_[frames.first];
+      expected_.push_back(AnalysisResult(
+          100 + frames.second,
+          CalculateMetrics(kPSNR, reference.data(), test.data(), kWidth,
+                           kHeight),
+          CalculateMetrics(kSSIM, reference.data(), test.data(), kWidth,
+                           kHeight)));
+    }
+  }
+
+  void TearDown() override {
+    remove(reference_filename_.c_str());
+    remove(test_filename_.c_str());
+    VideoQualityAnalysisTest::TearDown();
+  }
+
+  void ExpectResults(const ResultsContainer& results) {
+    ASSERT_EQ(expected_.size(), results.frames.size());
+    for (size_t i = 0; i < expected_.size(); ++i) {
+      EXPECT_EQ(expected_[i].frame_number, results.frames[i].frame_number);
+      EXPECT_EQ(expected_[i].psnr_value, results.frames[i].psnr_value);
+      EXPECT_EQ(expected_[i].ssim_value, results.frames[i].ssim_value);
+    }
+  }
+
+  std::string reference_filename_;
+  std::string test_filename_;
+  std::vector<Frame> reference_frames_;
+  std::vector<Frame> test_frames_;
+  std::vector<AnalysisResult> expected_;
+};
+
+TEST_F(VideoQualityAnalysisRunTest, AnalyzesMatchingFrames) {
+  WriteVideo(reference_filename_, reference_frames_, kWidth, kHeight, false);
+  for (int num_threads : {1, 2, 16}) {
+    ResultsContainer results;
+    RunAnalysis(reference_filename_.c_str(), test_filename_.c_str(),
+                stats_filename_ref_.c_str(), stats_filename_.c_str(), kWidth,
+                kHeight, num_threads, &results);
+    ExpectResults(results);
+  }
+  ResultsContainer results;
+  RunAnalysis(reference_filename_.c_str(), test_filename_.c_str(),
+              stats_filename_ref_.c_str(), stats_filename_.c_str(), kWidth,
+              kHeight, &results);
+  ExpectResults(results);
+}
+
+TEST_F(VideoQualityAnalysisRunTest, AnalyzesY4mReference) {
+  remove(reference_filename_.c_str());
+  reference_filename_ += ".y4m";
+  WriteVideo(reference_filename_, reference_frames_, kWidth, kHeight, true);
+  ResultsContainer results;
+  RunAnalysis(reference_filename_.c_str(), test_filename_.c_str(),
+              stats_filename_ref_.c_str(), stats_filename_.c_str(), kWidth,
+              kHeight, 2, &results);
+  ExpectResults(results);
+}
+
+TEST_F(VideoQualityAnalysisRunTest, SkipsFramesPastTheEndOfTheVideo) {
+  // Without the last reference frame.
+  reference_frames_.pop_back();
+  WriteVideo(reference_filename_, reference_frames_, kWidth, kHeight, false);
+  expected_.pop_back();
+  ResultsContainer results;
+  RunAnalysis(reference_filename_.c_str(), test_filename_.c_str(),
+              stats_filename_ref_.c_str(), stats_filename_.c_str(), kWidth,
+              kHeight, 2, &results);
+  ExpectResults(results);
+}
+
+// Analyzes a 1080p clip in the way RunAnalysis used to, reading each frame
+// with its own fopen and fread and using libyuv's SSIM, and with RunAnalysis
+// on one thread and on one thread per core. Reports the frames per second.
+TEST_F(VideoQualityAnalysisTest, FramesPerSecond1080p) {
+  const int kWidth = 1920;
+  const int kHeight = 1080;
+  const int kNumFrames =
+      field_trial::IsEnabled("WebRTC-QuickPerfTest") ? 4 : 30;
+  const std::string reference_filename =
+      TempFilename(OutputPath(), "reference_1080p");
+  const std::string test_filename = TempFilename(OutputPath(), "test_1080p");
+  FILE* reference_file = fopen(reference_filename.c_str(), "wb");
+  FILE* test_file = fopen(test_filename.c_str(), "wb");
+  ASSERT_TRUE(reference_file != NULL);
+  ASSERT_TRUE(test_file != NULL);
+  Random random(0x1080);
+  for (int i = 0; i < kNumFrames; ++i) {
+    const Frame reference = RandomFrame(&random, kWidth, kHeight);
+    const Frame test = AddNoise(&random, reference);
+    fwrite(reference.data(), 1, reference.size(), reference_file);
+    fwrite(test.data(), 1, test.size(), test_file);
+  }
+  ASSERT_EQ(0, fclose(reference_file));
+  ASSERT_EQ(0, fclose(test_file));
+  std::ofstream stats_file;
+  stats_file.open(stats_filename_ref_.c_str());
+  for (int i = 0; i < kNumFrames; ++i)
+    stats_file << "frame_" << i << " " << i << "\n";
+  stats_file.close();
+  stats_file.open(stats_filename_.c_str());
+  for (int i = 0; i < kNumFrames; ++i)
+    stats_file << "frame_" << i << " " << i << "\n";
+  stats_file.close();
+
+  auto frames_per_second = [kNumFrames](int64_t start_us) {
+    return static_cast<size_t>(
+        kNumFrames * rtc::kNumMicrosecsPerSec /
+        std::max<int64_t>(rtc::TimeMicros() - start_us, 1));
+  };
+
+  int64_t start_us = rtc::TimeMicros();
+  const int half_width = (kWidth + 1) / 2;
+  const int half_height = (kHeight + 1) / 2;
+  Frame reference(GetI420FrameSize(kWidth, kHeight));
+  Frame test(reference.size());
+  std::vector<double> baseline_ssim;
+  for (int i = 0; i < kNumFrames; ++i) {
+    ASSERT_TRUE(ExtractFrameFromYuvFile(test_filename.c_str(), kWidth,
+                                        kHeight, i, test.data()));
+    ASSERT_TRUE(ExtractFrameFromYuvFile(reference_filename.c_str(), kWidth,
+                                        kHeight, i, reference.data()));
+    CalculateMetrics(kPSNR, reference.data(), test.data(), kWidth, kHeight);
+    const uint8_t* u_a = reference.data() + kWidth * kHeight;
+    const uint8_t* v_a = u_a + half_width * half_height;
+    const uint8_t* u_b = test.data() + kWidth * kHeight;
+    const uint8_t* v_b = u_b + half_width * half_height;
+    baseline_ssim.push_back(libyuv::I420Ssim(
+        reference.data(), kWidth, u_a, half_width, v_a, half_width,
+        test.data(), kWidth, u_b, half_width, v_b, half_width, kWidth,
+        kHeight));
+  }
+  const size_t baseline_fps = frames_per_second(start_us);
+
+  start_us = rtc::TimeMicros();
+  ResultsContainer single_thread_results;
+  RunAnalysis(reference_filename.c_str(), test_filename.c_str(),
+              stats_filename_ref_.c_str(), stats_filename_.c_str(), kWidth,
+              kHeight, 1, &single_thread_results);
+  const size_t single_thread_fps = frames_per_second(start_us);
+
+  const int num_cores = static_cast<int>(CpuInfo::DetectNumberOfCores());
+  start_us = rtc::TimeMicros();
+  ResultsContainer results;
+  RunAnalysis(reference_filename.c_str(), test_filename.c_str(),
+              stats_filename_ref_.c_str(), stats_filename_.c_str(), kWidth,
+              kHeight, num_cores, &results);
+  const size_t fps = frames_per_second(start_us);
+
+  ASSERT_EQ(static_cast<size_t>(kNumFrames), results.frames.size());
+  for (int i = 0; i < kNumFrames; ++i)
+    EXPECT_EQ(baseline_ssim[i], results.frames[i].ssim_value);
+
+  PrintResult("frame_analyzer_1080p", "_per_frame_fread_libyuv_ssim",
+              "frames_per_second", baseline_fps, "fps", false);
+  PrintResult("frame_analyzer_1080p", "_1_thread", "frames_per_second",
+              single_thread_fps, "fps", false);
+  PrintResult("frame_analyzer_1080p", "_" + std::to_string(num_cores) +
+              "_threads", "frames_per_second", fps, "fps", false);
+  PrintResult("frame_analyzer_1080p", "", "speedup_percent",
+              fps * 100 / std::max<size_t>(baseline_fps, 1), "%", false);
+
+  remove(reference_filename.c_str());
+  remove(test_filename.c_str());
+}
+
 }  // namespace test
 }  // namespace webrtc
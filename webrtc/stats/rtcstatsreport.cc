@@ -84,6 +84,15 @@ const RTCStats* RTCStatsReport::Get(const std::string& id) const {
   return nullptr;
 }
 
+std::unique_ptr<const RTCStats> RTCStatsReport::Take(const std::string& id) {
+  StatsMap::iterator it = stats_.find(id);
+  if (it == stats_.end())
+    return nullptr;
+  std::unique_ptr<const RTCStats> stats = std::move(it->second);
+  stats_.erase(it);
+  return stats;
+}
+
 void RTCStatsReport::TakeMembersFrom(
     rtc::scoped_refptr<RTCStatsReport> victim) {
   for (StatsMap::iterator it = victim->stats_.begin();
@@ -110,6 +110,21 @@ TEST(RTCStatsReport, StatsOrder) {
   EXPECT_EQ(i, static_cast<int64_t>(7));
 }
 
+TEST(RTCStatsReport, Take) {
+  rtc::scoped_refptr<RTCStatsReport> report = RTCStatsReport::Create(0);
+  report->AddStats(std::unique_ptr<RTCStats>(new RTCTestStats1("A", 1)));
+  report->AddStats(std::unique_ptr<RTCStats>(new RTCTestStats1("B", 2)));
+
+  std::unique_ptr<const RTCStats> a = report->Take("A");
+  ASSERT_TRUE(a);
+  EXPECT_EQ(a->id(), "A");
+  EXPECT_EQ(a->timestamp_us(), 1);
+  EXPECT_FALSE(report->Get("A"));
+  EXPECT_FALSE(report->Take("A"));
+  EXPECT_EQ(report->size(), static_cast<size_t>(1));
+  EXPECT_TRUE(report->Get("B"));
+}
+
 TEST(RTCStatsReport, TakeMembersFrom) {
   rtc::scoped_refptr<RTCStatsReport> a = RTCStatsReport::Create(1337);
   EXPECT_EQ(a->timestamp_us(), 1337u);
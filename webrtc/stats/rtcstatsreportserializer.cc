@@ -0,0 +1,732 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/stats/rtcstatsreportserializer.h"
+
+#include <string.h>
+
+#include <cmath>
+#include <utility>
+
+#include "webrtc/api/stats/rtcstats_objects.h"
+#include "webrtc/rtc_base/checks.h"
+#include "webrtc/rtc_base/logging.h"
+
+namespace webrtc {
+
+namespace {
+
+// Message layout, all integers being varints unless noted otherwise:
+//   uint8_t flags (kKeyReportFlag)
+//   zigzag report timestamp delta
+//   number of removed objects, followed by their indexes
+//   number of object records, followed by the records
+// Object record:
+//   (object index << 1) | is_new
+//   if new: id, then (type index << 1) | is_new_type
+//     if new type: type, number of members, then per member: name, uint8_t type
+//   (number of changed members << 1) | has_timestamp_offset
+//   if has_timestamp_offset: zigzag (report timestamp - stats timestamp)
+//   per changed member: (member index << 1) | is_defined, then the value
+// Strings are written as their length followed by their bytes.
+const uint8_t kKeyReportFlag = 0x01;
+
+// Doubles are written as a delta from their previous value if the delta is an
+// integer, which is the case for counters such as bytes or frames, and raw
+// otherwise.
+const uint8_t kDoubleIntegerDelta = 0;
+const uint8_t kDoubleRaw = 1;
+const double kMaxExactIntegerDouble = 9007199254740992.0;  // 2^53.
+
+uint64_t ToZigZag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t FromZigZag(uint64_t value) {
+  return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+void WriteZigZag(int64_t value, rtc::ByteBufferWriter* buffer) {
+  buffer->WriteUVarint(ToZigZag(value));
+}
+
+bool ReadZigZag(rtc::ByteBufferReader* buffer, int64_t* value) {
+  uint64_t zigzag;
+  if (!buffer->ReadUVarint(&zigzag))
+    return false;
+  *value = FromZigZag(zigzag);
+  return true;
+}
+
+void WriteLengthPrefixedString(const char* value,
+                               size_t length,
+                               rtc::ByteBufferWriter* buffer) {
+  buffer->WriteUVarint(length);
+  buffer->WriteBytes(value, length);
+}
+
+bool ReadLengthPrefixedString(rtc::ByteBufferReader* buffer,
+                              std::string* value) {
+  uint64_t length;
+  if (!buffer->ReadUVarint(&length) || length > buffer->Length())
+    return false;
+  value->clear();
+  return buffer->ReadString(value, static_cast<size_t>(length));
+}
+
+// Value encoding. |previous| is null if the member was undefined or absent in
+// the previous report, in which case integers are delta-encoded against zero.
+// The integer deltas are computed modulo 2^64, so that they never overflow.
+template <typename T>
+void WriteValue(T value, const T* previous, rtc::ByteBufferWriter* buffer) {
+  const uint64_t base = previous ? static_cast<uint64_t>(*previous) : 0;
+  WriteZigZag(static_cast<int64_t>(static_cast<uint64_t>(value) - base),
+              buffer);
+}
+
+template <typename T>
+bool ReadValue(rtc::ByteBufferReader* buffer, const T* previous, T* value) {
+  int64_t delta;
+  if (!ReadZigZag(buffer, &delta))
+    return false;
+  const uint64_t base = previous ? static_cast<uint64_t>(*previous) : 0;
+  *value = static_cast<T>(base + static_cast<uint64_t>(delta));
+  return true;
+}
+
+void WriteValue(bool value, const bool* previous,
+                rtc::ByteBufferWriter* buffer) {
+  buffer->WriteUInt8(value ? 1 : 0);
+}
+
+bool ReadValue(rtc::ByteBufferReader* buffer, const bool* previous,
+               bool* value) {
+  uint8_t byte;
+  if (!buffer->ReadUInt8(&byte) || byte > 1)
+    return false;
+  *value = byte != 0;
+  return true;
+}
+
+void WriteValue(double value, const double* previous,
+                rtc::ByteBufferWriter* buffer) {
+  const double base = previous ? *previous : 0.0;
+  const double delta = value - base;
+  if (std::fabs(delta) < kMaxExactIntegerDouble && std::floor(delta) == delta &&
+      base + delta == value &&
+      std::signbit(base + delta) == std::signbit(value)) {
+    buffer->WriteUInt8(kDoubleIntegerDelta);
+    WriteZigZag(static_cast<int64_t>(delta), buffer);
+    return;
+  }
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  buffer->WriteUInt8(kDoubleRaw);
+  buffer->WriteUInt64(bits);
+}
+
+bool ReadValue(rtc::ByteBufferReader* buffer, const double* previous,
+               double* value) {
+  uint8_t tag;
+  if (!buffer->ReadUInt8(&tag))
+    return false;
+  if (tag == kDoubleIntegerDelta) {
+    int64_t delta;
+    if (!ReadZigZag(buffer, &delta))
+      return false;
+    *value = (previous ? *previous : 0.0) + static_cast<double>(delta);
+    return true;
+  }
+  uint64_t bits;
+  if (tag != kDoubleRaw || !buffer->ReadUInt64(&bits))
+    return false;
+  memcpy(value, &bits, sizeof(bits));
+  return true;
+}
+
+void WriteValue(const std::string& value, const std::string* previous,
+                rtc::ByteBufferWriter* buffer) {
+  WriteLengthPrefixedString(value.data(), value.size(), buffer);
+}
+
+bool ReadValue(rtc::ByteBufferReader* buffer, const std::string* previous,
+               std::string* value) {
+  return ReadLengthPrefixedString(buffer, value);
+}
+
+// Sequence elements are written without reference to the previous sequence.
+template <typename T>
+void WriteValue(const std::vector<T>& value, const std::vector<T>* previous,
+                rtc::ByteBufferWriter* buffer) {
+  buffer->WriteUVarint(value.size());
+  for (size_t i = 0; i < value.size(); ++i)
+    WriteValue(static_cast<T>(value[i]), static_cast<const T*>(nullptr),
+               buffer);
+}
+
+template <typename T>
+bool ReadValue(rtc::ByteBufferReader* buffer, const std::vector<T>* previous,
+               std::vector<T>* value) {
+  uint64_t size;
+  // Every element takes at least one byte.
+  if (!buffer->ReadUVarint(&size) || size > buffer->Length())
+    return false;
+  value->clear();
+  value->reserve(static_cast<size_t>(size));
+  for (uint64_t i = 0; i < size; ++i) {
+    T element;
+    if (!ReadValue(buffer, static_cast<const T*>(nullptr), &element))
+      return false;
+    value->push_back(element);
+  }
+  return true;
+}
+
+template <typename T>
+void WriteMember(const RTCStatsMemberInterface& member,
+                 const RTCStatsMemberInterface* previous,
+                 rtc::ByteBufferWriter* buffer) {
+  const T* previous_value =
+      previous && previous->is_defined()
+          ? &*previous->cast_to<RTCStatsMember<T>>()
+          : nullptr;
+  WriteValue(*member.cast_to<RTCStatsMember<T>>(), previous_value, buffer);
+}
+
+// Reads a value into |member|, or skips it if |member| is null.
+template <typename T>
+bool ReadMember(rtc::ByteBufferReader* buffer,
+                const RTCStatsMemberInterface* previous,
+                RTCStatsMemberInterface* member) {
+  const T* previous_value =
+      previous && previous->is_defined()
+          ? &*previous->cast_to<RTCStatsMember<T>>()
+          : nullptr;
+  T value;
+  if (!ReadValue(buffer, previous_value, &value))
+    return false;
+  if (member)
+    *static_cast<RTCStatsMember<T>*>(member) = value;
+  return true;
+}
+
+template <typename T>
+void CopyMember(const RTCStatsMemberInterface& from,
+                RTCStatsMemberInterface* to) {
+  if (from.is_defined())
+    *static_cast<RTCStatsMember<T>*>(to) = *from.cast_to<RTCStatsMember<T>>();
+}
+
+void WriteMemberValue(const RTCStatsMemberInterface& member,
+                      const RTCStatsMemberInterface* previous,
+                      rtc::ByteBufferWriter* buffer) {
+  switch (member.type()) {
+    case RTCStatsMemberInterface::kBool:
+      return WriteMember<bool>(member, previous, buffer);
+    case RTCStatsMemberInterface::kInt32:
+      return WriteMember<int32_t>(member, previous, buffer);
+    case RTCStatsMemberInterface::kUint32:
+      return WriteMember<uint32_t>(member, previous, buffer);
+    case RTCStatsMemberInterface::kInt64:
+      return WriteMember<int64_t>(member, previous, buffer);
+    case RTCStatsMemberInterface::kUint64:
+      return WriteMember<uint64_t>(member, previous, buffer);
+    case RTCStatsMemberInterface::kDouble:
+      return WriteMember<double>(member, previous, buffer);
+    case RTCStatsMemberInterface::kString:
+      return WriteMember<std::string>(member, previous, buffer);
+    case RTCStatsMemberInterface::kSequenceBool:
+      return WriteMember<std::vector<bool>>(member, previous, buffer);
+    case RTCStatsMemberInterface::kSequenceInt32:
+      return WriteMember<std::vector<int32_t>>(member, previous, buffer);
+    case RTCStatsMemberInterface::kSequenceUint32:
+      return WriteMember<std::vector<uint32_t>>(member, previous, buffer);
+    case RTCStatsMemberInterface::kSequenceInt64:
+      return WriteMember<std::vector<int64_t>>(member, previous, buffer);
+    case RTCStatsMemberInterface::kSequenceUint64:
+      return WriteMember<std::vector<uint64_t>>(member, previous, buffer);
+    case RTCStatsMemberInterface::kSequenceDouble:
+      return WriteMember<std::vector<double>>(member, previous, buffer);
+    case RTCStatsMemberInterface::kSequenceString:
+      return WriteMember<std::vector<std::string>>(member, previous, buffer);
+  }
+  RTC_NOTREACHED();
+}
+
+bool ReadMemberValue(rtc::ByteBufferReader* buffer,
+                     RTCStatsMemberInterface::Type type,
+                     const RTCStatsMemberInterface* previous,
+                     RTCStatsMemberInterface* member) {
+  switch (type) {
+    case RTCStatsMemberInterface::kBool:
+      return ReadMember<bool>(buffer, previous, member);
+    case RTCStatsMemberInterface::kInt32:
+      return ReadMember<int32_t>(buffer, previous, member);
+    case RTCStatsMemberInterface::kUint32:
+      return ReadMember<uint32_t>(buffer, previous, member);
+    case RTCStatsMemberInterface::kInt64:
+      return ReadMember<int64_t>(buffer, previous, member);
+    case RTCStatsMemberInterface::kUint64:
+      return ReadMember<uint64_t>(buffer, previous, member);
+    case RTCStatsMemberInterface::kDouble:
+      return ReadMember<double>(buffer, previous, member);
+    case RTCStatsMemberInterface::kString:
+      return ReadMember<std::string>(buffer, previous, member);
+    case RTCStatsMemberInterface::kSequenceBool:
+      return ReadMember<std::vector<bool>>(buffer, previous, member);
+    case RTCStatsMemberInterface::kSequenceInt32:
+      return ReadMember<std::vector<int32_t>>(buffer, previous, member);
+    case RTCStatsMemberInterface::kSequenceUint32:
+      return ReadMember<std::vector<uint32_t>>(buffer, previous, member);
+    case RTCStatsMemberInterface::kSequenceInt64:
+      return ReadMember<std::vector<int64_t>>(buffer, previous, member);
+    case RTCStatsMemberInterface::kSequenceUint64:
+      return ReadMember<std::vector<uint64_t>>(buffer, previous, member);
+    case RTCStatsMemberInterface::kSequenceDouble:
+      return ReadMember<std::vector<double>>(buffer, previous, member);
+    case RTCStatsMemberInterface::kSequenceString:
+      return ReadMember<std::vector<std::string>>(buffer, previous, member);
+  }
+  return false;
+}
+
+void CopyMemberValue(const RTCStatsMemberInterface& from,
+                     RTCStatsMemberInterface* to) {
+  RTC_DCHECK_EQ(from.type(), to->type());
+  switch (from.type()) {
+    case RTCStatsMemberInterface::kBool:
+      return CopyMember<bool>(from, to);
+    case RTCStatsMemberInterface::kInt32:
+      return CopyMember<int32_t>(from, to);
+    case RTCStatsMemberInterface::kUint32:
+      return CopyMember<uint32_t>(from, to);
+    case RTCStatsMemberInterface::kInt64:
+      return CopyMember<int64_t>(from, to);
+    case RTCStatsMemberInterface::kUint64:
+      return CopyMember<uint64_t>(from, to);
+    case RTCStatsMemberInterface::kDouble:
+      return CopyMember<double>(from, to);
+    case RTCStatsMemberInterface::kString:
+      return CopyMember<std::string>(from, to);
+    case RTCStatsMemberInterface::kSequenceBool:
+      return CopyMember<std::vector<bool>>(from, to);
+    case RTCStatsMemberInterface::kSequenceInt32:
+      return CopyMember<std::vector<int32_t>>(from, to);
+    case RTCStatsMemberInterface::kSequenceUint32:
+      return CopyMember<std::vector<uint32_t>>(from, to);
+    case RTCStatsMemberInterface::kSequenceInt64:
+      return CopyMember<std::vector<int64_t>>(from, to);
+    case RTCStatsMemberInterface::kSequenceUint64:
+      return CopyMember<std::vector<uint64_t>>(from, to);
+    case RTCStatsMemberInterface::kSequenceDouble:
+      return CopyMember<std::vector<double>>(from, to);
+    case RTCStatsMemberInterface::kSequenceString:
+      return CopyMember<std::vector<std::string>>(from, to);
+  }
+  RTC_NOTREACHED();
+}
+
+// The reader fills in stats objects that it created itself, whose members are
+// only exposed as const by |RTCStats::Members|.
+RTCStatsMemberInterface* MutableMember(const RTCStatsMemberInterface* member) {
+  return const_cast<RTCStatsMemberInterface*>(member);
+}
+
+template <typename T>
+std::unique_ptr<RTCStats> CreateStats(const std::string& id,
+                                      int64_t timestamp_us) {
+  return std::unique_ptr<RTCStats>(new T(id, timestamp_us));
+}
+
+std::unique_ptr<RTCStats> CreateMediaStreamTrackStats(const std::string& id,
+                                                      int64_t timestamp_us) {
+  // The kind is overwritten by the "kind" member when the stats are read.
+  return std::unique_ptr<RTCStats>(new RTCMediaStreamTrackStats(
+      id, timestamp_us, RTCMediaStreamTrackKind::kAudio));
+}
+
+}  // namespace
+
+RTCStatsReportWriter::RTCStatsReportWriter()
+    : previous_timestamp_us_(0), next_object_index_(0) {}
+
+RTCStatsReportWriter::~RTCStatsReportWriter() {}
+
+void RTCStatsReportWriter::Reset() {
+  previous_report_ = nullptr;
+}
+
+void RTCStatsReportWriter::WriteReport(
+    const rtc::scoped_refptr<const RTCStatsReport>& report,
+    rtc::ByteBufferWriter* output) {
+  RTC_DCHECK(report);
+  const bool key_report = !previous_report_;
+  if (key_report) {
+    previous_timestamp_us_ = 0;
+    objects_.clear();
+    next_object_index_ = 0;
+    type_indexes_.clear();
+  }
+  records_.Clear();
+  removed_indexes_.clear();
+  uint64_t num_records = 0;
+
+  // Both the report and |objects_| are ordered by id, which allows finding
+  // the new and removed objects in a single pass.
+  auto object_it = objects_.begin();
+  for (const RTCStats& stats : *report) {
+    while (object_it != objects_.end() && object_it->first < stats.id()) {
+      removed_indexes_.push_back(object_it->second.index);
+      object_it = objects_.erase(object_it);
+    }
+    const RTCStats* previous = nullptr;
+    if (object_it != objects_.end() && object_it->first == stats.id()) {
+      if (object_it->second.stats->type() == stats.type()) {
+        previous = object_it->second.stats;
+      } else {
+        // An id that changes type is sent as a new object.
+        removed_indexes_.push_back(object_it->second.index);
+        object_it->second.index = next_object_index_++;
+      }
+    } else {
+      ObjectState state = {next_object_index_++, 0, nullptr};
+      object_it = objects_.insert(object_it, std::make_pair(stats.id(), state));
+    }
+    ObjectState& state = object_it->second;
+    ++object_it;
+
+    const std::vector<const RTCStatsMemberInterface*> members =
+        stats.Members();
+    std::vector<const RTCStatsMemberInterface*> previous_members;
+    if (previous)
+      previous_members = previous->Members();
+    changed_members_.clear();
+    for (size_t i = 0; i < members.size(); ++i) {
+      if (previous ? *members[i] != *previous_members[i]
+                   : members[i]->is_defined()) {
+        changed_members_.push_back(i);
+      }
+    }
+    const int64_t timestamp_offset_us =
+        report->timestamp_us() - stats.timestamp_us();
+    const bool timestamp_offset_changed =
+        previous ? timestamp_offset_us != state.timestamp_offset_us
+                 : timestamp_offset_us != 0;
+    state.timestamp_offset_us = timestamp_offset_us;
+    state.stats = &stats;
+    if (previous && changed_members_.empty() && !timestamp_offset_changed)
+      continue;
+
+    ++num_records;
+    records_.WriteUVarint((state.index << 1) | (previous ? 0 : 1));
+    if (!previous) {
+      WriteLengthPrefixedString(stats.id().data(), stats.id().size(),
+                                &records_);
+      auto type_it = type_indexes_.find(stats.type());
+      if (type_it != type_indexes_.end()) {
+        records_.WriteUVarint(type_it->second << 1);
+      } else {
+        const uint64_t type_index = type_indexes_.size();
+        type_indexes_[stats.type()] = type_index;
+        records_.WriteUVarint((type_index << 1) | 1);
+        WriteLengthPrefixedString(stats.type(), strlen(stats.type()),
+                                  &records_);
+        records_.WriteUVarint(members.size());
+        for (const RTCStatsMemberInterface* member : members) {
+          WriteLengthPrefixedString(member->name(), strlen(member->name()),
+                                    &records_);
+          records_.WriteUInt8(static_cast<uint8_t>(member->type()));
+        }
+      }
+    }
+    records_.WriteUVarint((changed_members_.size() << 1) |
+                          (timestamp_offset_changed ? 1 : 0));
+    if (timestamp_offset_changed)
+      WriteZigZag(timestamp_offset_us, &records_);
+    for (size_t i : changed_members_) {
+      const bool defined = members[i]->is_defined();
+      records_.WriteUVarint((static_cast<uint64_t>(i) << 1) |
+                            (defined ? 1 : 0));
+      if (defined) {
+        WriteMemberValue(*members[i],
+                         previous ? previous_members[i] : nullptr, &records_);
+      }
+    }
+  }
+  while (object_it != objects_.end()) {
+    removed_indexes_.push_back(object_it->second.index);
+    object_it = objects_.erase(object_it);
+  }
+
+  output->WriteUInt8(key_report ? kKeyReportFlag : 0);
+  WriteZigZag(report->timestamp_us() - previous_timestamp_us_, output);
+  output->WriteUVarint(removed_indexes_.size());
+  for (uint64_t index : removed_indexes_)
+    output->WriteUVarint(index);
+  output->WriteUVarint(num_records);
+  output->WriteBytes(records_.Data(), records_.Length());
+
+  previous_report_ = report;
+  previous_timestamp_us_ = report->timestamp_us();
+}
+
+RTCStatsReportReader::RTCStatsReportReader()
+    : needs_key_report_(true), timestamp_us_(0), report_number_(0) {
+  RegisterStatsType(RTCCertificateStats::kType,
+                    &CreateStats<RTCCertificateStats>);
+  RegisterStatsType(RTCCodecStats::kType, &CreateStats<RTCCodecStats>);
+  RegisterStatsType(RTCDataChannelStats::kType,
+                    &CreateStats<RTCDataChannelStats>);
+  RegisterStatsType(RTCIceCandidatePairStats::kType,
+                    &CreateStats<RTCIceCandidatePairStats>);
+  RegisterStatsType(RTCLocalIceCandidateStats::kType,
+                    &CreateStats<RTCLocalIceCandidateStats>);
+  RegisterStatsType(RTCRemoteIceCandidateStats::kType,
+                    &CreateStats<RTCRemoteIceCandidateStats>);
+  RegisterStatsType(RTCMediaStreamStats::kType,
+                    &CreateStats<RTCMediaStreamStats>);
+  RegisterStatsType(RTCMediaStreamTrackStats::kType,
+                    &CreateMediaStreamTrackStats);
+  RegisterStatsType(RTCPeerConnectionStats::kType,
+                    &CreateStats<RTCPeerConnectionStats>);
+  RegisterStatsType(RTCInboundRTPStreamStats::kType,
+                    &CreateStats<RTCInboundRTPStreamStats>);
+  RegisterStatsType(RTCOutboundRTPStreamStats::kType,
+                    &CreateStats<RTCOutboundRTPStreamStats>);
+  RegisterStatsType(RTCTransportStats::kType,
+                    &CreateStats<RTCTransportStats>);
+}
+
+RTCStatsReportReader::~RTCStatsReportReader() {}
+
+void RTCStatsReportReader::RegisterStatsType(const std::string& type,
+                                             const StatsFactory& factory) {
+  factories_[type] = factory;
+}
+
+rtc::scoped_refptr<const RTCStatsReport> RTCStatsReportReader::ReadReport(
+    const char* data,
+    size_t size) {
+  rtc::ByteBufferReader buffer(data, size);
+  rtc::scoped_refptr<RTCStatsReport> report;
+  if (!ReadMessage(&buffer, &report) || buffer.Length() != 0) {
+    LOG(LS_WARNING) << "Failed to read RTCStatsReport message.";
+    ClearState();
+    return nullptr;
+  }
+  previous_report_ = report;
+  needs_key_report_ = false;
+  return report;
+}
+
+bool RTCStatsReportReader::ReadMessage(
+    rtc::ByteBufferReader* buffer,
+    rtc::scoped_refptr<RTCStatsReport>* report) {
+  uint8_t flags;
+  if (!buffer->ReadUInt8(&flags))
+    return false;
+  if (flags & kKeyReportFlag)
+    ClearState();
+  else if (needs_key_report_)
+    return false;
+
+  int64_t timestamp_delta_us;
+  if (!ReadZigZag(buffer, &timestamp_delta_us))
+    return false;
+  timestamp_us_ += timestamp_delta_us;
+  ++report_number_;
+  *report = RTCStatsReport::Create(timestamp_us_);
+
+  uint64_t num_removed;
+  if (!buffer->ReadUVarint(&num_removed))
+    return false;
+  for (uint64_t i = 0; i < num_removed; ++i) {
+    uint64_t index;
+    if (!buffer->ReadUVarint(&index) || objects_.erase(index) == 0)
+      return false;
+  }
+
+  uint64_t num_records;
+  if (!buffer->ReadUVarint(&num_records))
+    return false;
+  for (uint64_t i = 0; i < num_records; ++i) {
+    if (!ReadObject(buffer, report->get()))
+      return false;
+  }
+
+  // Objects without a record are unchanged apart from their timestamp.
+  for (auto& index_and_object : objects_) {
+    ObjectState& object = index_and_object.second;
+    if (object.report_number == report_number_ || !object.stats)
+      continue;
+    object.report_number = report_number_;
+    std::unique_ptr<RTCStats> stats = (*types_[object.type_index].factory)(
+        object.id, timestamp_us_ - object.timestamp_offset_us);
+    const std::vector<const RTCStatsMemberInterface*> members =
+        stats->Members();
+    const std::vector<const RTCStatsMemberInterface*> previous_members =
+        object.stats->Members();
+    for (size_t j = 0; j < members.size(); ++j)
+      CopyMemberValue(*previous_members[j], MutableMember(members[j]));
+    object.stats = stats.get();
+    (*report)->AddStats(std::move(stats));
+  }
+  return true;
+}
+
+bool RTCStatsReportReader::ReadTypeSchema(rtc::ByteBufferReader* buffer) {
+  std::string type;
+  uint64_t num_members;
+  if (!ReadLengthPrefixedString(buffer, &type) ||
+      !buffer->ReadUVarint(&num_members)) {
+    return false;
+  }
+  TypeSchema schema;
+  auto factory_it = factories_.find(type);
+  schema.factory =
+      factory_it != factories_.end() ? &factory_it->second : nullptr;
+  std::vector<const RTCStatsMemberInterface*> reader_members;
+  std::unique_ptr<RTCStats> prototype;
+  if (schema.factory) {
+    prototype = (*schema.factory)(std::string(), 0);
+    reader_members = prototype->Members();
+  }
+  std::string name;
+  for (uint64_t i = 0; i < num_members; ++i) {
+    uint8_t member_type;
+    if (!ReadLengthPrefixedString(buffer, &name) ||
+        !buffer->ReadUInt8(&member_type) ||
+        member_type > RTCStatsMemberInterface::kSequenceString) {
+      return false;
+    }
+    schema.member_types.push_back(
+        static_cast<RTCStatsMemberInterface::Type>(member_type));
+    int member_index = -1;
+    for (size_t j = 0; j < reader_members.size(); ++j) {
+      if (name == reader_members[j]->name() &&
+          reader_members[j]->type() == schema.member_types.back()) {
+        member_index = static_cast<int>(j);
+        break;
+      }
+    }
+    schema.member_indexes.push_back(member_index);
+  }
+  types_.push_back(std::move(schema));
+  return true;
+}
+
+bool RTCStatsReportReader::ReadObject(rtc::ByteBufferReader* buffer,
+                                      RTCStatsReport* report) {
+  uint64_t object_header;
+  if (!buffer->ReadUVarint(&object_header))
+    return false;
+  const uint64_t index = object_header >> 1;
+  ObjectState* object;
+  if (object_header & 1) {
+    ObjectState new_object;
+    uint64_t type_header;
+    if (!ReadLengthPrefixedString(buffer, &new_object.id) ||
+        !buffer->ReadUVarint(&type_header)) {
+      return false;
+    }
+    const uint64_t type_index = type_header >> 1;
+    if (type_header & 1) {
+      if (type_index != types_.size() || !ReadTypeSchema(buffer))
+        return false;
+    } else if (type_index >= types_.size()) {
+      return false;
+    }
+    new_object.type_index = static_cast<size_t>(type_index);
+    new_object.timestamp_offset_us = 0;
+    new_object.stats = nullptr;
+    new_object.report_number = 0;
+    auto inserted = objects_.insert(std::make_pair(index, new_object));
+    if (!inserted.second)
+      return false;
+    object = &inserted.first->second;
+  } else {
+    auto object_it = objects_.find(index);
+    if (object_it == objects_.end())
+      return false;
+    object = &object_it->second;
+  }
+  if (object->report_number == report_number_)
+    return false;
+  object->report_number = report_number_;
+  const TypeSchema& type = types_[object->type_index];
+
+  uint64_t members_header;
+  if (!buffer->ReadUVarint(&members_header))
+    return false;
+  const uint64_t num_changed = members_header >> 1;
+  if (num_changed > type.member_types.size())
+    return false;
+  if ((members_header & 1) &&
+      !ReadZigZag(buffer, &object->timestamp_offset_us)) {
+    return false;
+  }
+
+  std::unique_ptr<RTCStats> stats;
+  std::vector<const RTCStatsMemberInterface*> members;
+  std::vector<const RTCStatsMemberInterface*> previous_members;
+  if (type.factory) {
+    stats = (*type.factory)(object->id,
+                            timestamp_us_ - object->timestamp_offset_us);
+    members = stats->Members();
+    if (object->stats)
+      previous_members = object->stats->Members();
+  }
+  std::vector<bool> updated(members.size(), false);
+  for (uint64_t i = 0; i < num_changed; ++i) {
+    uint64_t member_header;
+    if (!buffer->ReadUVarint(&member_header))
+      return false;
+    const uint64_t written_index = member_header >> 1;
+    if (written_index >= type.member_types.size())
+      return false;
+    const int member_index =
+        stats ? type.member_indexes[written_index] : -1;
+    if (member_index >= 0)
+      updated[member_index] = true;
+    if (!(member_header & 1))
+      continue;
+    if (!ReadMemberValue(
+            buffer, type.member_types[written_index],
+            member_index >= 0 && object->stats ? previous_members[member_index]
+                                               : nullptr,
+            member_index >= 0 ? MutableMember(members[member_index])
+                              : nullptr)) {
+      return false;
+    }
+  }
+  if (!stats)
+    return true;
+
+  if (object->stats) {
+    for (size_t j = 0; j < members.size(); ++j) {
+      if (!updated[j])
+        CopyMemberValue(*previous_members[j], MutableMember(members[j]));
+    }
+  }
+  object->stats = stats.get();
+  report->AddStats(std::move(stats));
+  return true;
+}
+
+void RTCStatsReportReader::ClearState() {
+  needs_key_report_ = true;
+  previous_report_ = nullptr;
+  timestamp_us_ = 0;
+  types_.clear();
+  objects_.clear();
+}
+
+}  // namespace webrtc
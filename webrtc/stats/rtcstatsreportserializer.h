@@ -0,0 +1,143 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_STATS_RTCSTATSREPORTSERIALIZER_H_
+#define WEBRTC_STATS_RTCSTATSREPORTSERIALIZER_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/api/stats/rtcstats.h"
+#include "webrtc/api/stats/rtcstatsreport.h"
+#include "webrtc/rtc_base/bytebuffer.h"
+#include "webrtc/rtc_base/constructormagic.h"
+#include "webrtc/rtc_base/scoped_ref_ptr.h"
+
+namespace webrtc {
+
+// Serializes a sequence of |RTCStatsReport|s into a compact binary format,
+// meant for exporting the stats of a call in bulk. Each report is written as
+// one message. The first message is a key report containing every stats
+// object; subsequent messages only contain the stats objects and members that
+// changed since the previous report, with integers delta-encoded against their
+// previous value. The layout of a stats type (its members' names and types, in
+// the order listed in |WEBRTC_RTCSTATS_IMPL|) is written once, the first time
+// an object of that type is written, and members are referenced by index.
+//
+// Messages must be read in order by a single |RTCStatsReportReader|, starting
+// at a key report.
+class RTCStatsReportWriter {
+ public:
+  RTCStatsReportWriter();
+  ~RTCStatsReportWriter();
+
+  // Appends a message containing |report| to |output|.
+  void WriteReport(const rtc::scoped_refptr<const RTCStatsReport>& report,
+                   rtc::ByteBufferWriter* output);
+
+  // Makes the next message a key report, which can be read without any of the
+  // messages written before it.
+  void Reset();
+
+ private:
+  struct ObjectState {
+    uint64_t index;
+    int64_t timestamp_offset_us;
+    // Owned by |previous_report_|.
+    const RTCStats* stats;
+  };
+
+  // Writes the members of |stats| that differ from |previous|, which is null
+  // if |stats| was not part of the previous report.
+  void WriteMembers(const RTCStats& stats,
+                    const RTCStats* previous,
+                    bool timestamp_offset_changed,
+                    int64_t timestamp_offset_us,
+                    rtc::ByteBufferWriter* output);
+
+  rtc::scoped_refptr<const RTCStatsReport> previous_report_;
+  int64_t previous_timestamp_us_;
+  std::map<std::string, ObjectState> objects_;
+  uint64_t next_object_index_;
+  // Types are keyed by the address of their |kType|, which is unique per type.
+  std::map<const char*, uint64_t> type_indexes_;
+
+  // Scratch space reused between reports.
+  rtc::ByteBufferWriter records_;
+  std::vector<uint64_t> removed_indexes_;
+  std::vector<size_t> changed_members_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(RTCStatsReportWriter);
+};
+
+// Reads the messages written by an |RTCStatsReportWriter|. All the standard
+// stats types of rtcstats_objects.h are known to the reader; other types can be
+// added with |RegisterStatsType|. Stats objects of unknown types, and members
+// that the reader's version of a type does not have, are skipped.
+class RTCStatsReportReader {
+ public:
+  typedef std::function<std::unique_ptr<RTCStats>(const std::string& id,
+                                                  int64_t timestamp_us)>
+      StatsFactory;
+
+  RTCStatsReportReader();
+  ~RTCStatsReportReader();
+
+  // |factory| must create an empty stats object of type |type|.
+  void RegisterStatsType(const std::string& type, const StatsFactory& factory);
+
+  // Reads one message and returns the report it contains. Returns null if the
+  // message is malformed, in which case the next message must be a key
+  // report.
+  rtc::scoped_refptr<const RTCStatsReport> ReadReport(const char* data,
+                                                      size_t size);
+
+ private:
+  struct TypeSchema {
+    // Null if the type is unknown to the reader.
+    const StatsFactory* factory;
+    std::vector<RTCStatsMemberInterface::Type> member_types;
+    // For each member as written, the index of the reader's member with the
+    // same name and type, or -1 if there is none.
+    std::vector<int> member_indexes;
+  };
+  struct ObjectState {
+    std::string id;
+    size_t type_index;
+    int64_t timestamp_offset_us;
+    // Owned by |previous_report_|, null if the type is unknown.
+    const RTCStats* stats;
+    uint64_t report_number;
+  };
+
+  bool ReadMessage(rtc::ByteBufferReader* buffer,
+                   rtc::scoped_refptr<RTCStatsReport>* report);
+  bool ReadTypeSchema(rtc::ByteBufferReader* buffer);
+  bool ReadObject(rtc::ByteBufferReader* buffer, RTCStatsReport* report);
+  void ClearState();
+
+  std::map<std::string, StatsFactory> factories_;
+
+  bool needs_key_report_;
+  rtc::scoped_refptr<const RTCStatsReport> previous_report_;
+  int64_t timestamp_us_;
+  uint64_t report_number_;
+  std::vector<TypeSchema> types_;
+  std::map<uint64_t, ObjectState> objects_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(RTCStatsReportReader);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_STATS_RTCSTATSREPORTSERIALIZER_H_
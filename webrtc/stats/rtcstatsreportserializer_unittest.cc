@@ -0,0 +1,458 @@
+/*
+ *  Copyright 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/stats/rtcstatsreportserializer.h"
+
+#include <string>
+#include <vector>
+
+#include "webrtc/api/stats/rtcstats_objects.h"
+#include "webrtc/rtc_base/gunit.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/stats/test/rtcteststats.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+
+namespace {
+
+// Has a subset of the members of |RTCTestStats|, in a different order, and an
+// "mInt64" member of a different type.
+class RTCPartialTestStats : public RTCStats {
+ public:
+  WEBRTC_RTCSTATS_DECL();
+
+  RTCPartialTestStats(const std::string& id, int64_t timestamp_us)
+      : RTCStats(id, timestamp_us),
+        m_string("mString"),
+        m_int64("mInt64"),
+        m_int32("mInt32") {}
+
+  RTCStatsMember<std::string> m_string;
+  RTCStatsMember<double> m_int64;
+  RTCStatsMember<int32_t> m_int32;
+};
+
+WEBRTC_RTCSTATS_IMPL(RTCPartialTestStats, RTCStats, "test-stats",
+    &m_string,
+    &m_int64,
+    &m_int32);
+
+std::unique_ptr<RTCStats> CreateTestStats(const std::string& id,
+                                          int64_t timestamp_us) {
+  return std::unique_ptr<RTCStats>(new RTCTestStats(id, timestamp_us));
+}
+
+std::unique_ptr<RTCStats> CreatePartialTestStats(const std::string& id,
+                                                 int64_t timestamp_us) {
+  return std::unique_ptr<RTCStats>(new RTCPartialTestStats(id, timestamp_us));
+}
+
+std::unique_ptr<RTCTestStats> CreateTestStatsWithAllMembers(
+    const std::string& id,
+    int64_t timestamp_us) {
+  std::unique_ptr<RTCTestStats> stats(new RTCTestStats(id, timestamp_us));
+  stats->m_bool = true;
+  stats->m_int32 = -123;
+  stats->m_uint32 = 0xFFFFFFFFu;
+  stats->m_int64 = -0x7FFFFFFFFFFFFFFFll - 1;
+  stats->m_uint64 = 0xFFFFFFFFFFFFFFFFull;
+  stats->m_double = 0.125;
+  stats->m_string = "string";
+  stats->m_sequence_bool = std::vector<bool>({true, false, true});
+  stats->m_sequence_int32 = std::vector<int32_t>({-1, 0, 0x7FFFFFFF});
+  stats->m_sequence_uint32 = std::vector<uint32_t>({0, 1, 0xFFFFFFFFu});
+  stats->m_sequence_int64 = std::vector<int64_t>({-42, 42});
+  stats->m_sequence_uint64 = std::vector<uint64_t>({1, 2, 3});
+  stats->m_sequence_double = std::vector<double>({-0.0, 1.5, 1e300});
+  stats->m_sequence_string = std::vector<std::string>({"", "a", "bc"});
+  return stats;
+}
+
+rtc::scoped_refptr<const RTCStatsReport> WriteAndRead(
+    const rtc::scoped_refptr<const RTCStatsReport>& report,
+    RTCStatsReportWriter* writer,
+    RTCStatsReportReader* reader,
+    size_t* message_size) {
+  rtc::ByteBufferWriter buffer;
+  writer->WriteReport(report, &buffer);
+  if (message_size)
+    *message_size = buffer.Length();
+  return reader->ReadReport(buffer.Data(), buffer.Length());
+}
+
+void ExpectReportsEqual(const RTCStatsReport& expected,
+                        const RTCStatsReport& actual) {
+  EXPECT_EQ(expected.timestamp_us(), actual.timestamp_us());
+  ASSERT_EQ(expected.size(), actual.size());
+  for (const RTCStats& expected_stats : expected) {
+    const RTCStats* actual_stats = actual.Get(expected_stats.id());
+    ASSERT_TRUE(actual_stats) << expected_stats.id();
+    EXPECT_EQ(expected_stats, *actual_stats) << expected_stats.ToJson()
+                                             << actual_stats->ToJson();
+    EXPECT_EQ(expected_stats.timestamp_us(), actual_stats->timestamp_us());
+  }
+}
+
+// A report similar to that of a call with |num_tracks| audio tracks, each
+// sent and received, on |num_transports| transports. |step| varies the
+// counters the way they would between consecutive reports.
+rtc::scoped_refptr<RTCStatsReport> CreateCallReport(size_t num_tracks,
+                                                    size_t num_transports,
+                                                    int step) {
+  const int64_t timestamp_us = 1000000000 + step * 1000000;
+  rtc::scoped_refptr<RTCStatsReport> report =
+      RTCStatsReport::Create(timestamp_us);
+  std::unique_ptr<RTCPeerConnectionStats> peer_connection(
+      new RTCPeerConnectionStats("RTCPeerConnection", timestamp_us));
+  peer_connection->data_channels_opened = 1;
+  peer_connection->data_channels_closed = 0;
+  report->AddStats(std::move(peer_connection));
+  for (size_t i = 0; i < num_transports; ++i) {
+    const std::string index = std::to_string(i);
+    std::unique_ptr<RTCCertificateStats> certificate(new RTCCertificateStats(
+        "RTCCertificate_" + index, timestamp_us));
+    certificate->fingerprint = "AB:CD:EF:01:23:45:67:89:AB:CD:EF:01:23:45:67";
+    certificate->fingerprint_algorithm = "sha-256";
+    certificate->base64_certificate = std::string(600, 'A');
+    report->AddStats(std::move(certificate));
+
+    std::unique_ptr<RTCLocalIceCandidateStats> local(
+        new RTCLocalIceCandidateStats("RTCIceCandidate_local" + index,
+                                      timestamp_us));
+    local->transport_id = "RTCTransport_" + index;
+    local->is_remote = false;
+    local->ip = "192.168.1.1";
+    local->port = static_cast<int32_t>(10000 + i);
+    local->protocol = "udp";
+    local->candidate_type = "host";
+    local->priority = 2122260223;
+    report->AddStats(std::move(local));
+
+    std::unique_ptr<RTCRemoteIceCandidateStats> remote(
+        new RTCRemoteIceCandidateStats("RTCIceCandidate_remote" + index,
+                                       timestamp_us));
+    remote->transport_id = "RTCTransport_" + index;
+    remote->is_remote = true;
+    remote->ip = "10.0.0.1";
+    remote->port = static_cast<int32_t>(20000 + i);
+    remote->protocol = "udp";
+    remote->candidate_type = "srflx";
+    remote->priority = 1686052607;
+    report->AddStats(std::move(remote));
+
+    std::unique_ptr<RTCIceCandidatePairStats> pair(
+        new RTCIceCandidatePairStats("RTCIceCandidatePair_" + index,
+                                     timestamp_us));
+    pair->transport_id = "RTCTransport_" + index;
+    pair->local_candidate_id = "RTCIceCandidate_local" + index;
+    pair->remote_candidate_id = "RTCIceCandidate_remote" + index;
+    pair->state = "succeeded";
+    pair->nominated = true;
+    pair->writable = true;
+    pair->bytes_sent = static_cast<uint64_t>(step) * 64000 + i;
+    pair->bytes_received = static_cast<uint64_t>(step) * 63000 + i;
+    pair->total_round_trip_time = 0.05 * step;
+    pair->current_round_trip_time = 0.05 + 0.001 * (step % 7);
+    pair->requests_received = static_cast<uint64_t>(step / 2);
+    pair->requests_sent = static_cast<uint64_t>(step / 2);
+    pair->responses_received = static_cast<uint64_t>(step / 2);
+    pair->responses_sent = static_cast<uint64_t>(step / 2);
+    report->AddStats(std::move(pair));
+
+    std::unique_ptr<RTCTransportStats> transport(
+        new RTCTransportStats("RTCTransport_" + index, timestamp_us));
+    transport->bytes_sent = static_cast<uint64_t>(step) * 64000 + i;
+    transport->bytes_received = static_cast<uint64_t>(step) * 63000 + i;
+    transport->dtls_state = "connected";
+    transport->selected_candidate_pair_id = "RTCIceCandidatePair_" + index;
+    transport->local_certificate_id = "RTCCertificate_" + index;
+    report->AddStats(std::move(transport));
+  }
+  for (size_t i = 0; i < num_tracks; ++i) {
+    const std::string index = std::to_string(i);
+    const std::string transport_id =
+        "RTCTransport_" + std::to_string(i % num_transports);
+    std::unique_ptr<RTCMediaStreamTrackStats> track(
+        new RTCMediaStreamTrackStats("RTCMediaStreamTrack_" + index,
+                                     timestamp_us,
+                                     RTCMediaStreamTrackKind::kAudio));
+    track->track_identifier = "audio_track_" + index;
+    track->remote_source = false;
+    track->ended = false;
+    track->detached = false;
+    track->audio_level = 0.001 * ((step * 37 + static_cast<int>(i)) % 1000);
+    track->echo_return_loss = 30.0;
+    track->echo_return_loss_enhancement = 12.5;
+    report->AddStats(std::move(track));
+
+    std::unique_ptr<RTCOutboundRTPStreamStats> outbound(
+        new RTCOutboundRTPStreamStats("RTCOutboundRTPAudioStream_" + index,
+                                      timestamp_us));
+    outbound->ssrc = static_cast<uint32_t>(1000 + i);
+    outbound->is_remote = false;
+    outbound->media_type = "audio";
+    outbound->track_id = "RTCMediaStreamTrack_" + index;
+    outbound->transport_id = transport_id;
+    outbound->codec_id = "RTCCodec_OutboundAudio_111";
+    outbound->packets_sent = static_cast<uint32_t>(step * 50);
+    outbound->bytes_sent = static_cast<uint64_t>(step) * 4000;
+    report->AddStats(std::move(outbound));
+
+    std::unique_ptr<RTCInboundRTPStreamStats> inbound(
+        new RTCInboundRTPStreamStats("RTCInboundRTPAudioStream_" + index,
+                                     timestamp_us));
+    inbound->ssrc = static_cast<uint32_t>(2000 + i);
+    inbound->is_remote = false;
+    inbound->media_type = "audio";
+    inbound->transport_id = transport_id;
+    inbound->codec_id = "RTCCodec_InboundAudio_111";
+    inbound->packets_received = static_cast<uint32_t>(step * 50 - step / 10);
+    inbound->bytes_received = static_cast<uint64_t>(step) * 3960;
+    inbound->packets_lost = static_cast<uint32_t>(step / 10);
+    inbound->jitter = 0.002 + 0.0001 * (step % 5);
+    inbound->fraction_lost = 0.02;
+    inbound->round_trip_time = 0.05 + 0.001 * (step % 7);
+    report->AddStats(std::move(inbound));
+  }
+  for (const char* direction : {"Inbound", "Outbound"}) {
+    std::unique_ptr<RTCCodecStats> codec(new RTCCodecStats(
+        std::string("RTCCodec_") + direction + "Audio_111", timestamp_us));
+    codec->payload_type = 111;
+    codec->mime_type = "audio/opus";
+    codec->clock_rate = 48000;
+    codec->channels = 2;
+    report->AddStats(std::move(codec));
+  }
+  return report;
+}
+
+}  // namespace
+
+TEST(RTCStatsReportSerializerTest, KeyReportWithAllMemberTypes) {
+  rtc::scoped_refptr<RTCStatsReport> report = RTCStatsReport::Create(1234);
+  report->AddStats(CreateTestStatsWithAllMembers("a", 1000));
+  report->AddStats(
+      std::unique_ptr<RTCStats>(new RTCTestStats("undefined", 1234)));
+
+  RTCStatsReportWriter writer;
+  RTCStatsReportReader reader;
+  reader.RegisterStatsType(RTCTestStats::kType, &CreateTestStats);
+  rtc::scoped_refptr<const RTCStatsReport> read_report =
+      WriteAndRead(report, &writer, &reader, nullptr);
+  ASSERT_TRUE(read_report);
+  ExpectReportsEqual(*report, *read_report);
+}
+
+TEST(RTCStatsReportSerializerTest, DeltaReports) {
+  RTCStatsReportWriter writer;
+  RTCStatsReportReader reader;
+  reader.RegisterStatsType(RTCTestStats::kType, &CreateTestStats);
+
+  rtc::scoped_refptr<RTCStatsReport> report = RTCStatsReport::Create(1000);
+  report->AddStats(CreateTestStatsWithAllMembers("a", 1000));
+  report->AddStats(CreateTestStatsWithAllMembers("b", 1000));
+  report->AddStats(CreateTestStatsWithAllMembers("c", 1000));
+  size_t key_size;
+  rtc::scoped_refptr<const RTCStatsReport> read_report =
+      WriteAndRead(report, &writer, &reader, &key_size);
+  ASSERT_TRUE(read_report);
+  ExpectReportsEqual(*report, *read_report);
+
+  // Nothing but the timestamps changes.
+  report = RTCStatsReport::Create(2000);
+  report->AddStats(CreateTestStatsWithAllMembers("a", 2000));
+  report->AddStats(CreateTestStatsWithAllMembers("b", 2000));
+  report->AddStats(CreateTestStatsWithAllMembers("c", 2000));
+  size_t delta_size;
+  read_report = WriteAndRead(report, &writer, &reader, &delta_size);
+  ASSERT_TRUE(read_report);
+  ExpectReportsEqual(*report, *read_report);
+  EXPECT_LT(delta_size, 8u);
+
+  // Values change, a member becomes undefined, "b" is removed, "d" is added
+  // and "c" is timestamped differently from the report.
+  report = RTCStatsReport::Create(3000);
+  std::unique_ptr<RTCTestStats> a = CreateTestStatsWithAllMembers("a", 3000);
+  a->m_int32 = 0x7FFFFFFF;
+  a->m_uint64 = 0;
+  a->m_double = 0.25;
+  a->m_sequence_int32 = std::vector<int32_t>();
+  report->AddStats(std::move(a));
+  std::unique_ptr<RTCTestStats> c(new RTCTestStats("c", 2500));
+  c->m_string = "string";
+  report->AddStats(std::move(c));
+  report->AddStats(CreateTestStatsWithAllMembers("d", 3000));
+  read_report = WriteAndRead(report, &writer, &reader, nullptr);
+  ASSERT_TRUE(read_report);
+  ExpectReportsEqual(*report, *read_report);
+  EXPECT_FALSE(read_report->Get("c")->cast_to<RTCTestStats>().m_bool
+                   .is_defined());
+
+  // An id can change type.
+  report = RTCStatsReport::Create(4000);
+  std::unique_ptr<RTCTransportStats> transport(
+      new RTCTransportStats("a", 4000));
+  transport->bytes_sent = 42;
+  report->AddStats(std::move(transport));
+  read_report = WriteAndRead(report, &writer, &reader, nullptr);
+  ASSERT_TRUE(read_report);
+  ExpectReportsEqual(*report, *read_report);
+}
+
+TEST(RTCStatsReportSerializerTest, CountersAreDeltaEncoded) {
+  RTCStatsReportWriter writer;
+  RTCStatsReportReader reader;
+  rtc::scoped_refptr<const RTCStatsReport> read_report;
+  size_t message_size = 0;
+  for (int step = 1; step <= 10; ++step) {
+    rtc::scoped_refptr<RTCStatsReport> report = CreateCallReport(3, 1, step);
+    read_report = WriteAndRead(report, &writer, &reader, &message_size);
+    ASSERT_TRUE(read_report);
+    ExpectReportsEqual(*report, *read_report);
+  }
+  EXPECT_LT(message_size * 4, read_report->ToJson().size() / 4);
+}
+
+TEST(RTCStatsReportSerializerTest, UnknownTypesAndMembersAreSkipped) {
+  RTCStatsReportWriter writer;
+  RTCStatsReportReader reader;
+  RTCStatsReportReader partial_reader;
+  partial_reader.RegisterStatsType(RTCTestStats::kType,
+                                   &CreatePartialTestStats);
+
+  for (int step = 0; step < 3; ++step) {
+    rtc::scoped_refptr<RTCStatsReport> report =
+        RTCStatsReport::Create(1000 * step);
+    std::unique_ptr<RTCTestStats> test_stats =
+        CreateTestStatsWithAllMembers("test", 1000 * step);
+    *test_stats->m_int32 += step;
+    report->AddStats(std::move(test_stats));
+    std::unique_ptr<RTCTransportStats> transport(
+        new RTCTransportStats("transport", 1000 * step));
+    transport->bytes_sent = static_cast<uint64_t>(step) * 1000;
+    report->AddStats(std::move(transport));
+
+    rtc::ByteBufferWriter buffer;
+    writer.WriteReport(report, &buffer);
+
+    rtc::scoped_refptr<const RTCStatsReport> read_report =
+        reader.ReadReport(buffer.Data(), buffer.Length());
+    ASSERT_TRUE(read_report);
+    EXPECT_EQ(1u, read_report->size());
+    ASSERT_TRUE(read_report->Get("transport"));
+    EXPECT_EQ(*report->Get("transport"), *read_report->Get("transport"));
+
+    read_report = partial_reader.ReadReport(buffer.Data(), buffer.Length());
+    ASSERT_TRUE(read_report);
+    EXPECT_EQ(2u, read_report->size());
+    ASSERT_TRUE(read_report->Get("test"));
+    const RTCPartialTestStats& partial =
+        read_report->Get("test")->cast_to<RTCPartialTestStats>();
+    EXPECT_EQ("string", *partial.m_string);
+    EXPECT_EQ(-123 + step, *partial.m_int32);
+    EXPECT_FALSE(partial.m_int64.is_defined());
+  }
+}
+
+TEST(RTCStatsReportSerializerTest, ResetWritesKeyReport) {
+  RTCStatsReportWriter writer;
+  RTCStatsReportReader reader;
+  rtc::ByteBufferWriter buffer;
+  writer.WriteReport(CreateCallReport(2, 1, 1), &buffer);
+  ASSERT_TRUE(reader.ReadReport(buffer.Data(), buffer.Length()));
+
+  // A delta report can't be read without the reports before it.
+  rtc::scoped_refptr<RTCStatsReport> report = CreateCallReport(2, 1, 2);
+  rtc::ByteBufferWriter delta_buffer;
+  writer.WriteReport(report, &delta_buffer);
+  RTCStatsReportReader late_reader;
+  EXPECT_FALSE(
+      late_reader.ReadReport(delta_buffer.Data(), delta_buffer.Length()));
+
+  writer.Reset();
+  rtc::ByteBufferWriter key_buffer;
+  writer.WriteReport(report, &key_buffer);
+  rtc::scoped_refptr<const RTCStatsReport> read_report =
+      late_reader.ReadReport(key_buffer.Data(), key_buffer.Length());
+  ASSERT_TRUE(read_report);
+  ExpectReportsEqual(*report, *read_report);
+  read_report = reader.ReadReport(key_buffer.Data(), key_buffer.Length());
+  ASSERT_TRUE(read_report);
+  ExpectReportsEqual(*report, *read_report);
+}
+
+TEST(RTCStatsReportSerializerTest, MalformedMessageRequiresKeyReport) {
+  RTCStatsReportWriter writer;
+  RTCStatsReportReader reader;
+  rtc::ByteBufferWriter buffer;
+  writer.WriteReport(CreateCallReport(2, 1, 1), &buffer);
+  EXPECT_FALSE(reader.ReadReport(buffer.Data(), buffer.Length() - 1));
+
+  rtc::ByteBufferWriter delta_buffer;
+  writer.WriteReport(CreateCallReport(2, 1, 2), &delta_buffer);
+  EXPECT_FALSE(
+      reader.ReadReport(delta_buffer.Data(), delta_buffer.Length()));
+
+  EXPECT_TRUE(reader.ReadReport(buffer.Data(), buffer.Length()));
+  EXPECT_TRUE(reader.ReadReport(delta_buffer.Data(), delta_buffer.Length()));
+}
+
+TEST(RTCStatsReportSerializerTest, SizeAndThroughput) {
+  const int kNumReports = 100;
+  std::vector<rtc::scoped_refptr<const RTCStatsReport>> reports;
+  for (int step = 1; step <= kNumReports; ++step)
+    reports.push_back(CreateCallReport(50, 10, step));
+
+  size_t json_size = 0;
+  for (const auto& report : reports)
+    json_size += report->ToJson().size();
+
+  RTCStatsReportWriter writer;
+  std::vector<std::unique_ptr<rtc::ByteBufferWriter>> messages;
+  int64_t start_ns = rtc::SystemTimeNanos();
+  for (const auto& report : reports) {
+    messages.emplace_back(new rtc::ByteBufferWriter());
+    writer.WriteReport(report, messages.back().get());
+  }
+  const int64_t encode_ns = rtc::SystemTimeNanos() - start_ns;
+
+  RTCStatsReportReader reader;
+  start_ns = rtc::SystemTimeNanos();
+  for (size_t i = 0; i < messages.size(); ++i) {
+    rtc::scoped_refptr<const RTCStatsReport> read_report =
+        reader.ReadReport(messages[i]->Data(), messages[i]->Length());
+    ASSERT_TRUE(read_report);
+    EXPECT_EQ(reports[i]->size(), read_report->size());
+  }
+  const int64_t decode_ns = rtc::SystemTimeNanos() - start_ns;
+
+  size_t binary_size = 0;
+  for (const auto& message : messages)
+    binary_size += message->Length();
+  EXPECT_LT(binary_size * 10, json_size);
+
+  test::PrintResult("rtc_stats_serializer", "", "json_size",
+                    json_size / kNumReports, "bytes", false);
+  test::PrintResult("rtc_stats_serializer", "", "key_report_size",
+                    messages.front()->Length(), "bytes", false);
+  test::PrintResult("rtc_stats_serializer", "", "delta_report_size",
+                    (binary_size - messages.front()->Length()) /
+                        (kNumReports - 1),
+                    "bytes", false);
+  test::PrintResult("rtc_stats_serializer", "", "encode_time",
+                    static_cast<size_t>(encode_ns / 1000 / kNumReports), "us",
+                    false);
+  test::PrintResult("rtc_stats_serializer", "", "decode_time",
+                    static_cast<size_t>(decode_ns / 1000 / kNumReports), "us",
+                    false);
+}
+
+}  // namespace webrtc
@@ -9,8 +9,17 @@
 
 #include "webrtc/system_wrappers/include/metrics_default.h"
 
+#if defined(WEBRTC_WIN)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
 #include <algorithm>
+#include <atomic>
 
+#include "webrtc/rtc_base/atomicops.h"
+#include "webrtc/rtc_base/checks.h"
 #include "webrtc/rtc_base/criticalsection.h"
 #include "webrtc/rtc_base/thread_annotations.h"
 #include "webrtc/system_wrappers/include/metrics.h"
@@ -28,37 +37,184 @@ namespace {
 // linearly/exponentially spaced buckets) if samples are logged more frequently.
 const int kMaxSampleMapSize = 300;
 
+// Number of shards that the samples of a histogram are counted in. Each thread
+// adding samples is assigned one of them, so unless more than |kNumShards|
+// threads add to the same histogram, a shard is only written by one thread.
+const size_t kNumShards = 16;
+
+// Number of distinct sample values a shard can count between two calls to
+// GetAndReset (or Reset). Samples with other values are dropped.
+const int kShardSizeBits = 9;
+const size_t kShardSize = 1 << kShardSizeBits;
+
+// Returns the shard index of the calling thread. Threads are given indexes
+// round-robin the first time they ask for one.
+class ThreadShardIndex {
+ public:
+  ThreadShardIndex() {
+#if defined(WEBRTC_WIN)
+    tls_index_ = TlsAlloc();
+    RTC_CHECK(tls_index_ != TLS_OUT_OF_INDEXES);
+#else
+    RTC_CHECK_EQ(0, pthread_key_create(&tls_key_, nullptr));
+#endif
+  }
+
+  size_t Get() {
+    // The index is stored plus one, so that null means "not assigned yet".
+#if defined(WEBRTC_WIN)
+    void* value = TlsGetValue(tls_index_);
+#else
+    void* value = pthread_getspecific(tls_key_);
+#endif
+    if (!value) {
+      const uintptr_t index =
+          static_cast<uint32_t>(rtc::AtomicOps::Increment(&next_index_)) %
+          kNumShards;
+      value = reinterpret_cast<void*>(index + 1);
+#if defined(WEBRTC_WIN)
+      TlsSetValue(tls_index_, value);
+#else
+      pthread_setspecific(tls_key_, value);
+#endif
+    }
+    return reinterpret_cast<uintptr_t>(value) - 1;
+  }
+
+ private:
+#if defined(WEBRTC_WIN)
+  DWORD tls_index_;
+#else
+  pthread_key_t tls_key_;
+#endif
+  volatile int next_index_ = 0;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(ThreadShardIndex);
+};
+
+// Samples of one histogram counted by one or a few threads, without locks.
+// The shard is a fixed-size open addressing table in which each slot packs a
+// sample value (high 32 bits) and its number of events (low 32 bits) into one
+// word, so that a slot can be read and cleared atomically. An empty slot is 0.
+class SampleShard {
+ public:
+  SampleShard() {
+    for (std::atomic<uint64_t>& slot : slots_)
+      slot.store(0, std::memory_order_relaxed);
+  }
+
+  // Returns false if the sample was dropped because the shard is full.
+  bool Add(int sample) {
+    const uint64_t key = static_cast<uint64_t>(static_cast<uint32_t>(sample))
+                         << 32;
+    const size_t start = Hash(sample);
+    for (size_t i = 0; i < kShardSize; ++i) {
+      std::atomic<uint64_t>& slot = slots_[(start + i) & (kShardSize - 1)];
+      uint64_t word = slot.load(std::memory_order_relaxed);
+      while (true) {
+        if (word == 0) {
+          // Claim the empty slot. On failure |word| is reloaded.
+          if (slot.compare_exchange_weak(word, key | 1,
+                                         std::memory_order_relaxed)) {
+            return true;
+          }
+        } else if ((word & kKeyMask) == key) {
+          if ((word & kCountMask) == kCountMask)
+            return false;
+          if (slot.compare_exchange_weak(word, word + 1,
+                                         std::memory_order_relaxed)) {
+            return true;
+          }
+        } else {
+          break;  // Taken by another value; probe the next slot.
+        }
+      }
+    }
+    return false;
+  }
+
+  // Adds the counts to |samples|, clearing them if |reset| is true. A value
+  // that GetAndReset raced with may end up in two slots; the merged count is
+  // still exact.
+  void Merge(bool reset, std::map<int, int>* samples) {
+    for (std::atomic<uint64_t>& slot : slots_) {
+      const uint64_t word = reset
+                                ? slot.exchange(0, std::memory_order_relaxed)
+                                : slot.load(std::memory_order_relaxed);
+      if (word == 0)
+        continue;
+      const int sample = static_cast<int>(static_cast<uint32_t>(word >> 32));
+      if (samples->size() == kMaxSampleMapSize &&
+          samples->find(sample) == samples->end()) {
+        continue;
+      }
+      (*samples)[sample] += static_cast<int>(word & kCountMask);
+    }
+  }
+
+ private:
+  static constexpr uint64_t kCountMask = 0xffffffffu;
+  static constexpr uint64_t kKeyMask = ~kCountMask;
+
+  static size_t Hash(int sample) {
+    // Fibonacci hashing spreads consecutive values over the table.
+    return (static_cast<uint32_t>(sample) * 2654435769u) >>
+           (32 - kShardSizeBits);
+  }
+
+  std::atomic<uint64_t> slots_[kShardSize];
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(SampleShard);
+};
+
+ThreadShardIndex* GetThreadShardIndex() {
+  static ThreadShardIndex* const thread_shard_index = new ThreadShardIndex();
+  return thread_shard_index;
+}
+
 class RtcHistogram {
  public:
   RtcHistogram(const std::string& name, int min, int max, int bucket_count)
       : min_(min), max_(max), info_(name, min, max, bucket_count) {
     RTC_DCHECK_GT(bucket_count, 0);
+    for (std::atomic<SampleShard*>& shard : shards_)
+      shard.store(nullptr, std::memory_order_relaxed);
+  }
+
+  ~RtcHistogram() {
+    for (std::atomic<SampleShard*>& shard : shards_)
+      delete shard.load(std::memory_order_relaxed);
   }
 
+  // Lock-free: the sample is counted in the calling thread's shard, which is
+  // allocated the first time the thread adds to this histogram.
   void Add(int sample) {
     sample = std::min(sample, max_);
     sample = std::max(sample, min_ - 1);  // Underflow bucket.
 
-    rtc::CritScope cs(&crit_);
-    if (info_.samples.size() == kMaxSampleMapSize &&
-        info_.samples.find(sample) == info_.samples.end()) {
-      return;
+    std::atomic<SampleShard*>& shard_pointer =
+        shards_[GetThreadShardIndex()->Get()];
+    SampleShard* shard = shard_pointer.load(std::memory_order_acquire);
+    if (!shard) {
+      std::unique_ptr<SampleShard> new_shard(new SampleShard());
+      if (shard_pointer.compare_exchange_strong(shard, new_shard.get(),
+                                                std::memory_order_acq_rel)) {
+        shard = new_shard.release();
+      }
     }
-    ++info_.samples[sample];
+    shard->Add(sample);
   }
 
   // Returns a copy (or nullptr if there are no samples) and clears samples.
   std::unique_ptr<SampleInfo> GetAndReset() {
     rtc::CritScope cs(&crit_);
-    if (info_.samples.empty())
+    std::unique_ptr<SampleInfo> copy(
+        new SampleInfo(info_.name, info_.min, info_.max, info_.bucket_count));
+    MergeShards(true, &copy->samples);
+    if (copy->samples.empty())
       return nullptr;
 
-    SampleInfo* copy =
-        new SampleInfo(info_.name, info_.min, info_.max, info_.bucket_count);
-
-    std::swap(info_.samples, copy->samples);
-
-    return std::unique_ptr<SampleInfo>(copy);
+    return copy;
   }
 
   const std::string& name() const { return info_.name; }
@@ -66,34 +222,54 @@ class RtcHistogram {
   // Functions only for testing.
   void Reset() {
     rtc::CritScope cs(&crit_);
-    info_.samples.clear();
+    std::map<int, int> samples;
+    MergeShards(true, &samples);
   }
 
   int NumEvents(int sample) const {
-    rtc::CritScope cs(&crit_);
-    const auto it = info_.samples.find(sample);
-    return (it == info_.samples.end()) ? 0 : it->second;
+    const std::map<int, int> samples = Samples();
+    const auto it = samples.find(sample);
+    return (it == samples.end()) ? 0 : it->second;
   }
 
   int NumSamples() const {
     int num_samples = 0;
-    rtc::CritScope cs(&crit_);
-    for (const auto& sample : info_.samples) {
+    for (const auto& sample : Samples()) {
       num_samples += sample.second;
     }
     return num_samples;
   }
 
   int MinSample() const {
-    rtc::CritScope cs(&crit_);
-    return (info_.samples.empty()) ? -1 : info_.samples.begin()->first;
+    const std::map<int, int> samples = Samples();
+    return (samples.empty()) ? -1 : samples.begin()->first;
   }
 
  private:
+  // Merges the samples of all shards into |samples|.
+  void MergeShards(bool reset, std::map<int, int>* samples) const
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_) {
+    for (const std::atomic<SampleShard*>& shard_pointer : shards_) {
+      SampleShard* shard = shard_pointer.load(std::memory_order_acquire);
+      if (shard)
+        shard->Merge(reset, samples);
+    }
+  }
+
+  std::map<int, int> Samples() const {
+    rtc::CritScope cs(&crit_);
+    std::map<int, int> samples;
+    MergeShards(false, &samples);
+    return samples;
+  }
+
+  // Serializes readers. Adding samples does not take it.
   rtc::CriticalSection crit_;
   const int min_;
   const int max_;
-  SampleInfo info_ RTC_GUARDED_BY(crit_);
+  // Holds the name and limits; the samples are in |shards_|.
+  const SampleInfo info_;
+  std::atomic<SampleShard*> shards_[kNumShards];
 
   RTC_DISALLOW_COPY_AND_ASSIGN(RtcHistogram);
 };
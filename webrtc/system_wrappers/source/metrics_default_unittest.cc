@@ -8,9 +8,15 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <memory>
+#include <vector>
+
+#include "webrtc/rtc_base/platform_thread.h"
+#include "webrtc/rtc_base/timeutils.h"
 #include "webrtc/system_wrappers/include/metrics.h"
 #include "webrtc/system_wrappers/include/metrics_default.h"
 #include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
 
 namespace webrtc {
 
@@ -47,6 +53,30 @@ int NumEvents(const std::string& name,
 
   return it_sample->second;
 }
+
+const char kThreadedName[] = "Threaded";
+const int kThreadedNumValues = 10;
+
+// Adds |*samples_per_thread| samples to the same histogram as all other threads
+// running this function.
+void AddSamples(void* samples_per_thread) {
+  const int num_samples = *static_cast<int*>(samples_per_thread);
+  for (int i = 0; i < num_samples; ++i)
+    RTC_HISTOGRAM_PERCENTAGE(kThreadedName, i % kThreadedNumValues);
+}
+
+// Adds samples from |num_threads| threads at once.
+void AddSamplesFromThreads(int num_threads, int samples_per_thread) {
+  std::vector<std::unique_ptr<rtc::PlatformThread>> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back(
+        new rtc::PlatformThread(&AddSamples, &samples_per_thread, "Adder"));
+  }
+  for (auto& thread : threads)
+    thread->Start();
+  for (auto& thread : threads)
+    thread->Stop();
+}
 }  // namespace
 
 class MetricsDefaultTest : public ::testing::Test {
@@ -160,4 +190,34 @@ TEST_F(MetricsDefaultTest, TestMinMaxBucket) {
   EXPECT_EQ(1u, histograms.begin()->second->samples.size());
 }
 
+TEST_F(MetricsDefaultTest, SamplesFromManyThreadsAreCounted) {
+  const int kNumThreads = 20;
+  const int kSamplesPerThread = 100;
+  AddSamplesFromThreads(kNumThreads, kSamplesPerThread);
+
+  EXPECT_EQ(kNumThreads * kSamplesPerThread,
+            metrics::NumSamples(kThreadedName));
+  for (int i = 0; i < kThreadedNumValues; ++i) {
+    EXPECT_EQ(kNumThreads * kSamplesPerThread / kThreadedNumValues,
+              metrics::NumEvents(kThreadedName, i));
+  }
+}
+
+// Measures adding samples to one histogram from 8 threads at once. Disabled
+// since it only reports timings; run it with --gtest_also_run_disabled_tests.
+TEST_F(MetricsDefaultTest, DISABLED_ContentionPerformance) {
+  const int kNumThreads = 8;
+  const int kSamplesPerThread = 200000;
+  const int64_t start_ns = rtc::SystemTimeNanos();
+  AddSamplesFromThreads(kNumThreads, kSamplesPerThread);
+  const int64_t elapsed_ns = rtc::SystemTimeNanos() - start_ns;
+
+  EXPECT_EQ(kNumThreads * kSamplesPerThread,
+            metrics::NumSamples(kThreadedName));
+  // Wall-clock time per sample, as seen by each of the threads.
+  webrtc::test::PrintResult(
+      "histogram_add", "_8_threads", "metrics_default",
+      static_cast<double>(elapsed_ns) / kSamplesPerThread, "ns", false);
+}
+
 }  // namespace webrtc
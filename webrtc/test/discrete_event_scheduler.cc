@@ -0,0 +1,215 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/test/discrete_event_scheduler.h"
+
+#include <algorithm>
+#include <list>
+#include <utility>
+
+#include "webrtc/rtc_base/checks.h"
+#include "webrtc/rtc_base/location.h"
+#include "webrtc/rtc_base/task_queue.h"
+
+namespace webrtc {
+namespace test {
+
+// Processes its modules on the scheduler while started, like
+// ProcessThreadImpl does on its thread.
+class DiscreteEventScheduler::SimulatedProcessThread : public ProcessThread {
+ public:
+  explicit SimulatedProcessThread(DiscreteEventScheduler* scheduler)
+      : scheduler_(scheduler), started_(false) {}
+
+  ~SimulatedProcessThread() override {
+    RTC_DCHECK(!started_);
+  }
+
+  void Start() override {
+    RTC_DCHECK(!started_);
+    started_ = true;
+    for (Module* module : modules_) {
+      module->ProcessThreadAttached(this);
+      scheduler_->RegisterModule(module);
+    }
+    for (auto& task : pending_tasks_)
+      PostStartedTask(std::move(task));
+    pending_tasks_.clear();
+  }
+
+  void Stop() override {
+    if (!started_)
+      return;
+    started_ = false;
+    for (Module* module : modules_) {
+      scheduler_->DeRegisterModule(module);
+      module->ProcessThreadAttached(nullptr);
+    }
+  }
+
+  void WakeUp(Module* module) override {
+    if (started_ &&
+        std::find(modules_.begin(), modules_.end(), module) != modules_.end()) {
+      scheduler_->WakeUp(module);
+    }
+  }
+
+  void PostTask(std::unique_ptr<rtc::QueuedTask> task) override {
+    if (started_) {
+      PostStartedTask(std::move(task));
+    } else {
+      pending_tasks_.push_back(std::move(task));
+    }
+  }
+
+  void RegisterModule(Module* module, const rtc::Location& from) override {
+    RTC_DCHECK(module) << from.ToString();
+    RTC_DCHECK(std::find(modules_.begin(), modules_.end(), module) ==
+               modules_.end())
+        << from.ToString();
+    modules_.push_back(module);
+    if (started_) {
+      module->ProcessThreadAttached(this);
+      scheduler_->RegisterModule(module);
+    }
+  }
+
+  void DeRegisterModule(Module* module) override {
+    modules_.remove(module);
+    if (started_)
+      scheduler_->DeRegisterModule(module);
+    module->ProcessThreadAttached(nullptr);
+  }
+
+ private:
+  void PostStartedTask(std::unique_ptr<rtc::QueuedTask> task) {
+    // A task that returns false from Run() has taken ownership of itself.
+    std::shared_ptr<std::unique_ptr<rtc::QueuedTask>> holder =
+        std::make_shared<std::unique_ptr<rtc::QueuedTask>>(std::move(task));
+    scheduler_->PostTask([holder] {
+      if (!(*holder)->Run())
+        holder->release();
+    });
+  }
+
+  DiscreteEventScheduler* const scheduler_;
+  bool started_;
+  std::list<Module*> modules_;
+  std::vector<std::unique_ptr<rtc::QueuedTask>> pending_tasks_;
+};
+
+DiscreteEventScheduler::DiscreteEventScheduler(int64_t start_time_us)
+    : clock_(start_time_us),
+      rtc_clock_(&clock_),
+      previous_rtc_clock_(rtc::SetClockForTesting(&rtc_clock_)),
+      next_task_id_(1),
+      num_events_run_(0) {}
+
+DiscreteEventScheduler::~DiscreteEventScheduler() {
+  RTC_DCHECK(thread_checker_.CalledOnValidThread());
+  RTC_DCHECK(modules_.empty()) << "ProcessThreads must be stopped first.";
+  rtc::SetClockForTesting(previous_rtc_clock_);
+}
+
+DiscreteEventScheduler::TaskId DiscreteEventScheduler::PostTask(Task task) {
+  return ScheduleAt(clock_.TimeInMicroseconds(), std::move(task));
+}
+
+DiscreteEventScheduler::TaskId DiscreteEventScheduler::PostDelayedTask(
+    Task task,
+    int64_t delay_ms) {
+  return ScheduleAt(
+      clock_.TimeInMicroseconds() + std::max<int64_t>(delay_ms, 0) * 1000,
+      std::move(task));
+}
+
+bool DiscreteEventScheduler::CancelTask(TaskId task_id) {
+  RTC_DCHECK(thread_checker_.CalledOnValidThread());
+  // The event stays in |events_| and is skipped when it is due.
+  return tasks_.erase(task_id) > 0;
+}
+
+std::unique_ptr<ProcessThread> DiscreteEventScheduler::CreateProcessThread() {
+  return std::unique_ptr<ProcessThread>(new SimulatedProcessThread(this));
+}
+
+void DiscreteEventScheduler::RunFor(int64_t duration_ms) {
+  RTC_DCHECK(thread_checker_.CalledOnValidThread());
+  const int64_t end_time_us = clock_.TimeInMicroseconds() + duration_ms * 1000;
+  while (!events_.empty() && events_.top().time_us <= end_time_us) {
+    const Event event = events_.top();
+    events_.pop();
+    auto it = tasks_.find(event.task_id);
+    if (it == tasks_.end())
+      continue;
+    Task task = std::move(it->second);
+    tasks_.erase(it);
+    AdvanceTo(event.time_us);
+    task();
+    ++num_events_run_;
+  }
+  AdvanceTo(end_time_us);
+}
+
+DiscreteEventScheduler::TaskId DiscreteEventScheduler::ScheduleAt(
+    int64_t time_us,
+    Task task) {
+  RTC_DCHECK(thread_checker_.CalledOnValidThread());
+  const TaskId task_id = next_task_id_++;
+  tasks_.emplace(task_id, std::move(task));
+  events_.push({time_us, task_id});
+  return task_id;
+}
+
+void DiscreteEventScheduler::AdvanceTo(int64_t time_us) {
+  const int64_t delta_us = time_us - clock_.TimeInMicroseconds();
+  RTC_DCHECK_GE(delta_us, 0);
+  if (delta_us > 0)
+    clock_.AdvanceTimeMicroseconds(delta_us);
+}
+
+void DiscreteEventScheduler::RegisterModule(Module* module) {
+  RTC_DCHECK(modules_.find(module) == modules_.end());
+  modules_[module] = kNoTask;
+  ScheduleModule(module, module->TimeUntilNextProcess());
+}
+
+void DiscreteEventScheduler::DeRegisterModule(Module* module) {
+  auto it = modules_.find(module);
+  RTC_DCHECK(it != modules_.end());
+  CancelTask(it->second);
+  modules_.erase(it);
+}
+
+void DiscreteEventScheduler::WakeUp(Module* module) {
+  // Like ProcessThreadImpl, process the module right away.
+  ScheduleModule(module, 0);
+}
+
+void DiscreteEventScheduler::ScheduleModule(Module* module, int64_t delay_ms) {
+  auto it = modules_.find(module);
+  RTC_DCHECK(it != modules_.end());
+  CancelTask(it->second);
+  it->second = PostDelayedTask([this, module] { ProcessModule(module); },
+                               delay_ms);
+}
+
+void DiscreteEventScheduler::ProcessModule(Module* module) {
+  modules_[module] = kNoTask;
+  module->Process();
+  // Process() may have deregistered the module, or woken it up, in which case
+  // its next callback is already scheduled.
+  auto it = modules_.find(module);
+  if (it != modules_.end() && it->second == kNoTask)
+    ScheduleModule(module, module->TimeUntilNextProcess());
+}
+
+}  // namespace test
+}  // namespace webrtc
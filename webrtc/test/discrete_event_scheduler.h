@@ -0,0 +1,134 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+#ifndef WEBRTC_TEST_DISCRETE_EVENT_SCHEDULER_H_
+#define WEBRTC_TEST_DISCRETE_EVENT_SCHEDULER_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include "webrtc/modules/include/module.h"
+#include "webrtc/modules/utility/include/process_thread.h"
+#include "webrtc/rtc_base/constructormagic.h"
+#include "webrtc/rtc_base/thread_checker.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/system_wrappers/include/clock.h"
+
+namespace webrtc {
+namespace test {
+
+// Runs tasks and modules in simulated time, all on the thread that calls
+// RunFor(). Instead of waiting for the next task or module to be due, the
+// clock is advanced to it, so a simulation runs as fast as the code under test
+// allows and, given the same inputs, always runs the same way.
+//
+// Time is kept by a SimulatedClock, available through clock(). For the lifetime
+// of the scheduler, rtc::TimeMicros() and friends return the same time, which
+// is why there can only be one scheduler at a time.
+//
+// Tasks have the same interface as those of SingleThreadedTaskQueueForTesting.
+// Components that take a ProcessThread get one from CreateProcessThread().
+// Code running on an rtc::TaskQueue or a thread of its own, e.g. a Call, can
+// not be run by this class.
+//
+// Events due at the same time run in the order they were scheduled.
+class DiscreteEventScheduler {
+ public:
+  using Task = std::function<void()>;
+  using TaskId = size_t;
+
+  explicit DiscreteEventScheduler(int64_t start_time_us);
+  ~DiscreteEventScheduler();
+
+  Clock* clock() { return &clock_; }
+
+  // Schedules |task| to run at the current time, after any events already due
+  // by then, and returns a handle by which the task can be cancelled.
+  TaskId PostTask(Task task);
+
+  // Schedules |task| to run |delay_ms| from now.
+  TaskId PostDelayedTask(Task task, int64_t delay_ms);
+
+  // Returns true if the task was cancelled, false if it already ran or was
+  // not found.
+  bool CancelTask(TaskId task_id);
+
+  // Returns a ProcessThread that processes its modules, and runs its tasks,
+  // on this scheduler. It must not outlive the scheduler.
+  std::unique_ptr<ProcessThread> CreateProcessThread();
+
+  // Runs the events due in the next |duration_ms|, advancing the clock to the
+  // time of each of them, and finally to the end of the period.
+  void RunFor(int64_t duration_ms);
+
+  // The number of tasks and module callbacks run so far.
+  size_t num_events_run() const { return num_events_run_; }
+
+ private:
+  class SimulatedProcessThread;
+
+  // Makes rtc::TimeNanos() follow |clock_|.
+  class RtcClock : public rtc::ClockInterface {
+   public:
+    explicit RtcClock(const Clock* clock) : clock_(clock) {}
+    int64_t TimeNanos() const override {
+      return clock_->TimeInMicroseconds() * rtc::kNumNanosecsPerMicrosec;
+    }
+
+   private:
+    const Clock* const clock_;
+  };
+
+  // Task ids start at 1.
+  static const TaskId kNoTask = 0;
+
+  struct Event {
+    int64_t time_us;
+    TaskId task_id;
+  };
+  struct LaterEvent {
+    bool operator()(const Event& a, const Event& b) const {
+      return a.time_us > b.time_us ||
+             (a.time_us == b.time_us && a.task_id > b.task_id);
+    }
+  };
+
+  TaskId ScheduleAt(int64_t time_us, Task task);
+  void AdvanceTo(int64_t time_us);
+
+  // Module callbacks of the ProcessThreads.
+  void RegisterModule(Module* module);
+  void DeRegisterModule(Module* module);
+  void WakeUp(Module* module);
+  void ScheduleModule(Module* module, int64_t delay_ms);
+  void ProcessModule(Module* module);
+
+  rtc::ThreadChecker thread_checker_;
+  SimulatedClock clock_;
+  RtcClock rtc_clock_;
+  rtc::ClockInterface* const previous_rtc_clock_;
+
+  TaskId next_task_id_;
+  std::map<TaskId, Task> tasks_;
+  std::priority_queue<Event, std::vector<Event>, LaterEvent> events_;
+  // The pending Process() callback of each registered module, kNoTask while
+  // the module is being processed.
+  std::map<Module*, TaskId> modules_;
+  size_t num_events_run_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(DiscreteEventScheduler);
+};
+
+}  // namespace test
+}  // namespace webrtc
+
+#endif  // WEBRTC_TEST_DISCRETE_EVENT_SCHEDULER_H_
@@ -0,0 +1,224 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/test/discrete_event_scheduler.h"
+
+#include <memory>
+#include <vector>
+
+#include "webrtc/rtc_base/location.h"
+#include "webrtc/rtc_base/task_queue.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/test/gtest.h"
+
+namespace webrtc {
+namespace test {
+
+namespace {
+
+constexpr int64_t kStartTimeUs = 1000000;
+
+// Processes every |interval_ms| and records the times it was processed at.
+class PeriodicModule : public Module {
+ public:
+  PeriodicModule(Clock* clock, int64_t interval_ms)
+      : clock_(clock),
+        interval_ms_(interval_ms),
+        next_process_ms_(clock->TimeInMilliseconds() + interval_ms),
+        process_thread_(nullptr) {}
+
+  int64_t TimeUntilNextProcess() override {
+    return next_process_ms_ - clock_->TimeInMilliseconds();
+  }
+
+  void Process() override {
+    process_times_ms_.push_back(clock_->TimeInMilliseconds());
+    next_process_ms_ = clock_->TimeInMilliseconds() + interval_ms_;
+  }
+
+  void ProcessThreadAttached(ProcessThread* process_thread) override {
+    process_thread_ = process_thread;
+  }
+
+  const std::vector<int64_t>& process_times_ms() const {
+    return process_times_ms_;
+  }
+  ProcessThread* process_thread() const { return process_thread_; }
+
+ private:
+  Clock* const clock_;
+  const int64_t interval_ms_;
+  int64_t next_process_ms_;
+  ProcessThread* process_thread_;
+  std::vector<int64_t> process_times_ms_;
+};
+
+// A PeriodicModule that wakes itself up from Process() a number of times.
+class SelfWakingModule : public PeriodicModule {
+ public:
+  SelfWakingModule(Clock* clock, int64_t interval_ms, int wake_ups)
+      : PeriodicModule(clock, interval_ms), wake_ups_left_(wake_ups) {}
+
+  void Process() override {
+    PeriodicModule::Process();
+    if (wake_ups_left_ > 0) {
+      --wake_ups_left_;
+      process_thread()->WakeUp(this);
+    }
+  }
+
+ private:
+  int wake_ups_left_;
+};
+
+}  // namespace
+
+TEST(DiscreteEventSchedulerTest, RunsTasksInTimeOrder) {
+  DiscreteEventScheduler scheduler(kStartTimeUs);
+  std::vector<int> order;
+  scheduler.PostDelayedTask([&order] { order.push_back(3); }, 30);
+  scheduler.PostDelayedTask([&order] { order.push_back(1); }, 10);
+  scheduler.PostTask([&order] { order.push_back(0); });
+  scheduler.PostDelayedTask([&order] { order.push_back(2); }, 10);
+
+  scheduler.RunFor(20);
+  EXPECT_EQ(std::vector<int>({0, 1, 2}), order);
+  EXPECT_EQ(kStartTimeUs + 20000, scheduler.clock()->TimeInMicroseconds());
+
+  scheduler.RunFor(10);
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3}), order);
+  EXPECT_EQ(4u, scheduler.num_events_run());
+}
+
+TEST(DiscreteEventSchedulerTest, AdvancesClockToEachTask) {
+  DiscreteEventScheduler scheduler(kStartTimeUs);
+  Clock* clock = scheduler.clock();
+  std::vector<int64_t> times_ms;
+  std::function<void()> task = [&] {
+    times_ms.push_back(clock->TimeInMilliseconds());
+    if (times_ms.size() < 3)
+      scheduler.PostDelayedTask(task, 100);
+  };
+  scheduler.PostDelayedTask(task, 5);
+
+  scheduler.RunFor(1000);
+  const int64_t start_ms = kStartTimeUs / 1000;
+  EXPECT_EQ(
+      std::vector<int64_t>({start_ms + 5, start_ms + 105, start_ms + 205}),
+      times_ms);
+  EXPECT_EQ(start_ms + 1000, clock->TimeInMilliseconds());
+}
+
+TEST(DiscreteEventSchedulerTest, CancelsTasks) {
+  DiscreteEventScheduler scheduler(kStartTimeUs);
+  bool ran = false;
+  DiscreteEventScheduler::TaskId task_id =
+      scheduler.PostDelayedTask([&ran] { ran = true; }, 10);
+  EXPECT_TRUE(scheduler.CancelTask(task_id));
+  EXPECT_FALSE(scheduler.CancelTask(task_id));
+
+  scheduler.RunFor(100);
+  EXPECT_FALSE(ran);
+  EXPECT_EQ(0u, scheduler.num_events_run());
+}
+
+TEST(DiscreteEventSchedulerTest, RtcTimeFollowsSimulatedTime) {
+  DiscreteEventScheduler scheduler(kStartTimeUs);
+  int64_t rtc_time_us = 0;
+  scheduler.PostDelayedTask(
+      [&rtc_time_us] { rtc_time_us = rtc::TimeMicros(); }, 123);
+
+  scheduler.RunFor(200);
+  EXPECT_EQ(kStartTimeUs + 123000, rtc_time_us);
+  EXPECT_EQ(kStartTimeUs + 200000, rtc::TimeMicros());
+}
+
+TEST(DiscreteEventSchedulerTest, ProcessesModulesWhileStarted) {
+  DiscreteEventScheduler scheduler(kStartTimeUs);
+  std::unique_ptr<ProcessThread> process_thread =
+      scheduler.CreateProcessThread();
+  PeriodicModule module(scheduler.clock(), 10);
+  process_thread->RegisterModule(&module, RTC_FROM_HERE);
+
+  scheduler.RunFor(50);
+  EXPECT_TRUE(module.process_times_ms().empty());
+  EXPECT_EQ(nullptr, module.process_thread());
+
+  // The module is due 10 ms after it was created.
+  process_thread->Start();
+  EXPECT_EQ(process_thread.get(), module.process_thread());
+  scheduler.RunFor(35);
+  const int64_t start_ms = kStartTimeUs / 1000;
+  EXPECT_EQ(std::vector<int64_t>({start_ms + 50, start_ms + 60, start_ms + 70,
+                                  start_ms + 80}),
+            module.process_times_ms());
+
+  process_thread->Stop();
+  EXPECT_EQ(nullptr, module.process_thread());
+  scheduler.RunFor(100);
+  EXPECT_EQ(4u, module.process_times_ms().size());
+  process_thread->DeRegisterModule(&module);
+}
+
+TEST(DiscreteEventSchedulerTest, WakeUpProcessesModuleRightAway) {
+  DiscreteEventScheduler scheduler(kStartTimeUs);
+  std::unique_ptr<ProcessThread> process_thread =
+      scheduler.CreateProcessThread();
+  PeriodicModule module(scheduler.clock(), 100);
+  process_thread->RegisterModule(&module, RTC_FROM_HERE);
+  process_thread->Start();
+
+  scheduler.RunFor(30);
+  process_thread->WakeUp(&module);
+  scheduler.RunFor(150);
+  const int64_t start_ms = kStartTimeUs / 1000;
+  EXPECT_EQ(std::vector<int64_t>({start_ms + 30, start_ms + 130}),
+            module.process_times_ms());
+
+  process_thread->Stop();
+  process_thread->DeRegisterModule(&module);
+}
+
+TEST(DiscreteEventSchedulerTest, WakeUpFromProcessIsNotLost) {
+  DiscreteEventScheduler scheduler(kStartTimeUs);
+  std::unique_ptr<ProcessThread> process_thread =
+      scheduler.CreateProcessThread();
+  SelfWakingModule module(scheduler.clock(), 100, 1);
+  process_thread->RegisterModule(&module, RTC_FROM_HERE);
+  process_thread->Start();
+
+  scheduler.RunFor(250);
+  const int64_t start_ms = kStartTimeUs / 1000;
+  EXPECT_EQ(
+      std::vector<int64_t>({start_ms + 100, start_ms + 100, start_ms + 200}),
+      module.process_times_ms());
+
+  process_thread->Stop();
+  process_thread->DeRegisterModule(&module);
+}
+
+TEST(DiscreteEventSchedulerTest, RunsProcessThreadTasksOnceStarted) {
+  DiscreteEventScheduler scheduler(kStartTimeUs);
+  std::unique_ptr<ProcessThread> process_thread =
+      scheduler.CreateProcessThread();
+  int runs = 0;
+  process_thread->PostTask(rtc::NewClosure([&runs] { ++runs; }));
+
+  scheduler.RunFor(10);
+  EXPECT_EQ(0, runs);
+  process_thread->Start();
+  process_thread->PostTask(rtc::NewClosure([&runs] { ++runs; }));
+  scheduler.RunFor(10);
+  EXPECT_EQ(2, runs);
+  process_thread->Stop();
+}
+
+}  // namespace test
+}  // namespace webrtc
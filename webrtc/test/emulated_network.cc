@@ -0,0 +1,306 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/test/emulated_network.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "webrtc/modules/utility/include/process_thread.h"
+#include "webrtc/rtc_base/checks.h"
+#include "webrtc/rtc_base/ptr_util.h"
+#include "webrtc/system_wrappers/include/clock.h"
+
+namespace webrtc {
+namespace test {
+
+namespace {
+// How long to wait when there is nothing to do.
+constexpr int64_t kIdleProcessIntervalMs = 1000;
+}  // namespace
+
+const EmulatedNetwork::EndpointId EmulatedNetwork::kNoEndpoint =
+    std::numeric_limits<EndpointId>::max();
+
+EmulatedNetwork::Link::Link(const FakeNetworkPipe::Config& config,
+                            uint64_t seed)
+    : random(seed) {
+  ApplyConfig(config, this);
+}
+
+EmulatedNetwork::EmulatedNetwork(Clock* clock, uint64_t seed)
+    : clock_(clock),
+      seed_(seed),
+      process_thread_(nullptr),
+      next_sequence_number_(0) {}
+
+EmulatedNetwork::~EmulatedNetwork() = default;
+
+EmulatedNetwork::EndpointId EmulatedNetwork::AddEndpoint(
+    ReceiveCallback callback) {
+  endpoints_.push_back(std::move(callback));
+  return endpoints_.size() - 1;
+}
+
+EmulatedNetwork::LinkId EmulatedNetwork::AddLink(
+    const FakeNetworkPipe::Config& config) {
+  rtc::CritScope crit(&lock_);
+  // Each link has a random generator of its own, so that adding a link does
+  // not change what happens on the others.
+  links_.push_back(
+      rtc::MakeUnique<Link>(config, seed_ + links_.size() + 1));
+  return links_.size() - 1;
+}
+
+void EmulatedNetwork::SetLinkConfig(LinkId link,
+                                    const FakeNetworkPipe::Config& config) {
+  rtc::CritScope crit(&lock_);
+  RTC_CHECK_LT(link, links_.size());
+  ApplyConfig(config, links_[link].get());
+}
+
+void EmulatedNetwork::SetRoute(EndpointId from,
+                               EndpointId to,
+                               std::vector<LinkId> links) {
+  RTC_CHECK_LT(from, endpoints_.size());
+  RTC_CHECK_LT(to, endpoints_.size());
+  rtc::CritScope crit(&lock_);
+  for (LinkId link : links)
+    RTC_CHECK_LT(link, links_.size());
+  routes_.push_back(std::move(links));
+  route_ids_[std::make_pair(from, to)] = routes_.size() - 1;
+}
+
+void EmulatedNetwork::AddCrossTraffic(std::vector<LinkId> links,
+                                      int rate_kbps,
+                                      size_t packet_size) {
+  RTC_CHECK_GT(rate_kbps, 0);
+  RTC_CHECK_GT(packet_size, 0);
+  {
+    rtc::CritScope crit(&lock_);
+    for (LinkId link : links)
+      RTC_CHECK_LT(link, links_.size());
+    routes_.push_back(std::move(links));
+    cross_traffic_.push_back(
+        {routes_.size() - 1,
+         std::max<int64_t>(packet_size * 8000 / rate_kbps, 1), packet_size});
+    SendCrossTraffic(cross_traffic_.size() - 1, clock_->TimeInMicroseconds());
+  }
+  if (process_thread_)
+    process_thread_->WakeUp(this);
+}
+
+bool EmulatedNetwork::SendPacket(EndpointId from,
+                                 EndpointId to,
+                                 const uint8_t* data,
+                                 size_t length) {
+  bool wake_up;
+  {
+    rtc::CritScope crit(&lock_);
+    auto it = route_ids_.find(std::make_pair(from, to));
+    if (it == route_ids_.end())
+      return false;
+    const int64_t next_event_time_us =
+        events_.empty() ? std::numeric_limits<int64_t>::max()
+                        : events_.top().time_us;
+
+    PacketRecord* packet = AcquirePacketRecord();
+    if (packet->data.size() < length)
+      packet->data.resize(length);
+    memcpy(packet->data.data(), data, length);
+    packet->length = length;
+    packet->from = from;
+    packet->to = to;
+    packet->route = it->second;
+    packet->hop = 0;
+    packet->send_time_us = clock_->TimeInMicroseconds();
+    ForwardPacket(packet, packet->send_time_us);
+
+    // A route without links delivers right away.
+    wake_up = !to_deliver_.empty() ||
+              (!events_.empty() && events_.top().time_us < next_event_time_us);
+  }
+  if (wake_up && process_thread_)
+    process_thread_->WakeUp(this);
+  return true;
+}
+
+EmulatedNetwork::LinkStats EmulatedNetwork::GetLinkStats(LinkId link) const {
+  rtc::CritScope crit(&lock_);
+  RTC_CHECK_LT(link, links_.size());
+  return links_[link]->stats;
+}
+
+size_t EmulatedNetwork::num_packet_records() const {
+  rtc::CritScope crit(&lock_);
+  return packet_records_.size();
+}
+
+int64_t EmulatedNetwork::NextEventTimeUs() const {
+  rtc::CritScope crit(&lock_);
+  if (!to_deliver_.empty())
+    return clock_->TimeInMicroseconds();
+  return events_.empty() ? -1 : events_.top().time_us;
+}
+
+int64_t EmulatedNetwork::TimeUntilNextProcess() {
+  const int64_t next_event_time_us = NextEventTimeUs();
+  if (next_event_time_us < 0)
+    return kIdleProcessIntervalMs;
+  const int64_t delay_us = next_event_time_us - clock_->TimeInMicroseconds();
+  // Round up, so that the event is due when Process() is called.
+  return std::max<int64_t>((delay_us + 999) / 1000, 0);
+}
+
+void EmulatedNetwork::Process() {
+  const int64_t now_us = clock_->TimeInMicroseconds();
+  {
+    rtc::CritScope crit(&lock_);
+    while (!events_.empty() && events_.top().time_us <= now_us) {
+      const Event event = events_.top();
+      events_.pop();
+      if (event.packet) {
+        ForwardPacket(event.packet, event.time_us);
+      } else {
+        SendCrossTraffic(event.cross_traffic, event.time_us);
+      }
+    }
+    delivering_.swap(to_deliver_);
+  }
+
+  for (PacketRecord* packet : delivering_) {
+    endpoints_[packet->to](packet->from, packet->data.data(), packet->length,
+                           packet->send_time_us);
+  }
+
+  rtc::CritScope crit(&lock_);
+  for (PacketRecord* packet : delivering_)
+    ReleasePacketRecord(packet);
+  delivering_.clear();
+}
+
+void EmulatedNetwork::ProcessThreadAttached(ProcessThread* process_thread) {
+  process_thread_ = process_thread;
+}
+
+// static
+void EmulatedNetwork::ApplyConfig(const FakeNetworkPipe::Config& config,
+                                  Link* link) {
+  link->config = config;
+  // Same loss model as FakeNetworkPipe.
+  const double prob_loss = config.loss_percent / 100.0;
+  if (config.avg_burst_loss_length == -1) {
+    link->prob_loss_bursting = prob_loss;
+    link->prob_start_bursting = prob_loss;
+  } else {
+    const int min_avg_burst_loss_length =
+        std::ceil(prob_loss / (1 - prob_loss));
+    RTC_CHECK_GT(config.avg_burst_loss_length, min_avg_burst_loss_length);
+    link->prob_loss_bursting = 1.0 - 1.0 / config.avg_burst_loss_length;
+    link->prob_start_bursting =
+        prob_loss / (1 - prob_loss) / config.avg_burst_loss_length;
+  }
+}
+
+EmulatedNetwork::PacketRecord* EmulatedNetwork::AcquirePacketRecord() {
+  if (free_packet_records_.empty()) {
+    packet_records_.emplace_back();
+    return &packet_records_.back();
+  }
+  PacketRecord* packet = free_packet_records_.back();
+  free_packet_records_.pop_back();
+  return packet;
+}
+
+void EmulatedNetwork::ReleasePacketRecord(PacketRecord* packet) {
+  free_packet_records_.push_back(packet);
+}
+
+void EmulatedNetwork::ForwardPacket(PacketRecord* packet, int64_t time_us) {
+  const std::vector<LinkId>& route = routes_[packet->route];
+  if (packet->hop == route.size()) {
+    if (packet->to == kNoEndpoint) {
+      ReleasePacketRecord(packet);
+    } else {
+      to_deliver_.push_back(packet);
+    }
+    return;
+  }
+
+  Link& link = *links_[route[packet->hop++]];
+  const FakeNetworkPipe::Config& config = link.config;
+  while (!link.departure_times_us.empty() &&
+         link.departure_times_us.front() <= time_us) {
+    link.departure_times_us.pop_front();
+  }
+  if (config.queue_length_packets > 0 &&
+      link.departure_times_us.size() >= config.queue_length_packets) {
+    ++link.stats.dropped_packets;
+    ReleasePacketRecord(packet);
+    return;
+  }
+
+  int64_t departure_time_us = time_us;
+  if (config.link_capacity_kbps > 0) {
+    if (!link.departure_times_us.empty())
+      departure_time_us = link.departure_times_us.back();
+    departure_time_us += packet->length * 8000 / config.link_capacity_kbps;
+    link.departure_times_us.push_back(departure_time_us);
+  }
+
+  if ((link.bursting && link.random.Rand<double>() < link.prob_loss_bursting) ||
+      (!link.bursting &&
+       link.random.Rand<double>() < link.prob_start_bursting)) {
+    link.bursting = true;
+    ++link.stats.dropped_packets;
+    ReleasePacketRecord(packet);
+    return;
+  }
+  link.bursting = false;
+
+  const int64_t delay_us = std::max<int64_t>(
+      link.random.Gaussian(config.queue_delay_ms * 1000.0,
+                           config.delay_standard_deviation_ms * 1000.0),
+      0);
+  int64_t arrival_time_us = departure_time_us + delay_us;
+  if (!config.allow_reordering)
+    arrival_time_us = std::max(arrival_time_us, link.last_arrival_time_us);
+  link.last_arrival_time_us = std::max(arrival_time_us,
+                                       link.last_arrival_time_us);
+
+  ++link.stats.sent_packets;
+  link.stats.total_delay_us += arrival_time_us - time_us;
+  PushEvent(arrival_time_us, packet, 0);
+}
+
+void EmulatedNetwork::PushEvent(int64_t time_us,
+                                PacketRecord* packet,
+                                size_t cross_traffic) {
+  events_.push({time_us, next_sequence_number_++, packet, cross_traffic});
+}
+
+void EmulatedNetwork::SendCrossTraffic(size_t cross_traffic, int64_t time_us) {
+  const CrossTraffic& source = cross_traffic_[cross_traffic];
+  PacketRecord* packet = AcquirePacketRecord();
+  packet->length = source.packet_size;
+  packet->from = kNoEndpoint;
+  packet->to = kNoEndpoint;
+  packet->route = source.route;
+  packet->hop = 0;
+  packet->send_time_us = time_us;
+  ForwardPacket(packet, time_us);
+  PushEvent(time_us + source.interval_us, nullptr, cross_traffic);
+}
+
+}  // namespace test
+}  // namespace webrtc
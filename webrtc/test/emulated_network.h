@@ -0,0 +1,201 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_TEST_EMULATED_NETWORK_H_
+#define WEBRTC_TEST_EMULATED_NETWORK_H_
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "webrtc/modules/include/module.h"
+#include "webrtc/rtc_base/constructormagic.h"
+#include "webrtc/rtc_base/criticalsection.h"
+#include "webrtc/rtc_base/random.h"
+#include "webrtc/test/fake_network_pipe.h"
+
+namespace webrtc {
+
+class Clock;
+
+namespace test {
+
+// Emulates a network of many endpoints connected by links. Each link is a
+// bottleneck configured like a FakeNetworkPipe, i.e. with a capacity, a queue
+// length, a delay with jitter, random or bursty loss and optional reordering.
+// A packet follows the route set up between its sender and its receiver, which
+// may cross any number of links. A link shared by the routes of several
+// endpoints, or loaded with cross traffic, models a shared bottleneck.
+//
+// Unlike FakeNetworkPipe, the time a packet spends on a link is computed when
+// the packet enters it, so there is a single event per packet and link, kept
+// in a time-ordered heap. Process() only handles the events that are due and
+// TimeUntilNextProcess() returns when the next one is, so there is no polling.
+// Packet records and their buffers are pooled and reused.
+//
+// Can be run as a module of a ProcessThread, which is woken up when a packet
+// is sent. Callbacks are made on the thread calling Process(), without holding
+// any lock.
+class EmulatedNetwork : public Module {
+ public:
+  using EndpointId = size_t;
+  using LinkId = size_t;
+  // Called with the sender, the data and the send time of a packet.
+  using ReceiveCallback = std::function<void(EndpointId from,
+                                             const uint8_t* data,
+                                             size_t length,
+                                             int64_t send_time_us)>;
+
+  struct LinkStats {
+    size_t sent_packets = 0;
+    size_t dropped_packets = 0;
+    // Over the sent packets, from entering the link to leaving it.
+    int64_t total_delay_us = 0;
+  };
+
+  EmulatedNetwork(Clock* clock, uint64_t seed);
+  ~EmulatedNetwork() override;
+
+  EndpointId AddEndpoint(ReceiveCallback callback);
+  LinkId AddLink(const FakeNetworkPipe::Config& config);
+  // Does not affect the packets already on the link.
+  void SetLinkConfig(LinkId link, const FakeNetworkPipe::Config& config);
+
+  // Packets from |from| to |to| cross |links|, in order. Packets already on
+  // their way keep their route.
+  void SetRoute(EndpointId from, EndpointId to, std::vector<LinkId> links);
+
+  // Starts sending packets of |packet_size| bytes over |links| at a constant
+  // |rate_kbps|. They take up capacity and queue space on the links and are
+  // discarded at the end of the route.
+  void AddCrossTraffic(std::vector<LinkId> links,
+                       int rate_kbps,
+                       size_t packet_size);
+
+  // Returns false, and drops the packet, if there is no route from |from| to
+  // |to|.
+  bool SendPacket(EndpointId from,
+                  EndpointId to,
+                  const uint8_t* data,
+                  size_t length);
+
+  LinkStats GetLinkStats(LinkId link) const;
+  // The number of packet records allocated, in use or in the pool.
+  size_t num_packet_records() const;
+
+  // The time of the next event, or -1 if there is none.
+  int64_t NextEventTimeUs() const;
+
+  // Implements Module.
+  int64_t TimeUntilNextProcess() override;
+  void Process() override;
+  void ProcessThreadAttached(ProcessThread* process_thread) override;
+
+ private:
+  static const EndpointId kNoEndpoint;
+
+  struct Link {
+    Link(const FakeNetworkPipe::Config& config, uint64_t seed);
+
+    FakeNetworkPipe::Config config;
+    Random random;
+    // When the packets waiting for, or being sent at, the capacity of the
+    // link will have been sent.
+    std::deque<int64_t> departure_times_us;
+    int64_t last_arrival_time_us = 0;
+    bool bursting = false;
+    double prob_loss_bursting = 0;
+    double prob_start_bursting = 0;
+    LinkStats stats;
+  };
+
+  struct PacketRecord {
+    std::vector<uint8_t> data;
+    size_t length = 0;
+    EndpointId from = kNoEndpoint;
+    EndpointId to = kNoEndpoint;
+    // Index into |routes_| and the number of links crossed so far.
+    size_t route = 0;
+    size_t hop = 0;
+    int64_t send_time_us = 0;
+  };
+
+  struct CrossTraffic {
+    size_t route;
+    int64_t interval_us;
+    size_t packet_size;
+  };
+
+  // Either a packet that leaves a link or the next packet of a cross traffic
+  // source. Events due at the same time are handled in the order they were
+  // scheduled.
+  struct Event {
+    int64_t time_us;
+    uint64_t sequence_number;
+    PacketRecord* packet;
+    size_t cross_traffic;
+  };
+  struct LaterEvent {
+    bool operator()(const Event& a, const Event& b) const {
+      return a.time_us > b.time_us ||
+             (a.time_us == b.time_us && a.sequence_number > b.sequence_number);
+    }
+  };
+
+  static void ApplyConfig(const FakeNetworkPipe::Config& config, Link* link);
+
+  PacketRecord* AcquirePacketRecord() RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void ReleasePacketRecord(PacketRecord* packet)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Puts |packet| on the next link of its route at |time_us|, or adds it to
+  // |to_deliver_| if it has crossed all of them.
+  void ForwardPacket(PacketRecord* packet, int64_t time_us)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void PushEvent(int64_t time_us, PacketRecord* packet, size_t cross_traffic)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void SendCrossTraffic(size_t cross_traffic, int64_t time_us)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  Clock* const clock_;
+  const uint64_t seed_;
+  rtc::CriticalSection lock_;
+  ProcessThread* process_thread_;
+
+  // Only modified while not processing, so read by Process() without |lock_|.
+  std::vector<ReceiveCallback> endpoints_;
+
+  std::vector<std::unique_ptr<Link>> links_ RTC_GUARDED_BY(lock_);
+  // Append only, so that packets on their way keep their route.
+  std::vector<std::vector<LinkId>> routes_ RTC_GUARDED_BY(lock_);
+  std::map<std::pair<EndpointId, EndpointId>, size_t> route_ids_
+      RTC_GUARDED_BY(lock_);
+  std::vector<CrossTraffic> cross_traffic_ RTC_GUARDED_BY(lock_);
+
+  // A deque, so that records do not move when it grows.
+  std::deque<PacketRecord> packet_records_ RTC_GUARDED_BY(lock_);
+  std::vector<PacketRecord*> free_packet_records_ RTC_GUARDED_BY(lock_);
+  std::priority_queue<Event, std::vector<Event>, LaterEvent> events_
+      RTC_GUARDED_BY(lock_);
+  uint64_t next_sequence_number_ RTC_GUARDED_BY(lock_);
+  std::vector<PacketRecord*> to_deliver_ RTC_GUARDED_BY(lock_);
+  // Only used by Process().
+  std::vector<PacketRecord*> delivering_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(EmulatedNetwork);
+};
+
+}  // namespace test
+}  // namespace webrtc
+
+#endif  // WEBRTC_TEST_EMULATED_NETWORK_H_
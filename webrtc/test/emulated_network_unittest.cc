@@ -0,0 +1,311 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/test/emulated_network.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/system_wrappers/include/clock.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace test {
+
+namespace {
+
+constexpr int64_t kStartTimeUs = 1000000;
+
+FakeNetworkPipe::Config LinkConfig(int capacity_kbps, int delay_ms) {
+  FakeNetworkPipe::Config config;
+  config.link_capacity_kbps = capacity_kbps;
+  config.queue_delay_ms = delay_ms;
+  return config;
+}
+
+struct ReceivedPacket {
+  EmulatedNetwork::EndpointId from;
+  int sequence_number;
+  int64_t arrival_time_us;
+};
+
+}  // namespace
+
+class EmulatedNetworkTest : public ::testing::Test {
+ public:
+  EmulatedNetworkTest() : clock_(kStartTimeUs), network_(&clock_, 1) {}
+
+ protected:
+  // Adds an endpoint that records the packets it receives.
+  EmulatedNetwork::EndpointId AddEndpoint() {
+    return network_.AddEndpoint([this](EmulatedNetwork::EndpointId from,
+                                       const uint8_t* data, size_t length,
+                                       int64_t send_time_us) {
+      int sequence_number;
+      memcpy(&sequence_number, data, sizeof(sequence_number));
+      received_.push_back(
+          {from, sequence_number, clock_.TimeInMicroseconds() - kStartTimeUs});
+    });
+  }
+
+  void SendPacket(EmulatedNetwork::EndpointId from,
+                  EmulatedNetwork::EndpointId to,
+                  int sequence_number,
+                  size_t size) {
+    std::vector<uint8_t> packet(size);
+    memcpy(packet.data(), &sequence_number, sizeof(sequence_number));
+    EXPECT_TRUE(network_.SendPacket(from, to, packet.data(), packet.size()));
+  }
+
+  // Processes the network until |duration_ms| from now, jumping from one
+  // event to the next.
+  void RunFor(int64_t duration_ms) {
+    const int64_t end_time_us =
+        clock_.TimeInMicroseconds() + duration_ms * 1000;
+    for (int64_t next_us = network_.NextEventTimeUs();
+         next_us >= 0 && next_us <= end_time_us;
+         next_us = network_.NextEventTimeUs()) {
+      clock_.AdvanceTimeMicroseconds(next_us - clock_.TimeInMicroseconds());
+      network_.Process();
+    }
+    clock_.AdvanceTimeMicroseconds(end_time_us - clock_.TimeInMicroseconds());
+  }
+
+  SimulatedClock clock_;
+  EmulatedNetwork network_;
+  std::vector<ReceivedPacket> received_;
+};
+
+TEST_F(EmulatedNetworkTest, AddsUpTheDelaysOfTheLinksOnTheRoute) {
+  const EmulatedNetwork::EndpointId sender = AddEndpoint();
+  const EmulatedNetwork::EndpointId receiver = AddEndpoint();
+  network_.SetRoute(sender, receiver,
+                    {network_.AddLink(LinkConfig(0, 10)),
+                     network_.AddLink(LinkConfig(0, 20))});
+  EXPECT_FALSE(network_.SendPacket(receiver, sender, nullptr, 0));
+
+  SendPacket(sender, receiver, 1, 100);
+  RunFor(29);
+  EXPECT_TRUE(received_.empty());
+  RunFor(1);
+  ASSERT_EQ(1u, received_.size());
+  EXPECT_EQ(sender, received_[0].from);
+  EXPECT_EQ(1, received_[0].sequence_number);
+  EXPECT_EQ(30000, received_[0].arrival_time_us);
+}
+
+TEST_F(EmulatedNetworkTest, SharesBottleneckBetweenEndpoints) {
+  const EmulatedNetwork::EndpointId first = AddEndpoint();
+  const EmulatedNetwork::EndpointId second = AddEndpoint();
+  const EmulatedNetwork::EndpointId receiver = AddEndpoint();
+  // 1000 bytes take 10 ms at 800 kbps.
+  const EmulatedNetwork::LinkId bottleneck =
+      network_.AddLink(LinkConfig(800, 5));
+  network_.SetRoute(first, receiver,
+                    {network_.AddLink(LinkConfig(0, 0)), bottleneck});
+  network_.SetRoute(second, receiver,
+                    {network_.AddLink(LinkConfig(0, 0)), bottleneck});
+
+  SendPacket(first, receiver, 1, 1000);
+  SendPacket(second, receiver, 2, 1000);
+  SendPacket(first, receiver, 3, 1000);
+  RunFor(100);
+  ASSERT_EQ(3u, received_.size());
+  EXPECT_EQ(15000, received_[0].arrival_time_us);
+  EXPECT_EQ(second, received_[1].from);
+  EXPECT_EQ(25000, received_[1].arrival_time_us);
+  EXPECT_EQ(35000, received_[2].arrival_time_us);
+  EXPECT_EQ(3u, network_.GetLinkStats(bottleneck).sent_packets);
+}
+
+TEST_F(EmulatedNetworkTest, DropsPacketsWhenQueueIsFull) {
+  const EmulatedNetwork::EndpointId sender = AddEndpoint();
+  const EmulatedNetwork::EndpointId receiver = AddEndpoint();
+  FakeNetworkPipe::Config config = LinkConfig(800, 0);
+  config.queue_length_packets = 2;
+  const EmulatedNetwork::LinkId link = network_.AddLink(config);
+  network_.SetRoute(sender, receiver, {link});
+
+  for (int i = 0; i < 5; ++i)
+    SendPacket(sender, receiver, i, 1000);
+  RunFor(15);
+  // The queue has room again once the first packet has been sent.
+  SendPacket(sender, receiver, 5, 1000);
+  RunFor(100);
+  ASSERT_EQ(3u, received_.size());
+  EXPECT_EQ(0, received_[0].sequence_number);
+  EXPECT_EQ(1, received_[1].sequence_number);
+  EXPECT_EQ(5, received_[2].sequence_number);
+  EXPECT_EQ(3u, network_.GetLinkStats(link).dropped_packets);
+}
+
+TEST_F(EmulatedNetworkTest, CrossTrafficTakesUpCapacity) {
+  const EmulatedNetwork::EndpointId sender = AddEndpoint();
+  const EmulatedNetwork::EndpointId receiver = AddEndpoint();
+  const EmulatedNetwork::LinkId link = network_.AddLink(LinkConfig(800, 0));
+  network_.SetRoute(sender, receiver, {link});
+  // Keeps the link busy half of the time, 10 ms out of every 20 ms.
+  network_.AddCrossTraffic({link}, 400, 1000);
+
+  RunFor(5);
+  SendPacket(sender, receiver, 1, 1000);
+  RunFor(100);
+  ASSERT_EQ(1u, received_.size());
+  // Waits for the cross traffic packet sent at 0 ms.
+  EXPECT_EQ(20000, received_[0].arrival_time_us);
+}
+
+TEST_F(EmulatedNetworkTest, KeepsOrderUnlessReorderingIsAllowed) {
+  const EmulatedNetwork::EndpointId sender = AddEndpoint();
+  const EmulatedNetwork::EndpointId receiver = AddEndpoint();
+  FakeNetworkPipe::Config config = LinkConfig(0, 50);
+  config.delay_standard_deviation_ms = 20;
+  const EmulatedNetwork::LinkId link = network_.AddLink(config);
+  network_.SetRoute(sender, receiver, {link});
+
+  const int kNumPackets = 100;
+  for (int i = 0; i < kNumPackets; ++i) {
+    SendPacket(sender, receiver, i, 100);
+    RunFor(1);
+  }
+  RunFor(1000);
+  ASSERT_EQ(static_cast<size_t>(kNumPackets), received_.size());
+  for (int i = 0; i < kNumPackets; ++i)
+    EXPECT_EQ(i, received_[i].sequence_number);
+
+  received_.clear();
+  config.allow_reordering = true;
+  network_.SetLinkConfig(link, config);
+  for (int i = 0; i < kNumPackets; ++i) {
+    SendPacket(sender, receiver, i, 100);
+    RunFor(1);
+  }
+  RunFor(1000);
+  ASSERT_EQ(static_cast<size_t>(kNumPackets), received_.size());
+  int num_reordered = 0;
+  for (int i = 1; i < kNumPackets; ++i) {
+    if (received_[i].sequence_number < received_[i - 1].sequence_number)
+      ++num_reordered;
+  }
+  EXPECT_GT(num_reordered, 0);
+}
+
+TEST_F(EmulatedNetworkTest, LosesPacketsPerLink) {
+  const EmulatedNetwork::EndpointId sender = AddEndpoint();
+  const EmulatedNetwork::EndpointId receiver = AddEndpoint();
+  FakeNetworkPipe::Config lossy = LinkConfig(0, 0);
+  lossy.loss_percent = 20;
+  const EmulatedNetwork::LinkId lossy_link = network_.AddLink(lossy);
+  const EmulatedNetwork::LinkId lossless_link =
+      network_.AddLink(LinkConfig(0, 0));
+  network_.SetRoute(sender, receiver, {lossy_link, lossless_link});
+
+  const int kNumPackets = 10000;
+  for (int i = 0; i < kNumPackets; ++i)
+    SendPacket(sender, receiver, i, 100);
+  RunFor(10);
+  const EmulatedNetwork::LinkStats stats = network_.GetLinkStats(lossy_link);
+  EXPECT_NEAR(kNumPackets * 0.2, stats.dropped_packets, kNumPackets * 0.02);
+  EXPECT_EQ(0u, network_.GetLinkStats(lossless_link).dropped_packets);
+  EXPECT_EQ(received_.size(), stats.sent_packets);
+}
+
+TEST_F(EmulatedNetworkTest, ReusesPacketRecords) {
+  const EmulatedNetwork::EndpointId sender = AddEndpoint();
+  const EmulatedNetwork::EndpointId receiver = AddEndpoint();
+  network_.SetRoute(sender, receiver, {network_.AddLink(LinkConfig(0, 10))});
+
+  for (int i = 0; i < 1000; ++i) {
+    SendPacket(sender, receiver, i, 1000);
+    RunFor(1);
+  }
+  RunFor(100);
+  EXPECT_EQ(1000u, received_.size());
+  // At most 10 ms worth of packets are on the link at a time.
+  EXPECT_LE(network_.num_packet_records(), 11u);
+}
+
+// Many clients send to an SFU over their own access links and a shared
+// bottleneck, which also carries cross traffic. The SFU forwards every packet
+// to a few other clients. Reports how many packets are emulated per second.
+// Disabled since it only reports timings; run it with
+// --gtest_also_run_disabled_tests.
+TEST(EmulatedNetworkPerformanceTest, DISABLED_PacketsPerSecond) {
+  const int kNumClients = 200;
+  const int kNumForwards = 3;
+  const int64_t kPacketIntervalMs = 20;
+  const size_t kPacketSize = 1200;
+  const int64_t kDurationMs = 10000;
+
+  SimulatedClock clock(kStartTimeUs);
+  EmulatedNetwork network(&clock, 1);
+  size_t num_received = 0;
+  std::vector<EmulatedNetwork::EndpointId> clients;
+  EmulatedNetwork::EndpointId sfu = 0;
+  sfu = network.AddEndpoint(
+      [&](EmulatedNetwork::EndpointId from, const uint8_t* data, size_t length,
+          int64_t send_time_us) {
+        for (int i = 1; i <= kNumForwards; ++i)
+          network.SendPacket(sfu, clients[(from + i) % kNumClients], data,
+                             length);
+      });
+  for (int i = 0; i < kNumClients; ++i) {
+    clients.push_back(network.AddEndpoint(
+        [&num_received](EmulatedNetwork::EndpointId from, const uint8_t* data,
+                        size_t length,
+                        int64_t send_time_us) { ++num_received; }));
+  }
+
+  FakeNetworkPipe::Config access = LinkConfig(5000, 20);
+  access.delay_standard_deviation_ms = 5;
+  access.loss_percent = 1;
+  access.queue_length_packets = 100;
+  const EmulatedNetwork::LinkId uplink_bottleneck =
+      network.AddLink(LinkConfig(kNumClients * 1000, 5));
+  const EmulatedNetwork::LinkId downlink_bottleneck =
+      network.AddLink(LinkConfig(kNumClients * kNumForwards * 1000, 5));
+  network.AddCrossTraffic({uplink_bottleneck}, kNumClients * 200, kPacketSize);
+  for (EmulatedNetwork::EndpointId client : clients) {
+    network.SetRoute(client, sfu,
+                     {network.AddLink(access), uplink_bottleneck});
+    network.SetRoute(sfu, client,
+                     {downlink_bottleneck, network.AddLink(access)});
+  }
+
+  std::vector<uint8_t> packet(kPacketSize);
+  size_t num_sent = 0;
+  const int64_t start_us = rtc::TimeMicros();
+  for (int64_t time_ms = 0; time_ms < kDurationMs; ++time_ms) {
+    // Spread the clients evenly over the packet interval.
+    for (int i = time_ms % kPacketIntervalMs; i < kNumClients;
+         i += kPacketIntervalMs) {
+      network.SendPacket(clients[i], sfu, packet.data(), packet.size());
+      ++num_sent;
+    }
+    clock.AdvanceTimeMilliseconds(1);
+    network.Process();
+  }
+  const int64_t elapsed_us = std::max<int64_t>(rtc::TimeMicros() - start_us, 1);
+
+  EXPECT_GT(num_received, num_sent * kNumForwards * 9 / 10);
+  const size_t num_emulated = num_sent * (1 + kNumForwards);
+  test::PrintResult("emulated_network", "", "packets_per_second",
+                    static_cast<size_t>(num_emulated * 1000000 / elapsed_us),
+                    "packets/s", false);
+  test::PrintResult("emulated_network", "", "packet_records",
+                    network.num_packet_records(), "records", false);
+}
+
+}  // namespace test
+}  // namespace webrtc
@@ -13,14 +13,15 @@
 #include <assert.h>
 #include <stdio.h>
 
-#include <algorithm>  // min_element, max_element
+#include <algorithm>  // min, min_element, max_element
 #include <memory>
 
-#include "webrtc/api/video/i420_buffer.h"
-#include "webrtc/api/video/video_frame.h"
+#include "webrtc/api/video/video_frame_buffer.h"
+#include "webrtc/common_video/include/video_frame_buffer.h"
 #include "webrtc/common_video/libyuv/include/webrtc_libyuv.h"
-#include "webrtc/test/frame_utils.h"
-#include "libyuv/convert.h"
+#include "webrtc/rtc_base/memory_mapped_file.h"
+#include "webrtc/rtc_base/parallel_for.h"
+#include "webrtc/system_wrappers/include/cpu_info.h"
 
 namespace webrtc {
 namespace test {
@@ -36,25 +37,16 @@ static bool LessForFrameResultValue(const FrameResult& s1,
 
 enum VideoMetricsType { kPSNR, kSSIM, kBoth };
 
-// Calculates metrics for a frame and adds statistics to the result for it.
-void CalculateFrame(VideoMetricsType video_metrics_type,
-                    const I420BufferInterface& ref,
-                    const I420BufferInterface& test,
-                    int frame_number,
-                    QualityMetricsResult* result) {
-  FrameResult frame_result = {0, 0};
-  frame_result.frame_number = frame_number;
-  switch (video_metrics_type) {
-    case kPSNR:
-      frame_result.value = I420PSNR(ref, test);
-      break;
-    case kSSIM:
-      frame_result.value = I420SSIM(ref, test);
-      break;
-    default:
-      assert(false);
-  }
-  result->frames.push_back(frame_result);
+rtc::scoped_refptr<I420BufferInterface> WrapFrame(const uint8_t* data,
+                                                  int width,
+                                                  int height) {
+  const int chroma_width = (width + 1) / 2;
+  const int chroma_height = (height + 1) / 2;
+  const uint8_t* u_plane = data + width * height;
+  const uint8_t* v_plane = u_plane + chroma_width * chroma_height;
+  // The mapped files outlive the buffers.
+  return WrapI420Buffer(width, height, data, width, u_plane, chroma_width,
+                        v_plane, chroma_width, [] {});
 }
 
 // Calculates average, min and max values for the supplied struct, if non-NULL.
@@ -96,65 +88,68 @@ int CalculateMetrics(VideoMetricsType video_metrics_type,
   assert(width > 0);
   assert(height > 0);
 
-  FILE* ref_fp = fopen(ref_filename, "rb");
-  if (ref_fp == NULL) {
+  // The frames are read straight from the mapped files, by several threads.
+  std::unique_ptr<rtc::MemoryMappedFile> ref_file =
+      rtc::MemoryMappedFile::Open(ref_filename);
+  if (!ref_file) {
     // Cannot open reference file.
     fprintf(stderr, "Cannot open file %s\n", ref_filename);
     return -1;
   }
-  FILE* test_fp = fopen(test_filename, "rb");
-  if (test_fp == NULL) {
+  std::unique_ptr<rtc::MemoryMappedFile> test_file =
+      rtc::MemoryMappedFile::Open(test_filename);
+  if (!test_file) {
     // Cannot open test file.
     fprintf(stderr, "Cannot open file %s\n", test_filename);
-    fclose(ref_fp);
     return -2;
   }
-  int frame_number = 0;
-
-  // Read reference and test frames.
-  for (;;) {
-    rtc::scoped_refptr<I420Buffer> ref_i420_buffer(
-        test::ReadI420Buffer(width, height, ref_fp));
-    if (!ref_i420_buffer)
-      break;
-
-    rtc::scoped_refptr<I420Buffer> test_i420_buffer(
-        test::ReadI420Buffer(width, height, test_fp));
-
-    if (!test_i420_buffer)
-      break;
-
-    switch (video_metrics_type) {
-      case kPSNR:
-        CalculateFrame(kPSNR, *ref_i420_buffer, *test_i420_buffer, frame_number,
-                       psnr_result);
-        break;
-      case kSSIM:
-        CalculateFrame(kSSIM, *ref_i420_buffer, *test_i420_buffer, frame_number,
-                       ssim_result);
-        break;
-      case kBoth:
-        CalculateFrame(kPSNR, *ref_i420_buffer, *test_i420_buffer, frame_number,
-                       psnr_result);
-        CalculateFrame(kSSIM, *ref_i420_buffer, *test_i420_buffer, frame_number,
-                       ssim_result);
-        break;
-    }
-    frame_number++;
-  }
-  int return_code = 0;
-  if (frame_number == 0) {
+
+  // Frames are compared until the shortest video ends.
+  const size_t frame_size = CalcBufferSize(VideoType::kI420, width, height);
+  const size_t num_frames =
+      std::min(ref_file->size(), test_file->size()) / frame_size;
+  if (num_frames == 0) {
     fprintf(stderr, "Tried to measure video metrics from empty files "
             "(reference file: %s  test file: %s)\n", ref_filename,
             test_filename);
-    return_code = -3;
-  } else {
-    CalculateStats(psnr_result);
-    CalculateStats(ssim_result);
+    return -3;
+  }
+
+  std::vector<FrameResult> psnr_frames;
+  std::vector<FrameResult> ssim_frames;
+  if (video_metrics_type != kSSIM)
+    psnr_frames.resize(num_frames);
+  if (video_metrics_type != kPSNR)
+    ssim_frames.resize(num_frames);
+
+  const uint8_t* const ref_data = ref_file->data();
+  const uint8_t* const test_data = test_file->data();
+  rtc::ParallelFor(
+      num_frames, static_cast<int>(CpuInfo::DetectNumberOfCores()),
+      "VideoMetrics", [&](size_t i) {
+        rtc::scoped_refptr<I420BufferInterface> ref =
+            WrapFrame(ref_data + i * frame_size, width, height);
+        rtc::scoped_refptr<I420BufferInterface> test =
+            WrapFrame(test_data + i * frame_size, width, height);
+        const int frame_number = static_cast<int>(i);
+        if (!psnr_frames.empty())
+          psnr_frames[i] = {frame_number, I420PSNR(*ref, *test)};
+        if (!ssim_frames.empty())
+          ssim_frames[i] = {frame_number, I420SSIM(*ref, *test)};
+      });
+
+  // Results are in frame order, whichever thread calculated them.
+  if (psnr_result) {
+    psnr_result->frames.insert(psnr_result->frames.end(), psnr_frames.begin(),
+                               psnr_frames.end());
+  }
+  if (ssim_result) {
+    ssim_result->frames.insert(ssim_result->frames.end(), ssim_frames.begin(),
+                               ssim_frames.end());
   }
-  fclose(ref_fp);
-  fclose(test_fp);
-  return return_code;
+  CalculateStats(psnr_result);
+  CalculateStats(ssim_result);
+  return 0;
 }
 
 int I420MetricsFromFiles(const char* ref_filename,
@@ -10,6 +10,13 @@
 
 #include "webrtc/test/testsupport/metrics/video_metrics.h"
 
+#include <stdio.h>
+
+#include <vector>
+
+#include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/common_video/libyuv/include/webrtc_libyuv.h"
+#include "webrtc/rtc_base/random.h"
 #include "webrtc/test/gtest.h"
 #include "webrtc/test/testsupport/fileutils.h"
 
@@ -144,4 +151,70 @@ TEST_F(VideoMetricsTest, EmptyFilesBothMetrics) {
                                    &psnr_result_, &ssim_result_));
 }
 
+// Tests that the metrics of each frame are given in order, and that frames are
+// compared until the shortest file ends.
+TEST_F(VideoMetricsTest, ResultsForEachFrameInOrder) {
+  const int kSmallWidth = 40;
+  const int kSmallHeight = 30;
+  const size_t kFrameSize =
+      CalcBufferSize(VideoType::kI420, kSmallWidth, kSmallHeight);
+  const size_t kNumFrames = 20;
+  Random random(0x6e);
+  std::vector<uint8_t> ref(kFrameSize * kNumFrames);
+  std::vector<uint8_t> test(ref.size());
+  for (size_t i = 0; i < ref.size(); ++i) {
+    ref[i] = static_cast<uint8_t>(random.Rand(100, 140));
+    // The noise grows from frame to frame.
+    const int noise = 1 + static_cast<int>(i / kFrameSize);
+    test[i] = static_cast<uint8_t>(ref[i] + random.Rand(-noise, noise));
+  }
+  const std::string ref_file = webrtc::test::TempFilename(
+      webrtc::test::OutputPath(), "video_metrics_unittest_ref");
+  const std::string test_file = webrtc::test::TempFilename(
+      webrtc::test::OutputPath(), "video_metrics_unittest_test");
+  FILE* file = fopen(ref_file.c_str(), "wb");
+  ASSERT_TRUE(file != NULL);
+  fwrite(ref.data(), 1, ref.size(), file);
+  fclose(file);
+  // The test file ends with half a frame, which is not compared.
+  file = fopen(test_file.c_str(), "wb");
+  ASSERT_TRUE(file != NULL);
+  fwrite(test.data(), 1, test.size() - kFrameSize / 2, file);
+  fclose(file);
+
+  EXPECT_EQ(0, I420MetricsFromFiles(ref_file.c_str(), test_file.c_str(),
+                                    kSmallWidth, kSmallHeight, &psnr_result_,
+                                    &ssim_result_));
+  ASSERT_EQ(kNumFrames - 1, psnr_result_.frames.size());
+  ASSERT_EQ(kNumFrames - 1, ssim_result_.frames.size());
+  const int chroma_width = (kSmallWidth + 1) / 2;
+  const int chroma_height = (kSmallHeight + 1) / 2;
+  for (size_t i = 0; i < kNumFrames - 1; ++i) {
+    const uint8_t* ref_y = ref.data() + i * kFrameSize;
+    const uint8_t* ref_u = ref_y + kSmallWidth * kSmallHeight;
+    const uint8_t* ref_v = ref_u + chroma_width * chroma_height;
+    const uint8_t* test_y = test.data() + i * kFrameSize;
+    const uint8_t* test_u = test_y + kSmallWidth * kSmallHeight;
+    const uint8_t* test_v = test_u + chroma_width * chroma_height;
+    rtc::scoped_refptr<I420Buffer> ref_buffer = I420Buffer::Copy(
+        kSmallWidth, kSmallHeight, ref_y, kSmallWidth, ref_u, chroma_width,
+        ref_v, chroma_width);
+    rtc::scoped_refptr<I420Buffer> test_buffer = I420Buffer::Copy(
+        kSmallWidth, kSmallHeight, test_y, kSmallWidth, test_u, chroma_width,
+        test_v, chroma_width);
+    EXPECT_EQ(static_cast<int>(i), psnr_result_.frames[i].frame_number);
+    EXPECT_EQ(I420PSNR(*ref_buffer, *test_buffer),
+              psnr_result_.frames[i].value);
+    EXPECT_EQ(static_cast<int>(i), ssim_result_.frames[i].frame_number);
+    EXPECT_EQ(I420SSIM(*ref_buffer, *test_buffer),
+              ssim_result_.frames[i].value);
+  }
+  // The quality drops as the noise grows.
+  EXPECT_EQ(0, psnr_result_.max_frame_number);
+  EXPECT_EQ(static_cast<int>(kNumFrames) - 2, psnr_result_.min_frame_number);
+
+  remove(ref_file.c_str());
+  remove(test_file.c_str());
+}
+
 }  // namespace webrtc
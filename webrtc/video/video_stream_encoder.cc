@@ -23,12 +23,14 @@
 #include "webrtc/modules/video_coding/include/video_codec_initializer.h"
 #include "webrtc/modules/video_coding/include/video_coding.h"
 #include "webrtc/modules/video_coding/include/video_coding_defines.h"
+#include "webrtc/modules/video_processing/video_denoiser.h"
 #include "webrtc/rtc_base/arraysize.h"
 #include "webrtc/rtc_base/checks.h"
 #include "webrtc/rtc_base/location.h"
 #include "webrtc/rtc_base/logging.h"
 #include "webrtc/rtc_base/timeutils.h"
 #include "webrtc/rtc_base/trace_event.h"
+#include "webrtc/system_wrappers/include/field_trial.h"
 #include "webrtc/video/overuse_frame_detector.h"
 #include "webrtc/video/send_statistics_proxy.h"
 
@@ -45,6 +47,9 @@ const int kMaxFramerateFps = 120;
 // to try and achieve desired bitrate.
 const int kMaxInitialFramedrop = 4;
 
+// Enables denoising the luma plane of non-texture frames before encoding.
+const char kDenoiserFieldTrial[] = "WebRTC-VideoDenoiser";
+
 uint32_t MaximumFrameSizeForBitrate(uint32_t kbps) {
   if (kbps > 0) {
     if (kbps < 300 /* qvga */) {
@@ -149,6 +154,7 @@ class VideoStreamEncoder::EncodeTask : public rtc::QueuedTask {
       LOG(LS_VERBOSE)
           << "Incoming frame dropped due to that the encoder is blocked.";
       ++video_stream_encoder_->dropped_frame_count_;
+      video_stream_encoder_->update_rects_.AddDroppedFrame(frame_);
     }
     if (log_stats_) {
       LOG(LS_INFO) << "Number of frames: captured "
@@ -417,6 +423,9 @@ VideoStreamEncoder::VideoStreamEncoder(uint32_t number_of_cores,
       captured_frame_count_(0),
       dropped_frame_count_(0),
       bitrate_observer_(nullptr),
+      denoiser_(field_trial::IsEnabled(kDenoiserFieldTrial)
+                    ? new VideoDenoiser(true /* runtime_cpu_detection */)
+                    : nullptr),
       encoder_queue_("EncoderQueue") {
   RTC_DCHECK(stats_proxy);
   encoder_queue_.PostTask([this] {
@@ -708,6 +717,12 @@ void VideoStreamEncoder::OnFrame(const VideoFrame& video_frame) {
                     << incoming_frame.ntp_time_ms()
                     << " <= " << last_captured_timestamp_
                     << ") for incoming frame. Dropping.";
+    const rtc::Optional<std::vector<VideoFrame::UpdateRect>> update_rects =
+        video_frame.update_rects();
+    encoder_queue_.PostTask([this, update_rects] {
+      RTC_DCHECK_RUN_ON(&encoder_queue_);
+      update_rects_.Add(update_rects);
+    });
     return;
   }
 
@@ -773,6 +788,7 @@ void VideoStreamEncoder::EncodeVideoFrame(const VideoFrame& video_frame,
     LOG(LS_INFO) << "Dropping frame. Too large for target bitrate.";
     AdaptDown(kQuality);
     ++initial_rampup_;
+    update_rects_.AddDroppedFrame(video_frame);
     return;
   }
   initial_rampup_ = kMaxInitialFramedrop;
@@ -791,11 +807,13 @@ void VideoStreamEncoder::EncodeVideoFrame(const VideoFrame& video_frame,
 
   if (EncoderPaused()) {
     TraceFrameDropStart();
+    update_rects_.AddDroppedFrame(video_frame);
     return;
   }
   TraceFrameDropEnd();
 
   VideoFrame out_frame(video_frame);
+  out_frame.set_update_rects(update_rects_.TakeForFrame(video_frame));
   // Crop frame if needed.
   if (crop_width_ > 0 || crop_height_ > 0) {
     int cropped_width = video_frame.width() - crop_width_;
@@ -812,6 +830,8 @@ void VideoStreamEncoder::EncodeVideoFrame(const VideoFrame& video_frame,
       cropped_buffer->ScaleFrom(
           *video_frame.video_frame_buffer()->ToI420().get());
     }
+    // The update rects of the source frame are not translated to the
+    // cropped one, leaving them unknown.
     out_frame =
         VideoFrame(cropped_buffer, video_frame.timestamp(),
                    video_frame.render_time_ms(), video_frame.rotation());
@@ -823,6 +843,22 @@ void VideoStreamEncoder::EncodeVideoFrame(const VideoFrame& video_frame,
 
   overuse_detector_->FrameCaptured(out_frame, time_when_posted_us);
 
+  // Denoise after FrameCaptured(), so that the time spent counts towards the
+  // encode usage seen by the overuse detector. Screen content has no camera
+  // noise, and filtering it would only blur text and sharp edges.
+  if (denoiser_ && !out_frame.is_texture() &&
+      encoder_config_.content_type !=
+          VideoEncoderConfig::ContentType::kScreen) {
+    VideoFrame denoised_frame(
+        denoiser_->DenoiseFrame(out_frame.video_frame_buffer()->ToI420(),
+                                true /* noise_estimation_enabled */),
+        out_frame.timestamp(), out_frame.render_time_ms(),
+        out_frame.rotation());
+    denoised_frame.set_ntp_time_ms(out_frame.ntp_time_ms());
+    denoised_frame.set_update_rects(out_frame.update_rects());
+    out_frame = denoised_frame;
+  }
+
   video_sender_.AddVideoFrame(out_frame, nullptr);
 }
 
@@ -20,6 +20,7 @@
 #include "webrtc/api/video_codecs/video_encoder.h"
 #include "webrtc/call/call.h"
 #include "webrtc/common_types.h"
+#include "webrtc/common_video/include/update_rect_accumulator.h"
 #include "webrtc/common_video/include/video_bitrate_allocator.h"
 #include "webrtc/media/base/videosinkinterface.h"
 #include "webrtc/modules/video_coding/include/video_coding_defines.h"
@@ -39,6 +40,7 @@ namespace webrtc {
 class ProcessThread;
 class SendStatisticsProxy;
 class VideoBitrateAllocationObserver;
+class VideoDenoiser;
 
 // VideoStreamEncoder represent a video encoder that accepts raw video frames as
 // input and produces an encoded bit stream.
@@ -306,6 +308,12 @@ class VideoStreamEncoder : public rtc::VideoSinkInterface<VideoFrame>,
       RTC_ACCESS_ON(&encoder_queue_);
   rtc::Optional<int64_t> last_parameters_update_ms_
       RTC_ACCESS_ON(&encoder_queue_);
+  // Set if the "WebRTC-VideoDenoiser" field trial is enabled. Not used for
+  // screen content.
+  const std::unique_ptr<VideoDenoiser> denoiser_
+      RTC_ACCESS_ON(&encoder_queue_);
+  // Update rects of the frames dropped before reaching |video_sender_|.
+  UpdateRectAccumulator update_rects_ RTC_ACCESS_ON(&encoder_queue_);
 
   // All public methods are proxied to |encoder_queue_|. It must must be
   // destroyed first to make sure no tasks are run that use other members.
@@ -22,6 +22,7 @@
 #include "webrtc/system_wrappers/include/sleep.h"
 #include "webrtc/test/encoder_settings.h"
 #include "webrtc/test/fake_encoder.h"
+#include "webrtc/test/field_trial.h"
 #include "webrtc/test/frame_generator.h"
 #include "webrtc/test/gmock.h"
 #include "webrtc/test/gtest.h"
@@ -349,6 +350,25 @@ class VideoStreamEncoderTest : public ::testing::Test {
     return frame;
   }
 
+  // A frame whose pixels are set, for code that reads them.
+  VideoFrame CreateBlackFrame(int64_t ntp_time_ms) const {
+    rtc::scoped_refptr<I420Buffer> buffer =
+        I420Buffer::Create(codec_width_, codec_height_);
+    I420Buffer::SetBlack(buffer);
+    VideoFrame frame(buffer, 99, 99, kVideoRotation_0);
+    frame.set_ntp_time_ms(ntp_time_ms);
+    return frame;
+  }
+
+  VideoFrame CreateFrameWithUpdateRect(
+      int64_t ntp_time_ms,
+      const VideoFrame::UpdateRect& update_rect) const {
+    VideoFrame frame = CreateFrame(ntp_time_ms, nullptr);
+    frame.set_update_rects(rtc::Optional<std::vector<VideoFrame::UpdateRect>>(
+        std::vector<VideoFrame::UpdateRect>{update_rect}));
+    return frame;
+  }
+
   VideoFrame CreateFrame(int64_t ntp_time_ms, int width, int height) const {
     VideoFrame frame(
         new rtc::RefCountedObject<TestBuffer>(nullptr, width, height), 99, 99,
@@ -503,6 +523,17 @@ class VideoStreamEncoderTest : public ::testing::Test {
       force_init_encode_failed_ = force_failure;
     }
 
+    rtc::scoped_refptr<VideoFrameBuffer> last_input_buffer() const {
+      rtc::CritScope lock(&local_crit_sect_);
+      return last_input_buffer_;
+    }
+
+    rtc::Optional<std::vector<VideoFrame::UpdateRect>> last_update_rects()
+        const {
+      rtc::CritScope lock(&local_crit_sect_);
+      return last_update_rects_;
+    }
+
    private:
     int32_t Encode(const VideoFrame& input_image,
                    const CodecSpecificInfo* codec_specific_info,
@@ -518,6 +549,8 @@ class VideoStreamEncoderTest : public ::testing::Test {
         ntp_time_ms_ = input_image.ntp_time_ms();
         last_input_width_ = input_image.width();
         last_input_height_ = input_image.height();
+        last_input_buffer_ = input_image.video_frame_buffer();
+        last_update_rects_ = input_image.update_rects();
         block_encode = block_next_encode_;
         block_next_encode_ = false;
       }
@@ -557,6 +590,10 @@ class VideoStreamEncoderTest : public ::testing::Test {
     int64_t ntp_time_ms_ RTC_GUARDED_BY(local_crit_sect_) = 0;
     int last_input_width_ RTC_GUARDED_BY(local_crit_sect_) = 0;
     int last_input_height_ RTC_GUARDED_BY(local_crit_sect_) = 0;
+    rtc::scoped_refptr<VideoFrameBuffer> last_input_buffer_
+        RTC_GUARDED_BY(local_crit_sect_);
+    rtc::Optional<std::vector<VideoFrame::UpdateRect>> last_update_rects_
+        RTC_GUARDED_BY(local_crit_sect_);
     bool quality_scaling_ RTC_GUARDED_BY(local_crit_sect_) = true;
     std::vector<std::unique_ptr<TemporalLayers>> allocated_temporal_layers_
         RTC_GUARDED_BY(local_crit_sect_);
@@ -3277,4 +3314,92 @@ TEST_F(VideoStreamEncoderTest, DoesNotUpdateBitrateAllocationWhenSuspended) {
   video_stream_encoder_->Stop();
 }
 
+TEST_F(VideoStreamEncoderTest, DenoisesFramesWithFieldTrial) {
+  // The denoiser is created with the encoder, so recreate it with the field
+  // trial set.
+  test::ScopedFieldTrials field_trials("WebRTC-VideoDenoiser/Enabled/");
+  ConfigureEncoder(video_encoder_config_.Copy(), true /* nack_enabled */);
+  video_stream_encoder_->OnBitrateUpdated(kTargetBitrateBps, 0, 0);
+
+  VideoFrame frame = CreateBlackFrame(1);
+  rtc::scoped_refptr<I420BufferInterface> input =
+      frame.video_frame_buffer()->ToI420();
+  video_source_.IncomingCapturedFrame(frame);
+  WaitForEncodedFrame(1);
+
+  // The luma plane is denoised into a new buffer, the chroma planes are those
+  // of the input frame.
+  rtc::scoped_refptr<I420BufferInterface> encoded =
+      fake_encoder_.last_input_buffer()->ToI420();
+  EXPECT_NE(input->DataY(), encoded->DataY());
+  EXPECT_EQ(input->DataU(), encoded->DataU());
+  EXPECT_EQ(input->DataV(), encoded->DataV());
+  video_stream_encoder_->Stop();
+}
+
+TEST_F(VideoStreamEncoderTest, DoesNotDenoiseScreenContent) {
+  test::ScopedFieldTrials field_trials("WebRTC-VideoDenoiser/Enabled/");
+  ResetEncoder("FAKE", 1, 1, 1, false /* nack_enabled */,
+               true /* screenshare */);
+  video_stream_encoder_->OnBitrateUpdated(kTargetBitrateBps, 0, 0);
+
+  VideoFrame frame = CreateBlackFrame(1);
+  video_source_.IncomingCapturedFrame(frame);
+  WaitForEncodedFrame(1);
+
+  EXPECT_EQ(frame.video_frame_buffer(), fake_encoder_.last_input_buffer());
+  video_stream_encoder_->Stop();
+}
+
+TEST_F(VideoStreamEncoderTest, AddsUpdateRectsOfDroppedFramesToNextFrame) {
+  video_stream_encoder_->OnBitrateUpdated(kTargetBitrateBps, 0, 0);
+  video_source_.IncomingCapturedFrame(
+      CreateFrameWithUpdateRect(1, {0, 0, 16, 16}));
+  WaitForEncodedFrame(1);
+  rtc::Optional<std::vector<VideoFrame::UpdateRect>> update_rects =
+      fake_encoder_.last_update_rects();
+  ASSERT_TRUE(update_rects);
+  EXPECT_EQ(1u, update_rects->size());
+
+  // Dropped since bitrate is zero.
+  video_stream_encoder_->OnBitrateUpdated(0, 0, 0);
+  video_source_.IncomingCapturedFrame(
+      CreateFrameWithUpdateRect(2, {16, 16, 16, 16}));
+  ExpectDroppedFrame();
+  // Dropped since it has the same ntp timestamp.
+  video_stream_encoder_->OnBitrateUpdated(kTargetBitrateBps, 0, 0);
+  video_source_.IncomingCapturedFrame(
+      CreateFrameWithUpdateRect(1, {32, 32, 16, 16}));
+
+  video_source_.IncomingCapturedFrame(
+      CreateFrameWithUpdateRect(3, {48, 48, 16, 16}));
+  WaitForEncodedFrame(3);
+  update_rects = fake_encoder_.last_update_rects();
+  ASSERT_TRUE(update_rects);
+  ASSERT_EQ(3u, update_rects->size());
+  EXPECT_EQ(16, (*update_rects)[0].offset_x);
+  EXPECT_EQ(32, (*update_rects)[1].offset_x);
+  EXPECT_EQ(48, (*update_rects)[2].offset_x);
+  video_stream_encoder_->Stop();
+}
+
+TEST_F(VideoStreamEncoderTest, UnknownUpdateRectsOfDroppedFrameAreUnknown) {
+  video_stream_encoder_->OnBitrateUpdated(kTargetBitrateBps, 0, 0);
+  video_source_.IncomingCapturedFrame(
+      CreateFrameWithUpdateRect(1, {0, 0, 16, 16}));
+  WaitForEncodedFrame(1);
+
+  // Dropped since bitrate is zero.
+  video_stream_encoder_->OnBitrateUpdated(0, 0, 0);
+  video_source_.IncomingCapturedFrame(CreateFrame(2, nullptr));
+  ExpectDroppedFrame();
+
+  video_stream_encoder_->OnBitrateUpdated(kTargetBitrateBps, 0, 0);
+  video_source_.IncomingCapturedFrame(
+      CreateFrameWithUpdateRect(3, {16, 16, 16, 16}));
+  WaitForEncodedFrame(3);
+  EXPECT_FALSE(fake_encoder_.last_update_rects());
+  video_stream_encoder_->Stop();
+}
+
 }  // namespace webrtc